@@ -39,6 +39,15 @@
  * one must hold the lock shared.  To read or update the counters within
  * an entry, one must hold the lock shared or exclusive (so the entry doesn't
  * disappear!) and also take the entry's mutex spinlock.
+ *
+ * To keep that locking off the hot path, each backend accumulates the
+ * counters of statements whose entry it has already seen in a local hash
+ * table, and adds them to the shared entries in one batch at most every
+ * pg_stat_statements.flush_interval milliseconds, and at backend exit.
+ * Executing a statement whose entry is known thus needs neither the lock
+ * nor the query text.  The flush happens only when the backend records its
+ * next statement, though, so the counters of an idle backend's last
+ * statements stay local until it does something again.
  * The shared state variable pgss->extent (the next free spot in the external
  * query-text file) should be accessed only while holding either the
  * pgss->mutex spinlock, or exclusive lock on pgss->lock.  We use the mutex to
@@ -57,10 +66,12 @@
  */
 #include "postgres.h"
 
+#include <math.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
 #include "access/hash.h"
+#include "access/xact.h"
 #include "executor/instrument.h"
 #include "funcapi.h"
 #include "mb/pg_wchar.h"
@@ -75,6 +86,7 @@
 #include "tcop/utility.h"
 #include "utils/builtins.h"
 #include "utils/memutils.h"
+#include "utils/timestamp.h"
 
 
 PG_MODULE_MAGIC;
@@ -93,7 +105,7 @@ PG_MODULE_MAGIC;
 #define PGSS_TEXT_FILE	PG_STAT_TMP_DIR "/pgss_query_texts.stat"
 
 /* Magic number identifying the stats file format */
-static const uint32 PGSS_FILE_HEADER = 0x20140125;
+static const uint32 PGSS_FILE_HEADER = 0x20140412;
 
 /* PostgreSQL major version number, changes in which invalidate all entries */
 static const uint32 PGSS_PG_MAJOR_VERSION = PG_VERSION_NUM / 100;
@@ -109,6 +121,14 @@ static const uint32 PGSS_PG_MAJOR_VERSION = PG_VERSION_NUM / 100;
 
 #define JUMBLE_SIZE				1024	/* query serialization buffer size */
 
+/*
+ * Execution times are also counted in a histogram with logarithmic buckets:
+ * bucket 0 counts executions shorter than 1 microsecond, and bucket i > 0
+ * those between 2^(i-1) and 2^i microseconds.  The last bucket also counts
+ * anything longer.
+ */
+#define PGSS_HIST_BUCKETS		32
+
 /*
  * Extension version number, for supporting older extension versions' objects
  */
@@ -116,7 +136,8 @@ typedef enum pgssVersion
 {
 	PGSS_V1_0 = 0,
 	PGSS_V1_1,
-	PGSS_V1_2
+	PGSS_V1_2,
+	PGSS_V1_3
 } pgssVersion;
 
 /*
@@ -150,6 +171,9 @@ typedef struct Counters
 	int64		temp_blks_written;		/* # of temp blocks written */
 	double		blk_read_time;	/* time spent reading, in msec */
 	double		blk_write_time; /* time spent writing, in msec */
+	double		min_time;		/* minimum execution time, in msec */
+	double		max_time;		/* maximum execution time, in msec */
+	int64		time_hist[PGSS_HIST_BUCKETS];	/* execution time histogram */
 	double		usage;			/* usage factor */
 } Counters;
 
@@ -170,6 +194,16 @@ typedef struct pgssEntry
 	slock_t		mutex;			/* protects the counters only */
 } pgssEntry;
 
+/*
+ * Counters accumulated by this backend for an existing shared entry, and not
+ * yet added to it
+ */
+typedef struct pgssLocalEntry
+{
+	pgssHashKey key;			/* hash key of entry - MUST BE FIRST */
+	Counters	counters;		/* pending increments */
+} pgssLocalEntry;
+
 /*
  * Global shared state
  */
@@ -233,6 +267,10 @@ static ProcessUtility_hook_type prev_ProcessUtility = NULL;
 static pgssSharedState *pgss = NULL;
 static HTAB *pgss_hash = NULL;
 
+/* Backend-local counters not yet flushed to shared memory */
+static HTAB *pgss_local_hash = NULL;
+static TimestampTz pgss_last_flush = 0;
+
 /*---- GUC variables ----*/
 
 typedef enum
@@ -254,6 +292,7 @@ static int	pgss_max;			/* max # statements to track */
 static int	pgss_track;			/* tracking level */
 static bool pgss_track_utility; /* whether to track utility commands */
 static bool pgss_save;			/* whether to save stats across shutdown */
+static int	pgss_flush_interval;	/* max delay before flushing local stats */
 
 
 #define pgss_enabled() \
@@ -274,10 +313,12 @@ void		_PG_init(void);
 void		_PG_fini(void);
 
 Datum		pg_stat_statements_reset(PG_FUNCTION_ARGS);
+Datum		pg_stat_statements_1_3(PG_FUNCTION_ARGS);
 Datum		pg_stat_statements_1_2(PG_FUNCTION_ARGS);
 Datum		pg_stat_statements(PG_FUNCTION_ARGS);
 
 PG_FUNCTION_INFO_V1(pg_stat_statements_reset);
+PG_FUNCTION_INFO_V1(pg_stat_statements_1_3);
 PG_FUNCTION_INFO_V1(pg_stat_statements_1_2);
 PG_FUNCTION_INFO_V1(pg_stat_statements);
 
@@ -300,12 +341,17 @@ static void pgss_store(const char *query, uint32 queryId,
 		   double total_time, uint64 rows,
 		   const BufferUsage *bufusage,
 		   pgssJumbleState *jstate);
+static void pgss_flush_local(void);
+static void pgss_backend_exit(int code, Datum arg);
+static void counters_add(volatile Counters *dst, const Counters *src);
+static double counters_percentile(const Counters *c, double fraction);
 static void pg_stat_statements_internal(FunctionCallInfo fcinfo,
 							pgssVersion api_version,
 							bool showtext);
 static Size pgss_memsize(void);
 static pgssEntry *entry_alloc(pgssHashKey *key, Size query_offset, int query_len,
 			int encoding, bool sticky);
+static double select_usage(double *usages, int n, int k);
 static void entry_dealloc(void);
 static bool qtext_store(const char *query, int query_len,
 			Size *query_offset, int *gc_count);
@@ -394,6 +440,20 @@ _PG_init(void)
 							 NULL,
 							 NULL);
 
+	DefineCustomIntVariable("pg_stat_statements.flush_interval",
+							"Sets the minimum delay between additions of a backend's statistics to the shared ones.",
+							"A backend adds its statistics when it executes a statement or exits, so those of an idle backend wait until then. "
+							"Zero updates the shared statistics after every statement.",
+							&pgss_flush_interval,
+							500,
+							0,
+							INT_MAX / 1000,
+							PGC_SUSET,
+							GUC_UNIT_MS,
+							NULL,
+							NULL,
+							NULL);
+
 	EmitWarningsOnPlaceholders("pg_stat_statements");
 
 	/*
@@ -1104,6 +1164,7 @@ pgss_store(const char *query, uint32 queryId,
 {
 	pgssHashKey key;
 	pgssEntry  *entry;
+	Counters	inc;
 	char	   *norm_query = NULL;
 	int			encoding = GetDatabaseEncoding();
 	int			query_len;
@@ -1114,13 +1175,71 @@ pgss_store(const char *query, uint32 queryId,
 	if (!pgss || !pgss_hash)
 		return;
 
-	query_len = strlen(query);
-
 	/* Set up key for hashtable search */
 	key.userid = GetUserId();
 	key.dbid = MyDatabaseId;
 	key.queryid = queryId;
 
+	/* Collect the counters of this execution, except when jstate is set */
+	if (!jstate)
+	{
+		int			bucket;
+
+		memset(&inc, 0, sizeof(Counters));
+		inc.calls = 1;
+		inc.total_time = total_time;
+		inc.rows = rows;
+		inc.shared_blks_hit = bufusage->shared_blks_hit;
+		inc.shared_blks_read = bufusage->shared_blks_read;
+		inc.shared_blks_dirtied = bufusage->shared_blks_dirtied;
+		inc.shared_blks_written = bufusage->shared_blks_written;
+		inc.local_blks_hit = bufusage->local_blks_hit;
+		inc.local_blks_read = bufusage->local_blks_read;
+		inc.local_blks_dirtied = bufusage->local_blks_dirtied;
+		inc.local_blks_written = bufusage->local_blks_written;
+		inc.temp_blks_read = bufusage->temp_blks_read;
+		inc.temp_blks_written = bufusage->temp_blks_written;
+		inc.blk_read_time = INSTR_TIME_GET_MILLISEC(bufusage->blk_read_time);
+		inc.blk_write_time = INSTR_TIME_GET_MILLISEC(bufusage->blk_write_time);
+		inc.min_time = total_time;
+		inc.max_time = total_time;
+		inc.usage = USAGE_EXEC(total_time);
+
+		/* frexp() returns the exponent e such that 2^(e-1) <= x < 2^e */
+		(void) frexp(total_time * 1000.0, &bucket);
+		bucket = Max(bucket, 0);
+		bucket = Min(bucket, PGSS_HIST_BUCKETS - 1);
+		inc.time_hist[bucket] = 1;
+
+		/*
+		 * If we've already seen the entry, just accumulate the counters
+		 * locally; they'll be added to the shared entry by the next flush.
+		 */
+		if (pgss_local_hash)
+		{
+			pgssLocalEntry *local;
+
+			local = (pgssLocalEntry *) hash_search(pgss_local_hash, &key,
+												   HASH_FIND, NULL);
+			if (local)
+			{
+				counters_add(&local->counters, &inc);
+
+				/*
+				 * The statement start time is good enough to decide when to
+				 * flush, and saves a kernel call.
+				 */
+				if (TimestampDifferenceExceeds(pgss_last_flush,
+											   GetCurrentStatementStartTimestamp(),
+											   pgss_flush_interval))
+					pgss_flush_local();
+				return;
+			}
+		}
+	}
+
+	query_len = strlen(query);
+
 	/* Lookup the hash table entry with shared lock. */
 	LWLockAcquire(pgss->lock, LW_SHARED);
 
@@ -1204,22 +1323,7 @@ pgss_store(const char *query, uint32 queryId,
 		if (e->counters.calls == 0)
 			e->counters.usage = USAGE_INIT;
 
-		e->counters.calls += 1;
-		e->counters.total_time += total_time;
-		e->counters.rows += rows;
-		e->counters.shared_blks_hit += bufusage->shared_blks_hit;
-		e->counters.shared_blks_read += bufusage->shared_blks_read;
-		e->counters.shared_blks_dirtied += bufusage->shared_blks_dirtied;
-		e->counters.shared_blks_written += bufusage->shared_blks_written;
-		e->counters.local_blks_hit += bufusage->local_blks_hit;
-		e->counters.local_blks_read += bufusage->local_blks_read;
-		e->counters.local_blks_dirtied += bufusage->local_blks_dirtied;
-		e->counters.local_blks_written += bufusage->local_blks_written;
-		e->counters.temp_blks_read += bufusage->temp_blks_read;
-		e->counters.temp_blks_written += bufusage->temp_blks_written;
-		e->counters.blk_read_time += INSTR_TIME_GET_MILLISEC(bufusage->blk_read_time);
-		e->counters.blk_write_time += INSTR_TIME_GET_MILLISEC(bufusage->blk_write_time);
-		e->counters.usage += USAGE_EXEC(total_time);
+		counters_add(&e->counters, &inc);
 
 		SpinLockRelease(&e->mutex);
 	}
@@ -1230,6 +1334,180 @@ done:
 	/* We postpone this clean-up until we're out of the lock */
 	if (norm_query)
 		pfree(norm_query);
+
+	/*
+	 * Remember that the entry exists, so that the next executions of the
+	 * statement can be counted locally.
+	 */
+	if (!jstate && entry && pgss_flush_interval > 0)
+	{
+		pgssLocalEntry *local;
+		bool		found;
+
+		if (!pgss_local_hash)
+		{
+			HASHCTL		info;
+
+			memset(&info, 0, sizeof(info));
+			info.keysize = sizeof(pgssHashKey);
+			info.entrysize = sizeof(pgssLocalEntry);
+			info.hash = pgss_hash_fn;
+			info.match = pgss_match_fn;
+			pgss_local_hash = hash_create("pg_stat_statements local hash",
+										  64, &info,
+										  HASH_ELEM | HASH_FUNCTION | HASH_COMPARE);
+			pgss_last_flush = GetCurrentStatementStartTimestamp();
+			before_shmem_exit(pgss_backend_exit, (Datum) 0);
+		}
+		else if (hash_get_num_entries(pgss_local_hash) >= pgss_max)
+		{
+			/* Don't remember more entries than the shared table can hold */
+			pgss_flush_local();
+			return;
+		}
+
+		local = (pgssLocalEntry *) hash_search(pgss_local_hash, &key,
+											   HASH_ENTER, &found);
+		if (!found)
+			memset(&local->counters, 0, sizeof(Counters));
+	}
+}
+
+/*
+ * Add the counters accumulated by this backend to the shared entries.
+ *
+ * Local entries whose shared entry has been evicted in the meantime are
+ * forgotten, together with their counters; a later execution of the
+ * statement will create the entry again.
+ */
+static void
+pgss_flush_local(void)
+{
+	HASH_SEQ_STATUS hash_seq;
+	pgssLocalEntry *local;
+	bool		forget_all;
+
+	if (!pgss_local_hash)
+		return;
+
+	/* Also forget everything if the table of entries to remember is full */
+	forget_all = (hash_get_num_entries(pgss_local_hash) >= pgss_max);
+
+	LWLockAcquire(pgss->lock, LW_SHARED);
+
+	hash_seq_init(&hash_seq, pgss_local_hash);
+	while ((local = hash_seq_search(&hash_seq)) != NULL)
+	{
+		pgssEntry  *entry;
+
+		entry = (pgssEntry *) hash_search(pgss_hash, &local->key,
+										  HASH_FIND, NULL);
+
+		if (entry && local->counters.calls > 0)
+		{
+			volatile pgssEntry *e = (volatile pgssEntry *) entry;
+
+			SpinLockAcquire(&e->mutex);
+
+			/* "Unstick" entry if it was previously sticky */
+			if (e->counters.calls == 0)
+				e->counters.usage = USAGE_INIT;
+
+			counters_add(&e->counters, &local->counters);
+
+			SpinLockRelease(&e->mutex);
+		}
+
+		if (!entry || forget_all)
+			hash_search(pgss_local_hash, &local->key, HASH_REMOVE, NULL);
+		else
+			memset(&local->counters, 0, sizeof(Counters));
+	}
+
+	LWLockRelease(pgss->lock);
+
+	pgss_last_flush = GetCurrentStatementStartTimestamp();
+}
+
+/*
+ * before_shmem_exit hook: flush this backend's counters at exit.
+ */
+static void
+pgss_backend_exit(int code, Datum arg)
+{
+	if (pgss && pgss_hash)
+		pgss_flush_local();
+}
+
+/*
+ * Add the counters in src to those in dst.
+ *
+ * dst is volatile so that this can be used on shared entries while holding
+ * their spinlock.
+ */
+static void
+counters_add(volatile Counters *dst, const Counters *src)
+{
+	int			i;
+
+	if (src->calls == 0)
+		return;
+
+	if (dst->calls == 0 || src->min_time < dst->min_time)
+		dst->min_time = src->min_time;
+	if (dst->calls == 0 || src->max_time > dst->max_time)
+		dst->max_time = src->max_time;
+
+	dst->calls += src->calls;
+	dst->total_time += src->total_time;
+	dst->rows += src->rows;
+	dst->shared_blks_hit += src->shared_blks_hit;
+	dst->shared_blks_read += src->shared_blks_read;
+	dst->shared_blks_dirtied += src->shared_blks_dirtied;
+	dst->shared_blks_written += src->shared_blks_written;
+	dst->local_blks_hit += src->local_blks_hit;
+	dst->local_blks_read += src->local_blks_read;
+	dst->local_blks_dirtied += src->local_blks_dirtied;
+	dst->local_blks_written += src->local_blks_written;
+	dst->temp_blks_read += src->temp_blks_read;
+	dst->temp_blks_written += src->temp_blks_written;
+	dst->blk_read_time += src->blk_read_time;
+	dst->blk_write_time += src->blk_write_time;
+	for (i = 0; i < PGSS_HIST_BUCKETS; i++)
+		dst->time_hist[i] += src->time_hist[i];
+	dst->usage += src->usage;
+}
+
+/*
+ * Estimate the given percentile (as a fraction between 0 and 1) of the
+ * execution times, in msec, from the histogram.  We interpolate linearly
+ * within the bucket holding the percentile, and clamp the result to the
+ * observed minimum and maximum.
+ */
+static double
+counters_percentile(const Counters *c, double fraction)
+{
+	double		target = fraction * c->calls;
+	double		cum = 0;
+	int			i;
+
+	for (i = 0; i < PGSS_HIST_BUCKETS; i++)
+	{
+		if (c->time_hist[i] > 0 && cum + c->time_hist[i] >= target)
+		{
+			double		lo = (i == 0) ? 0.0 : ldexp(1.0, i - 1) / 1000.0;
+			double		hi = ldexp(1.0, i) / 1000.0;
+			double		result;
+
+			result = lo + (hi - lo) * (target - cum) / c->time_hist[i];
+			result = Max(result, c->min_time);
+			result = Min(result, c->max_time);
+			return result;
+		}
+		cum += c->time_hist[i];
+	}
+
+	return c->max_time;
 }
 
 /*
@@ -1242,6 +1520,21 @@ pg_stat_statements_reset(PG_FUNCTION_ARGS)
 		ereport(ERROR,
 				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
 				 errmsg("pg_stat_statements must be loaded via shared_preload_libraries")));
+
+	/*
+	 * Forget our own pending counters, too.  Keep the hash table itself, as
+	 * the exit callback that flushes it is registered only when it's made.
+	 */
+	if (pgss_local_hash)
+	{
+		HASH_SEQ_STATUS hash_seq;
+		pgssLocalEntry *local;
+
+		hash_seq_init(&hash_seq, pgss_local_hash);
+		while ((local = hash_seq_search(&hash_seq)) != NULL)
+			hash_search(pgss_local_hash, &local->key, HASH_REMOVE, NULL);
+	}
+
 	entry_reset();
 	PG_RETURN_VOID();
 }
@@ -1250,7 +1543,8 @@ pg_stat_statements_reset(PG_FUNCTION_ARGS)
 #define PG_STAT_STATEMENTS_COLS_V1_0	14
 #define PG_STAT_STATEMENTS_COLS_V1_1	18
 #define PG_STAT_STATEMENTS_COLS_V1_2	19
-#define PG_STAT_STATEMENTS_COLS			19		/* maximum of above */
+#define PG_STAT_STATEMENTS_COLS_V1_3	24
+#define PG_STAT_STATEMENTS_COLS			24		/* maximum of above */
 
 /*
  * Retrieve statement statistics.
@@ -1262,6 +1556,16 @@ pg_stat_statements_reset(PG_FUNCTION_ARGS)
  * expected API version is identified by embedding it in the C name of the
  * function.  Unfortunately we weren't bright enough to do that for 1.1.
  */
+Datum
+pg_stat_statements_1_3(PG_FUNCTION_ARGS)
+{
+	bool		showtext = PG_GETARG_BOOL(0);
+
+	pg_stat_statements_internal(fcinfo, PGSS_V1_3, showtext);
+
+	return (Datum) 0;
+}
+
 Datum
 pg_stat_statements_1_2(PG_FUNCTION_ARGS)
 {
@@ -1351,6 +1655,10 @@ pg_stat_statements_internal(FunctionCallInfo fcinfo,
 			if (api_version != PGSS_V1_2)
 				elog(ERROR, "incorrect number of output arguments");
 			break;
+		case PG_STAT_STATEMENTS_COLS_V1_3:
+			if (api_version != PGSS_V1_3)
+				elog(ERROR, "incorrect number of output arguments");
+			break;
 		default:
 			elog(ERROR, "incorrect number of output arguments");
 	}
@@ -1362,6 +1670,9 @@ pg_stat_statements_internal(FunctionCallInfo fcinfo,
 
 	MemoryContextSwitchTo(oldcontext);
 
+	/* Make sure our own statistics are up to date */
+	pgss_flush_local();
+
 	/*
 	 * We'd like to load the query text file (if needed) while not holding any
 	 * lock on pgss->lock.	In the worst case we'll have to do this again
@@ -1528,10 +1839,19 @@ pg_stat_statements_internal(FunctionCallInfo fcinfo,
 			values[i++] = Float8GetDatumFast(tmp.blk_read_time);
 			values[i++] = Float8GetDatumFast(tmp.blk_write_time);
 		}
+		if (api_version >= PGSS_V1_3)
+		{
+			values[i++] = Float8GetDatumFast(tmp.min_time);
+			values[i++] = Float8GetDatumFast(tmp.max_time);
+			values[i++] = Float8GetDatumFast(counters_percentile(&tmp, 0.50));
+			values[i++] = Float8GetDatumFast(counters_percentile(&tmp, 0.95));
+			values[i++] = Float8GetDatumFast(counters_percentile(&tmp, 0.99));
+		}
 
 		Assert(i == (api_version == PGSS_V1_0 ? PG_STAT_STATEMENTS_COLS_V1_0 :
 					 api_version == PGSS_V1_1 ? PG_STAT_STATEMENTS_COLS_V1_1 :
 					 api_version == PGSS_V1_2 ? PG_STAT_STATEMENTS_COLS_V1_2 :
+					 api_version == PGSS_V1_3 ? PG_STAT_STATEMENTS_COLS_V1_3 :
 					 -1 /* fail if you forget to update this assert */ ));
 
 		tuplestore_putvalues(tupstore, tupdesc, values, nulls);
@@ -1612,20 +1932,51 @@ entry_alloc(pgssHashKey *key, Size query_offset, int query_len, int encoding,
 }
 
 /*
- * qsort comparator for sorting into increasing usage order
+ * Return the k'th smallest (counting from 0) of the n usage values in the
+ * array, which is reordered in the process.  This is Hoare's selection
+ * algorithm, which takes linear time on average, rather than the n log n
+ * of sorting the whole array.
  */
-static int
-entry_cmp(const void *lhs, const void *rhs)
+static double
+select_usage(double *usages, int n, int k)
 {
-	double		l_usage = (*(pgssEntry *const *) lhs)->counters.usage;
-	double		r_usage = (*(pgssEntry *const *) rhs)->counters.usage;
+	int			lo = 0;
+	int			hi = n - 1;
 
-	if (l_usage < r_usage)
-		return -1;
-	else if (l_usage > r_usage)
-		return +1;
-	else
-		return 0;
+	Assert(k >= 0 && k < n);
+
+	while (lo < hi)
+	{
+		double		pivot = usages[lo + (hi - lo) / 2];
+		int			i = lo;
+		int			j = hi;
+
+		while (i <= j)
+		{
+			while (usages[i] < pivot)
+				i++;
+			while (usages[j] > pivot)
+				j--;
+			if (i <= j)
+			{
+				double		tmp = usages[i];
+
+				usages[i] = usages[j];
+				usages[j] = tmp;
+				i++;
+				j--;
+			}
+		}
+
+		if (k <= j)
+			hi = j;
+		else if (k >= i)
+			lo = i;
+		else
+			break;				/* usages[k] is equal to the pivot */
+	}
+
+	return usages[k];
 }
 
 /*
@@ -1636,53 +1987,76 @@ static void
 entry_dealloc(void)
 {
 	HASH_SEQ_STATUS hash_seq;
-	pgssEntry **entries;
+	double	   *usages;
 	pgssEntry  *entry;
+	double		threshold;
+	int			nentries;
 	int			nvictims;
+	int			nbelow;
 	int			i;
 	Size		totlen = 0;
 
 	/*
-	 * Sort entries by usage and deallocate USAGE_DEALLOC_PERCENT of them.
-	 * While we're scanning the table, apply the decay factor to the usage
-	 * values.
+	 * Deallocate USAGE_DEALLOC_PERCENT of the entries, those with the lowest
+	 * usage.  Rather than sorting all the entries, collect their usage values
+	 * in a first pass (applying the decay factor as we go), find the usage
+	 * of the last victim by selection, and remove the entries below that
+	 * threshold in a second pass.
 	 */
 
-	entries = palloc(hash_get_num_entries(pgss_hash) * sizeof(pgssEntry *));
+	nentries = hash_get_num_entries(pgss_hash);
+	usages = palloc(Max(nentries, 1) * sizeof(double));
 
 	i = 0;
 	hash_seq_init(&hash_seq, pgss_hash);
 	while ((entry = hash_seq_search(&hash_seq)) != NULL)
 	{
-		entries[i++] = entry;
 		/* "Sticky" entries get a different usage decay rate. */
 		if (entry->counters.calls == 0)
 			entry->counters.usage *= STICKY_DECREASE_FACTOR;
 		else
 			entry->counters.usage *= USAGE_DECREASE_FACTOR;
+		usages[i++] = entry->counters.usage;
 		/* Accumulate total size, too. */
 		totlen += entry->query_len + 1;
 	}
+	nentries = i;
 
-	qsort(entries, i, sizeof(pgssEntry *), entry_cmp);
-
-	if (i > 0)
+	if (nentries == 0)
 	{
-		/* Record the (approximate) median usage */
-		pgss->cur_median_usage = entries[i / 2]->counters.usage;
-		/* Record the mean query length */
-		pgss->mean_query_len = totlen / i;
+		pfree(usages);
+		return;
 	}
 
-	nvictims = Max(10, i * USAGE_DEALLOC_PERCENT / 100);
-	nvictims = Min(nvictims, i);
+	/* Record the (approximate) median usage */
+	pgss->cur_median_usage = select_usage(usages, nentries, nentries / 2);
+	/* Record the mean query length */
+	pgss->mean_query_len = totlen / nentries;
+
+	nvictims = Max(10, nentries * USAGE_DEALLOC_PERCENT / 100);
+	nvictims = Min(nvictims, nentries);
 
-	for (i = 0; i < nvictims; i++)
+	/*
+	 * Every entry with a usage below the threshold is a victim; so are as
+	 * many of those equal to it as it takes to make up nvictims.
+	 */
+	threshold = select_usage(usages, nentries, nvictims - 1);
+	nbelow = 0;
+	for (i = 0; i < nentries; i++)
+	{
+		if (usages[i] < threshold)
+			nbelow++;
+	}
+
+	hash_seq_init(&hash_seq, pgss_hash);
+	while ((entry = hash_seq_search(&hash_seq)) != NULL)
 	{
-		hash_search(pgss_hash, &entries[i]->key, HASH_REMOVE, NULL);
+		if (entry->counters.usage < threshold ||
+			(entry->counters.usage == threshold && nbelow++ < nvictims))
+			hash_search(pgss_hash, &entry->key, HASH_REMOVE, NULL);
 	}
 
-	pfree(entries);
+	pfree(usages);
 }
 
 /*
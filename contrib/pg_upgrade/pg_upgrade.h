@@ -115,6 +115,13 @@ extern char *output_files[];
  */
 #define MULTIXACT_FORMATCHANGE_CAT_VER 201301231
 
+/*
+ * The visibility map gained an all-frozen bit per heap page, making each
+ * page's entry two bits wide; pick this catalog version.  Older maps have to
+ * be rewritten rather than copied or linked.
+ */
+#define VISIBILITY_MAP_FROZEN_BIT_CAT_VER 201404052
+
 /*
  * Each relation is represented by a relinfo structure.
  */
@@ -386,6 +393,7 @@ const char *copyAndUpdateFile(pageCnvCtx *pageConverter, const char *src,
 				  const char *dst, bool force);
 const char *linkAndUpdateFile(pageCnvCtx *pageConverter, const char *src,
 				  const char *dst);
+const char *rewriteVisibilityMap(const char *fromfile, const char *tofile);
 
 void		check_hard_link(void);
 FILE	   *fopen_priv(const char *path, const char *mode);
@@ -187,6 +187,28 @@ typedef struct
 #define MAX_FILES		128		/* max number of SQL script files allowed */
 #define SHELL_COMMAND_SIZE	256 /* maximum size allowed for shell command */
 
+/*
+ * Histogram of transaction latencies, in microseconds.  Latencies below
+ * HIST_EXACT are counted exactly; above that, each power of two is split into
+ * HIST_SUB_BUCKETS equal buckets, in the style of HdrHistogram, so that
+ * percentiles are accurate to about 1.5% whatever the latency.  Latencies of
+ * 2^HIST_MAX_BITS microseconds (about 12 days) or more go in the last bucket.
+ */
+#define HIST_SUB_BITS		5
+#define HIST_SUB_BUCKETS	(1 << HIST_SUB_BITS)
+#define HIST_EXACT			(2 * HIST_SUB_BUCKETS)
+#define HIST_MAX_BITS		40
+#define HIST_SIZE \
+	(HIST_EXACT + (HIST_MAX_BITS - HIST_SUB_BITS - 1) * HIST_SUB_BUCKETS)
+
+typedef struct
+{
+	int64		count;			/* number of latencies recorded */
+	int64		sum;			/* their sum */
+	int64		max;			/* the largest one */
+	int64		buckets[HIST_SIZE];
+} Histogram;
+
 /*
  * structures used in custom query mode
  */
@@ -206,12 +228,15 @@ typedef struct
 	Variable   *variables;		/* array of variable definitions */
 	int			nvariables;
 	instr_time	txn_begin;		/* used for measuring transaction latencies */
+	int64		txn_scheduled;	/* scheduled start time of transaction (usec),
+								 * under throttling */
 	instr_time	stmt_begin;		/* used for measuring statement latencies */
 	int64		txn_latencies;	/* cumulated latencies */
 	int64		txn_sqlats;		/* cumulated square latencies */
 	bool		is_throttled;	/* whether transaction throttling is done */
 	int			use_file;		/* index in sql_files for this client */
 	bool		prepared[MAX_FILES];
+	bool		in_pipeline;	/* between \startpipeline and \endpipeline */
 } CState;
 
 /*
@@ -230,6 +255,7 @@ typedef struct
 	int64       throttle_trigger; 	/* previous/next throttling (us) */
 	int64       throttle_lag; 		/* total transaction lag behind throttling */
 	int64       throttle_lag_max; 	/* max transaction lag */
+	Histogram  *script_hist;	/* latency histogram of each script file */
 } TState;
 
 #define INVALID_THREAD		((pthread_t) 0)
@@ -242,6 +268,7 @@ typedef struct
 	int64		sqlats;
 	int64       throttle_lag;
 	int64       throttle_lag_max;
+	Histogram  *script_hist;	/* num_files latency histograms */
 } TResult;
 
 /*
@@ -285,7 +312,10 @@ typedef struct
 } AggVals;
 
 static Command **sql_files[MAX_FILES];	/* SQL script files */
+static char *sql_file_names[MAX_FILES];	/* their names, for reports */
+static int	sql_file_weights[MAX_FILES];	/* their relative weights */
 static int	num_files;			/* number of script files */
+static int	total_weight = 0;	/* sum of sql_file_weights[] */
 static int	num_commands = 0;	/* total number of Command structs */
 static int	debug = 0;			/* debug flag */
 
@@ -356,7 +386,8 @@ usage(void)
 		   "  -C, --connect            establish new connection for each transaction\n"
 		   "  -D, --define=VARNAME=VALUE\n"
 		   "                           define variable for use by custom script\n"
-		   "  -f, --file=FILENAME      read transaction script from FILENAME\n"
+		   "  -f, --file=FILENAME[@W]  read transaction script from FILENAME,\n"
+		   "                           with weight W (default: 1)\n"
 		   "  -j, --jobs=NUM           number of threads (default: 1)\n"
 		   "  -l, --log                write transaction times to log file\n"
 		   "  -M, --protocol=simple|extended|prepared\n"
@@ -871,6 +902,240 @@ preparedStatementName(char *buffer, int file, int state)
 	sprintf(buffer, "P%d_%d", file, state);
 }
 
+/* Return the index of the histogram bucket counting the given latency */
+static int
+hist_bucket(int64 value)
+{
+	int			shift = 0;
+
+	if (value < HIST_EXACT)
+		return (value < 0) ? 0 : (int) value;
+	if (value >= INT64CONST(1) << HIST_MAX_BITS)
+		value = (INT64CONST(1) << HIST_MAX_BITS) - 1;
+
+	while ((value >> shift) >= 2 * HIST_SUB_BUCKETS)
+		shift++;
+	return HIST_EXACT + (shift - 1) * HIST_SUB_BUCKETS +
+		(int) (value >> shift) - HIST_SUB_BUCKETS;
+}
+
+/* Return the latency in the middle of the given histogram bucket */
+static int64
+hist_bucket_value(int bucket)
+{
+	int			shift;
+	int64		sub;
+
+	if (bucket < HIST_EXACT)
+		return bucket;
+	shift = (bucket - HIST_EXACT) / HIST_SUB_BUCKETS + 1;
+	sub = (bucket - HIST_EXACT) % HIST_SUB_BUCKETS + HIST_SUB_BUCKETS;
+	return (sub << shift) + (INT64CONST(1) << (shift - 1));
+}
+
+static void
+hist_add(Histogram *hist, int64 value)
+{
+	hist->count++;
+	hist->sum += value;
+	if (value > hist->max)
+		hist->max = value;
+	hist->buckets[hist_bucket(value)]++;
+}
+
+/* Add the contents of histogram src to dst */
+static void
+hist_merge(Histogram *dst, const Histogram *src)
+{
+	int			i;
+
+	dst->count += src->count;
+	dst->sum += src->sum;
+	if (src->max > dst->max)
+		dst->max = src->max;
+	for (i = 0; i < HIST_SIZE; i++)
+		dst->buckets[i] += src->buckets[i];
+}
+
+/*
+ * Return the latency, in milliseconds, below which the given fraction of the
+ * latencies recorded in the histogram lie.
+ */
+static double
+hist_percentile(const Histogram *hist, double fraction)
+{
+	int64		target = (int64) ceil(fraction * hist->count);
+	int64		cum = 0;
+	int			i;
+
+	if (hist->count == 0)
+		return 0.0;
+	target = Max(target, 1);
+
+	for (i = 0; i < HIST_SIZE; i++)
+	{
+		cum += hist->buckets[i];
+		if (cum >= target)
+			return 0.001 * Min(hist_bucket_value(i), hist->max);
+	}
+	return 0.001 * hist->max;
+}
+
+/*
+ * Compute the histogram of the latencies recorded by the given threads since
+ * the previous progress report.  *last holds the totals as of that report,
+ * and is updated.  The per-thread histograms may be updated concurrently,
+ * but the result is good enough for a progress report.
+ */
+static void
+progressHistogram(TState *threads, int nthreads, Histogram *last,
+				  Histogram *interval)
+{
+	int			t,
+				f,
+				i;
+
+	memset(interval, 0, sizeof(Histogram));
+	for (t = 0; t < nthreads; t++)
+		for (f = 0; f < num_files; f++)
+			hist_merge(interval, &threads[t].script_hist[f]);
+
+	interval->count -= last->count;
+	interval->sum -= last->sum;
+	for (i = 0; i < HIST_SIZE; i++)
+	{
+		int64		total = interval->buckets[i];
+
+		interval->buckets[i] -= last->buckets[i];
+		last->buckets[i] = total;
+	}
+	last->count += interval->count;
+	last->sum += interval->sum;
+
+	/* we don't know the exact maximum over the interval; approximate it */
+	interval->max = 0;
+	for (i = HIST_SIZE - 1; i >= 0; i--)
+	{
+		if (interval->buckets[i] > 0)
+		{
+			interval->max = hist_bucket_value(i);
+			break;
+		}
+	}
+}
+
+/* Print the usual set of latency percentiles of a histogram */
+static void
+printPercentiles(const char *prefix, const Histogram *hist)
+{
+	printf("%slatency percentiles: 50%% %.3f, 90%% %.3f, 95%% %.3f, "
+		   "99%% %.3f, 99.9%% %.3f, max %.3f ms\n",
+		   prefix,
+		   hist_percentile(hist, 0.50), hist_percentile(hist, 0.90),
+		   hist_percentile(hist, 0.95), hist_percentile(hist, 0.99),
+		   hist_percentile(hist, 0.999), 0.001 * hist->max);
+}
+
+/* Choose the script for a client's next transaction, according to weights */
+static int
+chooseScript(TState *thread)
+{
+	int			i;
+	int64		w;
+
+	if (num_files == 1)
+		return 0;
+
+	w = getrand(thread, 0, total_weight - 1);
+	for (i = 0; i < num_files - 1; i++)
+	{
+		w -= sql_file_weights[i];
+		if (w < 0)
+			break;
+	}
+	return i;
+}
+
+/*
+ * Prepare all the SQL commands of the client's current script, if we didn't
+ * do so already.
+ */
+static void
+prepareScript(CState *st, Command **commands)
+{
+	int			j;
+
+	if (st->prepared[st->use_file])
+		return;
+
+	for (j = 0; commands[j] != NULL; j++)
+	{
+		PGresult   *res;
+		char		name[MAX_PREPARE_NAME];
+
+		if (commands[j]->type != SQL_COMMAND)
+			continue;
+		preparedStatementName(name, st->use_file, j);
+		res = PQprepare(st->con, name,
+						commands[j]->argv[0], commands[j]->argc - 1, NULL);
+		if (PQresultStatus(res) != PGRES_COMMAND_OK)
+			fprintf(stderr, "%s", PQerrorMessage(st->con));
+		PQclear(res);
+	}
+	st->prepared[st->use_file] = true;
+}
+
+/*
+ * Does the given command wait for a response from the server before the
+ * client can move on?  SQL commands sent inside a pipeline don't; their
+ * results are collected by the \endpipeline that ends the pipeline.
+ */
+static bool
+waitsForResponse(CState *st, Command *command)
+{
+	if (command->type == SQL_COMMAND)
+		return !st->in_pipeline;
+	return pg_strcasecmp(command->argv[0], "endpipeline") == 0;
+}
+
+/*
+ * Collect the results of the commands sent in a pipeline, up to the result
+ * of the synchronization point sent by \endpipeline, without blocking.
+ * Returns 1 when the pipeline is done, 0 if more input is needed, and -1 if
+ * one of its commands failed.
+ */
+static int
+collectPipelineResults(CState *st)
+{
+	PGresult   *res;
+
+	for (;;)
+	{
+		if (PQisBusy(st->con))
+			return 0;
+
+		res = PQgetResult(st->con);
+		if (res == NULL)
+			continue;			/* end of one command's results */
+
+		switch (PQresultStatus(res))
+		{
+			case PGRES_COMMAND_OK:
+			case PGRES_TUPLES_OK:
+				PQclear(res);
+				break;			/* OK, on to the next command */
+			case PGRES_PIPELINE_SYNC:
+				PQclear(res);
+				return 1;
+			default:
+				fprintf(stderr, "Client %d aborted in state %d: %s",
+						st->id, st->state, PQerrorMessage(st->con));
+				PQclear(res);
+				return -1;
+		}
+	}
+}
+
 static bool
 clientDone(CState *st, bool ok)
 {
@@ -939,6 +1204,7 @@ top:
 		thread->throttle_trigger += wait;
 
 		st->until = thread->throttle_trigger;
+		st->txn_scheduled = thread->throttle_trigger;
 		st->sleeping = 1;
 		st->throttling = true;
 		st->is_throttled = true;
@@ -973,7 +1239,12 @@ top:
 
 	if (st->listen)
 	{							/* are we receiver? */
-		if (commands[st->state]->type == SQL_COMMAND)
+		instr_time	txn_end;
+		double		txn_usec = 0;
+
+		INSTR_TIME_SET_ZERO(txn_end);
+
+		if (waitsForResponse(st, commands[st->state]))
 		{
 			if (debug)
 				fprintf(stderr, "client %d receiving\n", st->id);
@@ -982,7 +1253,24 @@ top:
 				fprintf(stderr, "Client %d aborted in state %d. Probably the backend died while processing.\n", st->id, st->state);
 				return clientDone(st, false);
 			}
-			if (PQisBusy(st->con))
+			if (commands[st->state]->type == META_COMMAND)
+			{
+				/* \endpipeline: wait for the results of the whole pipeline */
+				int			r = collectPipelineResults(st);
+
+				if (r < 0)
+					return clientDone(st, false);
+				if (r == 0)
+					return true;	/* don't have all the results yet */
+				if (!PQexitPipelineMode(st->con))
+				{
+					fprintf(stderr, "Client %d aborted in state %d: %s",
+							st->id, st->state, PQerrorMessage(st->con));
+					return clientDone(st, false);
+				}
+				st->in_pipeline = false;
+			}
+			else if (PQisBusy(st->con))
 				return true;	/* don't have the whole result yet */
 		}
 
@@ -1001,15 +1289,24 @@ top:
 			thread->exec_count[cnum]++;
 		}
 
-		/* transaction finished: record latency under progress or throttling */
-		if ((progress || throttle_delay) && commands[st->state + 1] == NULL)
+		/*
+		 * transaction finished: record its latency.  Under throttling, it is
+		 * measured from the scheduled start of the transaction rather than
+		 * from its actual start, so that the time spent waiting behind
+		 * earlier, slow transactions counts too.
+		 */
+		if (commands[st->state + 1] == NULL)
 		{
-			instr_time	diff;
 			int64		latency;
 
-			INSTR_TIME_SET_CURRENT(diff);
-			INSTR_TIME_SUBTRACT(diff, st->txn_begin);
-			latency = INSTR_TIME_GET_MICROSEC(diff);
+			INSTR_TIME_SET_CURRENT(txn_end);
+			if (throttle_delay)
+				latency = INSTR_TIME_GET_MICROSEC(txn_end) - st->txn_scheduled;
+			else
+				latency = INSTR_TIME_GET_MICROSEC(txn_end) -
+					INSTR_TIME_GET_MICROSEC(st->txn_begin);
+			txn_usec = (double) latency;
+
 			st->txn_latencies += latency;
 			/*
 			 * XXX In a long benchmark run of high-latency transactions, this
@@ -1019,6 +1316,7 @@ top:
 			 * would take 256 hours.
 			 */
 			st->txn_sqlats += latency * latency;
+			hist_add(&thread->script_hist[st->use_file], latency);
 		}
 
 		/*
@@ -1026,9 +1324,8 @@ top:
 		 */
 		if (logfile && commands[st->state + 1] == NULL)
 		{
-			instr_time	now;
-			instr_time	diff;
-			double		usec;
+			instr_time	now = txn_end;
+			double		usec = txn_usec;
 
 			/*
 			 * write the log entry if this row belongs to the random sample,
@@ -1037,10 +1334,6 @@ top:
 			if (sample_rate == 0.0 ||
 				pg_erand48(thread->random_state) <= sample_rate)
 			{
-				INSTR_TIME_SET_CURRENT(now);
-				diff = now;
-				INSTR_TIME_SUBTRACT(diff, st->txn_begin);
-				usec = (double) INSTR_TIME_GET_MICROSEC(diff);
 
 				/* should we aggregate the results or not? */
 				if (agg_interval > 0)
@@ -1131,7 +1424,7 @@ top:
 			}
 		}
 
-		if (commands[st->state]->type == SQL_COMMAND)
+		if (commands[st->state]->type == SQL_COMMAND && !st->in_pipeline)
 		{
 			/*
 			 * Read and discard the query result; note this is not included in
@@ -1171,7 +1464,7 @@ top:
 		if (commands[st->state] == NULL)
 		{
 			st->state = 0;
-			st->use_file = (int) getrand(thread, 0, num_files - 1);
+			st->use_file = chooseScript(thread);
 			commands = sql_files[st->use_file];
 			st->is_throttled = false;
 			/*
@@ -1210,8 +1503,8 @@ top:
 		goto top;
 	}
 
-	/* Record transaction start time under logging, progress or throttling */
-	if ((logfile || progress || throttle_delay) && st->state == 0)
+	/* Record transaction start time */
+	if (st->state == 0)
 		INSTR_TIME_SET_CURRENT(st->txn_begin);
 
 	/* Record statement start time if per-command latencies are requested */
@@ -1252,26 +1545,7 @@ top:
 			char		name[MAX_PREPARE_NAME];
 			const char *params[MAX_ARGS];
 
-			if (!st->prepared[st->use_file])
-			{
-				int			j;
-
-				for (j = 0; commands[j] != NULL; j++)
-				{
-					PGresult   *res;
-					char		name[MAX_PREPARE_NAME];
-
-					if (commands[j]->type != SQL_COMMAND)
-						continue;
-					preparedStatementName(name, st->use_file, j);
-					res = PQprepare(st->con, name,
-						  commands[j]->argv[0], commands[j]->argc - 1, NULL);
-					if (PQresultStatus(res) != PGRES_COMMAND_OK)
-						fprintf(stderr, "%s", PQerrorMessage(st->con));
-					PQclear(res);
-				}
-				st->prepared[st->use_file] = true;
-			}
+			prepareScript(st, commands);
 
 			getQueryParams(st, command, params);
 			preparedStatementName(name, st->use_file, st->state);
@@ -1291,7 +1565,13 @@ top:
 			st->ecnt++;
 		}
 		else
+		{
 			st->listen = 1;		/* flags that should be listened */
+
+			/* in a pipeline, go on sending without waiting for the result */
+			if (st->in_pipeline)
+				goto top;
+		}
 	}
 	else if (commands[st->state]->type == META_COMMAND)
 	{
@@ -1515,6 +1795,36 @@ top:
 			else	/* succeeded */
 				st->listen = 1;
 		}
+		else if (pg_strcasecmp(argv[0], "startpipeline") == 0)
+		{
+			/* statements must be prepared before entering pipeline mode */
+			if (querymode == QUERY_PREPARED)
+				prepareScript(st, commands);
+
+			if (st->in_pipeline || !PQenterPipelineMode(st->con))
+			{
+				fprintf(stderr, "%s: cannot enter pipeline mode: %s",
+						argv[0], PQerrorMessage(st->con));
+				st->ecnt++;
+				return true;
+			}
+			st->in_pipeline = true;
+			st->listen = 1;
+		}
+		else if (pg_strcasecmp(argv[0], "endpipeline") == 0)
+		{
+			if (!st->in_pipeline || !PQpipelineSync(st->con))
+			{
+				fprintf(stderr, "%s: cannot send pipeline synchronization point: %s",
+						argv[0], PQerrorMessage(st->con));
+				st->ecnt++;
+				return true;
+			}
+
+			/* the results are collected once the server responds */
+			st->listen = 1;
+			return true;
+		}
 		goto top;
 	}
 
@@ -1979,6 +2289,13 @@ process_commands(char *buf)
 				exit(1);
 			}
 		}
+		else if (pg_strcasecmp(my_commands->argv[0], "startpipeline") == 0 ||
+				 pg_strcasecmp(my_commands->argv[0], "endpipeline") == 0)
+		{
+			for (j = 1; j < my_commands->argc; j++)
+				fprintf(stderr, "%s: extra argument \"%s\" ignored\n",
+						my_commands->argv[0], my_commands->argv[j]);
+		}
 		else
 		{
 			fprintf(stderr, "Invalid command %s\n", my_commands->argv[0]);
@@ -2061,6 +2378,7 @@ process_file(char *filename)
 	int			lineno;
 	char	   *buf;
 	int			alloc_num;
+	bool		in_pipeline = false;
 
 	if (num_files >= MAX_FILES)
 	{
@@ -2092,6 +2410,28 @@ process_file(char *filename)
 		if (command == NULL)
 			continue;
 
+		/* pipelines must be properly bracketed within the script */
+		if (command->type == META_COMMAND &&
+			(pg_strcasecmp(command->argv[0], "startpipeline") == 0 ||
+			 pg_strcasecmp(command->argv[0], "endpipeline") == 0))
+		{
+			bool		start = (pg_strcasecmp(command->argv[0], "startpipeline") == 0);
+
+			if (start == in_pipeline)
+			{
+				fprintf(stderr, "%s: \\%s %s\n", filename, command->argv[0],
+						start ? "inside a pipeline" : "without \\startpipeline");
+				exit(1);
+			}
+			in_pipeline = start;
+		}
+		else if (in_pipeline && command->type == META_COMMAND)
+		{
+			fprintf(stderr, "%s: meta command \\%s not allowed inside a pipeline\n",
+					filename, command->argv[0]);
+			exit(1);
+		}
+
 		my_commands[lineno] = command;
 		lineno++;
 
@@ -2103,6 +2443,12 @@ process_file(char *filename)
 	}
 	fclose(fd);
 
+	if (in_pipeline)
+	{
+		fprintf(stderr, "%s: \\startpipeline without \\endpipeline\n", filename);
+		exit(1);
+	}
+
 	my_commands[lineno] = NULL;
 
 	sql_files[num_files++] = my_commands;
@@ -2167,12 +2513,15 @@ printResults(int ttype, int normal_xacts, int nclients,
 			 TState *threads, int nthreads,
 			 instr_time total_time, instr_time conn_total_time,
 			 int64 total_latencies, int64 total_sqlats,
-			 int64 throttle_lag, int64 throttle_lag_max)
+			 int64 throttle_lag, int64 throttle_lag_max,
+			 Histogram *script_hist)
 {
 	double		time_include,
 				tps_include,
 				tps_exclude;
 	char	   *s;
+	Histogram	all_hist;
+	int			f;
 
 	time_include = INSTR_TIME_GET_DOUBLE(total_time);
 	tps_include = normal_xacts / time_include;
@@ -2206,21 +2555,19 @@ printResults(int ttype, int normal_xacts, int nclients,
 			   normal_xacts);
 	}
 
-	if (throttle_delay || progress)
+	/* compute and show latency average, standard deviation and percentiles */
 	{
-		/* compute and show latency average and standard deviation */
 		double latency = 0.001 * total_latencies / normal_xacts;
 		double sqlat = (double) total_sqlats / normal_xacts;
 		printf("latency average: %.3f ms\n"
 			   "latency stddev: %.3f ms\n",
 			   latency, 0.001 * sqrt(sqlat - 1000000.0 * latency * latency));
 	}
-	else
-	{
-		/* only an average latency computed from the duration is available */
-		printf("latency average: %.3f ms\n",
-			   1000.0 * duration * nclients / normal_xacts);
-	}
+
+	memset(&all_hist, 0, sizeof(all_hist));
+	for (f = 0; f < num_files; f++)
+		hist_merge(&all_hist, &script_hist[f]);
+	printPercentiles("", &all_hist);
 
 	if (throttle_delay)
 	{
@@ -2237,6 +2584,24 @@ printResults(int ttype, int normal_xacts, int nclients,
 	printf("tps = %f (including connections establishing)\n", tps_include);
 	printf("tps = %f (excluding connections establishing)\n", tps_exclude);
 
+	/* Report per-script transaction counts and latencies */
+	if (num_files > 1)
+	{
+		for (f = 0; f < num_files; f++)
+		{
+			Histogram  *hist = &script_hist[f];
+
+			printf("script %d: %s, weight %d\n",
+				   f + 1, sql_file_names[f], sql_file_weights[f]);
+			printf(" - " INT64_FORMAT " transactions (%.1f%% of total), "
+				   "latency average %.3f ms\n",
+				   hist->count,
+				   normal_xacts > 0 ? 100.0 * hist->count / normal_xacts : 0.0,
+				   hist->count > 0 ? 0.001 * hist->sum / hist->count : 0.0);
+			printPercentiles(" - ", hist);
+		}
+	}
+
 	/* Report per-command latencies */
 	if (is_latencies)
 	{
@@ -2346,8 +2711,10 @@ main(int argc, char **argv)
 	int64		total_sqlats = 0;
 	int64       throttle_lag = 0;
 	int64       throttle_lag_max = 0;
+	Histogram  *script_hist;
 
-	int			i;
+	int			i,
+				f;
 
 #ifdef HAVE_GETRLIMIT
 	struct rlimit rlim;
@@ -2502,10 +2869,28 @@ main(int argc, char **argv)
 				use_quiet = true;
 				break;
 			case 'f':
-				ttype = 3;
-				filename = pg_strdup(optarg);
-				if (process_file(filename) == false || *sql_files[num_files - 1] == NULL)
-					exit(1);
+				{
+					char	   *sep;
+					int			weight = 1;
+
+					ttype = 3;
+					filename = pg_strdup(optarg);
+
+					/* an optional @weight suffix gives the script's weight */
+					sep = strrchr(filename, '@');
+					if (sep != NULL && sep[1] != '\0' &&
+						strspn(sep + 1, "0123456789") == strlen(sep + 1))
+					{
+						*sep = '\0';
+						weight = atoi(sep + 1);
+					}
+
+					if (process_file(filename) == false || *sql_files[num_files - 1] == NULL)
+						exit(1);
+					sql_file_names[num_files - 1] = filename;
+					sql_file_weights[num_files - 1] = weight;
+					total_weight += weight;
+				}
 				break;
 			case 'D':
 				{
@@ -2821,20 +3206,31 @@ main(int argc, char **argv)
 	{
 		case 0:
 			sql_files[0] = process_builtin(tpc_b);
+			sql_file_names[0] = "builtin: TPC-B (sort of)";
+			sql_file_weights[0] = total_weight = 1;
 			num_files = 1;
 			break;
 
 		case 1:
 			sql_files[0] = process_builtin(select_only);
+			sql_file_names[0] = "builtin: SELECT only";
+			sql_file_weights[0] = total_weight = 1;
 			num_files = 1;
 			break;
 
 		case 2:
 			sql_files[0] = process_builtin(simple_update);
+			sql_file_names[0] = "builtin: simple update";
+			sql_file_weights[0] = total_weight = 1;
 			num_files = 1;
 			break;
 
 		default:
+			if (total_weight <= 0)
+			{
+				fprintf(stderr, "total weight of script files must be positive\n");
+				exit(1);
+			}
 			break;
 	}
 
@@ -2850,6 +3246,8 @@ main(int argc, char **argv)
 		thread->random_state[0] = random();
 		thread->random_state[1] = random();
 		thread->random_state[2] = random();
+		thread->script_hist = (Histogram *)
+			pg_malloc0(sizeof(Histogram) * num_files);
 
 		if (is_latencies)
 		{
@@ -2907,6 +3305,7 @@ main(int argc, char **argv)
 
 	/* wait for threads and accumulate results */
 	INSTR_TIME_SET_ZERO(conn_total_time);
+	script_hist = (Histogram *) pg_malloc0(sizeof(Histogram) * num_files);
 	for (i = 0; i < nthreads; i++)
 	{
 		void	   *ret = NULL;
@@ -2927,6 +3326,8 @@ main(int argc, char **argv)
 			if (r->throttle_lag_max > throttle_lag_max)
 				throttle_lag_max = r->throttle_lag_max;
 			INSTR_TIME_ADD(conn_total_time, r->conn_time);
+			for (f = 0; f < num_files; f++)
+				hist_merge(&script_hist[f], &r->script_hist[f]);
 			free(ret);
 		}
 	}
@@ -2946,7 +3347,7 @@ main(int argc, char **argv)
 	INSTR_TIME_SUBTRACT(total_time, start_time);
 	printResults(ttype, total_xacts, nclients, threads, nthreads,
 				 total_time, conn_total_time, total_latencies, total_sqlats,
-				 throttle_lag, throttle_lag_max);
+				 throttle_lag, throttle_lag_max, script_hist);
 
 	return 0;
 }
@@ -2968,6 +3369,8 @@ threadRun(void *arg)
 	int64		last_report = thread_start;
 	int64		next_report = last_report + (int64) progress * 1000000;
 	int64		last_count = 0, last_lats = 0, last_sqlats = 0, last_lags = 0;
+	Histogram  *last_hist = NULL;
+	Histogram  *interval_hist = NULL;
 
 	AggVals		aggs;
 
@@ -2984,6 +3387,12 @@ threadRun(void *arg)
 
 	result = pg_malloc(sizeof(TResult));
 
+	if (progress)
+	{
+		last_hist = (Histogram *) pg_malloc0(sizeof(Histogram));
+		interval_hist = (Histogram *) pg_malloc(sizeof(Histogram));
+	}
+
 	INSTR_TIME_SET_ZERO(result->conn_time);
 
 	/* open log file if requested */
@@ -3027,7 +3436,7 @@ threadRun(void *arg)
 		Command   **commands = sql_files[st->use_file];
 		int			prev_ecnt = st->ecnt;
 
-		st->use_file = getrand(thread, 0, num_files - 1);
+		st->use_file = chooseScript(thread);
 		if (!doCustom(thread, st, &result->conn_time, logfile, &aggs))
 			remains--;			/* I've aborted */
 
@@ -3090,7 +3499,7 @@ threadRun(void *arg)
 						min_usec = this_usec;
 				}
 			}
-			else if (commands[st->state]->type == META_COMMAND)
+			else if (!waitsForResponse(st, commands[st->state]))
 			{
 				min_usec = 0;	/* the connection is ready to run */
 				break;
@@ -3141,7 +3550,7 @@ threadRun(void *arg)
 			int			prev_ecnt = st->ecnt;
 
 			if (st->con && (FD_ISSET(PQsocket(st->con), &input_mask)
-							|| commands[st->state]->type == META_COMMAND))
+							|| !waitsForResponse(st, commands[st->state])))
 			{
 				if (!doCustom(thread, st, &result->conn_time, logfile, &aggs))
 					remains--;	/* I've aborted */
@@ -3185,17 +3594,25 @@ threadRun(void *arg)
 				sqlat = 1.0 * (sqlats - last_sqlats) / (count - last_count);
 				stdev = 0.001 * sqrt(sqlat - 1000000.0 * latency * latency);
 				lag = 0.001 * (lags - last_lags) / (count - last_count);
+				progressHistogram(thread, 1, last_hist, interval_hist);
 
 				if (throttle_delay)
 					fprintf(stderr,
 							"progress %d: %.1f s, %.1f tps, "
-							"lat %.3f ms stddev %.3f, lag %.3f ms\n",
-							thread->tid, total_run, tps, latency, stdev, lag);
+							"lat %.3f ms stddev %.3f p50 %.3f p95 %.3f p99 %.3f, "
+							"lag %.3f ms\n",
+							thread->tid, total_run, tps, latency, stdev,
+							hist_percentile(interval_hist, 0.50),
+							hist_percentile(interval_hist, 0.95),
+							hist_percentile(interval_hist, 0.99), lag);
 				else
 					fprintf(stderr,
 							"progress %d: %.1f s, %.1f tps, "
-							"lat %.3f ms stddev %.3f\n",
-							thread->tid, total_run, tps, latency, stdev);
+							"lat %.3f ms stddev %.3f p50 %.3f p95 %.3f p99 %.3f\n",
+							thread->tid, total_run, tps, latency, stdev,
+							hist_percentile(interval_hist, 0.50),
+							hist_percentile(interval_hist, 0.95),
+							hist_percentile(interval_hist, 0.99));
 
 				last_count = count;
 				last_lats = lats;
@@ -3236,17 +3653,26 @@ threadRun(void *arg)
 				sqlat = 1.0 * (sqlats - last_sqlats) / (count - last_count);
 				stdev = 0.001 * sqrt(sqlat - 1000000.0 * latency * latency);
 				lag = 0.001 * (lags - last_lags) / (count - last_count);
+				progressHistogram(thread, progress_nthreads, last_hist,
+								  interval_hist);
 
 				if (throttle_delay)
 					fprintf(stderr,
 							"progress: %.1f s, %.1f tps, "
-							"lat %.3f ms stddev %.3f, lag %.3f ms\n",
-							total_run, tps, latency, stdev, lag);
+							"lat %.3f ms stddev %.3f p50 %.3f p95 %.3f p99 %.3f, "
+							"lag %.3f ms\n",
+							total_run, tps, latency, stdev,
+							hist_percentile(interval_hist, 0.50),
+							hist_percentile(interval_hist, 0.95),
+							hist_percentile(interval_hist, 0.99), lag);
 				else
 					fprintf(stderr,
 							"progress: %.1f s, %.1f tps, "
-							"lat %.3f ms stddev %.3f\n",
-							total_run, tps, latency, stdev);
+							"lat %.3f ms stddev %.3f p50 %.3f p95 %.3f p99 %.3f\n",
+							total_run, tps, latency, stdev,
+							hist_percentile(interval_hist, 0.50),
+							hist_percentile(interval_hist, 0.95),
+							hist_percentile(interval_hist, 0.99));
 
 				last_count = count;
 				last_lats = lats;
@@ -3273,6 +3699,7 @@ done:
 	}
 	result->throttle_lag = thread->throttle_lag;
 	result->throttle_lag_max = thread->throttle_lag_max;
+	result->script_hist = thread->script_hist;
 	INSTR_TIME_SET_CURRENT(end);
 	INSTR_TIME_ACCUM_DIFF(result->conn_time, end, start);
 	if (logfile)
@@ -3350,6 +3777,9 @@ pthread_create(pthread_t *thread,
 
 	ret = start_routine(arg);
 	rc = write(th->pipes[1], ret, sizeof(TResult));
+	if (rc == sizeof(TResult))
+		rc = write(th->pipes[1], ((TResult *) ret)->script_hist,
+				   sizeof(Histogram) * num_files);
 	(void) rc;
 	close(th->pipes[1]);
 	free(th);
@@ -3361,21 +3791,46 @@ pthread_join(pthread_t th, void **thread_return)
 {
 	int			status;
 
-	while (waitpid(th->pid, &status, 0) != th->pid)
-	{
-		if (errno != EINTR)
-			return errno;
-	}
-
+	/*
+	 * Read the result before waiting for the child: the histograms may not
+	 * fit in the pipe's buffer.
+	 */
 	if (thread_return != NULL)
 	{
-		/* assume result is TResult */
-		*thread_return = pg_malloc(sizeof(TResult));
-		if (read(th->pipes[0], *thread_return, sizeof(TResult)) != sizeof(TResult))
+		/* assume result is TResult, followed by the histograms */
+		TResult    *r = pg_malloc(sizeof(TResult));
+		Size		hist_size = sizeof(Histogram) * num_files;
+		Size		done = 0;
+
+		r->script_hist = NULL;
+		if (read(th->pipes[0], r, sizeof(TResult)) == sizeof(TResult))
+		{
+			r->script_hist = pg_malloc(hist_size);
+			while (done < hist_size)
+			{
+				ssize_t		n = read(th->pipes[0],
+									 (char *) r->script_hist + done,
+									 hist_size - done);
+
+				if (n <= 0)
+					break;
+				done += n;
+			}
+		}
+		if (done != hist_size)
 		{
-			free(*thread_return);
-			*thread_return = NULL;
+			if (r->script_hist)
+				free(r->script_hist);
+			free(r);
+			r = NULL;
 		}
+		*thread_return = r;
+	}
+
+	while (waitpid(th->pid, &status, 0) != th->pid)
+	{
+		if (errno != EINTR)
+			return errno;
 	}
 	close(th->pipes[0]);
 
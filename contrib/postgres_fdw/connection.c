@@ -34,6 +34,12 @@
  * commands at the same nesting depth on the remote as we're executing at
  * ourselves, so that rolling back a subtransaction will kill the right
  * queries and not the wrong ones.
+ *
+ * A connection can also have at most one asynchronous request in flight,
+ * sent with PQsendQuery on behalf of some "owner" (a scan, in practice).
+ * Anyone else wanting to use the connection must first call
+ * pgfdw_drain_pending, which collects the request's result and stashes it
+ * in the cache entry until the owner asks for it.
  */
 typedef struct ConnCacheKey
 {
@@ -49,6 +55,9 @@ typedef struct ConnCacheEntry
 								 * one level of subxact open, etc */
 	bool		have_prep_stmt; /* have we prepared any stmts in this xact? */
 	bool		have_error;		/* have any subxacts aborted in this xact? */
+	void	   *pending_owner;	/* owner of async request, or NULL if none */
+	bool		pending_busy;	/* is the request's result still unread? */
+	PGresult   *pending_res;	/* result collected by drain_pending_request */
 } ConnCacheEntry;
 
 /*
@@ -63,12 +72,18 @@ static unsigned int prep_stmt_number = 0;
 /* tracks whether any work is needed in callback functions */
 static bool xact_got_connection = false;
 
+/* number of cache entries with an async request in flight */
+static int	num_pending_busy = 0;
+
 /* prototypes of private functions */
 static PGconn *connect_pg_server(ForeignServer *server, UserMapping *user);
 static void check_conn_params(const char **keywords, const char **values);
 static void configure_remote_session(PGconn *conn);
 static void do_sql_command(PGconn *conn, const char *sql);
 static void begin_remote_xact(ConnCacheEntry *entry);
+static ConnCacheEntry *find_conn_entry(PGconn *conn);
+static void drain_pending_request(ConnCacheEntry *entry);
+static void discard_pending_request(ConnCacheEntry *entry, bool cancel);
 static void pgfdw_xact_callback(XactEvent event, void *arg);
 static void pgfdw_subxact_callback(SubXactEvent event,
 					   SubTransactionId mySubid,
@@ -142,6 +157,9 @@ GetConnection(ForeignServer *server, UserMapping *user,
 		entry->xact_depth = 0;
 		entry->have_prep_stmt = false;
 		entry->have_error = false;
+		entry->pending_owner = NULL;
+		entry->pending_busy = false;
+		entry->pending_res = NULL;
 	}
 
 	/*
@@ -374,6 +392,10 @@ begin_remote_xact(ConnCacheEntry *entry)
 {
 	int			curlevel = GetCurrentTransactionNestLevel();
 
+	/* Any in-flight request must complete before we can send commands */
+	if (entry->xact_depth <= 0 || entry->xact_depth < curlevel)
+		drain_pending_request(entry);
+
 	/* Start main transaction if we haven't yet */
 	if (entry->xact_depth <= 0)
 	{
@@ -449,6 +471,160 @@ GetPrepStmtNumber(PGconn *conn)
 	return ++prep_stmt_number;
 }
 
+/*
+ * Find the cache entry for an open connection.
+ */
+static ConnCacheEntry *
+find_conn_entry(PGconn *conn)
+{
+	HASH_SEQ_STATUS scan;
+	ConnCacheEntry *entry;
+
+	hash_seq_init(&scan, ConnectionHash);
+	while ((entry = (ConnCacheEntry *) hash_seq_search(&scan)))
+	{
+		if (entry->conn == conn)
+		{
+			hash_seq_term(&scan);
+			return entry;
+		}
+	}
+	elog(ERROR, "postgres_fdw connection %p not found in cache", conn);
+	return NULL;				/* keep compiler quiet */
+}
+
+/*
+ * Read the result of the connection's in-flight request, if any, and stash
+ * it for the request's owner.  If the request consisted of several
+ * statements, we keep the first error result, or else the last result.
+ */
+static void
+drain_pending_request(ConnCacheEntry *entry)
+{
+	PGresult   *res;
+	PGresult   *last = NULL;
+
+	if (!entry->pending_busy)
+		return;
+
+	while ((res = PQgetResult(entry->conn)) != NULL)
+	{
+		if (last == NULL)
+			last = res;
+		else if (PQresultStatus(last) == PGRES_FATAL_ERROR)
+			PQclear(res);
+		else
+		{
+			PQclear(last);
+			last = res;
+		}
+	}
+
+	entry->pending_busy = false;
+	entry->pending_res = last;
+	num_pending_busy--;
+}
+
+/*
+ * Throw away the connection's async request and its result, if any.  If
+ * cancel is true, try to cancel a request still running on the remote side
+ * rather than waiting for it to finish.
+ */
+static void
+discard_pending_request(ConnCacheEntry *entry, bool cancel)
+{
+	if (entry->pending_owner == NULL)
+		return;
+
+	if (entry->pending_busy && cancel)
+	{
+		PGcancel   *cancel_obj = PQgetCancel(entry->conn);
+		char		errbuf[256];
+
+		if (cancel_obj)
+		{
+			if (!PQcancel(cancel_obj, errbuf, sizeof(errbuf)))
+				ereport(WARNING,
+						(errcode(ERRCODE_CONNECTION_FAILURE),
+						 errmsg("could not send cancel request: %s",
+								errbuf)));
+			PQfreeCancel(cancel_obj);
+		}
+	}
+	drain_pending_request(entry);
+
+	if (entry->pending_res)
+		PQclear(entry->pending_res);
+	entry->pending_res = NULL;
+	entry->pending_owner = NULL;
+}
+
+/*
+ * Record that the caller has just sent an asynchronous request on conn on
+ * behalf of owner.  The caller must have checked pgfdw_has_pending first.
+ */
+void
+pgfdw_set_pending(PGconn *conn, void *owner)
+{
+	ConnCacheEntry *entry = find_conn_entry(conn);
+
+	Assert(owner != NULL);
+	Assert(entry->pending_owner == NULL);
+
+	entry->pending_owner = owner;
+	entry->pending_busy = true;
+	entry->pending_res = NULL;
+	num_pending_busy++;
+}
+
+/*
+ * Is there an asynchronous request outstanding on conn, either still in
+ * flight or with a result that its owner hasn't collected yet?
+ */
+bool
+pgfdw_has_pending(PGconn *conn)
+{
+	return find_conn_entry(conn)->pending_owner != NULL;
+}
+
+/*
+ * Make conn available for a synchronous command, by collecting the result
+ * of any request in flight on it.  Every user of a connection that might
+ * be shared with an asynchronous scan must call this before sending
+ * anything.
+ */
+void
+pgfdw_drain_pending(PGconn *conn)
+{
+	/* Quick exit if no connection has anything in flight */
+	if (num_pending_busy == 0)
+		return;
+
+	drain_pending_request(find_conn_entry(conn));
+}
+
+/*
+ * Collect the result of owner's asynchronous request on conn, waiting for
+ * it if need be.  Returns false if owner has no request outstanding.
+ * Otherwise the result (possibly NULL, if the connection was lost) is
+ * returned in *res, and the caller becomes responsible for freeing it.
+ */
+bool
+pgfdw_get_pending_result(PGconn *conn, void *owner, PGresult **res)
+{
+	ConnCacheEntry *entry = find_conn_entry(conn);
+
+	if (entry->pending_owner != owner)
+		return false;
+
+	drain_pending_request(entry);
+
+	*res = entry->pending_res;
+	entry->pending_res = NULL;
+	entry->pending_owner = NULL;
+	return true;
+}
+
 /*
  * Report an error we got from the remote server.
  *
@@ -539,6 +715,9 @@ pgfdw_xact_callback(XactEvent event, void *arg)
 		if (entry->conn == NULL)
 			continue;
 
+		/* Nobody is left to collect the result of an async request */
+		discard_pending_request(entry, event == XACT_EVENT_ABORT);
+
 		/* If it has an open remote transaction, try to close it */
 		if (entry->xact_depth > 0)
 		{
@@ -688,6 +867,14 @@ pgfdw_subxact_callback(SubXactEvent event, SubTransactionId mySubid,
 			elog(ERROR, "missed cleaning up remote subtransaction at level %d",
 				 entry->xact_depth);
 
+		/*
+		 * Make the connection available for our commands.  We must not throw
+		 * away the result of an async request even on abort, since its owner
+		 * might be a cursor that survives the subtransaction; if the owner is
+		 * gone, the result just stays stashed until transaction end.
+		 */
+		drain_pending_request(entry);
+
 		if (event == SUBXACT_EVENT_PRE_COMMIT_SUB)
 		{
 			/* Commit all remote subtransactions during pre-commit */
@@ -881,6 +881,41 @@ deparseInsertSql(StringInfo buf, PlannerInfo *root,
 						 returningList, retrieved_attrs);
 }
 
+/*
+ * Construct a remote INSERT statement that inserts nrows rows at once.
+ *
+ * orig_query must be a statement built by deparseInsertSql with a non-empty
+ * target column list and no RETURNING clause, so that it ends with the
+ * VALUES list of its single row; nparams is the number of columns in that
+ * row.  We append further VALUES lists, numbering their parameters after
+ * those of the original row.
+ */
+void
+deparseBatchInsertSql(StringInfo buf, const char *orig_query,
+					  int nparams, int nrows)
+{
+	int			pindex = nparams + 1;
+	int			i;
+	int			j;
+
+	Assert(nparams > 0 && nrows > 0);
+
+	appendStringInfoString(buf, orig_query);
+
+	for (i = 1; i < nrows; i++)
+	{
+		appendStringInfoString(buf, ", (");
+		for (j = 0; j < nparams; j++)
+		{
+			if (j > 0)
+				appendStringInfoString(buf, ", ");
+			appendStringInfo(buf, "$%d", pindex);
+			pindex++;
+		}
+		appendStringInfoChar(buf, ')');
+	}
+}
+
 /*
  * deparse remote UPDATE statement
  *
@@ -126,6 +126,21 @@ postgres_fdw_validator(PG_FUNCTION_ARGS)
 						 errmsg("%s requires a non-negative numeric value",
 								def->defname)));
 		}
+		else if (strcmp(def->defname, "fetch_size") == 0 ||
+				 strcmp(def->defname, "batch_size") == 0)
+		{
+			/* these must have a positive integer value */
+			long		val;
+			char	   *endp;
+
+			errno = 0;
+			val = strtol(defGetString(def), &endp, 10);
+			if (*endp || errno == ERANGE || val <= 0 || val != (int) val)
+				ereport(ERROR,
+						(errcode(ERRCODE_SYNTAX_ERROR),
+						 errmsg("%s requires a positive integer value",
+								def->defname)));
+		}
 	}
 
 	PG_RETURN_VOID();
@@ -155,6 +170,11 @@ InitPgFdwOptions(void)
 		/* updatable is available on both server and table */
 		{"updatable", ForeignServerRelationId, false},
 		{"updatable", ForeignTableRelationId, false},
+		/* fetch_size and batch_size are available on both server and table */
+		{"fetch_size", ForeignServerRelationId, false},
+		{"fetch_size", ForeignTableRelationId, false},
+		{"batch_size", ForeignServerRelationId, false},
+		{"batch_size", ForeignTableRelationId, false},
 		{NULL, InvalidOid, false}
 	};
 
@@ -46,6 +46,12 @@ PG_MODULE_MAGIC;
 /* Default CPU cost to process 1 row (above and beyond cpu_tuple_cost). */
 #define DEFAULT_FDW_TUPLE_COST		0.01
 
+/* Default number of rows to retrieve per FETCH. */
+#define DEFAULT_FDW_FETCH_SIZE		100
+
+/* Largest number of parameters a remote statement may have. */
+#define PGFDW_MAX_PARAMS			65535
+
 /*
  * FDW-specific planner information kept in RelOptInfo.fdw_private for a
  * foreign table.  This information is collected by postgresGetForeignRelSize.
@@ -73,6 +79,7 @@ typedef struct PgFdwRelationInfo
 	bool		use_remote_estimate;
 	Cost		fdw_startup_cost;
 	Cost		fdw_tuple_cost;
+	int			fetch_size;
 
 	/* Cached catalog information. */
 	ForeignTable *table;
@@ -88,6 +95,8 @@ typedef struct PgFdwRelationInfo
  *
  * 1) SELECT statement text to be sent to the remote server
  * 2) Integer list of attribute numbers retrieved by the SELECT
+ * 3) Number of rows to retrieve per FETCH
+ * 4) Boolean flag showing if the query may be started at executor startup
  *
  * These items are indexed with the enum FdwScanPrivateIndex, so an item
  * can be fetched with list_nth().	For example, to get the SELECT statement:
@@ -98,7 +107,11 @@ enum FdwScanPrivateIndex
 	/* SQL statement to execute remotely (as a String node) */
 	FdwScanPrivateSelectSql,
 	/* Integer list of attribute numbers retrieved by the SELECT */
-	FdwScanPrivateRetrievedAttrs
+	FdwScanPrivateRetrievedAttrs,
+	/* Number of rows per FETCH (as an integer Value node) */
+	FdwScanPrivateFetchSize,
+	/* early-start flag (as an integer Value node) */
+	FdwScanPrivateEarlyStart
 };
 
 /*
@@ -143,6 +156,8 @@ typedef struct PgFdwScanState
 	FmgrInfo   *param_flinfo;	/* output conversion functions for them */
 	List	   *param_exprs;	/* executable expressions for param values */
 	const char **param_values;	/* textual values of query parameters */
+	int			fetch_size;		/* number of rows per FETCH */
+	bool		async_pending;	/* have we a FETCH in flight on conn? */
 
 	/* for storing result tuples */
 	HeapTuple  *tuples;			/* array of currently-retrieved tuples */
@@ -181,8 +196,15 @@ typedef struct PgFdwModifyState
 	int			p_nums;			/* number of parameters to transmit */
 	FmgrInfo   *p_flinfo;		/* output conversion functions for them */
 
-	/* working memory context */
+	/* for batched INSERT; batch_size is 1 if we're not batching */
+	int			batch_size;		/* max number of rows per remote INSERT */
+	int			num_batched;	/* number of rows currently queued */
+	const char **batch_values;	/* their parameter values, row by row */
+	char	   *batch_query;	/* INSERT statement for a full batch */
+
+	/* working memory contexts */
 	MemoryContext temp_cxt;		/* context for per-tuple temporary data */
+	MemoryContext batch_cxt;	/* context holding queued parameter values */
 } PgFdwModifyState;
 
 /*
@@ -307,9 +329,14 @@ static bool ec_member_matches_foreign(PlannerInfo *root, RelOptInfo *rel,
 						  EquivalenceClass *ec, EquivalenceMember *em,
 						  void *arg);
 static void create_cursor(ForeignScanState *node);
+static void start_cursor_async(PgFdwScanState *fsstate);
 static void fetch_more_data(ForeignScanState *node);
+static void fetch_ahead(PgFdwScanState *fsstate);
+static void discard_pending_fetch(PgFdwScanState *fsstate);
 static void close_cursor(PGconn *conn, unsigned int cursor_number);
 static void prepare_foreign_modify(PgFdwModifyState *fmstate);
+static int	get_batch_size_option(Relation rel);
+static void flush_batch_insert(PgFdwModifyState *fmstate);
 static const char **convert_prep_stmt_params(PgFdwModifyState *fmstate,
 						 ItemPointer tupleid,
 						 TupleTableSlot *slot);
@@ -401,6 +428,7 @@ postgresGetForeignRelSize(PlannerInfo *root,
 	fpinfo->use_remote_estimate = false;
 	fpinfo->fdw_startup_cost = DEFAULT_FDW_STARTUP_COST;
 	fpinfo->fdw_tuple_cost = DEFAULT_FDW_TUPLE_COST;
+	fpinfo->fetch_size = DEFAULT_FDW_FETCH_SIZE;
 
 	foreach(lc, fpinfo->server->options)
 	{
@@ -412,16 +440,17 @@ postgresGetForeignRelSize(PlannerInfo *root,
 			fpinfo->fdw_startup_cost = strtod(defGetString(def), NULL);
 		else if (strcmp(def->defname, "fdw_tuple_cost") == 0)
 			fpinfo->fdw_tuple_cost = strtod(defGetString(def), NULL);
+		else if (strcmp(def->defname, "fetch_size") == 0)
+			fpinfo->fetch_size = strtol(defGetString(def), NULL, 10);
 	}
 	foreach(lc, fpinfo->table->options)
 	{
 		DefElem    *def = (DefElem *) lfirst(lc);
 
 		if (strcmp(def->defname, "use_remote_estimate") == 0)
-		{
 			fpinfo->use_remote_estimate = defGetBoolean(def);
-			break;				/* only need the one value */
-		}
+		else if (strcmp(def->defname, "fetch_size") == 0)
+			fpinfo->fetch_size = strtol(defGetString(def), NULL, 10);
 	}
 
 	/*
@@ -747,6 +776,7 @@ postgresGetForeignPlan(PlannerInfo *root,
 	List	   *local_exprs = NIL;
 	List	   *params_list = NIL;
 	List	   *retrieved_attrs;
+	bool		early_start = true;
 	StringInfoData sql;
 	ListCell   *lc;
 
@@ -816,6 +846,7 @@ postgresGetForeignPlan(PlannerInfo *root,
 	{
 		/* Relation is UPDATE/DELETE target, so use FOR UPDATE */
 		appendStringInfoString(&sql, " FOR UPDATE");
+		early_start = false;
 	}
 	else
 	{
@@ -843,6 +874,12 @@ postgresGetForeignPlan(PlannerInfo *root,
 					appendStringInfoString(&sql, " FOR UPDATE");
 					break;
 			}
+
+			/*
+			 * Don't lock remote rows before we know that the scan will be
+			 * run at all.
+			 */
+			early_start = false;
 		}
 	}
 
@@ -850,8 +887,10 @@ postgresGetForeignPlan(PlannerInfo *root,
 	 * Build the fdw_private list that will be available to the executor.
 	 * Items in the list must match enum FdwScanPrivateIndex, above.
 	 */
-	fdw_private = list_make2(makeString(sql.data),
-							 retrieved_attrs);
+	fdw_private = list_make4(makeString(sql.data),
+							 retrieved_attrs,
+							 makeInteger(fpinfo->fetch_size),
+							 makeInteger(early_start));
 
 	/*
 	 * Create the ForeignScan node from target list, local filtering
@@ -927,6 +966,9 @@ postgresBeginForeignScan(ForeignScanState *node, int eflags)
 									 FdwScanPrivateSelectSql));
 	fsstate->retrieved_attrs = (List *) list_nth(fsplan->fdw_private,
 											   FdwScanPrivateRetrievedAttrs);
+	fsstate->fetch_size = intVal(list_nth(fsplan->fdw_private,
+										  FdwScanPrivateFetchSize));
+	fsstate->async_pending = false;
 
 	/* Create contexts for batches of tuples and per-tuple temp workspace. */
 	fsstate->batch_cxt = AllocSetContextCreate(estate->es_query_cxt,
@@ -979,6 +1021,18 @@ postgresBeginForeignScan(ForeignScanState *node, int eflags)
 		fsstate->param_values = (const char **) palloc0(numParams * sizeof(char *));
 	else
 		fsstate->param_values = NULL;
+
+	/*
+	 * If the query needs no parameters, send it to the remote server right
+	 * away, without waiting for the first row to be requested.  That way
+	 * scans of several foreign servers, say the children of an Append, run
+	 * concurrently rather than one after another.  We can only do this if
+	 * nobody else is already using the connection asynchronously.
+	 */
+	if (numParams == 0 &&
+		intVal(list_nth(fsplan->fdw_private, FdwScanPrivateEarlyStart)) &&
+		!pgfdw_has_pending(fsstate->conn))
+		start_cursor_async(fsstate);
 }
 
 /*
@@ -1042,8 +1096,12 @@ postgresReScanForeignScan(ForeignScanState *node)
 	 * If any internal parameters affecting this node have changed, we'd
 	 * better destroy and recreate the cursor.	Otherwise, rewinding it should
 	 * be good enough.	If we've only fetched zero or one batch, we needn't
-	 * even rewind the cursor, just rescan what we have.
+	 * even rewind the cursor, just rescan what we have.  (A FETCH still in
+	 * flight counts as fetched, so in that case we keep it.)
 	 */
+	if (node->ss.ps.chgParam != NULL || fsstate->fetch_ct_2 > 1)
+		discard_pending_fetch(fsstate);
+
 	if (node->ss.ps.chgParam != NULL)
 	{
 		fsstate->cursor_exists = false;
@@ -1066,6 +1124,7 @@ postgresReScanForeignScan(ForeignScanState *node)
 	 * We don't use a PG_TRY block here, so be careful not to throw error
 	 * without releasing the PGresult.
 	 */
+	pgfdw_drain_pending(fsstate->conn);
 	res = PQexec(fsstate->conn, sql);
 	if (PQresultStatus(res) != PGRES_COMMAND_OK)
 		pgfdw_report_error(ERROR, res, fsstate->conn, true, sql);
@@ -1092,7 +1151,8 @@ postgresEndForeignScan(ForeignScanState *node)
 	if (fsstate == NULL)
 		return;
 
-	/* Close the cursor if open, to prevent accumulation of cursors */
+	/* Collect any FETCH still in flight, then close the cursor if open */
+	discard_pending_fetch(fsstate);
 	if (fsstate->cursor_exists)
 		close_cursor(fsstate->conn, fsstate->cursor_number);
 
@@ -1362,6 +1422,42 @@ postgresBeginForeignModify(ModifyTableState *mtstate,
 
 	Assert(fmstate->p_nums <= n_params);
 
+	/*
+	 * An INSERT whose result we don't need to look at can be sent in
+	 * batches of several rows.  AFTER ROW triggers force a RETURNING clause,
+	 * so they exclude batching too; AFTER STATEMENT triggers would fire
+	 * before we flush the last batch, so we don't batch with those either.
+	 */
+	fmstate->batch_size = 1;
+	if (operation == CMD_INSERT &&
+		!fmstate->has_returning &&
+		fmstate->p_nums > 0 &&
+		!(rel->trigdesc && rel->trigdesc->trig_insert_after_statement))
+	{
+		fmstate->batch_size = Min(get_batch_size_option(rel),
+								  PGFDW_MAX_PARAMS / fmstate->p_nums);
+		fmstate->batch_size = Max(fmstate->batch_size, 1);
+	}
+
+	if (fmstate->batch_size > 1)
+	{
+		StringInfoData sql;
+
+		fmstate->batch_cxt = AllocSetContextCreate(estate->es_query_cxt,
+												   "postgres_fdw batch data",
+												   ALLOCSET_DEFAULT_MINSIZE,
+												   ALLOCSET_DEFAULT_INITSIZE,
+												   ALLOCSET_DEFAULT_MAXSIZE);
+		fmstate->batch_values = (const char **)
+			palloc0(fmstate->batch_size * fmstate->p_nums * sizeof(char *));
+		fmstate->num_batched = 0;
+
+		initStringInfo(&sql);
+		deparseBatchInsertSql(&sql, fmstate->query, fmstate->p_nums,
+							  fmstate->batch_size);
+		fmstate->batch_query = sql.data;
+	}
+
 	resultRelInfo->ri_FdwState = fmstate;
 }
 
@@ -1380,6 +1476,33 @@ postgresExecForeignInsert(EState *estate,
 	PGresult   *res;
 	int			n_rows;
 
+	/*
+	 * If batching, just queue the row's parameter values, and send the
+	 * batch once it's full.  We have to report the row as inserted without
+	 * knowing, but any remote failure will still abort the statement.
+	 */
+	if (fmstate->batch_size > 1)
+	{
+		MemoryContext oldcontext;
+		const char **dest;
+		int			i;
+
+		p_values = convert_prep_stmt_params(fmstate, NULL, slot);
+
+		oldcontext = MemoryContextSwitchTo(fmstate->batch_cxt);
+		dest = fmstate->batch_values + fmstate->num_batched * fmstate->p_nums;
+		for (i = 0; i < fmstate->p_nums; i++)
+			dest[i] = p_values[i] ? pstrdup(p_values[i]) : NULL;
+		MemoryContextSwitchTo(oldcontext);
+
+		if (++fmstate->num_batched >= fmstate->batch_size)
+			flush_batch_insert(fmstate);
+
+		MemoryContextReset(fmstate->temp_cxt);
+
+		return slot;
+	}
+
 	/* Set up the prepared statement on the remote server, if we didn't yet */
 	if (!fmstate->p_name)
 		prepare_foreign_modify(fmstate);
@@ -1393,6 +1516,7 @@ postgresExecForeignInsert(EState *estate,
 	 * We don't use a PG_TRY block here, so be careful not to throw error
 	 * without releasing the PGresult.
 	 */
+	pgfdw_drain_pending(fmstate->conn);
 	res = PQexecPrepared(fmstate->conn,
 						 fmstate->p_name,
 						 fmstate->p_nums,
@@ -1463,6 +1587,7 @@ postgresExecForeignUpdate(EState *estate,
 	 * We don't use a PG_TRY block here, so be careful not to throw error
 	 * without releasing the PGresult.
 	 */
+	pgfdw_drain_pending(fmstate->conn);
 	res = PQexecPrepared(fmstate->conn,
 						 fmstate->p_name,
 						 fmstate->p_nums,
@@ -1533,6 +1658,7 @@ postgresExecForeignDelete(EState *estate,
 	 * We don't use a PG_TRY block here, so be careful not to throw error
 	 * without releasing the PGresult.
 	 */
+	pgfdw_drain_pending(fmstate->conn);
 	res = PQexecPrepared(fmstate->conn,
 						 fmstate->p_name,
 						 fmstate->p_nums,
@@ -1577,6 +1703,10 @@ postgresEndForeignModify(EState *estate,
 	if (fmstate == NULL)
 		return;
 
+	/* Send any rows still queued for a batched INSERT */
+	if (fmstate->num_batched > 0)
+		flush_batch_insert(fmstate);
+
 	/* If we created a prepared statement, destroy it */
 	if (fmstate->p_name)
 	{
@@ -1589,6 +1719,7 @@ postgresEndForeignModify(EState *estate,
 		 * We don't use a PG_TRY block here, so be careful not to throw error
 		 * without releasing the PGresult.
 		 */
+		pgfdw_drain_pending(fmstate->conn);
 		res = PQexec(fmstate->conn, sql);
 		if (PQresultStatus(res) != PGRES_COMMAND_OK)
 			pgfdw_report_error(ERROR, res, fmstate->conn, true, sql);
@@ -1847,6 +1978,7 @@ get_remote_estimate(const char *sql, PGconn *conn,
 		/*
 		 * Execute EXPLAIN remotely.
 		 */
+		pgfdw_drain_pending(conn);
 		res = PQexec(conn, sql);
 		if (PQresultStatus(res) != PGRES_TUPLES_OK)
 			pgfdw_report_error(ERROR, res, conn, false, sql);
@@ -1980,6 +2112,7 @@ create_cursor(ForeignScanState *node)
 	 * We don't use a PG_TRY block here, so be careful not to throw error
 	 * without releasing the PGresult.
 	 */
+	pgfdw_drain_pending(conn);
 	res = PQexecParams(conn, buf.data, numParams, NULL, values,
 					   NULL, NULL, 0);
 	if (PQresultStatus(res) != PGRES_COMMAND_OK)
@@ -1998,8 +2131,47 @@ create_cursor(ForeignScanState *node)
 	pfree(buf.data);
 }
 
+/*
+ * Send the DECLARE CURSOR command for a scan without parameters, together
+ * with the first FETCH, without waiting for the result.  fetch_more_data
+ * will collect the result when the first rows are needed.
+ */
+static void
+start_cursor_async(PgFdwScanState *fsstate)
+{
+	PGconn	   *conn = fsstate->conn;
+	StringInfoData buf;
+
+	Assert(fsstate->numParams == 0);
+
+	initStringInfo(&buf);
+	appendStringInfo(&buf, "DECLARE c%u CURSOR FOR\n%s;\nFETCH %d FROM c%u",
+					 fsstate->cursor_number, fsstate->query,
+					 fsstate->fetch_size, fsstate->cursor_number);
+
+	if (!PQsendQuery(conn, buf.data))
+		pgfdw_report_error(ERROR, NULL, conn, false, fsstate->query);
+	pgfdw_set_pending(conn, fsstate);
+	fsstate->async_pending = true;
+
+	/* Mark the cursor as created, with one fetch issued */
+	fsstate->cursor_exists = true;
+	fsstate->tuples = NULL;
+	fsstate->num_tuples = 0;
+	fsstate->next_tuple = 0;
+	fsstate->fetch_ct_2 = 1;
+	fsstate->eof_reached = false;
+
+	pfree(buf.data);
+}
+
 /*
  * Fetch some more rows from the node's cursor.
+ *
+ * If a FETCH for this scan is already in flight, we just collect its result.
+ * Otherwise we issue one and wait for it.  Either way, unless we've reached
+ * EOF, we then send the next FETCH before returning, so that the remote
+ * server can produce the next batch while we process this one.
  */
 static void
 fetch_more_data(ForeignScanState *node)
@@ -2021,17 +2193,30 @@ fetch_more_data(ForeignScanState *node)
 	{
 		PGconn	   *conn = fsstate->conn;
 		char		sql[64];
-		int			fetch_size;
 		int			numrows;
 		int			i;
 
-		/* The fetch size is arbitrary, but shouldn't be enormous. */
-		fetch_size = 100;
+		if (fsstate->async_pending)
+		{
+			PGresult   *pending_res = NULL;
+
+			fsstate->async_pending = false;
+			if (!pgfdw_get_pending_result(conn, fsstate, &pending_res))
+				elog(ERROR, "lost track of FETCH in flight on cursor c%u",
+					 fsstate->cursor_number);
+			res = pending_res;
+		}
+		else
+		{
+			snprintf(sql, sizeof(sql), "FETCH %d FROM c%u",
+					 fsstate->fetch_size, fsstate->cursor_number);
 
-		snprintf(sql, sizeof(sql), "FETCH %d FROM c%u",
-				 fetch_size, fsstate->cursor_number);
+			pgfdw_drain_pending(conn);
+			res = PQexec(conn, sql);
 
-		res = PQexec(conn, sql);
+			if (fsstate->fetch_ct_2 < 2)
+				fsstate->fetch_ct_2++;
+		}
 		/* On error, report the original query, not the FETCH. */
 		if (PQresultStatus(res) != PGRES_TUPLES_OK)
 			pgfdw_report_error(ERROR, res, conn, false, fsstate->query);
@@ -2052,15 +2237,15 @@ fetch_more_data(ForeignScanState *node)
 										   fsstate->temp_cxt);
 		}
 
-		/* Update fetch_ct_2 */
-		if (fsstate->fetch_ct_2 < 2)
-			fsstate->fetch_ct_2++;
-
 		/* Must be EOF if we didn't get as many tuples as we asked for. */
-		fsstate->eof_reached = (numrows < fetch_size);
+		fsstate->eof_reached = (numrows < fsstate->fetch_size);
 
 		PQclear(res);
 		res = NULL;
+
+		/* Get the remote server started on the next batch. */
+		if (!fsstate->eof_reached)
+			fetch_ahead(fsstate);
 	}
 	PG_CATCH();
 	{
@@ -2073,6 +2258,55 @@ fetch_more_data(ForeignScanState *node)
 	MemoryContextSwitchTo(oldcontext);
 }
 
+/*
+ * Send a FETCH for the node's next batch without waiting for the result,
+ * unless the connection is already busy with some other async request.
+ */
+static void
+fetch_ahead(PgFdwScanState *fsstate)
+{
+	PGconn	   *conn = fsstate->conn;
+	char		sql[64];
+
+	Assert(!fsstate->async_pending);
+
+	if (pgfdw_has_pending(conn))
+		return;
+
+	snprintf(sql, sizeof(sql), "FETCH %d FROM c%u",
+			 fsstate->fetch_size, fsstate->cursor_number);
+
+	if (!PQsendQuery(conn, sql))
+		pgfdw_report_error(ERROR, NULL, conn, false, fsstate->query);
+	pgfdw_set_pending(conn, fsstate);
+	fsstate->async_pending = true;
+
+	if (fsstate->fetch_ct_2 < 2)
+		fsstate->fetch_ct_2++;
+}
+
+/*
+ * Collect and throw away the result of the node's FETCH in flight, if any.
+ * We still report an error, since the remote transaction is unusable after
+ * one anyway.
+ */
+static void
+discard_pending_fetch(PgFdwScanState *fsstate)
+{
+	PGresult   *res = NULL;
+
+	if (!fsstate->async_pending)
+		return;
+
+	fsstate->async_pending = false;
+	if (!pgfdw_get_pending_result(fsstate->conn, fsstate, &res))
+		return;
+
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+		pgfdw_report_error(ERROR, res, fsstate->conn, true, fsstate->query);
+	PQclear(res);
+}
+
 /*
  * Force assorted GUC parameters to settings that ensure that we'll output
  * data values in a form that is unambiguous to the remote server.
@@ -2138,6 +2372,7 @@ close_cursor(PGconn *conn, unsigned int cursor_number)
 	 * We don't use a PG_TRY block here, so be careful not to throw error
 	 * without releasing the PGresult.
 	 */
+	pgfdw_drain_pending(conn);
 	res = PQexec(conn, sql);
 	if (PQresultStatus(res) != PGRES_COMMAND_OK)
 		pgfdw_report_error(ERROR, res, conn, true, sql);
@@ -2170,6 +2405,7 @@ prepare_foreign_modify(PgFdwModifyState *fmstate)
 	 * We don't use a PG_TRY block here, so be careful not to throw error
 	 * without releasing the PGresult.
 	 */
+	pgfdw_drain_pending(fmstate->conn);
 	res = PQprepare(fmstate->conn,
 					p_name,
 					fmstate->query,
@@ -2184,6 +2420,103 @@ prepare_foreign_modify(PgFdwModifyState *fmstate)
 	fmstate->p_name = p_name;
 }
 
+/*
+ * get_batch_size_option
+ *		Get the batch_size option for a foreign table; a per-table setting
+ *		overrides the per-server one
+ */
+static int
+get_batch_size_option(Relation rel)
+{
+	ForeignTable *table;
+	ForeignServer *server;
+	int			batch_size = 1;
+	ListCell   *lc;
+
+	table = GetForeignTable(RelationGetRelid(rel));
+	server = GetForeignServer(table->serverid);
+
+	foreach(lc, server->options)
+	{
+		DefElem    *def = (DefElem *) lfirst(lc);
+
+		if (strcmp(def->defname, "batch_size") == 0)
+			batch_size = strtol(defGetString(def), NULL, 10);
+	}
+	foreach(lc, table->options)
+	{
+		DefElem    *def = (DefElem *) lfirst(lc);
+
+		if (strcmp(def->defname, "batch_size") == 0)
+			batch_size = strtol(defGetString(def), NULL, 10);
+	}
+
+	return batch_size;
+}
+
+/*
+ * flush_batch_insert
+ *		Send the rows queued by a batched INSERT to the remote server
+ */
+static void
+flush_batch_insert(PgFdwModifyState *fmstate)
+{
+	const char *sql;
+	char	   *partial_sql = NULL;
+	PGresult   *res;
+	int			n_rows;
+
+	Assert(fmstate->num_batched > 0);
+
+	/* A partial batch needs a statement of its own */
+	if (fmstate->num_batched == fmstate->batch_size)
+		sql = fmstate->batch_query;
+	else
+	{
+		StringInfoData buf;
+
+		initStringInfo(&buf);
+		deparseBatchInsertSql(&buf, fmstate->query, fmstate->p_nums,
+							  fmstate->num_batched);
+		sql = partial_sql = buf.data;
+	}
+
+	/*
+	 * We don't use a PG_TRY block here, so be careful not to throw error
+	 * without releasing the PGresult.
+	 */
+	pgfdw_drain_pending(fmstate->conn);
+	res = PQexecParams(fmstate->conn,
+					   sql,
+					   fmstate->num_batched * fmstate->p_nums,
+					   NULL,
+					   fmstate->batch_values,
+					   NULL,
+					   NULL,
+					   0);
+	if (PQresultStatus(res) != PGRES_COMMAND_OK)
+		pgfdw_report_error(ERROR, res, fmstate->conn, true, fmstate->query);
+
+	n_rows = atoi(PQcmdTuples(res));
+	PQclear(res);
+
+	/*
+	 * We've already reported all these rows as inserted, so it's an error
+	 * if some of them weren't, e.g. because of a remote trigger.
+	 */
+	if (n_rows != fmstate->num_batched)
+		ereport(ERROR,
+				(errcode(ERRCODE_FDW_ERROR),
+				 errmsg("remote INSERT inserted %d rows rather than %d",
+						n_rows, fmstate->num_batched),
+				 errhint("Set the batch_size option of the foreign table to 1.")));
+
+	if (partial_sql)
+		pfree(partial_sql);
+	MemoryContextReset(fmstate->batch_cxt);
+	fmstate->num_batched = 0;
+}
+
 /*
  * convert_prep_stmt_params
  *		Create array of text strings representing parameter values
@@ -2325,6 +2658,7 @@ postgresAnalyzeForeignTable(Relation relation,
 	/* In what follows, do not risk leaking any PGresults. */
 	PG_TRY();
 	{
+		pgfdw_drain_pending(conn);
 		res = PQexec(conn, sql.data);
 		if (PQresultStatus(res) != PGRES_TUPLES_OK)
 			pgfdw_report_error(ERROR, res, conn, false, sql.data);
@@ -2419,6 +2753,7 @@ postgresAcquireSampleRowsFunc(Relation relation, int elevel,
 	/* In what follows, do not risk leaking any PGresults. */
 	PG_TRY();
 	{
+		pgfdw_drain_pending(conn);
 		res = PQexec(conn, sql.data);
 		if (PQresultStatus(res) != PGRES_COMMAND_OK)
 			pgfdw_report_error(ERROR, res, conn, false, sql.data);
@@ -2449,6 +2784,7 @@ postgresAcquireSampleRowsFunc(Relation relation, int elevel,
 			snprintf(fetch_sql, sizeof(fetch_sql), "FETCH %d FROM c%u",
 					 fetch_size, cursor_number);
 
+			pgfdw_drain_pending(conn);
 			res = PQexec(conn, fetch_sql);
 			/* On error, report the original query, not the FETCH. */
 			if (PQresultStatus(res) != PGRES_TUPLES_OK)
@@ -30,6 +30,11 @@ extern PGconn *GetConnection(ForeignServer *server, UserMapping *user,
 extern void ReleaseConnection(PGconn *conn);
 extern unsigned int GetCursorNumber(PGconn *conn);
 extern unsigned int GetPrepStmtNumber(PGconn *conn);
+extern void pgfdw_set_pending(PGconn *conn, void *owner);
+extern bool pgfdw_has_pending(PGconn *conn);
+extern void pgfdw_drain_pending(PGconn *conn);
+extern bool pgfdw_get_pending_result(PGconn *conn, void *owner,
+						 PGresult **res);
 extern void pgfdw_report_error(int elevel, PGresult *res, PGconn *conn,
 				   bool clear, const char *sql);
 
@@ -62,6 +67,8 @@ extern void deparseInsertSql(StringInfo buf, PlannerInfo *root,
 				 Index rtindex, Relation rel,
 				 List *targetAttrs, List *returningList,
 				 List **retrieved_attrs);
+extern void deparseBatchInsertSql(StringInfo buf, const char *orig_query,
+					  int nparams, int nrows);
 extern void deparseUpdateSql(StringInfo buf, PlannerInfo *root,
 				 Index rtindex, Relation rel,
 				 List *targetAttrs, List *returningList,
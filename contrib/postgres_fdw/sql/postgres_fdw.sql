@@ -91,6 +91,8 @@ ALTER SERVER testserver1 OPTIONS (
 	updatable 'true',
 	fdw_startup_cost '123.456',
 	fdw_tuple_cost '0.123',
+	fetch_size '101',
+	batch_size '10',
 	service 'value',
 	connect_timeout 'value',
 	dbname 'value',
@@ -606,3 +608,29 @@ UPDATE rem1 SET f2 = 'testo';
 
 -- Test returning a system attribute
 INSERT INTO rem1(f2) VALUES ('test') RETURNING ctid;
+
+-- ===================================================================
+-- test fetch_size and batch_size
+-- ===================================================================
+ALTER SERVER loopback OPTIONS (ADD fetch_size '0');
+ALTER FOREIGN TABLE ft1 OPTIONS (ADD batch_size '-1');
+ALTER FOREIGN TABLE ft1 OPTIONS (ADD batch_size 'x');
+create table loc2 (f1 int, f2 text);
+create foreign table rem2 (f1 int, f2 text)
+  server loopback options (table_name 'loc2', fetch_size '3', batch_size '4');
+-- 10 rows go out as batches of 4, 4 and 2
+insert into rem2 select i, 'row ' || i from generate_series(1, 10) i;
+select count(*), sum(f1) from loc2;
+-- RETURNING disables batching
+insert into rem2 values (11, 'row 11') returning *;
+delete from loc2 where f1 = 11;
+-- scans fetching several batches, sharing the connection
+select * from rem2 order by f1;
+select count(*) from (select f1 from rem2 union all select f1 from rem2) s;
+-- rescans
+begin;
+set local enable_hashjoin = off;
+set local enable_mergejoin = off;
+set local enable_material = off;
+select count(*) from (values (1), (2), (3)) a(f1), rem2 b where a.f1 + b.f1 > 0;
+commit;
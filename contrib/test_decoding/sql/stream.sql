@@ -0,0 +1,70 @@
+-- predictability
+SET synchronous_commit = on;
+-- the large transactions below use about 700kB
+SET logical_decoding_work_mem = '400kB';
+
+SELECT 'init' FROM pg_create_logical_replication_slot('regression_slot', 'test_decoding');
+
+CREATE TABLE stream_test(data text);
+
+-- consume DDL
+SELECT data FROM pg_logical_slot_get_changes('regression_slot', NULL, NULL, 'include-xids', '0');
+
+-- large transaction, streamed in two blocks before its commit
+INSERT INTO stream_test SELECT 'row ' || g.i FROM generate_series(1, 5000) g(i);
+SELECT data FROM pg_logical_slot_peek_changes('regression_slot', NULL, NULL, 'include-xids', '0', 'stream-changes', '1')
+WHERE data NOT LIKE 'table public.stream_test:%';
+-- all changes get sent
+SELECT count(*) FROM pg_logical_slot_get_changes('regression_slot', NULL, NULL, 'include-xids', '0', 'stream-changes', '1')
+WHERE data LIKE 'table public.stream_test: INSERT:%';
+
+-- large subtransaction rolled back after being streamed
+BEGIN;
+INSERT INTO stream_test VALUES ('before savepoint');
+SAVEPOINT s1;
+INSERT INTO stream_test SELECT 'aborted ' || g.i FROM generate_series(1, 5000) g(i);
+ROLLBACK TO SAVEPOINT s1;
+INSERT INTO stream_test VALUES ('after savepoint');
+COMMIT;
+SELECT data FROM pg_logical_slot_get_changes('regression_slot', NULL, NULL, 'include-xids', '0', 'stream-changes', '1')
+WHERE data NOT LIKE 'table public.stream_test: INSERT: data[text]:''aborted %';
+
+-- large transaction rolled back after being streamed
+BEGIN;
+INSERT INTO stream_test SELECT 'aborted ' || g.i FROM generate_series(1, 5000) g(i);
+ROLLBACK;
+SELECT data FROM pg_logical_slot_get_changes('regression_slot', NULL, NULL, 'include-xids', '0', 'stream-changes', '1')
+WHERE data NOT LIKE 'table public.stream_test:%';
+
+-- transactions modifying the catalog are only decoded at commit
+BEGIN;
+CREATE TABLE stream_test_ddl(data text);
+INSERT INTO stream_test SELECT 'row ' || g.i FROM generate_series(1, 5000) g(i);
+COMMIT;
+SELECT data FROM pg_logical_slot_get_changes('regression_slot', NULL, NULL, 'include-xids', '0', 'stream-changes', '1')
+WHERE data NOT LIKE 'table public.stream_test:%';
+
+-- without the option, large transactions are only decoded at commit
+INSERT INTO stream_test SELECT 'row ' || g.i FROM generate_series(1, 5000) g(i);
+SELECT data FROM pg_logical_slot_get_changes('regression_slot', NULL, NULL, 'include-xids', '0')
+WHERE data NOT LIKE 'table public.stream_test:%';
+
+-- a WAL switch has no room for a pending toplevel xid, the next record has it
+BEGIN;
+CREATE TEMP TABLE stream_temp(data text) ON COMMIT DROP;
+SAVEPOINT s1;
+INSERT INTO stream_temp VALUES ('not logged');
+SELECT 'switched' FROM pg_switch_xlog();
+INSERT INTO stream_test VALUES ('after switch');
+COMMIT;
+SELECT data FROM pg_logical_slot_get_changes('regression_slot', NULL, NULL, 'include-xids', '0', 'stream-changes', '1');
+
+DROP TABLE stream_test, stream_test_ddl;
+SELECT data FROM pg_logical_slot_get_changes('regression_slot', NULL, NULL, 'include-xids', '0');
+
+-- both spilling and streaming got reported to the slot
+SELECT spill_txns > 0 AND spill_count >= spill_txns AND spill_bytes > 0 AS spilled,
+    stream_txns > 0 AND stream_count >= stream_txns AND stream_bytes > 0 AS streamed
+FROM pg_replication_slots WHERE slot_name = 'regression_slot';
+
+SELECT 'init' FROM pg_drop_replication_slot('regression_slot');
@@ -0,0 +1,511 @@
+/*-------------------------------------------------------------------------
+ *
+ * tidstore.c
+ *	  compact storage for a set of TIDs, organized by block
+ *
+ * A TID store holds a set of TIDs for fast membership tests; VACUUM uses it
+ * to remember dead heap tuples while it removes their index entries.  TIDs
+ * are added a block at a time, in increasing block order.  Each block gets
+ * a small fixed-size entry, and its offsets are kept either as a sorted
+ * array of OffsetNumbers or as a bitmap, whichever is smaller.  A block
+ * with many dead tuples thus costs little more than a bit per line pointer,
+ * where a flat array of ItemPointerData costs six bytes per TID.
+ *
+ * All of a store's data lives in one contiguous area, laid out much like a
+ * heap page: the block entries grow forward from the start of the area and
+ * the offset arrays and bitmaps grow backward from its end.  The area holds
+ * no pointers, so it can be placed in dynamic shared memory and used by
+ * several backends, each through its own TidStore handle.  Only one backend
+ * may add TIDs, and nobody may look anything up while it does.
+ *
+ * To find a block's entry, a lookup consults a directory that maps ranges
+ * of block numbers to the entries falling in them.  The directory is built
+ * in backend-local memory on the first lookup after the store has changed,
+ * and is sized to have about as many ranges as there are entries, so a
+ * lookup normally costs one directory probe, a comparison or two within the
+ * range, and a bit test.  The directory takes four bytes per entry, which
+ * is not counted against the area size.
+ *
+ *
+ * Portions Copyright (c) 1996-2014, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/access/common/tidstore.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "access/tidstore.h"
+#include "storage/shmem.h"
+#include "utils/memutils.h"
+
+
+/* TidStoreEntry.info holds the payload length, plus this flag */
+#define TIDSTORE_BITMAP			0x8000
+#define TIDSTORE_LEN_MASK		0x7FFF
+
+typedef struct TidStoreEntry
+{
+	BlockNumber blkno;
+	uint32		payload;		/* offset of the block's data in the area */
+	uint16		ntids;			/* number of TIDs in this block */
+	uint16		info;			/* payload length and TIDSTORE_BITMAP */
+} TidStoreEntry;
+
+/*
+ * The control data at the start of the area.
+ */
+typedef struct TidStoreControl
+{
+	Size		area_size;		/* total size of the area */
+	OffsetNumber max_offset;	/* largest offset we may be asked to store */
+	uint32		num_entries;	/* number of blocks stored */
+	uint32		payload_start;	/* offset of the lowest payload byte */
+	int64		num_tids;		/* number of TIDs stored */
+	uint64		generation;		/* advanced whenever the contents change */
+	TidStoreEntry entries[FLEXIBLE_ARRAY_MEMBER];
+} TidStoreControl;
+
+#define SizeOfTidStoreControl	offsetof(TidStoreControl, entries)
+
+/*
+ * Backend-local handle.  The lookup directory is valid only while
+ * dir_generation matches the control data's generation.
+ */
+struct TidStore
+{
+	TidStoreControl *control;
+	bool		owns_area;		/* area allocated by tidstore_create? */
+	MemoryContext cxt;			/* context for the directory */
+
+	uint64		dir_generation;
+	BlockNumber dir_base;		/* first block covered by the directory */
+	int			dir_shift;		/* log2 of blocks per directory slot */
+	uint32		dir_nslots;
+	uint32		dir_allocated;	/* allocated length of dir[] */
+	uint32	   *dir;			/* first entry of each slot, plus a sentinel */
+};
+
+static void tidstore_build_directory(TidStore *ts);
+static bool tidstore_entry_contains(TidStoreControl *control,
+						TidStoreEntry *entry, OffsetNumber off);
+
+
+/*
+ * Worst-case space one block can take in a store whose offsets don't
+ * exceed max_offset.
+ */
+Size
+tidstore_block_space(OffsetNumber max_offset)
+{
+	/* we never choose an offset array bigger than the bitmap */
+	return sizeof(TidStoreEntry) + SHORTALIGN(max_offset / BITS_PER_BYTE + 1);
+}
+
+/*
+ * Area size needed to be sure of holding nblocks blocks.
+ */
+Size
+tidstore_space_for_blocks(BlockNumber nblocks, OffsetNumber max_offset)
+{
+	Size		size;
+
+	size = add_size(SizeOfTidStoreControl,
+					mul_size(nblocks, tidstore_block_space(max_offset)));
+	return MAXALIGN(size);
+}
+
+/*
+ * Create an empty TID store in a newly allocated area of area_size bytes,
+ * which may exceed MaxAllocSize.
+ */
+TidStore *
+tidstore_create(Size area_size, OffsetNumber max_offset)
+{
+	void	   *area;
+	TidStore   *ts;
+
+	area = MemoryContextAllocHuge(CurrentMemoryContext, area_size);
+	ts = tidstore_initialize(area, area_size, max_offset);
+	ts->owns_area = true;
+
+	return ts;
+}
+
+/*
+ * Create an empty TID store in caller-supplied memory, such as a dynamic
+ * shared memory segment, and return a handle for it.
+ *
+ * The payloads are laid out backward from the end of the area, so we only
+ * use a MAXALIGN'd prefix of it to keep them aligned; area must be MAXALIGN'd
+ * itself.
+ */
+TidStore *
+tidstore_initialize(void *area, Size area_size, OffsetNumber max_offset)
+{
+	TidStoreControl *control = (TidStoreControl *) area;
+
+	area_size = MAXALIGN_DOWN(area_size);
+
+	Assert(max_offset >= FirstOffsetNumber && max_offset <= MaxOffsetNumber);
+	Assert(area_size >= tidstore_space_for_blocks(1, max_offset));
+	Assert(area_size <= TIDSTORE_MAX_SIZE);
+
+	control->area_size = area_size;
+	control->max_offset = max_offset;
+	control->num_entries = 0;
+	control->payload_start = (uint32) area_size;
+	control->num_tids = 0;
+	control->generation = 1;
+
+	return tidstore_attach(area);
+}
+
+/*
+ * Return a new handle for a TID store initialized by tidstore_initialize,
+ * possibly in another backend.
+ */
+TidStore *
+tidstore_attach(void *area)
+{
+	TidStore   *ts;
+
+	ts = (TidStore *) palloc0(sizeof(TidStore));
+	ts->control = (TidStoreControl *) area;
+	ts->owns_area = false;
+	ts->cxt = CurrentMemoryContext;
+	ts->dir_generation = 0;		/* no directory yet */
+
+	return ts;
+}
+
+/*
+ * Release a handle, and the area too if tidstore_create allocated it.
+ */
+void
+tidstore_free(TidStore *ts)
+{
+	if (ts->dir)
+		pfree(ts->dir);
+	if (ts->owns_area)
+		pfree(ts->control);
+	pfree(ts);
+}
+
+/*
+ * Forget all the TIDs in the store.
+ */
+void
+tidstore_reset(TidStore *ts)
+{
+	TidStoreControl *control = ts->control;
+
+	control->num_entries = 0;
+	control->payload_start = (uint32) control->area_size;
+	control->num_tids = 0;
+	control->generation++;
+}
+
+/*
+ * Is the store too full to be sure of holding one more block?
+ */
+bool
+tidstore_is_full(TidStore *ts)
+{
+	TidStoreControl *control = ts->control;
+	Size		used;
+
+	used = SizeOfTidStoreControl +
+		(Size) control->num_entries * sizeof(TidStoreEntry);
+
+	return control->payload_start - used <
+		tidstore_block_space(control->max_offset);
+}
+
+/*
+ * Add the given offsets of block blkno to the store.
+ *
+ * offsets must be in increasing order, and blkno must be higher than any
+ * block already in the store.  The caller must have checked that the store
+ * isn't full.
+ */
+void
+tidstore_set_block_offsets(TidStore *ts, BlockNumber blkno,
+						   OffsetNumber *offsets, int num_offsets)
+{
+	TidStoreControl *control = ts->control;
+	TidStoreEntry *entry;
+	OffsetNumber maxoff;
+	Size		bitmap_len;
+	Size		list_len;
+	Size		len;
+	bool		use_bitmap;
+	uint8	   *payload;
+	int			i;
+
+	Assert(num_offsets > 0);
+#ifdef USE_ASSERT_CHECKING
+	for (i = 1; i < num_offsets; i++)
+		Assert(offsets[i - 1] < offsets[i]);
+#endif
+
+	if (control->num_entries > 0 &&
+		control->entries[control->num_entries - 1].blkno >= blkno)
+		elog(ERROR, "TIDs must be added to a TID store in block order");
+
+	maxoff = offsets[num_offsets - 1];
+	if (offsets[0] < FirstOffsetNumber || maxoff > control->max_offset)
+		elog(ERROR, "offset number %u out of range for TID store", maxoff);
+
+	bitmap_len = maxoff / BITS_PER_BYTE + 1;
+	list_len = num_offsets * sizeof(OffsetNumber);
+	use_bitmap = (bitmap_len < list_len);
+	len = use_bitmap ? bitmap_len : list_len;
+
+	if (tidstore_is_full(ts))
+		elog(ERROR, "out of space in TID store");
+
+	control->payload_start -= SHORTALIGN(len);
+	payload = (uint8 *) control + control->payload_start;
+
+	if (use_bitmap)
+	{
+		memset(payload, 0, len);
+		for (i = 0; i < num_offsets; i++)
+			payload[offsets[i] / BITS_PER_BYTE] |=
+				1 << (offsets[i] % BITS_PER_BYTE);
+	}
+	else
+		memcpy(payload, offsets, len);
+
+	entry = &control->entries[control->num_entries];
+	entry->blkno = blkno;
+	entry->payload = control->payload_start;
+	entry->ntids = (uint16) num_offsets;
+	entry->info = (uint16) len | (use_bitmap ? TIDSTORE_BITMAP : 0);
+
+	control->num_entries++;
+	control->num_tids += num_offsets;
+	control->generation++;
+}
+
+/*
+ * Is the given TID in the store?
+ */
+bool
+tidstore_is_member(TidStore *ts, ItemPointer tid)
+{
+	TidStoreControl *control = ts->control;
+	BlockNumber blkno = ItemPointerGetBlockNumber(tid);
+	uint32		slot;
+	uint32		lo,
+				hi,
+				end;
+
+	if (control->num_entries == 0)
+		return false;
+
+	if (ts->dir_generation != control->generation)
+		tidstore_build_directory(ts);
+
+	if (blkno < ts->dir_base)
+		return false;
+	slot = (blkno - ts->dir_base) >> ts->dir_shift;
+	if (slot >= ts->dir_nslots)
+		return false;
+
+	/* binary search for the block among the entries of its slot */
+	lo = ts->dir[slot];
+	end = hi = ts->dir[slot + 1];
+	while (lo < hi)
+	{
+		uint32		mid = lo + (hi - lo) / 2;
+
+		if (control->entries[mid].blkno < blkno)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	if (lo >= end || control->entries[lo].blkno != blkno)
+		return false;
+
+	return tidstore_entry_contains(control, &control->entries[lo],
+								   ItemPointerGetOffsetNumber(tid));
+}
+
+int64
+tidstore_num_tids(TidStore *ts)
+{
+	return ts->control->num_tids;
+}
+
+BlockNumber
+tidstore_num_blocks(TidStore *ts)
+{
+	return ts->control->num_entries;
+}
+
+/*
+ * Number of bytes of the area currently in use.
+ */
+Size
+tidstore_memory_usage(TidStore *ts)
+{
+	TidStoreControl *control = ts->control;
+
+	return SizeOfTidStoreControl +
+		(Size) control->num_entries * sizeof(TidStoreEntry) +
+		(control->area_size - control->payload_start);
+}
+
+/*
+ * Prepare to iterate over the blocks of the store, in block order.
+ */
+void
+tidstore_begin_iterate(TidStore *ts, TidStoreIter *iter)
+{
+	iter->ts = ts;
+	iter->next_entry = 0;
+	iter->blkno = InvalidBlockNumber;
+	iter->num_offsets = 0;
+}
+
+/*
+ * Advance to the next block; returns false when there are no more.
+ */
+bool
+tidstore_iterate_next(TidStoreIter *iter)
+{
+	TidStoreControl *control = iter->ts->control;
+	TidStoreEntry *entry;
+	uint8	   *payload;
+	Size		len;
+
+	if (iter->next_entry >= control->num_entries)
+		return false;
+
+	entry = &control->entries[iter->next_entry++];
+	payload = (uint8 *) control + entry->payload;
+	len = entry->info & TIDSTORE_LEN_MASK;
+
+	iter->blkno = entry->blkno;
+	if (entry->info & TIDSTORE_BITMAP)
+	{
+		OffsetNumber off;
+
+		iter->num_offsets = 0;
+		for (off = FirstOffsetNumber; off < len * BITS_PER_BYTE; off++)
+		{
+			if (payload[off / BITS_PER_BYTE] & (1 << (off % BITS_PER_BYTE)))
+				iter->offsets[iter->num_offsets++] = off;
+		}
+	}
+	else
+	{
+		iter->num_offsets = entry->ntids;
+		memcpy(iter->offsets, payload, len);
+	}
+	Assert(iter->num_offsets == entry->ntids);
+
+	return true;
+}
+
+/*
+ * Build the lookup directory for the store's current contents.
+ *
+ * The block range spanned by the store is divided into dir_nslots slots of
+ * 2^dir_shift blocks each, choosing the smallest shift that yields no more
+ * slots than entries.  dir[i] is the index of the first entry whose block
+ * is in slot i or later, so the entries of slot i are dir[i] .. dir[i+1]-1.
+ */
+static void
+tidstore_build_directory(TidStore *ts)
+{
+	TidStoreControl *control = ts->control;
+	uint32		nentries = control->num_entries;
+	BlockNumber first;
+	BlockNumber last;
+	int			shift;
+	uint32		nslots;
+	uint32		slot;
+	uint32		i;
+
+	Assert(nentries > 0);
+
+	first = control->entries[0].blkno;
+	last = control->entries[nentries - 1].blkno;
+
+	shift = 0;
+	while (((last - first) >> shift) + 1 > nentries)
+		shift++;
+	nslots = ((last - first) >> shift) + 1;
+
+	if (ts->dir == NULL)
+	{
+		ts->dir = (uint32 *) MemoryContextAlloc(ts->cxt,
+											  (nslots + 1) * sizeof(uint32));
+		ts->dir_allocated = nslots + 1;
+	}
+	else if (ts->dir_allocated < nslots + 1)
+	{
+		ts->dir = (uint32 *) repalloc(ts->dir, (nslots + 1) * sizeof(uint32));
+		ts->dir_allocated = nslots + 1;
+	}
+
+	i = 0;
+	for (slot = 0; slot < nslots; slot++)
+	{
+		uint64		slot_start = (uint64) first + ((uint64) slot << shift);
+
+		while (i < nentries && control->entries[i].blkno < slot_start)
+			i++;
+		ts->dir[slot] = i;
+	}
+	ts->dir[nslots] = nentries;
+
+	ts->dir_base = first;
+	ts->dir_shift = shift;
+	ts->dir_nslots = nslots;
+	ts->dir_generation = control->generation;
+}
+
+/*
+ * Does the given block entry contain offset off?
+ */
+static bool
+tidstore_entry_contains(TidStoreControl *control, TidStoreEntry *entry,
+						OffsetNumber off)
+{
+	uint8	   *payload = (uint8 *) control + entry->payload;
+	Size		len = entry->info & TIDSTORE_LEN_MASK;
+
+	if (entry->info & TIDSTORE_BITMAP)
+	{
+		if (off / BITS_PER_BYTE >= len)
+			return false;
+		return (payload[off / BITS_PER_BYTE] & (1 << (off % BITS_PER_BYTE))) != 0;
+	}
+	else
+	{
+		OffsetNumber *offsets = (OffsetNumber *) payload;
+		int			lo = 0,
+					hi = entry->ntids;
+
+		while (lo < hi)
+		{
+			int			mid = lo + (hi - lo) / 2;
+
+			if (offsets[mid] < off)
+				lo = mid + 1;
+			else if (offsets[mid] > off)
+				hi = mid;
+			else
+				return true;
+		}
+		return false;
+	}
+}
@@ -0,0 +1,324 @@
+/*-------------------------------------------------------------------------
+ *
+ * nbtdedup.c
+ *	  Deduplication of btree leaf tuples into posting list tuples.
+ *
+ * Portions Copyright (c) 1996-2014, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/access/nbtree/nbtdedup.c
+ *
+ *	NOTES
+ *	   When a leaf page of a non-unique index is about to be split, we first
+ *	   try to make room on it by merging each group of tuples having the same
+ *	   key into a single posting list tuple (see nbtree.h for the format).
+ *	   Only tuples whose key parts are binary-identical are merged.  That is
+ *	   stricter than opclass equality (numeric 1.0 and 1.00 are equal but
+ *	   must both be kept for index-only scans), and it needs no support
+ *	   function calls.
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "access/heapam_xlog.h"
+#include "access/nbtree.h"
+#include "miscadmin.h"
+#include "utils/rel.h"
+
+static bool _bt_keys_binary_equal(IndexTuple a, IndexTuple b);
+static int	_bt_htid_cmp(const void *a, const void *b);
+
+
+/*
+ *	_bt_form_posting() -- build a leaf tuple with the key of 'base' and the
+ *						  given heap TIDs.
+ *
+ * The TIDs must already be sorted.  If there is just one of them, an
+ * ordinary tuple is returned.  The result is palloc'd.
+ */
+IndexTuple
+_bt_form_posting(IndexTuple base, ItemPointer htids, int nhtids)
+{
+	Size		keysize = BTreeTupleGetKeySize(base);
+	Size		newsize;
+	IndexTuple	itup;
+
+	Assert(nhtids > 0);
+
+	if (nhtids > 1)
+		newsize = MAXALIGN(MAXALIGN(keysize) +
+						   nhtids * sizeof(ItemPointerData));
+	else
+		newsize = keysize;
+
+	Assert(newsize <= INDEX_SIZE_MASK);
+	Assert(nhtids <= BT_OFFSET_MASK);
+
+	itup = (IndexTuple) palloc0(newsize);
+	memcpy(itup, base, keysize);
+	itup->t_info &= ~(INDEX_SIZE_MASK | INDEX_ALT_TID_MASK);
+	itup->t_info |= newsize;
+
+	if (nhtids > 1)
+	{
+		BTreeTupleSetPosting(itup, nhtids, MAXALIGN(keysize));
+		memcpy(BTreeTupleGetPosting(itup), htids,
+			   nhtids * sizeof(ItemPointerData));
+	}
+	else
+		itup->t_tid = htids[0];
+
+	return itup;
+}
+
+/*
+ *	_bt_pivot_tuple() -- make a copy of a leaf tuple suitable for use as a
+ *						 high key or downlink.
+ *
+ * For a posting list tuple, only the key part is copied; the result looks
+ * like an ordinary tuple pointing at the first heap TID of the list.
+ */
+IndexTuple
+_bt_pivot_tuple(IndexTuple itup)
+{
+	IndexTuple	pivot;
+	Size		keysize;
+
+	if (!BTreeTupleIsPosting(itup))
+		return CopyIndexTuple(itup);
+
+	keysize = BTreeTupleGetPostingOffset(itup);
+	pivot = (IndexTuple) palloc(keysize);
+	memcpy(pivot, itup, keysize);
+	pivot->t_info &= ~(INDEX_SIZE_MASK | INDEX_ALT_TID_MASK);
+	pivot->t_info |= keysize;
+	pivot->t_tid = *BTreeTupleGetPosting(itup);
+
+	return pivot;
+}
+
+/*
+ *	_bt_posting_contains() -- does a posting list tuple contain 'htid'?
+ */
+bool
+_bt_posting_contains(IndexTuple posting, ItemPointer htid)
+{
+	ItemPointer htids = BTreeTupleGetPosting(posting);
+	int			low = 0;
+	int			high = BTreeTupleGetNPosting(posting) - 1;
+
+	while (low <= high)
+	{
+		int			mid = low + (high - low) / 2;
+		int32		cmp = ItemPointerCompare(htid, &htids[mid]);
+
+		if (cmp == 0)
+			return true;
+		if (cmp < 0)
+			high = mid - 1;
+		else
+			low = mid + 1;
+	}
+
+	return false;
+}
+
+/*
+ *	_bt_dedup_one_page() -- merge duplicates on a leaf page.
+ *
+ * The caller must hold a write lock on the page, which must be a leaf page
+ * of a non-unique index.  Runs of adjacent tuples with binary-equal keys are
+ * replaced by posting list tuples, up to the maximum tuple size.  Tuples
+ * marked LP_DEAD are left alone, since they are about to be removed anyway.
+ *
+ * Returns true if the page was changed.  The rewritten page is WAL-logged as
+ * a full page image: the operation happens only when the page would
+ * otherwise have to be split, which is expensive to log anyway.
+ */
+bool
+_bt_dedup_one_page(Relation rel, Buffer buf)
+{
+	Page		page = BufferGetPage(buf);
+	BTPageOpaque opaque = (BTPageOpaque) PageGetSpecialPointer(page);
+	Page		newpage;
+	OffsetNumber offnum,
+				minoff,
+				maxoff,
+				newoff;
+	ItemPointer htids;
+	Size		maxpostingsize;
+	bool		found;
+
+	Assert(P_ISLEAF(opaque));
+
+	/*
+	 * Unique indexes rely on one heap TID per tuple while checking for
+	 * conflicts, and shouldn't contain many duplicates in the first place.
+	 */
+	if (rel->rd_index->indisunique)
+		return false;
+
+	minoff = P_FIRSTDATAKEY(opaque);
+	maxoff = PageGetMaxOffsetNumber(page);
+
+	/* Quickly check whether there's anything to merge at all */
+	found = false;
+	for (offnum = minoff; offnum < maxoff; offnum = OffsetNumberNext(offnum))
+	{
+		ItemId		itemid = PageGetItemId(page, offnum);
+		ItemId		nextitemid = PageGetItemId(page, OffsetNumberNext(offnum));
+
+		if (ItemIdIsDead(itemid) || ItemIdIsDead(nextitemid))
+			continue;
+		if (_bt_keys_binary_equal((IndexTuple) PageGetItem(page, itemid),
+								  (IndexTuple) PageGetItem(page, nextitemid)))
+		{
+			found = true;
+			break;
+		}
+	}
+	if (!found)
+		return false;
+
+	maxpostingsize = BTMaxItemSize(page);
+	htids = (ItemPointer) palloc(MaxTIDsPerBTreePage * sizeof(ItemPointerData));
+
+	/*
+	 * Build the new version of the page in a temporary copy, keeping the
+	 * special space and the high key as they are.
+	 */
+	newpage = PageGetTempPageCopySpecial(page);
+	newoff = P_HIKEY;
+	if (!P_RIGHTMOST(opaque))
+	{
+		ItemId		hitemid = PageGetItemId(page, P_HIKEY);
+
+		if (PageAddItem(newpage, PageGetItem(page, hitemid),
+						ItemIdGetLength(hitemid), P_HIKEY,
+						false, false) == InvalidOffsetNumber)
+			elog(ERROR, "failed to add high key to the deduplicated page in index \"%s\"",
+				 RelationGetRelationName(rel));
+		newoff = OffsetNumberNext(newoff);
+	}
+
+	offnum = minoff;
+	while (offnum <= maxoff)
+	{
+		ItemId		itemid = PageGetItemId(page, offnum);
+		IndexTuple	base = (IndexTuple) PageGetItem(page, itemid);
+		IndexTuple	newitem = base;
+		Size		newitemsz = ItemIdGetLength(itemid);
+		bool		isdead = ItemIdIsDead(itemid);
+		OffsetNumber next = OffsetNumberNext(offnum);
+
+		if (!isdead)
+		{
+			int			nhtids = 0;
+			int			nmerged = 1;
+			Size		keysize = MAXALIGN(BTreeTupleGetKeySize(base));
+
+			if (BTreeTupleIsPosting(base))
+			{
+				memcpy(htids, BTreeTupleGetPosting(base),
+					   BTreeTupleGetNPosting(base) * sizeof(ItemPointerData));
+				nhtids = BTreeTupleGetNPosting(base);
+			}
+			else
+				htids[nhtids++] = base->t_tid;
+
+			/* Absorb following tuples with the same key, while they fit */
+			while (next <= maxoff)
+			{
+				ItemId		nextitemid = PageGetItemId(page, next);
+				IndexTuple	nextitup;
+				int			nnext;
+
+				if (ItemIdIsDead(nextitemid))
+					break;
+				nextitup = (IndexTuple) PageGetItem(page, nextitemid);
+				if (!_bt_keys_binary_equal(base, nextitup))
+					break;
+
+				nnext = BTreeTupleGetNTIDs(nextitup);
+				if (nhtids + nnext > BT_OFFSET_MASK ||
+					MAXALIGN(keysize + (nhtids + nnext) *
+							 sizeof(ItemPointerData)) > maxpostingsize)
+					break;
+
+				if (BTreeTupleIsPosting(nextitup))
+					memcpy(htids + nhtids, BTreeTupleGetPosting(nextitup),
+						   nnext * sizeof(ItemPointerData));
+				else
+					htids[nhtids] = nextitup->t_tid;
+				nhtids += nnext;
+				nmerged++;
+				next = OffsetNumberNext(next);
+			}
+
+			if (nmerged > 1)
+			{
+				qsort(htids, nhtids, sizeof(ItemPointerData), _bt_htid_cmp);
+				newitem = _bt_form_posting(base, htids, nhtids);
+				newitemsz = MAXALIGN(IndexTupleSize(newitem));
+			}
+		}
+
+		if (PageAddItem(newpage, (Item) newitem, newitemsz, newoff,
+						false, false) == InvalidOffsetNumber)
+			elog(ERROR, "failed to add item to the deduplicated page in index \"%s\"",
+				 RelationGetRelationName(rel));
+		if (isdead)
+			ItemIdMarkDead(PageGetItemId(newpage, newoff));
+		if (newitem != base)
+			pfree(newitem);
+
+		newoff = OffsetNumberNext(newoff);
+		offnum = next;
+	}
+
+	pfree(htids);
+
+	/* No ereport(ERROR) until changes are logged */
+	START_CRIT_SECTION();
+
+	PageRestoreTempPage(newpage, page);
+	MarkBufferDirty(buf);
+
+	if (RelationNeedsWAL(rel))
+		log_newpage_buffer(buf, true);
+
+	END_CRIT_SECTION();
+
+	return true;
+}
+
+/*
+ * Do two leaf tuples have binary-identical keys?
+ */
+static bool
+_bt_keys_binary_equal(IndexTuple a, IndexTuple b)
+{
+	Size		keysize = BTreeTupleGetKeySize(a);
+
+	if (BTreeTupleGetKeySize(b) != keysize)
+		return false;
+	if ((a->t_info & (INDEX_NULL_MASK | INDEX_VAR_MASK)) !=
+		(b->t_info & (INDEX_NULL_MASK | INDEX_VAR_MASK)))
+		return false;
+
+	return memcmp((char *) a + sizeof(IndexTupleData),
+				  (char *) b + sizeof(IndexTupleData),
+				  keysize - sizeof(IndexTupleData)) == 0;
+}
+
+/*
+ * qsort comparator for heap TIDs
+ */
+static int
+_bt_htid_cmp(const void *a, const void *b)
+{
+	return ItemPointerCompare((ItemPointer) a, (ItemPointer) b);
+}
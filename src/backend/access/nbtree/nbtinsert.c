@@ -646,6 +646,15 @@ _bt_findinsertloc(Relation rel,
 		vacuumed = false;
 	}
 
+	/*
+	 * If the page is still full, try merging its duplicates into posting
+	 * list tuples before we resort to splitting it.  Like vacuuming, that
+	 * moves tuples around and so invalidates the caller's hint.
+	 */
+	if (PageGetFreeSpace(page) < itemsz && P_ISLEAF(lpageop) &&
+		_bt_dedup_one_page(rel, buf))
+		vacuumed = true;
+
 	/*
 	 * Now we are on the right page, so find the insert position. If we moved
 	 * right at all, we know we should insert at the start of the page. If we
@@ -1070,6 +1079,34 @@ _bt_split(Relation rel, Buffer buf, Buffer cbuf, OffsetNumber firstright,
 		itemsz = ItemIdGetLength(itemid);
 		item = (IndexTuple) PageGetItem(origpage, itemid);
 	}
+
+	/*
+	 * On the leaf level, truncate the high key to the attributes needed to
+	 * distinguish it from the last item on the left page; this high key is
+	 * also what ends up in the parent as the right page's downlink.  Above
+	 * the leaf level we just keep copying the existing pivot tuples.
+	 */
+	if (isleaf)
+	{
+		IndexTuple	lastleft;
+
+		if (newitemonleft && newitemoff == firstright)
+		{
+			/* incoming tuple will become last on left page */
+			lastleft = newitem;
+		}
+		else
+		{
+			OffsetNumber lastleftoff = OffsetNumberPrev(firstright);
+
+			Assert(lastleftoff >= P_FIRSTDATAKEY(oopaque));
+			itemid = PageGetItemId(origpage, lastleftoff);
+			lastleft = (IndexTuple) PageGetItem(origpage, itemid);
+		}
+
+		item = _bt_truncate(rel, lastleft, item);
+		itemsz = MAXALIGN(IndexTupleSize(item));
+	}
 	if (PageAddItem(leftpage, (Item) item, itemsz, leftoff,
 					false, false) == InvalidOffsetNumber)
 	{
@@ -1304,43 +1341,24 @@ _bt_split(Relation rel, Buffer buf, Buffer cbuf, OffsetNumber firstright,
 		}
 
 		/* Log left page */
-		if (!isleaf)
-		{
-			lastrdata->next = lastrdata + 1;
-			lastrdata++;
-
-			/*
-			 * We must also log the left page's high key, because the right
-			 * page's leftmost key is suppressed on non-leaf levels.  Show it
-			 * as belonging to the left page buffer, so that it is not stored
-			 * if XLogInsert decides it needs a full-page image of the left
-			 * page.
-			 */
-			itemid = PageGetItemId(origpage, P_HIKEY);
-			item = (IndexTuple) PageGetItem(origpage, itemid);
-			lastrdata->data = (char *) item;
-			lastrdata->len = MAXALIGN(IndexTupleSize(item));
-			lastrdata->buffer = buf;	/* backup block 1 */
-			lastrdata->buffer_std = true;
-		}
-
-		if (isleaf && !newitemonleft)
-		{
-			lastrdata->next = lastrdata + 1;
-			lastrdata++;
+		lastrdata->next = lastrdata + 1;
+		lastrdata++;
 
-			/*
-			 * Although we don't need to WAL-log anything on the left page,
-			 * we still need XLogInsert to consider storing a full-page image
-			 * of the left page, so make an empty entry referencing that
-			 * buffer. This also ensures that the left page is always backup
-			 * block 1.
-			 */
-			lastrdata->data = NULL;
-			lastrdata->len = 0;
-			lastrdata->buffer = buf;	/* backup block 1 */
-			lastrdata->buffer_std = true;
-		}
+		/*
+		 * We must also log the left page's high key.  It can't be derived
+		 * from the right page: on non-leaf levels the right page's leftmost
+		 * key is suppressed, and on the leaf level the high key has been
+		 * truncated.  Show it as belonging to the left page buffer, so that
+		 * it is not stored if XLogInsert decides it needs a full-page image
+		 * of the left page.  This also ensures that the left page is always
+		 * backup block 1.
+		 */
+		itemid = PageGetItemId(origpage, P_HIKEY);
+		item = (IndexTuple) PageGetItem(origpage, itemid);
+		lastrdata->data = (char *) item;
+		lastrdata->len = MAXALIGN(IndexTupleSize(item));
+		lastrdata->buffer = buf;	/* backup block 1 */
+		lastrdata->buffer_std = true;
 
 		/*
 		 * Log block number of left child, whose INCOMPLETE_SPLIT flag this
@@ -1761,7 +1779,7 @@ _bt_insert_parent(Relation rel,
 
 		/* form an index tuple that points at the new right page */
 		new_item = CopyIndexTuple(ritem);
-		ItemPointerSet(&(new_item->t_tid), rbknum, P_HIKEY);
+		BTreeInnerTupleSetDownLink(new_item, rbknum);
 
 		/*
 		 * Find the parent buffer and get the parent page.
@@ -2036,7 +2054,7 @@ _bt_newroot(Relation rel, Buffer lbuf, Buffer rbuf)
 	right_item_sz = ItemIdGetLength(itemid);
 	item = (IndexTuple) PageGetItem(lpage, itemid);
 	right_item = CopyIndexTuple(item);
-	ItemPointerSet(&(right_item->t_tid), rbkno, P_HIKEY);
+	BTreeInnerTupleSetDownLink(right_item, rbkno);
 
 	/* NO EREPORT(ERROR) from here till newroot op is logged */
 	START_CRIT_SECTION();
@@ -781,6 +781,10 @@ _bt_page_recyclable(Page page)
  * This routine assumes that the caller has pinned and locked the buffer.
  * Also, the given itemnos *must* appear in increasing order in the array.
  *
+ * Posting list tuples that lost only some of their heap TIDs are passed in
+ * 'updated', with their offsets in 'updateitemnos'; each replaces the tuple
+ * at that offset.  The offsets of updated and deleted items are disjoint.
+ *
  * We record VACUUMs and b-tree deletes differently in WAL. InHotStandby
  * we need to be able to pin all of the blocks in the btree in physical
  * order when replaying the effects of a VACUUM, just as we do for the
@@ -794,15 +798,51 @@ _bt_page_recyclable(Page page)
 void
 _bt_delitems_vacuum(Relation rel, Buffer buf,
 					OffsetNumber *itemnos, int nitems,
-					BlockNumber lastBlockVacuumed)
+					OffsetNumber *updateitemnos, IndexTuple *updated,
+					int nupdated, BlockNumber lastBlockVacuumed)
 {
 	Page		page = BufferGetPage(buf);
 	BTPageOpaque opaque;
+	char	   *updatedbuf = NULL;
+	Size		updatedbuflen = 0;
+	int			i;
+
+	/*
+	 * Flatten the updated tuples into a single chunk for the WAL record.
+	 * Do this before entering the critical section, since it allocates.
+	 */
+	if (nupdated > 0 && RelationNeedsWAL(rel))
+	{
+		for (i = 0; i < nupdated; i++)
+			updatedbuflen += MAXALIGN(IndexTupleSize(updated[i]));
+		updatedbuf = palloc(updatedbuflen);
+		updatedbuflen = 0;
+		for (i = 0; i < nupdated; i++)
+		{
+			Size		itemsz = MAXALIGN(IndexTupleSize(updated[i]));
+
+			memcpy(updatedbuf + updatedbuflen, updated[i], itemsz);
+			updatedbuflen += itemsz;
+		}
+	}
 
 	/* No ereport(ERROR) until changes are logged */
 	START_CRIT_SECTION();
 
-	/* Fix the page */
+	/*
+	 * Fix the page.  Updated tuples go first, since they're identified by
+	 * their offsets before any deletion.  Each replacement is smaller than
+	 * the tuple it replaces, so it always fits.
+	 */
+	for (i = 0; i < nupdated; i++)
+	{
+		PageIndexTupleDelete(page, updateitemnos[i]);
+		if (PageAddItem(page, (Item) updated[i],
+						MAXALIGN(IndexTupleSize(updated[i])),
+						updateitemnos[i], false, false) == InvalidOffsetNumber)
+			elog(PANIC, "failed to add updated posting list item to index page in \"%s\"",
+				 RelationGetRelationName(rel));
+	}
 	if (nitems > 0)
 		PageIndexMultiDelete(page, itemnos, nitems);
 
@@ -828,22 +868,24 @@ _bt_delitems_vacuum(Relation rel, Buffer buf,
 	if (RelationNeedsWAL(rel))
 	{
 		XLogRecPtr	recptr;
-		XLogRecData rdata[2];
+		XLogRecData rdata[4];
 		xl_btree_vacuum xlrec_vacuum;
 
 		xlrec_vacuum.node = rel->rd_node;
 		xlrec_vacuum.block = BufferGetBlockNumber(buf);
 
 		xlrec_vacuum.lastBlockVacuumed = lastBlockVacuumed;
+		xlrec_vacuum.ndeleted = nitems;
+		xlrec_vacuum.nupdated = nupdated;
 		rdata[0].data = (char *) &xlrec_vacuum;
 		rdata[0].len = SizeOfBtreeVacuum;
 		rdata[0].buffer = InvalidBuffer;
 		rdata[0].next = &(rdata[1]);
 
 		/*
-		 * The target-offsets array is not in the buffer, but pretend that it
-		 * is.	When XLogInsert stores the whole buffer, the offsets array
-		 * need not be stored too.
+		 * The target-offsets arrays and the updated tuples are not in the
+		 * buffer, but pretend that they are.  When XLogInsert stores the
+		 * whole buffer, they need not be stored too.
 		 */
 		if (nitems > 0)
 		{
@@ -859,12 +901,32 @@ _bt_delitems_vacuum(Relation rel, Buffer buf,
 		rdata[1].buffer_std = true;
 		rdata[1].next = NULL;
 
+		if (nupdated > 0)
+		{
+			rdata[1].next = &(rdata[2]);
+
+			rdata[2].data = (char *) updateitemnos;
+			rdata[2].len = nupdated * sizeof(OffsetNumber);
+			rdata[2].buffer = buf;
+			rdata[2].buffer_std = true;
+			rdata[2].next = &(rdata[3]);
+
+			rdata[3].data = updatedbuf;
+			rdata[3].len = updatedbuflen;
+			rdata[3].buffer = buf;
+			rdata[3].buffer_std = true;
+			rdata[3].next = NULL;
+		}
+
 		recptr = XLogInsert(RM_BTREE_ID, XLOG_BTREE_VACUUM, rdata);
 
 		PageSetLSN(page, recptr);
 	}
 
 	END_CRIT_SECTION();
+
+	if (updatedbuf)
+		pfree(updatedbuf);
 }
 
 /*
@@ -1245,8 +1307,8 @@ _bt_pagedel(Relation rel, Buffer buf)
 				/* we need an insertion scan key for the search, so build one */
 				itup_scankey = _bt_mkscankey(rel, targetkey);
 				/* find the leftmost leaf page containing this key */
-				stack = _bt_search(rel, rel->rd_rel->relnatts, itup_scankey,
-								   false, &lbuf, BT_READ);
+				stack = _bt_search(rel, BTreeTupleGetNAtts(targetkey, rel),
+								   itup_scankey, false, &lbuf, BT_READ);
 				/* don't need a pin on the page */
 				_bt_relbuf(rel, lbuf);
 
@@ -1392,7 +1454,7 @@ _bt_mark_page_halfdead(Relation rel, Buffer leafbuf, BTStack stack)
 
 	itemid = PageGetItemId(page, topoff);
 	itup = (IndexTuple) PageGetItem(page, itemid);
-	ItemPointerSet(&(itup->t_tid), rightsib, P_HIKEY);
+	BTreeInnerTupleSetDownLink(itup, rightsib);
 
 	nextoffset = OffsetNumberNext(topoff);
 	PageIndexTupleDelete(page, nextoffset);
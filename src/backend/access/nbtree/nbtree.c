@@ -283,7 +283,14 @@ btgettuple(PG_FUNCTION_ARGS)
 		_bt_start_array_keys(scan, dir);
 	}
 
-	/* This loop handles advancing to the next array elements, if any */
+	/* Likewise, choose the first group if this is a skip scan */
+	if (so->skipScan && !BTScanPosIsValid(so->currPos))
+		_bt_start_skip_scan(scan, dir);
+
+	/*
+	 * This loop handles advancing to the next array elements or skip group,
+	 * if any
+	 */
 	do
 	{
 		/*
@@ -311,8 +318,8 @@ btgettuple(PG_FUNCTION_ARGS)
 				 */
 				if (so->killedItems == NULL)
 					so->killedItems = (int *)
-						palloc(MaxIndexTuplesPerPage * sizeof(int));
-				if (so->numKilled < MaxIndexTuplesPerPage)
+						palloc(MaxTIDsPerBTreePage * sizeof(int));
+				if (so->numKilled < MaxTIDsPerBTreePage)
 					so->killedItems[so->numKilled++] = so->currPos.itemIndex;
 			}
 
@@ -325,8 +332,9 @@ btgettuple(PG_FUNCTION_ARGS)
 		/* If we have a tuple, return it ... */
 		if (res)
 			break;
-		/* ... otherwise see if we have more array keys to deal with */
-	} while (so->numArrayKeys && _bt_advance_array_keys(scan, dir));
+		/* ... otherwise see if we have more array keys or groups to do */
+	} while ((so->numArrayKeys && _bt_advance_array_keys(scan, dir)) ||
+			 (so->skipScan && _bt_advance_skip_scan(scan, dir)));
 
 	PG_RETURN_BOOL(res);
 }
@@ -355,7 +363,14 @@ btgetbitmap(PG_FUNCTION_ARGS)
 		_bt_start_array_keys(scan, ForwardScanDirection);
 	}
 
-	/* This loop handles advancing to the next array elements, if any */
+	/* Likewise, choose the first group if this is a skip scan */
+	if (so->skipScan)
+		_bt_start_skip_scan(scan, ForwardScanDirection);
+
+	/*
+	 * This loop handles advancing to the next array elements or skip group,
+	 * if any
+	 */
 	do
 	{
 		/* Fetch the first page & tuple */
@@ -385,8 +400,9 @@ btgetbitmap(PG_FUNCTION_ARGS)
 				ntids++;
 			}
 		}
-		/* Now see if we have more array keys to deal with */
-	} while (so->numArrayKeys && _bt_advance_array_keys(scan, ForwardScanDirection));
+		/* Now see if we have more array keys or groups to deal with */
+	} while ((so->numArrayKeys && _bt_advance_array_keys(scan, ForwardScanDirection)) ||
+			 (so->skipScan && _bt_advance_skip_scan(scan, ForwardScanDirection)));
 
 	PG_RETURN_INT64(ntids);
 }
@@ -412,8 +428,13 @@ btbeginscan(PG_FUNCTION_ARGS)
 	/* allocate private workspace */
 	so = (BTScanOpaque) palloc(sizeof(BTScanOpaqueData));
 	so->currPos.buf = so->markPos.buf = InvalidBuffer;
+
+	/*
+	 * A skip scan adds one key on the leading index column to the caller's
+	 * keys, so leave room for that.
+	 */
 	if (scan->numberOfKeys > 0)
-		so->keyData = (ScanKey) palloc(scan->numberOfKeys * sizeof(ScanKeyData));
+		so->keyData = (ScanKey) palloc((scan->numberOfKeys + 1) * sizeof(ScanKeyData));
 	else
 		so->keyData = NULL;
 
@@ -422,6 +443,13 @@ btbeginscan(PG_FUNCTION_ARGS)
 	so->arrayKeys = NULL;
 	so->arrayContext = NULL;
 
+	so->skipScan = false;		/* assume no skip scan for now */
+	so->skipKeyData = NULL;
+	so->numSkipKeys = 0;
+	so->skipIsNull = so->markSkipIsNull = true;
+	so->skipValue = so->markSkipValue = (Datum) 0;
+	so->skipContext = NULL;
+
 	so->killedItems = NULL;		/* until needed */
 	so->numKilled = 0;
 
@@ -471,8 +499,8 @@ btrescan(PG_FUNCTION_ARGS)
 	so->markItemIndex = -1;
 
 	/*
-	 * Allocate tuple workspace arrays, if needed for an index-only scan and
-	 * not already done in a previous rescan call.	To save on palloc
+	 * Allocate tuple workspace arrays, if needed for an index-only scan or a
+	 * skip scan and not already done in a previous rescan call.	To save on palloc
 	 * overhead, both workspaces are allocated as one palloc block; only this
 	 * function and btendscan know that.
 	 *
@@ -486,7 +514,7 @@ btrescan(PG_FUNCTION_ARGS)
 	 * a SIGSEGV is not possible.  Yeah, this is ugly as sin, but it beats
 	 * adding special-case treatment for name_ops elsewhere.
 	 */
-	if (scan->xs_want_itup && so->currTuples == NULL)
+	if ((scan->xs_want_itup || scan->xs_want_skip) && so->currTuples == NULL)
 	{
 		so->currTuples = (char *) palloc(BLCKSZ * 2);
 		so->markTuples = so->currTuples + BLCKSZ;
@@ -505,6 +533,9 @@ btrescan(PG_FUNCTION_ARGS)
 	/* If any keys are SK_SEARCHARRAY type, set up array-key info */
 	_bt_preprocess_array_keys(scan);
 
+	/* Set up for a skip scan, if the caller wants one */
+	_bt_preprocess_skip_scan(scan);
+
 	PG_RETURN_VOID();
 }
 
@@ -540,6 +571,9 @@ btendscan(PG_FUNCTION_ARGS)
 	/* so->arrayKeyData and so->arrayKeys are in arrayContext */
 	if (so->arrayContext != NULL)
 		MemoryContextDelete(so->arrayContext);
+	/* so->skipKeyData and skip values are in skipContext */
+	if (so->skipContext != NULL)
+		MemoryContextDelete(so->skipContext);
 	if (so->killedItems != NULL)
 		pfree(so->killedItems);
 	if (so->currTuples != NULL)
@@ -581,6 +615,10 @@ btmarkpos(PG_FUNCTION_ARGS)
 	if (so->numArrayKeys)
 		_bt_mark_array_keys(scan);
 
+	/* ... and the current skip group */
+	if (so->skipScan)
+		_bt_mark_skip_scan(scan);
+
 	PG_RETURN_VOID();
 }
 
@@ -628,6 +666,14 @@ btrestrpos(PG_FUNCTION_ARGS)
 			if (so->currTuples)
 				memcpy(so->currTuples, so->markTuples,
 					   so->markPos.nextTupleOffset);
+
+			/*
+			 * The marked position might belong to an earlier skip group.
+			 * (If the mark is on the current page, it must be in the current
+			 * group, so we needn't bother in that case.)
+			 */
+			if (so->skipScan)
+				_bt_restore_skip_scan(scan);
 		}
 	}
 
@@ -835,7 +881,8 @@ btvacuumscan(IndexVacuumInfo *info, IndexBulkDeleteResult *stats,
 								 RBM_NORMAL, info->strategy);
 		LockBufferForCleanup(buf);
 		_bt_checkpage(rel, buf);
-		_bt_delitems_vacuum(rel, buf, NULL, 0, vstate.lastBlockVacuumed);
+		_bt_delitems_vacuum(rel, buf, NULL, 0, NULL, NULL, 0,
+							vstate.lastBlockVacuumed);
 		_bt_relbuf(rel, buf);
 	}
 
@@ -931,6 +978,10 @@ restart:
 	{
 		OffsetNumber deletable[MaxOffsetNumber];
 		int			ndeletable;
+		OffsetNumber updatable[MaxIndexTuplesPerPage];
+		IndexTuple	updated[MaxIndexTuplesPerPage];
+		int			nupdatable;
+		int			nhtidsdead;
 		OffsetNumber offnum,
 					minoff,
 					maxoff;
@@ -970,6 +1021,8 @@ restart:
 		 * callback function.
 		 */
 		ndeletable = 0;
+		nupdatable = 0;
+		nhtidsdead = 0;
 		minoff = P_FIRSTDATAKEY(opaque);
 		maxoff = PageGetMaxOffsetNumber(page);
 		if (callback)
@@ -1006,8 +1059,36 @@ restart:
 				 * applies to *any* type of index that marks index tuples as
 				 * killed.
 				 */
-				if (callback(htup, callback_state))
+				if (BTreeTupleIsPosting(itup))
+				{
+					/* check each heap TID of a posting list tuple */
+					ItemPointerData htids[MaxTIDsPerBTreePage];
+					int			nposting = BTreeTupleGetNPosting(itup);
+					int			nlive = 0;
+					int			i;
+
+					for (i = 0; i < nposting; i++)
+					{
+						htup = BTreeTupleGetPostingN(itup, i);
+						if (!callback(htup, callback_state))
+							htids[nlive++] = *htup;
+					}
+
+					nhtidsdead += nposting - nlive;
+					if (nlive == 0)
+						deletable[ndeletable++] = offnum;
+					else if (nlive < nposting)
+					{
+						updatable[nupdatable] = offnum;
+						updated[nupdatable++] = _bt_form_posting(itup, htids,
+																 nlive);
+					}
+				}
+				else if (callback(htup, callback_state))
+				{
 					deletable[ndeletable++] = offnum;
+					nhtidsdead++;
+				}
 			}
 		}
 
@@ -1015,7 +1096,7 @@ restart:
 		 * Apply any needed deletes.  We issue just one _bt_delitems_vacuum()
 		 * call per page, so as to minimize WAL traffic.
 		 */
-		if (ndeletable > 0)
+		if (ndeletable > 0 || nupdatable > 0)
 		{
 			/*
 			 * Notice that the issued XLOG_BTREE_VACUUM WAL record includes an
@@ -1029,7 +1110,10 @@ restart:
 			 * that.
 			 */
 			_bt_delitems_vacuum(rel, buf, deletable, ndeletable,
+								updatable, updated, nupdatable,
 								vstate->lastBlockVacuumed);
+			while (nupdatable > 0)
+				pfree(updated[--nupdatable]);
 
 			/*
 			 * Remember highest leaf page number we've issued a
@@ -1038,7 +1122,7 @@ restart:
 			if (blkno > vstate->lastBlockVacuumed)
 				vstate->lastBlockVacuumed = blkno;
 
-			stats->tuples_removed += ndeletable;
+			stats->tuples_removed += nhtidsdead;
 			/* must recompute maxoff */
 			maxoff = PageGetMaxOffsetNumber(page);
 		}
@@ -1070,7 +1154,19 @@ restart:
 		if (minoff > maxoff)
 			delete_now = (blkno == orig_blkno);
 		else
-			stats->num_index_tuples += maxoff - minoff + 1;
+		{
+			/* count heap TIDs, not index tuples */
+			for (offnum = minoff;
+				 offnum <= maxoff;
+				 offnum = OffsetNumberNext(offnum))
+			{
+				IndexTuple	itup;
+
+				itup = (IndexTuple) PageGetItem(page,
+												PageGetItemId(page, offnum));
+				stats->num_index_tuples += BTreeTupleGetNTIDs(itup);
+			}
+		}
 	}
 
 	if (delete_now)
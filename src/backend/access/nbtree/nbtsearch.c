@@ -28,9 +28,12 @@ static bool _bt_readpage(IndexScanDesc scan, ScanDirection dir,
 			 OffsetNumber offnum);
 static void _bt_saveitem(BTScanOpaque so, int itemIndex,
 			 OffsetNumber offnum, IndexTuple itup);
+static int _bt_saveposting(BTScanOpaque so, int itemIndex,
+				OffsetNumber offnum, IndexTuple itup, bool forward);
 static bool _bt_steppage(IndexScanDesc scan, ScanDirection dir);
 static Buffer _bt_walk_left(Relation rel, Buffer buf);
 static bool _bt_endpoint(IndexScanDesc scan, ScanDirection dir);
+static bool _bt_skip_probe(IndexScanDesc scan, ScanDirection dir);
 
 
 /*
@@ -108,7 +111,7 @@ _bt_search(Relation rel, int keysz, ScanKey scankey, bool nextkey,
 		offnum = _bt_binsrch(rel, *bufP, keysz, scankey, nextkey);
 		itemid = PageGetItemId(page, offnum);
 		itup = (IndexTuple) PageGetItem(page, itemid);
-		blkno = ItemPointerGetBlockNumber(&(itup->t_tid));
+		blkno = BTreeInnerTupleGetDownLink(itup);
 		par_blkno = BufferGetBlockNumber(*bufP);
 
 		/*
@@ -377,6 +380,10 @@ _bt_binsrch(Relation rel,
  * does not matter.  This convention allows us to implement the Lehman and
  * Yao convention that the first down-link pointer is before the first key.
  * See backend/access/nbtree/README for details.
+ *
+ * Similarly, the attributes truncated away from a pivot tuple are taken to
+ * be minus infinity: if the scankey matches all of the attributes the tuple
+ * has left, but has more, it is greater than the tuple.
  *----------
  */
 int32
@@ -389,6 +396,7 @@ _bt_compare(Relation rel,
 	TupleDesc	itupdesc = RelationGetDescr(rel);
 	BTPageOpaque opaque = (BTPageOpaque) PageGetSpecialPointer(page);
 	IndexTuple	itup;
+	int			ntupatts;
 	int			i;
 
 	/*
@@ -399,6 +407,7 @@ _bt_compare(Relation rel,
 		return 1;
 
 	itup = (IndexTuple) PageGetItem(page, PageGetItemId(page, offnum));
+	ntupatts = BTreeTupleGetNAtts(itup, rel);
 
 	/*
 	 * The scan key is set up with the attribute number associated with each
@@ -418,6 +427,10 @@ _bt_compare(Relation rel,
 		bool		isNull;
 		int32		result;
 
+		/* truncated attributes are minus infinity --- see NOTE above */
+		if (scankey->sk_attno > ntupatts)
+			return 1;
+
 		datum = index_getattr(itup, scankey->sk_attno, itupdesc, &isNull);
 
 		/* see comments about NULLs handling in btbuild */
@@ -1081,6 +1094,112 @@ _bt_next(IndexScanDesc scan, ScanDirection dir)
 	return true;
 }
 
+/*
+ *	_bt_start_skip_scan() -- Choose the first group of a skip scan
+ *
+ *		Like _bt_start_array_keys, this has to wait until the first
+ *		btgettuple call, since we need to know the scan direction.  On
+ *		return, skipKeyData is set up to scan the first group, which is the
+ *		group of NULLs if either they come first in this scan direction or
+ *		there are no non-null leading column values at all.
+ */
+void
+_bt_start_skip_scan(IndexScanDesc scan, ScanDirection dir)
+{
+	bool		found = false;
+
+	if (!_bt_skip_nulls_first(scan, dir))
+	{
+		_bt_skip_probe_keys(scan, dir, true);
+		found = _bt_skip_probe(scan, dir);
+	}
+	if (!found)
+		_bt_skip_set_group(scan, true, (Datum) 0);
+
+	_bt_skip_group_keys(scan);
+}
+
+/*
+ *	_bt_advance_skip_scan() -- Advance a skip scan to its next group
+ *
+ *		Returns TRUE if there is another group to scan, in which case
+ *		skipKeyData is set up to scan it; FALSE if not.  Each call costs a
+ *		fresh descent of the tree to find the next leading column value.
+ */
+bool
+_bt_advance_skip_scan(IndexScanDesc scan, ScanDirection dir)
+{
+	BTScanOpaque so = (BTScanOpaque) scan->opaque;
+	bool		nullsFirst = _bt_skip_nulls_first(scan, dir);
+
+	/*
+	 * If the caller's own keys were found to be contradictory while setting
+	 * up the last group, they are contradictory for every group.
+	 */
+	if (!so->qual_ok)
+		return false;
+
+	if (so->skipIsNull)
+	{
+		/* The NULL group is the last one unless it came first */
+		if (!nullsFirst)
+			return false;
+		_bt_skip_probe_keys(scan, dir, true);
+		if (!_bt_skip_probe(scan, dir))
+			return false;
+	}
+	else
+	{
+		_bt_skip_probe_keys(scan, dir, false);
+		if (!_bt_skip_probe(scan, dir))
+		{
+			/* Out of non-null values; finish with NULLs if they're last */
+			if (nullsFirst)
+				return false;
+			_bt_skip_set_group(scan, true, (Datum) 0);
+		}
+	}
+
+	_bt_skip_group_keys(scan);
+	return true;
+}
+
+/*
+ *	_bt_skip_probe() -- Find a skip scan's next leading column value
+ *
+ *		skipKeyData must hold a probe key set up by _bt_skip_probe_keys.
+ *		If a matching index entry exists, make its leading column value the
+ *		current skip group and return TRUE.  Either way, the scan position is
+ *		left invalid, so that the group's own scan starts with _bt_first.
+ */
+static bool
+_bt_skip_probe(IndexScanDesc scan, ScanDirection dir)
+{
+	BTScanOpaque so = (BTScanOpaque) scan->opaque;
+	BTScanPosItem *currItem;
+	IndexTuple	itup;
+	Datum		value;
+	bool		isnull;
+
+	if (!_bt_first(scan, dir))
+		return false;
+
+	/* btrescan made sure we have a copy of the tuple to look at */
+	Assert(so->currTuples != NULL);
+	currItem = &so->currPos.items[so->currPos.itemIndex];
+	itup = (IndexTuple) (so->currTuples + currItem->tupleOffset);
+	value = index_getattr(itup, 1, RelationGetDescr(scan->indexRelation),
+						  &isnull);
+	Assert(!isnull);
+	_bt_skip_set_group(scan, false, value);
+
+	/* We have no use for the rest of the page; drop the pin */
+	ReleaseBuffer(so->currPos.buf);
+	so->currPos.buf = InvalidBuffer;
+
+	return true;
+}
+
 /*
  *	_bt_readpage() -- Load data from current index page into so->currPos
  *
@@ -1139,8 +1258,14 @@ _bt_readpage(IndexScanDesc scan, ScanDirection dir, OffsetNumber offnum)
 			if (itup != NULL)
 			{
 				/* tuple passes all scan key conditions, so remember it */
-				_bt_saveitem(so, itemIndex, offnum, itup);
-				itemIndex++;
+				if (BTreeTupleIsPosting(itup))
+					itemIndex = _bt_saveposting(so, itemIndex, offnum, itup,
+												true);
+				else
+				{
+					_bt_saveitem(so, itemIndex, offnum, itup);
+					itemIndex++;
+				}
 			}
 			if (!continuescan)
 			{
@@ -1152,7 +1277,7 @@ _bt_readpage(IndexScanDesc scan, ScanDirection dir, OffsetNumber offnum)
 			offnum = OffsetNumberNext(offnum);
 		}
 
-		Assert(itemIndex <= MaxIndexTuplesPerPage);
+		Assert(itemIndex <= MaxTIDsPerBTreePage);
 		so->currPos.firstItem = 0;
 		so->currPos.lastItem = itemIndex - 1;
 		so->currPos.itemIndex = 0;
@@ -1160,7 +1285,7 @@ _bt_readpage(IndexScanDesc scan, ScanDirection dir, OffsetNumber offnum)
 	else
 	{
 		/* load items[] in descending order */
-		itemIndex = MaxIndexTuplesPerPage;
+		itemIndex = MaxTIDsPerBTreePage;
 
 		offnum = Min(offnum, maxoff);
 
@@ -1170,8 +1295,14 @@ _bt_readpage(IndexScanDesc scan, ScanDirection dir, OffsetNumber offnum)
 			if (itup != NULL)
 			{
 				/* tuple passes all scan key conditions, so remember it */
-				itemIndex--;
-				_bt_saveitem(so, itemIndex, offnum, itup);
+				if (BTreeTupleIsPosting(itup))
+					itemIndex = _bt_saveposting(so, itemIndex, offnum, itup,
+												false);
+				else
+				{
+					itemIndex--;
+					_bt_saveitem(so, itemIndex, offnum, itup);
+				}
 			}
 			if (!continuescan)
 			{
@@ -1185,8 +1316,8 @@ _bt_readpage(IndexScanDesc scan, ScanDirection dir, OffsetNumber offnum)
 
 		Assert(itemIndex >= 0);
 		so->currPos.firstItem = itemIndex;
-		so->currPos.lastItem = MaxIndexTuplesPerPage - 1;
-		so->currPos.itemIndex = MaxIndexTuplesPerPage - 1;
+		so->currPos.lastItem = MaxTIDsPerBTreePage - 1;
+		so->currPos.itemIndex = MaxTIDsPerBTreePage - 1;
 	}
 
 	return (so->currPos.firstItem <= so->currPos.lastItem);
@@ -1211,6 +1342,54 @@ _bt_saveitem(BTScanOpaque so, int itemIndex,
 	}
 }
 
+/*
+ * Save the heap TIDs of a posting list tuple into so->currPos.items[],
+ * starting at itemIndex and moving in the scan direction.  All of the items
+ * share one copy of the tuple's key part for index-only scans.  Returns the
+ * next itemIndex to use.
+ */
+static int
+_bt_saveposting(BTScanOpaque so, int itemIndex,
+				OffsetNumber offnum, IndexTuple itup, bool forward)
+{
+	int			nposting = BTreeTupleGetNPosting(itup);
+	int			tupleOffset = 0;
+	int			i;
+
+	if (so->currTuples)
+	{
+		Size		keysize = BTreeTupleGetPostingOffset(itup);
+		IndexTuple	base;
+
+		/* save the key part as an ordinary tuple */
+		tupleOffset = so->currPos.nextTupleOffset;
+		base = (IndexTuple) (so->currTuples + tupleOffset);
+		memcpy(base, itup, keysize);
+		base->t_info &= ~(INDEX_SIZE_MASK | INDEX_ALT_TID_MASK);
+		base->t_info |= keysize;
+		base->t_tid = *BTreeTupleGetPosting(itup);
+		so->currPos.nextTupleOffset += MAXALIGN(keysize);
+	}
+
+	for (i = 0; i < nposting; i++)
+	{
+		BTScanPosItem *currItem;
+
+		/* items[] is in index order, so fill backwards scans from the end */
+		if (forward)
+			currItem = &so->currPos.items[itemIndex++];
+		else
+			currItem = &so->currPos.items[--itemIndex];
+
+		currItem->heapTid = *BTreeTupleGetPostingN(itup,
+												  forward ? i : nposting - 1 - i);
+		currItem->indexOffset = offnum;
+		currItem->tupleOffset = tupleOffset;
+	}
+
+	return itemIndex;
+}
+
 /*
  *	_bt_steppage() -- Step to next page containing valid data for scan
  *
@@ -1533,7 +1712,7 @@ _bt_get_endpoint(Relation rel, uint32 level, bool rightmost)
 			offnum = P_FIRSTDATAKEY(opaque);
 
 		itup = (IndexTuple) PageGetItem(page, PageGetItemId(page, offnum));
-		blkno = ItemPointerGetBlockNumber(&(itup->t_tid));
+		blkno = BTreeInnerTupleGetDownLink(itup);
 
 		buf = _bt_relandgetbuf(rel, buf, blkno, BT_READ);
 		page = BufferGetPage(buf);
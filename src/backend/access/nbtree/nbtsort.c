@@ -507,6 +507,7 @@ _bt_buildadd(BTWriteState *wstate, BTPageState *state, IndexTuple itup)
 		ItemId		ii;
 		ItemId		hii;
 		IndexTuple	oitup;
+		IndexTuple	truncated = NULL;
 
 		/* Create new page of same level */
 		npage = _bt_blnewpage(state->btps_level);
@@ -526,6 +527,21 @@ _bt_buildadd(BTWriteState *wstate, BTPageState *state, IndexTuple itup)
 		oitup = (IndexTuple) PageGetItem(opage, ii);
 		_bt_sortaddtup(npage, ItemIdGetLength(ii), oitup, P_FIRSTKEY);
 
+		/*
+		 * On the leaf level, the high key can be truncated to the attributes
+		 * needed to distinguish it from the item before it (see
+		 * _bt_truncate).  Build it now, while that item is still in place.
+		 */
+		if (state->btps_level == 0)
+		{
+			IndexTuple	lastleft;
+
+			lastleft = (IndexTuple)
+				PageGetItem(opage,
+							PageGetItemId(opage, OffsetNumberPrev(last_off)));
+			truncated = _bt_truncate(wstate->index, lastleft, oitup);
+		}
+
 		/*
 		 * Move 'last' into the high key position on opage
 		 */
@@ -534,6 +550,16 @@ _bt_buildadd(BTWriteState *wstate, BTPageState *state, IndexTuple itup)
 		ItemIdSetUnused(ii);	/* redundant */
 		((PageHeader) opage)->pd_lower -= sizeof(ItemIdData);
 
+		/* and replace it with the truncated version, if any */
+		if (truncated)
+		{
+			PageIndexTupleDelete(opage, P_HIKEY);
+			if (PageAddItem(opage, (Item) truncated,
+							MAXALIGN(IndexTupleSize(truncated)), P_HIKEY,
+							false, false) == InvalidOffsetNumber)
+				elog(ERROR, "failed to add high key to the index page");
+		}
+
 		/*
 		 * Link the old page into its parent, using its minimum key. If we
 		 * don't have a parent, we have to create one; this adds a new btree
@@ -543,16 +569,19 @@ _bt_buildadd(BTWriteState *wstate, BTPageState *state, IndexTuple itup)
 			state->btps_next = _bt_pagestate(wstate, state->btps_level + 1);
 
 		Assert(state->btps_minkey != NULL);
-		ItemPointerSet(&(state->btps_minkey->t_tid), oblkno, P_HIKEY);
+		BTreeInnerTupleSetDownLink(state->btps_minkey, oblkno);
 		_bt_buildadd(wstate, state->btps_next, state->btps_minkey);
 		pfree(state->btps_minkey);
 
 		/*
 		 * Save a copy of the minimum key for the new page.  We have to copy
 		 * it off the old page, not the new one, in case we are not at leaf
-		 * level.
+		 * level.  On the leaf level, it's the truncated high key.
 		 */
-		state->btps_minkey = CopyIndexTuple(oitup);
+		if (truncated)
+			state->btps_minkey = truncated;
+		else
+			state->btps_minkey = CopyIndexTuple(oitup);
 
 		/*
 		 * Set the sibling links for both pages.
@@ -640,7 +669,7 @@ _bt_uppershutdown(BTWriteState *wstate, BTPageState *state)
 		else
 		{
 			Assert(s->btps_minkey != NULL);
-			ItemPointerSet(&(s->btps_minkey->t_tid), blkno, P_HIKEY);
+			BTreeInnerTupleSetDownLink(s->btps_minkey, blkno);
 			_bt_buildadd(wstate, s->btps_next, s->btps_minkey);
 			pfree(s->btps_minkey);
 			s->btps_minkey = NULL;
@@ -22,6 +22,7 @@
 #include "access/relscan.h"
 #include "miscadmin.h"
 #include "utils/array.h"
+#include "utils/datum.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
 #include "utils/rel.h"
@@ -49,6 +50,7 @@ static void _bt_mark_scankey_required(ScanKey skey);
 static bool _bt_check_rowcompare(ScanKey skey,
 					 IndexTuple tuple, TupleDesc tupdesc,
 					 ScanDirection dir, bool *continuescan);
+static int	_bt_compare_int(const void *a, const void *b);
 
 
 /*
@@ -56,7 +58,9 @@ static bool _bt_check_rowcompare(ScanKey skey,
  *		Build an insertion scan key that contains comparison data from itup
  *		as well as comparator routines appropriate to the key datatypes.
  *
- *		The result is intended for use with _bt_compare().
+ *		The result is intended for use with _bt_compare().  If itup is a
+ *		truncated pivot tuple, only the attributes it has are filled in, and
+ *		the caller must not pass a larger keysz than BTreeTupleGetNAtts().
  */
 ScanKey
 _bt_mkscankey(Relation rel, IndexTuple itup)
@@ -64,16 +68,18 @@ _bt_mkscankey(Relation rel, IndexTuple itup)
 	ScanKey		skey;
 	TupleDesc	itupdesc;
 	int			natts;
+	int			tupnatts;
 	int16	   *indoption;
 	int			i;
 
 	itupdesc = RelationGetDescr(rel);
 	natts = RelationGetNumberOfAttributes(rel);
+	tupnatts = BTreeTupleGetNAtts(itup, rel);
 	indoption = rel->rd_indoption;
 
 	skey = (ScanKey) palloc(natts * sizeof(ScanKeyData));
 
-	for (i = 0; i < natts; i++)
+	for (i = 0; i < tupnatts; i++)
 	{
 		FmgrInfo   *procinfo;
 		Datum		arg;
@@ -148,6 +154,65 @@ _bt_mkscankey_nodata(Relation rel)
 	return skey;
 }
 
+/*
+ * _bt_truncate
+ *		Build the pivot tuple that a leaf page split uses as the new high key
+ *		of the left page and as the downlink key of the right page.
+ *
+ *		lastleft and firstright are the last tuple going to the left page and
+ *		the first going to the right page.  We keep firstright's attributes up
+ *		to and including the first one on which the two differ according to
+ *		the opclass; the rest can be truncated away, since the remaining
+ *		prefix is already enough to tell the pages apart (see _bt_compare).
+ *		If the tuples are equal on every attribute, nothing can be truncated.
+ *		The result is palloc'd, and never has a posting list.
+ */
+IndexTuple
+_bt_truncate(Relation rel, IndexTuple lastleft, IndexTuple firstright)
+{
+	TupleDesc	itupdesc = RelationGetDescr(rel);
+	struct tupleDesc truncdesc;
+	int			natts = RelationGetNumberOfAttributes(rel);
+	int			keepnatts;
+	Datum		values[INDEX_MAX_KEYS];
+	bool		isnull[INDEX_MAX_KEYS];
+	IndexTuple	pivot;
+
+	for (keepnatts = 1; keepnatts <= natts; keepnatts++)
+	{
+		Datum		datum1,
+					datum2;
+		bool		isNull1,
+					isNull2;
+
+		datum1 = index_getattr(lastleft, keepnatts, itupdesc, &isNull1);
+		datum2 = index_getattr(firstright, keepnatts, itupdesc, &isNull2);
+
+		if (isNull1 != isNull2)
+			break;
+		if (!isNull1 &&
+			DatumGetInt32(FunctionCall2Coll(index_getprocinfo(rel, keepnatts,
+															  BTORDER_PROC),
+											rel->rd_indcollation[keepnatts - 1],
+											datum1, datum2)) != 0)
+			break;
+	}
+
+	if (keepnatts >= natts)
+		return _bt_pivot_tuple(firstright);
+
+	/* Form a new tuple from the attributes we keep */
+	index_deform_tuple(firstright, itupdesc, values, isnull);
+	truncdesc = *itupdesc;
+	truncdesc.natts = keepnatts;
+	pivot = index_form_tuple(&truncdesc, values, isnull);
+	BTreeTupleSetNAtts(pivot, keepnatts);
+
+	Assert(IndexTupleSize(pivot) <= BTreeTupleGetKeySize(firstright));
+
+	return pivot;
+}
+
 /*
  * free a scan key made by either _bt_mkscankey or _bt_mkscankey_nodata.
  */
@@ -655,6 +720,266 @@ _bt_restore_array_keys(IndexScanDesc scan)
 }
 
 
+
+/*
+ * _bt_preprocess_skip_scan() -- Set up a skip scan, if requested
+ *
+ * A skip scan handles quals that don't constrain the leading index column
+ * by treating the index as a series of groups, one per distinct value of
+ * that column (plus one for NULLs).  Each group is searched as though the
+ * caller had also supplied "leading_col = value", and a fresh descent of the
+ * tree is used to find the next value whenever a group is exhausted.  That
+ * can be much cheaper than a full index scan when the leading column has
+ * few distinct values.
+ *
+ * The executor asks for this via xs_want_skip, but we only honor the request
+ * when the scan keys look like what the planner would have chosen a skip
+ * scan for: no keys on the leading column, and no array or row-comparison
+ * keys.  Otherwise, we silently fall back to a regular scan, which gives the
+ * same answers.  Like _bt_preprocess_array_keys, this is called by btrescan.
+ */
+void
+_bt_preprocess_skip_scan(IndexScanDesc scan)
+{
+	BTScanOpaque so = (BTScanOpaque) scan->opaque;
+	Relation	rel = scan->indexRelation;
+	int			i;
+
+	so->skipScan = false;
+
+	if (!scan->xs_want_skip || so->numArrayKeys != 0 ||
+		scan->numberOfKeys < 1 || RelationGetNumberOfAttributes(rel) < 2)
+		return;
+
+	for (i = 0; i < scan->numberOfKeys; i++)
+	{
+		ScanKey		cur = &scan->keyData[i];
+
+		if (cur->sk_attno <= 1 ||
+			(cur->sk_flags & (SK_SEARCHARRAY | SK_ROW_HEADER)))
+			return;
+	}
+
+	/*
+	 * Make a scan-lifespan context to hold skip-related data, and look up the
+	 * leading column's comparison operators, unless a previous rescan cycle
+	 * already did so.
+	 */
+	if (so->skipContext == NULL)
+	{
+		Oid			opfamily = rel->rd_opfamily[0];
+		Oid			opcintype = rel->rd_opcintype[0];
+		StrategyNumber strat;
+
+		so->skipContext = AllocSetContextCreate(CurrentMemoryContext,
+												"BTree Skip Context",
+												ALLOCSET_SMALL_MINSIZE,
+												ALLOCSET_SMALL_INITSIZE,
+												ALLOCSET_SMALL_MAXSIZE);
+		so->skipKeyData = (ScanKey)
+			MemoryContextAlloc(so->skipContext,
+							   (scan->numberOfKeys + 1) * sizeof(ScanKeyData));
+
+		for (strat = 1; strat <= BTMaxStrategyNumber; strat++)
+		{
+			Oid			opr;
+
+			so->skipProcs[strat - 1].fn_oid = InvalidOid;
+			if (strat != BTLessStrategyNumber &&
+				strat != BTEqualStrategyNumber &&
+				strat != BTGreaterStrategyNumber)
+				continue;
+			opr = get_opfamily_member(opfamily, opcintype, opcintype, strat);
+			if (OidIsValid(opr))
+				fmgr_info_cxt(get_opcode(opr), &so->skipProcs[strat - 1],
+							  so->skipContext);
+		}
+	}
+
+	/* punt if the opfamily lacks any of the operators we need */
+	if (!OidIsValid(so->skipProcs[BTLessStrategyNumber - 1].fn_oid) ||
+		!OidIsValid(so->skipProcs[BTEqualStrategyNumber - 1].fn_oid) ||
+		!OidIsValid(so->skipProcs[BTGreaterStrategyNumber - 1].fn_oid))
+		return;
+
+	so->skipScan = true;
+	_bt_skip_set_group(scan, true, (Datum) 0);
+}
+
+/*
+ * _bt_skip_set_group() -- Remember the leading-column value of a skip group
+ *
+ * isnull = true selects the group of NULLs.  A non-null value is copied into
+ * the skip context, so the caller needn't keep it valid.
+ */
+void
+_bt_skip_set_group(IndexScanDesc scan, bool isnull, Datum value)
+{
+	BTScanOpaque so = (BTScanOpaque) scan->opaque;
+	Form_pg_attribute attr = RelationGetDescr(scan->indexRelation)->attrs[0];
+
+	if (!so->skipIsNull && !attr->attbyval)
+		pfree(DatumGetPointer(so->skipValue));
+
+	so->skipIsNull = isnull;
+	if (isnull)
+		so->skipValue = (Datum) 0;
+	else
+	{
+		MemoryContext oldContext = MemoryContextSwitchTo(so->skipContext);
+
+		so->skipValue = datumCopy(value, attr->attbyval, attr->attlen);
+		MemoryContextSwitchTo(oldContext);
+	}
+}
+
+/*
+ * _bt_skip_group_keys() -- Set up skipKeyData to scan the current group
+ *
+ * The result is the caller's scan keys, preceded by an equality (or IS NULL)
+ * key on the leading column.  Since the caller's keys never reference the
+ * leading column, the combined set is still correctly ordered.
+ */
+void
+_bt_skip_group_keys(IndexScanDesc scan)
+{
+	BTScanOpaque so = (BTScanOpaque) scan->opaque;
+	Relation	rel = scan->indexRelation;
+
+	if (so->skipIsNull)
+		ScanKeyEntryInitialize(&so->skipKeyData[0],
+							   SK_ISNULL | SK_SEARCHNULL,
+							   1,
+							   InvalidStrategy,
+							   InvalidOid,
+							   InvalidOid,
+							   InvalidOid,
+							   (Datum) 0);
+	else
+		ScanKeyEntryInitializeWithInfo(&so->skipKeyData[0],
+									   0,
+									   1,
+									   BTEqualStrategyNumber,
+									   rel->rd_opcintype[0],
+									   rel->rd_indcollation[0],
+									   &so->skipProcs[BTEqualStrategyNumber - 1],
+									   so->skipValue);
+
+	memcpy(&so->skipKeyData[1], scan->keyData,
+		   scan->numberOfKeys * sizeof(ScanKeyData));
+	so->numSkipKeys = scan->numberOfKeys + 1;
+}
+
+/*
+ * _bt_skip_probe_keys() -- Set up skipKeyData to find the next group
+ *
+ * If first is true, the single key built matches the first non-null leading
+ * column value in the given scan direction; otherwise, the first value
+ * beyond the current group's value in that direction.
+ */
+void
+_bt_skip_probe_keys(IndexScanDesc scan, ScanDirection dir, bool first)
+{
+	BTScanOpaque so = (BTScanOpaque) scan->opaque;
+	Relation	rel = scan->indexRelation;
+
+	if (first)
+		ScanKeyEntryInitialize(&so->skipKeyData[0],
+							   SK_ISNULL | SK_SEARCHNOTNULL,
+							   1,
+							   InvalidStrategy,
+							   InvalidOid,
+							   InvalidOid,
+							   InvalidOid,
+							   (Datum) 0);
+	else
+	{
+		StrategyNumber strat;
+
+		Assert(!so->skipIsNull);
+
+		/*
+		 * The key is expressed in terms of the column's own ordering, which
+		 * is reversed relative to index order for a DESC column;
+		 * _bt_fix_scankey_strategy will take care of that later.
+		 */
+		if (ScanDirectionIsForward(dir) ==
+			!(rel->rd_indoption[0] & INDOPTION_DESC))
+			strat = BTGreaterStrategyNumber;
+		else
+			strat = BTLessStrategyNumber;
+
+		ScanKeyEntryInitializeWithInfo(&so->skipKeyData[0],
+									   0,
+									   1,
+									   strat,
+									   rel->rd_opcintype[0],
+									   rel->rd_indcollation[0],
+									   &so->skipProcs[strat - 1],
+									   so->skipValue);
+	}
+	so->numSkipKeys = 1;
+}
+
+/*
+ * _bt_skip_nulls_first() -- Does a skip scan in this direction see the
+ * group of NULLs before any other group?
+ */
+bool
+_bt_skip_nulls_first(IndexScanDesc scan, ScanDirection dir)
+{
+	bool		nullsFirst;
+
+	nullsFirst = (scan->indexRelation->rd_indoption[0] & INDOPTION_NULLS_FIRST) != 0;
+	return ScanDirectionIsForward(dir) ? nullsFirst : !nullsFirst;
+}
+
+/*
+ * _bt_mark_skip_scan() -- Handle skip scan groups during btmarkpos
+ *
+ * Save the current skip group as the "mark" position.
+ */
+void
+_bt_mark_skip_scan(IndexScanDesc scan)
+{
+	BTScanOpaque so = (BTScanOpaque) scan->opaque;
+	Form_pg_attribute attr = RelationGetDescr(scan->indexRelation)->attrs[0];
+
+	if (!so->markSkipIsNull && !attr->attbyval)
+		pfree(DatumGetPointer(so->markSkipValue));
+
+	so->markSkipIsNull = so->skipIsNull;
+	if (so->skipIsNull)
+		so->markSkipValue = (Datum) 0;
+	else
+	{
+		MemoryContext oldContext = MemoryContextSwitchTo(so->skipContext);
+
+		so->markSkipValue = datumCopy(so->skipValue,
+									  attr->attbyval, attr->attlen);
+		MemoryContextSwitchTo(oldContext);
+	}
+}
+
+/*
+ * _bt_restore_skip_scan() -- Handle skip scan groups during btrestrpos
+ *
+ * Restore the skip group that was current when the mark was set, and redo
+ * _bt_preprocess_keys for it.
+ */
+void
+_bt_restore_skip_scan(IndexScanDesc scan)
+{
+	BTScanOpaque so = (BTScanOpaque) scan->opaque;
+
+	_bt_skip_set_group(scan, so->markSkipIsNull, so->markSkipValue);
+	_bt_skip_group_keys(scan);
+	_bt_preprocess_keys(scan);
+	/* The mark should have been set on a consistent set of keys... */
+	Assert(so->qual_ok);
+}
+
+
 /*
  *	_bt_preprocess_keys() -- Preprocess scan keys
  *
@@ -760,17 +1085,23 @@ _bt_preprocess_keys(IndexScanDesc scan)
 	so->qual_ok = true;
 	so->numberOfKeys = 0;
 
-	if (numberOfKeys < 1)
-		return;					/* done if qual-less scan */
-
 	/*
-	 * Read so->arrayKeyData if array keys are present, else scan->keyData
+	 * Read so->skipKeyData during a skip scan, else so->arrayKeyData if array
+	 * keys are present, else scan->keyData
 	 */
-	if (so->arrayKeyData != NULL)
+	if (so->skipScan)
+	{
+		inkeys = so->skipKeyData;
+		numberOfKeys = so->numSkipKeys;
+	}
+	else if (so->arrayKeyData != NULL)
 		inkeys = so->arrayKeyData;
 	else
 		inkeys = scan->keyData;
 
+	if (numberOfKeys < 1)
+		return;					/* done if qual-less scan */
+
 	outkeys = so->keyData;
 	cur = &inkeys[0];
 	/* we check that input keys are correctly ordered */
@@ -1731,7 +2062,13 @@ _bt_check_rowcompare(ScanKey skey, IndexTuple tuple, TupleDesc tupdesc,
  * the page, and so there is no need to search left from the recorded offset.
  * (This observation also guarantees that the item is still the right one
  * to delete, which might otherwise be questionable since heap TIDs can get
- * recycled.)
+ * recycled.)  Items may also have moved left if the page was deduplicated
+ * meanwhile; we just fail to find those.
+ *
+ * A posting list tuple can only be marked LP_DEAD once all of its heap TIDs
+ * have been killed.  The items for one posting list tuple are adjacent in
+ * currPos.items[], so we sort the killed item indexes to bring them
+ * together.
  */
 void
 _bt_killitems(IndexScanDesc scan, bool haveLock)
@@ -1742,6 +2079,7 @@ _bt_killitems(IndexScanDesc scan, bool haveLock)
 	OffsetNumber minoff;
 	OffsetNumber maxoff;
 	int			i;
+	int			numKilled;
 	bool		killedsomething = false;
 
 	Assert(BufferIsValid(so->currPos.buf));
@@ -1754,7 +2092,22 @@ _bt_killitems(IndexScanDesc scan, bool haveLock)
 	minoff = P_FIRSTDATAKEY(opaque);
 	maxoff = PageGetMaxOffsetNumber(page);
 
-	for (i = 0; i < so->numKilled; i++)
+	/* sort the killed items, and get rid of any duplicate entries */
+	numKilled = so->numKilled;
+	if (numKilled > 1)
+	{
+		int			j = 0;
+
+		qsort(so->killedItems, numKilled, sizeof(int), _bt_compare_int);
+		for (i = 1; i < numKilled; i++)
+		{
+			if (so->killedItems[i] != so->killedItems[j])
+				so->killedItems[++j] = so->killedItems[i];
+		}
+		numKilled = j + 1;
+	}
+
+	for (i = 0; i < numKilled; i++)
 	{
 		int			itemIndex = so->killedItems[i];
 		BTScanPosItem *kitem = &so->currPos.items[itemIndex];
@@ -1769,6 +2122,39 @@ _bt_killitems(IndexScanDesc scan, bool haveLock)
 			ItemId		iid = PageGetItemId(page, offnum);
 			IndexTuple	ituple = (IndexTuple) PageGetItem(page, iid);
 
+			if (BTreeTupleIsPosting(ituple))
+			{
+				int			nkilled = 0;
+
+				if (!_bt_posting_contains(ituple, &kitem->heapTid))
+				{
+					offnum = OffsetNumberNext(offnum);
+					continue;
+				}
+
+				/*
+				 * Found the tuple.  Count the killed items that belong to it,
+				 * and skip over them in the outer loop.
+				 */
+				while (i + 1 < numKilled)
+				{
+					BTScanPosItem *nitem;
+
+					nitem = &so->currPos.items[so->killedItems[i + 1]];
+					if (nitem->indexOffset != kitem->indexOffset ||
+						!_bt_posting_contains(ituple, &nitem->heapTid))
+						break;
+					nkilled++;
+					i++;
+				}
+				if (nkilled + 1 == BTreeTupleGetNPosting(ituple))
+				{
+					ItemIdMarkDead(iid);
+					killedsomething = true;
+				}
+				break;			/* out of inner search loop */
+			}
+
 			if (ItemPointerEquals(&ituple->t_tid, &kitem->heapTid))
 			{
 				/* found the item */
@@ -1802,6 +2188,22 @@ _bt_killitems(IndexScanDesc scan, bool haveLock)
 	so->numKilled = 0;
 }
 
+/*
+ * qsort comparator for killed item indexes
+ */
+static int
+_bt_compare_int(const void *a, const void *b)
+{
+	int			av = *(const int *) a;
+	int			bv = *(const int *) b;
+
+	if (av < bv)
+		return -1;
+	if (av > bv)
+		return 1;
+	return 0;
+}
+
 
 /*
  * The following routines manage a shared-memory area in which we track
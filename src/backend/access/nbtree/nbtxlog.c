@@ -258,7 +258,7 @@ btree_xlog_split(bool onleft, bool isroot,
 	}
 
 	/* Extract left hikey and its size (still assuming 16-bit alignment) */
-	if (!isleaf && !(record->xl_info & XLR_BKP_BLOCK(0)))
+	if (!(record->xl_info & XLR_BKP_BLOCK(0)))
 	{
 		left_hikey = (Item) datapos;
 		left_hikeysz = MAXALIGN(IndexTupleSize(left_hikey));
@@ -305,23 +305,9 @@ btree_xlog_split(bool onleft, bool isroot,
 
 	_bt_restore_page(rpage, datapos, datalen);
 
-	/*
-	 * On leaf level, the high key of the left page is equal to the first key
-	 * on the right page.
-	 */
-	if (isleaf)
-	{
-		ItemId		hiItemId = PageGetItemId(rpage, P_FIRSTDATAKEY(ropaque));
-
-		left_hikey = PageGetItem(rpage, hiItemId);
-		left_hikeysz = ItemIdGetLength(hiItemId);
-	}
-
 	PageSetLSN(rpage, lsn);
 	MarkBufferDirty(rbuf);
 
-	/* don't release the buffer yet; we touch right page's first item below */
-
 	/* Now reconstruct left (original) sibling page */
 	if (record->xl_info & XLR_BKP_BLOCK(0))
 		lbuf = RestoreBackupBlock(lsn, record, 0, false, true);
@@ -531,13 +517,36 @@ btree_xlog_vacuum(XLogRecPtr lsn, XLogRecord *record)
 	if (record->xl_len > SizeOfBtreeVacuum)
 	{
 		OffsetNumber *unused;
-		OffsetNumber *unend;
+		OffsetNumber *updated;
+		char	   *tuples;
+		int			i;
 
 		unused = (OffsetNumber *) ((char *) xlrec + SizeOfBtreeVacuum);
-		unend = (OffsetNumber *) ((char *) xlrec + record->xl_len);
+		updated = unused + xlrec->ndeleted;
+		tuples = (char *) (updated + xlrec->nupdated);
+
+		/*
+		 * Replace the shrunken posting list tuples first, since the offsets
+		 * refer to the page as it was before any deletions.
+		 */
+		for (i = 0; i < xlrec->nupdated; i++)
+		{
+			IndexTupleData itupdata;
+			Size		itemsz;
+
+			/* Need to copy tuple header due to alignment considerations */
+			memcpy(&itupdata, tuples, sizeof(IndexTupleData));
+			itemsz = MAXALIGN(IndexTupleDSize(itupdata));
+
+			PageIndexTupleDelete(page, updated[i]);
+			if (PageAddItem(page, (Item) tuples, itemsz, updated[i],
+							false, false) == InvalidOffsetNumber)
+				elog(PANIC, "btree_xlog_vacuum: failed to add updated item");
+			tuples += itemsz;
+		}
 
-		if ((unend - unused) > 0)
-			PageIndexMultiDelete(page, unused, unend - unused);
+		if (xlrec->ndeleted > 0)
+			PageIndexMultiDelete(page, unused, xlrec->ndeleted);
 	}
 
 	/*
@@ -578,7 +587,9 @@ btree_xlog_delete_get_latestRemovedXid(xl_btree_delete *xlrec)
 	BlockNumber hblkno;
 	OffsetNumber hoffnum;
 	TransactionId latestRemovedXid = InvalidTransactionId;
-	int			i;
+	int			i,
+				j,
+				nhtids;
 
 	/*
 	 * If there's nothing running on the standby we don't need to derive a
@@ -630,61 +641,76 @@ btree_xlog_delete_get_latestRemovedXid(xl_btree_delete *xlrec)
 		itup = (IndexTuple) PageGetItem(ipage, iitemid);
 
 		/*
-		 * Locate the heap page that the index tuple points at
+		 * A posting list tuple references several heap tuples; look at each
+		 * of them.
 		 */
-		hblkno = ItemPointerGetBlockNumber(&(itup->t_tid));
-		hbuffer = XLogReadBuffer(xlrec->hnode, hblkno, false);
-		if (!BufferIsValid(hbuffer))
+		nhtids = BTreeTupleGetNTIDs(itup);
+		for (j = 0; j < nhtids; j++)
 		{
-			UnlockReleaseBuffer(ibuffer);
-			return InvalidTransactionId;
-		}
-		hpage = (Page) BufferGetPage(hbuffer);
+			ItemPointer htid;
 
-		/*
-		 * Look up the heap tuple header that the index tuple points at by
-		 * using the heap node supplied with the xlrec. We can't use
-		 * heap_fetch, since it uses ReadBuffer rather than XLogReadBuffer.
-		 * Note that we are not looking at tuple data here, just headers.
-		 */
-		hoffnum = ItemPointerGetOffsetNumber(&(itup->t_tid));
-		hitemid = PageGetItemId(hpage, hoffnum);
+			htid = BTreeTupleIsPosting(itup) ?
+				BTreeTupleGetPostingN(itup, j) : &(itup->t_tid);
 
-		/*
-		 * Follow any redirections until we find something useful.
-		 */
-		while (ItemIdIsRedirected(hitemid))
-		{
-			hoffnum = ItemIdGetRedirect(hitemid);
+			/*
+			 * Locate the heap page that the index tuple points at
+			 */
+			hblkno = ItemPointerGetBlockNumber(htid);
+			hbuffer = XLogReadBuffer(xlrec->hnode, hblkno, false);
+			if (!BufferIsValid(hbuffer))
+			{
+				UnlockReleaseBuffer(ibuffer);
+				return InvalidTransactionId;
+			}
+			hpage = (Page) BufferGetPage(hbuffer);
+
+			/*
+			 * Look up the heap tuple header that the index tuple points at
+			 * by using the heap node supplied with the xlrec. We can't use
+			 * heap_fetch, since it uses ReadBuffer rather than
+			 * XLogReadBuffer. Note that we are not looking at tuple data
+			 * here, just headers.
+			 */
+			hoffnum = ItemPointerGetOffsetNumber(htid);
 			hitemid = PageGetItemId(hpage, hoffnum);
-			CHECK_FOR_INTERRUPTS();
-		}
 
-		/*
-		 * If the heap item has storage, then read the header and use that to
-		 * set latestRemovedXid.
-		 *
-		 * Some LP_DEAD items may not be accessible, so we ignore them.
-		 */
-		if (ItemIdHasStorage(hitemid))
-		{
-			htuphdr = (HeapTupleHeader) PageGetItem(hpage, hitemid);
+			/*
+			 * Follow any redirections until we find something useful.
+			 */
+			while (ItemIdIsRedirected(hitemid))
+			{
+				hoffnum = ItemIdGetRedirect(hitemid);
+				hitemid = PageGetItemId(hpage, hoffnum);
+				CHECK_FOR_INTERRUPTS();
+			}
 
-			HeapTupleHeaderAdvanceLatestRemovedXid(htuphdr, &latestRemovedXid);
-		}
-		else if (ItemIdIsDead(hitemid))
-		{
 			/*
-			 * Conjecture: if hitemid is dead then it had xids before the xids
-			 * marked on LP_NORMAL items. So we just ignore this item and move
-			 * onto the next, for the purposes of calculating
-			 * latestRemovedxids.
+			 * If the heap item has storage, then read the header and use
+			 * that to set latestRemovedXid.
+			 *
+			 * Some LP_DEAD items may not be accessible, so we ignore them.
 			 */
-		}
-		else
-			Assert(!ItemIdIsUsed(hitemid));
+			if (ItemIdHasStorage(hitemid))
+			{
+				htuphdr = (HeapTupleHeader) PageGetItem(hpage, hitemid);
 
-		UnlockReleaseBuffer(hbuffer);
+				HeapTupleHeaderAdvanceLatestRemovedXid(htuphdr,
+													   &latestRemovedXid);
+			}
+			else if (ItemIdIsDead(hitemid))
+			{
+				/*
+				 * Conjecture: if hitemid is dead then it had xids before the
+				 * xids marked on LP_NORMAL items. So we just ignore this item
+				 * and move onto the next, for the purposes of calculating
+				 * latestRemovedxids.
+				 */
+			}
+			else
+				Assert(!ItemIdIsUsed(hitemid));
+
+			UnlockReleaseBuffer(hbuffer);
+		}
 	}
 
 	UnlockReleaseBuffer(ibuffer);
@@ -815,7 +841,7 @@ btree_xlog_mark_page_halfdead(uint8 info, XLogRecPtr lsn, XLogRecord *record)
 
 				itemid = PageGetItemId(page, poffset);
 				itup = (IndexTuple) PageGetItem(page, itemid);
-				ItemPointerSet(&(itup->t_tid), rightsib, P_HIKEY);
+				BTreeInnerTupleSetDownLink(itup, rightsib);
 				nextoffset = OffsetNumberNext(poffset);
 				PageIndexTupleDelete(page, nextoffset);
 
@@ -114,6 +114,8 @@ heap_desc(StringInfo buf, uint8 xl_info, char *rec)
 		out_target(buf, &(xlrec->target));
 		appendStringInfoChar(buf, ' ');
 		out_infobits(buf, xlrec->infobits_set);
+		if (xlrec->flags & XLH_LOCK_ALL_FROZEN_CLEARED)
+			appendStringInfoString(buf, "ALL_FROZEN_CLEARED ");
 	}
 	else if (info == XLOG_HEAP_INPLACE)
 	{
@@ -164,9 +166,10 @@ heap2_desc(StringInfo buf, uint8 xl_info, char *rec)
 	{
 		xl_heap_visible *xlrec = (xl_heap_visible *) rec;
 
-		appendStringInfo(buf, "visible: rel %u/%u/%u; blk %u",
+		appendStringInfo(buf, "visible: rel %u/%u/%u; blk %u; cutoff xid %u flags %02x",
 						 xlrec->node.spcNode, xlrec->node.dbNode,
-						 xlrec->node.relNode, xlrec->block);
+						 xlrec->node.relNode, xlrec->block,
+						 xlrec->cutoff_xid, xlrec->flags);
 	}
 	else if (info == XLOG_HEAP2_MULTI_INSERT)
 	{
@@ -184,8 +187,8 @@ heap2_desc(StringInfo buf, uint8 xl_info, char *rec)
 	{
 		xl_heap_lock_updated *xlrec = (xl_heap_lock_updated *) rec;
 
-		appendStringInfo(buf, "lock updated: xmax %u msk %04x; ", xlrec->xmax,
-						 xlrec->infobits_set);
+		appendStringInfo(buf, "lock updated: xmax %u msk %04x flags %02x; ",
+						 xlrec->xmax, xlrec->infobits_set, xlrec->flags);
 		out_target(buf, &(xlrec->target));
 	}
 	else if (info == XLOG_HEAP2_NEW_CID)
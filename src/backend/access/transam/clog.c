@@ -76,6 +76,9 @@ static SlruCtlData ClogCtlData;
 
 #define ClogCtl (&ClogCtlData)
 
+/* GUC parameter: number of CLOG buffers, or 0 to size automatically */
+int			transaction_buffers = 0;
+
 
 static int	ZeroCLOGPage(int pageno, bool writeXlog);
 static bool CLOGPagePrecedes(int page1, int page2);
@@ -252,6 +255,7 @@ TransactionIdSetPageStatus(TransactionId xid, int nsubxids,
 						   TransactionId *subxids, XidStatus status,
 						   XLogRecPtr lsn, int pageno)
 {
+	LWLock	   *lock = SimpleLruGetBankLock(ClogCtl, pageno);
 	int			slotno;
 	int			i;
 
@@ -259,7 +263,7 @@ TransactionIdSetPageStatus(TransactionId xid, int nsubxids,
 		   status == TRANSACTION_STATUS_ABORTED ||
 		   (status == TRANSACTION_STATUS_SUB_COMMITTED && !TransactionIdIsValid(xid)));
 
-	LWLockAcquire(CLogControlLock, LW_EXCLUSIVE);
+	LWLockAcquire(lock, LW_EXCLUSIVE);
 
 	/*
 	 * If we're doing an async commit (ie, lsn is valid), then we must wait
@@ -308,13 +312,13 @@ TransactionIdSetPageStatus(TransactionId xid, int nsubxids,
 
 	ClogCtl->shared->page_dirty[slotno] = true;
 
-	LWLockRelease(CLogControlLock);
+	LWLockRelease(lock);
 }
 
 /*
  * Sets the commit status of a single transaction.
  *
- * Must be called with CLogControlLock held
+ * Must be called with the bank lock of the transaction's page held
  */
 static void
 TransactionIdSetStatusBit(TransactionId xid, XidStatus status, XLogRecPtr lsn, int slotno)
@@ -406,7 +410,7 @@ TransactionIdGetStatus(TransactionId xid, XLogRecPtr *lsn)
 	lsnindex = GetLSNIndex(slotno, xid);
 	*lsn = ClogCtl->shared->group_lsn[lsnindex];
 
-	LWLockRelease(CLogControlLock);
+	LWLockRelease(SimpleLruGetBankLock(ClogCtl, pageno));
 
 	return status;
 }
@@ -428,16 +432,19 @@ TransactionIdGetStatus(TransactionId xid, XLogRecPtr *lsn)
  * compromise: people with very low values for shared_buffers will get fewer
  * CLOG buffers as well, and everyone else will get 32.
  *
- * It is likely that some further work will be needed here in future releases;
- * for example, on a 64-core server, the maximum number of CLOG requests that
- * can be simultaneously in flight will be even larger.  But that will
- * apparently require more than just changing the formula, so for now we take
- * the easy way out.
+ * On a 64-core server, the maximum number of CLOG requests that can be
+ * simultaneously in flight is even larger.  Now that the buffers are split
+ * into banks that are searched and locked independently, a larger pool no
+ * longer slows down lookups, so the size can be set with transaction_buffers.
+ * If it is left at zero, we use one buffer per 512 shared buffers, between
+ * SLRU_MIN_BUFFERS and 1024.
  */
 Size
 CLOGShmemBuffers(void)
 {
-	return Min(32, Max(4, NBuffers / 512));
+	if (transaction_buffers == 0)
+		return SimpleLruAutotuneBuffers(512, 1024);
+	return transaction_buffers;
 }
 
 /*
@@ -454,7 +461,7 @@ CLOGShmemInit(void)
 {
 	ClogCtl->PagePrecedes = CLOGPagePrecedes;
 	SimpleLruInit(ClogCtl, "CLOG Ctl", CLOGShmemBuffers(), CLOG_LSNS_PER_PAGE,
-				  CLogControlLock, "pg_clog");
+				  NULL, "pg_clog");
 }
 
 /*
@@ -466,9 +473,10 @@ CLOGShmemInit(void)
 void
 BootStrapCLOG(void)
 {
+	LWLock	   *lock = SimpleLruGetBankLock(ClogCtl, 0);
 	int			slotno;
 
-	LWLockAcquire(CLogControlLock, LW_EXCLUSIVE);
+	LWLockAcquire(lock, LW_EXCLUSIVE);
 
 	/* Create and zero the first page of the commit log */
 	slotno = ZeroCLOGPage(0, false);
@@ -477,7 +485,7 @@ BootStrapCLOG(void)
 	SimpleLruWritePage(ClogCtl, slotno);
 	Assert(!ClogCtl->shared->page_dirty[slotno]);
 
-	LWLockRelease(CLogControlLock);
+	LWLockRelease(lock);
 }
 
 /*
@@ -487,7 +495,7 @@ BootStrapCLOG(void)
  * The page is not actually written, just set up in shared memory.
  * The slot number of the new page is returned.
  *
- * Control lock must be held at entry, and will be held at exit.
+ * The bank lock of the page must be held at entry, and will be held at exit.
  */
 static int
 ZeroCLOGPage(int pageno, bool writeXlog)
@@ -512,14 +520,10 @@ StartupCLOG(void)
 	TransactionId xid = ShmemVariableCache->nextXid;
 	int			pageno = TransactionIdToPage(xid);
 
-	LWLockAcquire(CLogControlLock, LW_EXCLUSIVE);
-
 	/*
 	 * Initialize our idea of the latest page number.
 	 */
 	ClogCtl->shared->latest_page_number = pageno;
-
-	LWLockRelease(CLogControlLock);
 }
 
 /*
@@ -530,8 +534,9 @@ TrimCLOG(void)
 {
 	TransactionId xid = ShmemVariableCache->nextXid;
 	int			pageno = TransactionIdToPage(xid);
+	LWLock	   *lock = SimpleLruGetBankLock(ClogCtl, pageno);
 
-	LWLockAcquire(CLogControlLock, LW_EXCLUSIVE);
+	LWLockAcquire(lock, LW_EXCLUSIVE);
 
 	/*
 	 * Re-Initialize our idea of the latest page number.
@@ -568,7 +573,7 @@ TrimCLOG(void)
 		ClogCtl->shared->page_dirty[slotno] = true;
 	}
 
-	LWLockRelease(CLogControlLock);
+	LWLockRelease(lock);
 }
 
 /*
@@ -608,6 +613,7 @@ void
 ExtendCLOG(TransactionId newestXact)
 {
 	int			pageno;
+	LWLock	   *lock;
 
 	/*
 	 * No work except at first XID of a page.  But beware: just after
@@ -618,13 +624,14 @@ ExtendCLOG(TransactionId newestXact)
 		return;
 
 	pageno = TransactionIdToPage(newestXact);
+	lock = SimpleLruGetBankLock(ClogCtl, pageno);
 
-	LWLockAcquire(CLogControlLock, LW_EXCLUSIVE);
+	LWLockAcquire(lock, LW_EXCLUSIVE);
 
 	/* Zero the page and make an XLOG entry about it */
 	ZeroCLOGPage(pageno, true);
 
-	LWLockRelease(CLogControlLock);
+	LWLockRelease(lock);
 }
 
 
@@ -740,16 +747,18 @@ clog_redo(XLogRecPtr lsn, XLogRecord *record)
 	{
 		int			pageno;
 		int			slotno;
+		LWLock	   *lock;
 
 		memcpy(&pageno, XLogRecGetData(record), sizeof(int));
 
-		LWLockAcquire(CLogControlLock, LW_EXCLUSIVE);
+		lock = SimpleLruGetBankLock(ClogCtl, pageno);
+		LWLockAcquire(lock, LW_EXCLUSIVE);
 
 		slotno = ZeroCLOGPage(pageno, false);
 		SimpleLruWritePage(ClogCtl, slotno);
 		Assert(!ClogCtl->shared->page_dirty[slotno]);
 
-		LWLockRelease(CLogControlLock);
+		LWLockRelease(lock);
 	}
 	else if (info == CLOG_TRUNCATE)
 	{
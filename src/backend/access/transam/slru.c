@@ -7,30 +7,42 @@
  * buffers.  Under ordinary circumstances we expect that write
  * traffic will occur mostly to the latest page (and to the just-prior
  * page, soon after a page transition).  Read traffic will probably touch
- * a larger span of pages, but in any case a fairly small number of page
- * buffers should be sufficient.  So, we just search the buffers using plain
- * linear search; there's no need for a hashtable or anything fancy.
- * The management algorithm is straight LRU except that we will never swap
- * out the latest page (since we know it's going to be hit again eventually).
+ * a larger span of pages, and with long-running transactions or heavy use
+ * of multixacts the working set can be large, so the number of buffers of
+ * the busiest SLRUs is configurable.
  *
- * We use a control LWLock to protect the shared data structures, plus
- * per-buffer LWLocks that synchronize I/O for each buffer.  The control lock
- * must be held to examine or modify any shared state.	A process that is
- * reading in or writing out a page buffer does not hold the control lock,
- * only the per-buffer lock for the buffer it is working on.
+ * To keep lookups cheap however many buffers there are, the buffers are
+ * divided into banks of SLRU_BANK_SIZE buffers, and a page can only be
+ * stored in the bank selected by its page number.  Finding a page, or a
+ * victim buffer for it, is then a plain linear search of one bank; there's
+ * no need for a hashtable or anything fancy.  The management algorithm
+ * within a bank is straight LRU except that we will never swap out the
+ * latest page (since we know it's going to be hit again eventually).
  *
- * "Holding the control lock" means exclusive lock in all cases except for
+ * Each bank has an LWLock protecting its part of the shared data
+ * structures, plus there are per-buffer LWLocks that synchronize I/O for
+ * each buffer.  The bank lock must be held to examine or modify any shared
+ * state of the bank's buffers; callers get it with SimpleLruGetBankLock().
+ * Since pages in different banks are protected by different locks,
+ * processes working on different pages don't usually contend with each
+ * other.  An SLRU whose callers need to hold a lock across accesses to
+ * several pages can instead supply a single control lock, which then
+ * serves as the lock of every bank.  A process that is reading in
+ * or writing out a page buffer does not hold the bank lock, only the
+ * per-buffer lock for the buffer it is working on.
+ *
+ * "Holding the bank lock" means exclusive lock in all cases except for
  * SimpleLruReadPage_ReadOnly(); see comments for SlruRecentlyUsed() for
  * the implications of that.
  *
  * When initiating I/O on a buffer, we acquire the per-buffer lock exclusively
- * before releasing the control lock.  The per-buffer lock is released after
- * completing the I/O, re-acquiring the control lock, and updating the shared
+ * before releasing the bank lock.  The per-buffer lock is released after
+ * completing the I/O, re-acquiring the bank lock, and updating the shared
  * state.  (Deadlock is not possible here, because we never try to initiate
  * I/O when someone else is already doing I/O on the same buffer.)
- * To wait for I/O to complete, release the control lock, acquire the
+ * To wait for I/O to complete, release the bank lock, acquire the
  * per-buffer lock in shared mode, immediately release the per-buffer lock,
- * reacquire the control lock, and then recheck state (since arbitrary things
+ * reacquire the bank lock, and then recheck state (since arbitrary things
  * could have happened while we didn't have the lock).
  *
  * As with the regular buffer manager, it is possible for another process
@@ -80,19 +92,30 @@ typedef struct SlruFlushData
 
 typedef struct SlruFlushData *SlruFlush;
 
+/* The lock protecting a buffer slot */
+#define SlotBankLock(shared, slotno) \
+	((shared)->bank_locks[(slotno) / (shared)->bank_size])
+
 /*
  * Macro to mark a buffer slot "most recently used".  Note multiple evaluation
  * of arguments!
  *
+ * We mark a page "most recently used" by setting
+ *		page_lru_count[slotno] = ++bank_cur_lru_count[bankno];
+ * The oldest page of a bank is therefore the one with the highest value of
+ *		bank_cur_lru_count[bankno] - page_lru_count[slotno]
+ * The counts will eventually wrap around, but this calculation still works
+ * as long as no page's age exceeds INT_MAX counts.
+ *
  * The reason for the if-test is that there are often many consecutive
  * accesses to the same page (particularly the latest page).  By suppressing
- * useless increments of cur_lru_count, we reduce the probability that old
+ * useless increments of the counter, we reduce the probability that old
  * pages' counts will "wrap around" and make them appear recently used.
  *
  * We allow this code to be executed concurrently by multiple processes within
  * SimpleLruReadPage_ReadOnly().  As long as int reads and writes are atomic,
  * this should not cause any completely-bogus values to enter the computation.
- * However, it is possible for either cur_lru_count or individual
+ * However, it is possible for either the bank's counter or individual
  * page_lru_count entries to be "reset" to lower values than they should have,
  * in case a process is delayed while it executes this macro.  With care in
  * SlruSelectLRUPage(), this does little harm, and in any case the absolute
@@ -101,9 +124,10 @@ typedef struct SlruFlushData *SlruFlush;
  */
 #define SlruRecentlyUsed(shared, slotno)	\
 	do { \
-		int		new_lru_count = (shared)->cur_lru_count; \
+		int		bankno = (slotno) / (shared)->bank_size; \
+		int		new_lru_count = (shared)->bank_cur_lru_count[bankno]; \
 		if (new_lru_count != (shared)->page_lru_count[slotno]) { \
-			(shared)->cur_lru_count = ++new_lru_count; \
+			(shared)->bank_cur_lru_count[bankno] = ++new_lru_count; \
 			(shared)->page_lru_count[slotno] = new_lru_count; \
 		} \
 	} while (0)
@@ -142,10 +166,13 @@ static bool SlruScanDirCbDeleteCutoff(SlruCtl ctl, char *filename,
 Size
 SimpleLruShmemSize(int nslots, int nlsns)
 {
+	int			nbanks = Max(1, nslots / SLRU_BANK_SIZE);
 	Size		sz;
 
 	/* we assume nslots isn't so large as to risk overflow */
 	sz = MAXALIGN(sizeof(SlruSharedData));
+	sz += MAXALIGN(nbanks * sizeof(LWLock *));	/* bank_locks[] */
+	sz += MAXALIGN(nbanks * sizeof(int));		/* bank_cur_lru_count[] */
 	sz += MAXALIGN(nslots * sizeof(char *));	/* page_buffer[] */
 	sz += MAXALIGN(nslots * sizeof(SlruPageStatus));	/* page_status[] */
 	sz += MAXALIGN(nslots * sizeof(bool));		/* page_dirty[] */
@@ -159,6 +186,40 @@ SimpleLruShmemSize(int nslots, int nlsns)
 	return BUFFERALIGN(sz) + BLCKSZ * nslots;
 }
 
+/*
+ * Number of LWLocks SimpleLruInit will assign for an SLRU with nslots
+ * buffers, depending on whether it is called without a control lock
+ */
+int
+SimpleLruNumLWLocks(int nslots, bool banklocks)
+{
+	if (banklocks)
+		return nslots + Max(1, nslots / SLRU_BANK_SIZE);
+	return nslots;
+}
+
+/*
+ * Default number of buffers for an SLRU whose size is set automatically:
+ * one for every divisor shared buffers, but at most max, rounded down to a
+ * whole number of banks.
+ */
+int
+SimpleLruAutotuneBuffers(int divisor, int max)
+{
+	int			nbuffers;
+
+	nbuffers = Min(max, Max(SLRU_MIN_BUFFERS, NBuffers / divisor));
+
+	return nbuffers - nbuffers % SLRU_BANK_SIZE;
+}
+
+/*
+ * Initialize an SLRU.
+ *
+ * If nslots is a multiple of SLRU_BANK_SIZE, the buffers are divided into
+ * banks of that size; otherwise they form a single bank.  If ctllock is NULL,
+ * each bank gets a lock of its own; otherwise ctllock protects all of them.
+ */
 void
 SimpleLruInit(SlruCtl ctl, const char *name, int nslots, int nlsns,
 			  LWLock *ctllock, const char *subdir)
@@ -176,22 +237,34 @@ SimpleLruInit(SlruCtl ctl, const char *name, int nslots, int nlsns,
 		char	   *ptr;
 		Size		offset;
 		int			slotno;
+		int			bankno;
 
 		Assert(!found);
 
 		memset(shared, 0, sizeof(SlruSharedData));
 
-		shared->ControlLock = ctllock;
-
 		shared->num_slots = nslots;
 		shared->lsn_groups_per_page = nlsns;
 
-		shared->cur_lru_count = 0;
+		if (nslots % SLRU_BANK_SIZE == 0)
+		{
+			shared->num_banks = nslots / SLRU_BANK_SIZE;
+			shared->bank_size = SLRU_BANK_SIZE;
+		}
+		else
+		{
+			shared->num_banks = 1;
+			shared->bank_size = nslots;
+		}
 
 		/* shared->latest_page_number will be set later */
 
 		ptr = (char *) shared;
 		offset = MAXALIGN(sizeof(SlruSharedData));
+		shared->bank_locks = (LWLock **) (ptr + offset);
+		offset += MAXALIGN(shared->num_banks * sizeof(LWLock *));
+		shared->bank_cur_lru_count = (int *) (ptr + offset);
+		offset += MAXALIGN(shared->num_banks * sizeof(int));
 		shared->page_buffer = (char **) (ptr + offset);
 		offset += MAXALIGN(nslots * sizeof(char *));
 		shared->page_status = (SlruPageStatus *) (ptr + offset);
@@ -211,6 +284,12 @@ SimpleLruInit(SlruCtl ctl, const char *name, int nslots, int nlsns,
 			offset += MAXALIGN(nslots * nlsns * sizeof(XLogRecPtr));
 		}
 
+		for (bankno = 0; bankno < shared->num_banks; bankno++)
+		{
+			shared->bank_locks[bankno] = ctllock ? ctllock : LWLockAssign();
+			shared->bank_cur_lru_count[bankno] = 0;
+		}
+
 		ptr += BUFFERALIGN(offset);
 		for (slotno = 0; slotno < nslots; slotno++)
 		{
@@ -240,7 +319,7 @@ SimpleLruInit(SlruCtl ctl, const char *name, int nslots, int nlsns,
  * The page is not actually written, just set up in shared memory.
  * The slot number of the new page is returned.
  *
- * Control lock must be held at entry, and will be held at exit.
+ * The bank lock of the page must be held at entry, and will be held at exit.
  */
 int
 SimpleLruZeroPage(SlruCtl ctl, int pageno)
@@ -298,18 +377,19 @@ SimpleLruZeroLSNs(SlruCtl ctl, int slotno)
  * guarantee that new I/O hasn't been started before we return, though.
  * In fact the slot might not even contain the same page anymore.)
  *
- * Control lock must be held at entry, and will be held at exit.
+ * The bank lock of the page must be held at entry, and will be held at exit.
  */
 static void
 SimpleLruWaitIO(SlruCtl ctl, int slotno)
 {
 	SlruShared	shared = ctl->shared;
+	LWLock	   *banklock = SlotBankLock(shared, slotno);
 
 	/* See notes at top of file */
-	LWLockRelease(shared->ControlLock);
+	LWLockRelease(banklock);
 	LWLockAcquire(shared->buffer_locks[slotno], LW_SHARED);
 	LWLockRelease(shared->buffer_locks[slotno]);
-	LWLockAcquire(shared->ControlLock, LW_EXCLUSIVE);
+	LWLockAcquire(banklock, LW_EXCLUSIVE);
 
 	/*
 	 * If the slot is still in an io-in-progress state, then either someone
@@ -352,7 +432,7 @@ SimpleLruWaitIO(SlruCtl ctl, int slotno)
  * Return value is the shared-buffer slot number now holding the page.
  * The buffer's LRU access info is updated.
  *
- * Control lock must be held at entry, and will be held at exit.
+ * The bank lock of the page must be held at entry, and will be held at exit.
  */
 int
 SimpleLruReadPage(SlruCtl ctl, int pageno, bool write_ok,
@@ -403,8 +483,8 @@ SimpleLruReadPage(SlruCtl ctl, int pageno, bool write_ok,
 		/* Acquire per-buffer lock (cannot deadlock, see notes at top) */
 		LWLockAcquire(shared->buffer_locks[slotno], LW_EXCLUSIVE);
 
-		/* Release control lock while doing I/O */
-		LWLockRelease(shared->ControlLock);
+		/* Release bank lock while doing I/O */
+		LWLockRelease(SlotBankLock(shared, slotno));
 
 		/* Do the read */
 		ok = SlruPhysicalReadPage(ctl, pageno, slotno);
@@ -412,8 +492,8 @@ SimpleLruReadPage(SlruCtl ctl, int pageno, bool write_ok,
 		/* Set the LSNs for this newly read-in page to zero */
 		SimpleLruZeroLSNs(ctl, slotno);
 
-		/* Re-acquire control lock and update page state */
-		LWLockAcquire(shared->ControlLock, LW_EXCLUSIVE);
+		/* Re-acquire bank lock and update page state */
+		LWLockAcquire(SlotBankLock(shared, slotno), LW_EXCLUSIVE);
 
 		Assert(shared->page_number[slotno] == pageno &&
 			   shared->page_status[slotno] == SLRU_PAGE_READ_IN_PROGRESS &&
@@ -443,20 +523,23 @@ SimpleLruReadPage(SlruCtl ctl, int pageno, bool write_ok,
  * Return value is the shared-buffer slot number now holding the page.
  * The buffer's LRU access info is updated.
  *
- * Control lock must NOT be held at entry, but will be held at exit.
- * It is unspecified whether the lock will be shared or exclusive.
+ * The bank lock of the page must NOT be held at entry, but will be held at
+ * exit.  It is unspecified whether the lock will be shared or exclusive.
  */
 int
 SimpleLruReadPage_ReadOnly(SlruCtl ctl, int pageno, TransactionId xid)
 {
 	SlruShared	shared = ctl->shared;
+	LWLock	   *banklock = SimpleLruGetBankLock(ctl, pageno);
+	int			bankstart = (pageno % shared->num_banks) * shared->bank_size;
+	int			bankend = bankstart + shared->bank_size;
 	int			slotno;
 
 	/* Try to find the page while holding only shared lock */
-	LWLockAcquire(shared->ControlLock, LW_SHARED);
+	LWLockAcquire(banklock, LW_SHARED);
 
 	/* See if page is already in a buffer */
-	for (slotno = 0; slotno < shared->num_slots; slotno++)
+	for (slotno = bankstart; slotno < bankend; slotno++)
 	{
 		if (shared->page_number[slotno] == pageno &&
 			shared->page_status[slotno] != SLRU_PAGE_EMPTY &&
@@ -469,8 +552,8 @@ SimpleLruReadPage_ReadOnly(SlruCtl ctl, int pageno, TransactionId xid)
 	}
 
 	/* No luck, so switch to normal exclusive lock and do regular read */
-	LWLockRelease(shared->ControlLock);
-	LWLockAcquire(shared->ControlLock, LW_EXCLUSIVE);
+	LWLockRelease(banklock);
+	LWLockAcquire(banklock, LW_EXCLUSIVE);
 
 	return SimpleLruReadPage(ctl, pageno, true, xid);
 }
@@ -484,7 +567,7 @@ SimpleLruReadPage_ReadOnly(SlruCtl ctl, int pageno, TransactionId xid)
  * the write).	However, we *do* attempt a fresh write even if the page
  * is already being written; this is for checkpoints.
  *
- * Control lock must be held at entry, and will be held at exit.
+ * The bank lock of the page must be held at entry, and will be held at exit.
  */
 static void
 SlruInternalWritePage(SlruCtl ctl, int slotno, SlruFlush fdata)
@@ -519,8 +602,8 @@ SlruInternalWritePage(SlruCtl ctl, int slotno, SlruFlush fdata)
 	/* Acquire per-buffer lock (cannot deadlock, see notes at top) */
 	LWLockAcquire(shared->buffer_locks[slotno], LW_EXCLUSIVE);
 
-	/* Release control lock while doing I/O */
-	LWLockRelease(shared->ControlLock);
+	/* Release bank lock while doing I/O */
+	LWLockRelease(SlotBankLock(shared, slotno));
 
 	/* Do the write */
 	ok = SlruPhysicalWritePage(ctl, pageno, slotno, fdata);
@@ -534,8 +617,8 @@ SlruInternalWritePage(SlruCtl ctl, int slotno, SlruFlush fdata)
 			CloseTransientFile(fdata->fd[i]);
 	}
 
-	/* Re-acquire control lock and update page state */
-	LWLockAcquire(shared->ControlLock, LW_EXCLUSIVE);
+	/* Re-acquire bank lock and update page state */
+	LWLockAcquire(SlotBankLock(shared, slotno), LW_EXCLUSIVE);
 
 	Assert(shared->page_number[slotno] == pageno &&
 		   shared->page_status[slotno] == SLRU_PAGE_WRITE_IN_PROGRESS);
@@ -935,12 +1018,15 @@ SlruReportIOError(SlruCtl ctl, int pageno, TransactionId xid)
  * (could be any state except EMPTY), *or* a freeable slot (state EMPTY
  * or CLEAN).
  *
- * Control lock must be held at entry, and will be held at exit.
+ * The bank lock of the page must be held at entry, and will be held at exit.
  */
 static int
 SlruSelectLRUPage(SlruCtl ctl, int pageno)
 {
 	SlruShared	shared = ctl->shared;
+	int			bankno = pageno % shared->num_banks;
+	int			bankstart = bankno * shared->bank_size;
+	int			bankend = bankstart + shared->bank_size;
 
 	/* Outer loop handles restart after I/O */
 	for (;;)
@@ -954,8 +1040,8 @@ SlruSelectLRUPage(SlruCtl ctl, int pageno)
 		int			best_invalid_delta = -1;
 		int			best_invalid_page_number = 0;		/* keep compiler quiet */
 
-		/* See if page already has a buffer assigned */
-		for (slotno = 0; slotno < shared->num_slots; slotno++)
+		/* See if page already has a buffer assigned in its bank */
+		for (slotno = bankstart; slotno < bankend; slotno++)
 		{
 			if (shared->page_number[slotno] == pageno &&
 				shared->page_status[slotno] != SLRU_PAGE_EMPTY)
@@ -981,7 +1067,7 @@ SlruSelectLRUPage(SlruCtl ctl, int pageno)
 		 * acquire the same lru_count values.  In that case we break ties by
 		 * choosing the furthest-back page.
 		 *
-		 * Notice that this next line forcibly advances cur_lru_count to a
+		 * Notice that this next line forcibly advances the bank's counter to a
 		 * value that is certainly beyond any value that will be in the
 		 * page_lru_count array after the loop finishes.  This ensures that
 		 * the next execution of SlruRecentlyUsed will mark the page newly
@@ -989,8 +1075,8 @@ SlruSelectLRUPage(SlruCtl ctl, int pageno)
 		 * That gets us back on the path to having good data when there are
 		 * multiple pages with the same lru_count.
 		 */
-		cur_count = (shared->cur_lru_count)++;
-		for (slotno = 0; slotno < shared->num_slots; slotno++)
+		cur_count = (shared->bank_cur_lru_count[bankno])++;
+		for (slotno = bankstart; slotno < bankend; slotno++)
 		{
 			int			this_delta;
 			int			this_page_number;
@@ -1083,16 +1169,23 @@ SimpleLruFlush(SlruCtl ctl, bool checkpoint)
 	int			pageno = 0;
 	int			i;
 	bool		ok;
+	LWLock	   *banklock = NULL;
 
 	/*
-	 * Find and write dirty pages
+	 * Find and write dirty pages, locking one bank at a time
 	 */
 	fdata.num_files = 0;
 
-	LWLockAcquire(shared->ControlLock, LW_EXCLUSIVE);
-
 	for (slotno = 0; slotno < shared->num_slots; slotno++)
 	{
+		if (SlotBankLock(shared, slotno) != banklock)
+		{
+			if (banklock)
+				LWLockRelease(banklock);
+			banklock = SlotBankLock(shared, slotno);
+			LWLockAcquire(banklock, LW_EXCLUSIVE);
+		}
+
 		SlruInternalWritePage(ctl, slotno, &fdata);
 
 		/*
@@ -1106,7 +1199,8 @@ SimpleLruFlush(SlruCtl ctl, bool checkpoint)
 				!shared->page_dirty[slotno]));
 	}
 
-	LWLockRelease(shared->ControlLock);
+	if (banklock)
+		LWLockRelease(banklock);
 
 	/*
 	 * Now fsync and close any files that were open
@@ -1141,6 +1235,7 @@ void
 SimpleLruTruncate(SlruCtl ctl, int cutoffPage)
 {
 	SlruShared	shared = ctl->shared;
+	int			bankno;
 	int			slotno;
 
 	/*
@@ -1149,63 +1244,70 @@ SimpleLruTruncate(SlruCtl ctl, int cutoffPage)
 	cutoffPage -= cutoffPage % SLRU_PAGES_PER_SEGMENT;
 
 	/*
-	 * Scan shared memory and remove any pages preceding the cutoff page, to
-	 * ensure we won't rewrite them later.  (Since this is normally called in
-	 * or just after a checkpoint, any dirty pages should have been flushed
-	 * already ... we're just being extra careful here.)
-	 */
-	LWLockAcquire(shared->ControlLock, LW_EXCLUSIVE);
-
-restart:;
-
-	/*
-	 * While we are holding the lock, make an important safety check: the
-	 * planned cutoff point must be <= the current endpoint page. Otherwise we
-	 * have already wrapped around, and proceeding with the truncation would
-	 * risk removing the current segment.
+	 * Make an important safety check: the planned cutoff point must be <= the
+	 * current endpoint page. Otherwise we have already wrapped around, and
+	 * proceeding with the truncation would risk removing the current segment.
+	 * latest_page_number can be read without a lock, as it is only ever
+	 * advanced past pages that are still in use.
 	 */
 	if (ctl->PagePrecedes(shared->latest_page_number, cutoffPage))
 	{
-		LWLockRelease(shared->ControlLock);
 		ereport(LOG,
 		  (errmsg("could not truncate directory \"%s\": apparent wraparound",
 				  ctl->Dir)));
 		return;
 	}
 
-	for (slotno = 0; slotno < shared->num_slots; slotno++)
+	/*
+	 * Scan shared memory and remove any pages preceding the cutoff page, to
+	 * ensure we won't rewrite them later.  (Since this is normally called in
+	 * or just after a checkpoint, any dirty pages should have been flushed
+	 * already ... we're just being extra careful here.)  Each bank is
+	 * processed under its own lock.
+	 */
+	for (bankno = 0; bankno < shared->num_banks; bankno++)
 	{
-		if (shared->page_status[slotno] == SLRU_PAGE_EMPTY)
-			continue;
-		if (!ctl->PagePrecedes(shared->page_number[slotno], cutoffPage))
-			continue;
+		LWLock	   *banklock = shared->bank_locks[bankno];
+		int			bankstart = bankno * shared->bank_size;
+		int			bankend = bankstart + shared->bank_size;
 
-		/*
-		 * If page is clean, just change state to EMPTY (expected case).
-		 */
-		if (shared->page_status[slotno] == SLRU_PAGE_VALID &&
-			!shared->page_dirty[slotno])
+		LWLockAcquire(banklock, LW_EXCLUSIVE);
+
+restart:
+		for (slotno = bankstart; slotno < bankend; slotno++)
 		{
-			shared->page_status[slotno] = SLRU_PAGE_EMPTY;
-			continue;
+			if (shared->page_status[slotno] == SLRU_PAGE_EMPTY)
+				continue;
+			if (!ctl->PagePrecedes(shared->page_number[slotno], cutoffPage))
+				continue;
+
+			/*
+			 * If page is clean, just change state to EMPTY (expected case).
+			 */
+			if (shared->page_status[slotno] == SLRU_PAGE_VALID &&
+				!shared->page_dirty[slotno])
+			{
+				shared->page_status[slotno] = SLRU_PAGE_EMPTY;
+				continue;
+			}
+
+			/*
+			 * Hmm, we have (or may have) I/O operations acting on the page,
+			 * so we've got to wait for them to finish and then start again.
+			 * This is the same logic as in SlruSelectLRUPage.  (XXX if page
+			 * is dirty, wouldn't it be OK to just discard it without writing
+			 * it?  For now, keep the logic the same as it was.)
+			 */
+			if (shared->page_status[slotno] == SLRU_PAGE_VALID)
+				SlruInternalWritePage(ctl, slotno, NULL);
+			else
+				SimpleLruWaitIO(ctl, slotno);
+			goto restart;
 		}
 
-		/*
-		 * Hmm, we have (or may have) I/O operations acting on the page, so
-		 * we've got to wait for them to finish and then start again. This is
-		 * the same logic as in SlruSelectLRUPage.	(XXX if page is dirty,
-		 * wouldn't it be OK to just discard it without writing it?  For now,
-		 * keep the logic the same as it was.)
-		 */
-		if (shared->page_status[slotno] == SLRU_PAGE_VALID)
-			SlruInternalWritePage(ctl, slotno, NULL);
-		else
-			SimpleLruWaitIO(ctl, slotno);
-		goto restart;
+		LWLockRelease(banklock);
 	}
 
-	LWLockRelease(shared->ControlLock);
-
 	/* Now we can remove the old segment(s) */
 	(void) SlruScanDirectory(ctl, SlruScanDirCbDeleteCutoff, &cutoffPage);
 }
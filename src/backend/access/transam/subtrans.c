@@ -61,6 +61,9 @@ static SlruCtlData SubTransCtlData;
 
 #define SubTransCtl  (&SubTransCtlData)
 
+/* GUC parameter: number of SUBTRANS buffers, or 0 to size automatically */
+int			subtransaction_buffers = 0;
+
 
 static int	ZeroSUBTRANSPage(int pageno);
 static bool SubTransPagePrecedes(int page1, int page2);
@@ -77,11 +80,13 @@ SubTransSetParent(TransactionId xid, TransactionId parent, bool overwriteOK)
 	int			pageno = TransactionIdToPage(xid);
 	int			entryno = TransactionIdToEntry(xid);
 	int			slotno;
+	LWLock	   *lock;
 	TransactionId *ptr;
 
 	Assert(TransactionIdIsValid(parent));
 
-	LWLockAcquire(SubtransControlLock, LW_EXCLUSIVE);
+	lock = SimpleLruGetBankLock(SubTransCtl, pageno);
+	LWLockAcquire(lock, LW_EXCLUSIVE);
 
 	slotno = SimpleLruReadPage(SubTransCtl, pageno, true, xid);
 	ptr = (TransactionId *) SubTransCtl->shared->page_buffer[slotno];
@@ -95,7 +100,7 @@ SubTransSetParent(TransactionId xid, TransactionId parent, bool overwriteOK)
 
 	SubTransCtl->shared->page_dirty[slotno] = true;
 
-	LWLockRelease(SubtransControlLock);
+	LWLockRelease(lock);
 }
 
 /*
@@ -125,7 +130,7 @@ SubTransGetParent(TransactionId xid)
 
 	parent = *ptr;
 
-	LWLockRelease(SubtransControlLock);
+	LWLockRelease(SimpleLruGetBankLock(SubTransCtl, pageno));
 
 	return parent;
 }
@@ -165,21 +170,34 @@ SubTransGetTopmostTransaction(TransactionId xid)
 }
 
 
+/*
+ * Number of shared SUBTRANS buffers.
+ *
+ * Unless set with subtransaction_buffers, this is sized like the CLOG pool.
+ */
+Size
+SUBTRANSShmemBuffers(void)
+{
+	if (subtransaction_buffers == 0)
+		return SimpleLruAutotuneBuffers(512, 1024);
+	return subtransaction_buffers;
+}
+
 /*
  * Initialization of shared memory for SUBTRANS
  */
 Size
 SUBTRANSShmemSize(void)
 {
-	return SimpleLruShmemSize(NUM_SUBTRANS_BUFFERS, 0);
+	return SimpleLruShmemSize(SUBTRANSShmemBuffers(), 0);
 }
 
 void
 SUBTRANSShmemInit(void)
 {
 	SubTransCtl->PagePrecedes = SubTransPagePrecedes;
-	SimpleLruInit(SubTransCtl, "SUBTRANS Ctl", NUM_SUBTRANS_BUFFERS, 0,
-				  SubtransControlLock, "pg_subtrans");
+	SimpleLruInit(SubTransCtl, "SUBTRANS Ctl", SUBTRANSShmemBuffers(), 0,
+				  NULL, "pg_subtrans");
 	/* Override default assumption that writes should be fsync'd */
 	SubTransCtl->do_fsync = false;
 }
@@ -197,9 +215,10 @@ SUBTRANSShmemInit(void)
 void
 BootStrapSUBTRANS(void)
 {
+	LWLock	   *lock = SimpleLruGetBankLock(SubTransCtl, 0);
 	int			slotno;
 
-	LWLockAcquire(SubtransControlLock, LW_EXCLUSIVE);
+	LWLockAcquire(lock, LW_EXCLUSIVE);
 
 	/* Create and zero the first page of the subtrans log */
 	slotno = ZeroSUBTRANSPage(0);
@@ -208,7 +227,7 @@ BootStrapSUBTRANS(void)
 	SimpleLruWritePage(SubTransCtl, slotno);
 	Assert(!SubTransCtl->shared->page_dirty[slotno]);
 
-	LWLockRelease(SubtransControlLock);
+	LWLockRelease(lock);
 }
 
 /*
@@ -217,7 +236,7 @@ BootStrapSUBTRANS(void)
  * The page is not actually written, just set up in shared memory.
  * The slot number of the new page is returned.
  *
- * Control lock must be held at entry, and will be held at exit.
+ * The bank lock of the page must be held at entry, and will be held at exit.
  */
 static int
 ZeroSUBTRANSPage(int pageno)
@@ -237,6 +256,7 @@ StartupSUBTRANS(TransactionId oldestActiveXID)
 {
 	int			startPage;
 	int			endPage;
+	LWLock	   *lock;
 
 	/*
 	 * Since we don't expect pg_subtrans to be valid across crashes, we
@@ -244,19 +264,20 @@ StartupSUBTRANS(TransactionId oldestActiveXID)
 	 * Whenever we advance into a new page, ExtendSUBTRANS will likewise zero
 	 * the new page without regard to whatever was previously on disk.
 	 */
-	LWLockAcquire(SubtransControlLock, LW_EXCLUSIVE);
-
 	startPage = TransactionIdToPage(oldestActiveXID);
 	endPage = TransactionIdToPage(ShmemVariableCache->nextXid);
 
-	while (startPage != endPage)
+	for (;;)
 	{
+		lock = SimpleLruGetBankLock(SubTransCtl, startPage);
+		LWLockAcquire(lock, LW_EXCLUSIVE);
 		(void) ZeroSUBTRANSPage(startPage);
+		LWLockRelease(lock);
+
+		if (startPage == endPage)
+			break;
 		startPage++;
 	}
-	(void) ZeroSUBTRANSPage(startPage);
-
-	LWLockRelease(SubtransControlLock);
 }
 
 /*
@@ -307,6 +328,7 @@ void
 ExtendSUBTRANS(TransactionId newestXact)
 {
 	int			pageno;
+	LWLock	   *lock;
 
 	/*
 	 * No work except at first XID of a page.  But beware: just after
@@ -317,13 +339,14 @@ ExtendSUBTRANS(TransactionId newestXact)
 		return;
 
 	pageno = TransactionIdToPage(newestXact);
+	lock = SimpleLruGetBankLock(SubTransCtl, pageno);
 
-	LWLockAcquire(SubtransControlLock, LW_EXCLUSIVE);
+	LWLockAcquire(lock, LW_EXCLUSIVE);
 
 	/* Zero the page */
 	ZeroSUBTRANSPage(pageno);
 
-	LWLockRelease(SubtransControlLock);
+	LWLockRelease(lock);
 }
 
 
@@ -246,6 +246,9 @@ MarkAsPreparing(TransactionId xid, const char *gid,
 	GlobalTransaction gxact;
 	PGPROC	   *proc;
 	PGXACT	   *pgxact;
+	SHM_QUEUE  *myProcLocks;
+	uint64	   *fpLockBits;
+	Oid		   *fpRelId;
 	int			i;
 
 	if (strlen(gid) >= GIDSIZE)
@@ -310,8 +313,17 @@ MarkAsPreparing(TransactionId xid, const char *gid,
 	proc = &ProcGlobal->allProcs[gxact->pgprocno];
 	pgxact = &ProcGlobal->allPgXact[gxact->pgprocno];
 
-	/* Initialize the PGPROC entry */
+	/*
+	 * Initialize the PGPROC entry.  The lock manager arrays live outside the
+	 * struct, so keep the pointers to them across the MemSet.
+	 */
+	myProcLocks = proc->myProcLocks;
+	fpLockBits = proc->fpLockBits;
+	fpRelId = proc->fpRelId;
 	MemSet(proc, 0, sizeof(PGPROC));
+	proc->myProcLocks = myProcLocks;
+	proc->fpLockBits = fpLockBits;
+	proc->fpRelId = fpRelId;
 	proc->pgprocno = gxact->pgprocno;
 	SHMQueueElemInit(&(proc->links));
 	proc->waitStatus = STATUS_OK;
@@ -149,6 +149,7 @@ typedef struct TransactionStateData
 	bool		prevXactReadOnly;		/* entry-time xact r/o state */
 	bool		startedInRecovery;		/* did we start in recovery? */
 	bool		didLogXid;		/* has xid been included in WAL record? */
+	bool		assigned;		/* toplevel xid logged with ours? */
 	struct TransactionStateData *parent;		/* back link to parent */
 } TransactionStateData;
 
@@ -179,6 +180,7 @@ static TransactionStateData TopTransactionStateData = {
 	false,						/* entry-time xact r/o state */
 	false,						/* startedInRecovery */
 	false,						/* didLogXid */
+	false,						/* assigned */
 	NULL						/* link to parent state block */
 };
 
@@ -408,6 +410,44 @@ MarkCurrentTransactionIdLoggedIfAny(void)
 		CurrentTransactionState->didLogXid = true;
 }
 
+/*
+ *	IsSubTransactionAssignmentPending
+ *
+ * When wal_level=logical, the first WAL record written by a subtransaction
+ * carries the xid of its toplevel transaction, so that logical decoding
+ * learns which toplevel transaction the subtransaction's changes belong to
+ * before it sees any of them; it needs that to stream the changes of
+ * transactions that are still in progress.  Returns true if the current
+ * subtransaction has an xid but hasn't written such a record yet.
+ */
+bool
+IsSubTransactionAssignmentPending(void)
+{
+	if (!XLogLogicalInfoActive())
+		return false;
+
+	/* we need to be in a subtransaction that has an xid */
+	if (!IsSubTransaction() ||
+		!TransactionIdIsValid(CurrentTransactionState->transactionId))
+		return false;
+
+	return !CurrentTransactionState->assigned;
+}
+
+/*
+ *	MarkSubTransactionAssigned
+ *
+ * Remember that the current subtransaction has written its toplevel xid to
+ * WAL, see IsSubTransactionAssignmentPending.
+ */
+void
+MarkSubTransactionAssigned(void)
+{
+	Assert(IsSubTransactionAssignmentPending());
+
+	CurrentTransactionState->assigned = true;
+}
+
 
 /*
  *	GetStableLatestTransactionId
@@ -690,6 +730,21 @@ SetCurrentStatementStartTimestamp(void)
 	stmtStartTimestamp = GetCurrentTimestamp();
 }
 
+/*
+ *	SetParallelStartTimestamps
+ *
+ * Called by a background worker that does part of another backend's work,
+ * once it has started its own transaction, so that transaction_timestamp()
+ * and statement_timestamp() (and with them, input values like 'now') agree
+ * with the backend it is working for.
+ */
+void
+SetParallelStartTimestamps(TimestampTz xact_ts, TimestampTz stmt_ts)
+{
+	xactStartTimestamp = xact_ts;
+	stmtStartTimestamp = stmt_ts;
+}
+
 /*
  *	SetCurrentTransactionStopTimestamp
  */
@@ -844,6 +844,7 @@ XLogInsert(RmgrId rmid, uint8 info, XLogRecData *rdata)
 	XLogRecData dtbuf_rdt1[XLR_MAX_BKP_BLOCKS];
 	XLogRecData dtbuf_rdt2[XLR_MAX_BKP_BLOCKS];
 	XLogRecData dtbuf_rdt3[XLR_MAX_BKP_BLOCKS];
+	XLogRecData topxid_rdt;
 	XLogRecData hdr_rdt;
 	pg_crc32	rdata_crc;
 	uint32		len,
@@ -852,6 +853,8 @@ XLogInsert(RmgrId rmid, uint8 info, XLogRecData *rdata)
 	bool		doPageWrites;
 	bool		isLogSwitch = (rmid == RM_XLOG_ID && info == XLOG_SWITCH);
 	bool		inserted;
+	bool		include_topxid;
+	TransactionId topxid = InvalidTransactionId;
 	uint8		info_orig = info;
 	static XLogRecord *rechdr;
 	XLogRecPtr	StartPos;
@@ -884,6 +887,12 @@ XLogInsert(RmgrId rmid, uint8 info, XLogRecData *rdata)
 		return EndPos;
 	}
 
+	/*
+	 * A pending toplevel xid goes into the record unless it is a WAL switch,
+	 * which has no room for it; the next record carries it instead.
+	 */
+	include_topxid = !isLogSwitch && IsSubTransactionAssignmentPending();
+
 	/*
 	 * Here we scan the rdata chain, to determine which buffers must be backed
 	 * up.
@@ -1036,6 +1045,24 @@ begin:;
 		}
 	}
 
+	/*
+	 * Add the toplevel xid to the first record of a subtransaction, after
+	 * the backup blocks.  This, too, is undone if we loop back.
+	 */
+	if (include_topxid)
+	{
+		topxid = GetTopTransactionIdIfAny();
+		Assert(TransactionIdIsValid(topxid));
+
+		rdt->next = &topxid_rdt;
+		rdt = rdt->next;
+
+		rdt->data = (char *) &topxid;
+		rdt->len = sizeof(TransactionId);
+		write_len += sizeof(TransactionId);
+		rdt->next = NULL;
+	}
+
 	/*
 	 * Calculate CRC of the data, including all the backup blocks
 	 *
@@ -1060,6 +1087,7 @@ begin:;
 	rechdr->xl_len = len;		/* doesn't include backup blocks */
 	rechdr->xl_info = info;
 	rechdr->xl_rmid = rmid;
+	rechdr->xl_flags = include_topxid ? XLR_HAS_TOPLEVEL_XID : 0;
 	rechdr->xl_prev = InvalidXLogRecPtr;
 	COMP_CRC32(rdata_crc, ((char *) rechdr), offsetof(XLogRecord, xl_prev));
 
@@ -1203,6 +1231,8 @@ begin:;
 	WALInsertLockRelease();
 
 	MarkCurrentTransactionIdLoggedIfAny();
+	if (include_topxid)
+		MarkSubTransactionAssigned();
 
 	END_CRIT_SECTION();
 
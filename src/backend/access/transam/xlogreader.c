@@ -602,7 +602,8 @@ ValidXLogRecordHeader(XLogReaderState *state, XLogRecPtr RecPtr,
 	}
 	if (record->xl_tot_len < SizeOfXLogRecord + record->xl_len ||
 		record->xl_tot_len > SizeOfXLogRecord + record->xl_len +
-		XLR_MAX_BKP_BLOCKS * (sizeof(BkpBlock) + BLCKSZ))
+		XLR_MAX_BKP_BLOCKS * (sizeof(BkpBlock) + BLCKSZ) +
+		sizeof(TransactionId))
 	{
 		report_invalid_record(state,
 							  "invalid record length at %X/%X",
@@ -726,6 +727,20 @@ ValidXLogRecord(XLogReaderState *state, XLogRecord *record, XLogRecPtr recptr)
 		blk += blen;
 	}
 
+	/* And the toplevel xid, if any */
+	if (record->xl_flags & XLR_HAS_TOPLEVEL_XID)
+	{
+		if (remaining < sizeof(TransactionId))
+		{
+			report_invalid_record(state,
+								  "invalid toplevel xid in record at %X/%X",
+								  (uint32) (recptr >> 32), (uint32) recptr);
+			return false;
+		}
+		remaining -= sizeof(TransactionId);
+		COMP_CRC32(crc, blk, sizeof(TransactionId));
+	}
+
 	/* Check that xl_tot_len agrees with our calculation */
 	if (remaining != 0)
 	{
@@ -985,3 +1000,22 @@ out:
 }
 
 #endif   /* FRONTEND */
+
+/*
+ * Return the toplevel xid a subtransaction's first record carries after its
+ * backup blocks, or InvalidTransactionId if the record has none.  The
+ * record must have passed ValidXLogRecord().
+ */
+TransactionId
+XLogRecGetTopXid(XLogRecord *record)
+{
+	TransactionId topxid;
+
+	if (!(record->xl_flags & XLR_HAS_TOPLEVEL_XID))
+		return InvalidTransactionId;
+
+	memcpy(&topxid,
+		   (char *) record + record->xl_tot_len - sizeof(TransactionId),
+		   sizeof(TransactionId));
+	return topxid;
+}
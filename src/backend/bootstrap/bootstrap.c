@@ -352,9 +352,15 @@ AuxiliaryProcessMain(int argc, char *argv[])
 	SetProcessingMode(BootstrapProcessing);
 	IgnoreSystemIndexes = true;
 
-	/* Initialize MaxBackends (if under postmaster, was done already) */
+	/*
+	 * Initialize MaxBackends and fast-path lock sizing (if under postmaster,
+	 * was done already)
+	 */
 	if (!IsUnderPostmaster)
+	{
 		InitializeMaxBackends();
+		InitializeFastPathLocks();
+	}
 
 	BaseInit();
 
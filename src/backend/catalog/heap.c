@@ -45,7 +45,10 @@
 #include "catalog/pg_constraint.h"
 #include "catalog/pg_foreign_table.h"
 #include "catalog/pg_inherits.h"
+#include "catalog/partition.h"
 #include "catalog/pg_namespace.h"
+#include "catalog/pg_opclass.h"
+#include "catalog/pg_partitioned_table.h"
 #include "catalog/pg_statistic.h"
 #include "catalog/pg_tablespace.h"
 #include "catalog/pg_type.h"
@@ -1742,6 +1745,13 @@ void
 heap_drop_with_catalog(Oid relid)
 {
 	Relation	rel;
+	Oid			parentOid;
+
+	/*
+	 * If the relation is a partition, the parent's partition descriptor must
+	 * be rebuilt without it.  The caller has locked the parent already.
+	 */
+	parentOid = get_partition_parent(relid);
 
 	/*
 	 * Open and lock the relation.
@@ -1819,6 +1829,11 @@ heap_drop_with_catalog(Oid relid)
 	 */
 	RelationRemoveInheritance(relid);
 
+	/*
+	 * remove the partition key, if any
+	 */
+	RemovePartitionKeyByRelId(relid);
+
 	/*
 	 * delete statistics
 	 */
@@ -1833,6 +1848,92 @@ heap_drop_with_catalog(Oid relid)
 	 * delete relation tuple
 	 */
 	DeleteRelationTuple(relid);
+
+	if (OidIsValid(parentOid))
+		CacheInvalidateRelcacheByRelid(parentOid);
+}
+
+/*
+ * StorePartitionKey
+ *		Store the partition key of a newly created partitioned table in
+ *		pg_partitioned_table.
+ */
+void
+StorePartitionKey(Relation rel, char strategy, AttrNumber partattnum,
+				  Oid partopclass, Oid partcollation)
+{
+	Relation	pg_partitioned_table;
+	HeapTuple	tuple;
+	Datum		values[Natts_pg_partitioned_table];
+	bool		nulls[Natts_pg_partitioned_table];
+	ObjectAddress myself;
+	ObjectAddress referenced;
+
+	Assert(rel->rd_rel->relkind == RELKIND_RELATION);
+
+	pg_partitioned_table = heap_open(PartitionedRelationId, RowExclusiveLock);
+
+	MemSet(nulls, false, sizeof(nulls));
+	values[Anum_pg_partitioned_table_partrelid - 1] = ObjectIdGetDatum(RelationGetRelid(rel));
+	values[Anum_pg_partitioned_table_partstrat - 1] = CharGetDatum(strategy);
+	values[Anum_pg_partitioned_table_partattnum - 1] = Int16GetDatum(partattnum);
+	values[Anum_pg_partitioned_table_partopclass - 1] = ObjectIdGetDatum(partopclass);
+	values[Anum_pg_partitioned_table_partcollation - 1] = ObjectIdGetDatum(partcollation);
+
+	tuple = heap_form_tuple(RelationGetDescr(pg_partitioned_table), values, nulls);
+
+	simple_heap_insert(pg_partitioned_table, tuple);
+	CatalogUpdateIndexes(pg_partitioned_table, tuple);
+
+	heap_freetuple(tuple);
+	heap_close(pg_partitioned_table, RowExclusiveLock);
+
+	/*
+	 * The key depends on its opclass and collation.  The key column is
+	 * protected from being dropped or changed by checks in tablecmds.c.
+	 */
+	myself.classId = RelationRelationId;
+	myself.objectId = RelationGetRelid(rel);
+	myself.objectSubId = 0;
+
+	referenced.classId = OperatorClassRelationId;
+	referenced.objectId = partopclass;
+	referenced.objectSubId = 0;
+	recordDependencyOn(&myself, &referenced, DEPENDENCY_NORMAL);
+
+	if (OidIsValid(partcollation) &&
+		partcollation != DEFAULT_COLLATION_OID)
+	{
+		referenced.classId = CollationRelationId;
+		referenced.objectId = partcollation;
+		referenced.objectSubId = 0;
+		recordDependencyOn(&myself, &referenced, DEPENDENCY_NORMAL);
+	}
+
+	/* Make the new key visible in the relcache entry */
+	CacheInvalidateRelcache(rel);
+}
+
+/*
+ * RemovePartitionKeyByRelId
+ *		Remove the pg_partitioned_table row of a relation, if it has one.
+ */
+void
+RemovePartitionKeyByRelId(Oid relid)
+{
+	Relation	rel;
+	HeapTuple	tuple;
+
+	rel = heap_open(PartitionedRelationId, RowExclusiveLock);
+
+	tuple = SearchSysCache1(PARTRELID, ObjectIdGetDatum(relid));
+	if (HeapTupleIsValid(tuple))
+	{
+		simple_heap_delete(rel, &tuple->t_self);
+		ReleaseSysCache(tuple);
+	}
+
+	heap_close(rel, RowExclusiveLock);
 }
 
 
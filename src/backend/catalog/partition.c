@@ -0,0 +1,1229 @@
+/*-------------------------------------------------------------------------
+ *
+ * partition.c
+ *	  Partitioning related data structures and functions.
+ *
+ * Portions Copyright (c) 1996-2014, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/catalog/partition.c
+ *
+ * NOTES
+ *	  A partitioned table has a single key column, and each of its
+ *	  partitions accepts either a half-open range of key values or a list of
+ *	  them.  The bounds of all the partitions are loaded into the parent's
+ *	  relcache entry in sorted order, so that routing a row to its partition
+ *	  and pruning the partitions that cannot satisfy a restriction clause are
+ *	  both binary searches, O(log n) in the number of partitions.
+ *
+ *	  A partition's bound is stored in its pg_inherits row.  From the bound we
+ *	  also derive the partition constraint, which is enforced like a CHECK
+ *	  constraint on rows inserted into the partition directly.
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "access/genam.h"
+#include "access/heapam.h"
+#include "access/htup_details.h"
+#include "access/nbtree.h"
+#include "catalog/indexing.h"
+#include "catalog/partition.h"
+#include "catalog/pg_inherits.h"
+#include "catalog/pg_opclass.h"
+#include "catalog/pg_partitioned_table.h"
+#include "catalog/pg_type.h"
+#include "nodes/makefuncs.h"
+#include "optimizer/clauses.h"
+#include "optimizer/planmain.h"
+#include "utils/array.h"
+#include "utils/builtins.h"
+#include "utils/datum.h"
+#include "utils/fmgroids.h"
+#include "utils/lsyscache.h"
+#include "utils/memutils.h"
+#include "utils/rel.h"
+#include "utils/syscache.h"
+
+/* Comparison info passed to the qsort_arg comparators */
+typedef struct PartitionSortContext
+{
+	FmgrInfo   *cmpfn;
+	Oid			collation;
+} PartitionSortContext;
+
+/* One partition, while building a PartitionDesc */
+typedef struct PartitionBoundEntry
+{
+	Oid			oid;
+	PartitionBoundSpec *spec;
+	int			index;			/* position in bound order, or -1 */
+} PartitionBoundEntry;
+
+/* One value of a list partition, while building a PartitionDesc */
+typedef struct PartitionListValue
+{
+	Datum		value;
+	int			entry;			/* index into the PartitionBoundEntry array */
+} PartitionListValue;
+
+static void RelationBuildPartitionKey(Relation rel);
+static void RelationBuildPartitionDesc(Relation rel);
+static PartitionBoundSpec *get_partition_bound(Oid relid, Oid *parentid);
+static List *make_partition_qual(Form_pg_partitioned_table form,
+					Oid opfamily, Oid opcintype, Expr *keyvar,
+					PartitionBoundSpec *spec);
+static Expr *make_partition_opclause(Oid opfamily, Oid opcintype,
+						Oid collation, int16 strategy,
+						Expr *keyvar, Const *bound);
+static int	range_bound_cmp(const void *a, const void *b, void *arg);
+static int	list_value_cmp(const void *a, const void *b, void *arg);
+static int range_lower_count(PartitionDesc pdesc, FmgrInfo *cmpfn,
+				  Oid collation, Datum value, bool inclusive);
+static int range_upper_first(PartitionDesc pdesc, FmgrInfo *cmpfn,
+				  Oid collation, Datum value);
+static int list_value_count(PartitionDesc pdesc, FmgrInfo *cmpfn,
+				 Oid collation, Datum value, bool inclusive);
+static bool match_partition_key(PartitionKey key, Index varno, Node *node);
+static bool get_clause_cmpfn(PartitionKey key, Oid opno, Oid inputcollid,
+				 int *strategy, FmgrInfo *cmpfn);
+static Bitmapset *prune_by_value(PartitionKey key, PartitionDesc pdesc,
+			   int strategy, FmgrInfo *cmpfn, Datum value);
+static bool prune_clause(PartitionKey key, PartitionDesc pdesc, Index varno,
+			 Node *clause, Bitmapset **parts, List **paramclauses);
+
+#define partition_cmp(cmpfn, collation, a, b) \
+	DatumGetInt32(FunctionCall2Coll(cmpfn, collation, a, b))
+
+
+/*
+ * RelationGetPartitionKey -- get the partition key of a relation
+ *
+ * Returns NULL if the relation isn't partitioned.  The result points into
+ * the relcache entry, so don't hold onto it across anything that might
+ * process invalidation messages.
+ */
+PartitionKey
+RelationGetPartitionKey(Relation rel)
+{
+	if (rel->rd_partkey == NULL &&
+		rel->rd_rel->relkind == RELKIND_RELATION)
+		RelationBuildPartitionKey(rel);
+
+	return rel->rd_partkey;
+}
+
+/*
+ * RelationGetPartitionDesc -- get the partitions of a partitioned table
+ *
+ * Returns NULL if the relation isn't partitioned.  The same caution as for
+ * RelationGetPartitionKey applies.
+ */
+PartitionDesc
+RelationGetPartitionDesc(Relation rel)
+{
+	if (rel->rd_partdesc == NULL && RelationGetPartitionKey(rel) != NULL)
+		RelationBuildPartitionDesc(rel);
+
+	return rel->rd_partdesc;
+}
+
+/*
+ * RelationGetPartitionQual -- get the partition constraint of a partition
+ *
+ * The result is an implicitly-ANDed list of expressions in which the key
+ * column is a Var with varno 1.  Returns NIL if the relation isn't a
+ * partition.
+ */
+List *
+RelationGetPartitionQual(Relation rel)
+{
+	PartitionBoundSpec *spec;
+	HeapTuple	tuple;
+	HeapTuple	opclasstup;
+	Form_pg_opclass opclassform;
+	Oid			parentid;
+	AttrNumber	attnum;
+	Form_pg_attribute attr;
+	Expr	   *keyvar;
+	List	   *result;
+	MemoryContext cxt;
+	MemoryContext oldcxt;
+
+	if (rel->rd_partcheckvalid)
+		return rel->rd_partcheck;
+
+	if (rel->rd_rel->relkind != RELKIND_RELATION ||
+		(spec = get_partition_bound(RelationGetRelid(rel), &parentid)) == NULL)
+	{
+		rel->rd_partcheck = NIL;
+		rel->rd_partcheckvalid = true;
+		return NIL;
+	}
+
+	tuple = SearchSysCache1(PARTRELID, ObjectIdGetDatum(parentid));
+	if (!HeapTupleIsValid(tuple))
+		elog(ERROR, "cache lookup failed for partition key of relation %u",
+			 parentid);
+	opclasstup = SearchSysCache1(CLAOID,
+			ObjectIdGetDatum(((Form_pg_partitioned_table) GETSTRUCT(tuple))->partopclass));
+	if (!HeapTupleIsValid(opclasstup))
+		elog(ERROR, "cache lookup failed for opclass %u",
+			 ((Form_pg_partitioned_table) GETSTRUCT(tuple))->partopclass);
+	opclassform = (Form_pg_opclass) GETSTRUCT(opclasstup);
+
+	/* The partition's column numbers may differ from the parent's */
+	attnum = get_attnum(RelationGetRelid(rel),
+						get_attname(parentid,
+				 ((Form_pg_partitioned_table) GETSTRUCT(tuple))->partattnum));
+	if (attnum == InvalidAttrNumber)
+		elog(ERROR, "partition key column missing in partition \"%s\"",
+			 RelationGetRelationName(rel));
+	attr = RelationGetDescr(rel)->attrs[attnum - 1];
+
+	keyvar = (Expr *) makeVar(1, attnum, attr->atttypid, attr->atttypmod,
+							  attr->attcollation, 0);
+	if (attr->atttypid != opclassform->opcintype &&
+		!IsPolymorphicType(opclassform->opcintype))
+		keyvar = (Expr *) makeRelabelType(keyvar, opclassform->opcintype, -1,
+										  attr->attcollation,
+										  COERCE_IMPLICIT_CAST);
+
+	result = make_partition_qual((Form_pg_partitioned_table) GETSTRUCT(tuple),
+								 opclassform->opcfamily,
+								 opclassform->opcintype,
+								 keyvar, spec);
+
+	ReleaseSysCache(opclasstup);
+	ReleaseSysCache(tuple);
+
+	/* No catalog access from here on; now save it in the relcache */
+	cxt = AllocSetContextCreate(CurrentMemoryContext,
+								"partition constraint",
+								ALLOCSET_SMALL_MINSIZE,
+								ALLOCSET_SMALL_INITSIZE,
+								ALLOCSET_SMALL_MAXSIZE);
+	oldcxt = MemoryContextSwitchTo(cxt);
+	rel->rd_partcheck = (List *) copyObject(result);
+	MemoryContextSwitchTo(oldcxt);
+
+	MemoryContextSetParent(cxt, CacheMemoryContext);
+	rel->rd_partcheckcxt = cxt;
+	rel->rd_partcheckvalid = true;
+
+	return rel->rd_partcheck;
+}
+
+/*
+ * relation_is_partitioned -- does the relation have a partition key?
+ */
+bool
+relation_is_partitioned(Oid relid)
+{
+	return SearchSysCacheExists1(PARTRELID, ObjectIdGetDatum(relid));
+}
+
+/*
+ * get_partition_parent -- get the parent of a partition
+ *
+ * Returns InvalidOid if the relation isn't a partition.
+ */
+Oid
+get_partition_parent(Oid relid)
+{
+	PartitionBoundSpec *spec;
+	Oid			parentid;
+
+	spec = get_partition_bound(relid, &parentid);
+	if (spec == NULL)
+		return InvalidOid;
+	pfree(spec);
+
+	return parentid;
+}
+
+/*
+ * check_new_partition_bound -- check that a new partition of parent, with
+ * the given transformed bound, wouldn't overlap any existing one
+ */
+void
+check_new_partition_bound(const char *relname, Relation parent,
+						  PartitionBoundSpec *spec)
+{
+	PartitionKey key = RelationGetPartitionKey(parent);
+	PartitionDesc pdesc = RelationGetPartitionDesc(parent);
+	int			overlap = -1;
+
+	Assert(key != NULL && spec->strategy == key->strategy);
+
+	if (key->strategy == PARTITION_STRATEGY_RANGE)
+	{
+		Const	   *lower = (Const *) spec->lowerdatum;
+		Const	   *upper = (Const *) spec->upperdatum;
+		int			n;
+
+		if (lower != NULL && upper != NULL &&
+			partition_cmp(&key->partcmpfn, key->partcollation,
+						  lower->constvalue, upper->constvalue) >= 0)
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_OBJECT_DEFINITION),
+					 errmsg("empty range bound specified for partition \"%s\"",
+							relname),
+					 errdetail("The lower bound must be less than the upper bound.")));
+
+		/*
+		 * Of the existing partitions starting below the new upper bound, the
+		 * last one has the highest upper bound.  If that one ends at or below
+		 * the new lower bound, so do all the others.
+		 */
+		if (upper == NULL)
+			n = pdesc->nparts;
+		else
+			n = range_lower_count(pdesc, &key->partcmpfn, key->partcollation,
+								  upper->constvalue, false);
+		if (n > 0 &&
+			(lower == NULL || pdesc->upper_unbounded[n - 1] ||
+			 partition_cmp(&key->partcmpfn, key->partcollation,
+						   pdesc->upper[n - 1], lower->constvalue) > 0))
+			overlap = n - 1;
+	}
+	else
+	{
+		ListCell   *lc;
+
+		foreach(lc, spec->listdatums)
+		{
+			Const	   *val = (Const *) lfirst(lc);
+			int			i;
+
+			i = list_value_count(pdesc, &key->partcmpfn, key->partcollation,
+								 val->constvalue, false);
+			if (i < pdesc->nvalues &&
+				partition_cmp(&key->partcmpfn, key->partcollation,
+							  pdesc->values[i], val->constvalue) == 0)
+			{
+				overlap = pdesc->valueparts[i];
+				break;
+			}
+		}
+	}
+
+	if (overlap >= 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_OBJECT_DEFINITION),
+				 errmsg("partition \"%s\" would overlap partition \"%s\"",
+						relname, get_rel_name(pdesc->oids[overlap]))));
+}
+
+/*
+ * get_partition_for_value -- find the partition accepting a key value
+ *
+ * Returns the partition's index in pdesc, or -1 if there is none.
+ */
+int
+get_partition_for_value(PartitionKey key, PartitionDesc pdesc,
+						Datum value, bool isnull)
+{
+	int			i;
+
+	if (isnull)
+		return -1;
+
+	if (key->strategy == PARTITION_STRATEGY_RANGE)
+	{
+		i = range_lower_count(pdesc, &key->partcmpfn, key->partcollation,
+							  value, true) - 1;
+		if (i >= 0 &&
+			(pdesc->upper_unbounded[i] ||
+			 partition_cmp(&key->partcmpfn, key->partcollation,
+						   pdesc->upper[i], value) > 0))
+			return i;
+	}
+	else
+	{
+		i = list_value_count(pdesc, &key->partcmpfn, key->partcollation,
+							 value, false);
+		if (i < pdesc->nvalues &&
+			partition_cmp(&key->partcmpfn, key->partcollation,
+						  pdesc->values[i], value) == 0)
+			return pdesc->valueparts[i];
+	}
+
+	return -1;
+}
+
+/*
+ * get_matching_partitions -- find the partitions that may contain rows
+ * satisfying all of the given restriction clauses
+ *
+ * varno is the range table index by which the clauses refer to the
+ * partitioned table.  Clauses that compare the key column with constants,
+ * possibly combined with AND and OR, are used for pruning; others are
+ * ignored.  The result is the set of indexes in pdesc of the partitions that
+ * remain.
+ *
+ * If paramclauses isn't NULL, top-level clauses comparing the key with an
+ * external Param are added to *paramclauses, so that the caller can prune
+ * with them once the values of the Params are known.
+ */
+Bitmapset *
+get_matching_partitions(PartitionKey key, PartitionDesc pdesc, Index varno,
+						List *clauses, List **paramclauses)
+{
+	Bitmapset  *result = NULL;
+	ListCell   *lc;
+	int			i;
+
+	for (i = 0; i < pdesc->nparts; i++)
+		result = bms_add_member(result, i);
+
+	foreach(lc, clauses)
+	{
+		Bitmapset  *parts;
+
+		if (prune_clause(key, pdesc, varno, (Node *) lfirst(lc), &parts,
+						 paramclauses))
+		{
+			result = bms_int_members(result, parts);
+			bms_free(parts);
+		}
+	}
+
+	return result;
+}
+
+/*
+ * partition_bounds_equal -- are two tables partitioned the same way?
+ *
+ * True if both keys compare values the same way and the partitions of the
+ * two tables accept the same sets of values, partition by partition, so that
+ * rows with equal keys always land in partitions with the same index.
+ */
+bool
+partition_bounds_equal(PartitionKey key1, PartitionDesc pdesc1,
+					   PartitionKey key2, PartitionDesc pdesc2)
+{
+	int			i;
+
+	if (key1->strategy != key2->strategy ||
+		key1->partopfamily != key2->partopfamily ||
+		key1->partopcintype != key2->partopcintype ||
+		key1->partcollation != key2->partcollation ||
+		key1->parttypid != key2->parttypid ||
+		pdesc1->nparts != pdesc2->nparts)
+		return false;
+
+	if (key1->strategy == PARTITION_STRATEGY_RANGE)
+	{
+		for (i = 0; i < pdesc1->nparts; i++)
+		{
+			if (pdesc1->lower_unbounded[i] != pdesc2->lower_unbounded[i] ||
+				pdesc1->upper_unbounded[i] != pdesc2->upper_unbounded[i])
+				return false;
+			if (!pdesc1->lower_unbounded[i] &&
+				!datumIsEqual(pdesc1->lower[i], pdesc2->lower[i],
+							  key1->parttypbyval, key1->parttyplen))
+				return false;
+			if (!pdesc1->upper_unbounded[i] &&
+				!datumIsEqual(pdesc1->upper[i], pdesc2->upper[i],
+							  key1->parttypbyval, key1->parttyplen))
+				return false;
+		}
+	}
+	else
+	{
+		if (pdesc1->nvalues != pdesc2->nvalues)
+			return false;
+		for (i = 0; i < pdesc1->nvalues; i++)
+		{
+			if (pdesc1->valueparts[i] != pdesc2->valueparts[i] ||
+				!datumIsEqual(pdesc1->values[i], pdesc2->values[i],
+							  key1->parttypbyval, key1->parttyplen))
+				return false;
+		}
+	}
+
+	return true;
+}
+
+
+/*
+ * Build the PartitionKey of a relation, if it has one.
+ */
+static void
+RelationBuildPartitionKey(Relation rel)
+{
+	HeapTuple	tuple;
+	HeapTuple	opclasstup;
+	Form_pg_partitioned_table form;
+	Form_pg_opclass opclassform;
+	Form_pg_attribute attr;
+	PartitionKey key;
+	Oid			cmpproc;
+	MemoryContext cxt;
+
+	tuple = SearchSysCache1(PARTRELID,
+							ObjectIdGetDatum(RelationGetRelid(rel)));
+	if (!HeapTupleIsValid(tuple))
+		return;
+	form = (Form_pg_partitioned_table) GETSTRUCT(tuple);
+
+	opclasstup = SearchSysCache1(CLAOID, ObjectIdGetDatum(form->partopclass));
+	if (!HeapTupleIsValid(opclasstup))
+		elog(ERROR, "cache lookup failed for opclass %u", form->partopclass);
+	opclassform = (Form_pg_opclass) GETSTRUCT(opclasstup);
+
+	cmpproc = get_opfamily_proc(opclassform->opcfamily,
+								opclassform->opcintype,
+								opclassform->opcintype,
+								BTORDER_PROC);
+	if (!RegProcedureIsValid(cmpproc))
+		elog(ERROR, "missing support function %d(%u,%u) in opfamily %u",
+			 BTORDER_PROC, opclassform->opcintype, opclassform->opcintype,
+			 opclassform->opcfamily);
+
+	/*
+	 * Build the key in a context of its own, which is made a child of
+	 * CacheMemoryContext only when done, so that nothing is leaked if we
+	 * fail partway.
+	 */
+	cxt = AllocSetContextCreate(CurrentMemoryContext,
+								"partition key",
+								ALLOCSET_SMALL_MINSIZE,
+								ALLOCSET_SMALL_INITSIZE,
+								ALLOCSET_SMALL_MAXSIZE);
+	key = (PartitionKey) MemoryContextAllocZero(cxt, sizeof(PartitionKeyData));
+
+	attr = RelationGetDescr(rel)->attrs[form->partattnum - 1];
+	key->strategy = form->partstrat;
+	key->partattnum = form->partattnum;
+	key->partopfamily = opclassform->opcfamily;
+	key->partopcintype = opclassform->opcintype;
+	key->partcollation = form->partcollation;
+	key->parttypid = attr->atttypid;
+	key->parttypmod = attr->atttypmod;
+	key->parttyplen = attr->attlen;
+	key->parttypbyval = attr->attbyval;
+	fmgr_info_cxt(cmpproc, &key->partcmpfn, cxt);
+
+	ReleaseSysCache(opclasstup);
+	ReleaseSysCache(tuple);
+
+	MemoryContextSetParent(cxt, CacheMemoryContext);
+	rel->rd_partkeycxt = cxt;
+	rel->rd_partkey = key;
+}
+
+/*
+ * Build the PartitionDesc of a partitioned table.
+ *
+ * Reading pg_inherits might process invalidation messages and reset the
+ * relation's partition key, so we work with a private copy of the bits of
+ * it we need.
+ */
+static void
+RelationBuildPartitionDesc(Relation rel)
+{
+	PartitionKey key = RelationGetPartitionKey(rel);
+	char		strategy = key->strategy;
+	int16		typlen = key->parttyplen;
+	bool		typbyval = key->parttypbyval;
+	FmgrInfo	cmpfn;
+	PartitionSortContext sortcxt;
+	PartitionBoundEntry *entries;
+	int			nentries = 0;
+	int			maxentries = 16;
+	PartitionListValue *values = NULL;
+	int			nvalues = 0;
+	Relation	inhrel;
+	SysScanDesc scan;
+	ScanKeyData skey;
+	HeapTuple	tuple;
+	PartitionDesc pdesc;
+	MemoryContext cxt;
+	MemoryContext oldcxt;
+	int			i;
+
+	fmgr_info_copy(&cmpfn, &key->partcmpfn, CurrentMemoryContext);
+	sortcxt.cmpfn = &cmpfn;
+	sortcxt.collation = key->partcollation;
+	key = NULL;
+
+	/* Collect the partitions and their bounds */
+	entries = (PartitionBoundEntry *)
+		palloc(maxentries * sizeof(PartitionBoundEntry));
+
+	inhrel = heap_open(InheritsRelationId, AccessShareLock);
+	ScanKeyInit(&skey,
+				Anum_pg_inherits_inhparent,
+				BTEqualStrategyNumber, F_OIDEQ,
+				ObjectIdGetDatum(RelationGetRelid(rel)));
+	scan = systable_beginscan(inhrel, InheritsParentIndexId, true,
+							  NULL, 1, &skey);
+	while ((tuple = systable_getnext(scan)) != NULL)
+	{
+		Datum		datum;
+		bool		isnull;
+
+		datum = heap_getattr(tuple, Anum_pg_inherits_inhbound,
+							 RelationGetDescr(inhrel), &isnull);
+		if (isnull)
+			continue;			/* shouldn't happen */
+
+		if (nentries >= maxentries)
+		{
+			maxentries *= 2;
+			entries = (PartitionBoundEntry *)
+				repalloc(entries, maxentries * sizeof(PartitionBoundEntry));
+		}
+		entries[nentries].oid = ((Form_pg_inherits) GETSTRUCT(tuple))->inhrelid;
+		entries[nentries].spec = (PartitionBoundSpec *)
+			stringToNode(TextDatumGetCString(datum));
+		entries[nentries].index = -1;
+		nentries++;
+	}
+	systable_endscan(scan);
+	heap_close(inhrel, AccessShareLock);
+
+	/* Put them in bound order */
+	if (strategy == PARTITION_STRATEGY_RANGE)
+	{
+		qsort_arg(entries, nentries, sizeof(PartitionBoundEntry),
+				  range_bound_cmp, &sortcxt);
+		for (i = 0; i < nentries; i++)
+			entries[i].index = i;
+	}
+	else
+	{
+		int			nextindex = 0;
+
+		for (i = 0; i < nentries; i++)
+			nvalues += list_length(entries[i].spec->listdatums);
+		values = (PartitionListValue *)
+			palloc(Max(nvalues, 1) * sizeof(PartitionListValue));
+		nvalues = 0;
+		for (i = 0; i < nentries; i++)
+		{
+			ListCell   *lc;
+
+			foreach(lc, entries[i].spec->listdatums)
+			{
+				values[nvalues].value = ((Const *) lfirst(lc))->constvalue;
+				values[nvalues].entry = i;
+				nvalues++;
+			}
+		}
+		qsort_arg(values, nvalues, sizeof(PartitionListValue),
+				  list_value_cmp, &sortcxt);
+
+		/* Number the partitions in order of their lowest values */
+		for (i = 0; i < nvalues; i++)
+		{
+			if (entries[values[i].entry].index < 0)
+				entries[values[i].entry].index = nextindex++;
+		}
+	}
+
+	/* No catalog access from here on; now build the result */
+	cxt = AllocSetContextCreate(CurrentMemoryContext,
+								"partition descriptor",
+								ALLOCSET_SMALL_MINSIZE,
+								ALLOCSET_SMALL_INITSIZE,
+								ALLOCSET_DEFAULT_MAXSIZE);
+	oldcxt = MemoryContextSwitchTo(cxt);
+
+	pdesc = (PartitionDesc) palloc0(sizeof(PartitionDescData));
+	pdesc->nparts = nentries;
+	pdesc->oids = (Oid *) palloc(Max(nentries, 1) * sizeof(Oid));
+	for (i = 0; i < nentries; i++)
+		pdesc->oids[entries[i].index] = entries[i].oid;
+
+	if (strategy == PARTITION_STRATEGY_RANGE)
+	{
+		pdesc->lower = (Datum *) palloc0(Max(nentries, 1) * sizeof(Datum));
+		pdesc->lower_unbounded = (bool *) palloc0(Max(nentries, 1) * sizeof(bool));
+		pdesc->upper = (Datum *) palloc0(Max(nentries, 1) * sizeof(Datum));
+		pdesc->upper_unbounded = (bool *) palloc0(Max(nentries, 1) * sizeof(bool));
+		for (i = 0; i < nentries; i++)
+		{
+			Const	   *lower = (Const *) entries[i].spec->lowerdatum;
+			Const	   *upper = (Const *) entries[i].spec->upperdatum;
+
+			if (lower != NULL)
+				pdesc->lower[i] = datumCopy(lower->constvalue, typbyval, typlen);
+			else
+				pdesc->lower_unbounded[i] = true;
+			if (upper != NULL)
+				pdesc->upper[i] = datumCopy(upper->constvalue, typbyval, typlen);
+			else
+				pdesc->upper_unbounded[i] = true;
+		}
+	}
+	else
+	{
+		pdesc->nvalues = nvalues;
+		pdesc->values = (Datum *) palloc(Max(nvalues, 1) * sizeof(Datum));
+		pdesc->valueparts = (int *) palloc(Max(nvalues, 1) * sizeof(int));
+		for (i = 0; i < nvalues; i++)
+		{
+			pdesc->values[i] = datumCopy(values[i].value, typbyval, typlen);
+			pdesc->valueparts[i] = entries[values[i].entry].index;
+		}
+	}
+
+	MemoryContextSwitchTo(oldcxt);
+
+	MemoryContextSetParent(cxt, CacheMemoryContext);
+	rel->rd_pdcxt = cxt;
+	rel->rd_partdesc = pdesc;
+}
+
+/*
+ * Fetch the bound of a partition, and the OID of its parent, from
+ * pg_inherits.  Returns NULL if the relation isn't a partition.
+ */
+static PartitionBoundSpec *
+get_partition_bound(Oid relid, Oid *parentid)
+{
+	PartitionBoundSpec *spec = NULL;
+	Relation	inhrel;
+	SysScanDesc scan;
+	ScanKeyData skey;
+	HeapTuple	tuple;
+
+	inhrel = heap_open(InheritsRelationId, AccessShareLock);
+	ScanKeyInit(&skey,
+				Anum_pg_inherits_inhrelid,
+				BTEqualStrategyNumber, F_OIDEQ,
+				ObjectIdGetDatum(relid));
+	scan = systable_beginscan(inhrel, InheritsRelidSeqnoIndexId, true,
+							  NULL, 1, &skey);
+	while ((tuple = systable_getnext(scan)) != NULL)
+	{
+		Datum		datum;
+		bool		isnull;
+
+		datum = heap_getattr(tuple, Anum_pg_inherits_inhbound,
+							 RelationGetDescr(inhrel), &isnull);
+		if (!isnull)
+		{
+			spec = (PartitionBoundSpec *)
+				stringToNode(TextDatumGetCString(datum));
+			*parentid = ((Form_pg_inherits) GETSTRUCT(tuple))->inhparent;
+			break;
+		}
+	}
+	systable_endscan(scan);
+	heap_close(inhrel, AccessShareLock);
+
+	return spec;
+}
+
+/*
+ * Build the partition constraint for the given bound: the key must not be
+ * null, and must lie within the range or equal one of the listed values.
+ */
+static List *
+make_partition_qual(Form_pg_partitioned_table form, Oid opfamily,
+					Oid opcintype, Expr *keyvar, PartitionBoundSpec *spec)
+{
+	NullTest   *nulltest;
+	List	   *result;
+
+	nulltest = makeNode(NullTest);
+	nulltest->arg = keyvar;
+	nulltest->nulltesttype = IS_NOT_NULL;
+	nulltest->argisrow = false;
+	result = list_make1(nulltest);
+
+	if (spec->strategy == PARTITION_STRATEGY_RANGE)
+	{
+		if (spec->lowerdatum != NULL)
+			result = lappend(result,
+							 make_partition_opclause(opfamily, opcintype,
+													 form->partcollation,
+													 BTGreaterEqualStrategyNumber,
+													 keyvar,
+												 (Const *) spec->lowerdatum));
+		if (spec->upperdatum != NULL)
+			result = lappend(result,
+							 make_partition_opclause(opfamily, opcintype,
+													 form->partcollation,
+													 BTLessStrategyNumber,
+													 keyvar,
+												 (Const *) spec->upperdatum));
+	}
+	else
+	{
+		List	   *eqclauses = NIL;
+		ListCell   *lc;
+
+		foreach(lc, spec->listdatums)
+			eqclauses = lappend(eqclauses,
+								make_partition_opclause(opfamily, opcintype,
+														form->partcollation,
+														BTEqualStrategyNumber,
+														keyvar,
+														(Const *) lfirst(lc)));
+		if (list_length(eqclauses) > 1)
+			result = lappend(result, make_orclause(eqclauses));
+		else
+			result = list_concat(result, eqclauses);
+	}
+
+	return result;
+}
+
+/*
+ * Build "keyvar op bound", for the opfamily operator with given strategy.
+ */
+static Expr *
+make_partition_opclause(Oid opfamily, Oid opcintype, Oid collation,
+						int16 strategy, Expr *keyvar, Const *bound)
+{
+	Oid			opno;
+	Expr	   *result;
+
+	opno = get_opfamily_member(opfamily, opcintype, opcintype, strategy);
+	if (!OidIsValid(opno))
+		elog(ERROR, "missing operator %d(%u,%u) in opfamily %u",
+			 strategy, opcintype, opcintype, opfamily);
+
+	/* Label the constant with the operator's input type, as for the key */
+	bound = (Const *) copyObject(bound);
+	if (bound->consttype != opcintype && !IsPolymorphicType(opcintype))
+	{
+		bound->consttype = opcintype;
+		bound->consttypmod = -1;
+	}
+
+	result = make_opclause(opno, BOOLOID, false,
+						   (Expr *) copyObject(keyvar), (Expr *) bound,
+						   InvalidOid, collation);
+	set_opfuncid((OpExpr *) result);
+
+	return result;
+}
+
+/*
+ * qsort_arg comparator for range partitions, by lower bound
+ */
+static int
+range_bound_cmp(const void *a, const void *b, void *arg)
+{
+	Const	   *lower1 = (Const *) ((const PartitionBoundEntry *) a)->spec->lowerdatum;
+	Const	   *lower2 = (Const *) ((const PartitionBoundEntry *) b)->spec->lowerdatum;
+	PartitionSortContext *sortcxt = (PartitionSortContext *) arg;
+
+	if (lower1 == NULL)
+		return (lower2 == NULL) ? 0 : -1;
+	if (lower2 == NULL)
+		return 1;
+	return partition_cmp(sortcxt->cmpfn, sortcxt->collation,
+						 lower1->constvalue, lower2->constvalue);
+}
+
+/*
+ * qsort_arg comparator for list partition values
+ */
+static int
+list_value_cmp(const void *a, const void *b, void *arg)
+{
+	PartitionSortContext *sortcxt = (PartitionSortContext *) arg;
+
+	return partition_cmp(sortcxt->cmpfn, sortcxt->collation,
+						 ((const PartitionListValue *) a)->value,
+						 ((const PartitionListValue *) b)->value);
+}
+
+/*
+ * Count the leading range partitions whose lower bound is less than value,
+ * or less than or equal to it if inclusive.  cmpfn compares a bound with
+ * the value.
+ */
+static int
+range_lower_count(PartitionDesc pdesc, FmgrInfo *cmpfn, Oid collation,
+				  Datum value, bool inclusive)
+{
+	int			lo = 0;
+	int			hi = pdesc->nparts;
+
+	while (lo < hi)
+	{
+		int			mid = lo + (hi - lo) / 2;
+		bool		below;
+
+		if (pdesc->lower_unbounded[mid])
+			below = true;
+		else
+		{
+			int32		cmp = partition_cmp(cmpfn, collation,
+											pdesc->lower[mid], value);
+
+			below = inclusive ? (cmp <= 0) : (cmp < 0);
+		}
+
+		if (below)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+/*
+ * Find the first range partition whose upper bound is greater than value.
+ * Returns nparts if there is none.
+ */
+static int
+range_upper_first(PartitionDesc pdesc, FmgrInfo *cmpfn, Oid collation,
+				  Datum value)
+{
+	int			lo = 0;
+	int			hi = pdesc->nparts;
+
+	while (lo < hi)
+	{
+		int			mid = lo + (hi - lo) / 2;
+
+		if (pdesc->upper_unbounded[mid] ||
+			partition_cmp(cmpfn, collation, pdesc->upper[mid], value) > 0)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+
+	return lo;
+}
+
+/*
+ * Count the leading list values that are less than value, or less than or
+ * equal to it if inclusive.
+ */
+static int
+list_value_count(PartitionDesc pdesc, FmgrInfo *cmpfn, Oid collation,
+				 Datum value, bool inclusive)
+{
+	int			lo = 0;
+	int			hi = pdesc->nvalues;
+
+	while (lo < hi)
+	{
+		int			mid = lo + (hi - lo) / 2;
+		int32		cmp = partition_cmp(cmpfn, collation,
+										pdesc->values[mid], value);
+
+		if (inclusive ? (cmp <= 0) : (cmp < 0))
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+/*
+ * Is node a reference to the partition key column, possibly relabeled?
+ */
+static bool
+match_partition_key(PartitionKey key, Index varno, Node *node)
+{
+	while (node && IsA(node, RelabelType))
+		node = (Node *) ((RelabelType *) node)->arg;
+
+	return (node != NULL && IsA(node, Var) &&
+			((Var *) node)->varno == varno &&
+			((Var *) node)->varattno == key->partattnum &&
+			((Var *) node)->varlevelsup == 0);
+}
+
+/*
+ * If "key opno value" can be used for pruning, return the operator's btree
+ * strategy and the comparison function for bounds and values of the
+ * operator's right-hand input type.
+ */
+static bool
+get_clause_cmpfn(PartitionKey key, Oid opno, Oid inputcollid,
+				 int *strategy, FmgrInfo *cmpfn)
+{
+	Oid			lefttype;
+	Oid			righttype;
+	Oid			cmpproc;
+
+	/* The comparison must be done under the key's collation */
+	if (OidIsValid(key->partcollation) && inputcollid != key->partcollation)
+		return false;
+
+	if (!op_in_opfamily(opno, key->partopfamily))
+		return false;
+	get_op_opfamily_properties(opno, key->partopfamily, false,
+							   strategy, &lefttype, &righttype);
+	if (lefttype != key->partopcintype)
+		return false;
+
+	if (righttype == key->partopcintype)
+	{
+		*cmpfn = key->partcmpfn;
+		return true;
+	}
+
+	cmpproc = get_opfamily_proc(key->partopfamily, key->partopcintype,
+								righttype, BTORDER_PROC);
+	if (!RegProcedureIsValid(cmpproc))
+		return false;
+	fmgr_info(cmpproc, cmpfn);
+
+	return true;
+}
+
+/*
+ * Find the partitions that may contain key values satisfying
+ * "key <strategy> value".
+ */
+static Bitmapset *
+prune_by_value(PartitionKey key, PartitionDesc pdesc, int strategy,
+			   FmgrInfo *cmpfn, Datum value)
+{
+	Oid			collation = key->partcollation;
+	Bitmapset  *result = NULL;
+	int			i;
+	int			n;
+
+	if (key->strategy == PARTITION_STRATEGY_RANGE)
+	{
+		switch (strategy)
+		{
+			case BTLessStrategyNumber:
+			case BTLessEqualStrategyNumber:
+				n = range_lower_count(pdesc, cmpfn, collation, value,
+									  strategy == BTLessEqualStrategyNumber);
+				for (i = 0; i < n; i++)
+					result = bms_add_member(result, i);
+				break;
+			case BTEqualStrategyNumber:
+				n = range_lower_count(pdesc, cmpfn, collation, value, true);
+				if (n > 0 &&
+					(pdesc->upper_unbounded[n - 1] ||
+					 partition_cmp(cmpfn, collation,
+								   pdesc->upper[n - 1], value) > 0))
+					result = bms_make_singleton(n - 1);
+				break;
+			case BTGreaterEqualStrategyNumber:
+			case BTGreaterStrategyNumber:
+				n = range_upper_first(pdesc, cmpfn, collation, value);
+				for (i = n; i < pdesc->nparts; i++)
+					result = bms_add_member(result, i);
+				break;
+			default:
+				elog(ERROR, "unrecognized StrategyNumber: %d", strategy);
+		}
+	}
+	else
+	{
+		switch (strategy)
+		{
+			case BTLessStrategyNumber:
+			case BTLessEqualStrategyNumber:
+				n = list_value_count(pdesc, cmpfn, collation, value,
+									 strategy == BTLessEqualStrategyNumber);
+				for (i = 0; i < n; i++)
+					result = bms_add_member(result, pdesc->valueparts[i]);
+				break;
+			case BTEqualStrategyNumber:
+				n = list_value_count(pdesc, cmpfn, collation, value, false);
+				if (n < pdesc->nvalues &&
+					partition_cmp(cmpfn, collation,
+								  pdesc->values[n], value) == 0)
+					result = bms_make_singleton(pdesc->valueparts[n]);
+				break;
+			case BTGreaterEqualStrategyNumber:
+			case BTGreaterStrategyNumber:
+				n = list_value_count(pdesc, cmpfn, collation, value,
+									 strategy == BTGreaterStrategyNumber);
+				for (i = n; i < pdesc->nvalues; i++)
+					result = bms_add_member(result, pdesc->valueparts[i]);
+				break;
+			default:
+				elog(ERROR, "unrecognized StrategyNumber: %d", strategy);
+		}
+	}
+
+	return result;
+}
+
+/*
+ * Work out the partitions that may contain rows satisfying one clause.
+ *
+ * Returns false if the clause can't be used for pruning, else true with the
+ * partitions in *parts.  See get_matching_partitions for paramclauses.
+ */
+static bool
+prune_clause(PartitionKey key, PartitionDesc pdesc, Index varno,
+			 Node *clause, Bitmapset **parts, List **paramclauses)
+{
+	if (IsA(clause, RestrictInfo))
+		clause = (Node *) ((RestrictInfo *) clause)->clause;
+
+	if (and_clause(clause))
+	{
+		Bitmapset  *result = NULL;
+		bool		found = false;
+		ListCell   *lc;
+
+		foreach(lc, ((BoolExpr *) clause)->args)
+		{
+			Bitmapset  *argparts;
+
+			if (!prune_clause(key, pdesc, varno, (Node *) lfirst(lc),
+							  &argparts, paramclauses))
+				continue;
+			if (found)
+			{
+				result = bms_int_members(result, argparts);
+				bms_free(argparts);
+			}
+			else
+				result = argparts;
+			found = true;
+		}
+		*parts = result;
+		return found;
+	}
+	else if (or_clause(clause))
+	{
+		Bitmapset  *result = NULL;
+		ListCell   *lc;
+
+		/* Params can't be used below an OR, since all arms are needed */
+		foreach(lc, ((BoolExpr *) clause)->args)
+		{
+			Bitmapset  *argparts;
+
+			if (!prune_clause(key, pdesc, varno, (Node *) lfirst(lc),
+							  &argparts, NULL))
+			{
+				bms_free(result);
+				return false;
+			}
+			result = bms_join(result, argparts);
+		}
+		*parts = result;
+		return true;
+	}
+	else if (is_opclause(clause) &&
+			 list_length(((OpExpr *) clause)->args) == 2)
+	{
+		OpExpr	   *opclause = (OpExpr *) clause;
+		Node	   *leftop = (Node *) linitial(opclause->args);
+		Node	   *rightop = (Node *) lsecond(opclause->args);
+		Oid			opno = opclause->opno;
+		Node	   *other;
+		int			strategy;
+		FmgrInfo	cmpfn;
+
+		if (match_partition_key(key, varno, leftop))
+			other = rightop;
+		else if (match_partition_key(key, varno, rightop))
+		{
+			other = leftop;
+			opno = get_commutator(opno);
+			if (!OidIsValid(opno))
+				return false;
+		}
+		else
+			return false;
+
+		while (other && IsA(other, RelabelType))
+			other = (Node *) ((RelabelType *) other)->arg;
+
+		if (!get_clause_cmpfn(key, opno, opclause->inputcollid,
+							  &strategy, &cmpfn))
+			return false;
+
+		if (IsA(other, Param) &&
+			((Param *) other)->paramkind == PARAM_EXTERN)
+		{
+			if (paramclauses != NULL)
+				*paramclauses = lappend(*paramclauses, clause);
+			return false;
+		}
+		if (!IsA(other, Const))
+			return false;
+
+		/* btree operators are strict, so a null matches nothing */
+		if (((Const *) other)->constisnull)
+			*parts = NULL;
+		else
+			*parts = prune_by_value(key, pdesc, strategy, &cmpfn,
+									((Const *) other)->constvalue);
+		return true;
+	}
+	else if (IsA(clause, ScalarArrayOpExpr))
+	{
+		ScalarArrayOpExpr *saop = (ScalarArrayOpExpr *) clause;
+		Node	   *arrayop = (Node *) lsecond(saop->args);
+		Const	   *arrayconst;
+		ArrayType  *arr;
+		int16		elmlen;
+		bool		elmbyval;
+		char		elmalign;
+		Datum	   *elems;
+		bool	   *elemnulls;
+		int			nelems;
+		int			strategy;
+		FmgrInfo	cmpfn;
+		Bitmapset  *result = NULL;
+		int			i;
+
+		if (!saop->useOr ||
+			!match_partition_key(key, varno, (Node *) linitial(saop->args)))
+			return false;
+
+		while (arrayop && IsA(arrayop, RelabelType))
+			arrayop = (Node *) ((RelabelType *) arrayop)->arg;
+
+		if (!get_clause_cmpfn(key, saop->opno, saop->inputcollid,
+							  &strategy, &cmpfn))
+			return false;
+
+		if (IsA(arrayop, Param) &&
+			((Param *) arrayop)->paramkind == PARAM_EXTERN)
+		{
+			if (paramclauses != NULL)
+				*paramclauses = lappend(*paramclauses, clause);
+			return false;
+		}
+		if (!IsA(arrayop, Const))
+			return false;
+
+		arrayconst = (Const *) arrayop;
+		if (arrayconst->constisnull)
+		{
+			*parts = NULL;
+			return true;
+		}
+
+		arr = DatumGetArrayTypeP(arrayconst->constvalue);
+		get_typlenbyvalalign(ARR_ELEMTYPE(arr),
+							 &elmlen, &elmbyval, &elmalign);
+		deconstruct_array(arr, ARR_ELEMTYPE(arr),
+						  elmlen, elmbyval, elmalign,
+						  &elems, &elemnulls, &nelems);
+		for (i = 0; i < nelems; i++)
+		{
+			if (elemnulls[i])
+				continue;
+			result = bms_join(result,
+							  prune_by_value(key, pdesc, strategy, &cmpfn,
+											 elems[i]));
+		}
+		*parts = result;
+		return true;
+	}
+
+	return false;
+}
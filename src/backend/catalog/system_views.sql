@@ -626,7 +626,13 @@ CREATE VIEW pg_replication_slots AS
             L.active,
             L.xmin,
             L.catalog_xmin,
-            L.restart_lsn
+            L.restart_lsn,
+            L.spill_txns,
+            L.spill_count,
+            L.spill_bytes,
+            L.stream_txns,
+            L.stream_count,
+            L.stream_bytes
     FROM pg_get_replication_slots() AS L
             LEFT JOIN pg_database D ON (L.datoid = D.oid);
 
@@ -700,6 +706,23 @@ CREATE VIEW pg_stat_archiver AS
         s.stats_reset
     FROM pg_stat_get_archiver() s;
 
+CREATE VIEW pg_stat_autovacuum_queue AS
+    SELECT
+            Q.datid,
+            D.datname,
+            Q.relid,
+            Q.pid,
+            Q.in_progress,
+            Q.priority,
+            Q.do_vacuum,
+            Q.do_analyze,
+            Q.wraparound,
+            Q.n_dead_tup,
+            Q.xid_age,
+            Q.relpages
+    FROM pg_stat_get_autovacuum_queue() AS Q
+            LEFT JOIN pg_database D ON (Q.datid = D.oid);
+
 CREATE VIEW pg_stat_bgwriter AS
     SELECT
         pg_stat_get_bgwriter_timed_checkpoints() AS checkpoints_timed,
@@ -578,13 +578,19 @@ do_analyze_rel(Relation onerel, VacuumStmt *vacstmt,
 	 * inherited stats.
 	 */
 	if (!inh)
+	{
+		BlockNumber relallvisible;
+
+		visibilitymap_count(onerel, &relallvisible, NULL);
+
 		vac_update_relstats(onerel,
 							relpages,
 							totalrows,
-							visibilitymap_count(onerel),
+							relallvisible,
 							hasindex,
 							InvalidTransactionId,
 							InvalidMultiXactId);
+	}
 
 	/*
 	 * Same for indexes. Vacuum always scans all indexes, so if we're part of
@@ -23,29 +23,45 @@
 #include "access/heapam.h"
 #include "access/htup_details.h"
 #include "access/sysattr.h"
+#include "access/transam.h"
 #include "access/xact.h"
 #include "catalog/namespace.h"
+#include "catalog/partition.h"
 #include "catalog/pg_type.h"
 #include "commands/copy.h"
+#include "commands/dbcommands.h"
 #include "commands/defrem.h"
 #include "commands/trigger.h"
+#include "executor/execPartition.h"
 #include "executor/executor.h"
 #include "libpq/libpq.h"
 #include "libpq/pqformat.h"
+#include "libpq/pqsignal.h"
 #include "mb/pg_wchar.h"
 #include "miscadmin.h"
 #include "optimizer/clauses.h"
 #include "optimizer/planner.h"
 #include "parser/parse_relation.h"
+#include "postmaster/bgworker.h"
 #include "rewrite/rewriteHandler.h"
+#include "storage/dsm.h"
+#include "storage/dsm_impl.h"
 #include "storage/fd.h"
+#include "storage/ipc.h"
+#include "storage/proc.h"
+#include "storage/shm_mq.h"
+#include "storage/shm_toc.h"
+#include "storage/spin.h"
 #include "tcop/tcopprot.h"
 #include "utils/acl.h"
 #include "utils/builtins.h"
+#include "utils/fmgroids.h"
+#include "utils/guc.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
 #include "utils/portal.h"
 #include "utils/rel.h"
+#include "utils/resowner.h"
 #include "utils/snapmgr.h"
 
 
@@ -74,6 +90,35 @@ typedef enum EolType
 	EOL_CRNL
 } EolType;
 
+/*
+ * Output fast paths for COPY TO in text and CSV format.  A column whose
+ * type's output function is one of these is converted without calling the
+ * output function: integers are written straight into the output buffer,
+ * and the bytes of text values are escaped where they are, rather than
+ * after being copied into a palloc'd cstring.
+ */
+typedef enum CopyOutKind
+{
+	COPY_OUT_GENERIC,			/* call the output function */
+	COPY_OUT_INT2,
+	COPY_OUT_INT4,
+	COPY_OUT_INT8,
+	COPY_OUT_TEXT				/* text, varchar or bpchar */
+} CopyOutKind;
+
+/*
+ * The set of bytes a COPY TO escaping loop has to stop at, both as a lookup
+ * table and in a form that lets CopyScanOut check eight bytes at a time.
+ */
+typedef struct CopyOutScan
+{
+	bool		special[256];	/* does the loop need to look at this byte? */
+	bool		controls;		/* are all bytes below 0x20 special? */
+	bool		highbit;		/* are all bytes with the high bit set? */
+	int			nchars;
+	uint64		chars[4];		/* other special bytes, repeated 8 times */
+} CopyOutScan;
+
 /*
  * This struct contains all the state variables used throughout a COPY
  * operation. For simplicity, we use the same struct for all variants of COPY,
@@ -130,6 +175,7 @@ typedef struct CopyStateData
 	bool		convert_selectively;	/* do selective binary conversion? */
 	List	   *convert_select; /* list of column names (can be NIL) */
 	bool	   *convert_select_flags;	/* per-column CSV/TEXT CS flags */
+	int			parallel_workers;	/* # of parse workers, 0 if serial */
 
 	/* these are just for error messages, see CopyFromErrorCallback */
 	const char *cur_relname;	/* table name for error messages */
@@ -146,6 +192,10 @@ typedef struct CopyStateData
 	 * Working state for COPY TO
 	 */
 	FmgrInfo   *out_functions;	/* lookup info for output functions */
+	CopyOutKind *out_kinds;		/* fast paths, for text and CSV format */
+	CopyOutScan *out_scan;		/* bytes to stop at in text format */
+	CopyOutScan *out_csv_quote_scan;	/* bytes that make CSV quoting needed */
+	CopyOutScan *out_csv_escape_scan;	/* bytes to escape in quoted CSV */
 	MemoryContext rowcontext;	/* per-row evaluation context */
 
 	/*
@@ -200,6 +250,9 @@ typedef struct CopyStateData
 	int			raw_buf_len;	/* total # of bytes stored */
 } CopyStateData;
 
+/* Leader-private state for a parallel COPY FROM; see below */
+typedef struct ParallelCopyState ParallelCopyState;
+
 /* DestReceiver for COPY (SELECT) TO */
 typedef struct
 {
@@ -297,6 +350,15 @@ static void CopyFromInsertBatch(CopyState cstate, EState *estate,
 					BulkInsertState bistate,
 					int nBufferedTuples, HeapTuple *bufferedTuples,
 					int firstBufferedLineNo);
+static void CopyFieldsToValues(CopyState cstate, TupleDesc tupDesc,
+				   char **field_strings, int fldct,
+				   Datum *values, bool *nulls, Oid *tupleOid);
+static ParallelCopyState *BeginParallelCopyFrom(CopyState cstate,
+					  TupleDesc tupDesc);
+static HeapTuple ParallelCopyFromNext(ParallelCopyState *pcopy,
+					 ExprContext *econtext, Datum *values, bool *nulls);
+static void EndParallelCopyFrom(ParallelCopyState *pcopy);
+static void ParallelCopyTerminateWorkers(dsm_segment *seg, Datum arg);
 static bool CopyReadLine(CopyState cstate);
 static bool CopyReadLineText(CopyState cstate);
 static int	CopyReadAttributesText(CopyState cstate);
@@ -305,9 +367,16 @@ static Datum CopyReadBinaryAttribute(CopyState cstate,
 						int column_no, FmgrInfo *flinfo,
 						Oid typioparam, int32 typmod,
 						bool *isnull);
-static void CopyAttributeOutText(CopyState cstate, char *string);
-static void CopyAttributeOutCSV(CopyState cstate, char *string,
-					bool use_quote, bool single_attr);
+static CopyOutKind CopyGetOutKind(CopyState cstate, int attnum,
+			   Oid out_func_oid);
+static void CopyInitOutScan(CopyOutScan *scan, const char *chars,
+				bool controls, bool highbit);
+static void CopyAttributeOutInteger(CopyState cstate, CopyOutKind kind,
+						Datum value);
+static void CopyAttributeOutText(CopyState cstate, const char *string,
+					 int len);
+static void CopyAttributeOutCSV(CopyState cstate, const char *string,
+					int len, bool use_quote, bool single_attr);
 static List *CopyGetAttnums(TupleDesc tupDesc, Relation rel,
 			   List *attnamelist);
 static char *limit_printout_length(const char *str);
@@ -902,6 +971,7 @@ ProcessCopyOptions(CopyState cstate,
 				   List *options)
 {
 	bool		format_specified = false;
+	bool		parallel_specified = false;
 	ListCell   *option;
 
 	/* Support external use for option sanity checking */
@@ -1068,6 +1138,20 @@ ProcessCopyOptions(CopyState cstate,
 						 errmsg("argument to option \"%s\" must be a valid encoding name",
 								defel->defname)));
 		}
+		else if (strcmp(defel->defname, "parallel") == 0)
+		{
+			if (parallel_specified)
+				ereport(ERROR,
+						(errcode(ERRCODE_SYNTAX_ERROR),
+						 errmsg("conflicting or redundant options")));
+			parallel_specified = true;
+			cstate->parallel_workers = defGetInt32(defel);
+			if (cstate->parallel_workers < 0)
+				ereport(ERROR,
+						(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+						 errmsg("argument to option \"%s\" must not be negative",
+								defel->defname)));
+		}
 		else
 			ereport(ERROR,
 					(errcode(ERRCODE_SYNTAX_ERROR),
@@ -1205,6 +1289,16 @@ ProcessCopyOptions(CopyState cstate,
 				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
 			  errmsg("COPY force null only available using COPY FROM")));
 
+	/* Check parallel */
+	if (cstate->parallel_workers > 0 && !is_from)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("COPY parallel only available using COPY FROM")));
+	if (cstate->parallel_workers > 0 && cstate->binary)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("cannot specify PARALLEL in BINARY mode")));
+
 	/* Don't allow the delimiter to appear in the null string. */
 	if (strchr(cstate->null_print, cstate->delim[0]) != NULL)
 		ereport(ERROR,
@@ -1709,6 +1803,7 @@ CopyTo(CopyState cstate)
 
 	/* Get info about the columns we need to process. */
 	cstate->out_functions = (FmgrInfo *) palloc(num_phys_attrs * sizeof(FmgrInfo));
+	cstate->out_kinds = (CopyOutKind *) palloc0(num_phys_attrs * sizeof(CopyOutKind));
 	foreach(cur, cstate->attnumlist)
 	{
 		int			attnum = lfirst_int(cur);
@@ -1720,12 +1815,50 @@ CopyTo(CopyState cstate)
 									&out_func_oid,
 									&isvarlena);
 		else
+		{
 			getTypeOutputInfo(attr[attnum - 1]->atttypid,
 							  &out_func_oid,
 							  &isvarlena);
+			cstate->out_kinds[attnum - 1] = CopyGetOutKind(cstate, attnum,
+														   out_func_oid);
+		}
 		fmgr_info(out_func_oid, &cstate->out_functions[attnum - 1]);
 	}
 
+	/* Set up the escaping loops' sets of bytes to look at */
+	if (!cstate->binary)
+	{
+		char		chars[5];
+
+		if (cstate->csv_mode)
+		{
+			chars[0] = cstate->delim[0];
+			chars[1] = cstate->quote[0];
+			chars[2] = '\n';
+			chars[3] = '\r';
+			chars[4] = '\0';
+			cstate->out_csv_quote_scan = palloc(sizeof(CopyOutScan));
+			CopyInitOutScan(cstate->out_csv_quote_scan, chars, false,
+							cstate->encoding_embeds_ascii);
+
+			chars[0] = cstate->quote[0];
+			chars[1] = cstate->escape[0];
+			chars[2] = '\0';
+			cstate->out_csv_escape_scan = palloc(sizeof(CopyOutScan));
+			CopyInitOutScan(cstate->out_csv_escape_scan, chars, false,
+							cstate->encoding_embeds_ascii);
+		}
+		else
+		{
+			chars[0] = '\\';
+			chars[1] = cstate->delim[0];
+			chars[2] = '\0';
+			cstate->out_scan = palloc(sizeof(CopyOutScan));
+			CopyInitOutScan(cstate->out_scan, chars, true,
+							cstate->encoding_embeds_ascii);
+		}
+	}
+
 	/*
 	 * Create a temporary memory context that we can reset once per row to
 	 * recover palloc'd memory.  This avoids any problems with leaks inside
@@ -1781,7 +1914,7 @@ CopyTo(CopyState cstate)
 
 				colname = NameStr(attr[attnum - 1]->attname);
 
-				CopyAttributeOutCSV(cstate, colname, false,
+				CopyAttributeOutCSV(cstate, colname, strlen(colname), false,
 									list_length(cstate->attnumlist) == 1);
 			}
 
@@ -1903,14 +2036,36 @@ CopyOneRowTo(CopyState cstate, Oid tupleOid, Datum *values, bool *nulls)
 		{
 			if (!cstate->binary)
 			{
-				string = OutputFunctionCall(&out_functions[attnum - 1],
-											value);
+				CopyOutKind kind = cstate->out_kinds[attnum - 1];
+				int			len;
+
+				if (kind == COPY_OUT_INT2 || kind == COPY_OUT_INT4 ||
+					kind == COPY_OUT_INT8)
+				{
+					CopyAttributeOutInteger(cstate, kind, value);
+					continue;
+				}
+
+				if (kind == COPY_OUT_TEXT)
+				{
+					text	   *t = DatumGetTextPP(value);
+
+					string = VARDATA_ANY(t);
+					len = VARSIZE_ANY_EXHDR(t);
+				}
+				else
+				{
+					string = OutputFunctionCall(&out_functions[attnum - 1],
+												value);
+					len = strlen(string);
+				}
+
 				if (cstate->csv_mode)
-					CopyAttributeOutCSV(cstate, string,
+					CopyAttributeOutCSV(cstate, string, len,
 										cstate->force_quote_flags[attnum - 1],
 										list_length(cstate->attnumlist) == 1);
 				else
-					CopyAttributeOutText(cstate, string);
+					CopyAttributeOutText(cstate, string, len);
 			}
 			else
 			{
@@ -2049,6 +2204,8 @@ CopyFrom(CopyState cstate)
 	Datum	   *values;
 	bool	   *nulls;
 	ResultRelInfo *resultRelInfo;
+	ResultRelInfo *saved_resultRelInfo;
+	PartitionTupleRouting *proute = NULL;
 	EState	   *estate = CreateExecutorState(); /* for ExecConstraints() */
 	ExprContext *econtext;
 	TupleTableSlot *myslot;
@@ -2066,6 +2223,7 @@ CopyFrom(CopyState cstate)
 	HeapTuple  *bufferedTuples = NULL;	/* initialize to silence warning */
 	Size		bufferedTuplesSize = 0;
 	int			firstBufferedLineNo = 0;
+	ParallelCopyState *pcopy = NULL;
 
 	Assert(cstate->rel);
 
@@ -2191,6 +2349,18 @@ CopyFrom(CopyState cstate)
 	/* Triggers might need a slot as well */
 	estate->es_trig_tuple_slot = ExecInitExtraTupleSlot(estate);
 
+	/*
+	 * Rows copied into a partitioned table are routed to its partitions.  The
+	 * heap_insert options chosen above are based on the partitioned table,
+	 * so they don't apply to its partitions.
+	 */
+	if (RelationGetPartitionKey(cstate->rel) != NULL)
+	{
+		proute = ExecSetupPartitionTupleRouting(resultRelInfo, estate);
+		hi_options = 0;
+	}
+	saved_resultRelInfo = resultRelInfo;
+
 	/*
 	 * It's more efficient to prepare a bunch of tuples for insertion, and
 	 * insert them in one heap_multi_insert() call, than call heap_insert()
@@ -2198,9 +2368,12 @@ CopyFrom(CopyState cstate)
 	 * BEFORE/INSTEAD OF triggers, or we need to evaluate volatile default
 	 * expressions. Such triggers or expressions might query the table we're
 	 * inserting to, and act differently if the tuples that have already been
-	 * processed and prepared for insertion are not there.
+	 * processed and prepared for insertion are not there.  Nor can we do it
+	 * when routing rows to partitions, as consecutive rows may belong in
+	 * different partitions.
 	 */
-	if ((resultRelInfo->ri_TrigDesc != NULL &&
+	if (proute != NULL ||
+		(resultRelInfo->ri_TrigDesc != NULL &&
 		 (resultRelInfo->ri_TrigDesc->trig_insert_before_row ||
 		  resultRelInfo->ri_TrigDesc->trig_insert_instead_row)) ||
 		cstate->volatile_defexprs)
@@ -2230,6 +2403,10 @@ CopyFrom(CopyState cstate)
 	bistate = GetBulkInsertState();
 	econtext = GetPerTupleExprContext(estate);
 
+	/* Hand the parsing to background workers, if asked to and possible */
+	if (cstate->parallel_workers > 0)
+		pcopy = BeginParallelCopyFrom(cstate, tupDesc);
+
 	/* Set up callback to identify error line number */
 	errcallback.callback = CopyFromErrorCallback;
 	errcallback.arg = (void *) cstate;
@@ -2257,14 +2434,23 @@ CopyFrom(CopyState cstate)
 		/* Switch into its memory context */
 		MemoryContextSwitchTo(GetPerTupleMemoryContext(estate));
 
-		if (!NextCopyFrom(cstate, econtext, values, nulls, &loaded_oid))
-			break;
+		if (pcopy != NULL)
+		{
+			tuple = ParallelCopyFromNext(pcopy, econtext, values, nulls);
+			if (tuple == NULL)
+				break;
+		}
+		else
+		{
+			if (!NextCopyFrom(cstate, econtext, values, nulls, &loaded_oid))
+				break;
 
-		/* And now we can form the input tuple. */
-		tuple = heap_form_tuple(tupDesc, values, nulls);
+			/* And now we can form the input tuple. */
+			tuple = heap_form_tuple(tupDesc, values, nulls);
 
-		if (loaded_oid != InvalidOid)
-			HeapTupleSetOid(tuple, loaded_oid);
+			if (loaded_oid != InvalidOid)
+				HeapTupleSetOid(tuple, loaded_oid);
+		}
 
 		/*
 		 * Constraints might reference the tableoid column, so initialize
@@ -2279,6 +2465,19 @@ CopyFrom(CopyState cstate)
 		slot = myslot;
 		ExecStoreTuple(tuple, slot, InvalidBuffer, false);
 
+		/* Switch to the partition the tuple belongs in, if any */
+		if (proute != NULL)
+		{
+			int			partidx;
+
+			partidx = ExecFindPartition(proute, slot, estate);
+			resultRelInfo = ExecGetPartitionInfo(proute, partidx, estate);
+			slot = ExecConvertToPartition(proute, partidx, slot);
+			tuple = ExecMaterializeSlot(slot);
+			tuple->t_tableOid = RelationGetRelid(resultRelInfo->ri_RelationDesc);
+			estate->es_result_relation_info = resultRelInfo;
+		}
+
 		skip_tuple = false;
 
 		/* BEFORE ROW INSERT Triggers */
@@ -2296,8 +2495,10 @@ CopyFrom(CopyState cstate)
 		if (!skip_tuple)
 		{
 			/* Check the constraints of the tuple */
-			if (cstate->rel->rd_att->constr)
+			if (resultRelInfo->ri_RelationDesc->rd_att->constr)
 				ExecConstraints(resultRelInfo, slot, estate);
+			if (resultRelInfo->ri_PartitionCheck && proute == NULL)
+				ExecPartitionCheck(resultRelInfo, slot, estate);
 
 			if (useHeapMultiInsert)
 			{
@@ -2328,8 +2529,13 @@ CopyFrom(CopyState cstate)
 			{
 				List	   *recheckIndexes = NIL;
 
-				/* OK, store the tuple and create index entries for it */
-				heap_insert(cstate->rel, tuple, mycid, hi_options, bistate);
+				/*
+				 * OK, store the tuple and create index entries for it.  The
+				 * bulk insert state can't be shared between partitions, as
+				 * it keeps the target buffer pinned.
+				 */
+				heap_insert(resultRelInfo->ri_RelationDesc, tuple, mycid,
+							hi_options, proute != NULL ? NULL : bistate);
 
 				if (resultRelInfo->ri_NumIndices > 0)
 					recheckIndexes = ExecInsertIndexTuples(slot, &(tuple->t_self),
@@ -2349,6 +2555,9 @@ CopyFrom(CopyState cstate)
 			 */
 			processed++;
 		}
+
+		resultRelInfo = saved_resultRelInfo;
+		estate->es_result_relation_info = resultRelInfo;
 	}
 
 	/* Flush any remaining buffered tuples */
@@ -2358,6 +2567,9 @@ CopyFrom(CopyState cstate)
 							nBufferedTuples, bufferedTuples,
 							firstBufferedLineNo);
 
+	if (pcopy != NULL)
+		EndParallelCopyFrom(pcopy);
+
 	/* Done, clean up */
 	error_context_stack = errcallback.previous;
 
@@ -2377,6 +2589,8 @@ CopyFrom(CopyState cstate)
 	ExecResetTupleTable(estate->es_tupleTable, false);
 
 	ExecCloseIndices(resultRelInfo);
+	if (proute != NULL)
+		ExecCleanupPartitionTupleRouting(proute);
 
 	FreeExecutorState(estate);
 
@@ -2752,6 +2966,124 @@ NextCopyFromRawFields(CopyState cstate, char ***fields, int *nfields)
 	return true;
 }
 
+/*
+ * Convert the raw fields of a text or CSV line into column values.
+ *
+ * 'values' and 'nulls' must have been initialized to all NULLs; only the
+ * columns in attnumlist are filled in.  This is separate from NextCopyFrom
+ * so that parallel COPY workers, which get their lines from the leader
+ * rather than from the input, can use it too.
+ */
+static void
+CopyFieldsToValues(CopyState cstate, TupleDesc tupDesc,
+				   char **field_strings, int fldct,
+				   Datum *values, bool *nulls, Oid *tupleOid)
+{
+	Form_pg_attribute *attr = tupDesc->attrs;
+	AttrNumber	attr_count = list_length(cstate->attnumlist);
+	bool		file_has_oids = cstate->file_has_oids;
+	int			nfields = file_has_oids ? (attr_count + 1) : attr_count;
+	FmgrInfo   *in_functions = cstate->in_functions;
+	Oid		   *typioparams = cstate->typioparams;
+	ListCell   *cur;
+	int			fieldno;
+	char	   *string;
+
+	/* check for overflowing fields */
+	if (nfields > 0 && fldct > nfields)
+		ereport(ERROR,
+				(errcode(ERRCODE_BAD_COPY_FILE_FORMAT),
+				 errmsg("extra data after last expected column")));
+
+	fieldno = 0;
+
+	/* Read the OID field if present */
+	if (file_has_oids)
+	{
+		if (fieldno >= fldct)
+			ereport(ERROR,
+					(errcode(ERRCODE_BAD_COPY_FILE_FORMAT),
+					 errmsg("missing data for OID column")));
+		string = field_strings[fieldno++];
+
+		if (string == NULL)
+			ereport(ERROR,
+					(errcode(ERRCODE_BAD_COPY_FILE_FORMAT),
+					 errmsg("null OID in COPY data")));
+		else if (cstate->oids && tupleOid != NULL)
+		{
+			cstate->cur_attname = "oid";
+			cstate->cur_attval = string;
+			*tupleOid = DatumGetObjectId(DirectFunctionCall1(oidin,
+											   CStringGetDatum(string)));
+			if (*tupleOid == InvalidOid)
+				ereport(ERROR,
+						(errcode(ERRCODE_BAD_COPY_FILE_FORMAT),
+						 errmsg("invalid OID in COPY data")));
+			cstate->cur_attname = NULL;
+			cstate->cur_attval = NULL;
+		}
+	}
+
+	/* Loop to read the user attributes on the line. */
+	foreach(cur, cstate->attnumlist)
+	{
+		int			attnum = lfirst_int(cur);
+		int			m = attnum - 1;
+
+		if (fieldno >= fldct)
+			ereport(ERROR,
+					(errcode(ERRCODE_BAD_COPY_FILE_FORMAT),
+					 errmsg("missing data for column \"%s\"",
+							NameStr(attr[m]->attname))));
+		string = field_strings[fieldno++];
+
+		if (cstate->convert_select_flags &&
+			!cstate->convert_select_flags[m])
+		{
+			/* ignore input field, leaving column as NULL */
+			continue;
+		}
+
+		if (cstate->csv_mode)
+		{
+			if(string == NULL &&
+			   cstate->force_notnull_flags[m])
+			{
+				/*
+				 * FORCE_NOT_NULL option is set and column is NULL -
+				 * convert it to the NULL string.
+				 */
+				string = cstate->null_print;
+			}
+			else if(string != NULL && cstate->force_null_flags[m]
+					&& strcmp(string,cstate->null_print) == 0 )
+			{
+				/*
+				 * FORCE_NULL option is set and column matches the NULL string.
+				 * It must have been quoted, or otherwise the string would already
+				 * have been set to NULL.
+				 * Convert it to NULL as specified.
+				 */
+				string = NULL;
+			}
+		}
+
+		cstate->cur_attname = NameStr(attr[m]->attname);
+		cstate->cur_attval = string;
+		values[m] = InputFunctionCall(&in_functions[m],
+									  string,
+									  typioparams[m],
+									  attr[m]->atttypmod);
+		if (string != NULL)
+			nulls[m] = false;
+		cstate->cur_attname = NULL;
+		cstate->cur_attval = NULL;
+	}
+
+	Assert(fieldno == nfields);
+}
+
 /*
  * Read next tuple from file for COPY FROM. Return false if no more tuples.
  *
@@ -2775,7 +3107,6 @@ NextCopyFrom(CopyState cstate, ExprContext *econtext,
 	FmgrInfo   *in_functions = cstate->in_functions;
 	Oid		   *typioparams = cstate->typioparams;
 	int			i;
-	int			nfields;
 	bool		isnull;
 	bool		file_has_oids = cstate->file_has_oids;
 	int		   *defmap = cstate->defmap;
@@ -2785,7 +3116,6 @@ NextCopyFrom(CopyState cstate, ExprContext *econtext,
 	attr = tupDesc->attrs;
 	num_phys_attrs = tupDesc->natts;
 	attr_count = list_length(cstate->attnumlist);
-	nfields = file_has_oids ? (attr_count + 1) : attr_count;
 
 	/* Initialize all values for row to NULL */
 	MemSet(values, 0, num_phys_attrs * sizeof(Datum));
@@ -2794,108 +3124,14 @@ NextCopyFrom(CopyState cstate, ExprContext *econtext,
 	if (!cstate->binary)
 	{
 		char	  **field_strings;
-		ListCell   *cur;
 		int			fldct;
-		int			fieldno;
-		char	   *string;
 
 		/* read raw fields in the next line */
 		if (!NextCopyFromRawFields(cstate, &field_strings, &fldct))
 			return false;
 
-		/* check for overflowing fields */
-		if (nfields > 0 && fldct > nfields)
-			ereport(ERROR,
-					(errcode(ERRCODE_BAD_COPY_FILE_FORMAT),
-					 errmsg("extra data after last expected column")));
-
-		fieldno = 0;
-
-		/* Read the OID field if present */
-		if (file_has_oids)
-		{
-			if (fieldno >= fldct)
-				ereport(ERROR,
-						(errcode(ERRCODE_BAD_COPY_FILE_FORMAT),
-						 errmsg("missing data for OID column")));
-			string = field_strings[fieldno++];
-
-			if (string == NULL)
-				ereport(ERROR,
-						(errcode(ERRCODE_BAD_COPY_FILE_FORMAT),
-						 errmsg("null OID in COPY data")));
-			else if (cstate->oids && tupleOid != NULL)
-			{
-				cstate->cur_attname = "oid";
-				cstate->cur_attval = string;
-				*tupleOid = DatumGetObjectId(DirectFunctionCall1(oidin,
-												   CStringGetDatum(string)));
-				if (*tupleOid == InvalidOid)
-					ereport(ERROR,
-							(errcode(ERRCODE_BAD_COPY_FILE_FORMAT),
-							 errmsg("invalid OID in COPY data")));
-				cstate->cur_attname = NULL;
-				cstate->cur_attval = NULL;
-			}
-		}
-
-		/* Loop to read the user attributes on the line. */
-		foreach(cur, cstate->attnumlist)
-		{
-			int			attnum = lfirst_int(cur);
-			int			m = attnum - 1;
-
-			if (fieldno >= fldct)
-				ereport(ERROR,
-						(errcode(ERRCODE_BAD_COPY_FILE_FORMAT),
-						 errmsg("missing data for column \"%s\"",
-								NameStr(attr[m]->attname))));
-			string = field_strings[fieldno++];
-
-			if (cstate->convert_select_flags &&
-				!cstate->convert_select_flags[m])
-			{
-				/* ignore input field, leaving column as NULL */
-				continue;
-			}
-
-			if (cstate->csv_mode)
-			{
-				if(string == NULL &&
-				   cstate->force_notnull_flags[m])
-				{
-					/*
-					 * FORCE_NOT_NULL option is set and column is NULL -
-					 * convert it to the NULL string.
-					 */
-					string = cstate->null_print;
-				}
-				else if(string != NULL && cstate->force_null_flags[m]
-						&& strcmp(string,cstate->null_print) == 0 )
-				{
-					/*
-					 * FORCE_NULL option is set and column matches the NULL string.
-					 * It must have been quoted, or otherwise the string would already
-					 * have been set to NULL.
-					 * Convert it to NULL as specified.
-					 */
-					string = NULL;
-				}
-			}
-
-			cstate->cur_attname = NameStr(attr[m]->attname);
-			cstate->cur_attval = string;
-			values[m] = InputFunctionCall(&in_functions[m],
-										  string,
-										  typioparams[m],
-										  attr[m]->atttypmod);
-			if (string != NULL)
-				nulls[m] = false;
-			cstate->cur_attname = NULL;
-			cstate->cur_attval = NULL;
-		}
-
-		Assert(fieldno == nfields);
+		CopyFieldsToValues(cstate, tupDesc, field_strings, fldct,
+						   values, nulls, tupleOid);
 	}
 	else
 	{
@@ -3013,37 +3249,1105 @@ EndCopyFrom(CopyState cstate)
 }
 
 /*
- * Read the next input line and stash it in line_buf, with conversion to
- * server encoding.
+ * Parallel COPY FROM
  *
- * Result is true if read was terminated by EOF, false if terminated
- * by newline.	The terminating newline or EOF marker is not included
- * in the final value of line_buf.
+ * With the PARALLEL option, COPY FROM in text or CSV format hands the work
+ * of splitting lines into fields and running the columns' input functions
+ * to background workers.  The leader still reads the input, since only it
+ * is connected to the client or has the file open, and it still does all
+ * the inserting: a worker can't write into the leader's transaction, and
+ * doing the inserts in one process keeps the rows in input order, together
+ * with triggers, defaults and constraint checks.
+ *
+ * The leader reads lines (converted to server encoding) into fixed-size
+ * chunks in a ring in dynamic shared memory.  Each worker claims the next
+ * filled chunk, turns every line in it into a heap tuple, and sends all the
+ * tuples of the chunk back to the leader over its own shm_mq.  The leader
+ * consumes the chunks strictly in input order, so whichever worker claimed
+ * a chunk, the rows come out in the order they were read.  A chunk nobody
+ * has claimed by the time the leader needs it is parsed by the leader
+ * itself, so a slow or missing worker never stalls the load.
+ *
+ * Errors have to look to the client exactly as they do in a serial COPY.
+ * A worker that fails on any line of a chunk tells the leader the chunk
+ * failed and then exits on the error, so a bad chunk costs a worker and
+ * leaves an ERROR from it in the server log.  The leader parses that chunk
+ * again itself once it gets to it, and so throws the error itself, with the
+ * same line number and context, after processing all the rows before it.
+ * Errors while reading the input, such as an invalid encoding or an
+ * unterminated CSV quote, are thrown right away by the leader as it reads
+ * ahead to fill the chunks, with the line number of the bad line; rows
+ * before it that were read but not yet inserted are simply not inserted.
+ *
+ * Only columns of built-in base types are parsed in parallel: their input
+ * functions depend on nothing but the GUCs we pass to the workers, whereas
+ * a domain's constraints or a user-defined type's input function might
+ * look at the leader's uncommitted state.  Anything else, and COPY with
+ * OIDS, silently uses the serial code.
+ */
+
+/*
+ * Magic number and table-of-contents keys for the dynamic shared memory
+ * segment used by a parallel COPY FROM.
+ */
+#define PARALLEL_COPY_MAGIC				0x50434f50
+#define PARALLEL_COPY_KEY_SHARED		1
+#define PARALLEL_COPY_KEY_ATTNUMS		2
+#define PARALLEL_COPY_KEY_STRINGS		3
+#define PARALLEL_COPY_KEY_CHUNKS		4
+#define PARALLEL_COPY_KEY_QUEUES		5
+
+/* Size of the line data in one chunk, and chunks in the ring per worker */
+#define PARALLEL_COPY_CHUNK_SIZE		65536
+#define PARALLEL_COPY_CHUNKS_PER_WORKER	4
+
+/* Size of each worker's queue for sending tuples to the leader */
+#define PARALLEL_COPY_QUEUE_SIZE		262144
+
+/*
+ * GUCs that influence the input functions of built-in types.  The leader's
+ * values are passed to the workers, so that they parse exactly as the
+ * leader would.
+ */
+static const char *const parallel_copy_gucs[] = {
+	"DateStyle",
+	"IntervalStyle",
+	"TimeZone",
+	"timezone_abbreviations",
+	"lc_monetary",
+	"lc_numeric",
+	"array_nulls",
+	"xmloption",
+	"search_path"
+};
+
+/* Per-attribute information a worker needs, from the relation's tupdesc */
+typedef struct ParallelCopyAttr
+{
+	FormData_pg_attribute attr;	/* only the fixed part is valid */
+	bool		force_notnull;
+	bool		force_null;
+} ParallelCopyAttr;
+
+/*
+ * Shared state of a parallel COPY FROM, stored at PARALLEL_COPY_KEY_SHARED.
+ * Only the fields protected by the mutex change once workers are launched.
+ */
+typedef struct ParallelCopyShared
+{
+	slock_t		mutex;			/* protects the following four fields */
+	int			nattached;		/* # of workers that have started */
+	uint64		nfilled;		/* # of chunks the leader has filled */
+	uint64		next_claim;		/* next chunk for anyone to parse */
+	bool		finished;		/* no more chunks will be filled */
+
+	char		dbname[NAMEDATALEN];
+	TimestampTz xact_start;		/* leader's transaction_timestamp() */
+	TimestampTz stmt_start;		/* leader's statement_timestamp() */
+	int			nworkers;
+	int			nchunks;
+	bool		csv_mode;
+	char		delim;
+	char		quote;
+	char		escape;
+	Oid			reltype;
+	bool		relhasoids;
+	int			natts;			/* # of attributes in the relation */
+	int			nattnums;		/* # of columns in the input */
+	ParallelCopyAttr attrs[FLEXIBLE_ARRAY_MEMBER];
+} ParallelCopyShared;
+
+/*
+ * One chunk of input lines.  Each line is stored as an int32 length and an
+ * int32 line number, followed by that many bytes and a terminating zero
+ * byte, padded to int alignment.  The line number is the one a serial COPY
+ * would report for the line; it isn't simply one more than the previous
+ * line's, as a CSV line can span several lines of input.  worker is set
+ * under the mutex when a worker claims the chunk.
+ */
+typedef struct ParallelCopyChunk
+{
+	int			worker;			/* index of worker that claimed the chunk */
+	int			nlines;
+	Size		used;			/* bytes of data in use */
+	char		data[PARALLEL_COPY_CHUNK_SIZE];
+} ParallelCopyChunk;
+
+#define PCOPY_LINE_HDRSZ		(2 * sizeof(int32))
+#define PCOPY_LINE_SPACE(len)	INTALIGN(PCOPY_LINE_HDRSZ + (len) + 1)
+
+/*
+ * A worker's reply for one chunk: this header, then for each line a uint32
+ * tuple length and the tuple's HeapTupleHeader and data.  ntuples is -1 if
+ * the worker failed to parse the chunk.
+ */
+typedef struct ParallelCopyReply
+{
+	uint64		chunkno;
+	int32		ntuples;
+} ParallelCopyReply;
+
+/* Leader-private state for a parallel COPY FROM */
+struct ParallelCopyState
+{
+	CopyState	cstate;
+	TupleDesc	tupDesc;
+	dsm_segment *seg;
+	ParallelCopyShared *shared;
+	ParallelCopyChunk *chunks;
+	shm_mq	  **queues;
+	shm_mq_handle **mqhs;
+	int			nlaunched;
+	BackgroundWorkerHandle **handles;
+
+	/* reading the input */
+	int			read_lineno;	/* line number of last line read */
+	bool		eof;			/* no more lines to read? */
+	bool		have_pending;	/* a line read but not yet in a chunk? */
+	bool		pending_oversized;	/* ... and too long for any chunk? */
+	int			pending_lineno;
+	StringInfoData pending;
+	uint64		nfilled;		/* local copy of shared->nfilled */
+
+	/* consuming the rows of the current batch of lines */
+	uint64		nconsumed;		/* # of chunks completely consumed */
+	bool		in_chunk;		/* consuming chunk # nconsumed? */
+	bool		in_oversized;	/* consuming the oversized pending line? */
+	bool		local;			/* parsing the batch ourselves? */
+	char	   *next_line;		/* next line record in the batch */
+	int			lines_left;
+	char	   *next_tuple;		/* next tuple in the worker's reply */
+	char	   *reply_end;
+};
+
+/* Worker-side state, used to report which chunk failed */
+typedef struct ParallelCopyWorkerState
+{
+	uint64		chunkno;
+	bool		have_chunk;
+} ParallelCopyWorkerState;
+
+#define PCOPY_CHUNK(chunks, chunkno, nchunks) \
+	(&(chunks)[(chunkno) % (nchunks)])
+
+/*
+ * Can a worker run the input function of this column type?
+ *
+ * Only built-in base types qualify, and arrays of them, because a worker
+ * has to find the same input function and get the same result from it as
+ * the leader would.  The reg* types are excluded: their input functions
+ * look up catalog entries, which the worker doesn't see as the leader does,
+ * e.g. ones created earlier in the leader's transaction, or ones found
+ * through a temporary schema in the search path.
  */
 static bool
-CopyReadLine(CopyState cstate)
+ParallelCopyTypeIsSafe(Oid typid)
 {
-	bool		result;
+	Oid			elemtype;
 
-	resetStringInfo(&cstate->line_buf);
-	cstate->line_buf_valid = true;
+	if (typid >= FirstNormalObjectId || get_typtype(typid) != TYPTYPE_BASE)
+		return false;
 
-	/* Mark that encoding conversion hasn't occurred yet */
-	cstate->line_buf_converted = false;
+	switch (typid)
+	{
+		case REGPROCOID:
+		case REGPROCEDUREOID:
+		case REGOPEROID:
+		case REGOPERATOROID:
+		case REGCLASSOID:
+		case REGTYPEOID:
+		case REGCONFIGOID:
+		case REGDICTIONARYOID:
+			return false;
+		default:
+			break;
+	}
 
-	/* Parse data and transfer into line_buf */
-	result = CopyReadLineText(cstate);
+	elemtype = get_element_type(typid);
+	if (OidIsValid(elemtype))
+		return ParallelCopyTypeIsSafe(elemtype);
 
-	if (result)
+	return true;
+}
+
+/*
+ * Set up a parallel COPY FROM, and launch its workers.
+ *
+ * Returns NULL, leaving the caller to do the COPY serially, if the input or
+ * the table doesn't allow parallel parsing, if dynamic shared memory isn't
+ * available, or if no worker could be registered.
+ */
+static ParallelCopyState *
+BeginParallelCopyFrom(CopyState cstate, TupleDesc tupDesc)
+{
+	ParallelCopyState *pcopy;
+	ParallelCopyShared *shared;
+	BackgroundWorker worker;
+	shm_toc_estimator e;
+	shm_toc    *toc;
+	dsm_segment *seg;
+	StringInfoData strings;
+	Size		shared_size;
+	Size		attnums_size;
+	Size		chunks_size;
+	Size		queues_size;
+	Size		segsize;
+	int			nworkers = Min(cstate->parallel_workers, max_worker_processes);
+	int			nchunks;
+	int			nattnums = list_length(cstate->attnumlist);
+	int		   *attnums;
+	char	   *dbname;
+	char	   *ptr;
+	ListCell   *cur;
+	int			i;
+
+	Assert(!cstate->binary);
+
+	if (!IsUnderPostmaster || dynamic_shared_memory_type == DSM_IMPL_NONE ||
+		nworkers <= 0)
+		return NULL;
+
+	if (cstate->file_has_oids || cstate->convert_selectively)
+		return NULL;
+
+	foreach(cur, cstate->attnumlist)
 	{
-		/*
-		 * Reached EOF.  In protocol version 3, we should ignore anything
-		 * after \. up to the protocol end of copy data.  (XXX maybe better
-		 * not to treat \. as special?)
-		 */
-		if (cstate->copy_dest == COPY_NEW_FE)
+		Form_pg_attribute att = tupDesc->attrs[lfirst_int(cur) - 1];
+
+		if (!ParallelCopyTypeIsSafe(att->atttypid))
 		{
-			do
+			elog(DEBUG1, "column \"%s\" of type %s prevents parallel COPY",
+				 NameStr(att->attname), format_type_be(att->atttypid));
+			return NULL;
+		}
+	}
+
+	/* Gather the strings the workers need: the NULL marker, then the GUCs */
+	initStringInfo(&strings);
+	appendBinaryStringInfo(&strings, cstate->null_print,
+						   cstate->null_print_len + 1);
+	for (i = 0; i < lengthof(parallel_copy_gucs); i++)
+	{
+		const char *value = GetConfigOption(parallel_copy_gucs[i],
+											false, false);
+
+		appendBinaryStringInfo(&strings, value, strlen(value) + 1);
+	}
+
+	nchunks = nworkers * PARALLEL_COPY_CHUNKS_PER_WORKER;
+	shared_size = add_size(offsetof(ParallelCopyShared, attrs),
+						   mul_size(sizeof(ParallelCopyAttr), tupDesc->natts));
+	attnums_size = mul_size(sizeof(int), Max(nattnums, 1));
+	chunks_size = mul_size(sizeof(ParallelCopyChunk), nchunks);
+	queues_size = mul_size(PARALLEL_COPY_QUEUE_SIZE, nworkers);
+
+	shm_toc_initialize_estimator(&e);
+	shm_toc_estimate_chunk(&e, shared_size);
+	shm_toc_estimate_chunk(&e, attnums_size);
+	shm_toc_estimate_chunk(&e, strings.len);
+	shm_toc_estimate_chunk(&e, chunks_size);
+	shm_toc_estimate_chunk(&e, queues_size);
+	shm_toc_estimate_keys(&e, 5);
+	segsize = shm_toc_estimate(&e);
+
+	seg = dsm_create(segsize);
+	toc = shm_toc_create(PARALLEL_COPY_MAGIC, dsm_segment_address(seg),
+						 segsize);
+
+	shared = shm_toc_allocate(toc, shared_size);
+	MemSet(shared, 0, shared_size);
+	SpinLockInit(&shared->mutex);
+	dbname = get_database_name(MyDatabaseId);
+	if (dbname == NULL)
+		elog(ERROR, "cache lookup failed for database %u", MyDatabaseId);
+	strlcpy(shared->dbname, dbname, NAMEDATALEN);
+	shared->xact_start = GetCurrentTransactionStartTimestamp();
+	shared->stmt_start = GetCurrentStatementStartTimestamp();
+	shared->nworkers = nworkers;
+	shared->nchunks = nchunks;
+	shared->csv_mode = cstate->csv_mode;
+	shared->delim = cstate->delim[0];
+	shared->quote = cstate->csv_mode ? cstate->quote[0] : '\0';
+	shared->escape = cstate->csv_mode ? cstate->escape[0] : '\0';
+	shared->reltype = tupDesc->tdtypeid;
+	shared->relhasoids = tupDesc->tdhasoid;
+	shared->natts = tupDesc->natts;
+	shared->nattnums = nattnums;
+	for (i = 0; i < tupDesc->natts; i++)
+	{
+		ParallelCopyAttr *pattr = &shared->attrs[i];
+
+		memcpy(&pattr->attr, tupDesc->attrs[i], ATTRIBUTE_FIXED_PART_SIZE);
+		if (cstate->csv_mode)
+		{
+			pattr->force_notnull = cstate->force_notnull_flags[i];
+			pattr->force_null = cstate->force_null_flags[i];
+		}
+	}
+	shm_toc_insert(toc, PARALLEL_COPY_KEY_SHARED, shared);
+
+	attnums = shm_toc_allocate(toc, attnums_size);
+	i = 0;
+	foreach(cur, cstate->attnumlist)
+		attnums[i++] = lfirst_int(cur);
+	shm_toc_insert(toc, PARALLEL_COPY_KEY_ATTNUMS, attnums);
+
+	ptr = shm_toc_allocate(toc, strings.len);
+	memcpy(ptr, strings.data, strings.len);
+	shm_toc_insert(toc, PARALLEL_COPY_KEY_STRINGS, ptr);
+	pfree(strings.data);
+
+	pcopy = (ParallelCopyState *) palloc0(sizeof(ParallelCopyState));
+	pcopy->cstate = cstate;
+	pcopy->tupDesc = tupDesc;
+	pcopy->seg = seg;
+	pcopy->shared = shared;
+
+	pcopy->chunks = shm_toc_allocate(toc, chunks_size);
+	shm_toc_insert(toc, PARALLEL_COPY_KEY_CHUNKS, pcopy->chunks);
+
+	ptr = shm_toc_allocate(toc, queues_size);
+	pcopy->queues = (shm_mq **) palloc(nworkers * sizeof(shm_mq *));
+	pcopy->mqhs = (shm_mq_handle **) palloc(nworkers * sizeof(shm_mq_handle *));
+	for (i = 0; i < nworkers; i++)
+	{
+		pcopy->queues[i] = shm_mq_create(ptr + i * PARALLEL_COPY_QUEUE_SIZE,
+										 PARALLEL_COPY_QUEUE_SIZE);
+		shm_mq_set_receiver(pcopy->queues[i], MyProc);
+		pcopy->mqhs[i] = shm_mq_attach(pcopy->queues[i], seg, NULL);
+	}
+	shm_toc_insert(toc, PARALLEL_COPY_KEY_QUEUES, ptr);
+
+	initStringInfo(&pcopy->pending);
+
+	/* If we error out, make sure no worker outlives the segment's owner */
+	pcopy->handles = (BackgroundWorkerHandle **)
+		palloc0(nworkers * sizeof(BackgroundWorkerHandle *));
+	on_dsm_detach(seg, ParallelCopyTerminateWorkers, PointerGetDatum(pcopy));
+
+	memset(&worker, 0, sizeof(worker));
+	worker.bgw_flags = BGWORKER_SHMEM_ACCESS |
+		BGWORKER_BACKEND_DATABASE_CONNECTION;
+	worker.bgw_start_time = BgWorkerStart_ConsistentState;
+	worker.bgw_restart_time = BGW_NEVER_RESTART;
+	worker.bgw_main = NULL;
+	snprintf(worker.bgw_library_name, BGW_MAXLEN, "postgres");
+	snprintf(worker.bgw_function_name, BGW_MAXLEN, "ParallelCopyWorkerMain");
+	snprintf(worker.bgw_name, BGW_MAXLEN,
+			 "parallel COPY worker for PID %d", MyProcPid);
+	worker.bgw_main_arg = UInt32GetDatum(dsm_segment_handle(seg));
+	/* set bgw_notify_pid so that we're woken up when the worker stops */
+	worker.bgw_notify_pid = MyProcPid;
+
+	for (i = 0; i < nworkers; i++)
+	{
+		if (!RegisterDynamicBackgroundWorker(&worker, &pcopy->handles[i]))
+			break;
+		pcopy->nlaunched++;
+	}
+
+	ereport(DEBUG1,
+			(errmsg("launched %d parallel COPY workers (planned: %d)",
+					pcopy->nlaunched, nworkers)));
+
+	/* Without any workers, we're better off without the chunk ring */
+	if (pcopy->nlaunched == 0)
+	{
+		cancel_on_dsm_detach(seg, ParallelCopyTerminateWorkers,
+							 PointerGetDatum(pcopy));
+		dsm_detach(seg);
+		return NULL;
+	}
+
+	return pcopy;
+}
+
+/*
+ * Wake up any workers waiting for a chunk to be filled, or for the end of
+ * the COPY.  A worker that hasn't attached to its queue yet will check for
+ * work before it first waits, so it needn't be woken.
+ */
+static void
+ParallelCopyWakeWorkers(ParallelCopyState *pcopy)
+{
+	int			i;
+
+	for (i = 0; i < pcopy->shared->nworkers; i++)
+	{
+		PGPROC	   *proc = shm_mq_get_sender(pcopy->queues[i]);
+
+		if (proc != NULL)
+			SetLatch(&proc->procLatch);
+	}
+}
+
+/*
+ * Read the next input line into the pending buffer.  Sets pcopy->eof if
+ * there are no more lines to read, which may be after this one.
+ *
+ * cur_lineno counts the lines as NextCopyFromRawFields does, including any
+ * newlines within quoted CSV fields, so an error thrown while reading
+ * reports the same line as in a serial COPY.  Such an error is thrown right
+ * away, even if an earlier line that's still to be parsed has bad data too.
+ */
+static void
+ParallelCopyReadLine(ParallelCopyState *pcopy)
+{
+	CopyState	cstate = pcopy->cstate;
+	bool		done = false;
+	int			save_lineno = cstate->cur_lineno;
+
+	Assert(!pcopy->eof && !pcopy->have_pending);
+
+	cstate->cur_lineno = pcopy->read_lineno;
+
+	/* on input just throw the header line away */
+	if (cstate->cur_lineno == 0 && cstate->header_line)
+	{
+		cstate->cur_lineno++;
+		if (CopyReadLine(cstate))
+			done = true;
+	}
+
+	if (!done)
+	{
+		cstate->cur_lineno++;
+		done = CopyReadLine(cstate);
+
+		/* see NextCopyFromRawFields */
+		if (!done || cstate->line_buf.len > 0)
+		{
+			resetStringInfo(&pcopy->pending);
+			appendBinaryStringInfo(&pcopy->pending, cstate->line_buf.data,
+								   cstate->line_buf.len);
+			pcopy->have_pending = true;
+			pcopy->pending_lineno = cstate->cur_lineno;
+			pcopy->pending_oversized =
+				PCOPY_LINE_SPACE(pcopy->pending.len) > PARALLEL_COPY_CHUNK_SIZE;
+		}
+	}
+
+	pcopy->read_lineno = cstate->cur_lineno;
+	cstate->cur_lineno = save_lineno;
+	if (done)
+		pcopy->eof = true;
+}
+
+/*
+ * Fill as many free chunks of the ring as we can with input lines, and let
+ * the workers know about them.
+ *
+ * We stop early at a line too long to fit in a chunk; the leader processes
+ * that line itself once all the chunks before it have been consumed.
+ */
+static void
+ParallelCopyFillChunks(ParallelCopyState *pcopy)
+{
+	ParallelCopyShared *shared = pcopy->shared;
+	bool		filled = false;
+
+	while (pcopy->nfilled < pcopy->nconsumed + shared->nchunks)
+	{
+		ParallelCopyChunk *chunk = PCOPY_CHUNK(pcopy->chunks, pcopy->nfilled,
+											   shared->nchunks);
+
+		chunk->worker = -1;
+		chunk->nlines = 0;
+		chunk->used = 0;
+
+		for (;;)
+		{
+			Size		space;
+			int32		len;
+
+			if (!pcopy->have_pending)
+			{
+				if (pcopy->eof)
+					break;
+				ParallelCopyReadLine(pcopy);
+				if (!pcopy->have_pending)
+					break;
+			}
+
+			if (pcopy->pending_oversized)
+				break;
+			space = PCOPY_LINE_SPACE(pcopy->pending.len);
+			if (chunk->used + space > PARALLEL_COPY_CHUNK_SIZE)
+				break;
+
+			len = pcopy->pending.len;
+			memcpy(chunk->data + chunk->used, &len, sizeof(int32));
+			memcpy(chunk->data + chunk->used + sizeof(int32),
+				   &pcopy->pending_lineno, sizeof(int32));
+			memcpy(chunk->data + chunk->used + PCOPY_LINE_HDRSZ,
+				   pcopy->pending.data, len + 1);
+			chunk->used += space;
+			chunk->nlines++;
+			pcopy->have_pending = false;
+		}
+
+		if (chunk->nlines == 0)
+			break;
+
+		SpinLockAcquire(&shared->mutex);
+		shared->nfilled = ++pcopy->nfilled;
+		SpinLockRelease(&shared->mutex);
+		filled = true;
+
+		if (pcopy->have_pending && pcopy->pending_oversized)
+			break;
+	}
+
+	if (filled)
+		ParallelCopyWakeWorkers(pcopy);
+}
+
+/*
+ * Set up to consume the rows of the next chunk, or of an oversized line.
+ * Returns false if there's nothing left.
+ */
+static bool
+ParallelCopyNextBatch(ParallelCopyState *pcopy)
+{
+	ParallelCopyShared *shared = pcopy->shared;
+	ParallelCopyChunk *chunk;
+	uint64		chunkno = pcopy->nconsumed;
+	int			worker = -1;
+	Size		nbytes;
+	void	   *data;
+
+	ParallelCopyFillChunks(pcopy);
+
+	if (chunkno >= pcopy->nfilled)
+	{
+		/* All chunks are consumed; now for the oversized line, if any */
+		if (!pcopy->have_pending)
+			return false;
+
+		Assert(pcopy->pending_oversized);
+		pcopy->in_oversized = true;
+		pcopy->local = true;
+		pcopy->lines_left = 1;
+		return true;
+	}
+
+	chunk = PCOPY_CHUNK(pcopy->chunks, chunkno, shared->nchunks);
+	pcopy->in_chunk = true;
+	pcopy->next_line = chunk->data;
+	pcopy->lines_left = chunk->nlines;
+
+	/* Claim the chunk ourselves if no worker has got to it yet */
+	SpinLockAcquire(&shared->mutex);
+	if (shared->next_claim <= chunkno)
+	{
+		Assert(shared->next_claim == chunkno);
+		shared->next_claim = chunkno + 1;
+	}
+	else
+		worker = chunk->worker;
+	SpinLockRelease(&shared->mutex);
+
+	pcopy->local = true;
+	if (worker >= 0 &&
+		shm_mq_receive(pcopy->mqhs[worker], &nbytes, &data,
+					   false) == SHM_MQ_SUCCESS)
+	{
+		ParallelCopyReply reply;
+
+		if (nbytes < sizeof(ParallelCopyReply))
+			elog(ERROR, "invalid message size %lu from parallel COPY worker",
+				 (unsigned long) nbytes);
+		memcpy(&reply, data, sizeof(ParallelCopyReply));
+		if (reply.chunkno != chunkno)
+			elog(ERROR, "parallel COPY worker sent chunk " UINT64_FORMAT ", expected " UINT64_FORMAT,
+				 reply.chunkno, chunkno);
+
+		/* If the worker failed, we parse the chunk again ourselves */
+		if (reply.ntuples >= 0)
+		{
+			if (reply.ntuples != chunk->nlines)
+				elog(ERROR, "parallel COPY worker sent %d tuples for %d lines",
+					 reply.ntuples, chunk->nlines);
+			pcopy->local = false;
+			pcopy->next_tuple = (char *) data + sizeof(ParallelCopyReply);
+			pcopy->reply_end = (char *) data + nbytes;
+		}
+	}
+
+	return true;
+}
+
+/*
+ * Return the next tuple of a parallel COPY FROM, or NULL at the end.
+ *
+ * This is the parallel counterpart of NextCopyFrom followed by
+ * heap_form_tuple.  The tuple is allocated in the current memory context,
+ * which should be the per-tuple context of econtext, and any defaults are
+ * computed just as NextCopyFrom does.  line_buf and cur_lineno are set to
+ * the row's input line, so errors report the same context as in a serial
+ * COPY.
+ */
+static HeapTuple
+ParallelCopyFromNext(ParallelCopyState *pcopy, ExprContext *econtext,
+					 Datum *values, bool *nulls)
+{
+	CopyState	cstate = pcopy->cstate;
+	TupleDesc	tupDesc = pcopy->tupDesc;
+	HeapTuple	tuple;
+	char	   *line;
+	int32		len;
+	int32		lineno;
+	int			i;
+
+	while (pcopy->lines_left == 0)
+	{
+		if (pcopy->in_chunk)
+		{
+			pcopy->nconsumed++;
+			pcopy->in_chunk = false;
+		}
+		if (pcopy->in_oversized)
+		{
+			pcopy->have_pending = false;
+			pcopy->in_oversized = false;
+		}
+
+		if (!ParallelCopyNextBatch(pcopy))
+			return NULL;
+	}
+
+	if (pcopy->in_oversized)
+	{
+		line = pcopy->pending.data;
+		len = pcopy->pending.len;
+		lineno = pcopy->pending_lineno;
+	}
+	else
+	{
+		memcpy(&len, pcopy->next_line, sizeof(int32));
+		memcpy(&lineno, pcopy->next_line + sizeof(int32), sizeof(int32));
+		line = pcopy->next_line + PCOPY_LINE_HDRSZ;
+		pcopy->next_line += PCOPY_LINE_SPACE(len);
+	}
+	pcopy->lines_left--;
+
+	/* Make the line the current one, as CopyReadLine would */
+	resetStringInfo(&cstate->line_buf);
+	appendBinaryStringInfo(&cstate->line_buf, line, len);
+	cstate->line_buf_valid = true;
+	cstate->line_buf_converted = true;
+	cstate->cur_lineno = lineno;
+
+	MemSet(values, 0, tupDesc->natts * sizeof(Datum));
+	MemSet(nulls, true, tupDesc->natts * sizeof(bool));
+
+	if (pcopy->local)
+	{
+		int			fldct;
+
+		if (cstate->csv_mode)
+			fldct = CopyReadAttributesCSV(cstate);
+		else
+			fldct = CopyReadAttributesText(cstate);
+		CopyFieldsToValues(cstate, tupDesc, cstate->raw_fields, fldct,
+						   values, nulls, NULL);
+	}
+	else
+	{
+		uint32		tuplen;
+
+		Assert(pcopy->next_tuple + sizeof(uint32) <= pcopy->reply_end);
+		memcpy(&tuplen, pcopy->next_tuple, sizeof(uint32));
+		pcopy->next_tuple += sizeof(uint32);
+		Assert(pcopy->next_tuple + tuplen <= pcopy->reply_end);
+
+		tuple = (HeapTuple) palloc(HEAPTUPLESIZE + tuplen);
+		tuple->t_len = tuplen;
+		ItemPointerSetInvalid(&(tuple->t_self));
+		tuple->t_tableOid = InvalidOid;
+		tuple->t_data = (HeapTupleHeader) ((char *) tuple + HEAPTUPLESIZE);
+		memcpy(tuple->t_data, pcopy->next_tuple, tuplen);
+		pcopy->next_tuple += tuplen;
+
+		if (cstate->num_defaults == 0)
+			return tuple;
+
+		heap_deform_tuple(tuple, tupDesc, values, nulls);
+	}
+
+	/* Compute defaults, as in NextCopyFrom */
+	for (i = 0; i < cstate->num_defaults; i++)
+	{
+		int			m = cstate->defmap[i];
+
+		Assert(CurrentMemoryContext == econtext->ecxt_per_tuple_memory);
+		values[m] = ExecEvalExpr(cstate->defexprs[i], econtext,
+								 &nulls[m], NULL);
+	}
+
+	return heap_form_tuple(tupDesc, values, nulls);
+}
+
+/*
+ * Finish a parallel COPY FROM: tell the workers there's nothing more to do,
+ * wait for them to exit, and release the shared memory.
+ */
+static void
+EndParallelCopyFrom(ParallelCopyState *pcopy)
+{
+	ParallelCopyShared *shared = pcopy->shared;
+	int			i;
+
+	SpinLockAcquire(&shared->mutex);
+	shared->finished = true;
+	SpinLockRelease(&shared->mutex);
+	ParallelCopyWakeWorkers(pcopy);
+
+	for (i = 0; i < pcopy->nlaunched; i++)
+	{
+		for (;;)
+		{
+			BgwHandleStatus status;
+			pid_t		pid;
+
+			status = GetBackgroundWorkerPid(pcopy->handles[i], &pid);
+			if (status == BGWH_STOPPED || status == BGWH_POSTMASTER_DIED)
+				break;
+
+			WaitLatch(&MyProc->procLatch, WL_LATCH_SET | WL_POSTMASTER_DEATH, 0);
+			ResetLatch(&MyProc->procLatch);
+			CHECK_FOR_INTERRUPTS();
+		}
+	}
+	pcopy->nlaunched = 0;
+
+	cancel_on_dsm_detach(pcopy->seg, ParallelCopyTerminateWorkers,
+						 PointerGetDatum(pcopy));
+	dsm_detach(pcopy->seg);
+}
+
+/*
+ * on_dsm_detach callback that stops any workers still running when the
+ * leader releases the segment on error.
+ */
+static void
+ParallelCopyTerminateWorkers(dsm_segment *seg, Datum arg)
+{
+	ParallelCopyState *pcopy = (ParallelCopyState *) DatumGetPointer(arg);
+	int			i;
+
+	for (i = 0; i < pcopy->nlaunched; i++)
+		TerminateBackgroundWorker(pcopy->handles[i]);
+	pcopy->nlaunched = 0;
+}
+
+/*
+ * Claim the next filled chunk.  Returns NULL once the leader has finished
+ * and there's nothing left to claim.
+ */
+static ParallelCopyChunk *
+ParallelCopyClaimChunk(ParallelCopyShared *shared, ParallelCopyChunk *chunks,
+					   int idx, uint64 *chunkno)
+{
+	for (;;)
+	{
+		ParallelCopyChunk *chunk = NULL;
+		bool		finished;
+		int			rc;
+
+		SpinLockAcquire(&shared->mutex);
+		finished = shared->finished;
+		if (shared->next_claim < shared->nfilled)
+		{
+			*chunkno = shared->next_claim++;
+			chunk = PCOPY_CHUNK(chunks, *chunkno, shared->nchunks);
+			chunk->worker = idx;
+		}
+		SpinLockRelease(&shared->mutex);
+
+		if (chunk != NULL)
+			return chunk;
+		if (finished)
+			return NULL;
+
+		rc = WaitLatch(&MyProc->procLatch, WL_LATCH_SET | WL_POSTMASTER_DEATH,
+					   0);
+		if (rc & WL_POSTMASTER_DEATH)
+			proc_exit(1);
+		ResetLatch(&MyProc->procLatch);
+		CHECK_FOR_INTERRUPTS();
+	}
+}
+
+/*
+ * Parse chunks and send the tuples to the leader until there are no more.
+ */
+static void
+ParallelCopyWorkerLoop(CopyState cstate, TupleDesc tupDesc,
+					   ParallelCopyShared *shared, ParallelCopyChunk *chunks,
+					   int idx, shm_mq_handle *mqh,
+					   ParallelCopyWorkerState *wstate)
+{
+	MemoryContext chunkcontext;
+	MemoryContext tuplecontext;
+	MemoryContext oldcontext;
+	Datum	   *values;
+	bool	   *nulls;
+	StringInfoData reply;
+	ParallelCopyChunk *chunk;
+
+	values = (Datum *) palloc(tupDesc->natts * sizeof(Datum));
+	nulls = (bool *) palloc(tupDesc->natts * sizeof(bool));
+	initStringInfo(&reply);
+
+	chunkcontext = AllocSetContextCreate(CurrentMemoryContext,
+										 "parallel COPY chunk",
+										 ALLOCSET_DEFAULT_MINSIZE,
+										 ALLOCSET_DEFAULT_INITSIZE,
+										 ALLOCSET_DEFAULT_MAXSIZE);
+	tuplecontext = AllocSetContextCreate(CurrentMemoryContext,
+										 "parallel COPY tuple",
+										 ALLOCSET_DEFAULT_MINSIZE,
+										 ALLOCSET_DEFAULT_INITSIZE,
+										 ALLOCSET_DEFAULT_MAXSIZE);
+
+	while ((chunk = ParallelCopyClaimChunk(shared, chunks, idx,
+										   &wstate->chunkno)) != NULL)
+	{
+		ParallelCopyReply hdr;
+		char	   *next_line = chunk->data;
+		int			i;
+
+		wstate->have_chunk = true;
+		MemoryContextReset(chunkcontext);
+		oldcontext = MemoryContextSwitchTo(chunkcontext);
+
+		hdr.chunkno = wstate->chunkno;
+		hdr.ntuples = chunk->nlines;
+		resetStringInfo(&reply);
+		appendBinaryStringInfo(&reply, (char *) &hdr, sizeof(hdr));
+
+		for (i = 0; i < chunk->nlines; i++)
+		{
+			HeapTuple	tuple;
+			int32		len;
+			uint32		tuplen;
+			int			fldct;
+
+			CHECK_FOR_INTERRUPTS();
+
+			memcpy(&len, next_line, sizeof(int32));
+			resetStringInfo(&cstate->line_buf);
+			appendBinaryStringInfo(&cstate->line_buf,
+								   next_line + PCOPY_LINE_HDRSZ, len);
+			next_line += PCOPY_LINE_SPACE(len);
+
+			MemoryContextReset(tuplecontext);
+			MemoryContextSwitchTo(tuplecontext);
+
+			MemSet(values, 0, tupDesc->natts * sizeof(Datum));
+			MemSet(nulls, true, tupDesc->natts * sizeof(bool));
+			if (cstate->csv_mode)
+				fldct = CopyReadAttributesCSV(cstate);
+			else
+				fldct = CopyReadAttributesText(cstate);
+			CopyFieldsToValues(cstate, tupDesc, cstate->raw_fields, fldct,
+							   values, nulls, NULL);
+			tuple = heap_form_tuple(tupDesc, values, nulls);
+
+			MemoryContextSwitchTo(chunkcontext);
+			tuplen = tuple->t_len;
+			appendBinaryStringInfo(&reply, (char *) &tuplen, sizeof(uint32));
+			appendBinaryStringInfo(&reply, (char *) tuple->t_data, tuplen);
+		}
+
+		MemoryContextSwitchTo(oldcontext);
+
+		/* If the leader has gone away, there's no point in going on */
+		if (shm_mq_send(mqh, reply.len, reply.data, false) != SHM_MQ_SUCCESS)
+			break;
+		wstate->have_chunk = false;
+	}
+}
+
+/*
+ * ParallelCopyWorkerMain - main entrypoint for a parallel COPY worker
+ *
+ * main_arg is the handle of the leader's dynamic shared memory segment.  We
+ * connect to the leader's database, adopt its settings for everything that
+ * affects the input functions, and then turn chunks of lines into tuples
+ * until the leader says it's done.
+ */
+void
+ParallelCopyWorkerMain(Datum main_arg)
+{
+	dsm_segment *seg;
+	shm_toc    *toc;
+	ParallelCopyShared *shared;
+	ParallelCopyChunk *chunks;
+	ParallelCopyWorkerState wstate;
+	CopyState	cstate;
+	TupleDesc	tupDesc;
+	shm_mq	   *mq;
+	shm_mq_handle *mqh;
+	int		   *attnums;
+	char	   *strings;
+	char	   *queues;
+	int			idx;
+	int			i;
+
+	/* Let the leader's TerminateBackgroundWorker() cancel us */
+	pqsignal(SIGTERM, die);
+	BackgroundWorkerUnblockSignals();
+
+	/* We need a resource owner before we can attach to the segment */
+	CurrentResourceOwner = ResourceOwnerCreate(NULL, "parallel COPY worker");
+	seg = dsm_attach(DatumGetUInt32(main_arg));
+	if (seg == NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+				 errmsg("could not map dynamic shared memory segment")));
+	toc = shm_toc_attach(PARALLEL_COPY_MAGIC, dsm_segment_address(seg));
+	if (toc == NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+				 errmsg("invalid magic number in dynamic shared memory segment")));
+	shared = shm_toc_lookup(toc, PARALLEL_COPY_KEY_SHARED);
+	attnums = shm_toc_lookup(toc, PARALLEL_COPY_KEY_ATTNUMS);
+	strings = shm_toc_lookup(toc, PARALLEL_COPY_KEY_STRINGS);
+	chunks = shm_toc_lookup(toc, PARALLEL_COPY_KEY_CHUNKS);
+	queues = shm_toc_lookup(toc, PARALLEL_COPY_KEY_QUEUES);
+
+	SpinLockAcquire(&shared->mutex);
+	idx = shared->nattached++;
+	SpinLockRelease(&shared->mutex);
+	if (idx >= shared->nworkers)
+		proc_exit(0);
+
+	mq = (shm_mq *) (queues + idx * PARALLEL_COPY_QUEUE_SIZE);
+	shm_mq_set_sender(mq, MyProc);
+	mqh = shm_mq_attach(mq, seg, NULL);
+
+	BackgroundWorkerInitializeConnection(shared->dbname, NULL);
+
+	StartTransactionCommand();
+	SetParallelStartTimestamps(shared->xact_start, shared->stmt_start);
+
+	/* Build a CopyState with just what parsing a line needs */
+	cstate = (CopyStateData *) palloc0(sizeof(CopyStateData));
+	cstate->csv_mode = shared->csv_mode;
+	cstate->delim = pnstrdup(&shared->delim, 1);
+	if (shared->csv_mode)
+	{
+		cstate->quote = pnstrdup(&shared->quote, 1);
+		cstate->escape = pnstrdup(&shared->escape, 1);
+	}
+	cstate->null_print = pstrdup(strings);
+	cstate->null_print_len = strlen(strings);
+	strings += cstate->null_print_len + 1;
+	for (i = 0; i < lengthof(parallel_copy_gucs); i++)
+	{
+		SetConfigOption(parallel_copy_gucs[i], strings,
+						PGC_USERSET, PGC_S_SESSION);
+		strings += strlen(strings) + 1;
+	}
+
+	tupDesc = CreateTemplateTupleDesc(shared->natts, shared->relhasoids);
+	tupDesc->tdtypeid = shared->reltype;
+	tupDesc->tdtypmod = -1;
+	cstate->in_functions = (FmgrInfo *) palloc0(shared->natts * sizeof(FmgrInfo));
+	cstate->typioparams = (Oid *) palloc0(shared->natts * sizeof(Oid));
+	cstate->force_notnull_flags = (bool *) palloc0(shared->natts * sizeof(bool));
+	cstate->force_null_flags = (bool *) palloc0(shared->natts * sizeof(bool));
+	for (i = 0; i < shared->natts; i++)
+	{
+		memcpy(tupDesc->attrs[i], &shared->attrs[i].attr,
+			   ATTRIBUTE_FIXED_PART_SIZE);
+		cstate->force_notnull_flags[i] = shared->attrs[i].force_notnull;
+		cstate->force_null_flags[i] = shared->attrs[i].force_null;
+	}
+	for (i = 0; i < shared->nattnums; i++)
+	{
+		Form_pg_attribute att = tupDesc->attrs[attnums[i] - 1];
+		Oid			in_func_oid;
+
+		cstate->attnumlist = lappend_int(cstate->attnumlist, attnums[i]);
+		getTypeInputInfo(att->atttypid, &in_func_oid,
+						 &cstate->typioparams[attnums[i] - 1]);
+		fmgr_info(in_func_oid, &cstate->in_functions[attnums[i] - 1]);
+	}
+
+	initStringInfo(&cstate->attribute_buf);
+	initStringInfo(&cstate->line_buf);
+	cstate->max_fields = shared->nattnums;
+	cstate->raw_fields = (char **) palloc(Max(cstate->max_fields, 1) *
+										  sizeof(char *));
+
+	/* Input functions may want a snapshot set */
+	PushActiveSnapshot(GetTransactionSnapshot());
+
+	wstate.have_chunk = false;
+	PG_TRY();
+	{
+		ParallelCopyWorkerLoop(cstate, tupDesc, shared, chunks, idx, mqh,
+							   &wstate);
+	}
+	PG_CATCH();
+	{
+		/*
+		 * Tell the leader to parse the chunk again itself, so that it can
+		 * report the error with the right context; then exit on the error.
+		 */
+		if (wstate.have_chunk)
+		{
+			ParallelCopyReply hdr;
+
+			hdr.chunkno = wstate.chunkno;
+			hdr.ntuples = -1;
+			(void) shm_mq_send(mqh, sizeof(hdr), &hdr, false);
+		}
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+
+	PopActiveSnapshot();
+	CommitTransactionCommand();
+
+	dsm_detach(seg);
+}
+
+/*
+ * Read the next input line and stash it in line_buf, with conversion to
+ * server encoding.
+ *
+ * Result is true if read was terminated by EOF, false if terminated
+ * by newline.	The terminating newline or EOF marker is not included
+ * in the final value of line_buf.
+ */
+static bool
+CopyReadLine(CopyState cstate)
+{
+	bool		result;
+
+	resetStringInfo(&cstate->line_buf);
+	cstate->line_buf_valid = true;
+
+	/* Mark that encoding conversion hasn't occurred yet */
+	cstate->line_buf_converted = false;
+
+	/* Parse data and transfer into line_buf */
+	result = CopyReadLineText(cstate);
+
+	if (result)
+	{
+		/*
+		 * Reached EOF.  In protocol version 3, we should ignore anything
+		 * after \. up to the protocol end of copy data.  (XXX maybe better
+		 * not to treat \. as special?)
+		 */
+		if (cstate->copy_dest == COPY_NEW_FE)
+		{
+			do
 			{
 				cstate->raw_buf_index = cstate->raw_buf_len;
 			} while (CopyLoadRawBuf(cstate));
@@ -3943,6 +5247,173 @@ CopyReadBinaryAttribute(CopyState cstate,
 	return result;
 }
 
+/*
+ * Choose the output fast path, if any, for a column in text or CSV format.
+ */
+static CopyOutKind
+CopyGetOutKind(CopyState cstate, int attnum, Oid out_func_oid)
+{
+	/* what an integer's output can consist of */
+	static const char int_chars[] = "-0123456789";
+
+	switch (out_func_oid)
+	{
+		case F_INT2OUT:
+		case F_INT4OUT:
+		case F_INT8OUT:
+
+			/*
+			 * Integers are sent without any escaping, quoting or encoding
+			 * conversion (digits are the same in every encoding we support),
+			 * so check that none can be needed.  That's always so in text
+			 * format, unless the delimiter is a minus sign.
+			 */
+			if (strchr(int_chars, cstate->delim[0]) != NULL)
+				return COPY_OUT_GENERIC;
+			if (cstate->csv_mode &&
+				(cstate->force_quote_flags[attnum - 1] ||
+				 strchr(int_chars, cstate->quote[0]) != NULL ||
+				 (cstate->null_print_len > 0 &&
+				  strspn(cstate->null_print, int_chars) == cstate->null_print_len)))
+				return COPY_OUT_GENERIC;
+
+			if (out_func_oid == F_INT2OUT)
+				return COPY_OUT_INT2;
+			else if (out_func_oid == F_INT4OUT)
+				return COPY_OUT_INT4;
+			else
+				return COPY_OUT_INT8;
+
+		case F_TEXTOUT:
+		case F_VARCHAROUT:
+		case F_BPCHAROUT:
+			return COPY_OUT_TEXT;
+
+		default:
+			return COPY_OUT_GENERIC;
+	}
+}
+
+/*
+ * Send an integer attribute, formatting it directly into the output buffer.
+ */
+static void
+CopyAttributeOutInteger(CopyState cstate, CopyOutKind kind, Datum value)
+{
+	StringInfo	buf = cstate->fe_msgbuf;
+	char	   *dst;
+
+	/* enough for "-9223372036854775808" and a trailing null */
+	enlargeStringInfo(buf, 21);
+	dst = buf->data + buf->len;
+
+	switch (kind)
+	{
+		case COPY_OUT_INT2:
+			pg_itoa(DatumGetInt16(value), dst);
+			break;
+		case COPY_OUT_INT4:
+			pg_ltoa(DatumGetInt32(value), dst);
+			break;
+		case COPY_OUT_INT8:
+			pg_lltoa(DatumGetInt64(value), dst);
+			break;
+		default:
+			elog(ERROR, "unexpected COPY output kind: %d", (int) kind);
+	}
+
+	buf->len += strlen(dst);
+}
+
+/*
+ * Helpers for checking eight bytes at a time for any special byte: the
+ * first is nonzero if any byte of w is less than n (which must be at most
+ * 0x80), the second if any byte of w is zero.  See "Bit Twiddling Hacks".
+ */
+#define COPY_SCAN_ONES		UINT64CONST(0x0101010101010101)
+#define COPY_SCAN_HIGHS		UINT64CONST(0x8080808080808080)
+#define COPY_SCAN_HAS_LESS(w, n) \
+	(((w) - COPY_SCAN_ONES * (n)) & ~(w) & COPY_SCAN_HIGHS)
+#define COPY_SCAN_HAS_ZERO(w)	COPY_SCAN_HAS_LESS(w, 1)
+
+/*
+ * Set up a CopyOutScan for the bytes in the null-terminated string chars,
+ * plus, if requested, all ASCII control characters and all bytes with the
+ * high bit set.
+ */
+static void
+CopyInitOutScan(CopyOutScan *scan, const char *chars, bool controls,
+				bool highbit)
+{
+	int			c;
+
+	MemSet(scan, 0, sizeof(CopyOutScan));
+	scan->controls = controls;
+	scan->highbit = highbit;
+	if (controls)
+	{
+		for (c = 0; c < 0x20; c++)
+			scan->special[c] = true;
+	}
+	if (highbit)
+	{
+		for (c = 0x80; c < 0x100; c++)
+			scan->special[c] = true;
+	}
+
+	for (; *chars != '\0'; chars++)
+	{
+		unsigned char uc = (unsigned char) *chars;
+
+		if (scan->special[uc])
+			continue;
+		Assert(scan->nchars < lengthof(scan->chars));
+		scan->special[uc] = true;
+		scan->chars[scan->nchars++] = COPY_SCAN_ONES * uc;
+	}
+}
+
+/*
+ * Return a pointer to the first special byte in [ptr, end), or end if
+ * there is none.
+ *
+ * Most data has no bytes that need escaping or quoting at all, so we first
+ * look at eight bytes at a time, and only at bytes one by one once we know
+ * there's a special one among them.
+ */
+static inline const char *
+CopyScanOut(const CopyOutScan *scan, const char *ptr, const char *end)
+{
+	while (end - ptr >= sizeof(uint64))
+	{
+		uint64		w;
+		uint64		hit = 0;
+		int			i;
+
+		memcpy(&w, ptr, sizeof(uint64));
+		if (scan->controls)
+			hit |= COPY_SCAN_HAS_LESS(w, 0x20);
+		if (scan->highbit)
+			hit |= w & COPY_SCAN_HIGHS;
+		for (i = 0; i < scan->nchars; i++)
+			hit |= COPY_SCAN_HAS_ZERO(w ^ scan->chars[i]);
+
+		if (hit != 0)
+		{
+			for (i = 0; i < sizeof(uint64); i++)
+			{
+				if (scan->special[(unsigned char) ptr[i]])
+					return ptr + i;
+			}
+		}
+		ptr += sizeof(uint64);
+	}
+
+	while (ptr < end && !scan->special[(unsigned char) *ptr])
+		ptr++;
+	return ptr;
+}
+
 /*
  * Send text representation of one attribute, with conversion and escaping
  */
@@ -3953,17 +5424,23 @@ CopyReadBinaryAttribute(CopyState cstate,
 	} while (0)
 
 static void
-CopyAttributeOutText(CopyState cstate, char *string)
+CopyAttributeOutText(CopyState cstate, const char *string, int len)
 {
-	char	   *ptr;
-	char	   *start;
+	const char *ptr;
+	const char *start;
+	const char *end;
 	char		c;
 	char		delimc = cstate->delim[0];
 
 	if (cstate->need_transcoding)
-		ptr = pg_server_to_any(string, strlen(string), cstate->file_encoding);
+	{
+		ptr = pg_server_to_any(string, len, cstate->file_encoding);
+		if (ptr != string)
+			len = strlen(ptr);
+	}
 	else
 		ptr = string;
+	end = ptr + len;
 
 	/*
 	 * We have to grovel through the string searching for control characters
@@ -3973,128 +5450,68 @@ CopyAttributeOutText(CopyState cstate, char *string)
 	 * single call.  The loop invariant is that the data from "start" to "ptr"
 	 * can be sent literally, but hasn't yet been.
 	 *
-	 * We can skip pg_encoding_mblen() overhead when encoding is safe, because
-	 * in valid backend encodings, extra bytes of a multibyte character never
-	 * look like ASCII.  This loop is sufficiently performance-critical that
-	 * it's worth making two copies of it to get the IS_HIGHBIT_SET() test out
-	 * of the normal safe-encoding path.
+	 * CopyScanOut skips over the bytes that need no attention.  When the
+	 * encoding is safe, that's every byte with the high bit set, because in
+	 * valid backend encodings, extra bytes of a multibyte character never
+	 * look like ASCII; otherwise we must stop at each multibyte character
+	 * and step over it with pg_encoding_mblen().
 	 */
-	if (cstate->encoding_embeds_ascii)
+	start = ptr;
+	while ((ptr = CopyScanOut(cstate->out_scan, ptr, end)) < end)
 	{
-		start = ptr;
-		while ((c = *ptr) != '\0')
+		c = *ptr;
+		if ((unsigned char) c < (unsigned char) 0x20)
 		{
-			if ((unsigned char) c < (unsigned char) 0x20)
+			/*
+			 * \r and \n must be escaped, the others are traditional. We
+			 * prefer to dump these using the C-like notation, rather than a
+			 * backslash and the literal character, because it makes the dump
+			 * file a bit more proof against Microsoftish data mangling.
+			 */
+			switch (c)
 			{
-				/*
-				 * \r and \n must be escaped, the others are traditional. We
-				 * prefer to dump these using the C-like notation, rather than
-				 * a backslash and the literal character, because it makes the
-				 * dump file a bit more proof against Microsoftish data
-				 * mangling.
-				 */
-				switch (c)
-				{
-					case '\b':
-						c = 'b';
-						break;
-					case '\f':
-						c = 'f';
-						break;
-					case '\n':
-						c = 'n';
-						break;
-					case '\r':
-						c = 'r';
-						break;
-					case '\t':
-						c = 't';
-						break;
-					case '\v':
-						c = 'v';
+				case '\b':
+					c = 'b';
+					break;
+				case '\f':
+					c = 'f';
+					break;
+				case '\n':
+					c = 'n';
+					break;
+				case '\r':
+					c = 'r';
+					break;
+				case '\t':
+					c = 't';
+					break;
+				case '\v':
+					c = 'v';
+					break;
+				default:
+					/* If it's the delimiter, must backslash it */
+					if (c == delimc)
 						break;
-					default:
-						/* If it's the delimiter, must backslash it */
-						if (c == delimc)
-							break;
-						/* All ASCII control chars are length 1 */
-						ptr++;
-						continue;		/* fall to end of loop */
-				}
-				/* if we get here, we need to convert the control char */
-				DUMPSOFAR();
-				CopySendChar(cstate, '\\');
-				CopySendChar(cstate, c);
-				start = ++ptr;	/* do not include char in next run */
-			}
-			else if (c == '\\' || c == delimc)
-			{
-				DUMPSOFAR();
-				CopySendChar(cstate, '\\');
-				start = ptr++;	/* we include char in next run */
+					/* All ASCII control chars are length 1 */
+					ptr++;
+					continue;	/* fall to end of loop */
 			}
-			else if (IS_HIGHBIT_SET(c))
-				ptr += pg_encoding_mblen(cstate->file_encoding, ptr);
-			else
-				ptr++;
+			/* if we get here, we need to convert the control char */
+			DUMPSOFAR();
+			CopySendChar(cstate, '\\');
+			CopySendChar(cstate, c);
+			start = ++ptr;		/* do not include char in next run */
 		}
-	}
-	else
-	{
-		start = ptr;
-		while ((c = *ptr) != '\0')
+		else if (c == '\\' || c == delimc)
 		{
-			if ((unsigned char) c < (unsigned char) 0x20)
-			{
-				/*
-				 * \r and \n must be escaped, the others are traditional. We
-				 * prefer to dump these using the C-like notation, rather than
-				 * a backslash and the literal character, because it makes the
-				 * dump file a bit more proof against Microsoftish data
-				 * mangling.
-				 */
-				switch (c)
-				{
-					case '\b':
-						c = 'b';
-						break;
-					case '\f':
-						c = 'f';
-						break;
-					case '\n':
-						c = 'n';
-						break;
-					case '\r':
-						c = 'r';
-						break;
-					case '\t':
-						c = 't';
-						break;
-					case '\v':
-						c = 'v';
-						break;
-					default:
-						/* If it's the delimiter, must backslash it */
-						if (c == delimc)
-							break;
-						/* All ASCII control chars are length 1 */
-						ptr++;
-						continue;		/* fall to end of loop */
-				}
-				/* if we get here, we need to convert the control char */
-				DUMPSOFAR();
-				CopySendChar(cstate, '\\');
-				CopySendChar(cstate, c);
-				start = ++ptr;	/* do not include char in next run */
-			}
-			else if (c == '\\' || c == delimc)
-			{
-				DUMPSOFAR();
-				CopySendChar(cstate, '\\');
-				start = ptr++;	/* we include char in next run */
-			}
-			else
-				ptr++;
+			DUMPSOFAR();
+			CopySendChar(cstate, '\\');
+			start = ptr++;		/* we include char in next run */
+		}
+		else
+		{
+			Assert(IS_HIGHBIT_SET(c) && cstate->encoding_embeds_ascii);
+			ptr += pg_encoding_mblen(cstate->file_encoding, ptr);
 		}
 	}
 
@@ -4106,24 +5523,30 @@ CopyAttributeOutText(CopyState cstate, char *string)
  * CSV-style escaping
  */
 static void
-CopyAttributeOutCSV(CopyState cstate, char *string,
+CopyAttributeOutCSV(CopyState cstate, const char *string, int len,
 					bool use_quote, bool single_attr)
 {
-	char	   *ptr;
-	char	   *start;
+	const char *ptr;
+	const char *start;
+	const char *end;
 	char		c;
-	char		delimc = cstate->delim[0];
 	char		quotec = cstate->quote[0];
 	char		escapec = cstate->escape[0];
 
 	/* force quoting if it matches null_print (before conversion!) */
-	if (!use_quote && strcmp(string, cstate->null_print) == 0)
+	if (!use_quote && len == cstate->null_print_len &&
+		memcmp(string, cstate->null_print, len) == 0)
 		use_quote = true;
 
 	if (cstate->need_transcoding)
-		ptr = pg_server_to_any(string, strlen(string), cstate->file_encoding);
+	{
+		ptr = pg_server_to_any(string, len, cstate->file_encoding);
+		if (ptr != string)
+			len = strlen(ptr);
+	}
 	else
 		ptr = string;
+	end = ptr + len;
 
 	/*
 	 * Make a preliminary pass to discover if it needs quoting
@@ -4134,23 +5557,23 @@ CopyAttributeOutCSV(CopyState cstate, char *string,
 		 * Because '\.' can be a data value, quote it if it appears alone on a
 		 * line so it is not interpreted as the end-of-data marker.
 		 */
-		if (single_attr && strcmp(ptr, "\\.") == 0)
+		if (single_attr && len == 2 && memcmp(ptr, "\\.", 2) == 0)
 			use_quote = true;
 		else
 		{
-			char	   *tptr = ptr;
+			const char *tptr = ptr;
 
-			while ((c = *tptr) != '\0')
+			while ((tptr = CopyScanOut(cstate->out_csv_quote_scan,
+									   tptr, end)) < end)
 			{
-				if (c == delimc || c == quotec || c == '\n' || c == '\r')
+				if (IS_HIGHBIT_SET(*tptr))
+					tptr += pg_encoding_mblen(cstate->file_encoding, tptr);
+				else
 				{
+					/* delimiter, quote, \n or \r */
 					use_quote = true;
 					break;
 				}
-				if (IS_HIGHBIT_SET(c) && cstate->encoding_embeds_ascii)
-					tptr += pg_encoding_mblen(cstate->file_encoding, tptr);
-				else
-					tptr++;
 			}
 		}
 	}
@@ -4163,18 +5586,18 @@ CopyAttributeOutCSV(CopyState cstate, char *string,
 		 * We adopt the same optimization strategy as in CopyAttributeOutText
 		 */
 		start = ptr;
-		while ((c = *ptr) != '\0')
+		while ((ptr = CopyScanOut(cstate->out_csv_escape_scan,
+								  ptr, end)) < end)
 		{
+			c = *ptr;
 			if (c == quotec || c == escapec)
 			{
 				DUMPSOFAR();
 				CopySendChar(cstate, escapec);
-				start = ptr;	/* we include char in next run */
+				start = ptr++;	/* we include char in next run */
 			}
-			if (IS_HIGHBIT_SET(c) && cstate->encoding_embeds_ascii)
-				ptr += pg_encoding_mblen(cstate->file_encoding, ptr);
 			else
-				ptr++;
+				ptr += pg_encoding_mblen(cstate->file_encoding, ptr);
 		}
 		DUMPSOFAR();
 
@@ -4183,7 +5606,7 @@ CopyAttributeOutCSV(CopyState cstate, char *string,
 	else
 	{
 		/* If it doesn't need quoting, we can just dump it as-is */
-		CopySendString(cstate, ptr);
+		CopySendData(cstate, ptr, len);
 	}
 }
 
@@ -52,7 +52,7 @@ static void report_triggers(ResultRelInfo *rInfo, bool show_relname,
 				ExplainState *es);
 static double elapsed_time(instr_time *starttime);
 static void ExplainPreScanNode(PlanState *planstate, Bitmapset **rels_used);
-static void ExplainPreScanMemberNodes(List *plans, PlanState **planstates,
+static void ExplainPreScanMemberNodes(PlanState **planstates, int nplans,
 						  Bitmapset **rels_used);
 static void ExplainPreScanSubPlans(List *plans, Bitmapset **rels_used);
 static void ExplainNode(PlanState *planstate, List *ancestors,
@@ -74,6 +74,8 @@ static void show_upper_qual(List *qual, const char *qlabel,
 				ExplainState *es);
 static void show_sort_keys(SortState *sortstate, List *ancestors,
 			   ExplainState *es);
+static void show_incremental_sort_keys(IncrementalSortState *sortstate,
+						   List *ancestors, ExplainState *es);
 static void show_merge_append_keys(MergeAppendState *mstate, List *ancestors,
 					   ExplainState *es);
 static void show_agg_keys(AggState *astate, List *ancestors,
@@ -84,6 +86,8 @@ static void show_sort_group_keys(PlanState *planstate, const char *qlabel,
 					 int nkeys, AttrNumber *keycols,
 					 List *ancestors, ExplainState *es);
 static void show_sort_info(SortState *sortstate, ExplainState *es);
+static void show_incremental_sort_info(IncrementalSortState *sortstate,
+						   ExplainState *es);
 static void show_hash_info(HashState *hashstate, ExplainState *es);
 static void show_tidbitmap_info(BitmapHeapScanState *planstate,
 								ExplainState *es);
@@ -97,7 +101,7 @@ static void ExplainScanTarget(Scan *plan, ExplainState *es);
 static void ExplainModifyTarget(ModifyTable *plan, ExplainState *es);
 static void ExplainTargetRel(Plan *plan, Index rti, ExplainState *es);
 static void show_modifytable_info(ModifyTableState *mtstate, ExplainState *es);
-static void ExplainMemberNodes(List *plans, PlanState **planstates,
+static void ExplainMemberNodes(PlanState **planstates, int nplans,
 				   List *ancestors, ExplainState *es);
 static void ExplainSubPlans(List *plans, List *ancestors,
 				const char *relationship, ExplainState *es);
@@ -746,28 +750,28 @@ ExplainPreScanNode(PlanState *planstate, Bitmapset **rels_used)
 	switch (nodeTag(plan))
 	{
 		case T_ModifyTable:
-			ExplainPreScanMemberNodes(((ModifyTable *) plan)->plans,
-								  ((ModifyTableState *) planstate)->mt_plans,
+			ExplainPreScanMemberNodes(((ModifyTableState *) planstate)->mt_plans,
+									  ((ModifyTableState *) planstate)->mt_nplans,
 									  rels_used);
 			break;
 		case T_Append:
-			ExplainPreScanMemberNodes(((Append *) plan)->appendplans,
-									((AppendState *) planstate)->appendplans,
+			ExplainPreScanMemberNodes(((AppendState *) planstate)->appendplans,
+									  ((AppendState *) planstate)->as_nplans,
 									  rels_used);
 			break;
 		case T_MergeAppend:
-			ExplainPreScanMemberNodes(((MergeAppend *) plan)->mergeplans,
-								((MergeAppendState *) planstate)->mergeplans,
+			ExplainPreScanMemberNodes(((MergeAppendState *) planstate)->mergeplans,
+									  ((MergeAppendState *) planstate)->ms_nplans,
 									  rels_used);
 			break;
 		case T_BitmapAnd:
-			ExplainPreScanMemberNodes(((BitmapAnd *) plan)->bitmapplans,
-								 ((BitmapAndState *) planstate)->bitmapplans,
+			ExplainPreScanMemberNodes(((BitmapAndState *) planstate)->bitmapplans,
+									  ((BitmapAndState *) planstate)->nplans,
 									  rels_used);
 			break;
 		case T_BitmapOr:
-			ExplainPreScanMemberNodes(((BitmapOr *) plan)->bitmapplans,
-								  ((BitmapOrState *) planstate)->bitmapplans,
+			ExplainPreScanMemberNodes(((BitmapOrState *) planstate)->bitmapplans,
+									  ((BitmapOrState *) planstate)->nplans,
 									  rels_used);
 			break;
 		case T_SubqueryScan:
@@ -787,14 +791,13 @@ ExplainPreScanNode(PlanState *planstate, Bitmapset **rels_used)
  * Prescan the constituent plans of a ModifyTable, Append, MergeAppend,
  * BitmapAnd, or BitmapOr node.
  *
- * Note: we don't actually need to examine the Plan list members, but
- * we need the list in order to determine the length of the PlanState array.
+ * The number of PlanStates is taken from the executor state rather than the
+ * Plan, as an Append may have pruned some of its subplans at startup.
  */
 static void
-ExplainPreScanMemberNodes(List *plans, PlanState **planstates,
+ExplainPreScanMemberNodes(PlanState **planstates, int nplans,
 						  Bitmapset **rels_used)
 {
-	int			nplans = list_length(plans);
 	int			j;
 
 	for (j = 0; j < nplans; j++)
@@ -903,13 +906,22 @@ ExplainNode(PlanState *planstate, List *ancestors,
 			pname = sname = "Seq Scan";
 			break;
 		case T_IndexScan:
-			pname = sname = "Index Scan";
+			if (((IndexScan *) plan)->indexskipscan)
+				pname = sname = "Index Skip Scan";
+			else
+				pname = sname = "Index Scan";
 			break;
 		case T_IndexOnlyScan:
-			pname = sname = "Index Only Scan";
+			if (((IndexOnlyScan *) plan)->indexskipscan)
+				pname = sname = "Index Only Skip Scan";
+			else
+				pname = sname = "Index Only Scan";
 			break;
 		case T_BitmapIndexScan:
-			pname = sname = "Bitmap Index Scan";
+			if (((BitmapIndexScan *) plan)->indexskipscan)
+				pname = sname = "Bitmap Index Skip Scan";
+			else
+				pname = sname = "Bitmap Index Scan";
 			break;
 		case T_BitmapHeapScan:
 			pname = sname = "Bitmap Heap Scan";
@@ -941,6 +953,9 @@ ExplainNode(PlanState *planstate, List *ancestors,
 		case T_Sort:
 			pname = sname = "Sort";
 			break;
+		case T_IncrementalSort:
+			pname = sname = "Incremental Sort";
+			break;
 		case T_Group:
 			pname = sname = "Group";
 			break;
@@ -1402,6 +1417,18 @@ ExplainNode(PlanState *planstate, List *ancestors,
 			show_sort_keys((SortState *) planstate, ancestors, es);
 			show_sort_info((SortState *) planstate, es);
 			break;
+		case T_IncrementalSort:
+			show_incremental_sort_keys((IncrementalSortState *) planstate,
+									   ancestors, es);
+			show_incremental_sort_info((IncrementalSortState *) planstate,
+									   es);
+			break;
+		case T_Append:
+			if (((AppendState *) planstate)->as_nremoved > 0)
+				ExplainPropertyInteger("Subplans Removed",
+									((AppendState *) planstate)->as_nremoved,
+									   es);
+			break;
 		case T_MergeAppend:
 			show_merge_append_keys((MergeAppendState *) planstate,
 								   ancestors, es);
@@ -1566,28 +1593,28 @@ ExplainNode(PlanState *planstate, List *ancestors,
 	switch (nodeTag(plan))
 	{
 		case T_ModifyTable:
-			ExplainMemberNodes(((ModifyTable *) plan)->plans,
-							   ((ModifyTableState *) planstate)->mt_plans,
+			ExplainMemberNodes(((ModifyTableState *) planstate)->mt_plans,
+							   ((ModifyTableState *) planstate)->mt_nplans,
 							   ancestors, es);
 			break;
 		case T_Append:
-			ExplainMemberNodes(((Append *) plan)->appendplans,
-							   ((AppendState *) planstate)->appendplans,
+			ExplainMemberNodes(((AppendState *) planstate)->appendplans,
+							   ((AppendState *) planstate)->as_nplans,
 							   ancestors, es);
 			break;
 		case T_MergeAppend:
-			ExplainMemberNodes(((MergeAppend *) plan)->mergeplans,
-							   ((MergeAppendState *) planstate)->mergeplans,
+			ExplainMemberNodes(((MergeAppendState *) planstate)->mergeplans,
+							   ((MergeAppendState *) planstate)->ms_nplans,
 							   ancestors, es);
 			break;
 		case T_BitmapAnd:
-			ExplainMemberNodes(((BitmapAnd *) plan)->bitmapplans,
-							   ((BitmapAndState *) planstate)->bitmapplans,
+			ExplainMemberNodes(((BitmapAndState *) planstate)->bitmapplans,
+							   ((BitmapAndState *) planstate)->nplans,
 							   ancestors, es);
 			break;
 		case T_BitmapOr:
-			ExplainMemberNodes(((BitmapOr *) plan)->bitmapplans,
-							   ((BitmapOrState *) planstate)->bitmapplans,
+			ExplainMemberNodes(((BitmapOrState *) planstate)->bitmapplans,
+							   ((BitmapOrState *) planstate)->nplans,
 							   ancestors, es);
 			break;
 		case T_SubqueryScan:
@@ -1749,6 +1776,23 @@ show_sort_keys(SortState *sortstate, List *ancestors, ExplainState *es)
 						 ancestors, es);
 }
 
+/*
+ * Likewise, for an IncrementalSort node; also show which keys are presorted.
+ */
+static void
+show_incremental_sort_keys(IncrementalSortState *sortstate, List *ancestors,
+						   ExplainState *es)
+{
+	IncrementalSort *plan = (IncrementalSort *) sortstate->ss.ps.plan;
+
+	show_sort_group_keys((PlanState *) sortstate, "Sort Key",
+						 plan->sort.numCols, plan->sort.sortColIdx,
+						 ancestors, es);
+	show_sort_group_keys((PlanState *) sortstate, "Presorted Key",
+						 plan->presortedCols, plan->sort.sortColIdx,
+						 ancestors, es);
+}
+
 /*
  * Likewise, for a MergeAppend node.
  */
@@ -1876,6 +1920,17 @@ show_sort_info(SortState *sortstate, ExplainState *es)
 	}
 }
 
+/*
+ * If it's EXPLAIN ANALYZE, show how many batches an incremental sort sorted
+ */
+static void
+show_incremental_sort_info(IncrementalSortState *sortstate, ExplainState *es)
+{
+	Assert(IsA(sortstate, IncrementalSortState));
+	if (es->analyze)
+		ExplainPropertyLong("Sort Batches", sortstate->nbatches, es);
+}
+
 /*
  * Show information on hash buckets/batches.
  */
@@ -2218,14 +2273,13 @@ show_modifytable_info(ModifyTableState *mtstate, ExplainState *es)
  * The ancestors list should already contain the immediate parent of these
  * plans.
  *
- * Note: we don't actually need to examine the Plan list members, but
- * we need the list in order to determine the length of the PlanState array.
+ * The number of PlanStates is taken from the executor state rather than the
+ * Plan, as an Append may have pruned some of its subplans at startup.
  */
 static void
-ExplainMemberNodes(List *plans, PlanState **planstates,
+ExplainMemberNodes(PlanState **planstates, int nplans,
 				   List *ancestors, ExplainState *es)
 {
-	int			nplans = list_length(plans);
 	int			j;
 
 	for (j = 0; j < nplans; j++)
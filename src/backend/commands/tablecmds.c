@@ -29,6 +29,8 @@
 #include "catalog/indexing.h"
 #include "catalog/namespace.h"
 #include "catalog/objectaccess.h"
+#include "catalog/partition.h"
+#include "catalog/pg_am.h"
 #include "catalog/pg_collation.h"
 #include "catalog/pg_constraint.h"
 #include "catalog/pg_depend.h"
@@ -37,6 +39,7 @@
 #include "catalog/pg_inherits_fn.h"
 #include "catalog/pg_namespace.h"
 #include "catalog/pg_opclass.h"
+#include "catalog/pg_partitioned_table.h"
 #include "catalog/pg_tablespace.h"
 #include "catalog/pg_trigger.h"
 #include "catalog/pg_type.h"
@@ -263,13 +266,17 @@ struct DropRelationCallbackState
 
 static void truncate_check_rel(Relation rel);
 static List *MergeAttributes(List *schema, List *supers, char relpersistence,
+				bool is_partition,
 				List **supOids, List **supconstr, int *supOidCount);
 static bool MergeCheckConstraint(List *constraints, char *name, Node *expr);
 static void MergeAttributesIntoExisting(Relation child_rel, Relation parent_rel);
 static void MergeConstraintsIntoExisting(Relation child_rel, Relation parent_rel);
-static void StoreCatalogInheritance(Oid relationId, List *supers);
+static void StoreCatalogInheritance(Oid relationId, List *supers,
+						Node *bound);
 static void StoreCatalogInheritance1(Oid relationId, Oid parentOid,
-						 int16 seqNumber, Relation inhRelation);
+						 int16 seqNumber, Relation inhRelation,
+						 Node *bound);
+static void StorePartitionSpec(Relation rel, PartitionSpec *partspec);
 static int	findAttrByName(const char *attributeName, List *schema);
 static void AlterIndexNamespaces(Relation classRel, Relation rel,
 				   Oid oldNspOid, Oid newNspOid, ObjectAddresses *objsMoved);
@@ -452,6 +459,8 @@ DefineRelation(CreateStmt *stmt, char relkind, Oid ownerId)
 	AttrNumber	attnum;
 	static char *validnsps[] = HEAP_RELOPT_NAMESPACES;
 	Oid			ofTypeId;
+	Relation	parent = NULL;
+	PartitionBoundSpec *bound = NULL;
 
 	/*
 	 * Truncate relname to appropriate length (probably a waste of time, as
@@ -471,6 +480,10 @@ DefineRelation(CreateStmt *stmt, char relkind, Oid ownerId)
 		ereport(ERROR,
 				(errcode(ERRCODE_WRONG_OBJECT_TYPE),
 				 errmsg("constraints are not supported on foreign tables")));
+	if (stmt->partspec != NULL && stmt->inhRelations != NIL)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_TABLE_DEFINITION),
+				 errmsg("cannot create partitioned table as inheritance child")));
 
 	/*
 	 * Look up the namespace in which we are supposed to create the relation,
@@ -549,14 +562,41 @@ DefineRelation(CreateStmt *stmt, char relkind, Oid ownerId)
 	else
 		ofTypeId = InvalidOid;
 
+	/*
+	 * A new partition changes the set of partitions rows are routed to, so
+	 * lock the parent against all concurrent use before MergeAttributes gets
+	 * to it.
+	 */
+	if (stmt->partbound != NULL)
+	{
+		Assert(list_length(stmt->inhRelations) == 1);
+		(void) RangeVarGetRelid((RangeVar *) linitial(stmt->inhRelations),
+								AccessExclusiveLock, false);
+	}
+
 	/*
 	 * Look up inheritance ancestors and generate relation schema, including
 	 * inherited attributes.
 	 */
 	schema = MergeAttributes(schema, stmt->inhRelations,
 							 stmt->relation->relpersistence,
+							 stmt->partbound != NULL,
 							 &inheritOids, &old_constraints, &parentOidCount);
 
+	/*
+	 * Check that the bound of a new partition doesn't overlap those of the
+	 * existing partitions.
+	 */
+	if (stmt->partbound != NULL)
+	{
+		ParseState *pstate = make_parsestate(NULL);
+
+		parent = heap_open(linitial_oid(inheritOids), NoLock);
+		bound = transformPartitionBound(pstate, parent, stmt->partbound);
+		check_new_partition_bound(relname, parent, bound);
+		free_parsestate(pstate);
+	}
+
 	/*
 	 * Create a tuple descriptor from the relation schema.	Note that this
 	 * deals with column names, types, and NOT NULL constraints, but not
@@ -569,6 +609,12 @@ DefineRelation(CreateStmt *stmt, char relkind, Oid ownerId)
 										relkind == RELKIND_FOREIGN_TABLE));
 	descriptor->tdhasoid = (localHasOids || parentOidCount > 0);
 
+	/* Routed rows come from the parent, so they can't carry OIDs */
+	if (parent != NULL && localHasOids && parentOidCount == 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_WRONG_OBJECT_TYPE),
+				 errmsg("cannot create table with OIDs as partition of table without OIDs")));
+
 	/*
 	 * Find columns with default values and prepare for insertion of the
 	 * defaults.  Pre-cooked (that is, inherited) defaults go into a list of
@@ -649,7 +695,14 @@ DefineRelation(CreateStmt *stmt, char relkind, Oid ownerId)
 										  false);
 
 	/* Store inheritance information for new rel. */
-	StoreCatalogInheritance(relationId, inheritOids);
+	StoreCatalogInheritance(relationId, inheritOids, (Node *) bound);
+
+	/* The parent's partition descriptor must now include the new rel */
+	if (parent != NULL)
+	{
+		CacheInvalidateRelcache(parent);
+		heap_close(parent, NoLock);
+	}
 
 	/*
 	 * We must bump the command counter to make the newly-created relation
@@ -678,6 +731,10 @@ DefineRelation(CreateStmt *stmt, char relkind, Oid ownerId)
 		AddRelationNewConstraints(rel, rawDefaults, stmt->constraints,
 								  true, true, false);
 
+	/* Store the partition key, if the new relation is partitioned */
+	if (stmt->partspec != NULL)
+		StorePartitionSpec(rel, stmt->partspec);
+
 	/*
 	 * Clean up.  We keep lock on new relation (although it shouldn't be
 	 * visible to anyone else anyway, until commit).
@@ -884,7 +941,8 @@ RemoveRelations(DropStmt *drop)
 
 /*
  * Before acquiring a table lock, check whether we have sufficient rights.
- * In the case of DROP INDEX, also try to lock the table before the index.
+ * In the case of DROP INDEX, also try to lock the table before the index,
+ * and in DROP TABLE of a partition, its parent before the partition.
  */
 static void
 RangeVarCallbackForDropRelation(const RangeVar *rel, Oid relOid, Oid oldRelOid,
@@ -951,6 +1009,17 @@ RangeVarCallbackForDropRelation(const RangeVar *rel, Oid relOid, Oid oldRelOid,
 		if (OidIsValid(state->heapOid))
 			LockRelationOid(state->heapOid, heap_lockmode);
 	}
+
+	/*
+	 * Likewise, in DROP TABLE of a partition, lock the partitioned table
+	 * first, since its set of partitions is changing.
+	 */
+	if (relkind == RELKIND_RELATION && relOid != oldRelOid)
+	{
+		state->heapOid = get_partition_parent(relOid);
+		if (OidIsValid(state->heapOid))
+			LockRelationOid(state->heapOid, heap_lockmode);
+	}
 }
 
 /*
@@ -1321,6 +1390,8 @@ storage_name(char c)
  *		of ColumnDef's.) It is destructively changed.
  * 'supers' is a list of names (as RangeVar nodes) of parent relations.
  * 'relpersistence' is a persistence type of the table.
+ * 'is_partition' tells if the table is being created as a partition of its
+ *		only parent.
  *
  * Output arguments:
  * 'supOids' receives a list of the OIDs of the parent relations.
@@ -1372,7 +1443,7 @@ storage_name(char c)
  */
 static List *
 MergeAttributes(List *schema, List *supers, char relpersistence,
-				List **supOids, List **supconstr, int *supOidCount)
+				bool is_partition, List **supOids, List **supconstr, int *supOidCount)
 {
 	ListCell   *entry;
 	List	   *inhSchema = NIL;
@@ -1503,6 +1574,36 @@ MergeAttributes(List *schema, List *supers, char relpersistence,
 					(errcode(ERRCODE_WRONG_OBJECT_TYPE),
 					 errmsg("cannot inherit from temporary relation of another session")));
 
+		/*
+		 * A partitioned table can only have partitions as children, and a
+		 * partition can't have children at all.
+		 */
+		if (is_partition)
+		{
+			if (RelationGetPartitionKey(relation) == NULL)
+				ereport(ERROR,
+						(errcode(ERRCODE_WRONG_OBJECT_TYPE),
+						 errmsg("\"%s\" is not partitioned",
+								parent->relname)));
+			/* Rows routed to it must be visible to every session */
+			if (relpersistence == RELPERSISTENCE_TEMP &&
+				relation->rd_rel->relpersistence != RELPERSISTENCE_TEMP)
+				ereport(ERROR,
+						(errcode(ERRCODE_WRONG_OBJECT_TYPE),
+						 errmsg("cannot create a temporary partition of permanent relation \"%s\"",
+								parent->relname)));
+		}
+		else if (RelationGetPartitionKey(relation) != NULL)
+			ereport(ERROR,
+					(errcode(ERRCODE_WRONG_OBJECT_TYPE),
+					 errmsg("cannot inherit from partitioned table \"%s\"",
+							parent->relname)));
+		else if (OidIsValid(get_partition_parent(RelationGetRelid(relation))))
+			ereport(ERROR,
+					(errcode(ERRCODE_WRONG_OBJECT_TYPE),
+					 errmsg("cannot inherit from partition \"%s\"",
+							parent->relname)));
+
 		/*
 		 * We should have an UNDER permission flag for this, but for now,
 		 * demand that creator of a child table own the parent.
@@ -1918,9 +2019,11 @@ MergeCheckConstraint(List *constraints, char *name, Node *expr)
  *		Updates the system catalogs with proper inheritance information.
  *
  * supers is a list of the OIDs of the new relation's direct ancestors.
+ * bound is the partition bound, if the new relation is a partition of its
+ * only parent, else NULL.
  */
 static void
-StoreCatalogInheritance(Oid relationId, List *supers)
+StoreCatalogInheritance(Oid relationId, List *supers, Node *bound)
 {
 	Relation	relation;
 	int16		seqNumber;
@@ -1950,7 +2053,8 @@ StoreCatalogInheritance(Oid relationId, List *supers)
 	{
 		Oid			parentOid = lfirst_oid(entry);
 
-		StoreCatalogInheritance1(relationId, parentOid, seqNumber, relation);
+		StoreCatalogInheritance1(relationId, parentOid, seqNumber, relation,
+								 bound);
 		seqNumber++;
 	}
 
@@ -1960,10 +2064,12 @@ StoreCatalogInheritance(Oid relationId, List *supers)
 /*
  * Make catalog entries showing relationId as being an inheritance child
  * of parentOid.  inhRelation is the already-opened pg_inherits catalog.
+ * bound is the partition bound if relationId is a partition, else NULL.
  */
 static void
 StoreCatalogInheritance1(Oid relationId, Oid parentOid,
-						 int16 seqNumber, Relation inhRelation)
+						 int16 seqNumber, Relation inhRelation,
+						 Node *bound)
 {
 	TupleDesc	desc = RelationGetDescr(inhRelation);
 	Datum		values[Natts_pg_inherits];
@@ -1981,6 +2087,12 @@ StoreCatalogInheritance1(Oid relationId, Oid parentOid,
 
 	memset(nulls, 0, sizeof(nulls));
 
+	if (bound != NULL)
+		values[Anum_pg_inherits_inhbound - 1] =
+			CStringGetTextDatum(nodeToString(bound));
+	else
+		nulls[Anum_pg_inherits_inhbound - 1] = true;
+
 	tuple = heap_form_tuple(desc, values, nulls);
 
 	simple_heap_insert(inhRelation, tuple);
@@ -1999,7 +2111,9 @@ StoreCatalogInheritance1(Oid relationId, Oid parentOid,
 	childobject.objectId = relationId;
 	childobject.objectSubId = 0;
 
-	recordDependencyOn(&childobject, &parentobject, DEPENDENCY_NORMAL);
+	/* Partitions go away with their parent */
+	recordDependencyOn(&childobject, &parentobject,
+					   bound != NULL ? DEPENDENCY_AUTO : DEPENDENCY_NORMAL);
 
 	/*
 	 * Post creation hook of this inheritance. Since object_access_hook
@@ -2016,6 +2130,63 @@ StoreCatalogInheritance1(Oid relationId, Oid parentOid,
 	SetRelationHasSubclass(parentOid, true);
 }
 
+/*
+ * Check the PARTITION BY clause of a new partitioned table, and store its
+ * partition key.
+ */
+static void
+StorePartitionSpec(Relation rel, PartitionSpec *partspec)
+{
+	char		strategy;
+	AttrNumber	attnum;
+	Form_pg_attribute attform;
+	Oid			opclass;
+	Oid			collation;
+
+	if (pg_strcasecmp(partspec->strategy, "range") == 0)
+		strategy = PARTITION_STRATEGY_RANGE;
+	else if (pg_strcasecmp(partspec->strategy, "list") == 0)
+		strategy = PARTITION_STRATEGY_LIST;
+	else
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("unrecognized partitioning strategy \"%s\"",
+						partspec->strategy)));
+
+	if (SystemAttributeByName(partspec->colname,
+							  rel->rd_rel->relhasoids) != NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_TABLE_DEFINITION),
+				 errmsg("cannot use system column \"%s\" in partition key",
+						partspec->colname)));
+
+	attnum = get_attnum(RelationGetRelid(rel), partspec->colname);
+	if (attnum == InvalidAttrNumber)
+		ereport(ERROR,
+				(errcode(ERRCODE_UNDEFINED_COLUMN),
+				 errmsg("column \"%s\" named in partition key does not exist",
+						partspec->colname)));
+	attform = RelationGetDescr(rel)->attrs[attnum - 1];
+
+	/* Rows are routed and partitions pruned by the key's btree opclass */
+	opclass = GetIndexOpClass(partspec->opclass, attform->atttypid,
+							  "btree", BTREE_AM_OID);
+
+	if (partspec->collation != NIL)
+	{
+		if (!type_is_collatable(attform->atttypid))
+			ereport(ERROR,
+					(errcode(ERRCODE_DATATYPE_MISMATCH),
+					 errmsg("collations are not supported by type %s",
+							format_type_be(attform->atttypid))));
+		collation = get_collation_oid(partspec->collation, false);
+	}
+	else
+		collation = attform->attcollation;
+
+	StorePartitionKey(rel, strategy, attnum, opclass, collation);
+}
+
 /*
  * Look for an existing schema entry with the given name.
  *
@@ -4449,6 +4620,12 @@ ATExecAddColumn(List **wqueue, AlteredTableInfo *tab, Relation rel,
 	if (recursing)
 		ATSimplePermissions(rel, ATT_TABLE);
 
+	/* A partition must have exactly the columns of its parent */
+	if (!recursing && OidIsValid(get_partition_parent(myrelid)))
+		ereport(ERROR,
+				(errcode(ERRCODE_WRONG_OBJECT_TYPE),
+				 errmsg("cannot add column to a partition")));
+
 	attrdesc = heap_open(AttributeRelationId, RowExclusiveLock);
 
 	/*
@@ -5384,6 +5561,19 @@ ATExecDropColumn(List **wqueue, Relation rel, const char *colName,
 				 errmsg("cannot drop inherited column \"%s\"",
 						colName)));
 
+	/* Don't drop the partition key, nor leave partitions out of step */
+	if (RelationGetPartitionKey(rel) != NULL)
+	{
+		if (attnum == RelationGetPartitionKey(rel)->partattnum)
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_TABLE_DEFINITION),
+					 errmsg("cannot drop column named in partition key")));
+		if (!recurse)
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_TABLE_DEFINITION),
+				 errmsg("column must be dropped from partitions too")));
+	}
+
 	ReleaseSysCache(tuple);
 
 	/*
@@ -7454,6 +7644,13 @@ ATPrepAlterColumnType(List **wqueue,
 				 errmsg("cannot alter inherited column \"%s\"",
 						colName)));
 
+	/* The stored partition bounds are of the key's type */
+	if (RelationGetPartitionKey(rel) != NULL &&
+		attnum == RelationGetPartitionKey(rel)->partattnum)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_TABLE_DEFINITION),
+				 errmsg("cannot alter type of column named in partition key")));
+
 	/* Look up the target type */
 	typenameTypeIdAndMod(NULL, typeName, &targettype, &targettypmod);
 
@@ -9273,6 +9470,15 @@ ATPrepAddInherit(Relation child_rel)
 		ereport(ERROR,
 				(errcode(ERRCODE_WRONG_OBJECT_TYPE),
 				 errmsg("cannot change inheritance of typed table")));
+
+	if (RelationGetPartitionKey(child_rel) != NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_WRONG_OBJECT_TYPE),
+				 errmsg("cannot change inheritance of partitioned table")));
+	if (OidIsValid(get_partition_parent(RelationGetRelid(child_rel))))
+		ereport(ERROR,
+				(errcode(ERRCODE_WRONG_OBJECT_TYPE),
+				 errmsg("cannot change inheritance of partition")));
 }
 
 static void
@@ -9320,6 +9526,18 @@ ATExecAddInherit(Relation child_rel, RangeVar *parent, LOCKMODE lockmode)
 				(errcode(ERRCODE_WRONG_OBJECT_TYPE),
 		 errmsg("cannot inherit to temporary relation of another session")));
 
+	/* Partitions can only be added by CREATE TABLE ... PARTITION OF */
+	if (RelationGetPartitionKey(parent_rel) != NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_WRONG_OBJECT_TYPE),
+				 errmsg("cannot inherit from partitioned table \"%s\"",
+						RelationGetRelationName(parent_rel))));
+	if (OidIsValid(get_partition_parent(RelationGetRelid(parent_rel))))
+		ereport(ERROR,
+				(errcode(ERRCODE_WRONG_OBJECT_TYPE),
+				 errmsg("cannot inherit from partition \"%s\"",
+						RelationGetRelationName(parent_rel))));
+
 	/*
 	 * Check for duplicates in the list of parents, and determine the highest
 	 * inhseqno already present; we'll use the next one for the new parent.
@@ -9397,7 +9615,8 @@ ATExecAddInherit(Relation child_rel, RangeVar *parent, LOCKMODE lockmode)
 	StoreCatalogInheritance1(RelationGetRelid(child_rel),
 							 RelationGetRelid(parent_rel),
 							 inhseqno + 1,
-							 catalogRelation);
+							 catalogRelation,
+							 NULL);
 
 	/* Now we're done with pg_inherits */
 	heap_close(catalogRelation, RowExclusiveLock);
@@ -9692,6 +9911,11 @@ ATExecDropInherit(Relation rel, RangeVar *parent, LOCKMODE lockmode)
 	 */
 	parent_rel = heap_openrv(parent, AccessShareLock);
 
+	if (OidIsValid(get_partition_parent(RelationGetRelid(rel))))
+		ereport(ERROR,
+				(errcode(ERRCODE_WRONG_OBJECT_TYPE),
+				 errmsg("cannot change inheritance of partition")));
+
 	/*
 	 * We don't bother to check ownership of the parent table --- ownership of
 	 * the child is presumed enough rights.
@@ -110,6 +110,15 @@ vacuum(VacuumStmt *vacstmt, Oid relid, bool do_toast,
 
 	stmttype = (vacstmt->options & VACOPT_VACUUM) ? "VACUUM" : "ANALYZE";
 
+	/*
+	 * Index vacuuming is only ever parallelized by lazy vacuum; VACUUM FULL
+	 * rebuilds the indexes instead.
+	 */
+	if ((vacstmt->options & VACOPT_FULL) && vacstmt->parallel_workers > 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("VACUUM option PARALLEL cannot be used with FULL")));
+
 	/*
 	 * We cannot run VACUUM inside a user transaction block; if we were inside
 	 * a transaction, then our commit- and start-transaction-command calls
@@ -4,24 +4,34 @@
  *	  Concurrent ("lazy") vacuuming.
  *
  *
- * The major space usage for LAZY VACUUM is storage for the array of dead
- * tuple TIDs, with the next biggest need being storage for per-disk-page
- * free space info.  We want to ensure we can vacuum even the very largest
- * relations with finite memory space usage.  To do that, we set upper bounds
- * on the number of tuples and pages we will keep track of at once.
+ * The major space usage for LAZY VACUUM is storage for the dead tuple TIDs,
+ * with the next biggest need being storage for per-disk-page free space info.
+ * We want to ensure we can vacuum even the very largest relations with finite
+ * memory space usage.  To do that, we set upper bounds on the number of
+ * tuples and pages we will keep track of at once.
  *
  * We are willing to use at most maintenance_work_mem (or perhaps
  * autovacuum_work_mem) memory space to keep track of dead tuples.  We
- * initially allocate an array of TIDs of that size, with an upper limit that
- * depends on table size (this limit ensures we don't allocate a huge area
- * uselessly for vacuuming small tables).  If the array threatens to overflow,
+ * initially allocate a TID store (see access/common/tidstore.c) of that size,
+ * with an upper limit that depends on table size (this limit ensures we don't
+ * allocate a huge area uselessly for vacuuming small tables).  The store
+ * keeps each page's dead tuples as a bitmap or a short offset list, so it
+ * holds far more TIDs than a flat array of the same size would, and it is
+ * not subject to the 1GB palloc limit.  If the store threatens to overflow,
  * we suspend the heap scan phase and perform a pass of index cleanup and page
- * compaction, then resume the heap scan with an empty TID array.
+ * compaction, then resume the heap scan with an empty store.
  *
  * If we're processing a table with no indexes, we can just vacuum each page
  * as we go; there's no need to save up multiple tuples to minimize the number
  * of index scans performed.  So we don't use maintenance_work_mem memory for
- * the TID array, just enough to hold as many heap tuples as fit on one page.
+ * the TID store, just enough to hold as many heap tuples as fit on one page.
+ *
+ * If the user asks for it with VACUUM (PARALLEL n), the index vacuuming and
+ * index cleanup passes over a relation with more than one index are shared
+ * between this backend and up to n dynamic background workers.  The TID
+ * store then lives in a dynamic shared memory segment, and each index is
+ * handed out to exactly one process per pass.  The heap scan itself, and all
+ * catalog updates and progress reporting, remain with the leader.
  *
  *
  * Portions Copyright (c) 1996-2014, PostgreSQL Global Development Group
@@ -42,22 +52,34 @@
 #include "access/heapam_xlog.h"
 #include "access/htup_details.h"
 #include "access/multixact.h"
+#include "access/tidstore.h"
 #include "access/transam.h"
 #include "access/visibilitymap.h"
+#include "access/xact.h"
 #include "catalog/catalog.h"
 #include "catalog/storage.h"
 #include "commands/dbcommands.h"
 #include "commands/vacuum.h"
+#include "libpq/pqsignal.h"
 #include "miscadmin.h"
 #include "pgstat.h"
 #include "portability/instr_time.h"
 #include "postmaster/autovacuum.h"
+#include "postmaster/bgworker.h"
 #include "storage/bufmgr.h"
+#include "storage/dsm.h"
+#include "storage/dsm_impl.h"
 #include "storage/freespace.h"
 #include "storage/lmgr.h"
+#include "storage/proc.h"
+#include "storage/shm_toc.h"
+#include "storage/spin.h"
+#include "tcop/tcopprot.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
 #include "utils/pg_rusage.h"
+#include "utils/resowner.h"
+#include "utils/snapmgr.h"
 #include "utils/timestamp.h"
 #include "utils/tqual.h"
 
@@ -83,19 +105,80 @@
 #define VACUUM_TRUNCATE_LOCK_WAIT_INTERVAL		50		/* ms */
 #define VACUUM_TRUNCATE_LOCK_TIMEOUT			5000	/* ms */
 
-/*
- * Guesstimation of number of dead tuples per page.  This is used to
- * provide an upper limit to memory allocated when vacuuming small
- * tables.
- */
-#define LAZY_ALLOC_TUPLES		MaxHeapTuplesPerPage
-
 /*
  * Before we consider skipping a page that's marked as clean in
  * visibility map, we must've seen at least this many clean pages.
  */
 #define SKIP_PAGES_THRESHOLD	((BlockNumber) 32)
 
+/*
+ * Magic number and table-of-contents keys for the dynamic shared memory
+ * segment used by parallel index vacuuming.
+ */
+#define PARALLEL_VACUUM_MAGIC				0x50564143
+#define PARALLEL_VACUUM_KEY_SHARED			1
+#define PARALLEL_VACUUM_KEY_DEAD_TUPLES		2
+
+/* Which index pass a parallel vacuum is currently performing */
+typedef enum LVParallelPhase
+{
+	LV_PHASE_BULKDELETE,		/* ambulkdelete, removing dead tuples */
+	LV_PHASE_CLEANUP			/* amvacuumcleanup */
+} LVParallelPhase;
+
+/*
+ * Per-index state shared between the leader and the parallel workers.  The
+ * stats field carries the index AM's running statistics from one pass to
+ * the next; every 9.4 index AM returns a plain IndexBulkDeleteResult, so it
+ * can be copied in and out of shared memory as is.
+ */
+typedef struct LVSharedIndStats
+{
+	Oid			indexoid;		/* OID of the index */
+	bool		done;			/* processed in the current pass? */
+	bool		valid;			/* does stats hold anything? */
+	IndexBulkDeleteResult stats;
+} LVSharedIndStats;
+
+/*
+ * Shared state for parallel index vacuuming, stored at
+ * PARALLEL_VACUUM_KEY_SHARED.  Everything except nextidx and the per-index
+ * done/valid/stats fields is written by the leader only, before any worker
+ * is launched for a pass.
+ */
+typedef struct LVShared
+{
+	slock_t		mutex;			/* protects nextidx */
+	int			nextidx;		/* next index to hand out in this pass */
+
+	/* fixed for the life of the parallel vacuum */
+	char		dbname[NAMEDATALEN];
+	int			elevel;
+	int			cost_delay;
+	int			cost_limit;
+	int			cost_page_hit;
+	int			cost_page_miss;
+	int			cost_page_dirty;
+	int			nindexes;
+
+	/* set up by the leader for each pass */
+	LVParallelPhase phase;
+	bool		estimated_count;
+	double		num_heap_tuples;
+
+	LVSharedIndStats indstats[FLEXIBLE_ARRAY_MEMBER];
+} LVShared;
+
+/* Leader-private state for parallel index vacuuming */
+typedef struct LVParallelState
+{
+	dsm_segment *seg;
+	LVShared   *lvshared;
+	int			nworkers;		/* # of workers requested */
+	int			nlaunched;		/* # registered for the current pass */
+	BackgroundWorkerHandle **handles;
+} LVParallelState;
+
 typedef struct LVRelStats
 {
 	/* hasindex = true means two-pass strategy; false means one-pass */
@@ -104,6 +187,7 @@ typedef struct LVRelStats
 	BlockNumber old_rel_pages;	/* previous value of pg_class.relpages */
 	BlockNumber rel_pages;		/* total number of pages */
 	BlockNumber scanned_pages;	/* number of pages we examined */
+	BlockNumber frozenskipped_pages;	/* # of frozen pages we skipped */
 	double		scanned_tuples; /* counts only tuples on scanned pages */
 	double		old_rel_tuples; /* previous value of pg_class.reltuples */
 	double		new_rel_tuples; /* new estimated total # of tuples */
@@ -111,14 +195,14 @@ typedef struct LVRelStats
 	BlockNumber pages_removed;
 	double		tuples_deleted;
 	BlockNumber nonempty_pages; /* actually, last nonempty page + 1 */
-	/* List of TIDs of tuples we intend to delete */
-	/* NB: this list is ordered by TID address */
-	int			num_dead_tuples;	/* current # of entries */
-	int			max_dead_tuples;	/* # slots allocated in array */
-	ItemPointer dead_tuples;	/* array of ItemPointerData */
+	/* TIDs of tuples we intend to delete, added in block order */
+	TidStore   *dead_tuples;
 	int			num_index_scans;
 	TransactionId latestRemovedXid;
 	bool		lock_waiter_detected;
+	/* Parallel index vacuuming */
+	int			parallel_workers;	/* # of workers requested, 0 if none */
+	LVParallelState *lps;		/* NULL if not vacuuming indexes in parallel */
 } LVRelStats;
 
 
@@ -143,18 +227,42 @@ static void lazy_vacuum_index(Relation indrel,
 static void lazy_cleanup_index(Relation indrel,
 				   IndexBulkDeleteResult *stats,
 				   LVRelStats *vacrelstats);
-static int lazy_vacuum_page(Relation onerel, BlockNumber blkno, Buffer buffer,
-				 int tupindex, LVRelStats *vacrelstats, Buffer *vmbuffer);
+static void lazy_report_index_cleanup(Relation indrel,
+						  IndexBulkDeleteResult *stats,
+						  PGRUsage *ru0);
+static void lazy_vacuum_all_indexes(Relation *Irel, int nindexes,
+						IndexBulkDeleteResult **indstats,
+						LVRelStats *vacrelstats);
+static void lazy_cleanup_all_indexes(Relation *Irel, int nindexes,
+						 IndexBulkDeleteResult **indstats,
+						 LVRelStats *vacrelstats);
+static LVParallelState *begin_parallel_vacuum(LVRelStats *vacrelstats,
+					  Relation *Irel, int nindexes,
+					  BlockNumber relblocks);
+static void end_parallel_vacuum(LVRelStats *vacrelstats);
+static void lazy_parallel_vacuum_indexes(Relation *Irel, int nindexes,
+							 IndexBulkDeleteResult **indstats,
+							 LVRelStats *vacrelstats,
+							 LVParallelPhase phase);
+static void lazy_parallel_process_indexes(Relation *Irel, LVShared *lvshared,
+							  TidStore *dead_tuples);
+static void lazy_parallel_vacuum_one_index(Relation indrel, LVShared *lvshared,
+							   int idx, TidStore *dead_tuples);
+static void lazy_launch_parallel_workers(LVParallelState *lps, int nindexes);
+static void lazy_wait_for_parallel_workers(LVParallelState *lps);
+static void lazy_parallel_terminate_workers(dsm_segment *seg, Datum arg);
+static void lazy_vacuum_page(Relation onerel, BlockNumber blkno, Buffer buffer,
+				 OffsetNumber *deadoffsets, int ndeadoffsets,
+				 LVRelStats *vacrelstats, Buffer *vmbuffer);
 static void lazy_truncate_heap(Relation onerel, LVRelStats *vacrelstats);
 static BlockNumber count_nondeletable_pages(Relation onerel,
 						 LVRelStats *vacrelstats);
+static Size lazy_dead_tuples_space(LVRelStats *vacrelstats,
+					   BlockNumber relblocks);
 static void lazy_space_alloc(LVRelStats *vacrelstats, BlockNumber relblocks);
-static void lazy_record_dead_tuple(LVRelStats *vacrelstats,
-					   ItemPointer itemptr);
 static bool lazy_tid_reaped(ItemPointer itemptr, void *state);
-static int	vac_cmp_itemptr(const void *left, const void *right);
 static bool heap_page_is_all_visible(Relation rel, Buffer buf,
-						 TransactionId *visibility_cutoff_xid);
+						 TransactionId *visibility_cutoff_xid, bool *all_frozen);
 
 
 /*
@@ -181,7 +289,7 @@ lazy_vacuum_rel(Relation onerel, VacuumStmt *vacstmt,
 	double		read_rate,
 				write_rate;
 	bool		scan_all;		/* should we scan all pages? */
-	bool		scanned_all;	/* did we actually scan all pages? */
+	bool		scanned_all_unfrozen;	/* actually scanned all such pages? */
 	TransactionId xidFullScanLimit;
 	MultiXactId mxactFullScanLimit;
 	BlockNumber new_rel_pages;
@@ -230,6 +338,8 @@ lazy_vacuum_rel(Relation onerel, VacuumStmt *vacstmt,
 	vacrelstats->num_index_scans = 0;
 	vacrelstats->pages_removed = 0;
 	vacrelstats->lock_waiter_detected = false;
+	vacrelstats->parallel_workers = vacstmt->parallel_workers;
+	vacrelstats->lps = NULL;
 
 	/* Open all indexes of the relation */
 	vac_open_indexes(onerel, RowExclusiveLock, &nindexes, &Irel);
@@ -242,19 +352,20 @@ lazy_vacuum_rel(Relation onerel, VacuumStmt *vacstmt,
 	vac_close_indexes(nindexes, Irel, NoLock);
 
 	/*
-	 * Compute whether we actually scanned the whole relation. If we did, we
-	 * can adjust relfrozenxid and relminmxid.
+	 * Compute whether we actually scanned all the unfrozen pages. If we did,
+	 * we can adjust relfrozenxid and relminmxid.
 	 *
 	 * NB: We need to check this before truncating the relation, because that
 	 * will change ->rel_pages.
 	 */
-	if (vacrelstats->scanned_pages < vacrelstats->rel_pages)
+	if ((vacrelstats->scanned_pages + vacrelstats->frozenskipped_pages)
+		< vacrelstats->rel_pages)
 	{
 		Assert(!scan_all);
-		scanned_all = false;
+		scanned_all_unfrozen = false;
 	}
 	else
-		scanned_all = true;
+		scanned_all_unfrozen = true;
 
 	/*
 	 * Optionally truncate the relation.
@@ -285,8 +396,9 @@ lazy_vacuum_rel(Relation onerel, VacuumStmt *vacstmt,
 	 * is all-visible we'd definitely like to know that.  But clamp the value
 	 * to be not more than what we're setting relpages to.
 	 *
-	 * Also, don't change relfrozenxid/relminmxid if we skipped any pages,
-	 * since then we don't know for certain that all tuples have a newer xmin.
+	 * Also, don't change relfrozenxid/relminmxid if we skipped any pages
+	 * that weren't all-frozen, since then we don't know for certain that all
+	 * tuples have a newer xmin.
 	 */
 	new_rel_pages = vacrelstats->rel_pages;
 	new_rel_tuples = vacrelstats->new_rel_tuples;
@@ -296,12 +408,12 @@ lazy_vacuum_rel(Relation onerel, VacuumStmt *vacstmt,
 		new_rel_tuples = vacrelstats->old_rel_tuples;
 	}
 
-	new_rel_allvisible = visibilitymap_count(onerel);
+	visibilitymap_count(onerel, &new_rel_allvisible, NULL);
 	if (new_rel_allvisible > new_rel_pages)
 		new_rel_allvisible = new_rel_pages;
 
-	new_frozen_xid = scanned_all ? FreezeLimit : InvalidTransactionId;
-	new_min_multi = scanned_all ? MultiXactCutoff : InvalidMultiXactId;
+	new_frozen_xid = scanned_all_unfrozen ? FreezeLimit : InvalidTransactionId;
+	new_min_multi = scanned_all_unfrozen ? MultiXactCutoff : InvalidMultiXactId;
 
 	vac_update_relstats(onerel,
 						new_rel_pages,
@@ -343,7 +455,7 @@ lazy_vacuum_rel(Relation onerel, VacuumStmt *vacstmt,
 			}
 			ereport(LOG,
 					(errmsg("automatic vacuum of table \"%s.%s.%s\": index scans: %d\n"
-							"pages: %d removed, %d remain\n"
+							"pages: %d removed, %d remain, %d skipped frozen\n"
 							"tuples: %.0f removed, %.0f remain, %.0f are dead but not yet removable\n"
 							"buffer usage: %d hits, %d misses, %d dirtied\n"
 					  "avg read rate: %.3f MB/s, avg write rate: %.3f MB/s\n"
@@ -354,6 +466,7 @@ lazy_vacuum_rel(Relation onerel, VacuumStmt *vacstmt,
 							vacrelstats->num_index_scans,
 							vacrelstats->pages_removed,
 							vacrelstats->rel_pages,
+							vacrelstats->frozenskipped_pages,
 							vacrelstats->tuples_deleted,
 							vacrelstats->new_rel_tuples,
 							vacrelstats->new_dead_tuples,
@@ -433,8 +546,8 @@ lazy_scan_heap(Relation onerel, LVRelStats *vacrelstats,
 	int			i;
 	PGRUsage	ru0;
 	Buffer		vmbuffer = InvalidBuffer;
-	BlockNumber next_not_all_visible_block;
-	bool		skipping_all_visible_blocks;
+	BlockNumber next_unskippable_block;
+	bool		skipping_blocks;
 	xl_heap_freeze_tuple *frozen;
 
 	pg_rusage_init(&ru0);
@@ -454,10 +567,20 @@ lazy_scan_heap(Relation onerel, LVRelStats *vacrelstats,
 	nblocks = RelationGetNumberOfBlocks(onerel);
 	vacrelstats->rel_pages = nblocks;
 	vacrelstats->scanned_pages = 0;
+	vacrelstats->frozenskipped_pages = 0;
 	vacrelstats->nonempty_pages = 0;
 	vacrelstats->latestRemovedXid = InvalidTransactionId;
 
-	lazy_space_alloc(vacrelstats, nblocks);
+	/*
+	 * Set up for parallel index vacuuming if it was requested and there is
+	 * more than one index to share out; otherwise, or if that's not possible,
+	 * allocate the dead tuple array locally.
+	 */
+	if (vacrelstats->parallel_workers > 0 && nindexes > 1)
+		vacrelstats->lps = begin_parallel_vacuum(vacrelstats, Irel, nindexes,
+												 nblocks);
+	if (vacrelstats->lps == NULL)
+		lazy_space_alloc(vacrelstats, nblocks);
 	frozen = palloc(sizeof(xl_heap_freeze_tuple) * MaxHeapTuplesPerPage);
 
 	/*
@@ -471,38 +594,56 @@ lazy_scan_heap(Relation onerel, LVRelStats *vacrelstats,
 	 * of pages.
 	 *
 	 * Before entering the main loop, establish the invariant that
-	 * next_not_all_visible_block is the next block number >= blkno that's not
-	 * all-visible according to the visibility map, or nblocks if there's no
-	 * such block.	Also, we set up the skipping_all_visible_blocks flag,
-	 * which is needed because we need hysteresis in the decision: once we've
-	 * started skipping blocks, we may as well skip everything up to the next
-	 * not-all-visible block.
+	 * next_unskippable_block is the next block number >= blkno that we
+	 * can't skip based on the visibility map, either all-visible for a
+	 * regular scan or all-frozen for a scan_all one, or nblocks if there's no
+	 * such block.  Also, we set up the skipping_blocks flag, which is needed
+	 * because we need hysteresis in the decision: once we've started
+	 * skipping blocks, we may as well skip everything up to the next
+	 * unskippable block.
 	 *
-	 * Note: if scan_all is true, we won't actually skip any pages; but we
-	 * maintain next_not_all_visible_block anyway, so as to set up the
-	 * all_visible_according_to_vm flag correctly for each page.
+	 * An anti-wraparound vacuum must examine every page that might contain
+	 * an unfrozen XID, but pages whose all-frozen bit is set can't, so it can
+	 * skip those and still advance relfrozenxid.
 	 *
-	 * Note: The value returned by visibilitymap_test could be slightly
+	 * Note: The value returned by visibilitymap_get_status could be slightly
 	 * out-of-date, since we make this test before reading the corresponding
 	 * heap page or locking the buffer.  This is OK.  If we mistakenly think
-	 * that the page is all-visible when in fact the flag's just been cleared,
-	 * we might fail to vacuum the page.  But it's OK to skip pages when
-	 * scan_all is not set, so no great harm done; the next vacuum will find
-	 * them.  If we make the reverse mistake and vacuum a page unnecessarily,
-	 * it'll just be a no-op.
+	 * that the page is all-visible or all-frozen when in fact the flag's just
+	 * been cleared, we might fail to vacuum the page.  It's easy to see that
+	 * skipping a page when scan_all is not set is not a very big deal; we
+	 * might leave some dead tuples lying around, but the next vacuum will
+	 * find them.  But even when scan_all is set, it's still OK if we miss a
+	 * page whose all-frozen marking has just been cleared.  Any new XIDs just
+	 * added to that page are necessarily newer than the GlobalXmin we
+	 * computed, so they'll have no effect on the value to which we can
+	 * safely set relfrozenxid.  A similar argument applies for MXIDs and
+	 * relminmxid.
 	 */
-	for (next_not_all_visible_block = 0;
-		 next_not_all_visible_block < nblocks;
-		 next_not_all_visible_block++)
+	for (next_unskippable_block = 0;
+		 next_unskippable_block < nblocks;
+		 next_unskippable_block++)
 	{
-		if (!visibilitymap_test(onerel, next_not_all_visible_block, &vmbuffer))
-			break;
+		uint8		vmstatus;
+
+		vmstatus = visibilitymap_get_status(onerel, next_unskippable_block,
+											&vmbuffer);
+		if (scan_all)
+		{
+			if ((vmstatus & VISIBILITYMAP_ALL_FROZEN) == 0)
+				break;
+		}
+		else
+		{
+			if ((vmstatus & VISIBILITYMAP_ALL_VISIBLE) == 0)
+				break;
+		}
 		vacuum_delay_point();
 	}
-	if (next_not_all_visible_block >= SKIP_PAGES_THRESHOLD)
-		skipping_all_visible_blocks = true;
+	if (next_unskippable_block >= SKIP_PAGES_THRESHOLD)
+		skipping_blocks = true;
 	else
-		skipping_all_visible_blocks = false;
+		skipping_blocks = false;
 
 	for (blkno = 0; blkno < nblocks; blkno++)
 	{
@@ -512,43 +653,83 @@ lazy_scan_heap(Relation onerel, LVRelStats *vacrelstats,
 					maxoff;
 		bool		tupgone,
 					hastup;
-		int			prev_dead_count;
+		OffsetNumber deadoffsets[MaxHeapTuplesPerPage];
+		int			ndeadoffsets;
 		int			nfrozen;
 		Size		freespace;
-		bool		all_visible_according_to_vm;
+		bool		all_visible_according_to_vm = false;
 		bool		all_visible;
+		bool		all_frozen = true;	/* provided all_visible is also true */
 		bool		has_dead_tuples;
 		TransactionId visibility_cutoff_xid = InvalidTransactionId;
 
-		if (blkno == next_not_all_visible_block)
+		if (blkno == next_unskippable_block)
 		{
-			/* Time to advance next_not_all_visible_block */
-			for (next_not_all_visible_block++;
-				 next_not_all_visible_block < nblocks;
-				 next_not_all_visible_block++)
+			/* Time to advance next_unskippable_block */
+			for (next_unskippable_block++;
+				 next_unskippable_block < nblocks;
+				 next_unskippable_block++)
 			{
-				if (!visibilitymap_test(onerel, next_not_all_visible_block,
-										&vmbuffer))
-					break;
+				uint8		vmskipflags;
+
+				vmskipflags = visibilitymap_get_status(onerel,
+													   next_unskippable_block,
+													   &vmbuffer);
+				if (scan_all)
+				{
+					if ((vmskipflags & VISIBILITYMAP_ALL_FROZEN) == 0)
+						break;
+				}
+				else
+				{
+					if ((vmskipflags & VISIBILITYMAP_ALL_VISIBLE) == 0)
+						break;
+				}
 				vacuum_delay_point();
 			}
 
 			/*
 			 * We know we can't skip the current block.  But set up
-			 * skipping_all_visible_blocks to do the right thing at the
-			 * following blocks.
+			 * skipping_blocks to do the right thing at the following blocks.
 			 */
-			if (next_not_all_visible_block - blkno > SKIP_PAGES_THRESHOLD)
-				skipping_all_visible_blocks = true;
+			if (next_unskippable_block - blkno > SKIP_PAGES_THRESHOLD)
+				skipping_blocks = true;
 			else
-				skipping_all_visible_blocks = false;
-			all_visible_according_to_vm = false;
+				skipping_blocks = false;
+
+			/*
+			 * Normally, the fact that we can't skip this block must mean that
+			 * it's not all-visible.  But in a scan_all vacuum we know only
+			 * that it's not all-frozen, so it might still be all-visible.
+			 */
+			if (scan_all && VM_ALL_VISIBLE(onerel, blkno, &vmbuffer))
+				all_visible_according_to_vm = true;
 		}
 		else
 		{
-			/* Current block is all-visible */
-			if (skipping_all_visible_blocks && !scan_all)
+			/*
+			 * The current block is potentially skippable; if we've seen a
+			 * long enough run of skippable blocks to justify skipping it,
+			 * then go ahead and skip.  Otherwise, the page must be at least
+			 * all-visible if not all-frozen, so we can set
+			 * all_visible_according_to_vm = true.
+			 */
+			if (skipping_blocks)
+			{
+				/*
+				 * Tricky, tricky.  If this is a scan_all vacuum, the page
+				 * must have been all-frozen at the time we checked whether it
+				 * was skippable, but it might not be any more.  We must be
+				 * careful to count it as a skipped all-frozen page in that
+				 * case, or else we'll think we can't update relfrozenxid and
+				 * relminmxid.  If it's not a scan_all vacuum, we don't know
+				 * whether it was all-frozen, so we have to recheck; but in
+				 * this case an approximate answer is OK.
+				 */
+				if (scan_all || VM_ALL_FROZEN(onerel, blkno, &vmbuffer))
+					vacrelstats->frozenskipped_pages++;
 				continue;
+			}
 			all_visible_according_to_vm = true;
 		}
 
@@ -558,8 +739,8 @@ lazy_scan_heap(Relation onerel, LVRelStats *vacrelstats,
 		 * If we are close to overrunning the available space for dead-tuple
 		 * TIDs, pause and do a cycle of vacuuming before we tackle this page.
 		 */
-		if ((vacrelstats->max_dead_tuples - vacrelstats->num_dead_tuples) < MaxHeapTuplesPerPage &&
-			vacrelstats->num_dead_tuples > 0)
+		if (tidstore_is_full(vacrelstats->dead_tuples) &&
+			tidstore_num_tids(vacrelstats->dead_tuples) > 0)
 		{
 			/*
 			 * Before beginning index vacuuming, we release any pin we may
@@ -577,10 +758,7 @@ lazy_scan_heap(Relation onerel, LVRelStats *vacrelstats,
 			vacuum_log_cleanup_info(onerel, vacrelstats);
 
 			/* Remove index entries */
-			for (i = 0; i < nindexes; i++)
-				lazy_vacuum_index(Irel[i],
-								  &indstats[i],
-								  vacrelstats);
+			lazy_vacuum_all_indexes(Irel, nindexes, indstats, vacrelstats);
 			/* Remove tuples from heap */
 			lazy_vacuum_heap(onerel, vacrelstats);
 
@@ -589,7 +767,7 @@ lazy_scan_heap(Relation onerel, LVRelStats *vacrelstats,
 			 * not to reset latestRemovedXid since we want that value to be
 			 * valid.
 			 */
-			vacrelstats->num_dead_tuples = 0;
+			tidstore_reset(vacrelstats->dead_tuples);
 			vacrelstats->num_index_scans++;
 		}
 
@@ -694,7 +872,7 @@ lazy_scan_heap(Relation onerel, LVRelStats *vacrelstats,
 			empty_pages++;
 			freespace = PageGetHeapFreeSpace(page);
 
-			/* empty pages are always all-visible */
+			/* empty pages are always all-visible and all-frozen */
 			if (!PageIsAllVisible(page))
 			{
 				START_CRIT_SECTION();
@@ -718,7 +896,8 @@ lazy_scan_heap(Relation onerel, LVRelStats *vacrelstats,
 
 				PageSetAllVisible(page);
 				visibilitymap_set(onerel, blkno, buf, InvalidXLogRecPtr,
-								  vmbuffer, InvalidTransactionId);
+								  vmbuffer, InvalidTransactionId,
+					   VISIBILITYMAP_ALL_VISIBLE | VISIBILITYMAP_ALL_FROZEN);
 				END_CRIT_SECTION();
 			}
 
@@ -743,7 +922,7 @@ lazy_scan_heap(Relation onerel, LVRelStats *vacrelstats,
 		has_dead_tuples = false;
 		nfrozen = 0;
 		hastup = false;
-		prev_dead_count = vacrelstats->num_dead_tuples;
+		ndeadoffsets = 0;
 		maxoff = PageGetMaxOffsetNumber(page);
 
 		/*
@@ -782,7 +961,7 @@ lazy_scan_heap(Relation onerel, LVRelStats *vacrelstats,
 			 */
 			if (ItemIdIsDead(itemid))
 			{
-				lazy_record_dead_tuple(vacrelstats, &(tuple.t_self));
+				deadoffsets[ndeadoffsets++] = offnum;
 				all_visible = false;
 				continue;
 			}
@@ -887,7 +1066,7 @@ lazy_scan_heap(Relation onerel, LVRelStats *vacrelstats,
 
 			if (tupgone)
 			{
-				lazy_record_dead_tuple(vacrelstats, &(tuple.t_self));
+				deadoffsets[ndeadoffsets++] = offnum;
 				HeapTupleHeaderAdvanceLatestRemovedXid(tuple.t_data,
 											 &vacrelstats->latestRemovedXid);
 				tups_vacuumed += 1;
@@ -895,6 +1074,8 @@ lazy_scan_heap(Relation onerel, LVRelStats *vacrelstats,
 			}
 			else
 			{
+				bool		tuple_totally_frozen;
+
 				num_tuples += 1;
 				hastup = true;
 
@@ -903,8 +1084,12 @@ lazy_scan_heap(Relation onerel, LVRelStats *vacrelstats,
 				 * freezing.  Note we already have exclusive buffer lock.
 				 */
 				if (heap_prepare_freeze_tuple(tuple.t_data, FreezeLimit,
-										  MultiXactCutoff, &frozen[nfrozen]))
+										  MultiXactCutoff, &frozen[nfrozen],
+											  &tuple_totally_frozen))
 					frozen[nfrozen++].offset = offnum;
+
+				if (!tuple_totally_frozen)
+					all_frozen = false;
 			}
 		}						/* scan along page */
 
@@ -946,29 +1131,31 @@ lazy_scan_heap(Relation onerel, LVRelStats *vacrelstats,
 
 		/*
 		 * If there are no indexes then we can vacuum the page right now
-		 * instead of doing a second scan.
+		 * instead of doing a second scan.  Otherwise, remember the page's
+		 * dead tuples for the index and second heap passes.
 		 */
-		if (nindexes == 0 &&
-			vacrelstats->num_dead_tuples > 0)
+		if (nindexes == 0 && ndeadoffsets > 0)
 		{
 			/* Remove tuples from heap */
-			lazy_vacuum_page(onerel, blkno, buf, 0, vacrelstats, &vmbuffer);
+			lazy_vacuum_page(onerel, blkno, buf, deadoffsets, ndeadoffsets,
+							 vacrelstats, &vmbuffer);
 			has_dead_tuples = false;
-
-			/*
-			 * Forget the now-vacuumed tuples, and press on, but be careful
-			 * not to reset latestRemovedXid since we want that value to be
-			 * valid.
-			 */
-			vacrelstats->num_dead_tuples = 0;
 			vacuumed_pages++;
 		}
+		else if (ndeadoffsets > 0)
+			tidstore_set_block_offsets(vacrelstats->dead_tuples, blkno,
+									   deadoffsets, ndeadoffsets);
 
 		freespace = PageGetHeapFreeSpace(page);
 
 		/* mark page all-visible, if appropriate */
 		if (all_visible && !all_visible_according_to_vm)
 		{
+			uint8		flags = VISIBILITYMAP_ALL_VISIBLE;
+
+			if (all_frozen)
+				flags |= VISIBILITYMAP_ALL_FROZEN;
+
 			/*
 			 * It should never be the case that the visibility map page is set
 			 * while the page-level bit is clear, but the reverse is allowed
@@ -985,7 +1172,7 @@ lazy_scan_heap(Relation onerel, LVRelStats *vacrelstats,
 			PageSetAllVisible(page);
 			MarkBufferDirty(buf);
 			visibilitymap_set(onerel, blkno, buf, InvalidXLogRecPtr,
-							  vmbuffer, visibility_cutoff_xid);
+							  vmbuffer, visibility_cutoff_xid, flags);
 		}
 
 		/*
@@ -996,11 +1183,12 @@ lazy_scan_heap(Relation onerel, LVRelStats *vacrelstats,
 		 * that something bad has happened.
 		 */
 		else if (all_visible_according_to_vm && !PageIsAllVisible(page)
-				 && visibilitymap_test(onerel, blkno, &vmbuffer))
+				 && VM_ALL_VISIBLE(onerel, blkno, &vmbuffer))
 		{
 			elog(WARNING, "page is not marked all-visible but visibility map bit is set in relation \"%s\" page %u",
 				 relname, blkno);
-			visibilitymap_clear(onerel, blkno, vmbuffer);
+			visibilitymap_clear(onerel, blkno, vmbuffer,
+								VISIBILITYMAP_VALID_BITS);
 		}
 
 		/*
@@ -1022,7 +1210,26 @@ lazy_scan_heap(Relation onerel, LVRelStats *vacrelstats,
 				 relname, blkno);
 			PageClearAllVisible(page);
 			MarkBufferDirty(buf);
-			visibilitymap_clear(onerel, blkno, vmbuffer);
+			visibilitymap_clear(onerel, blkno, vmbuffer,
+								VISIBILITYMAP_VALID_BITS);
+		}
+
+		/*
+		 * If the all-visible page turns out to be all-frozen but not marked
+		 * as such, we should so mark it.  Note that all_frozen is only valid
+		 * if all_visible is true, so we must check both.
+		 */
+		else if (all_visible_according_to_vm && all_visible && all_frozen &&
+				 !VM_ALL_FROZEN(onerel, blkno, &vmbuffer))
+		{
+			/*
+			 * We can pass InvalidTransactionId as the cutoff XID here,
+			 * because setting the all-frozen bit doesn't cause recovery
+			 * conflicts.
+			 */
+			visibilitymap_set(onerel, blkno, buf, InvalidXLogRecPtr,
+							  vmbuffer, InvalidTransactionId,
+							  VISIBILITYMAP_ALL_FROZEN);
 		}
 
 		UnlockReleaseBuffer(buf);
@@ -1038,7 +1245,7 @@ lazy_scan_heap(Relation onerel, LVRelStats *vacrelstats,
 		 * page, so remember its free space as-is.	(This path will always be
 		 * taken if there are no indexes.)
 		 */
-		if (vacrelstats->num_dead_tuples == prev_dead_count)
+		if (nindexes == 0 || ndeadoffsets == 0)
 			RecordPageWithFreeSpace(onerel, blkno, freespace);
 	}
 
@@ -1066,24 +1273,24 @@ lazy_scan_heap(Relation onerel, LVRelStats *vacrelstats,
 
 	/* If any tuples need to be deleted, perform final vacuum cycle */
 	/* XXX put a threshold on min number of tuples here? */
-	if (vacrelstats->num_dead_tuples > 0)
+	if (tidstore_num_tids(vacrelstats->dead_tuples) > 0)
 	{
 		/* Log cleanup info before we touch indexes */
 		vacuum_log_cleanup_info(onerel, vacrelstats);
 
 		/* Remove index entries */
-		for (i = 0; i < nindexes; i++)
-			lazy_vacuum_index(Irel[i],
-							  &indstats[i],
-							  vacrelstats);
+		lazy_vacuum_all_indexes(Irel, nindexes, indstats, vacrelstats);
 		/* Remove tuples from heap */
 		lazy_vacuum_heap(onerel, vacrelstats);
 		vacrelstats->num_index_scans++;
 	}
 
 	/* Do post-vacuum cleanup and statistics update for each index */
-	for (i = 0; i < nindexes; i++)
-		lazy_cleanup_index(Irel[i], indstats[i], vacrelstats);
+	lazy_cleanup_all_indexes(Irel, nindexes, indstats, vacrelstats);
+
+	/* Done with parallel index vacuuming, if any */
+	if (vacrelstats->lps != NULL)
+		end_parallel_vacuum(vacrelstats);
 
 	/* If no indexes, make log report that lazy_vacuum_heap would've made */
 	if (vacuumed_pages)
@@ -1122,35 +1329,42 @@ lazy_scan_heap(Relation onerel, LVRelStats *vacrelstats,
 static void
 lazy_vacuum_heap(Relation onerel, LVRelStats *vacrelstats)
 {
-	int			tupindex;
+	TidStoreIter iter;
+	double		ntuples;
 	int			npages;
 	PGRUsage	ru0;
 	Buffer		vmbuffer = InvalidBuffer;
 
 	pg_rusage_init(&ru0);
+	ntuples = 0;
 	npages = 0;
 
-	tupindex = 0;
-	while (tupindex < vacrelstats->num_dead_tuples)
+	tidstore_begin_iterate(vacrelstats->dead_tuples, &iter);
+	while (tidstore_iterate_next(&iter))
 	{
-		BlockNumber tblk;
+		BlockNumber tblk = iter.blkno;
 		Buffer		buf;
 		Page		page;
 		Size		freespace;
 
 		vacuum_delay_point();
 
-		tblk = ItemPointerGetBlockNumber(&vacrelstats->dead_tuples[tupindex]);
 		buf = ReadBufferExtended(onerel, MAIN_FORKNUM, tblk, RBM_NORMAL,
 								 vac_strategy);
+
+		/*
+		 * If we can't get a cleanup lock, leave the page alone.  Its dead
+		 * tuples no longer have index entries, and will be cleaned up by
+		 * pruning or by the next vacuum.
+		 */
 		if (!ConditionalLockBufferForCleanup(buf))
 		{
 			ReleaseBuffer(buf);
-			++tupindex;
 			continue;
 		}
-		tupindex = lazy_vacuum_page(onerel, tblk, buf, tupindex, vacrelstats,
-									&vmbuffer);
+		lazy_vacuum_page(onerel, tblk, buf, iter.offsets, iter.num_offsets,
+						 vacrelstats, &vmbuffer);
+		ntuples += iter.num_offsets;
 
 		/* Now that we've compacted the page, record its available space */
 		page = BufferGetPage(buf);
@@ -1168,9 +1382,9 @@ lazy_vacuum_heap(Relation onerel, LVRelStats *vacrelstats)
 	}
 
 	ereport(elevel,
-			(errmsg("\"%s\": removed %d row versions in %d pages",
+			(errmsg("\"%s\": removed %.0f row versions in %d pages",
 					RelationGetRelationName(onerel),
-					tupindex, npages),
+					ntuples, npages),
 			 errdetail("%s.",
 					   pg_rusage_show(&ru0))));
 }
@@ -1181,34 +1395,26 @@ lazy_vacuum_heap(Relation onerel, LVRelStats *vacrelstats)
  *
  * Caller must hold pin and buffer cleanup lock on the buffer.
  *
- * tupindex is the index in vacrelstats->dead_tuples of the first dead
- * tuple for this page.  We assume the rest follow sequentially.
- * The return value is the first tupindex after the tuples of this page.
+ * deadoffsets[] holds the ndeadoffsets offsets of the page's dead tuples.
  */
-static int
+static void
 lazy_vacuum_page(Relation onerel, BlockNumber blkno, Buffer buffer,
-				 int tupindex, LVRelStats *vacrelstats, Buffer *vmbuffer)
+				 OffsetNumber *deadoffsets, int ndeadoffsets,
+				 LVRelStats *vacrelstats, Buffer *vmbuffer)
 {
 	Page		page = BufferGetPage(buffer);
-	OffsetNumber unused[MaxOffsetNumber];
-	int			uncnt = 0;
 	TransactionId visibility_cutoff_xid;
+	bool		all_frozen;
+	int			i;
 
 	START_CRIT_SECTION();
 
-	for (; tupindex < vacrelstats->num_dead_tuples; tupindex++)
+	for (i = 0; i < ndeadoffsets; i++)
 	{
-		BlockNumber tblk;
-		OffsetNumber toff;
 		ItemId		itemid;
 
-		tblk = ItemPointerGetBlockNumber(&vacrelstats->dead_tuples[tupindex]);
-		if (tblk != blkno)
-			break;				/* past end of tuples for this block */
-		toff = ItemPointerGetOffsetNumber(&vacrelstats->dead_tuples[tupindex]);
-		itemid = PageGetItemId(page, toff);
+		itemid = PageGetItemId(page, deadoffsets[i]);
 		ItemIdSetUnused(itemid);
-		unused[uncnt++] = toff;
 	}
 
 	PageRepairFragmentation(page);
@@ -1225,27 +1431,37 @@ lazy_vacuum_page(Relation onerel, BlockNumber blkno, Buffer buffer,
 
 		recptr = log_heap_clean(onerel, buffer,
 								NULL, 0, NULL, 0,
-								unused, uncnt,
+								deadoffsets, ndeadoffsets,
 								vacrelstats->latestRemovedXid);
 		PageSetLSN(page, recptr);
 	}
 
 	/*
 	 * Now that we have removed the dead tuples from the page, once again
-	 * check if the page has become all-visible.
+	 * check if the page has become all-visible, and perhaps all-frozen.
 	 */
-	if (!visibilitymap_test(onerel, blkno, vmbuffer) &&
-		heap_page_is_all_visible(onerel, buffer, &visibility_cutoff_xid))
+	if (heap_page_is_all_visible(onerel, buffer, &visibility_cutoff_xid,
+								 &all_frozen))
 	{
-		Assert(BufferIsValid(*vmbuffer));
-		PageSetAllVisible(page);
-		visibilitymap_set(onerel, blkno, buffer, InvalidXLogRecPtr, *vmbuffer,
-						  visibility_cutoff_xid);
+		uint8		vm_status = visibilitymap_get_status(onerel, blkno,
+														 vmbuffer);
+		uint8		flags = 0;
+
+		if ((vm_status & VISIBILITYMAP_ALL_VISIBLE) == 0)
+			flags |= VISIBILITYMAP_ALL_VISIBLE;
+		if ((vm_status & VISIBILITYMAP_ALL_FROZEN) == 0 && all_frozen)
+			flags |= VISIBILITYMAP_ALL_FROZEN;
+
+		if (flags != 0)
+		{
+			Assert(BufferIsValid(*vmbuffer));
+			PageSetAllVisible(page);
+			visibilitymap_set(onerel, blkno, buffer, InvalidXLogRecPtr,
+							  *vmbuffer, visibility_cutoff_xid, flags);
+		}
 	}
 
 	END_CRIT_SECTION();
-
-	return tupindex;
 }
 
 /*
@@ -1296,7 +1512,7 @@ lazy_check_needs_freeze(Buffer buf)
 /*
  *	lazy_vacuum_index() -- vacuum one index relation.
  *
- *		Delete all the index entries pointing to tuples listed in
+ *		Delete all the index entries pointing to tuples in
  *		vacrelstats->dead_tuples, and update running statistics.
  */
 static void
@@ -1318,12 +1534,13 @@ lazy_vacuum_index(Relation indrel,
 
 	/* Do bulk deletion */
 	*stats = index_bulk_delete(&ivinfo, *stats,
-							   lazy_tid_reaped, (void *) vacrelstats);
+							   lazy_tid_reaped,
+							   (void *) vacrelstats->dead_tuples);
 
 	ereport(elevel,
-			(errmsg("scanned index \"%s\" to remove %d row versions",
+			(errmsg("scanned index \"%s\" to remove %.0f row versions",
 					RelationGetRelationName(indrel),
-					vacrelstats->num_dead_tuples),
+					(double) tidstore_num_tids(vacrelstats->dead_tuples)),
 			 errdetail("%s.", pg_rusage_show(&ru0))));
 }
 
@@ -1352,9 +1569,24 @@ lazy_cleanup_index(Relation indrel,
 	if (!stats)
 		return;
 
+	lazy_report_index_cleanup(indrel, stats, &ru0);
+
+	pfree(stats);
+}
+
+/*
+ *	lazy_report_index_cleanup() -- record and report one index's final stats.
+ *
+ *		Shared by the serial and parallel cleanup paths; in the latter, the
+ *		index AM ran in a worker but pg_class is always updated by the leader.
+ */
+static void
+lazy_report_index_cleanup(Relation indrel, IndexBulkDeleteResult *stats,
+						  PGRUsage *ru0)
+{
 	/*
-	 * Now update statistics in pg_class, but only if the index says the count
-	 * is accurate.
+	 * Update statistics in pg_class, but only if the index says the count is
+	 * accurate.
 	 */
 	if (!stats->estimated_count)
 		vac_update_relstats(indrel,
@@ -1375,9 +1607,509 @@ lazy_cleanup_index(Relation indrel,
 					   "%s.",
 					   stats->tuples_removed,
 					   stats->pages_deleted, stats->pages_free,
-					   pg_rusage_show(&ru0))));
+					   pg_rusage_show(ru0))));
+}
 
-	pfree(stats);
+/*
+ *	lazy_vacuum_all_indexes() -- remove dead_tuples from every index.
+ */
+static void
+lazy_vacuum_all_indexes(Relation *Irel, int nindexes,
+						IndexBulkDeleteResult **indstats,
+						LVRelStats *vacrelstats)
+{
+	int			i;
+
+	if (vacrelstats->lps != NULL)
+	{
+		lazy_parallel_vacuum_indexes(Irel, nindexes, indstats, vacrelstats,
+									 LV_PHASE_BULKDELETE);
+		return;
+	}
+
+	for (i = 0; i < nindexes; i++)
+		lazy_vacuum_index(Irel[i], &indstats[i], vacrelstats);
+}
+
+/*
+ *	lazy_cleanup_all_indexes() -- do post-vacuum cleanup for every index.
+ */
+static void
+lazy_cleanup_all_indexes(Relation *Irel, int nindexes,
+						 IndexBulkDeleteResult **indstats,
+						 LVRelStats *vacrelstats)
+{
+	int			i;
+
+	if (vacrelstats->lps != NULL)
+	{
+		lazy_parallel_vacuum_indexes(Irel, nindexes, indstats, vacrelstats,
+									 LV_PHASE_CLEANUP);
+		return;
+	}
+
+	for (i = 0; i < nindexes; i++)
+		lazy_cleanup_index(Irel[i], indstats[i], vacrelstats);
+}
+
+/*
+ *	begin_parallel_vacuum() -- set up for parallel index vacuuming.
+ *
+ *		Creates the dynamic shared memory segment holding the shared state and
+ *		the dead tuple TID store, and points vacrelstats->dead_tuples at the
+ *		latter.  Returns NULL, leaving the caller to vacuum the indexes
+ *		itself, if dynamic shared memory is not available.
+ *
+ *		Workers are launched separately for each index pass, so that a pass
+ *		never waits for workers to start up before the leader can begin on
+ *		the indexes, and no worker sits idle while the heap is being scanned.
+ */
+static LVParallelState *
+begin_parallel_vacuum(LVRelStats *vacrelstats, Relation *Irel, int nindexes,
+					  BlockNumber relblocks)
+{
+	LVParallelState *lps;
+	LVShared   *lvshared;
+	void	   *dead_tuples_area;
+	shm_toc_estimator e;
+	shm_toc    *toc;
+	dsm_segment *seg;
+	Size		shared_size;
+	Size		dead_tuples_size;
+	Size		segsize;
+	char	   *dbname;
+	int			i;
+
+	if (!IsUnderPostmaster || dynamic_shared_memory_type == DSM_IMPL_NONE)
+		return NULL;
+
+	shared_size = add_size(offsetof(LVShared, indstats),
+						   mul_size(sizeof(LVSharedIndStats), nindexes));
+	dead_tuples_size = lazy_dead_tuples_space(vacrelstats, relblocks);
+
+	shm_toc_initialize_estimator(&e);
+	shm_toc_estimate_chunk(&e, shared_size);
+	shm_toc_estimate_chunk(&e, dead_tuples_size);
+	shm_toc_estimate_keys(&e, 2);
+	segsize = shm_toc_estimate(&e);
+
+	seg = dsm_create(segsize);
+	toc = shm_toc_create(PARALLEL_VACUUM_MAGIC, dsm_segment_address(seg),
+						 segsize);
+
+	lvshared = shm_toc_allocate(toc, shared_size);
+	MemSet(lvshared, 0, shared_size);
+	SpinLockInit(&lvshared->mutex);
+	dbname = get_database_name(MyDatabaseId);
+	if (dbname == NULL)
+		elog(ERROR, "cache lookup failed for database %u", MyDatabaseId);
+	strlcpy(lvshared->dbname, dbname, NAMEDATALEN);
+	lvshared->elevel = elevel;
+	lvshared->cost_delay = VacuumCostDelay;
+	lvshared->cost_limit = VacuumCostLimit;
+	lvshared->cost_page_hit = VacuumCostPageHit;
+	lvshared->cost_page_miss = VacuumCostPageMiss;
+	lvshared->cost_page_dirty = VacuumCostPageDirty;
+	lvshared->nindexes = nindexes;
+	for (i = 0; i < nindexes; i++)
+		lvshared->indstats[i].indexoid = RelationGetRelid(Irel[i]);
+	shm_toc_insert(toc, PARALLEL_VACUUM_KEY_SHARED, lvshared);
+
+	dead_tuples_area = shm_toc_allocate(toc, dead_tuples_size);
+	shm_toc_insert(toc, PARALLEL_VACUUM_KEY_DEAD_TUPLES, dead_tuples_area);
+
+	vacrelstats->dead_tuples = tidstore_initialize(dead_tuples_area,
+												   dead_tuples_size,
+												   MaxHeapTuplesPerPage);
+
+	lps = (LVParallelState *) palloc0(sizeof(LVParallelState));
+	lps->seg = seg;
+	lps->lvshared = lvshared;
+	lps->nworkers = Min(vacrelstats->parallel_workers, nindexes - 1);
+	lps->nlaunched = 0;
+	lps->handles = (BackgroundWorkerHandle **)
+		palloc0(lps->nworkers * sizeof(BackgroundWorkerHandle *));
+
+	/* If we error out, make sure no worker outlives the segment's owner */
+	on_dsm_detach(seg, lazy_parallel_terminate_workers, PointerGetDatum(lps));
+
+	return lps;
+}
+
+/*
+ *	end_parallel_vacuum() -- release the parallel index vacuuming resources.
+ *
+ *		All workers must already have exited.
+ */
+static void
+end_parallel_vacuum(LVRelStats *vacrelstats)
+{
+	LVParallelState *lps = vacrelstats->lps;
+
+	Assert(lps->nlaunched == 0);
+
+	cancel_on_dsm_detach(lps->seg, lazy_parallel_terminate_workers,
+						 PointerGetDatum(lps));
+	dsm_detach(lps->seg);
+
+	/* The dead tuple store went away with the segment */
+	tidstore_free(vacrelstats->dead_tuples);
+	vacrelstats->dead_tuples = NULL;
+
+	pfree(lps->handles);
+	pfree(lps);
+	vacrelstats->lps = NULL;
+}
+
+/*
+ *	lazy_parallel_vacuum_indexes() -- perform one index pass in parallel.
+ *
+ *		The leader launches the workers, takes its own share of the indexes,
+ *		waits for the workers to exit, and then processes any index a worker
+ *		didn't finish (because it failed, or couldn't lock the index).  Both
+ *		ambulkdelete and amvacuumcleanup can safely be repeated on an index,
+ *		so that's always correct.  The statistics are then copied back into
+ *		indstats[] and reported as in the serial case.
+ */
+static void
+lazy_parallel_vacuum_indexes(Relation *Irel, int nindexes,
+							 IndexBulkDeleteResult **indstats,
+							 LVRelStats *vacrelstats,
+							 LVParallelPhase phase)
+{
+	LVParallelState *lps = vacrelstats->lps;
+	LVShared   *lvshared = lps->lvshared;
+	PGRUsage	ru0;
+	int			i;
+
+	pg_rusage_init(&ru0);
+
+	/* Set up the shared state for this pass */
+	lvshared->phase = phase;
+	lvshared->nextidx = 0;
+	if (phase == LV_PHASE_BULKDELETE)
+	{
+		lvshared->estimated_count = true;
+		lvshared->num_heap_tuples = vacrelstats->old_rel_tuples;
+	}
+	else
+	{
+		lvshared->estimated_count =
+			(vacrelstats->scanned_pages < vacrelstats->rel_pages);
+		lvshared->num_heap_tuples = vacrelstats->new_rel_tuples;
+	}
+	for (i = 0; i < nindexes; i++)
+	{
+		LVSharedIndStats *slot = &lvshared->indstats[i];
+
+		slot->done = false;
+		slot->valid = (indstats[i] != NULL);
+		if (slot->valid)
+			memcpy(&slot->stats, indstats[i], sizeof(IndexBulkDeleteResult));
+	}
+
+	lazy_launch_parallel_workers(lps, nindexes);
+	if (phase == LV_PHASE_BULKDELETE)
+		ereport(elevel,
+				(errmsg("launched %d parallel vacuum workers for index vacuuming (planned: %d)",
+						lps->nlaunched, lps->nworkers)));
+	else
+		ereport(elevel,
+				(errmsg("launched %d parallel vacuum workers for index cleanup (planned: %d)",
+						lps->nlaunched, lps->nworkers)));
+
+	/* Take our share of the indexes, then wait for the workers to finish */
+	lazy_parallel_process_indexes(Irel, lvshared, vacrelstats->dead_tuples);
+	lazy_wait_for_parallel_workers(lps);
+
+	for (i = 0; i < nindexes; i++)
+	{
+		LVSharedIndStats *slot = &lvshared->indstats[i];
+
+		if (!slot->done)
+			lazy_parallel_vacuum_one_index(Irel[i], lvshared, i,
+										   vacrelstats->dead_tuples);
+
+		if (slot->valid)
+		{
+			if (indstats[i] == NULL)
+				indstats[i] = (IndexBulkDeleteResult *)
+					palloc(sizeof(IndexBulkDeleteResult));
+			memcpy(indstats[i], &slot->stats, sizeof(IndexBulkDeleteResult));
+		}
+		else if (indstats[i] != NULL)
+		{
+			pfree(indstats[i]);
+			indstats[i] = NULL;
+		}
+
+		if (phase == LV_PHASE_BULKDELETE)
+			ereport(elevel,
+					(errmsg("scanned index \"%s\" to remove %.0f row versions",
+							RelationGetRelationName(Irel[i]),
+							(double) tidstore_num_tids(vacrelstats->dead_tuples)),
+					 errdetail("%s.", pg_rusage_show(&ru0))));
+		else if (indstats[i] != NULL)
+		{
+			lazy_report_index_cleanup(Irel[i], indstats[i], &ru0);
+			pfree(indstats[i]);
+			indstats[i] = NULL;
+		}
+	}
+}
+
+/*
+ *	lazy_parallel_process_indexes() -- claim and process indexes until none
+ *		are left in the current pass.
+ *
+ *		The leader passes its array of open indexes; a worker passes NULL and
+ *		opens each index it claims by OID.  A worker only takes a conditional
+ *		lock: the leader already holds RowExclusiveLock, so this normally
+ *		succeeds, but if somebody is queued for a conflicting lock behind the
+ *		leader, waiting here would be an undetectable deadlock because the
+ *		leader in turn waits for us.  In that case we just leave the index for
+ *		the leader, which will find it not done.
+ */
+static void
+lazy_parallel_process_indexes(Relation *Irel, LVShared *lvshared,
+							  TidStore *dead_tuples)
+{
+	for (;;)
+	{
+		Relation	indrel;
+		Oid			indexoid;
+		int			idx;
+
+		CHECK_FOR_INTERRUPTS();
+
+		SpinLockAcquire(&lvshared->mutex);
+		idx = lvshared->nextidx++;
+		SpinLockRelease(&lvshared->mutex);
+
+		if (idx >= lvshared->nindexes)
+			break;
+
+		if (Irel != NULL)
+		{
+			lazy_parallel_vacuum_one_index(Irel[idx], lvshared, idx,
+										   dead_tuples);
+			continue;
+		}
+
+		indexoid = lvshared->indstats[idx].indexoid;
+		if (!ConditionalLockRelationOid(indexoid, RowExclusiveLock))
+			continue;
+		indrel = index_open(indexoid, NoLock);
+
+		lazy_parallel_vacuum_one_index(indrel, lvshared, idx, dead_tuples);
+
+		index_close(indrel, NoLock);
+	}
+}
+
+/*
+ *	lazy_parallel_vacuum_one_index() -- run the current pass on one index.
+ *
+ *		The index's running statistics are taken from, and returned to, its
+ *		shared slot.
+ */
+static void
+lazy_parallel_vacuum_one_index(Relation indrel, LVShared *lvshared, int idx,
+							   TidStore *dead_tuples)
+{
+	LVSharedIndStats *slot = &lvshared->indstats[idx];
+	IndexVacuumInfo ivinfo;
+	IndexBulkDeleteResult *stats = NULL;
+
+	if (slot->valid)
+	{
+		stats = (IndexBulkDeleteResult *) palloc(sizeof(IndexBulkDeleteResult));
+		memcpy(stats, &slot->stats, sizeof(IndexBulkDeleteResult));
+	}
+
+	ivinfo.index = indrel;
+	ivinfo.analyze_only = false;
+	ivinfo.estimated_count = lvshared->estimated_count;
+	ivinfo.message_level = elevel;
+	ivinfo.num_heap_tuples = lvshared->num_heap_tuples;
+	ivinfo.strategy = vac_strategy;
+
+	if (lvshared->phase == LV_PHASE_BULKDELETE)
+		stats = index_bulk_delete(&ivinfo, stats,
+								  lazy_tid_reaped, (void *) dead_tuples);
+	else
+		stats = index_vacuum_cleanup(&ivinfo, stats);
+
+	slot->valid = (stats != NULL);
+	if (stats != NULL)
+	{
+		memcpy(&slot->stats, stats, sizeof(IndexBulkDeleteResult));
+		pfree(stats);
+	}
+
+	SpinLockAcquire(&lvshared->mutex);
+	slot->done = true;
+	SpinLockRelease(&lvshared->mutex);
+}
+
+/*
+ *	lazy_launch_parallel_workers() -- register the workers for one pass.
+ *
+ *		There's no point in launching more workers than there are indexes
+ *		beyond the one the leader will take.  If we can't get as many
+ *		background worker slots as we'd like, we just make do with fewer,
+ *		possibly none.
+ */
+static void
+lazy_launch_parallel_workers(LVParallelState *lps, int nindexes)
+{
+	BackgroundWorker worker;
+	int			i;
+
+	Assert(lps->nlaunched == 0);
+
+	memset(&worker, 0, sizeof(worker));
+	worker.bgw_flags = BGWORKER_SHMEM_ACCESS |
+		BGWORKER_BACKEND_DATABASE_CONNECTION;
+	worker.bgw_start_time = BgWorkerStart_ConsistentState;
+	worker.bgw_restart_time = BGW_NEVER_RESTART;
+	worker.bgw_main = NULL;
+	snprintf(worker.bgw_library_name, BGW_MAXLEN, "postgres");
+	snprintf(worker.bgw_function_name, BGW_MAXLEN, "lazy_parallel_vacuum_main");
+	snprintf(worker.bgw_name, BGW_MAXLEN,
+			 "parallel vacuum worker for PID %d", MyProcPid);
+	worker.bgw_main_arg = UInt32GetDatum(dsm_segment_handle(lps->seg));
+	/* set bgw_notify_pid so that we're woken up when the worker stops */
+	worker.bgw_notify_pid = MyProcPid;
+
+	for (i = 0; i < Min(lps->nworkers, nindexes - 1); i++)
+	{
+		if (!RegisterDynamicBackgroundWorker(&worker, &lps->handles[i]))
+			break;
+		lps->nlaunched++;
+	}
+}
+
+/*
+ *	lazy_wait_for_parallel_workers() -- wait until every worker launched for
+ *		the current pass has exited.
+ */
+static void
+lazy_wait_for_parallel_workers(LVParallelState *lps)
+{
+	int			i;
+
+	for (i = 0; i < lps->nlaunched; i++)
+	{
+		for (;;)
+		{
+			BgwHandleStatus status;
+			pid_t		pid;
+
+			status = GetBackgroundWorkerPid(lps->handles[i], &pid);
+			if (status == BGWH_STOPPED || status == BGWH_POSTMASTER_DIED)
+				break;
+
+			WaitLatch(&MyProc->procLatch, WL_LATCH_SET | WL_POSTMASTER_DEATH, 0);
+			ResetLatch(&MyProc->procLatch);
+			CHECK_FOR_INTERRUPTS();
+		}
+
+		pfree(lps->handles[i]);
+		lps->handles[i] = NULL;
+	}
+
+	lps->nlaunched = 0;
+}
+
+/*
+ *	lazy_parallel_terminate_workers() -- on_dsm_detach callback that stops
+ *		any workers still running when the leader releases the segment on
+ *		error.
+ */
+static void
+lazy_parallel_terminate_workers(dsm_segment *seg, Datum arg)
+{
+	LVParallelState *lps = (LVParallelState *) DatumGetPointer(arg);
+	int			i;
+
+	for (i = 0; i < lps->nlaunched; i++)
+		TerminateBackgroundWorker(lps->handles[i]);
+	lps->nlaunched = 0;
+}
+
+/*
+ * lazy_parallel_vacuum_main - main entrypoint for a parallel vacuum worker
+ *
+ * main_arg is the handle of the leader's dynamic shared memory segment.  We
+ * connect to the leader's database, process indexes until there are none
+ * left in the current pass, and exit.  The leader is responsible for
+ * reporting the results, and for any index we don't finish.
+ *
+ * Each worker applies the leader's cost-based delay settings to its own I/O,
+ * so the total I/O rate of a parallel vacuum can be up to the number of
+ * participating processes times that of a serial one.
+ */
+void
+lazy_parallel_vacuum_main(Datum main_arg)
+{
+	dsm_segment *seg;
+	shm_toc    *toc;
+	LVShared   *lvshared;
+	TidStore   *dead_tuples;
+
+	/* Let the leader's TerminateBackgroundWorker() cancel us */
+	pqsignal(SIGTERM, die);
+	BackgroundWorkerUnblockSignals();
+
+	/* We need a resource owner before we can attach to the segment */
+	CurrentResourceOwner = ResourceOwnerCreate(NULL, "parallel vacuum worker");
+	seg = dsm_attach(DatumGetUInt32(main_arg));
+	if (seg == NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+				 errmsg("could not map dynamic shared memory segment")));
+	toc = shm_toc_attach(PARALLEL_VACUUM_MAGIC, dsm_segment_address(seg));
+	if (toc == NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+				 errmsg("invalid magic number in dynamic shared memory segment")));
+	lvshared = shm_toc_lookup(toc, PARALLEL_VACUUM_KEY_SHARED);
+	dead_tuples = tidstore_attach(shm_toc_lookup(toc,
+									PARALLEL_VACUUM_KEY_DEAD_TUPLES));
+
+	BackgroundWorkerInitializeConnection(lvshared->dbname, NULL);
+
+	elevel = lvshared->elevel;
+	vac_strategy = GetAccessStrategy(BAS_VACUUM);
+
+	VacuumCostDelay = lvshared->cost_delay;
+	VacuumCostLimit = lvshared->cost_limit;
+	VacuumCostPageHit = lvshared->cost_page_hit;
+	VacuumCostPageMiss = lvshared->cost_page_miss;
+	VacuumCostPageDirty = lvshared->cost_page_dirty;
+	VacuumCostActive = (VacuumCostDelay > 0);
+	VacuumCostBalance = 0;
+
+	StartTransactionCommand();
+
+	/* Functions in indexes may want a snapshot set, as in vacuum_rel() */
+	PushActiveSnapshot(GetTransactionSnapshot());
+
+	/*
+	 * Like the leader, we don't need other VACUUMs to wait for us while they
+	 * determine OldestXmin; see vacuum_rel().
+	 */
+	LWLockAcquire(ProcArrayLock, LW_EXCLUSIVE);
+	MyPgXact->vacuumFlags |= PROC_IN_VACUUM;
+	LWLockRelease(ProcArrayLock);
+
+	lazy_parallel_process_indexes(NULL, lvshared, dead_tuples);
+
+	PopActiveSnapshot();
+	CommitTransactionCommand();
+
+	dsm_detach(seg);
 }
 
 /*
@@ -1621,120 +2353,73 @@ count_nondeletable_pages(Relation onerel, LVRelStats *vacrelstats)
 }
 
 /*
- * lazy_space_alloc - space allocation decisions for lazy vacuum
+ * lazy_dead_tuples_space - size of the TID store for dead tuples
  *
  * See the comments at the head of this file for rationale.
  */
-static void
-lazy_space_alloc(LVRelStats *vacrelstats, BlockNumber relblocks)
+static Size
+lazy_dead_tuples_space(LVRelStats *vacrelstats, BlockNumber relblocks)
 {
-	long		maxtuples;
+	Size		space;
+	Size		block_space = tidstore_block_space(MaxHeapTuplesPerPage);
 	int			vac_work_mem =  IsAutoVacuumWorkerProcess() &&
 									autovacuum_work_mem != -1 ?
 								autovacuum_work_mem : maintenance_work_mem;
 
 	if (vacrelstats->hasindex)
 	{
-		maxtuples = (vac_work_mem * 1024L) / sizeof(ItemPointerData);
-		maxtuples = Min(maxtuples, INT_MAX);
-		maxtuples = Min(maxtuples, MaxAllocSize / sizeof(ItemPointerData));
+		space = (Size) vac_work_mem * 1024;
+		space = Min(space, TIDSTORE_MAX_SIZE);
+		space = Min(space, MaxAllocHugeSize);
 
 		/* curious coding here to ensure the multiplication can't overflow */
-		if ((BlockNumber) (maxtuples / LAZY_ALLOC_TUPLES) > relblocks)
-			maxtuples = relblocks * LAZY_ALLOC_TUPLES;
+		if ((BlockNumber) (space / block_space) > relblocks)
+			space = tidstore_space_for_blocks(relblocks, MaxHeapTuplesPerPage);
 
 		/* stay sane if small maintenance_work_mem */
-		maxtuples = Max(maxtuples, MaxHeapTuplesPerPage);
+		space = Max(space, tidstore_space_for_blocks(1, MaxHeapTuplesPerPage));
 	}
 	else
 	{
-		maxtuples = MaxHeapTuplesPerPage;
+		space = tidstore_space_for_blocks(1, MaxHeapTuplesPerPage);
 	}
 
-	vacrelstats->num_dead_tuples = 0;
-	vacrelstats->max_dead_tuples = (int) maxtuples;
-	vacrelstats->dead_tuples = (ItemPointer)
-		palloc(maxtuples * sizeof(ItemPointerData));
+	return space;
 }
 
 /*
- * lazy_record_dead_tuple - remember one deletable tuple
+ * lazy_space_alloc - space allocation decisions for lazy vacuum
  */
 static void
-lazy_record_dead_tuple(LVRelStats *vacrelstats,
-					   ItemPointer itemptr)
+lazy_space_alloc(LVRelStats *vacrelstats, BlockNumber relblocks)
 {
-	/*
-	 * The array shouldn't overflow under normal behavior, but perhaps it
-	 * could if we are given a really small maintenance_work_mem. In that
-	 * case, just forget the last few tuples (we'll get 'em next time).
-	 */
-	if (vacrelstats->num_dead_tuples < vacrelstats->max_dead_tuples)
-	{
-		vacrelstats->dead_tuples[vacrelstats->num_dead_tuples] = *itemptr;
-		vacrelstats->num_dead_tuples++;
-	}
+	vacrelstats->dead_tuples =
+		tidstore_create(lazy_dead_tuples_space(vacrelstats, relblocks),
+						MaxHeapTuplesPerPage);
 }
 
 /*
  *	lazy_tid_reaped() -- is a particular tid deletable?
  *
  *		This has the right signature to be an IndexBulkDeleteCallback.
- *
- *		Assumes dead_tuples array is in sorted order.
+ *		state is the TidStore of dead tuples.
  */
 static bool
 lazy_tid_reaped(ItemPointer itemptr, void *state)
 {
-	LVRelStats *vacrelstats = (LVRelStats *) state;
-	ItemPointer res;
-
-	res = (ItemPointer) bsearch((void *) itemptr,
-								(void *) vacrelstats->dead_tuples,
-								vacrelstats->num_dead_tuples,
-								sizeof(ItemPointerData),
-								vac_cmp_itemptr);
-
-	return (res != NULL);
-}
-
-/*
- * Comparator routines for use with qsort() and bsearch().
- */
-static int
-vac_cmp_itemptr(const void *left, const void *right)
-{
-	BlockNumber lblk,
-				rblk;
-	OffsetNumber loff,
-				roff;
-
-	lblk = ItemPointerGetBlockNumber((ItemPointer) left);
-	rblk = ItemPointerGetBlockNumber((ItemPointer) right);
-
-	if (lblk < rblk)
-		return -1;
-	if (lblk > rblk)
-		return 1;
-
-	loff = ItemPointerGetOffsetNumber((ItemPointer) left);
-	roff = ItemPointerGetOffsetNumber((ItemPointer) right);
-
-	if (loff < roff)
-		return -1;
-	if (loff > roff)
-		return 1;
-
-	return 0;
+	return tidstore_is_member((TidStore *) state, itemptr);
 }
 
 /*
  * Check if every tuple in the given page is visible to all current and future
  * transactions. Also return the visibility_cutoff_xid which is the highest
- * xmin amongst the visible tuples.
+ * xmin amongst the visible tuples, and *all_frozen which is set to true if
+ * the page is all-visible and every tuple on it is also frozen.
  */
 static bool
-heap_page_is_all_visible(Relation rel, Buffer buf, TransactionId *visibility_cutoff_xid)
+heap_page_is_all_visible(Relation rel, Buffer buf,
+						 TransactionId *visibility_cutoff_xid,
+						 bool *all_frozen)
 {
 	Page		page = BufferGetPage(buf);
 	OffsetNumber offnum,
@@ -1742,6 +2427,7 @@ heap_page_is_all_visible(Relation rel, Buffer buf, TransactionId *visibility_cut
 	bool		all_visible = true;
 
 	*visibility_cutoff_xid = InvalidTransactionId;
+	*all_frozen = true;
 
 	/*
 	 * This is a stripped down version of the line pointer scan in
@@ -1806,6 +2492,11 @@ heap_page_is_all_visible(Relation rel, Buffer buf, TransactionId *visibility_cut
 					/* Track newest xmin on page. */
 					if (TransactionIdFollows(xmin, *visibility_cutoff_xid))
 						*visibility_cutoff_xid = xmin;
+
+					/* Check whether this tuple is already frozen or not */
+					if (all_visible && *all_frozen &&
+						heap_tuple_needs_eventual_freeze(tuple.t_data))
+						*all_frozen = false;
 				}
 				break;
 
@@ -1822,5 +2513,9 @@ heap_page_is_all_visible(Relation rel, Buffer buf, TransactionId *visibility_cut
 		}
 	}							/* scan along page */
 
+	/* all_frozen is meaningless unless the page is all-visible */
+	if (!all_visible)
+		*all_frozen = false;
+
 	return all_visible;
 }
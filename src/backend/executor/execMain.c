@@ -42,6 +42,7 @@
 #include "access/transam.h"
 #include "access/xact.h"
 #include "catalog/namespace.h"
+#include "catalog/partition.h"
 #include "commands/matview.h"
 #include "commands/trigger.h"
 #include "executor/execdebug.h"
@@ -1172,6 +1173,10 @@ InitResultRelInfo(ResultRelInfo *resultRelInfo,
 	resultRelInfo->ri_ConstraintExprs = NULL;
 	resultRelInfo->ri_junkFilter = NULL;
 	resultRelInfo->ri_projectReturning = NULL;
+	/* likewise for the partition constraint */
+	resultRelInfo->ri_PartitionCheck =
+		(List *) copyObject(RelationGetPartitionQual(resultRelationDesc));
+	resultRelInfo->ri_PartitionCheckExpr = NIL;
 }
 
 /*
@@ -1631,6 +1636,47 @@ ExecConstraints(ResultRelInfo *resultRelInfo,
 	}
 }
 
+/*
+ * ExecPartitionCheck --- check that tuple satisfies the partition constraint
+ *
+ * Rows routed to a partition through its parent satisfy the constraint by
+ * construction, so this is needed only for rows inserted or updated in the
+ * partition directly.
+ */
+void
+ExecPartitionCheck(ResultRelInfo *resultRelInfo,
+				   TupleTableSlot *slot, EState *estate)
+{
+	Relation	rel = resultRelInfo->ri_RelationDesc;
+	ExprContext *econtext;
+
+	Assert(resultRelInfo->ri_PartitionCheck != NIL);
+
+	/* Prepare the expression tree the first time through */
+	if (resultRelInfo->ri_PartitionCheckExpr == NIL)
+	{
+		MemoryContext oldContext;
+
+		oldContext = MemoryContextSwitchTo(estate->es_query_cxt);
+		resultRelInfo->ri_PartitionCheckExpr = (List *)
+			ExecPrepareExpr((Expr *) resultRelInfo->ri_PartitionCheck, estate);
+		MemoryContextSwitchTo(oldContext);
+	}
+
+	econtext = GetPerTupleExprContext(estate);
+	econtext->ecxt_scantuple = slot;
+
+	if (!ExecQual(resultRelInfo->ri_PartitionCheckExpr, econtext, false))
+		ereport(ERROR,
+				(errcode(ERRCODE_CHECK_VIOLATION),
+				 errmsg("new row for relation \"%s\" violates partition constraint",
+						RelationGetRelationName(rel)),
+				 errdetail("Failing row contains %s.",
+						   ExecBuildSlotValueDescription(slot,
+														 RelationGetDescr(rel),
+														 64))));
+}
+
 /*
  * ExecWithCheckOptions -- check that tuple satisfies any WITH CHECK OPTIONs
  */
@@ -0,0 +1,239 @@
+/*-------------------------------------------------------------------------
+ *
+ * execPartition.c
+ *	  Routing of inserted rows to the partitions of a partitioned table.
+ *
+ * Portions Copyright (c) 1996-2014, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/executor/execPartition.c
+ *
+ * NOTES
+ *	  Rows inserted into a partitioned table by INSERT or COPY FROM are
+ *	  stored in the partition whose bound accepts the key value.  The
+ *	  partition is found by a binary search of the parent's bounds, and is
+ *	  opened for insertion the first time a row is routed to it, so that
+ *	  a statement touching a few partitions of many pays only for those.
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "access/heapam.h"
+#include "catalog/partition.h"
+#include "executor/execPartition.h"
+#include "executor/executor.h"
+#include "utils/lsyscache.h"
+#include "utils/rel.h"
+
+
+/*
+ * ExecSetupPartitionTupleRouting
+ *		Set up routing of rows inserted into the partitioned table described
+ *		by rootinfo.
+ */
+PartitionTupleRouting *
+ExecSetupPartitionTupleRouting(ResultRelInfo *rootinfo, EState *estate)
+{
+	PartitionTupleRouting *proute;
+	PartitionDesc pdesc = RelationGetPartitionDesc(rootinfo->ri_RelationDesc);
+
+	Assert(pdesc != NULL);
+
+	proute = (PartitionTupleRouting *) palloc0(sizeof(PartitionTupleRouting));
+	proute->rootinfo = rootinfo;
+	proute->nparts = pdesc->nparts;
+	if (proute->nparts > 0)
+	{
+		proute->partinfos = (ResultRelInfo **)
+			palloc0(proute->nparts * sizeof(ResultRelInfo *));
+		proute->tomaps = (TupleConversionMap **)
+			palloc0(proute->nparts * sizeof(TupleConversionMap *));
+		proute->frommaps = (TupleConversionMap **)
+			palloc0(proute->nparts * sizeof(TupleConversionMap *));
+		proute->partslots = (TupleTableSlot **)
+			palloc0(proute->nparts * sizeof(TupleTableSlot *));
+	}
+	proute->rootslot = ExecInitExtraTupleSlot(estate);
+	ExecSetSlotDescriptor(proute->rootslot,
+						  RelationGetDescr(rootinfo->ri_RelationDesc));
+
+	return proute;
+}
+
+/*
+ * ExecFindPartition
+ *		Find the partition a row of the partitioned table belongs in.
+ *
+ * slot holds the row, in the partitioned table's row type.  Returns the
+ * partition's index in the table's PartitionDesc; raises an error if no
+ * partition accepts the row.
+ */
+int
+ExecFindPartition(PartitionTupleRouting *proute, TupleTableSlot *slot,
+				  EState *estate)
+{
+	Relation	parent = proute->rootinfo->ri_RelationDesc;
+	PartitionKey key = RelationGetPartitionKey(parent);
+	Datum		value;
+	bool		isnull;
+	int			partidx;
+
+	value = slot_getattr(slot, key->partattnum, &isnull);
+
+	/*
+	 * The parent is locked against adding and dropping partitions, so its
+	 * partitions keep their indexes even if the relcache entry is rebuilt.
+	 */
+	partidx = get_partition_for_value(key, RelationGetPartitionDesc(parent),
+									  value, isnull);
+	if (partidx < 0)
+	{
+		char	   *valstr;
+
+		if (isnull)
+			valstr = pstrdup("null");
+		else
+		{
+			Oid			typoutput;
+			bool		typisvarlena;
+
+			getTypeOutputInfo(key->parttypid, &typoutput, &typisvarlena);
+			valstr = OidOutputFunctionCall(typoutput, value);
+		}
+
+		ereport(ERROR,
+				(errcode(ERRCODE_CHECK_VIOLATION),
+				 errmsg("no partition of relation \"%s\" found for row",
+						RelationGetRelationName(parent)),
+				 errdetail("Partition key of the failing row contains (%s) = (%s).",
+						   NameStr(RelationGetDescr(parent)->attrs[key->partattnum - 1]->attname),
+						   valstr)));
+	}
+
+	Assert(partidx < proute->nparts);
+
+	return partidx;
+}
+
+/*
+ * ExecGetPartitionInfo
+ *		Get the ResultRelInfo of a partition, opening it for insertion if
+ *		no row was routed to it before.
+ */
+ResultRelInfo *
+ExecGetPartitionInfo(PartitionTupleRouting *proute, int partidx,
+					 EState *estate)
+{
+	ResultRelInfo *rootinfo = proute->rootinfo;
+	ResultRelInfo *partinfo;
+	Relation	partrel;
+	MemoryContext oldcxt;
+
+	if (proute->partinfos[partidx] != NULL)
+		return proute->partinfos[partidx];
+
+	oldcxt = MemoryContextSwitchTo(estate->es_query_cxt);
+
+	partrel = heap_open(RelationGetPartitionDesc(rootinfo->ri_RelationDesc)->oids[partidx],
+						RowExclusiveLock);
+	CheckValidResultRel(partrel, CMD_INSERT);
+
+	/*
+	 * The partition shares the parent's range table entry, which is where
+	 * permissions were checked.
+	 */
+	partinfo = makeNode(ResultRelInfo);
+	InitResultRelInfo(partinfo, partrel, rootinfo->ri_RangeTableIndex,
+					  estate->es_instrument);
+	if (partrel->rd_rel->relhasindex)
+		ExecOpenIndices(partinfo);
+
+	proute->tomaps[partidx] =
+		convert_tuples_by_name(RelationGetDescr(rootinfo->ri_RelationDesc),
+							   RelationGetDescr(partrel),
+							   gettext_noop("could not convert row type"));
+	if (proute->tomaps[partidx] != NULL)
+	{
+		proute->frommaps[partidx] =
+			convert_tuples_by_name(RelationGetDescr(partrel),
+								   RelationGetDescr(rootinfo->ri_RelationDesc),
+								   gettext_noop("could not convert row type"));
+		proute->partslots[partidx] = ExecInitExtraTupleSlot(estate);
+		ExecSetSlotDescriptor(proute->partslots[partidx],
+							  RelationGetDescr(partrel));
+	}
+
+	MemoryContextSwitchTo(oldcxt);
+
+	proute->partinfos[partidx] = partinfo;
+
+	return partinfo;
+}
+
+/*
+ * ExecConvertToPartition
+ *		Convert a row of the partitioned table to the row type of its
+ *		partition, if they differ.
+ */
+TupleTableSlot *
+ExecConvertToPartition(PartitionTupleRouting *proute, int partidx,
+					   TupleTableSlot *slot)
+{
+	TupleConversionMap *map = proute->tomaps[partidx];
+	HeapTuple	tuple;
+
+	if (map == NULL)
+		return slot;
+
+	tuple = do_convert_tuple(ExecMaterializeSlot(slot), map);
+	return ExecStoreTuple(tuple, proute->partslots[partidx],
+						  InvalidBuffer, true);
+}
+
+/*
+ * ExecConvertToRoot
+ *		Convert a row stored in a partition back to the row type of the
+ *		partitioned table, for RETURNING and WITH CHECK OPTION.
+ */
+TupleTableSlot *
+ExecConvertToRoot(PartitionTupleRouting *proute, int partidx,
+				  TupleTableSlot *slot)
+{
+	TupleConversionMap *map = proute->frommaps[partidx];
+	HeapTuple	partTuple;
+	HeapTuple	tuple;
+
+	if (map == NULL)
+		return slot;
+
+	partTuple = ExecMaterializeSlot(slot);
+	tuple = do_convert_tuple(partTuple, map);
+	tuple->t_self = partTuple->t_self;
+	tuple->t_tableOid = partTuple->t_tableOid;
+
+	return ExecStoreTuple(tuple, proute->rootslot, InvalidBuffer, true);
+}
+
+/*
+ * ExecCleanupPartitionTupleRouting
+ *		Close the partitions rows were routed to.  Locks are kept until
+ *		end of transaction.
+ */
+void
+ExecCleanupPartitionTupleRouting(PartitionTupleRouting *proute)
+{
+	int			i;
+
+	for (i = 0; i < proute->nparts; i++)
+	{
+		ResultRelInfo *partinfo = proute->partinfos[i];
+
+		if (partinfo == NULL)
+			continue;
+		ExecCloseIndices(partinfo);
+		heap_close(partinfo->ri_RelationDesc, NoLock);
+	}
+}
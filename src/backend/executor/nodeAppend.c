@@ -57,10 +57,17 @@
 
 #include "postgres.h"
 
+#include "access/heapam.h"
+#include "catalog/partition.h"
 #include "executor/execdebug.h"
 #include "executor/nodeAppend.h"
+#include "nodes/makefuncs.h"
+#include "nodes/nodeFuncs.h"
+#include "utils/lsyscache.h"
 
 static bool exec_append_initialize_next(AppendState *appendstate);
+static List *exec_append_matching_partitions(Append *node, EState *estate);
+static Node *exec_append_param_mutator(Node *node, ExprContext *econtext);
 
 
 /* ----------------------------------------------------------------
@@ -105,6 +112,69 @@ exec_append_initialize_next(AppendState *appendstate)
 	}
 }
 
+/* ----------------------------------------------------------------
+ *		exec_append_matching_partitions
+ *
+ *		Returns the OIDs of the partitions that may hold rows matching
+ *		the node's pruning clauses, given the values of the Params in them.
+ * ----------------------------------------------------------------
+ */
+static List *
+exec_append_matching_partitions(Append *node, EState *estate)
+{
+	ExprContext *econtext = GetPerTupleExprContext(estate);
+	List	   *clauses;
+	Relation	parent;
+	PartitionDesc pdesc;
+	Bitmapset  *parts;
+	List	   *result = NIL;
+	int			partidx;
+
+	clauses = (List *) exec_append_param_mutator((Node *) node->partpruneclauses,
+												 econtext);
+
+	parent = heap_open(node->partrelid, AccessShareLock);
+	pdesc = RelationGetPartitionDesc(parent);
+	parts = get_matching_partitions(RelationGetPartitionKey(parent), pdesc,
+									node->partrti, clauses, NULL);
+	while ((partidx = bms_first_member(parts)) >= 0)
+		result = lappend_oid(result, pdesc->oids[partidx]);
+	heap_close(parent, NoLock);
+
+	return result;
+}
+
+/*
+ * Replace the external Params in pruning clauses with Consts holding their
+ * current values.
+ */
+static Node *
+exec_append_param_mutator(Node *node, ExprContext *econtext)
+{
+	if (node == NULL)
+		return NULL;
+	if (IsA(node, Param) &&
+		((Param *) node)->paramkind == PARAM_EXTERN)
+	{
+		Param	   *param = (Param *) node;
+		ExprState  *exprstate;
+		Datum		value;
+		bool		isnull;
+		int16		typlen;
+		bool		typbyval;
+
+		exprstate = ExecInitExpr((Expr *) param, NULL);
+		value = ExecEvalExprSwitchContext(exprstate, econtext, &isnull, NULL);
+		get_typlenbyval(param->paramtype, &typlen, &typbyval);
+
+		return (Node *) makeConst(param->paramtype, param->paramtypmod,
+								  param->paramcollid, (int) typlen,
+								  value, isnull, typbyval);
+	}
+	return expression_tree_mutator(node, exec_append_param_mutator,
+								   (void *) econtext);
+}
+
 /* ----------------------------------------------------------------
  *		ExecInitAppend
  *
@@ -114,6 +184,9 @@ exec_append_initialize_next(AppendState *appendstate)
  *		append node may not be scanned, but this way all of the
  *		structures get allocated in the executor's top level memory
  *		block instead of that of the call to ExecAppend.)
+ *
+ *		If the append node scans partitions and has pruning clauses,
+ *		the subplans of partitions that can't match are never started.
  * ----------------------------------------------------------------
  */
 AppendState *
@@ -124,16 +197,41 @@ ExecInitAppend(Append *node, EState *estate, int eflags)
 	int			nplans;
 	int			i;
 	ListCell   *lc;
+	ListCell   *lc2;
+	List	   *initplans;
+	List	   *matchoids = NIL;
+	bool		prune;
 
 	/* check for unsupported flags */
 	Assert(!(eflags & EXEC_FLAG_MARK));
 
+	/*
+	 * Work out which subplans to run.  The Params can be evaluated only if
+	 * values were supplied; EXPLAIN of a generic plan may have none.
+	 */
+	prune = (OidIsValid(node->partrelid) &&
+			 estate->es_param_list_info != NULL);
+	if (prune)
+	{
+		matchoids = exec_append_matching_partitions(node, estate);
+		initplans = NIL;
+		forboth(lc, node->appendplans, lc2, node->partoids)
+		{
+			Oid			partoid = lfirst_oid(lc2);
+
+			if (!OidIsValid(partoid) || list_member_oid(matchoids, partoid))
+				initplans = lappend(initplans, lfirst(lc));
+		}
+	}
+	else
+		initplans = node->appendplans;
+
 	/*
 	 * Set up empty vector of subplan states
 	 */
-	nplans = list_length(node->appendplans);
+	nplans = list_length(initplans);
 
-	appendplanstates = (PlanState **) palloc0(nplans * sizeof(PlanState *));
+	appendplanstates = (PlanState **) palloc0(Max(nplans, 1) * sizeof(PlanState *));
 
 	/*
 	 * create new AppendState for our append node
@@ -142,6 +240,7 @@ ExecInitAppend(Append *node, EState *estate, int eflags)
 	appendstate->ps.state = estate;
 	appendstate->appendplans = appendplanstates;
 	appendstate->as_nplans = nplans;
+	appendstate->as_nremoved = list_length(node->appendplans) - nplans;
 
 	/*
 	 * Miscellaneous initialization
@@ -161,7 +260,7 @@ ExecInitAppend(Append *node, EState *estate, int eflags)
 	 * results into the array "appendplans".
 	 */
 	i = 0;
-	foreach(lc, node->appendplans)
+	foreach(lc, initplans)
 	{
 		Plan	   *initNode = (Plan *) lfirst(lc);
 
@@ -193,6 +292,10 @@ ExecInitAppend(Append *node, EState *estate, int eflags)
 TupleTableSlot *
 ExecAppend(AppendState *node)
 {
+	/* All the subplans may have been pruned */
+	if (node->as_nplans == 0)
+		return ExecClearTuple(node->ps.ps_ResultTupleSlot);
+
 	for (;;)
 	{
 		PlanState  *subnode;
@@ -0,0 +1,339 @@
+/*-------------------------------------------------------------------------
+ *
+ * nodeIncrementalSort.c
+ *	  Routines to handle incremental sorting of relations.
+ *
+ * Portions Copyright (c) 1996-2014, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ *
+ * IDENTIFICATION
+ *	  src/backend/executor/nodeIncrementalSort.c
+ *
+ *	NOTES
+ *	   The input of an IncrementalSort node is already sorted by a prefix
+ *	   of the requested sort keys.  Instead of reading and sorting the whole
+ *	   input before returning the first tuple, as a Sort node must, we read
+ *	   one group of tuples sharing the presorted columns at a time, sort it
+ *	   and return it.  This needs memory only for one group, and the first
+ *	   tuples can be returned after reading just one group, which matters
+ *	   a lot under a LIMIT.
+ *
+ *	   Groups can be very small (in the extreme, one tuple each), and setting
+ *	   up a tuplesort for each one would be costly.  So consecutive groups
+ *	   are collected into a batch of at least INCSORT_MIN_BATCH tuples, which
+ *	   is sorted by all the sort keys.  A group is never split between two
+ *	   batches, so the batches come out in the right order.
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "executor/execdebug.h"
+#include "executor/nodeIncrementalSort.h"
+#include "miscadmin.h"
+#include "utils/lsyscache.h"
+#include "utils/memutils.h"
+#include "utils/tuplesort.h"
+
+/* minimum number of tuples sorted together */
+#define INCSORT_MIN_BATCH	32
+
+static bool fill_batch(IncrementalSortState *node);
+
+
+/* ----------------------------------------------------------------
+ *		ExecIncrementalSort
+ *
+ *		Returns the next tuple in sort order, reading and sorting the
+ *		next batch of groups from the outer subtree whenever the current
+ *		one is used up.
+ *
+ *		Conditions:
+ *		  -- the outer subtree returns tuples ordered by the first
+ *			 presortedCols sort columns.
+ *
+ *		Initial States:
+ *		  -- the outer child is prepared to return the first tuple.
+ * ----------------------------------------------------------------
+ */
+TupleTableSlot *
+ExecIncrementalSort(IncrementalSortState *node)
+{
+	TupleTableSlot *slot = node->ss.ps.ps_ResultTupleSlot;
+
+	for (;;)
+	{
+		if (node->batch_Done)
+		{
+			if (tuplesort_gettupleslot((Tuplesortstate *) node->tuplesortstate,
+									   true, slot))
+			{
+				node->tuples_returned++;
+				return slot;
+			}
+			node->batch_Done = false;
+		}
+
+		/* Nothing more to do if the input or the bound is used up */
+		if (node->outer_Done && !node->pivot_pending)
+			return ExecClearTuple(slot);
+		if (node->bounded && node->tuples_returned >= node->bound)
+			return ExecClearTuple(slot);
+
+		if (!fill_batch(node))
+			return ExecClearTuple(slot);
+	}
+}
+
+/*
+ * Read the next batch of whole groups from the outer plan into a fresh
+ * tuplesort, and sort it.  Returns false if there was nothing left to read.
+ */
+static bool
+fill_batch(IncrementalSortState *node)
+{
+	IncrementalSort *plannode = (IncrementalSort *) node->ss.ps.plan;
+	PlanState  *outerNode = outerPlanState(node);
+	Tuplesortstate *tuplesortstate;
+	int64		ntuples = 0;
+	int64		batch_bound = -1;
+
+	SO1_printf("ExecIncrementalSort: %s\n",
+			   "reading next batch");
+
+	if (node->tuplesortstate != NULL)
+		tuplesort_end((Tuplesortstate *) node->tuplesortstate);
+
+	tuplesortstate = tuplesort_begin_heap(ExecGetResultType(outerNode),
+										  plannode->sort.numCols,
+										  plannode->sort.sortColIdx,
+										  plannode->sort.sortOperators,
+										  plannode->sort.collations,
+										  plannode->sort.nullsFirst,
+										  work_mem,
+										  false);
+	node->tuplesortstate = (void *) tuplesortstate;
+
+	/*
+	 * If bounded, the batch need not deliver more than the tuples still
+	 * wanted.  Once we have that many, the following groups all sort after
+	 * them, so the batch can end at the next group boundary.
+	 */
+	if (node->bounded)
+	{
+		batch_bound = node->bound - node->tuples_returned;
+		tuplesort_set_bound(tuplesortstate, batch_bound);
+	}
+
+	/* The tuple that ended the previous batch starts this one */
+	if (node->pivot_pending)
+	{
+		tuplesort_puttupleslot(tuplesortstate, node->group_pivot);
+		node->pivot_pending = false;
+		ntuples++;
+	}
+
+	while (!node->outer_Done)
+	{
+		TupleTableSlot *outerslot = ExecProcNode(outerNode);
+
+		if (TupIsNull(outerslot))
+		{
+			node->outer_Done = true;
+			break;
+		}
+
+		if (ntuples == 0)
+			ExecCopySlot(node->group_pivot, outerslot);
+		else if (!execTuplesMatch(outerslot, node->group_pivot,
+								  plannode->presortedCols,
+								  plannode->sort.sortColIdx,
+								  node->eqfunctions,
+								  node->tempContext))
+		{
+			/* This tuple starts a new group */
+			ExecCopySlot(node->group_pivot, outerslot);
+			if (ntuples >= INCSORT_MIN_BATCH ||
+				(batch_bound >= 0 && ntuples >= batch_bound))
+			{
+				node->pivot_pending = true;
+				break;
+			}
+		}
+
+		tuplesort_puttupleslot(tuplesortstate, outerslot);
+		ntuples++;
+	}
+
+	if (ntuples == 0)
+		return false;
+
+	tuplesort_performsort(tuplesortstate);
+	node->batch_Done = true;
+	node->nbatches++;
+
+	SO1_printf("ExecIncrementalSort: %s\n",
+			   "batch sorted");
+
+	return true;
+}
+
+/* ----------------------------------------------------------------
+ *		ExecInitIncrementalSort
+ *
+ *		Creates the run-time state information for the incremental sort
+ *		node produced by the planner and initializes its outer subtree.
+ * ----------------------------------------------------------------
+ */
+IncrementalSortState *
+ExecInitIncrementalSort(IncrementalSort *node, EState *estate, int eflags)
+{
+	IncrementalSortState *sortstate;
+	Oid		   *eqOperators;
+	int			i;
+
+	SO1_printf("ExecInitIncrementalSort: %s\n",
+			   "initializing incremental sort node");
+
+	/*
+	 * Batches are thrown away once returned, so we support neither backward
+	 * scan nor mark/restore.
+	 */
+	Assert(!(eflags & (EXEC_FLAG_BACKWARD | EXEC_FLAG_MARK)));
+
+	/*
+	 * create state structure
+	 */
+	sortstate = makeNode(IncrementalSortState);
+	sortstate->ss.ps.plan = (Plan *) node;
+	sortstate->ss.ps.state = estate;
+
+	sortstate->bounded = false;
+	sortstate->batch_Done = false;
+	sortstate->outer_Done = false;
+	sortstate->pivot_pending = false;
+	sortstate->tuples_returned = 0;
+	sortstate->nbatches = 0;
+	sortstate->tuplesortstate = NULL;
+
+	/*
+	 * Miscellaneous initialization
+	 *
+	 * Like Unique nodes, we don't need an ExprContext, but do need a
+	 * per-tuple memory context for calling execTuplesMatch.
+	 */
+	sortstate->tempContext =
+		AllocSetContextCreate(CurrentMemoryContext,
+							  "IncrementalSort",
+							  ALLOCSET_DEFAULT_MINSIZE,
+							  ALLOCSET_DEFAULT_INITSIZE,
+							  ALLOCSET_DEFAULT_MAXSIZE);
+
+	/*
+	 * tuple table initialization
+	 */
+	ExecInitResultTupleSlot(estate, &sortstate->ss.ps);
+	ExecInitScanTupleSlot(estate, &sortstate->ss);
+	sortstate->group_pivot = ExecInitExtraTupleSlot(estate);
+
+	/*
+	 * initialize child nodes
+	 */
+	outerPlanState(sortstate) = ExecInitNode(outerPlan(node), estate, eflags);
+
+	/*
+	 * initialize tuple type.  no need to initialize projection info because
+	 * this node doesn't do projections.
+	 */
+	ExecAssignResultTypeFromTL(&sortstate->ss.ps);
+	ExecAssignScanTypeFromOuterPlan(&sortstate->ss);
+	ExecSetSlotDescriptor(sortstate->group_pivot,
+						  ExecGetResultType(outerPlanState(sortstate)));
+	sortstate->ss.ps.ps_ProjInfo = NULL;
+
+	/*
+	 * Precompute fmgr lookup data for comparing the presorted columns.
+	 */
+	eqOperators = (Oid *) palloc(node->presortedCols * sizeof(Oid));
+	for (i = 0; i < node->presortedCols; i++)
+	{
+		eqOperators[i] = get_equality_op_for_ordering_op(node->sort.sortOperators[i],
+														 NULL);
+		if (!OidIsValid(eqOperators[i]))
+			elog(ERROR, "could not find equality operator for ordering operator %u",
+				 node->sort.sortOperators[i]);
+	}
+	sortstate->eqfunctions = execTuplesMatchPrepare(node->presortedCols,
+													eqOperators);
+	pfree(eqOperators);
+
+	SO1_printf("ExecInitIncrementalSort: %s\n",
+			   "incremental sort node initialized");
+
+	return sortstate;
+}
+
+/* ----------------------------------------------------------------
+ *		ExecEndIncrementalSort(node)
+ * ----------------------------------------------------------------
+ */
+void
+ExecEndIncrementalSort(IncrementalSortState *node)
+{
+	SO1_printf("ExecEndIncrementalSort: %s\n",
+			   "shutting down incremental sort node");
+
+	/*
+	 * clean out the tuple table
+	 */
+	ExecClearTuple(node->ss.ss_ScanTupleSlot);
+	/* must drop pointer to sort result tuple */
+	ExecClearTuple(node->ss.ps.ps_ResultTupleSlot);
+	ExecClearTuple(node->group_pivot);
+
+	/*
+	 * Release tuplesort resources
+	 */
+	if (node->tuplesortstate != NULL)
+		tuplesort_end((Tuplesortstate *) node->tuplesortstate);
+	node->tuplesortstate = NULL;
+
+	MemoryContextDelete(node->tempContext);
+
+	/*
+	 * shut down the subplan
+	 */
+	ExecEndNode(outerPlanState(node));
+
+	SO1_printf("ExecEndIncrementalSort: %s\n",
+			   "incremental sort node shutdown");
+}
+
+void
+ExecReScanIncrementalSort(IncrementalSortState *node)
+{
+	/*
+	 * We keep no more than the current batch, so a rescan always has to
+	 * start over from the outer plan.
+	 */
+	ExecClearTuple(node->ss.ps.ps_ResultTupleSlot);
+	ExecClearTuple(node->group_pivot);
+
+	if (node->tuplesortstate != NULL)
+		tuplesort_end((Tuplesortstate *) node->tuplesortstate);
+	node->tuplesortstate = NULL;
+
+	node->batch_Done = false;
+	node->outer_Done = false;
+	node->pivot_pending = false;
+	node->tuples_returned = 0;
+
+	/*
+	 * if chgParam of subnode is not null then plan will be re-scanned by
+	 * first ExecProcNode.
+	 */
+	if (node->ss.ps.lefttree->chgParam == NULL)
+		ExecReScan(node->ss.ps.lefttree);
+}
@@ -85,9 +85,9 @@ IndexOnlyNext(IndexOnlyScanState *node)
 		 * which all tuples are known visible to everybody.  In any case,
 		 * we'll use the index tuple not the heap tuple as the data source.
 		 *
-		 * Note on Memory Ordering Effects: visibilitymap_test does not lock
-		 * the visibility map buffer, and therefore the result we read here
-		 * could be slightly stale.  However, it can't be stale enough to
+		 * Note on Memory Ordering Effects: visibilitymap_get_status does not
+		 * lock the visibility map buffer, and therefore the result we read
+		 * here could be slightly stale.  However, it can't be stale enough to
 		 * matter.	It suffices to show that (1) there is a read barrier
 		 * between the time we read the index TID and the time we test the
 		 * visibility map; and (2) there is a write barrier between the time
@@ -98,9 +98,9 @@ IndexOnlyNext(IndexOnlyScanState *node)
 		 * reading the TID; and (2) is satisfied by the acquisition of the
 		 * buffer content lock in order to insert the TID.
 		 */
-		if (!visibilitymap_test(scandesc->heapRelation,
-								ItemPointerGetBlockNumber(tid),
-								&node->ioss_VMBuffer))
+		if (!VM_ALL_VISIBLE(scandesc->heapRelation,
+							ItemPointerGetBlockNumber(tid),
+							&node->ioss_VMBuffer))
 		{
 			/*
 			 * Rats, we have to visit the heap to check visibility.
@@ -515,6 +515,7 @@ ExecInitIndexOnlyScan(IndexOnlyScan *node, EState *estate, int eflags)
 
 	/* Set it up for index-only scan */
 	indexstate->ioss_ScanDesc->xs_want_itup = true;
+	indexstate->ioss_ScanDesc->xs_want_skip = node->indexskipscan;
 	indexstate->ioss_VMBuffer = InvalidBuffer;
 
 	/*
@@ -608,6 +608,7 @@ ExecInitIndexScan(IndexScan *node, EState *estate, int eflags)
 											   estate->es_snapshot,
 											   indexstate->iss_NumScanKeys,
 											 indexstate->iss_NumOrderByKeys);
+	indexstate->iss_ScanDesc->xs_want_skip = node->indexskipscan;
 
 	/*
 	 * If no run-time keys to calculate, go ahead and pass the scankeys to the
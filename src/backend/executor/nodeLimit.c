@@ -300,20 +300,25 @@ recompute_limits(LimitState *node)
 }
 
 /*
- * If we have a COUNT, and our input is a Sort node, notify it that it can
- * use bounded sort.  Also, if our input is a MergeAppend, we can apply the
- * same bound to any Sorts that are direct children of the MergeAppend,
- * since the MergeAppend surely need read no more than that many tuples from
- * any one input.  We also have to be prepared to look through a Result,
- * since the planner might stick one atop MergeAppend for projection purposes.
+ * If we have a COUNT, and our input is a Sort or IncrementalSort node,
+ * notify it that it can use bounded sort.
+ *
+ * We can also look through nodes that never return more than one tuple per
+ * input tuple they read, and whose inputs therefore need not deliver more
+ * than N tuples either.  That covers MergeAppend and Append, for each of
+ * their children; and Result and SubqueryScan, as long as they do no
+ * filtering and don't expand set-returning functions.  The planner might
+ * stick a Result atop MergeAppend for projection purposes, and the
+ * branches of a UNION ALL come as SubqueryScans under an Append.
  *
  * This is a bit of a kluge, but we don't have any more-abstract way of
  * communicating between the two nodes; and it doesn't seem worth trying
  * to invent one without some more examples of special communication needs.
  *
- * Note: it is the responsibility of nodeSort.c to react properly to
- * changes of these parameters.  If we ever do redesign this, it'd be a
- * good idea to integrate this signaling with the parameter-change mechanism.
+ * Note: it is the responsibility of nodeSort.c and nodeIncrementalSort.c to
+ * react properly to changes of these parameters.  If we ever do redesign
+ * this, it'd be a good idea to integrate this signaling with the
+ * parameter-change mechanism.
  */
 static void
 pass_down_bound(LimitState *node, PlanState *child_node)
@@ -335,6 +340,20 @@ pass_down_bound(LimitState *node, PlanState *child_node)
 			sortState->bound = tuples_needed;
 		}
 	}
+	else if (IsA(child_node, IncrementalSortState))
+	{
+		IncrementalSortState *sortState = (IncrementalSortState *) child_node;
+		int64		tuples_needed = node->count + node->offset;
+
+		/* negative test checks for overflow in sum */
+		if (node->noCount || tuples_needed < 0)
+			sortState->bounded = false;
+		else
+		{
+			sortState->bounded = true;
+			sortState->bound = tuples_needed;
+		}
+	}
 	else if (IsA(child_node, MergeAppendState))
 	{
 		MergeAppendState *maState = (MergeAppendState *) child_node;
@@ -343,6 +362,23 @@ pass_down_bound(LimitState *node, PlanState *child_node)
 		for (i = 0; i < maState->ms_nplans; i++)
 			pass_down_bound(node, maState->mergeplans[i]);
 	}
+	else if (IsA(child_node, AppendState))
+	{
+		AppendState *aState = (AppendState *) child_node;
+		int			i;
+
+		for (i = 0; i < aState->as_nplans; i++)
+			pass_down_bound(node, aState->appendplans[i]);
+	}
+	else if (IsA(child_node, SubqueryScanState))
+	{
+		SubqueryScanState *sqState = (SubqueryScanState *) child_node;
+
+		/* Same considerations as for Result, below, but we do check quals */
+		if (child_node->plan->qual == NIL &&
+			!expression_returns_set((Node *) child_node->plan->targetlist))
+			pass_down_bound(node, sqState->subplan);
+	}
 	else if (IsA(child_node, ResultState))
 	{
 		/*
@@ -40,6 +40,8 @@
 #include "access/htup_details.h"
 #include "access/xact.h"
 #include "commands/trigger.h"
+#include "catalog/partition.h"
+#include "executor/execPartition.h"
 #include "executor/executor.h"
 #include "executor/nodeModifyTable.h"
 #include "foreign/fdwapi.h"
@@ -157,18 +159,25 @@ ExecProcessReturning(ProjectionInfo *projectReturning,
  *		For INSERT, we have to insert the tuple into the target relation
  *		and insert appropriate tuples into the index relations.
  *
+ *		If the target relation is partitioned, the tuple is inserted into
+ *		the partition that accepts it instead.
+ *
  *		Returns RETURNING result if any, otherwise NULL.
  * ----------------------------------------------------------------
  */
 static TupleTableSlot *
-ExecInsert(TupleTableSlot *slot,
+ExecInsert(ModifyTableState *mtstate,
+		   TupleTableSlot *slot,
 		   TupleTableSlot *planSlot,
 		   EState *estate,
 		   bool canSetTag)
 {
 	HeapTuple	tuple;
 	ResultRelInfo *resultRelInfo;
+	ResultRelInfo *saved_resultRelInfo = NULL;
 	Relation	resultRelationDesc;
+	PartitionTupleRouting *proute = mtstate->mt_partition_routing;
+	int			partidx = -1;
 	Oid			newId;
 	List	   *recheckIndexes = NIL;
 
@@ -182,6 +191,22 @@ ExecInsert(TupleTableSlot *slot,
 	 * get information on the (current) result relation
 	 */
 	resultRelInfo = estate->es_result_relation_info;
+
+	/*
+	 * Route the tuple to its partition, converting it to the partition's
+	 * rowtype if that's different.  The partition is the result relation
+	 * until we're done with the tuple, so that its triggers fire and its
+	 * indexes are updated.
+	 */
+	if (proute != NULL)
+	{
+		saved_resultRelInfo = resultRelInfo;
+		partidx = ExecFindPartition(proute, slot, estate);
+		resultRelInfo = ExecGetPartitionInfo(proute, partidx, estate);
+		slot = ExecConvertToPartition(proute, partidx, slot);
+		tuple = ExecMaterializeSlot(slot);
+		estate->es_result_relation_info = resultRelInfo;
+	}
 	resultRelationDesc = resultRelInfo->ri_RelationDesc;
 
 	/*
@@ -206,7 +231,11 @@ ExecInsert(TupleTableSlot *slot,
 		slot = ExecBRInsertTriggers(estate, resultRelInfo, slot);
 
 		if (slot == NULL)		/* "do nothing" */
+		{
+			if (saved_resultRelInfo)
+				estate->es_result_relation_info = saved_resultRelInfo;
 			return NULL;
+		}
 
 		/* trigger might have changed tuple */
 		tuple = ExecMaterializeSlot(slot);
@@ -253,10 +282,13 @@ ExecInsert(TupleTableSlot *slot,
 		tuple->t_tableOid = RelationGetRelid(resultRelationDesc);
 
 		/*
-		 * Check the constraints of the tuple
+		 * Check the constraints of the tuple.  A tuple routed to this
+		 * partition is known to satisfy its partition constraint.
 		 */
 		if (resultRelationDesc->rd_att->constr)
 			ExecConstraints(resultRelInfo, slot, estate);
+		if (resultRelInfo->ri_PartitionCheck && proute == NULL)
+			ExecPartitionCheck(resultRelInfo, slot, estate);
 
 		/*
 		 * insert the tuple
@@ -287,6 +319,14 @@ ExecInsert(TupleTableSlot *slot,
 
 	list_free(recheckIndexes);
 
+	/* The rest is done in terms of the partitioned table */
+	if (saved_resultRelInfo)
+	{
+		slot = ExecConvertToRoot(proute, partidx, slot);
+		resultRelInfo = saved_resultRelInfo;
+		estate->es_result_relation_info = resultRelInfo;
+	}
+
 	/* Check any WITH CHECK OPTION constraints */
 	if (resultRelInfo->ri_WithCheckOptions != NIL)
 		ExecWithCheckOptions(resultRelInfo, slot, estate);
@@ -664,6 +704,8 @@ ExecUpdate(ItemPointer tupleid,
 lreplace:;
 		if (resultRelationDesc->rd_att->constr)
 			ExecConstraints(resultRelInfo, slot, estate);
+		if (resultRelInfo->ri_PartitionCheck)
+			ExecPartitionCheck(resultRelInfo, slot, estate);
 
 		/*
 		 * replace the heap tuple
@@ -1021,7 +1063,8 @@ ExecModifyTable(ModifyTableState *node)
 		switch (operation)
 		{
 			case CMD_INSERT:
-				slot = ExecInsert(slot, planSlot, estate, node->canSetTag);
+				slot = ExecInsert(node, slot, planSlot, estate,
+								  node->canSetTag);
 				break;
 			case CMD_UPDATE:
 				slot = ExecUpdate(tupleid, oldtuple, slot, planSlot,
@@ -1159,6 +1202,12 @@ ExecInitModifyTable(ModifyTable *node, EState *estate, int eflags)
 
 	estate->es_result_relation_info = saved_resultRelInfo;
 
+	/* Rows inserted into a partitioned table are routed to its partitions */
+	if (operation == CMD_INSERT &&
+		RelationGetPartitionKey(mtstate->resultRelInfo->ri_RelationDesc) != NULL)
+		mtstate->mt_partition_routing =
+			ExecSetupPartitionTupleRouting(mtstate->resultRelInfo, estate);
+
 	/*
 	 * Initialize any WITH CHECK OPTION constraints if needed.
 	 */
@@ -1420,6 +1469,10 @@ ExecEndModifyTable(ModifyTableState *node)
 														   resultRelInfo);
 	}
 
+	/* Close any partitions rows were routed to */
+	if (node->mt_partition_routing != NULL)
+		ExecCleanupPartitionTupleRouting(node->mt_partition_routing);
+
 	/*
 	 * Free the exprcontext
 	 */
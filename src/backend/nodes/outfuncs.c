@@ -347,6 +347,10 @@ _outAppend(StringInfo str, const Append *node)
 	_outPlanInfo(str, (const Plan *) node);
 
 	WRITE_NODE_FIELD(appendplans);
+	WRITE_OID_FIELD(partrelid);
+	WRITE_UINT_FIELD(partrti);
+	WRITE_NODE_FIELD(partpruneclauses);
+	WRITE_NODE_FIELD(partoids);
 }
 
 static void
@@ -451,6 +455,7 @@ _outIndexScan(StringInfo str, const IndexScan *node)
 	WRITE_NODE_FIELD(indexorderby);
 	WRITE_NODE_FIELD(indexorderbyorig);
 	WRITE_ENUM_FIELD(indexorderdir, ScanDirection);
+	WRITE_BOOL_FIELD(indexskipscan);
 }
 
 static void
@@ -465,6 +470,7 @@ _outIndexOnlyScan(StringInfo str, const IndexOnlyScan *node)
 	WRITE_NODE_FIELD(indexorderby);
 	WRITE_NODE_FIELD(indextlist);
 	WRITE_ENUM_FIELD(indexorderdir, ScanDirection);
+	WRITE_BOOL_FIELD(indexskipscan);
 }
 
 static void
@@ -477,6 +483,7 @@ _outBitmapIndexScan(StringInfo str, const BitmapIndexScan *node)
 	WRITE_OID_FIELD(indexid);
 	WRITE_NODE_FIELD(indexqual);
 	WRITE_NODE_FIELD(indexqualorig);
+	WRITE_BOOL_FIELD(indexskipscan);
 }
 
 static void
@@ -736,6 +743,36 @@ _outSort(StringInfo str, const Sort *node)
 		appendStringInfo(str, " %s", booltostr(node->nullsFirst[i]));
 }
 
+static void
+_outIncrementalSort(StringInfo str, const IncrementalSort *node)
+{
+	int			i;
+
+	WRITE_NODE_TYPE("INCREMENTALSORT");
+
+	_outPlanInfo(str, (const Plan *) node);
+
+	WRITE_INT_FIELD(sort.numCols);
+
+	appendStringInfoString(str, " :sortColIdx");
+	for (i = 0; i < node->sort.numCols; i++)
+		appendStringInfo(str, " %d", node->sort.sortColIdx[i]);
+
+	appendStringInfoString(str, " :sortOperators");
+	for (i = 0; i < node->sort.numCols; i++)
+		appendStringInfo(str, " %u", node->sort.sortOperators[i]);
+
+	appendStringInfoString(str, " :collations");
+	for (i = 0; i < node->sort.numCols; i++)
+		appendStringInfo(str, " %u", node->sort.collations[i]);
+
+	appendStringInfoString(str, " :nullsFirst");
+	for (i = 0; i < node->sort.numCols; i++)
+		appendStringInfo(str, " %s", booltostr(node->sort.nullsFirst[i]));
+
+	WRITE_INT_FIELD(presortedCols);
+}
+
 static void
 _outUnique(StringInfo str, const Unique *node)
 {
@@ -1524,6 +1561,7 @@ _outIndexPath(StringInfo str, const IndexPath *node)
 	WRITE_NODE_FIELD(indexorderbys);
 	WRITE_NODE_FIELD(indexorderbycols);
 	WRITE_ENUM_FIELD(indexscandir, ScanDirection);
+	WRITE_BOOL_FIELD(indexskipscan);
 	WRITE_FLOAT_FIELD(indextotalcost, "%.2f");
 	WRITE_FLOAT_FIELD(indexselectivity, "%.4f");
 }
@@ -1988,6 +2026,8 @@ _outCreateStmtInfo(StringInfo str, const CreateStmt *node)
 	WRITE_ENUM_FIELD(oncommit, OnCommitAction);
 	WRITE_STRING_FIELD(tablespacename);
 	WRITE_BOOL_FIELD(if_not_exists);
+	WRITE_NODE_FIELD(partspec);
+	WRITE_NODE_FIELD(partbound);
 }
 
 static void
@@ -2114,6 +2154,30 @@ _outTableLikeClause(StringInfo str, const TableLikeClause *node)
 	WRITE_UINT_FIELD(options);
 }
 
+static void
+_outPartitionSpec(StringInfo str, const PartitionSpec *node)
+{
+	WRITE_NODE_TYPE("PARTITIONSPEC");
+
+	WRITE_STRING_FIELD(strategy);
+	WRITE_STRING_FIELD(colname);
+	WRITE_NODE_FIELD(collation);
+	WRITE_NODE_FIELD(opclass);
+	WRITE_LOCATION_FIELD(location);
+}
+
+static void
+_outPartitionBoundSpec(StringInfo str, const PartitionBoundSpec *node)
+{
+	WRITE_NODE_TYPE("PARTITIONBOUNDSPEC");
+
+	WRITE_CHAR_FIELD(strategy);
+	WRITE_NODE_FIELD(listdatums);
+	WRITE_NODE_FIELD(lowerdatum);
+	WRITE_NODE_FIELD(upperdatum);
+	WRITE_LOCATION_FIELD(location);
+}
+
 static void
 _outLockingClause(StringInfo str, const LockingClause *node)
 {
@@ -2855,6 +2919,9 @@ _outNode(StringInfo str, const void *obj)
 			case T_Sort:
 				_outSort(str, obj);
 				break;
+			case T_IncrementalSort:
+				_outIncrementalSort(str, obj);
+				break;
 			case T_Unique:
 				_outUnique(str, obj);
 				break;
@@ -3223,6 +3290,12 @@ _outNode(StringInfo str, const void *obj)
 			case T_TableLikeClause:
 				_outTableLikeClause(str, obj);
 				break;
+			case T_PartitionSpec:
+				_outPartitionSpec(str, obj);
+				break;
+			case T_PartitionBoundSpec:
+				_outPartitionBoundSpec(str, obj);
+				break;
 			case T_LockingClause:
 				_outLockingClause(str, obj);
 				break;
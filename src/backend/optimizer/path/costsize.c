@@ -111,14 +111,18 @@ Cost		disable_cost = 1.0e10;
 bool		enable_seqscan = true;
 bool		enable_indexscan = true;
 bool		enable_indexonlyscan = true;
+bool		enable_indexskipscan = true;
 bool		enable_bitmapscan = true;
 bool		enable_tidscan = true;
 bool		enable_sort = true;
+bool		enable_incrementalsort = true;
 bool		enable_hashagg = true;
 bool		enable_nestloop = true;
 bool		enable_material = true;
 bool		enable_mergejoin = true;
 bool		enable_hashjoin = true;
+bool		enable_partitionwise_join = false;
+bool		enable_partitionwise_aggregate = false;
 
 typedef struct
 {
@@ -1335,6 +1339,96 @@ cost_sort(Path *path, PlannerInfo *root,
 	path->total_cost = startup_cost + run_cost;
 }
 
+/*
+ * cost_incremental_sort
+ *	  Determines and returns the cost of sorting a relation that is already
+ *	  sorted by a prefix of the requested pathkeys, including the cost of
+ *	  reading the input data.
+ *
+ * The input is split into groups of tuples that share the values of the
+ * first 'presorted_keys' pathkeys, and each group is sorted on its own
+ * (see nodeIncrementalSort.c).  The number of groups is estimated from the
+ * presorted key expressions.  Only the first group has to be read and sorted
+ * before the first tuple can be returned, so startup cost is that of
+ * sorting one group; every other group adds to the run cost.  On top of
+ * that, we charge one comparison per input tuple for detecting group
+ * boundaries, and a cpu_tuple_cost per group for setting up its sort.
+ *
+ * Unlike cost_sort, we take no limit_tuples: the groups are usually small,
+ * so a bounded sort of one of them saves little, and an upper LIMIT will
+ * pro-rate our run cost anyway.
+ *
+ * 'pathkeys' is the list of all the sort keys
+ * 'presorted_keys' is the number of leading pathkeys the input is sorted by
+ * 'input_startup_cost', 'input_total_cost' are the costs of the input path
+ * Other parameters are as for cost_sort.
+ */
+void
+cost_incremental_sort(Path *path, PlannerInfo *root,
+					  List *pathkeys, int presorted_keys,
+					  Cost input_startup_cost, Cost input_total_cost,
+					  double input_tuples, int width,
+					  Cost comparison_cost, int sort_mem)
+{
+	Cost		startup_cost;
+	Cost		run_cost;
+	Cost		input_run_cost = input_total_cost - input_startup_cost;
+	Cost		group_startup_cost;
+	Cost		group_run_cost;
+	Cost		group_input_run_cost;
+	double		group_tuples;
+	double		num_groups;
+	List	   *presortedExprs = NIL;
+	ListCell   *l;
+	int			i = 0;
+	Path		sort_path;		/* dummy for result of cost_sort */
+
+	Assert(presorted_keys > 0 && presorted_keys < list_length(pathkeys));
+
+	path->rows = input_tuples;
+
+	if (input_tuples < 2.0)
+		input_tuples = 2.0;
+
+	/* Estimate the number of groups of the presorted keys */
+	foreach(l, pathkeys)
+	{
+		PathKey    *key = (PathKey *) lfirst(l);
+		EquivalenceMember *member = (EquivalenceMember *)
+		linitial(key->pk_eclass->ec_members);
+
+		if (i++ >= presorted_keys)
+			break;
+		presortedExprs = lappend(presortedExprs, member->em_expr);
+	}
+	num_groups = estimate_num_groups(root, presortedExprs, input_tuples);
+	list_free(presortedExprs);
+
+	group_tuples = input_tuples / num_groups;
+	group_input_run_cost = input_run_cost / num_groups;
+
+	/* Cost the sort of one group */
+	cost_sort(&sort_path, root, pathkeys, 0.0, group_tuples, width,
+			  comparison_cost, sort_mem, -1.0);
+	group_startup_cost = sort_path.startup_cost;
+	group_run_cost = sort_path.total_cost - sort_path.startup_cost;
+
+	startup_cost = input_startup_cost + group_input_run_cost + group_startup_cost;
+	run_cost = group_run_cost +
+		(num_groups - 1.0) * (group_input_run_cost + group_startup_cost +
+							  group_run_cost);
+
+	/* One equality check per tuple, and per-group tuplesort setup */
+	run_cost += (comparison_cost + cpu_operator_cost) * input_tuples;
+	run_cost += cpu_tuple_cost * num_groups;
+
+	if (!enable_incrementalsort)
+		startup_cost += disable_cost;
+
+	path->startup_cost = startup_cost;
+	path->total_cost = startup_cost + run_cost;
+}
+
 /*
  * cost_merge_append
  *	  Determines and returns the cost of a MergeAppend node.
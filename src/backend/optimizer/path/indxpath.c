@@ -136,6 +136,7 @@ static Relids get_bitmap_tree_required_outer(Path *bitmapqual);
 static void find_indexpath_quals(Path *bitmapqual, List **quals, List **preds);
 static int	find_list_position(Node *node, List **nodelist);
 static bool check_index_only(RelOptInfo *rel, IndexOptInfo *index);
+static bool skip_scan_clauses_ok(List *indexclauses);
 static double get_loop_count(PlannerInfo *root, Relids outer_relids);
 static void match_restriction_clauses_to_index(RelOptInfo *rel,
 								   IndexOptInfo *index,
@@ -838,6 +839,7 @@ build_index_paths(PlannerInfo *root, RelOptInfo *rel,
 	bool		pathkeys_possibly_useful;
 	bool		index_is_ordered;
 	bool		index_only_scan;
+	bool		skip_scan;
 	int			indexcol;
 
 	/*
@@ -983,10 +985,23 @@ build_index_paths(PlannerInfo *root, RelOptInfo *rel,
 					   check_index_only(rel, index));
 
 	/*
-	 * 4. Generate an indexscan path if there are relevant restriction clauses
+	 * 4. Check if a skip scan is possible.  That requires restriction clauses
+	 * on some index columns, but not the first one, since the scan is going
+	 * to supply its own condition on the first column for each distinct
+	 * value it finds there.
+	 */
+	skip_scan = (enable_indexskipscan && index->amcanskip &&
+				 index->ncolumns > 1 && found_clause &&
+				 linitial_int(clause_columns) > 0 &&
+				 skip_scan_clauses_ok(index_clauses));
+
+	/*
+	 * 5. Generate an indexscan path if there are relevant restriction clauses
 	 * in the current clauses, OR the index ordering is potentially useful for
 	 * later merging or final output ordering, OR the index has a useful
-	 * predicate, OR an index-only scan is possible.
+	 * predicate, OR an index-only scan is possible.  If a skip scan is
+	 * possible, generate that too; the index AM's cost estimate will decide
+	 * whether it's cheaper.
 	 */
 	if (found_clause || useful_pathkeys != NIL || useful_predicate ||
 		index_only_scan)
@@ -1000,14 +1015,33 @@ build_index_paths(PlannerInfo *root, RelOptInfo *rel,
 								  index_is_ordered ?
 								  ForwardScanDirection :
 								  NoMovementScanDirection,
+								  false,
 								  index_only_scan,
 								  outer_relids,
 								  loop_count);
 		result = lappend(result, ipath);
+
+		if (skip_scan)
+		{
+			ipath = create_index_path(root, index,
+									  index_clauses,
+									  clause_columns,
+									  orderbyclauses,
+									  orderbyclausecols,
+									  useful_pathkeys,
+									  index_is_ordered ?
+									  ForwardScanDirection :
+									  NoMovementScanDirection,
+									  true,
+									  index_only_scan,
+									  outer_relids,
+									  loop_count);
+			result = lappend(result, ipath);
+		}
 	}
 
 	/*
-	 * 5. If the index is ordered, a backwards scan might be interesting.
+	 * 6. If the index is ordered, a backwards scan might be interesting.
 	 */
 	if (index_is_ordered && pathkeys_possibly_useful)
 	{
@@ -1024,10 +1058,27 @@ build_index_paths(PlannerInfo *root, RelOptInfo *rel,
 									  NIL,
 									  useful_pathkeys,
 									  BackwardScanDirection,
+									  false,
 									  index_only_scan,
 									  outer_relids,
 									  loop_count);
 			result = lappend(result, ipath);
+
+			if (skip_scan)
+			{
+				ipath = create_index_path(root, index,
+										  index_clauses,
+										  clause_columns,
+										  NIL,
+										  NIL,
+										  useful_pathkeys,
+										  BackwardScanDirection,
+										  true,
+										  index_only_scan,
+										  outer_relids,
+										  loop_count);
+				result = lappend(result, ipath);
+			}
 		}
 	}
 
@@ -1809,6 +1860,31 @@ check_index_only(RelOptInfo *rel, IndexOptInfo *index)
 	return result;
 }
 
+/*
+ * skip_scan_clauses_ok
+ *		Determine whether a skip scan can be used with these index clauses.
+ *
+ * Index AMs that support skip scans needn't handle ScalarArrayOpExpr or
+ * RowCompareExpr quals in them, since each of those already implies its
+ * own sequence of index searches.
+ */
+static bool
+skip_scan_clauses_ok(List *indexclauses)
+{
+	ListCell   *lc;
+
+	foreach(lc, indexclauses)
+	{
+		RestrictInfo *rinfo = (RestrictInfo *) lfirst(lc);
+
+		if (IsA(rinfo->clause, ScalarArrayOpExpr) ||
+			IsA(rinfo->clause, RowCompareExpr))
+			return false;
+	}
+
+	return true;
+}
+
 /*
  * get_loop_count
  *		Choose the loop count estimate to use for costing a parameterized path
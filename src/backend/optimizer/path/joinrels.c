@@ -14,10 +14,25 @@
  */
 #include "postgres.h"
 
+#include "access/heapam.h"
+#include "catalog/partition.h"
+#include "nodes/nodeFuncs.h"
+#include "optimizer/clauses.h"
+#include "optimizer/cost.h"
 #include "optimizer/joininfo.h"
 #include "optimizer/pathnode.h"
 #include "optimizer/paths.h"
+#include "parser/parsetree.h"
 #include "utils/memutils.h"
+#include "utils/rel.h"
+
+
+/* Maps a partition's OID to its index in the parent's PartitionDesc */
+typedef struct PartitionOidIndex
+{
+	Oid			oid;
+	int			index;
+} PartitionOidIndex;
 
 
 static void make_rels_by_clause_joins(PlannerInfo *root,
@@ -32,6 +47,15 @@ static bool is_dummy_rel(RelOptInfo *rel);
 static void mark_dummy_rel(RelOptInfo *rel);
 static bool restriction_is_constant_false(List *restrictlist,
 							  bool only_pushed_down);
+static void try_partitionwise_join(PlannerInfo *root, RelOptInfo *joinrel,
+					   RelOptInfo *rel1, RelOptInfo *rel2,
+					   List *restrictlist);
+static bool have_partkey_equi_join(List *restrictlist,
+					   RelOptInfo *rel1, PartitionKey key1,
+					   RelOptInfo *rel2, PartitionKey key2);
+static RelOptInfo **get_partition_member_rels(PlannerInfo *root,
+						  RelOptInfo *rel, PartitionDesc pdesc);
+static int	partition_oid_index_cmp(const void *a, const void *b);
 
 
 /*
@@ -677,6 +701,7 @@ make_join_rel(PlannerInfo *root, RelOptInfo *rel1, RelOptInfo *rel2)
 			add_paths_to_joinrel(root, joinrel, rel2, rel1,
 								 JOIN_INNER, sjinfo,
 								 restrictlist);
+			try_partitionwise_join(root, joinrel, rel1, rel2, restrictlist);
 			break;
 		case JOIN_LEFT:
 			if (is_dummy_rel(rel1) ||
@@ -794,6 +819,256 @@ make_join_rel(PlannerInfo *root, RelOptInfo *rel1, RelOptInfo *rel2)
 	return joinrel;
 }
 
+/*
+ * try_partitionwise_join
+ *	  Consider joining two partitioned tables partition by partition.
+ *
+ * If two tables are partitioned the same way and the join clauses equate
+ * their partition keys, a row of one partition can only join with rows of
+ * the matching partition of the other table.  The join can then be done as
+ * an Append of the joins of each pair of matching partitions, each of which
+ * is planned on its own: the pieces are smaller, so they are more likely to
+ * fit in work_mem, and each pair can use whatever join method suits it best.
+ * The Append is added as another path for the joinrel, and competes with
+ * the paths that join the whole tables on cost.
+ *
+ * We only do this for inner joins of two base relations.  A partition that
+ * was pruned from either side, or proven empty, can't produce any joined
+ * rows, so its pair is simply left out.
+ */
+static void
+try_partitionwise_join(PlannerInfo *root, RelOptInfo *joinrel,
+					   RelOptInfo *rel1, RelOptInfo *rel2,
+					   List *restrictlist)
+{
+	RangeTblEntry *rte1;
+	RangeTblEntry *rte2;
+	Relation	parent1;
+	Relation	parent2;
+	RelOptInfo **parts1 = NULL;
+	RelOptInfo **parts2 = NULL;
+	int			nparts = 0;
+	List	   *subpaths = NIL;
+	ListCell   *lc;
+	int			i;
+
+	if (!enable_partitionwise_join)
+		return;
+
+	if (rel1->reloptkind != RELOPT_BASEREL ||
+		rel2->reloptkind != RELOPT_BASEREL ||
+		rel1->rtekind != RTE_RELATION ||
+		rel2->rtekind != RTE_RELATION)
+		return;
+	rte1 = planner_rt_fetch(rel1->relid, root);
+	rte2 = planner_rt_fetch(rel2->relid, root);
+	if (!rte1->inh || !rte2->inh)
+		return;
+
+	/*
+	 * Lateral references and row marks would have to be translated for each
+	 * pair of partitions; don't bother.
+	 */
+	if (rel1->lateral_relids != NULL || rel2->lateral_relids != NULL ||
+		root->parse->rowMarks != NIL)
+		return;
+
+	/*
+	 * Likewise for PlaceHolderVars that would have to be evaluated by the
+	 * joins of the partitions.
+	 */
+	foreach(lc, joinrel->reltargetlist)
+	{
+		if (!IsA(lfirst(lc), Var))
+			return;
+	}
+
+	if (!relation_is_partitioned(rte1->relid) ||
+		!relation_is_partitioned(rte2->relid))
+		return;
+
+	parent1 = heap_open(rte1->relid, NoLock);
+	parent2 = heap_open(rte2->relid, NoLock);
+	if (partition_bounds_equal(RelationGetPartitionKey(parent1),
+							   RelationGetPartitionDesc(parent1),
+							   RelationGetPartitionKey(parent2),
+							   RelationGetPartitionDesc(parent2)) &&
+		have_partkey_equi_join(restrictlist,
+							   rel1, RelationGetPartitionKey(parent1),
+							   rel2, RelationGetPartitionKey(parent2)))
+	{
+		nparts = RelationGetPartitionDesc(parent1)->nparts;
+		parts1 = get_partition_member_rels(root, rel1,
+										   RelationGetPartitionDesc(parent1));
+		parts2 = get_partition_member_rels(root, rel2,
+										   RelationGetPartitionDesc(parent2));
+	}
+	heap_close(parent1, NoLock);
+	heap_close(parent2, NoLock);
+
+	for (i = 0; i < nparts; i++)
+	{
+		RelOptInfo *child1 = parts1[i];
+		RelOptInfo *child2 = parts2[i];
+		RelOptInfo *child_joinrel;
+		SpecialJoinInfo child_sjinfo;
+		List	   *child_restrictlist;
+
+		if (child1 == NULL || child2 == NULL ||
+			is_dummy_rel(child1) || is_dummy_rel(child2))
+			continue;
+
+		/* Make up a SpecialJoinInfo, as make_join_rel does for inner joins */
+		child_sjinfo.type = T_SpecialJoinInfo;
+		child_sjinfo.min_lefthand = child1->relids;
+		child_sjinfo.min_righthand = child2->relids;
+		child_sjinfo.syn_lefthand = child1->relids;
+		child_sjinfo.syn_righthand = child2->relids;
+		child_sjinfo.jointype = JOIN_INNER;
+		child_sjinfo.lhs_strict = false;
+		child_sjinfo.delay_upper_joins = false;
+		child_sjinfo.join_quals = NIL;
+
+		child_joinrel = build_child_join_rel(root, joinrel, child1, child2,
+											 &child_sjinfo, restrictlist,
+											 &child_restrictlist);
+
+		add_paths_to_joinrel(root, child_joinrel, child1, child2,
+							 JOIN_INNER, &child_sjinfo,
+							 child_restrictlist);
+		add_paths_to_joinrel(root, child_joinrel, child2, child1,
+							 JOIN_INNER, &child_sjinfo,
+							 child_restrictlist);
+
+		/* Give up if some pair can't be joined without outside parameters */
+		if (child_joinrel->pathlist == NIL)
+			return;
+		set_cheapest(child_joinrel);
+		if (!bms_is_empty(PATH_REQ_OUTER(child_joinrel->cheapest_total_path)))
+			return;
+
+		subpaths = lappend(subpaths, child_joinrel->cheapest_total_path);
+	}
+
+	if (subpaths != NIL)
+		add_path(joinrel, (Path *) create_append_path(joinrel, subpaths, NULL));
+}
+
+/*
+ * have_partkey_equi_join
+ *	  Do the join clauses equate the partition keys of the two relations?
+ *
+ * The clause's operator must be the equality operator of the partition
+ * key's operator family, so that equal keys are routed to partitions with
+ * the same bounds.
+ */
+static bool
+have_partkey_equi_join(List *restrictlist,
+					   RelOptInfo *rel1, PartitionKey key1,
+					   RelOptInfo *rel2, PartitionKey key2)
+{
+	ListCell   *lc;
+
+	foreach(lc, restrictlist)
+	{
+		RestrictInfo *rinfo = (RestrictInfo *) lfirst(lc);
+		OpExpr	   *opexpr;
+		Var		   *left;
+		Var		   *right;
+
+		if (!rinfo->can_join || rinfo->pseudoconstant ||
+			!list_member_oid(rinfo->mergeopfamilies, key1->partopfamily))
+			continue;
+
+		opexpr = (OpExpr *) rinfo->clause;
+		if (!is_opclause(opexpr) || list_length(opexpr->args) != 2)
+			continue;
+
+		left = (Var *) strip_implicit_coercions(linitial(opexpr->args));
+		right = (Var *) strip_implicit_coercions(lsecond(opexpr->args));
+		if (!IsA(left, Var) || !IsA(right, Var) ||
+			left->varlevelsup != 0 || right->varlevelsup != 0)
+			continue;
+
+		if (left->varno == rel1->relid && left->varattno == key1->partattnum &&
+			right->varno == rel2->relid && right->varattno == key2->partattnum)
+			return true;
+		if (left->varno == rel2->relid && left->varattno == key2->partattnum &&
+			right->varno == rel1->relid && right->varattno == key1->partattnum)
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * get_partition_member_rels
+ *	  Get the member relations of a partitioned table's appendrel, indexed
+ *	  by their position in the table's PartitionDesc.
+ *
+ * Partitions that were pruned have no member, and are NULL in the result.
+ * The member for the parent table itself is left out; a partitioned table
+ * never stores rows of its own.
+ */
+static RelOptInfo **
+get_partition_member_rels(PlannerInfo *root, RelOptInfo *rel,
+						  PartitionDesc pdesc)
+{
+	RelOptInfo **result;
+	PartitionOidIndex *map;
+	ListCell   *lc;
+	int			i;
+
+	result = (RelOptInfo **) palloc0(Max(pdesc->nparts, 1) *
+									 sizeof(RelOptInfo *));
+	if (pdesc->nparts == 0)
+		return result;
+
+	map = (PartitionOidIndex *) palloc(pdesc->nparts *
+									   sizeof(PartitionOidIndex));
+	for (i = 0; i < pdesc->nparts; i++)
+	{
+		map[i].oid = pdesc->oids[i];
+		map[i].index = i;
+	}
+	qsort(map, pdesc->nparts, sizeof(PartitionOidIndex),
+		  partition_oid_index_cmp);
+
+	foreach(lc, root->append_rel_list)
+	{
+		AppendRelInfo *appinfo = (AppendRelInfo *) lfirst(lc);
+		PartitionOidIndex key;
+		PartitionOidIndex *entry;
+
+		if (appinfo->parent_relid != rel->relid)
+			continue;
+
+		key.oid = planner_rt_fetch(appinfo->child_relid, root)->relid;
+		entry = (PartitionOidIndex *) bsearch(&key, map, pdesc->nparts,
+											  sizeof(PartitionOidIndex),
+											  partition_oid_index_cmp);
+		if (entry != NULL)
+			result[entry->index] = find_base_rel(root, appinfo->child_relid);
+	}
+
+	pfree(map);
+
+	return result;
+}
+
+static int
+partition_oid_index_cmp(const void *a, const void *b)
+{
+	Oid			oa = ((const PartitionOidIndex *) a)->oid;
+	Oid			ob = ((const PartitionOidIndex *) b)->oid;
+
+	if (oa < ob)
+		return -1;
+	if (oa > ob)
+		return 1;
+	return 0;
+}
+
 
 /*
  * have_join_order_restriction
@@ -22,6 +22,7 @@
 #include "nodes/nodeFuncs.h"
 #include "nodes/plannodes.h"
 #include "optimizer/clauses.h"
+#include "optimizer/cost.h"
 #include "optimizer/pathnode.h"
 #include "optimizer/paths.h"
 #include "optimizer/tlist.h"
@@ -330,6 +331,31 @@ pathkeys_contained_in(List *keys1, List *keys2)
 	return false;
 }
 
+/*
+ * pathkeys_common
+ *	  Returns the number of leading pathkeys that keys1 and keys2 have in
+ *	  common.  If the result equals the length of keys1, keys2 is at least
+ *	  as well sorted as keys1; a smaller nonzero result means that data
+ *	  sorted by keys2 is sorted by a prefix of keys1, which is what an
+ *	  incremental sort can take advantage of.
+ */
+int
+pathkeys_common(List *keys1, List *keys2)
+{
+	int			n = 0;
+	ListCell   *key1,
+			   *key2;
+
+	/* As in compare_pathkeys, canonical pathkeys compare by pointer */
+	forboth(key1, keys1, key2, keys2)
+	{
+		if (lfirst(key1) != lfirst(key2))
+			break;
+		n++;
+	}
+	return n;
+}
+
 /*
  * get_cheapest_path_for_pathkeys
  *	  Find the cheapest path (according to the specified criterion) that
@@ -1450,9 +1476,9 @@ right_merge_direction(PlannerInfo *root, PathKey *pathkey)
  *		Count the number of pathkeys that are useful for meeting the
  *		query's requested output ordering.
  *
- * Unlike merge pathkeys, this is an all-or-nothing affair: it does us
- * no good to order by just the first key(s) of the requested ordering.
- * So the result is always either 0 or list_length(root->query_pathkeys).
+ * Ordering by just the first key(s) of the requested ordering does us good
+ * only if an incremental sort can finish the job; so unless that's enabled,
+ * the result is always either 0 or list_length(root->query_pathkeys).
  */
 static int
 pathkeys_useful_for_ordering(PlannerInfo *root, List *pathkeys)
@@ -1469,6 +1495,9 @@ pathkeys_useful_for_ordering(PlannerInfo *root, List *pathkeys)
 		return list_length(root->query_pathkeys);
 	}
 
+	if (enable_incrementalsort)
+		return pathkeys_common(root->query_pathkeys, pathkeys);
+
 	return 0;					/* path ordering not useful */
 }
 
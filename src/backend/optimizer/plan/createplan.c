@@ -19,7 +19,9 @@
 #include <limits.h>
 #include <math.h>
 
+#include "access/heapam.h"
 #include "access/skey.h"
+#include "catalog/partition.h"
 #include "catalog/pg_class.h"
 #include "foreign/fdwapi.h"
 #include "miscadmin.h"
@@ -50,6 +52,8 @@ static void disuse_physical_tlist(PlannerInfo *root, Plan *plan, Path *path);
 static Plan *create_gating_plan(PlannerInfo *root, Plan *plan, List *quals);
 static Plan *create_join_plan(PlannerInfo *root, JoinPath *best_path);
 static Plan *create_append_plan(PlannerInfo *root, AppendPath *best_path);
+static void set_append_partition_pruning(PlannerInfo *root,
+							 AppendPath *best_path, Append *plan);
 static Plan *create_merge_append_plan(PlannerInfo *root, MergeAppendPath *best_path);
 static Result *create_result_plan(PlannerInfo *root, ResultPath *best_path);
 static Material *create_material_plan(PlannerInfo *root, MaterialPath *best_path);
@@ -98,15 +102,16 @@ static SeqScan *make_seqscan(List *qptlist, List *qpqual, Index scanrelid);
 static IndexScan *make_indexscan(List *qptlist, List *qpqual, Index scanrelid,
 			   Oid indexid, List *indexqual, List *indexqualorig,
 			   List *indexorderby, List *indexorderbyorig,
-			   ScanDirection indexscandir);
+			   ScanDirection indexscandir, bool indexskipscan);
 static IndexOnlyScan *make_indexonlyscan(List *qptlist, List *qpqual,
 				   Index scanrelid, Oid indexid,
 				   List *indexqual, List *indexorderby,
 				   List *indextlist,
-				   ScanDirection indexscandir);
+				   ScanDirection indexscandir, bool indexskipscan);
 static BitmapIndexScan *make_bitmap_indexscan(Index scanrelid, Oid indexid,
 					  List *indexqual,
-					  List *indexqualorig);
+					  List *indexqualorig,
+					  bool indexskipscan);
 static BitmapHeapScan *make_bitmap_heapscan(List *qptlist,
 					 List *qpqual,
 					 Plan *lefttree,
@@ -717,9 +722,65 @@ create_append_plan(PlannerInfo *root, AppendPath *best_path)
 
 	plan = make_append(subplans, tlist);
 
+	/* Set up run-time pruning, if the Append scans partitions */
+	set_append_partition_pruning(root, best_path, plan);
+
 	return (Plan *) plan;
 }
 
+/*
+ * set_append_partition_pruning
+ *	  If an Append scans the partitions of a partitioned table, and some of
+ *	  the table's restrictions compare the partition key with external
+ *	  Params, save them so that the executor can prune partitions once the
+ *	  values of the Params are known.
+ *
+ * Restrictions with constants have already pruned partitions while the
+ * appendrel was expanded.
+ */
+static void
+set_append_partition_pruning(PlannerInfo *root, AppendPath *best_path,
+							 Append *plan)
+{
+	RelOptInfo *rel = best_path->path.parent;
+	RangeTblEntry *rte;
+	Relation	parent;
+	List	   *paramclauses = NIL;
+	ListCell   *subpaths;
+
+	if (rel->reloptkind != RELOPT_BASEREL || rel->baserestrictinfo == NIL)
+		return;
+	rte = planner_rt_fetch(rel->relid, root);
+	if (rte->rtekind != RTE_RELATION || !relation_is_partitioned(rte->relid))
+		return;
+
+	parent = heap_open(rte->relid, NoLock);
+	(void) get_matching_partitions(RelationGetPartitionKey(parent),
+								   RelationGetPartitionDesc(parent),
+								   rel->relid,
+								   extract_actual_clauses(rel->baserestrictinfo,
+														  false),
+								   &paramclauses);
+	heap_close(parent, NoLock);
+
+	if (paramclauses == NIL)
+		return;
+
+	plan->partrelid = rte->relid;
+	plan->partrti = rel->relid;
+	plan->partpruneclauses = paramclauses;
+	foreach(subpaths, best_path->subpaths)
+	{
+		RelOptInfo *childrel = ((Path *) lfirst(subpaths))->parent;
+		Oid			childOID = planner_rt_fetch(childrel->relid, root)->relid;
+
+		/* The parent's own (empty) scan can't be pruned */
+		plan->partoids = lappend_oid(plan->partoids,
+									 childOID == rte->relid ?
+									 InvalidOid : childOID);
+	}
+}
+
 /*
  * create_merge_append_plan
  *	  Create a MergeAppend plan for 'best_path' and (recursively) plans
@@ -1261,7 +1322,8 @@ create_indexscan_plan(PlannerInfo *root,
 												fixed_indexquals,
 												fixed_indexorderbys,
 											best_path->indexinfo->indextlist,
-												best_path->indexscandir);
+												best_path->indexscandir,
+												best_path->indexskipscan);
 	else
 		scan_plan = (Scan *) make_indexscan(tlist,
 											qpqual,
@@ -1271,7 +1333,8 @@ create_indexscan_plan(PlannerInfo *root,
 											stripped_indexquals,
 											fixed_indexorderbys,
 											indexorderbys,
-											best_path->indexscandir);
+											best_path->indexscandir,
+											best_path->indexskipscan);
 
 	copy_path_costsize(&scan_plan->plan, &best_path->path);
 
@@ -1556,7 +1619,8 @@ create_bitmap_subplan(PlannerInfo *root, Path *bitmapqual,
 		plan = (Plan *) make_bitmap_indexscan(iscan->scan.scanrelid,
 											  iscan->indexid,
 											  iscan->indexqual,
-											  iscan->indexqualorig);
+											  iscan->indexqualorig,
+											  iscan->indexskipscan);
 		plan->startup_cost = 0.0;
 		plan->total_cost = ipath->indextotalcost;
 		plan->plan_rows =
@@ -3235,7 +3299,8 @@ make_indexscan(List *qptlist,
 			   List *indexqualorig,
 			   List *indexorderby,
 			   List *indexorderbyorig,
-			   ScanDirection indexscandir)
+			   ScanDirection indexscandir,
+			   bool indexskipscan)
 {
 	IndexScan  *node = makeNode(IndexScan);
 	Plan	   *plan = &node->scan.plan;
@@ -3252,6 +3317,7 @@ make_indexscan(List *qptlist,
 	node->indexorderby = indexorderby;
 	node->indexorderbyorig = indexorderbyorig;
 	node->indexorderdir = indexscandir;
+	node->indexskipscan = indexskipscan;
 
 	return node;
 }
@@ -3264,7 +3330,8 @@ make_indexonlyscan(List *qptlist,
 				   List *indexqual,
 				   List *indexorderby,
 				   List *indextlist,
-				   ScanDirection indexscandir)
+				   ScanDirection indexscandir,
+				   bool indexskipscan)
 {
 	IndexOnlyScan *node = makeNode(IndexOnlyScan);
 	Plan	   *plan = &node->scan.plan;
@@ -3280,6 +3347,7 @@ make_indexonlyscan(List *qptlist,
 	node->indexorderby = indexorderby;
 	node->indextlist = indextlist;
 	node->indexorderdir = indexscandir;
+	node->indexskipscan = indexskipscan;
 
 	return node;
 }
@@ -3288,7 +3356,8 @@ static BitmapIndexScan *
 make_bitmap_indexscan(Index scanrelid,
 					  Oid indexid,
 					  List *indexqual,
-					  List *indexqualorig)
+					  List *indexqualorig,
+					  bool indexskipscan)
 {
 	BitmapIndexScan *node = makeNode(BitmapIndexScan);
 	Plan	   *plan = &node->scan.plan;
@@ -3302,6 +3371,7 @@ make_bitmap_indexscan(Index scanrelid,
 	node->indexid = indexid;
 	node->indexqual = indexqual;
 	node->indexqualorig = indexqualorig;
+	node->indexskipscan = indexskipscan;
 
 	return node;
 }
@@ -4112,6 +4182,64 @@ make_sort_from_pathkeys(PlannerInfo *root, Plan *lefttree, List *pathkeys,
 					 nullsFirst, limit_tuples);
 }
 
+/*
+ * make_incrementalsort_from_pathkeys
+ *	  Create an incremental sort plan to sort according to given pathkeys,
+ *	  when the input is already sorted by the first 'presortedCols' of them
+ *
+ *	  'lefttree' is the node which yields input tuples
+ *	  'pathkeys' is the list of pathkeys by which the result is to be sorted
+ *	  'presortedCols' is the number of leading pathkeys lefttree is sorted by
+ */
+IncrementalSort *
+make_incrementalsort_from_pathkeys(PlannerInfo *root, Plan *lefttree,
+								   List *pathkeys, int presortedCols)
+{
+	IncrementalSort *node = makeNode(IncrementalSort);
+	Plan	   *plan = &node->sort.plan;
+	Path		sort_path;		/* dummy for result of cost_incremental_sort */
+	int			numsortkeys;
+	AttrNumber *sortColIdx;
+	Oid		   *sortOperators;
+	Oid		   *collations;
+	bool	   *nullsFirst;
+
+	/* Compute sort column info, and adjust lefttree as needed */
+	lefttree = prepare_sort_from_pathkeys(root, lefttree, pathkeys,
+										  NULL,
+										  NULL,
+										  false,
+										  &numsortkeys,
+										  &sortColIdx,
+										  &sortOperators,
+										  &collations,
+										  &nullsFirst);
+	Assert(presortedCols > 0 && presortedCols < numsortkeys);
+
+	copy_plan_costsize(plan, lefttree); /* only care about copying size */
+	cost_incremental_sort(&sort_path, root, pathkeys, presortedCols,
+						  lefttree->startup_cost,
+						  lefttree->total_cost,
+						  lefttree->plan_rows,
+						  lefttree->plan_width,
+						  0.0,
+						  work_mem);
+	plan->startup_cost = sort_path.startup_cost;
+	plan->total_cost = sort_path.total_cost;
+	plan->targetlist = lefttree->targetlist;
+	plan->qual = NIL;
+	plan->lefttree = lefttree;
+	plan->righttree = NULL;
+	node->sort.numCols = numsortkeys;
+	node->sort.sortColIdx = sortColIdx;
+	node->sort.sortOperators = sortOperators;
+	node->sort.collations = collations;
+	node->sort.nullsFirst = nullsFirst;
+	node->presortedCols = presortedCols;
+
+	return node;
+}
+
 /*
  * make_sort_from_sortclauses
  *	  Create sort plan to sort according to given sortclauses
@@ -4836,6 +4964,7 @@ is_projection_capable_plan(Plan *plan)
 		case T_Hash:
 		case T_Material:
 		case T_Sort:
+		case T_IncrementalSort:
 		case T_Unique:
 		case T_SetOp:
 		case T_LockRows:
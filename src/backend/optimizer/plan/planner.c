@@ -17,11 +17,16 @@
 
 #include <limits.h>
 
+#include "access/heapam.h"
 #include "access/htup_details.h"
+#include "access/skey.h"
+#include "catalog/partition.h"
+#include "catalog/pg_type.h"
 #include "executor/executor.h"
 #include "executor/nodeAgg.h"
 #include "miscadmin.h"
 #include "nodes/makefuncs.h"
+#include "nodes/nodeFuncs.h"
 #ifdef OPTIMIZER_DEBUG
 #include "nodes/print.h"
 #endif
@@ -38,6 +43,7 @@
 #include "parser/analyze.h"
 #include "parser/parsetree.h"
 #include "rewrite/rewriteManip.h"
+#include "utils/lsyscache.h"
 #include "utils/rel.h"
 #include "utils/selfuncs.h"
 
@@ -91,6 +97,10 @@ static bool choose_hashed_distinct(PlannerInfo *root,
 					   Cost sorted_startup_cost, Cost sorted_total_cost,
 					   List *sorted_pathkeys,
 					   double dNumDistinctRows);
+static Path *choose_partially_sorted_path(PlannerInfo *root,
+							RelOptInfo *final_rel, double tuple_fraction,
+							double path_rows, int path_width,
+							Path *cheapest_path, Path *sorted_path);
 static List *make_subplanTargetList(PlannerInfo *root, List *tlist,
 					   AttrNumber **groupColIdx, bool *need_tlist_eval);
 static int	get_grouping_column_index(Query *parse, TargetEntry *tle);
@@ -99,6 +109,10 @@ static void locate_grouping_columns(PlannerInfo *root,
 						List *sub_tlist,
 						AttrNumber *groupColIdx);
 static List *postprocess_setop_tlist(List *new_tlist, List *orig_tlist);
+static Plan *limit_union_all_branches(PlannerInfo *root, Append *append,
+						 List *tlist, double limit_tuples);
+static Plan *push_agg_into_partitions(PlannerInfo *root, Agg *agg,
+						 const AggClauseCosts *agg_costs);
 static List *select_active_windows(PlannerInfo *root, WindowFuncLists *wflists);
 static List *make_windowInputTargetList(PlannerInfo *root,
 						   List *tlist, List *activeWindows);
@@ -1128,6 +1142,16 @@ grouping_planner(PlannerInfo *root, double tuple_fraction)
 		root->sort_pathkeys = make_pathkeys_for_sortclauses(root,
 															parse->sortClause,
 															tlist);
+
+		/*
+		 * With ORDER BY and a known LIMIT, a UNION ALL branch can't
+		 * contribute more than limit_tuples rows to the result, so let each
+		 * branch sort its own rows and stop after that many.
+		 */
+		if (parse->sortClause && limit_tuples > 0 && IsA(result_plan, Append))
+			result_plan = limit_union_all_branches(root,
+												   (Append *) result_plan,
+												   tlist, limit_tuples);
 	}
 	else
 	{
@@ -1391,6 +1415,23 @@ grouping_planner(PlannerInfo *root, double tuple_fraction)
 			}
 		}
 
+		/*
+		 * If the ORDER BY sort will be applied directly to the scan/join
+		 * output, a path sorted by just a prefix of the requested pathkeys
+		 * might beat both of the above once an incremental sort is put on
+		 * top of it.
+		 */
+		if (enable_incrementalsort && root->query_pathkeys != NIL &&
+			!parse->groupClause && !parse->hasAggs &&
+			!root->hasHavingQual && !activeWindows &&
+			!parse->distinctClause)
+			sorted_path = choose_partially_sorted_path(root, final_rel,
+													   tuple_fraction,
+													   path_rows,
+													   path_width,
+													   cheapest_path,
+													   sorted_path);
+
 		/*
 		 * Consider whether we want to use hashing instead of sorting.
 		 */
@@ -1548,6 +1589,18 @@ grouping_planner(PlannerInfo *root, double tuple_fraction)
 									extract_grouping_ops(parse->groupClause),
 												numGroups,
 												result_plan);
+
+				/* Maybe aggregate each partition separately instead */
+				if (enable_partitionwise_aggregate)
+				{
+					Plan	   *pushed_plan;
+
+					pushed_plan = push_agg_into_partitions(root,
+														   (Agg *) result_plan,
+														   &agg_costs);
+					if (pushed_plan != NULL)
+						result_plan = pushed_plan;
+				}
 				/* Hashed aggregation produces randomly-ordered results */
 				current_pathkeys = NIL;
 			}
@@ -1906,10 +1959,46 @@ grouping_planner(PlannerInfo *root, double tuple_fraction)
 	{
 		if (!pathkeys_contained_in(root->sort_pathkeys, current_pathkeys))
 		{
-			result_plan = (Plan *) make_sort_from_pathkeys(root,
-														   result_plan,
+			int			presorted = pathkeys_common(root->sort_pathkeys,
+													current_pathkeys);
+			bool		use_incremental = false;
+
+			/*
+			 * If the plan is already sorted by a prefix of the ORDER BY
+			 * keys, an incremental sort may be cheaper than a full one.
+			 */
+			if (presorted > 0 && enable_incrementalsort)
+			{
+				Path		sort_p;		/* dummy for result of cost_sort */
+				Path		incsort_p;	/* and of cost_incremental_sort */
+
+				cost_sort(&sort_p, root, root->sort_pathkeys,
+						  result_plan->total_cost,
+						  result_plan->plan_rows, result_plan->plan_width,
+						  0.0, work_mem, limit_tuples);
+				cost_incremental_sort(&incsort_p, root, root->sort_pathkeys,
+									  presorted,
+									  result_plan->startup_cost,
+									  result_plan->total_cost,
+									  result_plan->plan_rows,
+									  result_plan->plan_width,
+									  0.0, work_mem);
+				use_incremental =
+					compare_fractional_path_costs(&incsort_p, &sort_p,
+												  tuple_fraction) < 0;
+			}
+
+			if (use_incremental)
+				result_plan = (Plan *)
+					make_incrementalsort_from_pathkeys(root,
+													   result_plan,
+													   root->sort_pathkeys,
+													   presorted);
+			else
+				result_plan = (Plan *) make_sort_from_pathkeys(root,
+															   result_plan,
 														 root->sort_pathkeys,
-														   limit_tuples);
+															   limit_tuples);
 			current_pathkeys = root->sort_pathkeys;
 		}
 	}
@@ -2938,6 +3027,73 @@ choose_hashed_distinct(PlannerInfo *root,
 	return false;
 }
 
+/*
+ * choose_partially_sorted_path - look for a path that is sorted by a prefix
+ *		of query_pathkeys and would win with an incremental sort on top
+ *
+ * This is only meaningful when the final ORDER BY sort is applied directly
+ * to the scan/join output.  'sorted_path' is the presorted path chosen so
+ * far, or NULL if sorting the cheapest-total path is preferred.  We return
+ * the path to use in place of sorted_path; that is either sorted_path itself
+ * or a partially sorted path, for which grouping_planner's final sort step
+ * will then produce an IncrementalSort.
+ */
+static Path *
+choose_partially_sorted_path(PlannerInfo *root, RelOptInfo *final_rel,
+							 double tuple_fraction,
+							 double path_rows, int path_width,
+							 Path *cheapest_path, Path *sorted_path)
+{
+	Path		best_p;			/* costs of the best choice so far */
+	Path	   *result = sorted_path;
+	int			nkeys = list_length(root->query_pathkeys);
+	ListCell   *l;
+
+	if (sorted_path)
+	{
+		best_p.startup_cost = sorted_path->startup_cost;
+		best_p.total_cost = sorted_path->total_cost;
+	}
+	else if (pathkeys_contained_in(root->query_pathkeys,
+								   cheapest_path->pathkeys))
+		return NULL;			/* nothing to sort at all */
+	else
+		cost_sort(&best_p, root, root->query_pathkeys,
+				  cheapest_path->total_cost,
+				  path_rows, path_width,
+				  0.0, work_mem, root->limit_tuples);
+
+	foreach(l, final_rel->pathlist)
+	{
+		Path	   *path = (Path *) lfirst(l);
+		Path		incsort_p;	/* dummy for result of cost_incremental_sort */
+		int			presorted;
+
+		if (PATH_REQ_OUTER(path) != NULL)
+			continue;
+
+		presorted = pathkeys_common(root->query_pathkeys, path->pathkeys);
+		if (presorted == 0 || presorted >= nkeys)
+			continue;
+
+		cost_incremental_sort(&incsort_p, root, root->query_pathkeys,
+							  presorted,
+							  path->startup_cost, path->total_cost,
+							  path_rows, path_width,
+							  0.0, work_mem);
+
+		if (compare_fractional_path_costs(&incsort_p, &best_p,
+										  tuple_fraction) < 0)
+		{
+			result = path;
+			best_p.startup_cost = incsort_p.startup_cost;
+			best_p.total_cost = incsort_p.total_cost;
+		}
+	}
+
+	return result;
+}
+
 /*
  * make_subplanTargetList
  *	  Generate appropriate target list when grouping is required.
@@ -3183,6 +3339,226 @@ locate_grouping_columns(PlannerInfo *root,
 	}
 }
 
+/*
+ * limit_union_all_branches
+ *	  Put a Sort and Limit atop each branch of a UNION ALL that may return
+ *	  more than limit_tuples rows, for a query with ORDER BY and LIMIT.
+ *
+ * The final Sort and Limit still have to be applied to the Append's output.
+ * At execution time, the Limit nodes pass their bound down to the branch
+ * Sorts, which then need to keep only the top limit_tuples rows.
+ *
+ * 'tlist' is the setop result tlist carrying the ORDER BY sortgroupref
+ * markings; the branch outputs have the same column numbering.
+ */
+static Plan *
+limit_union_all_branches(PlannerInfo *root, Append *append,
+						 List *tlist, double limit_tuples)
+{
+	Query	   *parse = root->parse;
+	int			numsortkeys = list_length(parse->sortClause);
+	AttrNumber *sortColIdx;
+	List	   *newplans = NIL;
+	bool		changed = false;
+	int			i;
+	ListCell   *l;
+
+	sortColIdx = (AttrNumber *) palloc(numsortkeys * sizeof(AttrNumber));
+	i = 0;
+	foreach(l, parse->sortClause)
+	{
+		SortGroupClause *sortcl = (SortGroupClause *) lfirst(l);
+
+		sortColIdx[i++] = get_sortgroupclause_tle(sortcl, tlist)->resno;
+	}
+
+	foreach(l, append->appendplans)
+	{
+		Plan	   *subplan = (Plan *) lfirst(l);
+
+		if (subplan->plan_rows > limit_tuples)
+		{
+			Node	   *count;
+
+			subplan = (Plan *) make_sort_from_groupcols(root,
+														parse->sortClause,
+														sortColIdx,
+														subplan);
+			count = (Node *) makeConst(INT8OID, -1, InvalidOid,
+									   sizeof(int64),
+									   Int64GetDatum((int64) limit_tuples),
+									   false, FLOAT8PASSBYVAL);
+			subplan = (Plan *) make_limit(subplan, NULL, count,
+										  0, (int64) limit_tuples);
+			changed = true;
+		}
+		newplans = lappend(newplans, subplan);
+	}
+
+	if (!changed)
+		return (Plan *) append;
+
+	return (Plan *) make_append(newplans, append->plan.targetlist);
+}
+
+/*
+ * push_agg_into_partitions
+ *	  Try to move a hashed Agg below the Append that scans the partitions of
+ *	  a partitioned table, so that each partition is aggregated separately.
+ *
+ * This is correct when the grouping columns include the partition key,
+ * compared with an equality operator of the key's operator family: all the
+ * rows of a group then come from the same partition, and the groups computed
+ * for each partition are final, so HAVING can be checked there too.  Each
+ * hash table only has to hold the groups of one partition, which makes it
+ * much more likely to fit in work_mem.
+ *
+ * Returns the new Append, or NULL if the Agg can't be moved.
+ */
+static Plan *
+push_agg_into_partitions(PlannerInfo *root, Agg *agg,
+						 const AggClauseCosts *agg_costs)
+{
+	Plan	   *input = agg->plan.lefttree;
+	List	   *sub_tlist = input->targetlist;
+	Append	   *append;
+	Append	   *newappend;
+	Index		parent_relid = 0;
+	RangeTblEntry *rte;
+	Relation	parent;
+	PartitionKey key;
+	bool		grouped_by_key = false;
+	List	   *appinfos = NIL;
+	List	   *newplans = NIL;
+	ListCell   *l;
+	ListCell   *lc;
+	int			i;
+
+	/* There may be a Result computing the grouping columns */
+	if (IsA(input, Result))
+	{
+		if (((Result *) input)->resconstantqual != NULL ||
+			input->qual != NIL)
+			return NULL;
+		input = input->lefttree;
+	}
+	if (input == NULL || !IsA(input, Append))
+		return NULL;
+	append = (Append *) input;
+
+	if (contain_subplans((Node *) agg->plan.targetlist) ||
+		contain_subplans((Node *) agg->plan.qual) ||
+		contain_subplans((Node *) sub_tlist))
+		return NULL;
+
+	/* Each subplan must be a plain scan of a member of the same appendrel */
+	foreach(l, append->appendplans)
+	{
+		Plan	   *subplan = (Plan *) lfirst(l);
+		AppendRelInfo *appinfo = NULL;
+
+		switch (nodeTag(subplan))
+		{
+			case T_SeqScan:
+			case T_IndexScan:
+			case T_IndexOnlyScan:
+			case T_BitmapHeapScan:
+			case T_TidScan:
+				break;
+			default:
+				return NULL;
+		}
+
+		foreach(lc, root->append_rel_list)
+		{
+			appinfo = (AppendRelInfo *) lfirst(lc);
+			if (appinfo->child_relid == ((Scan *) subplan)->scanrelid)
+				break;
+			appinfo = NULL;
+		}
+		if (appinfo == NULL ||
+			(parent_relid != 0 && appinfo->parent_relid != parent_relid))
+			return NULL;
+		parent_relid = appinfo->parent_relid;
+		appinfos = lappend(appinfos, appinfo);
+	}
+	if (parent_relid == 0)
+		return NULL;
+
+	rte = planner_rt_fetch(parent_relid, root);
+	if (rte->rtekind != RTE_RELATION || !relation_is_partitioned(rte->relid))
+		return NULL;
+
+	parent = heap_open(rte->relid, NoLock);
+	key = RelationGetPartitionKey(parent);
+	for (i = 0; i < agg->numCols; i++)
+	{
+		TargetEntry *tle = get_tle_by_resno(sub_tlist, agg->grpColIdx[i]);
+		Var		   *var;
+
+		if (tle == NULL)
+			continue;
+		var = (Var *) strip_implicit_coercions((Node *) tle->expr);
+		if (IsA(var, Var) &&
+			var->varno == parent_relid &&
+			var->varlevelsup == 0 &&
+			var->varattno == key->partattnum &&
+			get_op_opfamily_strategy(agg->grpOperators[i],
+									 key->partopfamily) == BTEqualStrategyNumber)
+		{
+			grouped_by_key = true;
+			break;
+		}
+	}
+	heap_close(parent, NoLock);
+
+	if (!grouped_by_key)
+		return NULL;
+
+	forboth(l, append->appendplans, lc, appinfos)
+	{
+		Plan	   *subplan = (Plan *) lfirst(l);
+		AppendRelInfo *appinfo = (AppendRelInfo *) lfirst(lc);
+		List	   *child_sub_tlist;
+		double		numGroups;
+
+		child_sub_tlist = (List *)
+			adjust_appendrel_attrs(root, (Node *) sub_tlist, appinfo);
+		subplan->targetlist = child_sub_tlist;
+		add_tlist_costs_to_plan(root, subplan, child_sub_tlist);
+
+		/* Assume the groups are spread over the partitions like the rows */
+		numGroups = agg->numGroups;
+		if (append->plan.plan_rows > 0)
+			numGroups *= subplan->plan_rows / append->plan.plan_rows;
+		numGroups = clamp_row_est(numGroups);
+
+		subplan = (Plan *) make_agg(root,
+									(List *) adjust_appendrel_attrs(root,
+										  (Node *) agg->plan.targetlist,
+																	appinfo),
+									(List *) adjust_appendrel_attrs(root,
+												 (Node *) agg->plan.qual,
+																	appinfo),
+									AGG_HASHED,
+									agg_costs,
+									agg->numCols,
+									agg->grpColIdx,
+									agg->grpOperators,
+									(long) numGroups,
+									subplan);
+		newplans = lappend(newplans, subplan);
+	}
+
+	newappend = make_append(newplans, agg->plan.targetlist);
+	newappend->partrelid = append->partrelid;
+	newappend->partrti = append->partrti;
+	newappend->partpruneclauses = append->partpruneclauses;
+	newappend->partoids = append->partoids;
+
+	return (Plan *) newappend;
+}
+
 /*
  * postprocess_setop_tlist
  *	  Fix up targetlist returned by plan_set_operations().
@@ -3719,7 +4095,7 @@ plan_cluster_use_sort(Oid tableOid, Oid indexOid)
 	/* Estimate the cost of index scan */
 	indexScanPath = create_index_path(root, indexInfo,
 									  NIL, NIL, NIL, NIL, NIL,
-									  ForwardScanDirection, false,
+									  ForwardScanDirection, false, false,
 									  NULL, 1.0);
 
 	return (seqScanAndSortPath.total_cost < indexScanPath->path.total_cost);
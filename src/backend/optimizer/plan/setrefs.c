@@ -585,6 +585,7 @@ set_plan_refs(PlannerInfo *root, Plan *plan, int rtoffset)
 		case T_Hash:
 		case T_Material:
 		case T_Sort:
+		case T_IncrementalSort:
 		case T_Unique:
 		case T_SetOp:
 
@@ -780,6 +781,12 @@ set_plan_refs(PlannerInfo *root, Plan *plan, int rtoffset)
 											  (Plan *) lfirst(l),
 											  rtoffset);
 				}
+				if (OidIsValid(splan->partrelid))
+				{
+					splan->partrti += rtoffset;
+					splan->partpruneclauses =
+						fix_scan_list(root, splan->partpruneclauses, rtoffset);
+				}
 			}
 			break;
 		case T_MergeAppend:
@@ -33,11 +33,13 @@
 #include "access/heapam.h"
 #include "access/htup_details.h"
 #include "access/sysattr.h"
+#include "catalog/partition.h"
 #include "catalog/pg_inherits_fn.h"
 #include "catalog/pg_type.h"
 #include "miscadmin.h"
 #include "nodes/makefuncs.h"
 #include "nodes/nodeFuncs.h"
+#include "optimizer/clauses.h"
 #include "optimizer/cost.h"
 #include "optimizer/pathnode.h"
 #include "optimizer/planmain.h"
@@ -46,9 +48,11 @@
 #include "optimizer/tlist.h"
 #include "parser/parse_coerce.h"
 #include "parser/parsetree.h"
+#include "storage/lmgr.h"
 #include "utils/lsyscache.h"
 #include "utils/rel.h"
 #include "utils/selfuncs.h"
+#include "utils/syscache.h"
 
 
 typedef struct
@@ -100,6 +104,10 @@ static List *generate_append_tlist(List *colTypes, List *colCollations,
 static List *generate_setop_grouplist(SetOperationStmt *op, List *targetlist);
 static void expand_inherited_rtentry(PlannerInfo *root, RangeTblEntry *rte,
 						 Index rti);
+static List *find_matching_partitions(PlannerInfo *root, Oid parentOID,
+						 Index rti, LOCKMODE lockmode);
+static bool collect_rel_quals(Node *jtnode, Index rti, List **quals);
+static int	partition_oid_cmp(const void *p1, const void *p2);
 static void make_inh_translation_list(Relation oldrelation,
 						  Relation newrelation,
 						  Index newvarno,
@@ -1277,8 +1285,15 @@ expand_inherited_rtentry(PlannerInfo *root, RangeTblEntry *rte, Index rti)
 	else
 		lockmode = AccessShareLock;
 
-	/* Scan for all members of inheritance set, acquire needed locks */
-	inhOIDs = find_all_inheritors(parentOID, lockmode, NULL);
+	/*
+	 * Scan for all members of inheritance set, acquire needed locks.  For a
+	 * partitioned table, only the partitions that can contain rows satisfying
+	 * the query's restrictions are members.
+	 */
+	if (relation_is_partitioned(parentOID))
+		inhOIDs = find_matching_partitions(root, parentOID, rti, lockmode);
+	else
+		inhOIDs = find_all_inheritors(parentOID, lockmode, NULL);
 
 	/*
 	 * Check that there's at least one descendant, else treat as no-child
@@ -1417,6 +1432,139 @@ expand_inherited_rtentry(PlannerInfo *root, RangeTblEntry *rte, Index rti)
 	root->append_rel_list = list_concat(root->append_rel_list, appinfos);
 }
 
+/*
+ * find_matching_partitions
+ *		Find the partitions of a partitioned table that may contain rows
+ *		satisfying the query's restrictions on it, and lock them.
+ *
+ * The result is a list of OIDs starting with the parent's, like that of
+ * find_all_inheritors, with the partitions in bound order.
+ */
+static List *
+find_matching_partitions(PlannerInfo *root, Oid parentOID, Index rti,
+						 LOCKMODE lockmode)
+{
+	List	   *quals = NIL;
+	List	   *clauses = NIL;
+	Relation	parent;
+	Bitmapset  *parts;
+	Oid		   *oids;
+	Oid		   *lockoids;
+	int			noids = 0;
+	int			partidx;
+	List	   *result;
+	ListCell   *l;
+	int			i;
+
+	/*
+	 * Quals haven't been preprocessed yet, so simplify them here; this also
+	 * substitutes the values of any Params bound for a custom plan.
+	 */
+	(void) collect_rel_quals((Node *) root->parse->jointree, rti, &quals);
+	quals = (List *) eval_const_expressions(root,
+											(Node *) copyObject(quals));
+	foreach(l, quals)
+		clauses = list_concat(clauses, make_ands_implicit((Expr *) lfirst(l)));
+
+	/*
+	 * Copy out the OIDs of the partitions that remain, since locking them
+	 * can process invalidation messages that rebuild the parent's partition
+	 * descriptor.
+	 */
+	parent = heap_open(parentOID, NoLock);
+	parts = get_matching_partitions(RelationGetPartitionKey(parent),
+									RelationGetPartitionDesc(parent),
+									rti, clauses, NULL);
+	oids = (Oid *) palloc((bms_num_members(parts) + 1) * sizeof(Oid));
+	while ((partidx = bms_first_member(parts)) >= 0)
+		oids[noids++] = RelationGetPartitionDesc(parent)->oids[partidx];
+	heap_close(parent, NoLock);
+
+	/* Lock the partitions in OID order, like find_all_inheritors */
+	lockoids = (Oid *) palloc((noids + 1) * sizeof(Oid));
+	memcpy(lockoids, oids, noids * sizeof(Oid));
+	qsort(lockoids, noids, sizeof(Oid), partition_oid_cmp);
+	for (i = 0; i < noids; i++)
+		LockRelationOid(lockoids[i], lockmode);
+
+	result = list_make1_oid(parentOID);
+	for (i = 0; i < noids; i++)
+	{
+		/* Ignore a partition that got dropped before we locked it */
+		if (!SearchSysCacheExists1(RELOID, ObjectIdGetDatum(oids[i])))
+		{
+			UnlockRelationOid(oids[i], lockmode);
+			continue;
+		}
+		result = lappend_oid(result, oids[i]);
+	}
+
+	pfree(oids);
+	pfree(lockoids);
+
+	return result;
+}
+
+/*
+ * collect_rel_quals
+ *		Collect the quals in the join tree that must hold for all the rows
+ *		of relation rti that take part in the query's result.
+ *
+ * Those are the quals of FromExprs and inner joins above the relation.  An
+ * outer join's quals may leave rows of the relation unmatched but still in
+ * the result, so they're ignored.  Returns true if rti is within jtnode.
+ */
+static bool
+collect_rel_quals(Node *jtnode, Index rti, List **quals)
+{
+	bool		found = false;
+
+	if (jtnode == NULL)
+		return false;
+	if (IsA(jtnode, RangeTblRef))
+		return ((RangeTblRef *) jtnode)->rtindex == (int) rti;
+	else if (IsA(jtnode, FromExpr))
+	{
+		FromExpr   *f = (FromExpr *) jtnode;
+		ListCell   *l;
+
+		foreach(l, f->fromlist)
+		{
+			if (collect_rel_quals(lfirst(l), rti, quals))
+				found = true;
+		}
+		if (found && f->quals != NULL)
+			*quals = lappend(*quals, f->quals);
+	}
+	else if (IsA(jtnode, JoinExpr))
+	{
+		JoinExpr   *j = (JoinExpr *) jtnode;
+
+		found = (collect_rel_quals(j->larg, rti, quals) ||
+				 collect_rel_quals(j->rarg, rti, quals));
+		if (found && j->jointype == JOIN_INNER && j->quals != NULL)
+			*quals = lappend(*quals, j->quals);
+	}
+	else
+		elog(ERROR, "unrecognized node type: %d",
+			 (int) nodeTag(jtnode));
+
+	return found;
+}
+
+static int
+partition_oid_cmp(const void *p1, const void *p2)
+{
+	Oid			v1 = *((const Oid *) p1);
+	Oid			v2 = *((const Oid *) p2);
+
+	if (v1 < v2)
+		return -1;
+	if (v1 > v2)
+		return 1;
+	return 0;
+}
+
 /*
  * make_inh_translation_list
  *	  Build the list of translations from parent Vars to child Vars for
@@ -723,6 +723,7 @@ create_seqscan_path(PlannerInfo *root, RelOptInfo *rel, Relids required_outer)
  * 'indexscandir' is ForwardScanDirection or BackwardScanDirection
  *			for an ordered index, or NoMovementScanDirection for
  *			an unordered index.
+ * 'indexskipscan' is true if a skip scan is wanted.
  * 'indexonly' is true if an index-only scan is wanted.
  * 'required_outer' is the set of outer relids for a parameterized path.
  * 'loop_count' is the number of repetitions of the indexscan to factor into
@@ -739,6 +740,7 @@ create_index_path(PlannerInfo *root,
 				  List *indexorderbycols,
 				  List *pathkeys,
 				  ScanDirection indexscandir,
+				  bool indexskipscan,
 				  bool indexonly,
 				  Relids required_outer,
 				  double loop_count)
@@ -766,6 +768,7 @@ create_index_path(PlannerInfo *root,
 	pathnode->indexorderbys = indexorderbys;
 	pathnode->indexorderbycols = indexorderbycols;
 	pathnode->indexscandir = indexscandir;
+	pathnode->indexskipscan = indexskipscan;
 
 	cost_index(pathnode, root, loop_count);
 
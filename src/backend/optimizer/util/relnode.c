@@ -19,6 +19,7 @@
 #include "optimizer/paths.h"
 #include "optimizer/placeholder.h"
 #include "optimizer/plancat.h"
+#include "optimizer/prep.h"
 #include "optimizer/restrictinfo.h"
 #include "utils/hsearch.h"
 
@@ -463,6 +464,96 @@ build_join_rel(PlannerInfo *root,
 	return joinrel;
 }
 
+/*
+ * build_child_join_rel
+ *	  Builds the relation entry for the join of two appendrel members, for
+ *	  use in a partition-wise join of their parents.
+ *
+ * 'parent_joinrel' is the join of the two members' parent relations, and
+ * 'restrictlist' is the list of join clauses of that parent join.  The
+ * child joinrel gets the parent's targetlist and join clauses, translated
+ * to refer to the members; *restrictlist_ptr receives the translated
+ * clauses.
+ *
+ * Unlike build_join_rel, the result isn't added to the query's list of
+ * joinrels, since it is only ever used below an Append built for the
+ * parent joinrel.
+ */
+RelOptInfo *
+build_child_join_rel(PlannerInfo *root,
+					 RelOptInfo *parent_joinrel,
+					 RelOptInfo *outer_rel,
+					 RelOptInfo *inner_rel,
+					 SpecialJoinInfo *sjinfo,
+					 List *restrictlist,
+					 List **restrictlist_ptr)
+{
+	AppendRelInfo *outer_appinfo = find_childrel_appendrelinfo(root, outer_rel);
+	AppendRelInfo *inner_appinfo = find_childrel_appendrelinfo(root, inner_rel);
+	RelOptInfo *joinrel;
+
+	joinrel = makeNode(RelOptInfo);
+	joinrel->reloptkind = RELOPT_JOINREL;
+	joinrel->relids = bms_union(outer_rel->relids, inner_rel->relids);
+	joinrel->rows = 0;
+	joinrel->width = parent_joinrel->width;
+	joinrel->consider_startup = parent_joinrel->consider_startup;
+	joinrel->reltargetlist = NIL;
+	joinrel->pathlist = NIL;
+	joinrel->ppilist = NIL;
+	joinrel->cheapest_startup_path = NULL;
+	joinrel->cheapest_total_path = NULL;
+	joinrel->cheapest_unique_path = NULL;
+	joinrel->cheapest_parameterized_paths = NIL;
+	joinrel->relid = 0;			/* indicates not a baserel */
+	joinrel->rtekind = RTE_JOIN;
+	joinrel->min_attr = 0;
+	joinrel->max_attr = 0;
+	joinrel->attr_needed = NULL;
+	joinrel->attr_widths = NULL;
+	joinrel->lateral_vars = NIL;
+	joinrel->lateral_relids = NULL;
+	joinrel->lateral_referencers = NULL;
+	joinrel->indexlist = NIL;
+	joinrel->pages = 0;
+	joinrel->tuples = 0;
+	joinrel->allvisfrac = 0;
+	joinrel->subplan = NULL;
+	joinrel->subroot = NULL;
+	joinrel->subplan_params = NIL;
+	joinrel->fdwroutine = NULL;
+	joinrel->fdw_private = NULL;
+	joinrel->baserestrictinfo = NIL;
+	joinrel->baserestrictcost.startup = 0;
+	joinrel->baserestrictcost.per_tuple = 0;
+	joinrel->joininfo = NIL;
+	joinrel->has_eclass_joins = false;
+
+	/*
+	 * The targetlist must have the same columns in the same order as the
+	 * parent's, since the Append above passes the rows through unchanged.
+	 */
+	joinrel->reltargetlist = (List *)
+		adjust_appendrel_attrs(root,
+							   adjust_appendrel_attrs(root,
+										(Node *) parent_joinrel->reltargetlist,
+													  outer_appinfo),
+							   inner_appinfo);
+
+	restrictlist = (List *)
+		adjust_appendrel_attrs(root,
+							   adjust_appendrel_attrs(root,
+													  (Node *) restrictlist,
+													  outer_appinfo),
+							   inner_appinfo);
+	*restrictlist_ptr = restrictlist;
+
+	set_joinrel_size_estimates(root, joinrel, outer_rel, inner_rel,
+							   sjinfo, restrictlist);
+
+	return joinrel;
+}
+
 /*
  * build_joinrel_tlist
  *	  Builds a join relation's target list from an input relation.
@@ -51,6 +51,7 @@
 
 #include "catalog/index.h"
 #include "catalog/namespace.h"
+#include "catalog/pg_partitioned_table.h"
 #include "catalog/pg_trigger.h"
 #include "commands/defrem.h"
 #include "commands/trigger.h"
@@ -164,6 +165,7 @@ static void processCASbits(int cas_bits, int location, const char *constrType,
 			   bool *deferrable, bool *initdeferred, bool *not_valid,
 			   bool *no_inherit, core_yyscan_t yyscanner);
 static Node *makeRecursiveViewSelect(char *relname, List *aliases, Node *query);
+static void processVacuumOptions(VacuumStmt *n, List *options);
 
 %}
 
@@ -211,6 +213,8 @@ static Node *makeRecursiveViewSelect(char *relname, List *aliases, Node *query);
 	AccessPriv			*accesspriv;
 	InsertStmt			*istmt;
 	VariableSetStmt		*vsetstmt;
+	PartitionSpec		*partspec;
+	PartitionBoundSpec	*partboundspec;
 }
 
 %type <node>	stmt schema_stmt
@@ -269,7 +273,8 @@ static Node *makeRecursiveViewSelect(char *relname, List *aliases, Node *query);
 				create_extension_opt_item alter_extension_opt_item
 
 %type <ival>	opt_lock lock_type cast_context
-%type <ival>	vacuum_option_list vacuum_option_elem
+%type <list>	vacuum_option_list
+%type <defelt>	vacuum_option_elem
 %type <boolean>	opt_force opt_or_replace
 				opt_grant_grant_option opt_grant_admin_option
 				opt_nowait opt_if_exists opt_with_data
@@ -400,6 +405,10 @@ static Node *makeRecursiveViewSelect(char *relname, List *aliases, Node *query);
 
 %type <vsetstmt> generic_set set_rest set_rest_more SetResetClause FunctionSetResetClause
 
+%type <partspec>	OptPartitionSpec PartitionSpec
+%type <partboundspec>	ForValues
+%type <list>	partbound_datum_list
+%type <node>	partbound_datum range_datum
 %type <node>	TableElement TypedTableElement ConstraintElem TableFuncElement
 %type <node>	columnDef columnOptions
 %type <defelt>	def_elem reloption_elem old_aggr_elem
@@ -574,7 +583,7 @@ static Node *makeRecursiveViewSelect(char *relname, List *aliases, Node *query);
 	OBJECT_P OF OFF OFFSET OIDS ON ONLY OPERATOR OPTION OPTIONS OR
 	ORDER ORDINALITY OUT_P OUTER_P OVER OVERLAPS OVERLAY OWNED OWNER
 
-	PARSER PARTIAL PARTITION PASSING PASSWORD PLACING PLANS POSITION
+	PARALLEL PARSER PARTIAL PARTITION PASSING PASSWORD PLACING PLANS POSITION
 	PRECEDING PRECISION PRESERVE PREPARE PREPARED PRIMARY
 	PRIOR PRIVILEGES PROCEDURAL PROCEDURE PROGRAM
 
@@ -2641,33 +2650,35 @@ copy_generic_opt_arg_list_item:
  *****************************************************************************/
 
 CreateStmt:	CREATE OptTemp TABLE qualified_name '(' OptTableElementList ')'
-			OptInherit OptWith OnCommitOption OptTableSpace
+			OptInherit OptPartitionSpec OptWith OnCommitOption OptTableSpace
 				{
 					CreateStmt *n = makeNode(CreateStmt);
 					$4->relpersistence = $2;
 					n->relation = $4;
 					n->tableElts = $6;
 					n->inhRelations = $8;
+					n->partspec = $9;
 					n->constraints = NIL;
-					n->options = $9;
-					n->oncommit = $10;
-					n->tablespacename = $11;
+					n->options = $10;
+					n->oncommit = $11;
+					n->tablespacename = $12;
 					n->if_not_exists = false;
 					$$ = (Node *)n;
 				}
 		| CREATE OptTemp TABLE IF_P NOT EXISTS qualified_name '('
-			OptTableElementList ')' OptInherit OptWith OnCommitOption
-			OptTableSpace
+			OptTableElementList ')' OptInherit OptPartitionSpec OptWith
+			OnCommitOption OptTableSpace
 				{
 					CreateStmt *n = makeNode(CreateStmt);
 					$7->relpersistence = $2;
 					n->relation = $7;
 					n->tableElts = $9;
 					n->inhRelations = $11;
+					n->partspec = $12;
 					n->constraints = NIL;
-					n->options = $12;
-					n->oncommit = $13;
-					n->tablespacename = $14;
+					n->options = $13;
+					n->oncommit = $14;
+					n->tablespacename = $15;
 					n->if_not_exists = true;
 					$$ = (Node *)n;
 				}
@@ -2703,6 +2714,38 @@ CreateStmt:	CREATE OptTemp TABLE qualified_name '(' OptTableElementList ')'
 					n->if_not_exists = true;
 					$$ = (Node *)n;
 				}
+		| CREATE OptTemp TABLE qualified_name PARTITION OF qualified_name
+			ForValues OptWith OnCommitOption OptTableSpace
+				{
+					CreateStmt *n = makeNode(CreateStmt);
+					$4->relpersistence = $2;
+					n->relation = $4;
+					n->tableElts = NIL;
+					n->inhRelations = list_make1($7);
+					n->partbound = $8;
+					n->constraints = NIL;
+					n->options = $9;
+					n->oncommit = $10;
+					n->tablespacename = $11;
+					n->if_not_exists = false;
+					$$ = (Node *)n;
+				}
+		| CREATE OptTemp TABLE IF_P NOT EXISTS qualified_name PARTITION OF
+			qualified_name ForValues OptWith OnCommitOption OptTableSpace
+				{
+					CreateStmt *n = makeNode(CreateStmt);
+					$7->relpersistence = $2;
+					n->relation = $7;
+					n->tableElts = NIL;
+					n->inhRelations = list_make1($10);
+					n->partbound = $11;
+					n->constraints = NIL;
+					n->options = $12;
+					n->oncommit = $13;
+					n->tablespacename = $14;
+					n->if_not_exists = true;
+					$$ = (Node *)n;
+				}
 		;
 
 /*
@@ -3242,6 +3285,65 @@ OptInherit: INHERITS '(' qualified_name_list ')'	{ $$ = $3; }
 			| /*EMPTY*/								{ $$ = NIL; }
 		;
 
+/* Only a single partition key column is supported */
+OptPartitionSpec: PartitionSpec					{ $$ = $1; }
+			| /*EMPTY*/							{ $$ = NULL; }
+		;
+
+PartitionSpec: PARTITION BY ColId '(' ColId opt_collate opt_class ')'
+				{
+					PartitionSpec *n = makeNode(PartitionSpec);
+
+					n->strategy = $3;
+					n->colname = $5;
+					n->collation = $6;
+					n->opclass = $7;
+					n->location = @1;
+
+					$$ = n;
+				}
+		;
+
+ForValues:
+			FOR VALUES IN_P '(' partbound_datum_list ')'
+				{
+					PartitionBoundSpec *n = makeNode(PartitionBoundSpec);
+
+					n->strategy = PARTITION_STRATEGY_LIST;
+					n->listdatums = $5;
+					n->location = @3;
+
+					$$ = n;
+				}
+			| FOR VALUES FROM '(' range_datum ')' TO '(' range_datum ')'
+				{
+					PartitionBoundSpec *n = makeNode(PartitionBoundSpec);
+
+					n->strategy = PARTITION_STRATEGY_RANGE;
+					n->lowerdatum = $5;
+					n->upperdatum = $9;
+					n->location = @3;
+
+					$$ = n;
+				}
+		;
+
+partbound_datum:
+			Sconst						{ $$ = makeStringConst($1, @1); }
+			| NumericOnly				{ $$ = makeAConst($1, @1); }
+		;
+
+partbound_datum_list:
+			partbound_datum						{ $$ = list_make1($1); }
+			| partbound_datum_list ',' partbound_datum
+												{ $$ = lappend($1, $3); }
+		;
+
+range_datum:
+			partbound_datum				{ $$ = $1; }
+			| UNBOUNDED					{ $$ = NULL; }
+		;
+
 /* WITH (options) is preferred, WITH OIDS and WITHOUT OIDS are legacy forms */
 OptWith:
 			WITH reloptions				{ $$ = $2; }
@@ -8767,19 +8869,7 @@ VacuumStmt: VACUUM opt_full opt_freeze opt_verbose
 			| VACUUM '(' vacuum_option_list ')'
 				{
 					VacuumStmt *n = makeNode(VacuumStmt);
-					n->options = VACOPT_VACUUM | $3;
-					if (n->options & VACOPT_FREEZE)
-					{
-						n->freeze_min_age = n->freeze_table_age = 0;
-						n->multixact_freeze_min_age = 0;
-						n->multixact_freeze_table_age = 0;
-					}
-					else
-					{
-						n->freeze_min_age = n->freeze_table_age = -1;
-						n->multixact_freeze_min_age = -1;
-						n->multixact_freeze_table_age = -1;
-					}
+					processVacuumOptions(n, $3);
 					n->relation = NULL;
 					n->va_cols = NIL;
 					$$ = (Node *) n;
@@ -8787,19 +8877,7 @@ VacuumStmt: VACUUM opt_full opt_freeze opt_verbose
 			| VACUUM '(' vacuum_option_list ')' qualified_name opt_name_list
 				{
 					VacuumStmt *n = makeNode(VacuumStmt);
-					n->options = VACOPT_VACUUM | $3;
-					if (n->options & VACOPT_FREEZE)
-					{
-						n->freeze_min_age = n->freeze_table_age = 0;
-						n->multixact_freeze_min_age = 0;
-						n->multixact_freeze_table_age = 0;
-					}
-					else
-					{
-						n->freeze_min_age = n->freeze_table_age = -1;
-						n->multixact_freeze_min_age = -1;
-						n->multixact_freeze_table_age = -1;
-					}
+					processVacuumOptions(n, $3);
 					n->relation = $5;
 					n->va_cols = $6;
 					if (n->va_cols != NIL)	/* implies analyze */
@@ -8809,15 +8887,25 @@ VacuumStmt: VACUUM opt_full opt_freeze opt_verbose
 		;
 
 vacuum_option_list:
-			vacuum_option_elem								{ $$ = $1; }
-			| vacuum_option_list ',' vacuum_option_elem		{ $$ = $1 | $3; }
+			vacuum_option_elem
+				{
+					$$ = list_make1($1);
+				}
+			| vacuum_option_list ',' vacuum_option_elem
+				{
+					$$ = lappend($1, $3);
+				}
 		;
 
 vacuum_option_elem:
-			analyze_keyword		{ $$ = VACOPT_ANALYZE; }
-			| VERBOSE			{ $$ = VACOPT_VERBOSE; }
-			| FREEZE			{ $$ = VACOPT_FREEZE; }
-			| FULL				{ $$ = VACOPT_FULL; }
+			analyze_keyword		{ $$ = makeDefElem("analyze", NULL); }
+			| VERBOSE			{ $$ = makeDefElem("verbose", NULL); }
+			| FREEZE			{ $$ = makeDefElem("freeze", NULL); }
+			| FULL				{ $$ = makeDefElem("full", NULL); }
+			| PARALLEL Iconst
+				{
+					$$ = makeDefElem("parallel", (Node *) makeInteger($2));
+				}
 		;
 
 AnalyzeStmt:
@@ -12940,6 +13028,7 @@ unreserved_keyword:
 			| OVER
 			| OWNED
 			| OWNER
+			| PARALLEL
 			| PARSER
 			| PARTIAL
 			| PARTITION
@@ -13975,6 +14064,50 @@ makeRecursiveViewSelect(char *relname, List *aliases, Node *query)
 	return (Node *) s;
 }
 
+/*
+ * Convert the option list of a parenthesized VACUUM command into the
+ * VacuumStmt's options bitmask, freeze ages and parallel degree.
+ */
+static void
+processVacuumOptions(VacuumStmt *n, List *options)
+{
+	ListCell   *lc;
+
+	n->options = VACOPT_VACUUM;
+	n->parallel_workers = 0;
+
+	foreach(lc, options)
+	{
+		DefElem    *opt = (DefElem *) lfirst(lc);
+
+		if (strcmp(opt->defname, "analyze") == 0)
+			n->options |= VACOPT_ANALYZE;
+		else if (strcmp(opt->defname, "verbose") == 0)
+			n->options |= VACOPT_VERBOSE;
+		else if (strcmp(opt->defname, "freeze") == 0)
+			n->options |= VACOPT_FREEZE;
+		else if (strcmp(opt->defname, "full") == 0)
+			n->options |= VACOPT_FULL;
+		else if (strcmp(opt->defname, "parallel") == 0)
+			n->parallel_workers = intVal(opt->arg);
+		else
+			elog(ERROR, "unrecognized VACUUM option \"%s\"", opt->defname);
+	}
+
+	if (n->options & VACOPT_FREEZE)
+	{
+		n->freeze_min_age = n->freeze_table_age = 0;
+		n->multixact_freeze_min_age = 0;
+		n->multixact_freeze_table_age = 0;
+	}
+	else
+	{
+		n->freeze_min_age = n->freeze_table_age = -1;
+		n->multixact_freeze_min_age = -1;
+		n->multixact_freeze_table_age = -1;
+	}
+}
+
 /* parser_init()
  * Initialize to parse one query string
  */
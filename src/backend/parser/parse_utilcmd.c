@@ -32,10 +32,12 @@
 #include "catalog/heap.h"
 #include "catalog/index.h"
 #include "catalog/namespace.h"
+#include "catalog/partition.h"
 #include "catalog/pg_collation.h"
 #include "catalog/pg_constraint.h"
 #include "catalog/pg_opclass.h"
 #include "catalog/pg_operator.h"
+#include "catalog/pg_partitioned_table.h"
 #include "catalog/pg_type.h"
 #include "commands/comment.h"
 #include "commands/defrem.h"
@@ -44,8 +46,10 @@
 #include "miscadmin.h"
 #include "nodes/makefuncs.h"
 #include "nodes/nodeFuncs.h"
+#include "optimizer/clauses.h"
 #include "parser/analyze.h"
 #include "parser/parse_clause.h"
+#include "parser/parse_coerce.h"
 #include "parser/parse_collate.h"
 #include "parser/parse_expr.h"
 #include "parser/parse_relation.h"
@@ -123,6 +127,8 @@ static void transformConstraintAttrs(CreateStmtContext *cxt,
 						 List *constraintList);
 static void transformColumnType(CreateStmtContext *cxt, ColumnDef *column);
 static void setSchemaName(char *context_schema, char **stmt_schema_name);
+static Const *transformPartitionBoundValue(ParseState *pstate,
+							 PartitionKey key, Node *val);
 
 
 /*
@@ -2795,3 +2801,93 @@ setSchemaName(char *context_schema, char **stmt_schema_name)
 						"different from the one being created (%s)",
 						*stmt_schema_name, context_schema)));
 }
+
+/*
+ * transformPartitionBound
+ *		Transform a partition bound specification for a new partition of
+ *		parent, turning the raw bound values into Consts of the key type
+ */
+PartitionBoundSpec *
+transformPartitionBound(ParseState *pstate, Relation parent,
+						PartitionBoundSpec *spec)
+{
+	PartitionKey key = RelationGetPartitionKey(parent);
+	PartitionBoundSpec *result;
+	ListCell   *cell;
+
+	Assert(key != NULL);
+
+	if (spec->strategy != key->strategy)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_TABLE_DEFINITION),
+				 key->strategy == PARTITION_STRATEGY_LIST ?
+				 errmsg("invalid bound specification for a list partition") :
+				 errmsg("invalid bound specification for a range partition"),
+				 parser_errposition(pstate, spec->location)));
+
+	result = makeNode(PartitionBoundSpec);
+	result->strategy = spec->strategy;
+	result->location = spec->location;
+
+	if (spec->strategy == PARTITION_STRATEGY_LIST)
+	{
+		foreach(cell, spec->listdatums)
+			result->listdatums = lappend(result->listdatums,
+							   transformPartitionBoundValue(pstate, key,
+														(Node *) lfirst(cell)));
+	}
+	else
+	{
+		if (spec->lowerdatum != NULL)
+			result->lowerdatum = (Node *)
+				transformPartitionBoundValue(pstate, key, spec->lowerdatum);
+		if (spec->upperdatum != NULL)
+			result->upperdatum = (Node *)
+				transformPartitionBoundValue(pstate, key, spec->upperdatum);
+	}
+
+	return result;
+}
+
+/*
+ * transformPartitionBoundValue
+ *		Coerce one bound value to the type of the partition key
+ */
+static Const *
+transformPartitionBoundValue(ParseState *pstate, PartitionKey key, Node *val)
+{
+	A_Const    *aconst = (A_Const *) val;
+	Node	   *value;
+
+	/* The grammar allows nothing but literals */
+	Assert(IsA(aconst, A_Const));
+
+	value = (Node *) make_const(pstate, &aconst->val, aconst->location);
+	value = coerce_to_target_type(pstate,
+								  value, exprType(value),
+								  key->parttypid, key->parttypmod,
+								  COERCION_ASSIGNMENT,
+								  COERCE_IMPLICIT_CAST,
+								  -1);
+	if (value == NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_DATATYPE_MISMATCH),
+				 errmsg("specified value cannot be cast to type %s of the partition key",
+						format_type_be(key->parttypid)),
+				 parser_errposition(pstate, aconst->location)));
+
+	/* Simplify to a Const, running any length coercion */
+	value = eval_const_expressions(NULL, value);
+	if (!IsA(value, Const))
+		elog(ERROR, "could not evaluate partition bound value");
+
+	if (((Const *) value)->constisnull)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_TABLE_DEFINITION),
+				 errmsg("cannot specify NULL in partition bound"),
+				 parser_errposition(pstate, aconst->location)));
+
+	((Const *) value)->constcollid = key->partcollation;
+
+	return (Const *) value;
+}
@@ -61,6 +61,7 @@
  */
 #include "postgres.h"
 
+#include <math.h>
 #include <signal.h>
 #include <sys/types.h>
 #include <sys/time.h>
@@ -78,6 +79,7 @@
 #include "catalog/pg_database.h"
 #include "commands/dbcommands.h"
 #include "commands/vacuum.h"
+#include "funcapi.h"
 #include "lib/ilist.h"
 #include "libpq/pqsignal.h"
 #include "miscadmin.h"
@@ -103,6 +105,7 @@
 #include "utils/timeout.h"
 #include "utils/timestamp.h"
 #include "utils/tqual.h"
+#include "utils/tuplestore.h"
 
 
 /*
@@ -158,6 +161,7 @@ typedef struct avl_dbase
 	Oid			adl_datid;		/* hash key -- must be first */
 	TimestampTz adl_next_worker;
 	int			adl_score;
+	PgStat_Counter adl_changes; /* tuple changes when last worker started */
 	dlist_node	adl_node;
 } avl_dbase;
 
@@ -199,6 +203,51 @@ typedef struct autovac_table
 	char	   *at_datname;
 } autovac_table;
 
+/* struct to keep track of tables to vacuum and/or analyze, in priority order */
+typedef struct av_candidate
+{
+	Oid			ac_relid;
+	double		ac_priority;
+	bool		ac_dovacuum;
+	bool		ac_doanalyze;
+	bool		ac_wraparound;
+	PgStat_Counter ac_dead_tuples;
+	int32		ac_xid_age;
+	BlockNumber ac_relpages;
+} av_candidate;
+
+/*
+ * Number of entries each worker publishes in the shared work queue.  Tables
+ * beyond this are still processed, just not shown.
+ */
+#define AUTOVAC_QUEUE_PER_WORKER	128
+
+/*
+ * Priority given to tables that must be vacuumed to prevent wraparound; they
+ * always sort ahead of everything else.
+ */
+#define AUTOVAC_WRAPAROUND_PRIORITY 1000000.0
+
+/* number of heap pages treated as one size unit when computing priorities */
+#define AUTOVAC_PRIORITY_SIZE_UNIT	((double) (1024 * 1024 * 1024) / BLCKSZ)
+
+/*-------------
+ * An entry in a worker's part of the shared work queue, as published by
+ * do_autovacuum.  The fields mirror av_candidate.
+ *-------------
+ */
+typedef struct AutoVacQueueEntry
+{
+	Oid			aq_relid;
+	double		aq_priority;
+	bool		aq_dovacuum;
+	bool		aq_doanalyze;
+	bool		aq_wraparound;
+	PgStat_Counter aq_dead_tuples;
+	int32		aq_xid_age;
+	BlockNumber aq_relpages;
+} AutoVacQueueEntry;
+
 /*-------------
  * This struct holds information about a single worker's whereabouts.  We keep
  * an array of these in shared memory, sized according to
@@ -210,6 +259,9 @@ typedef struct autovac_table
  * wi_proc		pointer to PGPROC of the running worker, NULL if not started
  * wi_launchtime Time at which this worker was launched
  * wi_cost_*	Vacuum cost-based delay parameters current in this worker
+ * wi_queue		this worker's AUTOVAC_QUEUE_PER_WORKER slots of the work queue
+ * wi_queue_len	number of valid entries in wi_queue, in priority order
+ * wi_queue_next index of the first wi_queue entry not yet taken up
  *
  * All fields are protected by AutovacuumLock, except for wi_tableoid which is
  * protected by AutovacuumScheduleLock (which is read-only for everyone except
@@ -226,6 +278,9 @@ typedef struct WorkerInfoData
 	int			wi_cost_delay;
 	int			wi_cost_limit;
 	int			wi_cost_limit_base;
+	AutoVacQueueEntry *wi_queue;
+	int			wi_queue_len;
+	int			wi_queue_next;
 } WorkerInfoData;
 
 typedef struct WorkerInfoData *WorkerInfo;
@@ -244,7 +299,8 @@ typedef enum
 
 /*-------------
  * The main autovacuum shmem struct.  On shared memory we store this main
- * struct and the array of WorkerInfo structs.	This struct keeps:
+ * struct, the array of WorkerInfo structs and the work queue entries that
+ * the WorkerInfo structs point to.  This struct keeps:
  *
  * av_signal		set by other processes to indicate various conditions
  * av_launcherpid	the PID of the autovacuum launcher
@@ -305,7 +361,14 @@ static autovac_table *table_recheck_autovac(Oid relid, HTAB *table_toast_map,
 static void relation_needs_vacanalyze(Oid relid, AutoVacOpts *relopts,
 						  Form_pg_class classForm,
 						  PgStat_StatTabEntry *tabentry,
-						  bool *dovacuum, bool *doanalyze, bool *wraparound);
+						  bool *dovacuum, bool *doanalyze, bool *wraparound,
+						  double *priority);
+static av_candidate *make_av_candidate(Oid relid, Form_pg_class classForm,
+				  PgStat_StatTabEntry *tabentry,
+				  bool dovacuum, bool doanalyze, bool wraparound,
+				  double priority);
+static int	av_candidate_comparator(const void *a, const void *b);
+static void autovac_publish_queue(av_candidate *candidates, int ncandidates);
 
 static void autovacuum_do_vac_analyze(autovac_table *tab,
 						  BufferAccessStrategy bstrategy);
@@ -942,6 +1005,10 @@ rebuild_database_list(Oid newdb)
 			/* hash_search already filled in the key */
 			db->adl_score = score++;
 			/* next_worker is filled in later */
+
+			/* a worker is being started there right now */
+			db->adl_changes = entry->n_tuples_inserted +
+				entry->n_tuples_updated + entry->n_tuples_deleted;
 		}
 	}
 
@@ -968,6 +1035,7 @@ rebuild_database_list(Oid newdb)
 			/* hash_search already filled in the key */
 			db->adl_score = score++;
 			/* next_worker is filled in later */
+			db->adl_changes = avdb->adl_changes;
 		}
 	}
 
@@ -992,6 +1060,7 @@ rebuild_database_list(Oid newdb)
 			/* hash_search already filled in the key */
 			db->adl_score = score++;
 			/* next_worker is filled in later */
+			db->adl_changes = 0;
 		}
 	}
 	nelems = score;
@@ -1089,6 +1158,8 @@ do_start_worker(void)
 	bool		for_xid_wrap;
 	bool		for_multi_wrap;
 	avw_dbase  *avdb;
+	avl_dbase  *avdb_dbp;
+	double		avdb_priority;
 	TimestampTz current_time;
 	bool		skipit = false;
 	Oid			retval = InvalidOid;
@@ -1140,33 +1211,41 @@ do_start_worker(void)
 		multiForceLimit -= FirstMultiXactId;
 
 	/*
-	 * Choose a database to connect to.  We pick the database that was least
-	 * recently auto-vacuumed, or one that needs vacuuming to prevent Xid
-	 * wraparound-related data loss.  If any db at risk of Xid wraparound is
-	 * found, we pick the one with oldest datfrozenxid, independently of
-	 * autovacuum times; similarly we pick the one with the oldest datminmxid
-	 * if any is in MultiXactId wraparound.  Note that those in Xid wraparound
-	 * danger are given more priority than those in multi wraparound danger.
+	 * Choose a database to connect to.  We pick the database with the highest
+	 * priority, or one that needs vacuuming to prevent Xid wraparound-related
+	 * data loss.  If any db at risk of Xid wraparound is found, we pick the
+	 * one with oldest datfrozenxid, independently of priorities; similarly we
+	 * pick the one with the oldest datminmxid if any is in MultiXactId
+	 * wraparound.  Note that those in Xid wraparound danger are given more
+	 * priority than those in multi wraparound danger.
 	 *
 	 * Note that a database with no stats entry is not considered, except for
 	 * Xid wraparound purposes.  The theory is that if no one has ever
 	 * connected to it since the stats were last initialized, it doesn't need
 	 * vacuuming.
 	 *
-	 * XXX This could be improved if we had more info about whether it needs
-	 * vacuuming before connecting to it.  Perhaps look through the pgstats
-	 * data for the database's tables?  One idea is to keep track of the
-	 * number of new and dead tuples per database in pgstats.  However it
-	 * isn't clear how to construct a metric that measures that and not cause
-	 * starvation for less busy databases.
+	 * The priority of a database is the number of tuples inserted, updated
+	 * or deleted in it since we last started a worker there, which is a
+	 * cheap upper bound on the amount of vacuum and analyze work waiting in
+	 * it.  To avoid starving quiet databases, that is multiplied by the
+	 * number of naptimes that have passed since the database was last
+	 * processed, so that any database that is skipped for long enough
+	 * eventually outranks a busy one.
 	 */
 	avdb = NULL;
+	avdb_dbp = NULL;
+	avdb_priority = 0;
 	for_xid_wrap = false;
 	for_multi_wrap = false;
 	current_time = GetCurrentTimestamp();
 	foreach(cell, dblist)
 	{
 		avw_dbase  *tmp = lfirst(cell);
+		avl_dbase  *tmp_dbp = NULL;
+		PgStat_Counter changes;
+		double		priority;
+		long		secs;
+		int			usecs;
 		dlist_iter	iter;
 
 		/* Check to see if this one is at risk of wraparound */
@@ -1175,7 +1254,10 @@ do_start_worker(void)
 			if (avdb == NULL ||
 				TransactionIdPrecedes(tmp->adw_frozenxid,
 									  avdb->adw_frozenxid))
+			{
 				avdb = tmp;
+				avdb_dbp = NULL;
+			}
 			for_xid_wrap = true;
 			continue;
 		}
@@ -1185,7 +1267,10 @@ do_start_worker(void)
 		{
 			if (avdb == NULL ||
 				MultiXactIdPrecedes(tmp->adw_minmulti, avdb->adw_minmulti))
+			{
 				avdb = tmp;
+				avdb_dbp = NULL;
+			}
 			for_multi_wrap = true;
 			continue;
 		}
@@ -1228,6 +1313,7 @@ do_start_worker(void)
 												autovacuum_naptime * 1000))
 					skipit = true;
 
+				tmp_dbp = dbp;
 				break;
 			}
 		}
@@ -1235,12 +1321,27 @@ do_start_worker(void)
 			continue;
 
 		/*
-		 * Remember the db with oldest autovac time.  (If we are here, both
-		 * tmp->entry and db->entry must be non-null.)
+		 * Compute the db's priority and remember the highest one.  The
+		 * counters can go backwards if the stats were reset; in that case
+		 * just count everything since the reset.
 		 */
-		if (avdb == NULL ||
-			tmp->adw_entry->last_autovac_time < avdb->adw_entry->last_autovac_time)
+		changes = tmp->adw_entry->n_tuples_inserted +
+			tmp->adw_entry->n_tuples_updated +
+			tmp->adw_entry->n_tuples_deleted;
+		if (tmp_dbp != NULL && tmp_dbp->adl_changes <= changes)
+			changes -= tmp_dbp->adl_changes;
+
+		TimestampDifference(tmp->adw_entry->last_autovac_time, current_time,
+							&secs, &usecs);
+		priority = ((double) changes + 1.0) *
+			(1.0 + (double) secs / autovacuum_naptime);
+
+		if (avdb == NULL || priority > avdb_priority)
+		{
 			avdb = tmp;
+			avdb_dbp = tmp_dbp;
+			avdb_priority = priority;
+		}
 	}
 
 	/* Found a database -- process it */
@@ -1261,11 +1362,19 @@ do_start_worker(void)
 		worker->wi_dboid = avdb->adw_datid;
 		worker->wi_proc = NULL;
 		worker->wi_launchtime = GetCurrentTimestamp();
+		worker->wi_queue_len = 0;
+		worker->wi_queue_next = 0;
 
 		AutoVacuumShmem->av_startingWorker = worker;
 
 		LWLockRelease(AutovacuumLock);
 
+		/* the changes made so far are being taken care of */
+		if (avdb_dbp != NULL && avdb->adw_entry != NULL)
+			avdb_dbp->adl_changes = avdb->adw_entry->n_tuples_inserted +
+				avdb->adw_entry->n_tuples_updated +
+				avdb->adw_entry->n_tuples_deleted;
+
 		SendPostmasterSignal(PMSIGNAL_START_AUTOVAC_WORKER);
 
 		retval = avdb->adw_datid;
@@ -1719,6 +1828,8 @@ FreeWorkerInfo(int code, Datum arg)
 		MyWorkerInfo->wi_cost_delay = 0;
 		MyWorkerInfo->wi_cost_limit = 0;
 		MyWorkerInfo->wi_cost_limit_base = 0;
+		MyWorkerInfo->wi_queue_len = 0;
+		MyWorkerInfo->wi_queue_next = 0;
 		dlist_push_head(&AutoVacuumShmem->av_freeWorkers,
 						&MyWorkerInfo->wi_links);
 		/* not mine anymore */
@@ -1909,10 +2020,13 @@ do_autovacuum(void)
 	HeapTuple	tuple;
 	HeapScanDesc relScan;
 	Form_pg_database dbForm;
-	List	   *table_oids = NIL;
+	List	   *candidate_list = NIL;
+	av_candidate *candidates;
+	int			ncandidates;
 	HASHCTL		ctl;
 	HTAB	   *table_toast_map;
-	ListCell   *volatile cell;
+	ListCell   *cell;
+	volatile int i;
 	PgStat_StatDBEntry *shared;
 	PgStat_StatDBEntry *dbentry;
 	BufferAccessStrategy bstrategy;
@@ -2025,6 +2139,7 @@ do_autovacuum(void)
 		bool		dovacuum;
 		bool		doanalyze;
 		bool		wraparound;
+		double		priority;
 
 		if (classForm->relkind != RELKIND_RELATION &&
 			classForm->relkind != RELKIND_MATVIEW)
@@ -2039,7 +2154,8 @@ do_autovacuum(void)
 
 		/* Check if it needs vacuum or analyze */
 		relation_needs_vacanalyze(relid, relopts, classForm, tabentry,
-								  &dovacuum, &doanalyze, &wraparound);
+								  &dovacuum, &doanalyze, &wraparound,
+								  &priority);
 
 		/*
 		 * Check if it is a temp table (presumably, of some other backend's).
@@ -2086,9 +2202,15 @@ do_autovacuum(void)
 		}
 		else
 		{
-			/* relations that need work are added to table_oids */
+			/* relations that need work are added to the candidate list */
 			if (dovacuum || doanalyze)
-				table_oids = lappend_oid(table_oids, relid);
+				candidate_list = lappend(candidate_list,
+										 make_av_candidate(relid, classForm,
+														   tabentry,
+														   dovacuum,
+														   doanalyze,
+														   wraparound,
+														   priority));
 
 			/*
 			 * Remember the association for the second pass.  Note: we must do
@@ -2138,6 +2260,7 @@ do_autovacuum(void)
 		bool		dovacuum;
 		bool		doanalyze;
 		bool		wraparound;
+		double		priority;
 
 		/*
 		 * We cannot safely process other backends' temp tables, so skip 'em.
@@ -2167,16 +2290,39 @@ do_autovacuum(void)
 											 shared, dbentry);
 
 		relation_needs_vacanalyze(relid, relopts, classForm, tabentry,
-								  &dovacuum, &doanalyze, &wraparound);
+								  &dovacuum, &doanalyze, &wraparound,
+								  &priority);
 
 		/* ignore analyze for toast tables */
 		if (dovacuum)
-			table_oids = lappend_oid(table_oids, relid);
+			candidate_list = lappend(candidate_list,
+									 make_av_candidate(relid, classForm,
+													   tabentry,
+													   dovacuum,
+													   false,
+													   wraparound,
+													   priority));
 	}
 
 	heap_endscan(relScan);
 	heap_close(classRel, AccessShareLock);
 
+	/*
+	 * Sort the collected tables by decreasing priority, so that the ones that
+	 * need attention the most are processed first, and publish the head of
+	 * the resulting list in shared memory so that it can be monitored.
+	 */
+	ncandidates = list_length(candidate_list);
+	candidates = palloc(Max(ncandidates, 1) * sizeof(av_candidate));
+	i = 0;
+	foreach(cell, candidate_list)
+		memcpy(&candidates[i++], lfirst(cell), sizeof(av_candidate));
+	list_free_deep(candidate_list);
+
+	qsort(candidates, ncandidates, sizeof(av_candidate),
+		  av_candidate_comparator);
+	autovac_publish_queue(candidates, ncandidates);
+
 	/*
 	 * Create a buffer access strategy object for VACUUM to use.  We want to
 	 * use the same one across all the vacuum operations we perform, since the
@@ -2197,9 +2343,9 @@ do_autovacuum(void)
 	/*
 	 * Perform operations on collected tables.
 	 */
-	foreach(cell, table_oids)
+	for (i = 0; i < ncandidates; i++)
 	{
-		Oid			relid = lfirst_oid(cell);
+		Oid			relid = candidates[i].ac_relid;
 		autovac_table *tab;
 		bool		skipit;
 		int			stdVacuumCostDelay;
@@ -2211,10 +2357,13 @@ do_autovacuum(void)
 		/*
 		 * hold schedule lock from here until we're sure that this table still
 		 * needs vacuuming.  We also need the AutovacuumLock to walk the
-		 * worker array, but we'll let go of that one quickly.
+		 * worker array and to advance our position in the work queue, but
+		 * we'll let go of that one quickly.
 		 */
 		LWLockAcquire(AutovacuumScheduleLock, LW_EXCLUSIVE);
-		LWLockAcquire(AutovacuumLock, LW_SHARED);
+		LWLockAcquire(AutovacuumLock, LW_EXCLUSIVE);
+
+		MyWorkerInfo->wi_queue_next = Min(i, MyWorkerInfo->wi_queue_len);
 
 		/*
 		 * Check whether the table is being vacuumed concurrently by another
@@ -2387,6 +2536,12 @@ deleted:
 		VacuumCostLimit = stdVacuumCostLimit;
 	}
 
+	/* Nothing is left in our part of the work queue */
+	LWLockAcquire(AutovacuumLock, LW_EXCLUSIVE);
+	MyWorkerInfo->wi_queue_len = 0;
+	MyWorkerInfo->wi_queue_next = 0;
+	LWLockRelease(AutovacuumLock);
+
 	/*
 	 * We leak table_toast_map here (among other things), but since we're
 	 * going away soon, it's not a problem.
@@ -2453,6 +2608,85 @@ get_pgstat_tabentry_relid(Oid relid, bool isshared, PgStat_StatDBEntry *shared,
 	return tabentry;
 }
 
+/*
+ * make_av_candidate
+ *
+ * Build a palloc'd av_candidate for a table that needs vacuum or analyze.
+ */
+static av_candidate *
+make_av_candidate(Oid relid, Form_pg_class classForm,
+				  PgStat_StatTabEntry *tabentry,
+				  bool dovacuum, bool doanalyze, bool wraparound,
+				  double priority)
+{
+	av_candidate *cand = palloc(sizeof(av_candidate));
+
+	cand->ac_relid = relid;
+	cand->ac_priority = priority;
+	cand->ac_dovacuum = dovacuum;
+	cand->ac_doanalyze = doanalyze;
+	cand->ac_wraparound = wraparound;
+	cand->ac_dead_tuples = tabentry ? tabentry->n_dead_tuples : 0;
+	if (TransactionIdIsNormal(classForm->relfrozenxid))
+		cand->ac_xid_age = (int32) (recentXid - classForm->relfrozenxid);
+	else
+		cand->ac_xid_age = 0;
+	cand->ac_relpages = (BlockNumber) classForm->relpages;
+
+	return cand;
+}
+
+/*
+ * qsort comparator for av_candidate, sorting by decreasing priority.  Ties
+ * are broken by OID so that concurrent workers agree on the order.
+ */
+static int
+av_candidate_comparator(const void *a, const void *b)
+{
+	const av_candidate *ca = (const av_candidate *) a;
+	const av_candidate *cb = (const av_candidate *) b;
+
+	if (ca->ac_priority > cb->ac_priority)
+		return -1;
+	if (ca->ac_priority < cb->ac_priority)
+		return 1;
+	if (ca->ac_relid < cb->ac_relid)
+		return -1;
+	if (ca->ac_relid > cb->ac_relid)
+		return 1;
+	return 0;
+}
+
+/*
+ * autovac_publish_queue
+ *
+ * Copy the first AUTOVAC_QUEUE_PER_WORKER entries of the sorted candidate
+ * array into our part of the shared work queue.
+ */
+static void
+autovac_publish_queue(av_candidate *candidates, int ncandidates)
+{
+	AutoVacQueueEntry *queue = MyWorkerInfo->wi_queue;
+	int			nentries = Min(ncandidates, AUTOVAC_QUEUE_PER_WORKER);
+	int			i;
+
+	LWLockAcquire(AutovacuumLock, LW_EXCLUSIVE);
+	for (i = 0; i < nentries; i++)
+	{
+		queue[i].aq_relid = candidates[i].ac_relid;
+		queue[i].aq_priority = candidates[i].ac_priority;
+		queue[i].aq_dovacuum = candidates[i].ac_dovacuum;
+		queue[i].aq_doanalyze = candidates[i].ac_doanalyze;
+		queue[i].aq_wraparound = candidates[i].ac_wraparound;
+		queue[i].aq_dead_tuples = candidates[i].ac_dead_tuples;
+		queue[i].aq_xid_age = candidates[i].ac_xid_age;
+		queue[i].aq_relpages = candidates[i].ac_relpages;
+	}
+	MyWorkerInfo->wi_queue_len = nentries;
+	MyWorkerInfo->wi_queue_next = 0;
+	LWLockRelease(AutovacuumLock);
+}
+
 /*
  * table_recheck_autovac
  *
@@ -2474,6 +2708,7 @@ table_recheck_autovac(Oid relid, HTAB *table_toast_map,
 	PgStat_StatDBEntry *shared;
 	PgStat_StatDBEntry *dbentry;
 	bool		wraparound;
+	double		priority;
 	AutoVacOpts *avopts;
 
 	/* use fresh stats */
@@ -2509,7 +2744,7 @@ table_recheck_autovac(Oid relid, HTAB *table_toast_map,
 										 shared, dbentry);
 
 	relation_needs_vacanalyze(relid, avopts, classForm, tabentry,
-							  &dovacuum, &doanalyze, &wraparound);
+							  &dovacuum, &doanalyze, &wraparound, &priority);
 
 	/* ignore ANALYZE for toast tables */
 	if (classForm->relkind == RELKIND_TOASTVALUE)
@@ -2622,6 +2857,15 @@ table_recheck_autovac(Oid relid, HTAB *table_toast_map,
  * autovacuum_vacuum_threshold GUC variable.  Similarly, a vac_scale_factor
  * value < 0 is substituted with the value of
  * autovacuum_vacuum_scale_factor GUC variable.  Ditto for analyze.
+ *
+ * We also return a priority for the table, which decides the order in which
+ * the tables of a database are processed.  Tables vacuumed for wraparound
+ * come first, oldest first.  For the rest, the priority starts from how far
+ * the table is past its vacuum or analyze threshold, or how close it is to
+ * freeze_max_age, whichever is larger.  That is raised for tables that are
+ * accumulating dead tuples quickly relative to their size, and lowered
+ * (logarithmically) for very large tables, so that a big table barely over
+ * its threshold doesn't hold up many small ones that are bloating fast.
  */
 static void
 relation_needs_vacanalyze(Oid relid,
@@ -2631,7 +2875,8 @@ relation_needs_vacanalyze(Oid relid,
  /* output params below */
 						  bool *dovacuum,
 						  bool *doanalyze,
-						  bool *wraparound)
+						  bool *wraparound,
+						  double *priority)
 {
 	bool		force_vacuum;
 	bool		av_enabled;
@@ -2657,6 +2902,10 @@ relation_needs_vacanalyze(Oid relid,
 	TransactionId xidForceLimit;
 	MultiXactId multiForceLimit;
 
+	/* fraction of freeze_max_age (resp. multixact_freeze_max_age) used up */
+	double		xid_age_frac = 0.0;
+	double		multi_age_frac = 0.0;
+
 	AssertArg(classForm != NULL);
 	AssertArg(OidIsValid(relid));
 
@@ -2710,14 +2959,28 @@ relation_needs_vacanalyze(Oid relid,
 	}
 	*wraparound = force_vacuum;
 
+	if (TransactionIdIsNormal(classForm->relfrozenxid) && freeze_max_age > 0)
+		xid_age_frac = (double) (int32) (recentXid - classForm->relfrozenxid) /
+			freeze_max_age;
+	if (MultiXactIdIsValid(classForm->relminmxid) &&
+		multixact_freeze_max_age > 0)
+		multi_age_frac = (double) (int32) (recentMulti - classForm->relminmxid) /
+			multixact_freeze_max_age;
+
 	/* User disabled it in pg_class.reloptions?  (But ignore if at risk) */
 	if (!force_vacuum && !av_enabled)
 	{
 		*doanalyze = false;
 		*dovacuum = false;
+		*priority = 0.0;
 		return;
 	}
 
+	/* Wraparound vacuums go first, the oldest tables ahead of the others */
+	*priority = Max(xid_age_frac, multi_age_frac);
+	if (force_vacuum)
+		*priority = AUTOVAC_WRAPAROUND_PRIORITY * Max(*priority, 1.0);
+
 	if (PointerIsValid(tabentry))
 	{
 		reltuples = classForm->reltuples;
@@ -2739,6 +3002,42 @@ relation_needs_vacanalyze(Oid relid,
 		/* Determine if this table needs vacuum or analyze. */
 		*dovacuum = force_vacuum || (vactuples > vacthresh);
 		*doanalyze = (anltuples > anlthresh);
+
+		if (!force_vacuum)
+		{
+			TimestampTz last_vacuum;
+			double		growth = 0.0;
+			double		size_units;
+
+			*priority = Max(*priority, vactuples / Max(vacthresh, 1.0));
+			*priority = Max(*priority, anltuples / Max(anlthresh, 1.0));
+
+			/*
+			 * Estimate the fraction of the table that goes dead per naptime
+			 * from the dead tuples accumulated since the last vacuum, and
+			 * scale the priority up by that (capped at ten times).
+			 */
+			last_vacuum = Max(tabentry->vacuum_timestamp,
+							  tabentry->autovac_vacuum_timestamp);
+			if (last_vacuum != 0)
+			{
+				long		secs;
+				int			usecs;
+
+				TimestampDifference(last_vacuum,
+									GetCurrentTransactionStartTimestamp(),
+									&secs, &usecs);
+				growth = (vactuples / Max(reltuples, 1.0)) *
+					autovacuum_naptime / Max(secs, autovacuum_naptime);
+				growth = Min(growth, 10.0);
+			}
+			*priority *= 1.0 + growth;
+
+			/* and lower it gently for tables over a gigabyte */
+			size_units = classForm->relpages / AUTOVAC_PRIORITY_SIZE_UNIT;
+			if (size_units > 1.0)
+				*priority /= 1.0 + log(size_units);
+		}
 	}
 	else
 	{
@@ -2894,12 +3193,16 @@ AutoVacuumShmemSize(void)
 	Size		size;
 
 	/*
-	 * Need the fixed struct and the array of WorkerInfoData.
+	 * Need the fixed struct, the array of WorkerInfoData and the work queue.
 	 */
 	size = sizeof(AutoVacuumShmemStruct);
 	size = MAXALIGN(size);
 	size = add_size(size, mul_size(autovacuum_max_workers,
 								   sizeof(WorkerInfoData)));
+	size = MAXALIGN(size);
+	size = add_size(size, mul_size(mul_size(autovacuum_max_workers,
+											AUTOVAC_QUEUE_PER_WORKER),
+								   sizeof(AutoVacQueueEntry)));
 	return size;
 }
 
@@ -2920,6 +3223,7 @@ AutoVacuumShmemInit(void)
 	if (!IsUnderPostmaster)
 	{
 		WorkerInfo	worker;
+		AutoVacQueueEntry *queue;
 		int			i;
 
 		Assert(!found);
@@ -2931,16 +3235,112 @@ AutoVacuumShmemInit(void)
 
 		worker = (WorkerInfo) ((char *) AutoVacuumShmem +
 							   MAXALIGN(sizeof(AutoVacuumShmemStruct)));
+		queue = (AutoVacQueueEntry *)
+			((char *) worker +
+			 MAXALIGN(autovacuum_max_workers * sizeof(WorkerInfoData)));
 
 		/* initialize the WorkerInfo free list */
 		for (i = 0; i < autovacuum_max_workers; i++)
+		{
+			worker[i].wi_queue = &queue[i * AUTOVAC_QUEUE_PER_WORKER];
+			worker[i].wi_queue_len = 0;
+			worker[i].wi_queue_next = 0;
 			dlist_push_head(&AutoVacuumShmem->av_freeWorkers,
 							&worker[i].wi_links);
+		}
 	}
 	else
 		Assert(found);
 }
 
+/*
+ * pg_stat_get_autovacuum_queue
+ *		Returns the tables that running autovacuum workers have yet to process
+ *
+ * Each worker publishes the tables it is going to vacuum or analyze, in the
+ * order it is going to process them; we return the ones it hasn't gotten to
+ * yet, plus the one it's working on right now.
+ */
+Datum
+pg_stat_get_autovacuum_queue(PG_FUNCTION_ARGS)
+{
+#define PG_STAT_GET_AUTOVACUUM_QUEUE_COLS	11
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	TupleDesc	tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext per_query_ctx;
+	MemoryContext oldcontext;
+	dlist_iter	iter;
+
+	/* check to see if caller supports us returning a tuplestore */
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("set-valued function called in context that cannot accept a set")));
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("materialize mode required, but it is not " \
+						"allowed in this context")));
+
+	/* Build a tuple descriptor for our result type */
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	/*
+	 * wi_tableoid is protected by AutovacuumScheduleLock, not AutovacuumLock,
+	 * but it is only used to tell which entry is in progress, so a slightly
+	 * stale value is harmless.
+	 */
+	LWLockAcquire(AutovacuumLock, LW_SHARED);
+	dlist_foreach(iter, &AutoVacuumShmem->av_runningWorkers)
+	{
+		WorkerInfo	worker = dlist_container(WorkerInfoData, wi_links, iter.cur);
+		int			i;
+
+		for (i = worker->wi_queue_next; i < worker->wi_queue_len; i++)
+		{
+			AutoVacQueueEntry *entry = &worker->wi_queue[i];
+			Datum		values[PG_STAT_GET_AUTOVACUUM_QUEUE_COLS];
+			bool		nulls[PG_STAT_GET_AUTOVACUUM_QUEUE_COLS];
+
+			memset(nulls, 0, sizeof(nulls));
+			values[0] = ObjectIdGetDatum(worker->wi_dboid);
+			values[1] = ObjectIdGetDatum(entry->aq_relid);
+			if (worker->wi_proc != NULL)
+				values[2] = Int32GetDatum(worker->wi_proc->pid);
+			else
+				nulls[2] = true;
+			values[3] = BoolGetDatum(entry->aq_relid == worker->wi_tableoid);
+			values[4] = Float8GetDatum(entry->aq_priority);
+			values[5] = BoolGetDatum(entry->aq_dovacuum);
+			values[6] = BoolGetDatum(entry->aq_doanalyze);
+			values[7] = BoolGetDatum(entry->aq_wraparound);
+			values[8] = Int64GetDatum(entry->aq_dead_tuples);
+			values[9] = Int32GetDatum(entry->aq_xid_age);
+			values[10] = Int32GetDatum((int32) entry->aq_relpages);
+
+			tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+		}
+	}
+	LWLockRelease(AutovacuumLock);
+
+	/* clean up and return the tuplestore */
+	tuplestore_donestoring(tupstore);
+
+	return (Datum) 0;
+}
+
 /*
  * autovac_refresh_stats
  *		Refresh pgstats data for an autovacuum process
@@ -16,6 +16,8 @@
 #include <time.h>
 
 #include "miscadmin.h"
+#include "commands/copy.h"
+#include "commands/vacuum.h"
 #include "libpq/pqsignal.h"
 #include "postmaster/bgworker_internals.h"
 #include "postmaster/postmaster.h"
@@ -37,6 +39,32 @@
  */
 slist_head BackgroundWorkerList = SLIST_STATIC_INIT(BackgroundWorkerList);
 
+/*
+ * Entrypoints for background workers implemented in the core server.
+ *
+ * A worker registered with bgw_library_name "postgres" has its
+ * bgw_function_name looked up here rather than via load_external_function.
+ * Passing a function name rather than a pointer keeps such registrations
+ * valid in EXEC_BACKEND builds, where the address of a function in the
+ * postmaster need not match its address in the child.
+ */
+static const struct
+{
+	const char *fn_name;
+	bgworker_main_type fn_addr;
+} InternalBGWorkers[] =
+{
+	{
+		"lazy_parallel_vacuum_main", lazy_parallel_vacuum_main
+	},
+	{
+		"ParallelCopyWorkerMain", ParallelCopyWorkerMain
+	}
+};
+
+static bgworker_main_type LookupBackgroundWorkerFunction(char *libraryname,
+							   char *funcname);
+
 /*
  * BackgroundWorkerSlots exist in shared memory and can be accessed (via
  * the BackgroundWorkerArray) by both the postmaster and by regular backends.
@@ -642,10 +670,8 @@ StartBackgroundWorker(void)
 	if (worker->bgw_main != NULL)
 		entrypt = worker->bgw_main;
 	else
-		entrypt = (bgworker_main_type)
-			load_external_function(worker->bgw_library_name,
-								   worker->bgw_function_name,
-								   true, NULL);
+		entrypt = LookupBackgroundWorkerFunction(worker->bgw_library_name,
+												 worker->bgw_function_name);
 
 	/*
 	 * Note that in normal processes, we would call InitPostgres here.  For a
@@ -960,3 +986,31 @@ TerminateBackgroundWorker(BackgroundWorkerHandle *handle)
 	if (signal_postmaster)
 		SendPostmasterSignal(PMSIGNAL_BACKGROUND_WORKER_CHANGE);
 }
+
+/*
+ * Look up (and possibly load) a background worker entrypoint function.
+ *
+ * For functions contained in the core code, we use library name "postgres"
+ * and consult the InternalBGWorkers array.  External functions are looked up,
+ * and loaded if necessary, using load_external_function().
+ */
+static bgworker_main_type
+LookupBackgroundWorkerFunction(char *libraryname, char *funcname)
+{
+	if (strcmp(libraryname, "postgres") == 0)
+	{
+		int			i;
+
+		for (i = 0; i < lengthof(InternalBGWorkers); i++)
+		{
+			if (strcmp(InternalBGWorkers[i].fn_name, funcname) == 0)
+				return InternalBGWorkers[i].fn_addr;
+		}
+
+		/* We can only reach this by programming error. */
+		elog(ERROR, "internal function \"%s\" not found", funcname);
+	}
+
+	return (bgworker_main_type)
+		load_external_function(libraryname, funcname, true, NULL);
+}
@@ -16,9 +16,16 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include <time.h>
+#ifdef HAVE_LIBZ
+#include <zlib.h>
+#endif
 
 #include "access/xlog_internal.h"		/* for pg_start/stop_backup */
+#include "access/xlogreader.h"
+#include "catalog/pg_tablespace.h"
 #include "catalog/pg_type.h"
+#include "commands/dbcommands.h"
+#include "commands/tablespace.h"
 #include "common/relpath.h"
 #include "lib/stringinfo.h"
 #include "libpq/libpq.h"
@@ -28,12 +35,15 @@
 #include "pgtar.h"
 #include "pgstat.h"
 #include "replication/basebackup.h"
+#include "replication/logicalfuncs.h"
 #include "replication/walsender.h"
 #include "replication/walsender_private.h"
+#include "storage/bufpage.h"
 #include "storage/fd.h"
 #include "storage/ipc.h"
 #include "utils/builtins.h"
 #include "utils/elog.h"
+#include "utils/pg_crc.h"
 #include "utils/ps_status.h"
 #include "utils/timestamp.h"
 
@@ -46,6 +56,9 @@ typedef struct
 	bool		nowait;
 	bool		includewal;
 	uint32		maxrate;
+	XLogRecPtr	incremental;
+	int			compresslevel;
+	bool		manifest;
 } basebackup_options;
 
 
@@ -53,6 +66,12 @@ static int64 sendDir(char *path, int basepathlen, bool sizeonly, List *tablespac
 static int64 sendTablespace(char *path, bool sizeonly);
 static bool sendFile(char *readfilename, char *tarfilename,
 		 struct stat * statbuf, bool missing_ok);
+static bool sendIncrementalFile(FILE *fp, char *tarfilename,
+					struct stat * statbuf);
+static bool is_relation_file(const char *tarfilename);
+static bool is_incremental_candidate(char *readfilename, char *tarfilename);
+static void scan_created_dirs(XLogRecPtr startptr);
+static void scan_created_dirs_callback(void *arg);
 static void sendFileWithContent(const char *filename, const char *content);
 static void _tarWriteHeader(const char *filename, const char *linktarget,
 				struct stat * statbuf);
@@ -64,6 +83,11 @@ static void parse_basebackup_options(List *options, basebackup_options *opt);
 static void SendXlogRecPtrResult(XLogRecPtr ptr, TimeLineID tli);
 static int	compareWalFileNames(const void *a, const void *b);
 static void throttle(size_t increment);
+static void begin_copy_stream(void);
+static void end_copy_stream(void);
+static void send_data(const char *data, size_t len);
+static void manifest_add(const char *filename, pgoff_t size, pg_crc32 crc);
+static void send_manifest(void);
 
 /* Was the backup currently in-progress initiated in recovery mode? */
 static bool backup_started_in_recovery = false;
@@ -71,6 +95,29 @@ static bool backup_started_in_recovery = false;
 /* Relative path of temporary statistics directory */
 static char *statrelpath = NULL;
 
+/*
+ * For an incremental backup, the location after which changed blocks must
+ * be sent; InvalidXLogRecPtr for a full backup.
+ */
+static XLogRecPtr incremental_lsn = InvalidXLogRecPtr;
+
+/*
+ * Database directories created by copying another one since incremental_lsn,
+ * and tablespaces created since then (dboid is InvalidOid).  Copied files
+ * keep the page LSNs of the originals, so nothing in these directories can be
+ * sent incrementally.
+ */
+typedef struct
+{
+	Oid			tsoid;
+	Oid			dboid;
+} created_dir;
+
+static List *created_dirs = NIL;
+
+/* OID of the tablespace being sent; InvalidOid for the data directory */
+static Oid	sending_tsoid = InvalidOid;
+
 /*
  * Size of each block sent into the tar stream for larger files.
  */
@@ -93,6 +140,26 @@ static int64 elapsed_min_unit;
 /* The last check of the transfer rate. */
 static int64 throttled_last;
 
+/*
+ * Compression level for the tar streams (COMPRESS option), or 0.  Each
+ * tablespace's stream is compressed separately, as one gzip file.
+ */
+static int	backup_compresslevel = 0;
+#ifdef HAVE_LIBZ
+static z_stream zstream;
+static bool zstream_active = false;
+static char zbuf[TAR_SEND_SIZE];
+#endif
+
+/*
+ * The manifest (MANIFEST option) lists every file sent, with its size and
+ * CRC, one per line; NULL if not requested.  manifest_prefix is what turns
+ * the names of files in the tablespace being sent into paths relative to
+ * the data directory.
+ */
+static StringInfo manifest = NULL;
+static char *manifest_prefix = "";
+
 typedef struct
 {
 	char	   *oid;
@@ -136,6 +203,34 @@ perform_base_backup(basebackup_options *opt, DIR *tblspcdir)
 								  &labelfile);
 	SendXlogRecPtrResult(startptr, starttli);
 
+	/*
+	 * The prior backup an incremental one is based on must have been started
+	 * before this one.  Otherwise blocks modified in between would be
+	 * missing from both.
+	 */
+	if (opt->incremental > startptr)
+	{
+		do_pg_abort_backup();
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("incremental backup location %X/%X is later than the backup start location %X/%X",
+						(uint32) (opt->incremental >> 32),
+						(uint32) opt->incremental,
+						(uint32) (startptr >> 32), (uint32) startptr)));
+	}
+	incremental_lsn = opt->incremental;
+	created_dirs = NIL;
+	backup_compresslevel = opt->compresslevel;
+
+	if (opt->manifest)
+	{
+		manifest = makeStringInfo();
+		appendStringInfoString(manifest,
+							   "# PostgreSQL backup manifest: path, size, CRC-32\n");
+	}
+	else
+		manifest = NULL;
+
 	/*
 	 * Calculate the relative path of temporary statistics directory
 	 * in order to skip the files which are located in that directory later.
@@ -155,6 +250,9 @@ perform_base_backup(basebackup_options *opt, DIR *tblspcdir)
 		struct dirent *de;
 		tablespaceinfo *ti;
 
+		if (!XLogRecPtrIsInvalid(incremental_lsn))
+			scan_created_dirs(startptr);
+
 		/* Collect information about all tablespaces */
 		while ((de = ReadDir(tblspcdir, "pg_tblspc")) != NULL)
 		{
@@ -252,13 +350,19 @@ perform_base_backup(basebackup_options *opt, DIR *tblspcdir)
 		foreach(lc, tablespaces)
 		{
 			tablespaceinfo *ti = (tablespaceinfo *) lfirst(lc);
-			StringInfoData buf;
 
-			/* Send CopyOutResponse message */
-			pq_beginmessage(&buf, 'H');
-			pq_sendbyte(&buf, 0);		/* overall format */
-			pq_sendint(&buf, 0, 2);		/* natts */
-			pq_endmessage(&buf);
+			begin_copy_stream();
+
+			if (ti->path == NULL)
+			{
+				manifest_prefix = "";
+				sending_tsoid = InvalidOid;
+			}
+			else
+			{
+				manifest_prefix = psprintf("pg_tblspc/%s/", ti->oid);
+				sending_tsoid = (Oid) strtoul(ti->oid, NULL, 10);
+			}
 
 			if (ti->path == NULL)
 			{
@@ -292,7 +396,11 @@ perform_base_backup(basebackup_options *opt, DIR *tblspcdir)
 				Assert(lnext(lc) == NULL);
 			}
 			else
-				pq_putemptymessage('c');		/* CopyDone */
+			{
+				if (ti->path == NULL)
+					send_manifest();
+				end_copy_stream();
+			}
 		}
 	}
 	PG_END_ENSURE_ERROR_CLEANUP(base_backup_cleanup, (Datum) 0);
@@ -432,6 +540,7 @@ perform_base_backup(basebackup_options *opt, DIR *tblspcdir)
 			char		buf[TAR_SEND_SIZE];
 			size_t		cnt;
 			pgoff_t		len = 0;
+			pg_crc32	crc;
 
 			snprintf(pathbuf, MAXPGPATH, XLOGDIR "/%s", walFiles[i]);
 			XLogFromFileName(walFiles[i], &tli, &segno);
@@ -466,13 +575,13 @@ perform_base_backup(basebackup_options *opt, DIR *tblspcdir)
 
 			_tarWriteHeader(pathbuf, NULL, &statbuf);
 
+			INIT_CRC32(crc);
 			while ((cnt = fread(buf, 1, Min(sizeof(buf), XLogSegSize - len), fp)) > 0)
 			{
 				CheckXLogRemoved(segno, tli);
 				/* Send the chunk as a CopyData message */
-				if (pq_putmessage('d', buf, cnt))
-					ereport(ERROR,
-							(errmsg("base backup could not send data, aborting backup")));
+				send_data(buf, cnt);
+				COMP_CRC32(crc, buf, cnt);
 
 				len += cnt;
 				throttle(cnt);
@@ -488,6 +597,8 @@ perform_base_backup(basebackup_options *opt, DIR *tblspcdir)
 						(errcode_for_file_access(),
 					errmsg("unexpected WAL file size \"%s\"", walFiles[i])));
 			}
+			FIN_CRC32(crc);
+			manifest_add(pathbuf, len, crc);
 
 			/* XLogSegSize is a multiple of 512, so no need for padding */
 			FreeFile(fp);
@@ -516,8 +627,9 @@ perform_base_backup(basebackup_options *opt, DIR *tblspcdir)
 			sendFile(pathbuf, pathbuf, &statbuf, false);
 		}
 
-		/* Send CopyDone message for the last tar file */
-		pq_putemptymessage('c');
+		/* Send the manifest and CopyDone message for the last tar file */
+		send_manifest();
+		end_copy_stream();
 	}
 	SendXlogRecPtrResult(endptr, endtli);
 }
@@ -548,6 +660,9 @@ parse_basebackup_options(List *options, basebackup_options *opt)
 	bool		o_nowait = false;
 	bool		o_wal = false;
 	bool		o_maxrate = false;
+	bool		o_incremental = false;
+	bool		o_compress = false;
+	bool		o_manifest = false;
 
 	MemSet(opt, 0, sizeof(*opt));
 	foreach(lopt, options)
@@ -618,6 +733,59 @@ parse_basebackup_options(List *options, basebackup_options *opt)
 			opt->maxrate = (uint32) maxrate;
 			o_maxrate = true;
 		}
+		else if (strcmp(defel->defname, "incremental") == 0)
+		{
+			uint32		hi,
+						lo;
+
+			if (o_incremental)
+				ereport(ERROR,
+						(errcode(ERRCODE_SYNTAX_ERROR),
+						 errmsg("duplicate option \"%s\"", defel->defname)));
+
+			if (sscanf(strVal(defel->arg), "%X/%X", &hi, &lo) != 2 ||
+				(hi == 0 && lo == 0))
+				ereport(ERROR,
+						(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+						 errmsg("invalid value for parameter \"%s\": \"%s\"",
+								"INCREMENTAL", strVal(defel->arg))));
+
+			opt->incremental = ((uint64) hi) << 32 | lo;
+			o_incremental = true;
+		}
+		else if (strcmp(defel->defname, "compress") == 0)
+		{
+			long		level;
+
+			if (o_compress)
+				ereport(ERROR,
+						(errcode(ERRCODE_SYNTAX_ERROR),
+						 errmsg("duplicate option \"%s\"", defel->defname)));
+
+			level = intVal(defel->arg);
+			if (level < 1 || level > 9)
+				ereport(ERROR,
+						(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+						 errmsg("%d is outside the valid range for parameter \"%s\" (%d .. %d)",
+								(int) level, "COMPRESS", 1, 9)));
+#ifndef HAVE_LIBZ
+			ereport(ERROR,
+					(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					 errmsg("compression is not supported by this build")));
+#endif
+
+			opt->compresslevel = (int) level;
+			o_compress = true;
+		}
+		else if (strcmp(defel->defname, "manifest") == 0)
+		{
+			if (o_manifest)
+				ereport(ERROR,
+						(errcode(ERRCODE_SYNTAX_ERROR),
+						 errmsg("duplicate option \"%s\"", defel->defname)));
+			opt->manifest = true;
+			o_manifest = true;
+		}
 		else
 			elog(ERROR, "option \"%s\" not recognized",
 				 defel->defname);
@@ -805,6 +973,7 @@ sendFileWithContent(const char *filename, const char *content)
 	struct stat statbuf;
 	int			pad,
 				len;
+	pg_crc32	crc;
 
 	len = strlen(content);
 
@@ -826,7 +995,12 @@ sendFileWithContent(const char *filename, const char *content)
 
 	_tarWriteHeader(filename, NULL, &statbuf);
 	/* Send the contents as a CopyData message */
-	pq_putmessage('d', content, len);
+	send_data(content, len);
+
+	INIT_CRC32(crc);
+	COMP_CRC32(crc, content, len);
+	FIN_CRC32(crc);
+	manifest_add(filename, len, crc);
 
 	/* Pad to 512 byte boundary, per tar format requirements */
 	pad = ((len + 511) & ~511) - len;
@@ -835,7 +1009,7 @@ sendFileWithContent(const char *filename, const char *content)
 		char		buf[512];
 
 		MemSet(buf, 0, pad);
-		pq_putmessage('d', buf, pad);
+		send_data(buf, pad);
 	}
 }
 
@@ -957,6 +1131,10 @@ sendDir(char *path, int basepathlen, bool sizeonly, List *tablespaces)
 		if (strcmp(pathbuf, "./global/pg_control") == 0)
 			continue;
 
+		/* Skip a manifest left behind by restoring an earlier backup */
+		if (strcmp(pathbuf, "./" BACKUP_MANIFEST_FILE) == 0)
+			continue;
+
 		if (lstat(pathbuf, &statbuf) != 0)
 		{
 			if (errno != ENOENT)
@@ -1149,6 +1327,7 @@ sendFile(char *readfilename, char *tarfilename, struct stat * statbuf,
 	size_t		cnt;
 	pgoff_t		len = 0;
 	size_t		pad;
+	pg_crc32	crc;
 
 	fp = AllocateFile(readfilename, "rb");
 	if (fp == NULL)
@@ -1169,14 +1348,23 @@ sendFile(char *readfilename, char *tarfilename, struct stat * statbuf,
 				(errmsg("archive member \"%s\" too large for tar format",
 						tarfilename)));
 
+	if (!XLogRecPtrIsInvalid(incremental_lsn) &&
+		statbuf->st_size % BLCKSZ == 0 &&
+		is_incremental_candidate(readfilename, tarfilename) &&
+		sendIncrementalFile(fp, tarfilename, statbuf))
+	{
+		FreeFile(fp);
+		return true;
+	}
+
 	_tarWriteHeader(tarfilename, NULL, statbuf);
 
+	INIT_CRC32(crc);
 	while ((cnt = fread(buf, 1, Min(sizeof(buf), statbuf->st_size - len), fp)) > 0)
 	{
 		/* Send the chunk as a CopyData message */
-		if (pq_putmessage('d', buf, cnt))
-			ereport(ERROR,
-			   (errmsg("base backup could not send data, aborting backup")));
+		send_data(buf, cnt);
+		COMP_CRC32(crc, buf, cnt);
 
 		len += cnt;
 		throttle(cnt);
@@ -1199,11 +1387,14 @@ sendFile(char *readfilename, char *tarfilename, struct stat * statbuf,
 		while (len < statbuf->st_size)
 		{
 			cnt = Min(sizeof(buf), statbuf->st_size - len);
-			pq_putmessage('d', buf, cnt);
+			send_data(buf, cnt);
+			COMP_CRC32(crc, buf, cnt);
 			len += cnt;
 			throttle(cnt);
 		}
 	}
+	FIN_CRC32(crc);
+	manifest_add(tarfilename, len, crc);
 
 	/*
 	 * Pad to 512 byte boundary, per tar format requirements. (This small
@@ -1213,7 +1404,7 @@ sendFile(char *readfilename, char *tarfilename, struct stat * statbuf,
 	if (pad > 0)
 	{
 		MemSet(buf, 0, pad);
-		pq_putmessage('d', buf, pad);
+		send_data(buf, pad);
 	}
 
 	FreeFile(fp);
@@ -1221,6 +1412,327 @@ sendFile(char *readfilename, char *tarfilename, struct stat * statbuf,
 	return true;
 }
 
+/*
+ * Does the tar member name refer to a segment of a relation's main fork?
+ *
+ * Only those are candidates for being sent incrementally.  The other forks
+ * are small, and the free space map and visibility map are not reliably
+ * stamped with the LSN of their latest change (visibility map bits are
+ * cleared without a WAL record of their own), so they are always sent whole.
+ */
+static bool
+is_relation_file(const char *tarfilename)
+{
+	const char *fname;
+	const char *p;
+
+	if (strncmp(tarfilename, "base/", 5) != 0 &&
+		strncmp(tarfilename, "global/", 7) != 0 &&
+		strncmp(tarfilename, TABLESPACE_VERSION_DIRECTORY "/",
+				strlen(TABLESPACE_VERSION_DIRECTORY) + 1) != 0)
+		return false;
+
+	fname = last_dir_separator(tarfilename);
+	fname = fname ? fname + 1 : tarfilename;
+
+	/* relfilenode, optionally followed by a segment number */
+	p = fname;
+	if (!isdigit((unsigned char) *p))
+		return false;
+	while (isdigit((unsigned char) *p))
+		p++;
+	if (*p == '.')
+	{
+		p++;
+		if (!isdigit((unsigned char) *p))
+			return false;
+		while (isdigit((unsigned char) *p))
+			p++;
+	}
+	return *p == '\0';
+}
+
+/*
+ * May this relation segment be sent incrementally?
+ *
+ * Only if the prior backup is known to hold a copy of every block we would
+ * leave out, which isn't the case if the file was copied, with its page
+ * LSNs, into a database or tablespace directory created since then.  The
+ * main fork of an unlogged relation doesn't need to be correct, as it is
+ * reset from the init fork at the end of recovery, but its pages don't have
+ * real LSNs either (GiST uses a counter), so it is sent whole too.
+ */
+static bool
+is_incremental_candidate(char *readfilename, char *tarfilename)
+{
+	Oid			tsoid;
+	Oid			dboid;
+	ListCell   *lc;
+	char		initpath[MAXPGPATH];
+	char	   *p;
+	struct stat st;
+
+	if (!is_relation_file(tarfilename))
+		return false;
+
+	/* Which tablespace and database directory does it belong to? */
+	if (strncmp(tarfilename, "base/", 5) == 0)
+	{
+		tsoid = DEFAULTTABLESPACE_OID;
+		dboid = (Oid) strtoul(tarfilename + 5, NULL, 10);
+	}
+	else if (strncmp(tarfilename, "global/", 7) == 0)
+	{
+		tsoid = GLOBALTABLESPACE_OID;
+		dboid = InvalidOid;
+	}
+	else
+	{
+		tsoid = sending_tsoid;
+		dboid = (Oid) strtoul(tarfilename +
+							  strlen(TABLESPACE_VERSION_DIRECTORY) + 1,
+							  NULL, 10);
+	}
+
+	foreach(lc, created_dirs)
+	{
+		created_dir *dir = (created_dir *) lfirst(lc);
+
+		if (dir->tsoid == tsoid &&
+			(dir->dboid == InvalidOid || dir->dboid == dboid))
+			return false;
+	}
+
+	/* The init fork is named after the first segment: strip ".N", add _init */
+	strlcpy(initpath, readfilename, sizeof(initpath));
+	p = strrchr(initpath, '.');
+	if (p != NULL && p > last_dir_separator(initpath))
+		*p = '\0';
+	strlcat(initpath, "_init", sizeof(initpath));
+	if (lstat(initpath, &st) == 0)
+		return false;
+
+	return true;
+}
+
+/*
+ * Find the directories whose files can't be sent incrementally, see
+ * created_dirs, by reading the WAL written since incremental_lsn.
+ *
+ * The scan goes up to the latest WAL flushed, past the start of this backup,
+ * to also catch databases created while it was starting; one created after
+ * that is copied again when the backup is restored, by replay of its
+ * creation record, but the incremental files sent for it can't be combined.
+ */
+static void
+scan_created_dirs(XLogRecPtr startptr)
+{
+	XLogReaderState *reader;
+	XLogRecord *record;
+	XLogRecPtr	endptr;
+	char	   *errormsg;
+	ErrorContextCallback errcallback;
+
+	endptr = backup_started_in_recovery ?
+		GetXLogReplayRecPtr(NULL) : GetFlushRecPtr();
+	if (endptr < startptr)
+		endptr = startptr;
+
+	errcallback.callback = scan_created_dirs_callback;
+	errcallback.arg = NULL;
+	errcallback.previous = error_context_stack;
+	error_context_stack = &errcallback;
+
+	reader = XLogReaderAllocate(logical_read_local_xlog_page, NULL);
+	if (reader == NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_OUT_OF_MEMORY),
+				 errmsg("out of memory")));
+
+	/* a backup's start location is the redo pointer of a checkpoint */
+	if (!XRecOffIsValid(incremental_lsn))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("incremental backup location %X/%X is not a valid backup start location",
+						(uint32) (incremental_lsn >> 32),
+						(uint32) incremental_lsn)));
+
+	record = XLogReadRecord(reader, incremental_lsn, &errormsg);
+	while (record != NULL && reader->ReadRecPtr < endptr)
+	{
+		uint8		info = record->xl_info & ~XLR_INFO_MASK;
+
+		if (record->xl_rmid == RM_DBASE_ID && info == XLOG_DBASE_CREATE)
+		{
+			xl_dbase_create_rec *xlrec;
+			created_dir *dir = palloc(sizeof(created_dir));
+
+			xlrec = (xl_dbase_create_rec *) XLogRecGetData(record);
+			dir->tsoid = xlrec->tablespace_id;
+			dir->dboid = xlrec->db_id;
+			created_dirs = lappend(created_dirs, dir);
+		}
+		else if (record->xl_rmid == RM_TBLSPC_ID && info == XLOG_TBLSPC_CREATE)
+		{
+			xl_tblspc_create_rec *xlrec;
+			created_dir *dir = palloc(sizeof(created_dir));
+
+			xlrec = (xl_tblspc_create_rec *) XLogRecGetData(record);
+			dir->tsoid = xlrec->ts_id;
+			dir->dboid = InvalidOid;
+			created_dirs = lappend(created_dirs, dir);
+		}
+
+		if (reader->EndRecPtr >= endptr)
+			break;
+		record = XLogReadRecord(reader, InvalidXLogRecPtr, &errormsg);
+	}
+
+	if (record == NULL)
+	{
+		if (errormsg)
+			ereport(ERROR,
+					(errmsg("could not read WAL record at %X/%X: %s",
+							(uint32) (reader->ReadRecPtr >> 32),
+							(uint32) reader->ReadRecPtr, errormsg)));
+		else
+			ereport(ERROR,
+					(errmsg("could not read WAL record at %X/%X",
+							(uint32) (reader->ReadRecPtr >> 32),
+							(uint32) reader->ReadRecPtr)));
+	}
+
+	XLogReaderFree(reader);
+	error_context_stack = errcallback.previous;
+}
+
+static void
+scan_created_dirs_callback(void *arg)
+{
+	errcontext("reading the WAL written since the prior backup's start location %X/%X",
+			   (uint32) (incremental_lsn >> 32), (uint32) incremental_lsn);
+}
+
+/*
+ * Send a relation segment as an incremental file.
+ *
+ * A block is included if its page LSN is newer than incremental_lsn, or if
+ * the page is new (all zeroes); a new page might belong to a relation that
+ * has reused the relfilenode of one dropped since the prior backup, so it
+ * must not be taken from that backup.  Pages without an LSN, such as those
+ * of hash indexes, which aren't WAL-logged, are included as well.  Every
+ * other block was last changed before the prior backup started, so the
+ * prior backup holds a correct copy of it, see is_incremental_candidate.
+ * Changes made after *this* backup's start are fixed up by WAL replay as
+ * usual, so it doesn't matter whether we see them.
+ *
+ * This still reads the whole file, but only ships what has changed.  The
+ * format is described in replication/basebackup.h.
+ *
+ * Returns false, with fp rewound, if every block changed; the caller then
+ * sends the file in full.
+ */
+static bool
+sendIncrementalFile(FILE *fp, char *tarfilename, struct stat * statbuf)
+{
+	IncrementalFileHeader hdr;
+	struct stat incrstat;
+	BlockNumber nblocks = statbuf->st_size / BLCKSZ;
+	BlockNumber blkno;
+	BlockNumber *changed;
+	uint32		nchanged = 0;
+	char	   *page;
+	char	   *incrname;
+	pgoff_t		len;
+	size_t		cnt;
+	size_t		pad;
+	uint32		i;
+	pg_crc32	crc;
+
+	page = palloc(BLCKSZ);
+	changed = palloc(sizeof(BlockNumber) * Max(nblocks, 1));
+
+	/* First pass: find the blocks that have changed */
+	for (blkno = 0; blkno < nblocks; blkno++)
+	{
+		cnt = fread(page, 1, BLCKSZ, fp);
+		if (cnt < BLCKSZ)
+		{
+			/* Truncated while we read it; WAL replay will take care of it */
+			nblocks = blkno;
+			break;
+		}
+		if (PageIsNew(page) ||
+			PageGetLSN(page) == InvalidXLogRecPtr ||
+			PageGetLSN(page) > incremental_lsn)
+			changed[nchanged++] = blkno;
+	}
+
+	if (nchanged == nblocks)
+	{
+		pfree(page);
+		pfree(changed);
+		if (fseeko(fp, 0, SEEK_SET) != 0)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not seek in file \"%s\": %m",
+							tarfilename)));
+		return false;
+	}
+
+	hdr.magic = INCREMENTAL_MAGIC;
+	hdr.nblocks = nblocks;
+	hdr.nchanged = nchanged;
+	hdr.fromlsn_hi = (uint32) (incremental_lsn >> 32);
+	hdr.fromlsn_lo = (uint32) incremental_lsn;
+
+	len = sizeof(hdr) + (pgoff_t) nchanged * (sizeof(BlockNumber) + BLCKSZ);
+	incrstat = *statbuf;
+	incrstat.st_size = len;
+	incrname = psprintf("%s%s", tarfilename, INCREMENTAL_FILE_SUFFIX);
+	_tarWriteHeader(incrname, NULL, &incrstat);
+
+	send_data((char *) &hdr, sizeof(hdr));
+	send_data((char *) changed, sizeof(BlockNumber) * nchanged);
+	throttle(sizeof(hdr) + sizeof(BlockNumber) * nchanged);
+	INIT_CRC32(crc);
+	COMP_CRC32(crc, &hdr, sizeof(hdr));
+	COMP_CRC32(crc, changed, sizeof(BlockNumber) * nchanged);
+
+	/* Second pass: send the changed blocks */
+	for (i = 0; i < nchanged; i++)
+	{
+		if (fseeko(fp, (pgoff_t) changed[i] * BLCKSZ, SEEK_SET) != 0)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not seek in file \"%s\": %m",
+							tarfilename)));
+		cnt = fread(page, 1, BLCKSZ, fp);
+		/* If the file was truncated meanwhile, pad with zeros */
+		if (cnt < BLCKSZ)
+			MemSet(page + cnt, 0, BLCKSZ - cnt);
+
+		send_data(page, BLCKSZ);
+		COMP_CRC32(crc, page, BLCKSZ);
+		throttle(BLCKSZ);
+	}
+	FIN_CRC32(crc);
+	manifest_add(incrname, len, crc);
+	pfree(incrname);
+
+	/* Pad to 512 byte boundary, per tar format requirements */
+	pad = ((len + 511) & ~511) - len;
+	if (pad > 0)
+	{
+		MemSet(page, 0, pad);
+		send_data(page, pad);
+	}
+
+	pfree(page);
+	pfree(changed);
+
+	return true;
+}
 
 static void
 _tarWriteHeader(const char *filename, const char *linktarget,
@@ -1232,7 +1744,150 @@ _tarWriteHeader(const char *filename, const char *linktarget,
 					statbuf->st_mode, statbuf->st_uid, statbuf->st_gid,
 					statbuf->st_mtime);
 
-	pq_putmessage('d', h, 512);
+	send_data(h, 512);
+}
+
+/*
+ * Start sending one tar stream, for one tablespace.
+ */
+static void
+begin_copy_stream(void)
+{
+	StringInfoData buf;
+
+	/* Send CopyOutResponse message */
+	pq_beginmessage(&buf, 'H');
+	pq_sendbyte(&buf, 0);		/* overall format */
+	pq_sendint(&buf, 0, 2);		/* natts */
+	pq_endmessage(&buf);
+
+#ifdef HAVE_LIBZ
+	if (backup_compresslevel > 0)
+	{
+		/* Clean up after a previous backup that failed midway */
+		if (zstream_active)
+			deflateEnd(&zstream);
+
+		MemSet(&zstream, 0, sizeof(zstream));
+		/* 15 + 16: maximum window size, with a gzip header and trailer */
+		if (deflateInit2(&zstream, backup_compresslevel, Z_DEFLATED,
+						 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+			ereport(ERROR,
+					(errmsg("could not initialize compression library: %s",
+							zstream.msg ? zstream.msg : "unknown error")));
+		zstream_active = true;
+		zstream.next_out = (Bytef *) zbuf;
+		zstream.avail_out = sizeof(zbuf);
+	}
+#endif
+}
+
+/*
+ * Finish the current tar stream: flush out any compressed data still
+ * pending, then send CopyDone.
+ */
+static void
+end_copy_stream(void)
+{
+#ifdef HAVE_LIBZ
+	if (backup_compresslevel > 0)
+	{
+		int			rc;
+
+		do
+		{
+			rc = deflate(&zstream, Z_FINISH);
+			if (rc != Z_OK && rc != Z_STREAM_END)
+				ereport(ERROR,
+						(errmsg("could not compress data: %s",
+								zstream.msg ? zstream.msg : "unknown error")));
+			if (zstream.avail_out < sizeof(zbuf))
+			{
+				if (pq_putmessage('d', zbuf, sizeof(zbuf) - zstream.avail_out))
+					ereport(ERROR,
+							(errmsg("base backup could not send data, aborting backup")));
+				zstream.next_out = (Bytef *) zbuf;
+				zstream.avail_out = sizeof(zbuf);
+			}
+		} while (rc != Z_STREAM_END);
+
+		deflateEnd(&zstream);
+		zstream_active = false;
+	}
+#endif
+
+	pq_putemptymessage('c');	/* CopyDone */
+}
+
+/*
+ * Send data into the current tar stream, compressing it if requested.
+ */
+static void
+send_data(const char *data, size_t len)
+{
+#ifdef HAVE_LIBZ
+	if (backup_compresslevel > 0)
+	{
+		zstream.next_in = (Bytef *) data;
+		zstream.avail_in = len;
+		while (zstream.avail_in > 0)
+		{
+			if (deflate(&zstream, Z_NO_FLUSH) != Z_OK)
+				ereport(ERROR,
+						(errmsg("could not compress data: %s",
+								zstream.msg ? zstream.msg : "unknown error")));
+			if (zstream.avail_out == 0)
+			{
+				if (pq_putmessage('d', zbuf, sizeof(zbuf)))
+					ereport(ERROR,
+							(errmsg("base backup could not send data, aborting backup")));
+				zstream.next_out = (Bytef *) zbuf;
+				zstream.avail_out = sizeof(zbuf);
+			}
+		}
+		return;
+	}
+#endif
+
+	if (pq_putmessage('d', data, len))
+		ereport(ERROR,
+				(errmsg("base backup could not send data, aborting backup")));
+}
+
+/*
+ * Record a file sent into the tar stream in the manifest, if we are
+ * building one.
+ */
+static void
+manifest_add(const char *filename, pgoff_t size, pg_crc32 crc)
+{
+	if (manifest == NULL)
+		return;
+
+	/* Files in the data directory itself are sent with a "./" prefix */
+	if (strncmp(filename, "./", 2) == 0)
+		filename += 2;
+
+	appendStringInfo(manifest, "%s%s\t" INT64_FORMAT "\t%08X\n",
+					 manifest_prefix, filename, (int64) size, crc);
+}
+
+/*
+ * Send the manifest, as the last file of the main tar stream.
+ */
+static void
+send_manifest(void)
+{
+	StringInfo	m = manifest;
+
+	if (m == NULL)
+		return;
+
+	/* The manifest doesn't list itself */
+	manifest = NULL;
+	sendFileWithContent(BACKUP_MANIFEST_FILE, m->data);
+	pfree(m->data);
+	pfree(m);
 }
 
 /*
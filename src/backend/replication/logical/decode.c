@@ -82,12 +82,23 @@ void
 LogicalDecodingProcessRecord(LogicalDecodingContext *ctx, XLogRecord *record)
 {
 	XLogRecordBuffer buf;
+	TransactionId topxid;
 
 	buf.origptr = ctx->reader->ReadRecPtr;
 	buf.endptr = ctx->reader->EndRecPtr;
 	buf.record = *record;
 	buf.record_data = XLogRecGetData(record);
 
+	/*
+	 * The first record of a subtransaction tells us its toplevel
+	 * transaction, whatever kind of record it is; see
+	 * IsSubTransactionAssignmentPending().
+	 */
+	topxid = XLogRecGetTopXid(record);
+	if (TransactionIdIsValid(topxid))
+		ReorderBufferAssignChild(ctx->reorder, topxid, record->xl_xid,
+								 buf.origptr);
+
 	/* cast so we get a warning when new rmgrs are added */
 	switch ((RmgrIds) buf.record.xl_rmid)
 	{
@@ -331,7 +342,8 @@ DecodeStandbyOp(LogicalDecodingContext *ctx, XLogRecordBuffer *buf)
 				 * while shutdown checkpoints just know that no non-prepared
 				 * transactions are in progress.
 				 */
-				ReorderBufferAbortOld(ctx->reorder, running->oldestRunningXid);
+				ReorderBufferAbortOld(ctx->reorder, running->oldestRunningXid,
+									  buf->origptr);
 			}
 			break;
 		case XLOG_STANDBY_LOCK:
@@ -590,12 +602,15 @@ DecodeInsert(LogicalDecodingContext *ctx, XLogRecordBuffer *buf)
 
 	if (xlrec->flags & XLOG_HEAP_CONTAINS_NEW_TUPLE)
 	{
+		Size		tuplelen = r->xl_len - SizeOfHeapInsert;
+
 		Assert(r->xl_len > (SizeOfHeapInsert + SizeOfHeapHeader));
 
-		change->data.tp.newtuple = ReorderBufferGetTupleBuf(ctx->reorder);
+		change->data.tp.newtuple =
+			ReorderBufferGetTupleBuf(ctx->reorder,
+									 tuplelen - SizeOfHeapHeader);
 
-		DecodeXLogTuple((char *) xlrec + SizeOfHeapInsert,
-						r->xl_len - SizeOfHeapInsert,
+		DecodeXLogTuple((char *) xlrec + SizeOfHeapInsert, tuplelen,
 						change->data.tp.newtuple);
 	}
 
@@ -634,7 +649,8 @@ DecodeUpdate(LogicalDecodingContext *ctx, XLogRecordBuffer *buf)
 	{
 		Assert(r->xl_len > (SizeOfHeapUpdate + SizeOfHeapHeaderLen));
 
-		change->data.tp.newtuple = ReorderBufferGetTupleBuf(ctx->reorder);
+		change->data.tp.newtuple =
+			ReorderBufferGetTupleBuf(ctx->reorder, xlhdr->t_len);
 
 		DecodeXLogTuple(data,
 						xlhdr->t_len + SizeOfHeapHeader,
@@ -648,7 +664,8 @@ DecodeUpdate(LogicalDecodingContext *ctx, XLogRecordBuffer *buf)
 	if (xlrec->flags & XLOG_HEAP_CONTAINS_OLD)
 	{
 		xlhdr = (xl_heap_header_len *) data;
-		change->data.tp.oldtuple = ReorderBufferGetTupleBuf(ctx->reorder);
+		change->data.tp.oldtuple =
+			ReorderBufferGetTupleBuf(ctx->reorder, xlhdr->t_len);
 		DecodeXLogTuple((char *) &xlhdr->header,
 						xlhdr->t_len + SizeOfHeapHeader,
 						change->data.tp.oldtuple);
@@ -686,12 +703,15 @@ DecodeDelete(LogicalDecodingContext *ctx, XLogRecordBuffer *buf)
 	/* old primary key stored */
 	if (xlrec->flags & XLOG_HEAP_CONTAINS_OLD)
 	{
+		Size		tuplelen = r->xl_len - SizeOfHeapDelete;
+
 		Assert(r->xl_len > (SizeOfHeapDelete + SizeOfHeapHeader));
 
-		change->data.tp.oldtuple = ReorderBufferGetTupleBuf(ctx->reorder);
+		change->data.tp.oldtuple =
+			ReorderBufferGetTupleBuf(ctx->reorder,
+									 tuplelen - SizeOfHeapHeader);
 
-		DecodeXLogTuple((char *) xlrec + SizeOfHeapDelete,
-						r->xl_len - SizeOfHeapDelete,
+		DecodeXLogTuple((char *) xlrec + SizeOfHeapDelete, tuplelen,
 						change->data.tp.oldtuple);
 	}
 	ReorderBufferQueueChange(ctx->reorder, r->xl_xid, buf->origptr, change);
@@ -732,6 +752,7 @@ DecodeMultiInsert(LogicalDecodingContext *ctx, XLogRecordBuffer *buf)
 		xl_multi_insert_tuple *xlhdr;
 		int			datalen;
 		ReorderBufferTupleBuf *tuple;
+		HeapTupleHeader header;
 
 		change = ReorderBufferGetChange(ctx->reorder);
 		change->action = REORDER_BUFFER_CHANGE_INSERT;
@@ -746,37 +767,37 @@ DecodeMultiInsert(LogicalDecodingContext *ctx, XLogRecordBuffer *buf)
 		 */
 		if (xlrec->flags & XLOG_HEAP_CONTAINS_NEW_TUPLE)
 		{
-			change->data.tp.newtuple = ReorderBufferGetTupleBuf(ctx->reorder);
+			xlhdr = (xl_multi_insert_tuple *) SHORTALIGN(data);
+			data = ((char *) xlhdr) + SizeOfMultiInsertTuple;
+			datalen = xlhdr->datalen;
+
+			change->data.tp.newtuple =
+				ReorderBufferGetTupleBuf(ctx->reorder, datalen);
 
 			tuple = change->data.tp.newtuple;
 
 			/* not a disk based tuple */
 			ItemPointerSetInvalid(&tuple->tuple.t_self);
 
-			xlhdr = (xl_multi_insert_tuple *) SHORTALIGN(data);
-			data = ((char *) xlhdr) + SizeOfMultiInsertTuple;
-			datalen = xlhdr->datalen;
-
 			/*
 			 * We can only figure this out after reassembling the
 			 * transactions.
 			 */
 			tuple->tuple.t_tableOid = InvalidOid;
-			tuple->tuple.t_data = &tuple->header;
 			tuple->tuple.t_len = datalen
 				+ offsetof(HeapTupleHeaderData, t_bits);
+			header = tuple->tuple.t_data;
 
-			memset(&tuple->header, 0, sizeof(HeapTupleHeaderData));
+			memset(header, 0, offsetof(HeapTupleHeaderData, t_bits));
 
-			memcpy((char *) &tuple->header
-				   + offsetof(HeapTupleHeaderData, t_bits),
+			memcpy((char *) header + offsetof(HeapTupleHeaderData, t_bits),
 				   (char *) data,
 				   datalen);
 			data += datalen;
 
-			tuple->header.t_infomask = xlhdr->t_infomask;
-			tuple->header.t_infomask2 = xlhdr->t_infomask2;
-			tuple->header.t_hoff = xlhdr->t_hoff;
+			header->t_infomask = xlhdr->t_infomask;
+			header->t_infomask2 = xlhdr->t_infomask2;
+			header->t_hoff = xlhdr->t_hoff;
 		}
 
 		ReorderBufferQueueChange(ctx->reorder, r->xl_xid,
@@ -796,9 +817,11 @@ DecodeXLogTuple(char *data, Size len, ReorderBufferTupleBuf *tuple)
 {
 	xl_heap_header xlhdr;
 	int			datalen = len - SizeOfHeapHeader;
+	HeapTupleHeader header;
 
 	Assert(datalen >= 0);
-	Assert(datalen <= MaxHeapTupleSize);
+	Assert(datalen + offsetof(HeapTupleHeaderData, t_bits) <=
+		   tuple->alloc_tuple_size);
 
 	tuple->tuple.t_len = datalen + offsetof(HeapTupleHeaderData, t_bits);
 
@@ -807,20 +830,21 @@ DecodeXLogTuple(char *data, Size len, ReorderBufferTupleBuf *tuple)
 
 	/* we can only figure this out after reassembling the transactions */
 	tuple->tuple.t_tableOid = InvalidOid;
-	tuple->tuple.t_data = &tuple->header;
+
+	header = tuple->tuple.t_data;
 
 	/* data is not stored aligned, copy to aligned storage */
 	memcpy((char *) &xlhdr,
 		   data,
 		   SizeOfHeapHeader);
 
-	memset(&tuple->header, 0, sizeof(HeapTupleHeaderData));
+	memset(header, 0, offsetof(HeapTupleHeaderData, t_bits));
 
-	memcpy((char *) &tuple->header + offsetof(HeapTupleHeaderData, t_bits),
+	memcpy((char *) header + offsetof(HeapTupleHeaderData, t_bits),
 		   data + SizeOfHeapHeader,
 		   datalen);
 
-	tuple->header.t_infomask = xlhdr.t_infomask;
-	tuple->header.t_infomask2 = xlhdr.t_infomask2;
-	tuple->header.t_hoff = xlhdr.t_hoff;
+	header->t_infomask = xlhdr.t_infomask;
+	header->t_infomask2 = xlhdr.t_infomask2;
+	header->t_hoff = xlhdr.t_hoff;
 }
@@ -32,9 +32,23 @@
  *
  *	  In order to cope with large transactions - which can be several times as
  *	  big as the available memory - this module supports spooling the contents
- *	  of a large transactions to disk. When the transaction is replayed the
- *	  contents of individual (sub-)transactions will be read from disk in
- *	  chunks.
+ *	  of a large transactions to disk. The memory used by the decoded changes
+ *	  of all transactions is tracked, and once it exceeds
+ *	  logical_decoding_work_mem the largest (sub-)transaction is spilled, until
+ *	  we're below the limit again (c.f. ReorderBufferCheckMemoryLimit()). When
+ *	  the transaction is replayed the contents of individual
+ *	  (sub-)transactions will be read from disk in chunks.
+ *
+ *	  If the output plugin supports it, the largest toplevel transaction is
+ *	  instead handed to the plugin while still in progress,
+ *	  as a block of changes framed by the stream_start and stream_stop
+ *	  callbacks (c.f. ReorderBufferStreamTXN()). The changes sent are then
+ *	  discarded, and the transaction's remaining changes are streamed once
+ *	  the limit is reached again or once it commits, followed by the
+ *	  stream_commit callback. Should the transaction, or one of its
+ *	  subtransactions, abort, the plugin is told with the stream_abort
+ *	  callback. As cache invalidations are only known at commit, transactions
+ *	  that modified the catalog are not streamed before then.
  *
  *	  This module also has to deal with reassembling toast records from the
  *	  individual chunks stored in WAL. When a new (or initial) version of a
@@ -66,7 +80,7 @@
 #include "replication/logical.h"
 #include "replication/reorderbuffer.h"
 #include "replication/slot.h"
-#include "replication/snapbuild.h" /* just for SnapBuildSnapDecRefcount */
+#include "replication/snapbuild.h"
 
 #include "storage/bufmgr.h"
 #include "storage/fd.h"
@@ -142,29 +156,15 @@ typedef struct ReorderBufferDiskChange
 } ReorderBufferDiskChange;
 
 /*
- * Maximum number of changes kept in memory, per transaction. After that,
- * changes are spooled to disk.
- *
- * The current value should be sufficient to decode the entire transaction
- * without hitting disk in OLTP workloads, while starting to spool to disk in
- * other workloads reasonably fast.
- *
- * At some point in the future it probaly makes sense to have a more elaborate
- * resource management here, but it's not entirely clear what that would look
- * like.
+ * Maximum number of changes of a (sub-)transaction restored from disk at
+ * once, while replaying a transaction that has been spilled.  How much memory
+ * is used for changes before anything is spilled is limited by
+ * logical_decoding_work_mem instead.
  */
 static const Size max_changes_in_memory = 4096;
 
-/*
- * We use a very simple form of a slab allocator for frequently allocated
- * objects, simply keeping a fixed number in a linked list when unused,
- * instead pfree()ing them. Without that in many workloads aset.c becomes a
- * major bottleneck, especially when spilling to disk while decoding batch
- * workloads.
- */
-static const Size max_cached_changes = 4096 * 2;
-static const Size max_cached_tuplebufs = 4096 * 2;		/* ~8MB */
-static const Size max_cached_transactions = 512;
+/* GUC variable */
+int			logical_decoding_work_mem;
 
 
 /* ---------------------------------------
@@ -193,13 +193,25 @@ static ReorderBufferChange *
 static void ReorderBufferIterTXNFinish(ReorderBuffer *rb,
 						   ReorderBufferIterTXNState *state);
 static void ReorderBufferExecuteInvalidations(ReorderBuffer *rb, ReorderBufferTXN *txn);
+static void ReorderBufferProcessTXN(ReorderBuffer *rb, ReorderBufferTXN *txn,
+						XLogRecPtr commit_lsn);
+
+/* ---------------------------------------
+ * streaming of in-progress transactions
+ * ---------------------------------------
+ */
+static bool ReorderBufferCanStreamTXN(ReorderBuffer *rb, ReorderBufferTXN *txn);
+static void ReorderBufferStreamTXN(ReorderBuffer *rb, ReorderBufferTXN *txn);
+static void ReorderBufferTruncateTXN(ReorderBuffer *rb, ReorderBufferTXN *txn);
 
 /*
  * ---------------------------------------
  * Disk serialization support functions
  * ---------------------------------------
  */
-static void ReorderBufferCheckSerializeTXN(ReorderBuffer *rb, ReorderBufferTXN *txn);
+static void ReorderBufferCheckMemoryLimit(ReorderBuffer *rb);
+static ReorderBufferTXN *ReorderBufferLargestTXN(ReorderBuffer *rb);
+static ReorderBufferTXN *ReorderBufferLargestStreamableTopTXN(ReorderBuffer *rb);
 static void ReorderBufferSerializeTXN(ReorderBuffer *rb, ReorderBufferTXN *txn);
 static void ReorderBufferSerializeChange(ReorderBuffer *rb, ReorderBufferTXN *txn,
 							 int fd, ReorderBufferChange *change);
@@ -249,6 +261,28 @@ ReorderBufferAllocate(void)
 
 	buffer->context = new_ctx;
 
+	/*
+	 * Changes and transactions are allocated and freed in large numbers, and
+	 * with aset.c that becomes a major bottleneck, especially when spilling
+	 * to disk while decoding batch workloads.  Use a slab context for each of
+	 * these fixed-size objects, which gives memory of fully freed blocks back
+	 * instead of keeping it on freelists.  Tuples are consumed in roughly the
+	 * order they were decoded, so they go into a generation context.
+	 */
+	buffer->change_context = SlabContextCreate(new_ctx,
+											   "Change",
+											   SLAB_DEFAULT_BLOCK_SIZE,
+											   sizeof(ReorderBufferChange));
+
+	buffer->txn_context = SlabContextCreate(new_ctx,
+											"TXN",
+											SLAB_DEFAULT_BLOCK_SIZE,
+											sizeof(ReorderBufferTXN));
+
+	buffer->tup_context = GenerationContextCreate(new_ctx,
+												  "Tuples",
+												  SLAB_LARGE_BLOCK_SIZE);
+
 	hash_ctl.keysize = sizeof(TransactionId);
 	hash_ctl.entrysize = sizeof(ReorderBufferTXNByIdEnt);
 	hash_ctl.hash = tag_hash;
@@ -260,19 +294,21 @@ ReorderBufferAllocate(void)
 	buffer->by_txn_last_xid = InvalidTransactionId;
 	buffer->by_txn_last_txn = NULL;
 
-	buffer->nr_cached_transactions = 0;
-	buffer->nr_cached_changes = 0;
-	buffer->nr_cached_tuplebufs = 0;
-
 	buffer->outbuf = NULL;
 	buffer->outbufsize = 0;
 
 	buffer->current_restart_decoding_lsn = InvalidXLogRecPtr;
 
+	buffer->size = 0;
+
+	buffer->spill_txns = 0;
+	buffer->spill_count = 0;
+	buffer->spill_bytes = 0;
+	buffer->stream_txns = 0;
+	buffer->stream_count = 0;
+	buffer->stream_bytes = 0;
+
 	dlist_init(&buffer->toplevel_by_lsn);
-	dlist_init(&buffer->cached_transactions);
-	dlist_init(&buffer->cached_changes);
-	slist_init(&buffer->cached_tuplebufs);
 
 	return buffer;
 }
@@ -293,26 +329,15 @@ ReorderBufferFree(ReorderBuffer *rb)
 }
 
 /*
- * Get a unused, possibly preallocated, ReorderBufferTXN.
+ * Get an unused ReorderBufferTXN.
  */
 static ReorderBufferTXN *
 ReorderBufferGetTXN(ReorderBuffer *rb)
 {
 	ReorderBufferTXN *txn;
 
-	/* check the slab cache */
-	if (rb->nr_cached_transactions > 0)
-	{
-		rb->nr_cached_transactions--;
-		txn = (ReorderBufferTXN *)
-			dlist_container(ReorderBufferTXN, node,
-							dlist_pop_head_node(&rb->cached_transactions));
-	}
-	else
-	{
-		txn = (ReorderBufferTXN *)
-			MemoryContextAlloc(rb->context, sizeof(ReorderBufferTXN));
-	}
+	txn = (ReorderBufferTXN *)
+		MemoryContextAlloc(rb->txn_context, sizeof(ReorderBufferTXN));
 
 	memset(txn, 0, sizeof(ReorderBufferTXN));
 
@@ -325,9 +350,6 @@ ReorderBufferGetTXN(ReorderBuffer *rb)
 
 /*
  * Free a ReorderBufferTXN.
- *
- * Deallocation might be delayed for efficiency purposes, for details check
- * the comments above max_cached_changes's definition.
  */
 void
 ReorderBufferReturnTXN(ReorderBuffer *rb, ReorderBufferTXN *txn)
@@ -353,55 +375,101 @@ ReorderBufferReturnTXN(ReorderBuffer *rb, ReorderBufferTXN *txn)
 		txn->invalidations = NULL;
 	}
 
-	/* check whether to put into the slab cache */
-	if (rb->nr_cached_transactions < max_cached_transactions)
-	{
-		rb->nr_cached_transactions++;
-		dlist_push_head(&rb->cached_transactions, &txn->node);
-		VALGRIND_MAKE_MEM_UNDEFINED(txn, sizeof(ReorderBufferTXN));
-		VALGRIND_MAKE_MEM_DEFINED(&txn->node, sizeof(txn->node));
-	}
-	else
-	{
-		pfree(txn);
-	}
+	pfree(txn);
 }
 
 /*
- * Get a unused, possibly preallocated, ReorderBufferChange.
+ * Get an unused ReorderBufferChange.
  */
 ReorderBufferChange *
 ReorderBufferGetChange(ReorderBuffer *rb)
 {
 	ReorderBufferChange *change;
 
-	/* check the slab cache */
-	if (rb->nr_cached_changes)
+	change = (ReorderBufferChange *)
+		MemoryContextAlloc(rb->change_context, sizeof(ReorderBufferChange));
+
+	memset(change, 0, sizeof(ReorderBufferChange));
+	return change;
+}
+
+/*
+ * Amount of memory used by a change, including the data it contains.
+ *
+ * Tuples are accounted with the space allocated for them, which can be more
+ * than their current length after toast reassembly.
+ */
+static Size
+ReorderBufferChangeSize(ReorderBufferChange *change)
+{
+	Size		sz = sizeof(ReorderBufferChange);
+
+	switch (change->action)
 	{
-		rb->nr_cached_changes--;
-		change = (ReorderBufferChange *)
-			dlist_container(ReorderBufferChange, node,
-							dlist_pop_head_node(&rb->cached_changes));
+		case REORDER_BUFFER_CHANGE_INSERT:
+		case REORDER_BUFFER_CHANGE_UPDATE:
+		case REORDER_BUFFER_CHANGE_DELETE:
+			if (change->data.tp.newtuple)
+				sz += sizeof(ReorderBufferTupleBuf) +
+					change->data.tp.newtuple->alloc_tuple_size;
+			if (change->data.tp.oldtuple)
+				sz += sizeof(ReorderBufferTupleBuf) +
+					change->data.tp.oldtuple->alloc_tuple_size;
+			break;
+		case REORDER_BUFFER_CHANGE_INTERNAL_SNAPSHOT:
+			{
+				Snapshot	snap = change->data.snapshot;
+
+				sz += sizeof(SnapshotData) +
+					sizeof(TransactionId) * (snap->xcnt + snap->subxcnt);
+				break;
+			}
+		case REORDER_BUFFER_CHANGE_INTERNAL_COMMAND_ID:
+		case REORDER_BUFFER_CHANGE_INTERNAL_TUPLECID:
+			break;
+	}
+
+	return sz;
+}
+
+/*
+ * Account for a change being added to, or removed from, the changes of its
+ * transaction kept in memory.
+ */
+static void
+ReorderBufferChangeMemoryUpdate(ReorderBuffer *rb,
+								ReorderBufferChange *change, bool addition)
+{
+	ReorderBufferTXN *txn = change->txn;
+	Size		sz;
+
+	Assert(txn != NULL);
+
+	sz = ReorderBufferChangeSize(change);
+
+	if (addition)
+	{
+		txn->size += sz;
+		rb->size += sz;
 	}
 	else
 	{
-		change = (ReorderBufferChange *)
-			MemoryContextAlloc(rb->context, sizeof(ReorderBufferChange));
+		Assert(txn->size >= sz && rb->size >= sz);
+		txn->size -= sz;
+		rb->size -= sz;
 	}
-
-	memset(change, 0, sizeof(ReorderBufferChange));
-	return change;
 }
 
 /*
  * Free an ReorderBufferChange.
- *
- * Deallocation might be delayed for efficiency purposes, for details check
- * the comments above max_cached_changes's definition.
  */
 void
 ReorderBufferReturnChange(ReorderBuffer *rb, ReorderBufferChange *change)
 {
+	/* changes queued in a transaction count towards its memory usage */
+	if (change->txn != NULL)
+		ReorderBufferChangeMemoryUpdate(rb, change, false);
+
 	/* free contained data */
 	switch (change->action)
 	{
@@ -433,69 +501,39 @@ ReorderBufferReturnChange(ReorderBuffer *rb, ReorderBufferChange *change)
 			break;
 	}
 
-	/* check whether to put into the slab cache */
-	if (rb->nr_cached_changes < max_cached_changes)
-	{
-		rb->nr_cached_changes++;
-		dlist_push_head(&rb->cached_changes, &change->node);
-		VALGRIND_MAKE_MEM_UNDEFINED(change, sizeof(ReorderBufferChange));
-		VALGRIND_MAKE_MEM_DEFINED(&change->node, sizeof(change->node));
-	}
-	else
-	{
-		pfree(change);
-	}
+	pfree(change);
 }
 
 
 /*
- * Get a unused, possibly preallocated, ReorderBufferTupleBuf
+ * Get an unused ReorderBufferTupleBuf fitting at least a tuple with
+ * tuple_len bytes of data following the fixed-size part of its header.
  */
 ReorderBufferTupleBuf *
-ReorderBufferGetTupleBuf(ReorderBuffer *rb)
+ReorderBufferGetTupleBuf(ReorderBuffer *rb, Size tuple_len)
 {
 	ReorderBufferTupleBuf *tuple;
+	Size		alloc_len;
 
-	/* check the slab cache */
-	if (rb->nr_cached_tuplebufs)
-	{
-		rb->nr_cached_tuplebufs--;
-		tuple = slist_container(ReorderBufferTupleBuf, node,
-								slist_pop_head_node(&rb->cached_tuplebufs));
-#ifdef USE_ASSERT_CHECKING
-		memset(tuple, 0xdeadbeef, sizeof(ReorderBufferTupleBuf));
-#endif
-	}
-	else
-	{
-		tuple = (ReorderBufferTupleBuf *)
-			MemoryContextAlloc(rb->context, sizeof(ReorderBufferTupleBuf));
-	}
+	alloc_len = tuple_len + offsetof(HeapTupleHeaderData, t_bits);
+
+	tuple = (ReorderBufferTupleBuf *)
+		MemoryContextAlloc(rb->tup_context,
+						   sizeof(ReorderBufferTupleBuf) +
+						   MAXIMUM_ALIGNOF + alloc_len);
+	tuple->alloc_tuple_size = alloc_len;
+	tuple->tuple.t_data = ReorderBufferTupleBufData(tuple);
 
 	return tuple;
 }
 
 /*
  * Free an ReorderBufferTupleBuf.
- *
- * Deallocation might be delayed for efficiency purposes, for details check
- * the comments above max_cached_changes's definition.
  */
 void
 ReorderBufferReturnTupleBuf(ReorderBuffer *rb, ReorderBufferTupleBuf *tuple)
 {
-	/* check whether to put into the slab cache */
-	if (rb->nr_cached_tuplebufs < max_cached_tuplebufs)
-	{
-		rb->nr_cached_tuplebufs++;
-		slist_push_head(&rb->cached_tuplebufs, &tuple->node);
-		VALGRIND_MAKE_MEM_UNDEFINED(tuple, sizeof(ReorderBufferTupleBuf));
-		VALGRIND_MAKE_MEM_DEFINED(&tuple->node, sizeof(tuple->node));
-	}
-	else
-	{
-		pfree(tuple);
-	}
+	pfree(tuple);
 }
 
 /*
@@ -596,12 +634,15 @@ ReorderBufferQueueChange(ReorderBuffer *rb, TransactionId xid, XLogRecPtr lsn,
 	txn = ReorderBufferTXNByXid(rb, xid, true, NULL, lsn, true);
 
 	change->lsn = lsn;
+	change->txn = txn;
 	Assert(InvalidXLogRecPtr != lsn);
 	dlist_push_tail(&txn->changes, &change->node);
 	txn->nentries++;
 	txn->nentries_mem++;
 
-	ReorderBufferCheckSerializeTXN(rb, txn);
+	ReorderBufferChangeMemoryUpdate(rb, change, true);
+
+	ReorderBufferCheckMemoryLimit(rb);
 }
 
 static void
@@ -673,12 +714,15 @@ ReorderBufferAssignChild(ReorderBuffer *rb, TransactionId xid,
 		 * that have not yet produced any records. Knowing those aren't top
 		 * level xids allows us to make processing cheaper in some places.
 		 */
+		subtxn->is_known_as_subxact = true;
+		subtxn->toptxn = txn;
 		dlist_push_tail(&txn->subtxns, &subtxn->node);
 		txn->nsubtxns++;
 	}
 	else if (!subtxn->is_known_as_subxact)
 	{
 		subtxn->is_known_as_subxact = true;
+		subtxn->toptxn = txn;
 		Assert(subtxn->nsubtxns == 0);
 
 		/* remove from lsn order list of top-level transactions */
@@ -726,9 +770,12 @@ ReorderBufferCommitChild(ReorderBuffer *rb, TransactionId xid,
 	 * toplevel transaction but in one of the child transactions. This allows
 	 * the parent to simply use it's base snapshot initially.
 	 */
-	if (txn->base_snapshot == NULL ||
-		txn->base_snapshot_lsn > subtxn->base_snapshot_lsn)
+	if (subtxn->base_snapshot != NULL &&
+		(txn->base_snapshot == NULL ||
+		 txn->base_snapshot_lsn > subtxn->base_snapshot_lsn))
 	{
+		if (txn->base_snapshot != NULL)
+			SnapBuildSnapDecRefcount(txn->base_snapshot);
 		txn->base_snapshot = subtxn->base_snapshot;
 		txn->base_snapshot_lsn = subtxn->base_snapshot_lsn;
 		subtxn->base_snapshot = NULL;
@@ -741,6 +788,7 @@ ReorderBufferCommitChild(ReorderBuffer *rb, TransactionId xid,
 	if (!subtxn->is_known_as_subxact)
 	{
 		subtxn->is_known_as_subxact = true;
+		subtxn->toptxn = txn;
 		Assert(subtxn->nsubtxns == 0);
 
 		/* remove from lsn order list of top-level transactions */
@@ -874,7 +922,7 @@ ReorderBufferIterTXNInit(ReorderBuffer *rb, ReorderBufferTXN *txn)
 		{
 			ReorderBufferChange *cur_change;
 
-			if (txn->nentries != txn->nentries_mem)
+			if (cur_txn->nentries != cur_txn->nentries_mem)
 				ReorderBufferRestoreChanges(rb, cur_txn,
 											&state->entries[off].fd,
 											&state->entries[off].segno);
@@ -1073,6 +1121,16 @@ ReorderBufferCleanupTXN(ReorderBuffer *rb, ReorderBufferTXN *txn)
 		txn->base_snapshot_lsn = InvalidXLogRecPtr;
 	}
 
+	/* snapshot the last streamed block ended with */
+	if (txn->snapshot_now != NULL)
+	{
+		ReorderBufferFreeSnap(rb, txn->snapshot_now);
+		txn->snapshot_now = NULL;
+	}
+
+	/* toast chunks of a streamed transaction still waiting for their tuple */
+	ReorderBufferToastReset(rb, txn);
+
 	/* delete from list of known subxacts */
 	if (txn->is_known_as_subxact)
 	{
@@ -1093,7 +1151,7 @@ ReorderBufferCleanupTXN(ReorderBuffer *rb, ReorderBufferTXN *txn)
 	Assert(found);
 
 	/* remove entries spilled to disk */
-	if (txn->nentries != txn->nentries_mem)
+	if (txn->serialized)
 		ReorderBufferRestoreCleanup(rb, txn);
 
 	/* deallocate */
@@ -1248,61 +1306,69 @@ ReorderBufferFreeSnap(ReorderBuffer *rb, Snapshot snap)
 }
 
 /*
- * Perform the replay of a transaction and it's non-aborted subtransactions.
+ * Replay the changes of a transaction and its subtransactions collected so
+ * far, in lsn order.
  *
- * Subtransactions previously have to be processed by
- * ReorderBufferCommitChild(), even if previously assigned to the toplevel
- * transaction with ReorderBufferAssignChild.
+ * Unless the transaction has been streamed before, it has committed at
+ * commit_lsn and its changes are passed to the output plugin's begin, change
+ * and commit callbacks.  Otherwise they are sent as a streamed block; if
+ * commit_lsn is invalid, the transaction is still in progress and the
+ * snapshot and CommandId the block ended with are remembered, so the next
+ * block can continue from there.
  *
- * We currently can only decode a transaction's contents in when their commit
- * record is read because that's currently the only place where we know about
- * cache invalidations. Thus, once a toplevel commit is read, we iterate over
- * the top and subtransactions (using a k-way merge) and replay the changes in
- * lsn order.
+ * On success the caller has to clean up or truncate the transaction; on
+ * error it has already been cleaned up.
  */
-void
-ReorderBufferCommit(ReorderBuffer *rb, TransactionId xid,
-					XLogRecPtr commit_lsn, XLogRecPtr end_lsn,
-					TimestampTz commit_time)
+static void
+ReorderBufferProcessTXN(ReorderBuffer *rb, ReorderBufferTXN *txn,
+						XLogRecPtr commit_lsn)
 {
-	ReorderBufferTXN *txn;
-	ReorderBufferIterTXNState *iterstate = NULL;
+	ReorderBufferIterTXNState *volatile iterstate = NULL;
 	ReorderBufferChange *change;
+	dlist_iter	iter;
+	bool		streaming = txn->streamed;
+	XLogRecPtr	last_lsn = InvalidXLogRecPtr;
 
 	volatile CommandId	command_id = FirstCommandId;
 	volatile Snapshot	snapshot_now = NULL;
 	volatile bool		txn_started = false;
 	volatile bool		subtxn_started = false;
+	volatile bool		stream_started = false;
 
-	txn = ReorderBufferTXNByXid(rb, xid, false, NULL, InvalidXLogRecPtr,
-								false);
-
-	/* unknown transaction, nothing to replay */
-	if (txn == NULL)
-		return;
+	Assert(streaming || commit_lsn != InvalidXLogRecPtr);
 
-	txn->final_lsn = commit_lsn;
-	txn->end_lsn = end_lsn;
-	txn->commit_time = commit_time;
-
-	/* serialize the last bunch of changes if we need start earlier anyway */
+	/*
+	 * Serialize the last bunch of changes of (sub)transactions that already
+	 * have been partially spilled, we need to start reading them from disk
+	 * anyway.
+	 */
 	if (txn->nentries_mem != txn->nentries)
 		ReorderBufferSerializeTXN(rb, txn);
+	else
+	{
+		dlist_foreach(iter, &txn->subtxns)
+		{
+			ReorderBufferTXN *subtxn;
 
-	/*
-	 * If this transaction didn't have any real changes in our database, it's
-	 * OK not to have a snapshot. Note that ReorderBufferCommitChild will have
-	 * transferred its snapshot to this transaction if it had one and the
-	 * toplevel tx didn't.
-	 */
-	if (txn->base_snapshot == NULL)
+			subtxn = dlist_container(ReorderBufferTXN, node, iter.cur);
+
+			if (subtxn->nentries_mem != subtxn->nentries)
+				ReorderBufferSerializeTXN(rb, subtxn);
+		}
+	}
+
+	/* continue where the last streamed block left off, if any */
+	if (txn->snapshot_now != NULL)
 	{
-		Assert(txn->ninvalidations == 0);
-		ReorderBufferCleanupTXN(rb, txn);
-		return;
+		Assert(txn->snapshot_now->copied);
+		snapshot_now = txn->snapshot_now;
+		command_id = txn->command_id;
+		txn->snapshot_now = NULL;
 	}
+	else
+		snapshot_now = txn->base_snapshot;
 
-	snapshot_now = txn->base_snapshot;
+	Assert(snapshot_now != NULL);
 
 	/* build data to be able to lookup the CommandIds of catalog tuples */
 	ReorderBufferBuildTupleCidHash(rb, txn);
@@ -1335,7 +1401,8 @@ ReorderBufferCommit(ReorderBuffer *rb, TransactionId xid,
 			txn_started = true;
 		}
 
-		rb->begin(rb, txn);
+		if (!streaming)
+			rb->begin(rb, txn);
 
 		iterstate = ReorderBufferIterTXNInit(rb, txn);
 		while ((change = ReorderBufferIterTXNNext(rb, iterstate)))
@@ -1343,6 +1410,8 @@ ReorderBufferCommit(ReorderBuffer *rb, TransactionId xid,
 			Relation	relation = NULL;
 			Oid			reloid;
 
+			last_lsn = change->lsn;
+
 			switch (change->action)
 			{
 				case REORDER_BUFFER_CHANGE_INSERT:
@@ -1386,7 +1455,18 @@ ReorderBufferCommit(ReorderBuffer *rb, TransactionId xid,
 						else if (!IsToastRelation(relation))
 						{
 							ReorderBufferToastReplace(rb, txn, relation, change);
-							rb->apply_change(rb, txn, relation, change);
+							if (!streaming)
+								rb->apply_change(rb, txn, relation, change);
+							else
+							{
+								/* open a streamed block on the first change */
+								if (!stream_started)
+								{
+									rb->stream_start(rb, txn, change->lsn);
+									stream_started = true;
+								}
+								rb->stream_change(rb, txn, relation, change);
+							}
 							ReorderBufferToastReset(rb, txn);
 						}
 						/* we're not interested in toast deletions */
@@ -1398,9 +1478,14 @@ ReorderBufferCommit(ReorderBuffer *rb, TransactionId xid,
 							 * till we're done remove it from the list of this
 							 * transaction's changes. Otherwise it will get
 							 * freed/reused while restoring spooled data from
-							 * disk.
+							 * disk. The chunk isn't accounted to the
+							 * transaction anymore, which also means it
+							 * doesn't refer to a subtransaction that might be
+							 * gone by the time it's freed.
 							 */
 							dlist_delete(&change->node);
+							ReorderBufferChangeMemoryUpdate(rb, change, false);
+							change->txn = NULL;
 							ReorderBufferToastAppendChunk(rb, txn, relation,
 														  change);
 						}
@@ -1476,9 +1561,19 @@ ReorderBufferCommit(ReorderBuffer *rb, TransactionId xid,
 		}
 
 		ReorderBufferIterTXNFinish(rb, iterstate);
+		iterstate = NULL;
 
-		/* call commit callback */
-		rb->commit(rb, txn, commit_lsn);
+		if (stream_started)
+			rb->stream_stop(rb, txn, last_lsn);
+
+		/* call commit callback, unless the transaction is still running */
+		if (commit_lsn != InvalidXLogRecPtr)
+		{
+			if (streaming)
+				rb->stream_commit(rb, txn, commit_lsn);
+			else
+				rb->commit(rb, txn, commit_lsn);
+		}
 
 		/* this is just a sanity check against bad output plugin behaviour */
 		if (GetCurrentTransactionIdIfAny() != InvalidTransactionId)
@@ -1502,11 +1597,20 @@ ReorderBufferCommit(ReorderBuffer *rb, TransactionId xid,
 		else if (txn_started)
 			AbortCurrentTransaction();
 
-		if (snapshot_now->copied)
+		/*
+		 * Keep the snapshot for the next streamed block.  It has to be our
+		 * own copy, the one we're using may be freed with the changes.
+		 */
+		if (commit_lsn == InvalidXLogRecPtr)
+		{
+			if (!snapshot_now->copied)
+				snapshot_now = ReorderBufferCopySnap(rb, snapshot_now,
+													 txn, command_id);
+			txn->snapshot_now = snapshot_now;
+			txn->command_id = command_id;
+		}
+		else if (snapshot_now->copied)
 			ReorderBufferFreeSnap(rb, snapshot_now);
-
-		/* remove potential on-disk data, and deallocate */
-		ReorderBufferCleanupTXN(rb, txn);
 	}
 	PG_CATCH();
 	{
@@ -1538,6 +1642,216 @@ ReorderBufferCommit(ReorderBuffer *rb, TransactionId xid,
 	PG_END_TRY();
 }
 
+/*
+ * Perform the replay of a transaction and it's non-aborted subtransactions.
+ *
+ * Subtransactions previously have to be processed by
+ * ReorderBufferCommitChild(), even if previously assigned to the toplevel
+ * transaction with ReorderBufferAssignChild.
+ *
+ * We currently can only decode a transaction's contents in when their commit
+ * record is read because that's currently the only place where we know about
+ * cache invalidations. Thus, once a toplevel commit is read, we iterate over
+ * the top and subtransactions (using a k-way merge) and replay the changes in
+ * lsn order.
+ *
+ * If parts of the transaction have already been streamed, only its remaining
+ * changes are streamed before the output plugin is told about the commit.
+ */
+void
+ReorderBufferCommit(ReorderBuffer *rb, TransactionId xid,
+					XLogRecPtr commit_lsn, XLogRecPtr end_lsn,
+					TimestampTz commit_time)
+{
+	ReorderBufferTXN *txn;
+
+	txn = ReorderBufferTXNByXid(rb, xid, false, NULL, InvalidXLogRecPtr,
+								false);
+
+	/* unknown transaction, nothing to replay */
+	if (txn == NULL)
+		return;
+
+	txn->final_lsn = commit_lsn;
+	txn->end_lsn = end_lsn;
+	txn->commit_time = commit_time;
+
+	/*
+	 * If this transaction didn't have any real changes in our database, it's
+	 * OK not to have a snapshot. Note that ReorderBufferCommitChild will have
+	 * transferred its snapshot to this transaction if it had one and the
+	 * toplevel tx didn't.
+	 */
+	if (txn->base_snapshot == NULL)
+	{
+		Assert(txn->ninvalidations == 0);
+		ReorderBufferCleanupTXN(rb, txn);
+		return;
+	}
+
+	ReorderBufferProcessTXN(rb, txn, commit_lsn);
+
+	/* report what we had to spill or stream of it */
+	UpdateDecodingStats((LogicalDecodingContext *) rb->private_data);
+
+	/* remove potential on-disk data, and deallocate */
+	ReorderBufferCleanupTXN(rb, txn);
+}
+
+/*
+ * Can the changes of a still running toplevel transaction be streamed?
+ *
+ * That requires an output plugin supporting it, and a transaction that we
+ * will decode as a whole once it commits, so it has to have started after
+ * the point from which on we decode transactions.  As long as the cache
+ * invalidations of catalog modifying transactions are only known at commit,
+ * those can't be streamed before either.
+ */
+static bool
+ReorderBufferCanStreamTXN(ReorderBuffer *rb, ReorderBufferTXN *txn)
+{
+	LogicalDecodingContext *ctx = rb->private_data;
+	bool		has_snapshot = txn->base_snapshot != NULL;
+	dlist_iter	iter;
+
+	Assert(!txn->is_known_as_subxact);
+
+	if (!ctx->streaming)
+		return false;
+
+	if (SnapBuildCurrentState(ctx->snapshot_builder) != SNAPBUILD_CONSISTENT ||
+		SnapBuildXactNeedsSkip(ctx->snapshot_builder, txn->first_lsn))
+		return false;
+
+	if (txn->has_catalog_changes)
+		return false;
+
+	dlist_foreach(iter, &txn->subtxns)
+	{
+		ReorderBufferTXN *subtxn;
+
+		subtxn = dlist_container(ReorderBufferTXN, node, iter.cur);
+
+		if (subtxn->has_catalog_changes)
+			return false;
+
+		if (subtxn->base_snapshot != NULL)
+			has_snapshot = true;
+	}
+
+	/* nothing to decode yet */
+	return has_snapshot;
+}
+
+/*
+ * Send the changes collected so far of a running toplevel transaction and
+ * its subtransactions to the output plugin as a streamed block, and forget
+ * about them.
+ *
+ * This relies on the first WAL record of every subtransaction carrying its
+ * toplevel xid, see IsSubTransactionAssignmentPending(), so the changes of
+ * all of them are sent as part of the right toplevel transaction.
+ */
+static void
+ReorderBufferStreamTXN(ReorderBuffer *rb, ReorderBufferTXN *txn)
+{
+	dlist_iter	iter;
+	Size		size = txn->size;
+
+	Assert(!txn->is_known_as_subxact);
+
+	dlist_foreach(iter, &txn->subtxns)
+	{
+		ReorderBufferTXN *subtxn;
+
+		subtxn = dlist_container(ReorderBufferTXN, node, iter.cur);
+
+		size += subtxn->size;
+
+		/*
+		 * Use the oldest base snapshot of the toplevel transaction and its
+		 * subtransactions, as ReorderBufferCommitChild() would at commit.
+		 */
+		if (subtxn->base_snapshot != NULL &&
+			(txn->base_snapshot == NULL ||
+			 txn->base_snapshot_lsn > subtxn->base_snapshot_lsn))
+		{
+			if (txn->base_snapshot != NULL)
+				SnapBuildSnapDecRefcount(txn->base_snapshot);
+			txn->base_snapshot = subtxn->base_snapshot;
+			txn->base_snapshot_lsn = subtxn->base_snapshot_lsn;
+			subtxn->base_snapshot = NULL;
+			subtxn->base_snapshot_lsn = InvalidXLogRecPtr;
+		}
+
+		/* an abort of this subtransaction has to be reported from now on */
+		if (subtxn->nentries > 0)
+			subtxn->streamed = true;
+	}
+
+	if (!txn->streamed)
+		rb->stream_txns++;
+	rb->stream_count++;
+	rb->stream_bytes += size;
+
+	txn->streamed = true;
+
+	ReorderBufferProcessTXN(rb, txn, InvalidXLogRecPtr);
+
+	ReorderBufferTruncateTXN(rb, txn);
+}
+
+/*
+ * Discard the changes of a transaction and its subtransactions that have been
+ * streamed, including those spilled to disk.
+ *
+ * Unlike ReorderBufferCleanupTXN() this keeps everything needed to continue
+ * decoding the transaction: the transactions themselves, the snapshots, the
+ * tuplecids and the toast chunks not yet attached to a tuple.
+ */
+static void
+ReorderBufferTruncateTXN(ReorderBuffer *rb, ReorderBufferTXN *txn)
+{
+	dlist_mutable_iter iter;
+
+	/* subtransactions only exist one level deep */
+	dlist_foreach_modify(iter, &txn->subtxns)
+	{
+		ReorderBufferTXN *subtxn;
+
+		subtxn = dlist_container(ReorderBufferTXN, node, iter.cur);
+
+		ReorderBufferTruncateTXN(rb, subtxn);
+	}
+
+	dlist_foreach_modify(iter, &txn->changes)
+	{
+		ReorderBufferChange *change;
+
+		change = dlist_container(ReorderBufferChange, node, iter.cur);
+
+		dlist_delete(&change->node);
+		ReorderBufferReturnChange(rb, change);
+	}
+
+	/* remove entries spilled to disk */
+	if (txn->serialized)
+	{
+		ReorderBufferRestoreCleanup(rb, txn);
+		txn->serialized = false;
+	}
+
+	txn->nentries = 0;
+	txn->nentries_mem = 0;
+
+	/* rebuilt from the tuplecids when processing the transaction again */
+	if (txn->tuplecid_hash != NULL)
+	{
+		hash_destroy(txn->tuplecid_hash);
+		txn->tuplecid_hash = NULL;
+	}
+}
+
 /*
  * Abort a transaction that possibly has previous changes. Needs to be first
  * called for subtransactions and then for the toplevel xid.
@@ -1565,6 +1879,10 @@ ReorderBufferAbort(ReorderBuffer *rb, TransactionId xid, XLogRecPtr lsn)
 	/* cosmetic... */
 	txn->final_lsn = lsn;
 
+	/* the output plugin has to discard what it has seen of the txn */
+	if (txn->streamed)
+		rb->stream_abort(rb, txn, lsn);
+
 	/* remove potential on-disk data, and deallocate */
 	ReorderBufferCleanupTXN(rb, txn);
 }
@@ -1575,9 +1893,13 @@ ReorderBufferAbort(ReorderBuffer *rb, TransactionId xid, XLogRecPtr lsn)
  *
  * NB: These really have to be transactions that have aborted due to a server
  * crash/immediate restart, as we don't deal with invalidations here.
+ *
+ * lsn is the position at which that was determined, which is reported to the
+ * output plugin for transactions that have been streamed.
  */
 void
-ReorderBufferAbortOld(ReorderBuffer *rb, TransactionId oldestRunningXid)
+ReorderBufferAbortOld(ReorderBuffer *rb, TransactionId oldestRunningXid,
+					  XLogRecPtr lsn)
 {
 	dlist_mutable_iter it;
 
@@ -1598,6 +1920,9 @@ ReorderBufferAbortOld(ReorderBuffer *rb, TransactionId oldestRunningXid)
 		{
 			elog(DEBUG1, "aborting old transaction %u", txn->xid);
 
+			if (txn->streamed)
+				rb->stream_abort(rb, txn, lsn);
+
 			/* remove potential on-disk data, and deallocate this tx */
 			ReorderBufferCleanupTXN(rb, txn);
 		}
@@ -1881,20 +2206,110 @@ ReorderBufferSerializeReserve(ReorderBuffer *rb, Size sz)
 }
 
 /*
- * Check whether the transaction tx should spill its data to disk.
+ * Find the (sub-)transaction using the most memory for its changes.
+ *
+ * This has to look at every transaction we know about, but it's only done
+ * once the memory limit has been reached, and then a sizable chunk of memory
+ * is freed.
+ */
+static ReorderBufferTXN *
+ReorderBufferLargestTXN(ReorderBuffer *rb)
+{
+	HASH_SEQ_STATUS hash_seq;
+	ReorderBufferTXNByIdEnt *ent;
+	ReorderBufferTXN *largest = NULL;
+
+	hash_seq_init(&hash_seq, rb->by_txn);
+	while ((ent = hash_seq_search(&hash_seq)) != NULL)
+	{
+		ReorderBufferTXN *txn = ent->txn;
+
+		if (largest == NULL || txn->size > largest->size)
+			largest = txn;
+	}
+
+	return largest;
+}
+
+/*
+ * Find the toplevel transaction that, together with its subtransactions, uses
+ * the most memory for its changes and can be streamed. Returns NULL if there
+ * is none.
+ */
+static ReorderBufferTXN *
+ReorderBufferLargestStreamableTopTXN(ReorderBuffer *rb)
+{
+	LogicalDecodingContext *ctx = rb->private_data;
+	ReorderBufferTXN *largest = NULL;
+	Size		largest_size = 0;
+	dlist_iter	iter;
+
+	if (!ctx->streaming)
+		return NULL;
+
+	dlist_foreach(iter, &rb->toplevel_by_lsn)
+	{
+		ReorderBufferTXN *txn;
+		Size		size;
+		dlist_iter	subtxn_i;
+
+		txn = dlist_container(ReorderBufferTXN, node, iter.cur);
+
+		size = txn->size;
+		dlist_foreach(subtxn_i, &txn->subtxns)
+		{
+			ReorderBufferTXN *subtxn;
+
+			subtxn = dlist_container(ReorderBufferTXN, node, subtxn_i.cur);
+			size += subtxn->size;
+		}
+
+		if (size > largest_size && ReorderBufferCanStreamTXN(rb, txn))
+		{
+			largest = txn;
+			largest_size = size;
+		}
+	}
+
+	return largest;
+}
+
+/*
+ * Check whether the changes kept in memory exceed logical_decoding_work_mem,
+ * and if so, free memory until they don't anymore.
+ *
+ * If the output plugin supports it, the largest streamable toplevel
+ * transaction is streamed to it, otherwise the largest (sub-)transaction is
+ * spilled to disk. Evicting the largest transactions first means the least
+ * number of evictions, and keeps small transactions, which are likely to
+ * commit soon, in memory.
  */
 static void
-ReorderBufferCheckSerializeTXN(ReorderBuffer *rb, ReorderBufferTXN *txn)
+ReorderBufferCheckMemoryLimit(ReorderBuffer *rb)
 {
-	/*
-	 * TODO: improve accounting so we cheaply can take subtransactions into
-	 * account here.
-	 */
-	if (txn->nentries_mem >= max_changes_in_memory)
+	ReorderBufferTXN *txn;
+	bool		evicted = false;
+
+	while (rb->size >= logical_decoding_work_mem * 1024L)
 	{
-		ReorderBufferSerializeTXN(rb, txn);
-		Assert(txn->nentries_mem == 0);
+		Size		size PG_USED_FOR_ASSERTS_ONLY = rb->size;
+
+		if ((txn = ReorderBufferLargestStreamableTopTXN(rb)) != NULL)
+			ReorderBufferStreamTXN(rb, txn);
+		else
+		{
+			txn = ReorderBufferLargestTXN(rb);
+			Assert(txn != NULL && txn->size > 0);
+			ReorderBufferSerializeTXN(rb, txn);
+		}
+
+		Assert(txn->size == 0 && txn->nentries_mem == 0);
+		Assert(rb->size < size);
+		evicted = true;
 	}
+
+	if (evicted)
+		UpdateDecodingStats((LogicalDecodingContext *) rb->private_data);
 }
 
 /*
@@ -1908,6 +2323,7 @@ ReorderBufferSerializeTXN(ReorderBuffer *rb, ReorderBufferTXN *txn)
 	int			fd = -1;
 	XLogSegNo	curOpenSegNo = 0;
 	Size		spilled = 0;
+	Size		size;
 	char		path[MAXPGPATH];
 
 	elog(DEBUG2, "spill %u changes in tx %u to disk",
@@ -1922,6 +2338,8 @@ ReorderBufferSerializeTXN(ReorderBuffer *rb, ReorderBufferTXN *txn)
 		ReorderBufferSerializeTXN(rb, subtxn);
 	}
 
+	size = txn->size;
+
 	/* serialize changestream */
 	dlist_foreach_modify(change_i, &txn->changes)
 	{
@@ -1964,6 +2382,15 @@ ReorderBufferSerializeTXN(ReorderBuffer *rb, ReorderBufferTXN *txn)
 		}
 
 		ReorderBufferSerializeChange(rb, txn, fd, change);
+
+		/*
+		 * Remember the last spilled change of a running transaction, so all
+		 * files can be found again if it has to be cleaned up without
+		 * seeing its end.
+		 */
+		if (txn->final_lsn < change->lsn)
+			txn->final_lsn = change->lsn;
+
 		dlist_delete(&change->node);
 		ReorderBufferReturnChange(rb, change);
 
@@ -1972,8 +2399,19 @@ ReorderBufferSerializeTXN(ReorderBuffer *rb, ReorderBufferTXN *txn)
 
 	Assert(spilled == txn->nentries_mem);
 	Assert(dlist_is_empty(&txn->changes));
+	Assert(txn->size == 0);
 	txn->nentries_mem = 0;
 
+	if (spilled > 0)
+	{
+		if (!txn->serialized)
+			rb->spill_txns++;
+		rb->spill_count++;
+		rb->spill_bytes += size;
+
+		txn->serialized = true;
+	}
+
 	if (fd != -1)
 		CloseTransientFile(fd);
 }
@@ -2010,17 +2448,18 @@ ReorderBufferSerializeChange(ReorderBuffer *rb, ReorderBufferTXN *txn,
 				newtup = change->data.tp.newtuple;
 
 				if (oldtup)
-					oldlen = offsetof(ReorderBufferTupleBuf, data)
-						+ oldtup->tuple.t_len
-						- offsetof(HeapTupleHeaderData, t_bits);
+				{
+					sz += sizeof(HeapTupleData);
+					oldlen = oldtup->tuple.t_len;
+					sz += oldlen;
+				}
 
 				if (newtup)
-					newlen = offsetof(ReorderBufferTupleBuf, data)
-						+ newtup->tuple.t_len
-						- offsetof(HeapTupleHeaderData, t_bits);
-
-				sz += oldlen;
-				sz += newlen;
+				{
+					sz += sizeof(HeapTupleData);
+					newlen = newtup->tuple.t_len;
+					sz += newlen;
+				}
 
 				/* make sure we have enough space */
 				ReorderBufferSerializeReserve(rb, sz);
@@ -2031,13 +2470,19 @@ ReorderBufferSerializeChange(ReorderBuffer *rb, ReorderBufferTXN *txn,
 
 				if (oldlen)
 				{
-					memcpy(data, oldtup, oldlen);
+					memcpy(data, &oldtup->tuple, sizeof(HeapTupleData));
+					data += sizeof(HeapTupleData);
+
+					memcpy(data, oldtup->tuple.t_data, oldlen);
 					data += oldlen;
 				}
 
 				if (newlen)
 				{
-					memcpy(data, newtup, newlen);
+					memcpy(data, &newtup->tuple, sizeof(HeapTupleData));
+					data += sizeof(HeapTupleData);
+
+					memcpy(data, newtup->tuple.t_data, newlen);
 					data += newlen;
 				}
 				break;
@@ -2259,30 +2704,49 @@ ReorderBufferRestoreChange(ReorderBuffer *rb, ReorderBufferTXN *txn,
 		case REORDER_BUFFER_CHANGE_UPDATE:
 			/* fall through */
 		case REORDER_BUFFER_CHANGE_DELETE:
-			if (change->data.tp.newtuple)
+			/* the pointers are only checked for being set */
+			if (change->data.tp.oldtuple)
 			{
-				Size		len = offsetof(ReorderBufferTupleBuf, data)
-				+((ReorderBufferTupleBuf *) data)->tuple.t_len
-				- offsetof(HeapTupleHeaderData, t_bits);
+				uint32		tuplelen = ((HeapTuple) data)->t_len;
 
-				change->data.tp.newtuple = ReorderBufferGetTupleBuf(rb);
-				memcpy(change->data.tp.newtuple, data, len);
-				change->data.tp.newtuple->tuple.t_data =
-					&change->data.tp.newtuple->header;
-				data += len;
+				change->data.tp.oldtuple =
+					ReorderBufferGetTupleBuf(rb, tuplelen -
+									offsetof(HeapTupleHeaderData, t_bits));
+
+				/* restore ->tuple */
+				memcpy(&change->data.tp.oldtuple->tuple, data,
+					   sizeof(HeapTupleData));
+				data += sizeof(HeapTupleData);
+
+				/* reset t_data pointer into the new tuplebuf */
+				change->data.tp.oldtuple->tuple.t_data =
+					ReorderBufferTupleBufData(change->data.tp.oldtuple);
+
+				/* restore tuple data itself */
+				memcpy(change->data.tp.oldtuple->tuple.t_data, data, tuplelen);
+				data += tuplelen;
 			}
 
-			if (change->data.tp.oldtuple)
+			if (change->data.tp.newtuple)
 			{
-				Size		len = offsetof(ReorderBufferTupleBuf, data)
-				+((ReorderBufferTupleBuf *) data)->tuple.t_len
-				- offsetof(HeapTupleHeaderData, t_bits);
+				uint32		tuplelen = ((HeapTuple) data)->t_len;
 
-				change->data.tp.oldtuple = ReorderBufferGetTupleBuf(rb);
-				memcpy(change->data.tp.oldtuple, data, len);
-				change->data.tp.oldtuple->tuple.t_data =
-					&change->data.tp.oldtuple->header;
-				data += len;
+				change->data.tp.newtuple =
+					ReorderBufferGetTupleBuf(rb, tuplelen -
+									offsetof(HeapTupleHeaderData, t_bits));
+
+				/* restore ->tuple */
+				memcpy(&change->data.tp.newtuple->tuple, data,
+					   sizeof(HeapTupleData));
+				data += sizeof(HeapTupleData);
+
+				/* reset t_data pointer into the new tuplebuf */
+				change->data.tp.newtuple->tuple.t_data =
+					ReorderBufferTupleBufData(change->data.tp.newtuple);
+
+				/* restore tuple data itself */
+				memcpy(change->data.tp.newtuple->tuple.t_data, data, tuplelen);
+				data += tuplelen;
 			}
 			break;
 		case REORDER_BUFFER_CHANGE_INTERNAL_SNAPSHOT:
@@ -2314,8 +2778,11 @@ ReorderBufferRestoreChange(ReorderBuffer *rb, ReorderBufferTXN *txn,
 			break;
 	}
 
+	change->txn = txn;
 	dlist_push_tail(&txn->changes, &change->node);
 	txn->nentries_mem++;
+
+	ReorderBufferChangeMemoryUpdate(rb, change, true);
 }
 
 /*
@@ -2660,7 +3127,25 @@ ReorderBufferToastReplace(ReorderBuffer *rb, ReorderBufferTXN *txn,
 	 */
 	tmphtup = heap_form_tuple(desc, attrs, isnull);
 	Assert(newtup->tuple.t_len <= MaxHeapTupleSize);
-	Assert(&newtup->header == newtup->tuple.t_data);
+	Assert(ReorderBufferTupleBufData(newtup) == newtup->tuple.t_data);
+
+	/*
+	 * The rebuilt tuple can be larger than the original one, in which case
+	 * it needs a new tuplebuf, accounted in place of the old one.
+	 */
+	if (tmphtup->t_len > newtup->alloc_tuple_size)
+	{
+		ReorderBufferTupleBuf *oldtup = newtup;
+
+		ReorderBufferChangeMemoryUpdate(rb, change, false);
+		newtup = ReorderBufferGetTupleBuf(rb, tmphtup->t_len -
+									offsetof(HeapTupleHeaderData, t_bits));
+		newtup->tuple = oldtup->tuple;
+		newtup->tuple.t_data = ReorderBufferTupleBufData(newtup);
+		change->data.tp.newtuple = newtup;
+		ReorderBufferReturnTupleBuf(rb, oldtup);
+		ReorderBufferChangeMemoryUpdate(rb, change, true);
+	}
 
 	memcpy(newtup->tuple.t_data, tmphtup->t_data, tmphtup->t_len);
 	newtup->tuple.t_len = tmphtup->t_len;
@@ -70,6 +70,9 @@ Node *replication_parse_result;
 %token K_FAST
 %token K_NOWAIT
 %token K_MAX_RATE
+%token K_INCREMENTAL
+%token K_COMPRESS
+%token K_MANIFEST
 %token K_WAL
 %token K_TIMELINE
 %token K_PHYSICAL
@@ -120,6 +123,7 @@ identify_system:
 
 /*
  * BASE_BACKUP [LABEL '<label>'] [PROGRESS] [FAST] [WAL] [NOWAIT] [MAX_RATE %d]
+ * [INCREMENTAL %X/%X] [COMPRESS %d] [MANIFEST]
  */
 base_backup:
 			K_BASE_BACKUP base_backup_opt_list
@@ -168,6 +172,23 @@ base_backup_opt:
 				  $$ = makeDefElem("max_rate",
 								   (Node *)makeInteger($2));
 				}
+			| K_INCREMENTAL RECPTR
+				{
+				  $$ = makeDefElem("incremental",
+								   (Node *)makeString(psprintf("%X/%X",
+															   (uint32) ($2 >> 32),
+															   (uint32) $2)));
+				}
+			| K_COMPRESS UCONST
+				{
+				  $$ = makeDefElem("compress",
+								   (Node *)makeInteger($2));
+				}
+			| K_MANIFEST
+				{
+				  $$ = makeDefElem("manifest",
+								   (Node *)makeInteger(TRUE));
+				}
 			;
 
 create_replication_slot:
@@ -257,6 +257,12 @@ ReplicationSlotCreate(const char *name, bool db_specific,
 	NameStr(slot->data.name)[NAMEDATALEN - 1] = '\0';
 	slot->data.database = db_specific ? MyDatabaseId : InvalidOid;
 	slot->data.restart_lsn = InvalidXLogRecPtr;
+	slot->spill_txns = 0;
+	slot->spill_count = 0;
+	slot->spill_bytes = 0;
+	slot->stream_txns = 0;
+	slot->stream_count = 0;
+	slot->stream_bytes = 0;
 
 	/*
 	 * Create the slot on disk.  We haven't actually marked the slot allocated
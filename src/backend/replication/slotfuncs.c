@@ -154,7 +154,7 @@ pg_drop_replication_slot(PG_FUNCTION_ARGS)
 Datum
 pg_get_replication_slots(PG_FUNCTION_ARGS)
 {
-#define PG_GET_REPLICATION_SLOTS_COLS 8
+#define PG_GET_REPLICATION_SLOTS_COLS 14
 	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
 	TupleDesc	tupdesc;
 	Tuplestorestate *tupstore;
@@ -206,6 +206,12 @@ pg_get_replication_slots(PG_FUNCTION_ARGS)
 		Oid			database;
 		NameData	slot_name;
 		NameData	plugin;
+		int64		spill_txns;
+		int64		spill_count;
+		int64		spill_bytes;
+		int64		stream_txns;
+		int64		stream_count;
+		int64		stream_bytes;
 		int			i;
 
 		SpinLockAcquire(&slot->mutex);
@@ -223,6 +229,13 @@ pg_get_replication_slots(PG_FUNCTION_ARGS)
 			namecpy(&slot_name, &slot->data.name);
 			namecpy(&plugin, &slot->data.plugin);
 
+			spill_txns = slot->spill_txns;
+			spill_count = slot->spill_count;
+			spill_bytes = slot->spill_bytes;
+			stream_txns = slot->stream_txns;
+			stream_count = slot->stream_count;
+			stream_bytes = slot->stream_bytes;
+
 			active = slot->active;
 		}
 		SpinLockRelease(&slot->mutex);
@@ -264,6 +277,26 @@ pg_get_replication_slots(PG_FUNCTION_ARGS)
 		else
 			nulls[i++] = true;
 
+		/* decoding statistics only make sense for logical slots */
+		if (database == InvalidOid)
+		{
+			nulls[i++] = true;
+			nulls[i++] = true;
+			nulls[i++] = true;
+			nulls[i++] = true;
+			nulls[i++] = true;
+			nulls[i++] = true;
+		}
+		else
+		{
+			values[i++] = Int64GetDatum(spill_txns);
+			values[i++] = Int64GetDatum(spill_count);
+			values[i++] = Int64GetDatum(spill_bytes);
+			values[i++] = Int64GetDatum(stream_txns);
+			values[i++] = Int64GetDatum(stream_count);
+			values[i++] = Int64GetDatum(stream_bytes);
+		}
+
 		tuplestore_putvalues(tupstore, tupdesc, values, nulls);
 	}
 
@@ -30,6 +30,7 @@
 
 #include "access/clog.h"
 #include "access/multixact.h"
+#include "access/slru.h"
 #include "access/subtrans.h"
 #include "commands/async.h"
 #include "miscadmin.h"
@@ -73,11 +74,11 @@ static LWLockTranche MainLWLockTranche;
 
 /*
  * We use this structure to keep track of locked LWLocks for release
- * during error recovery.  The maximum size could be determined at runtime
- * if necessary, but it seems unlikely that more than a few locks could
+ * during error recovery.  Apart from code that locks all the lock manager
+ * partitions at once, it seems unlikely that more than a few locks could
  * ever be held simultaneously.
  */
-#define MAX_SIMUL_LWLOCKS	100
+#define MAX_SIMUL_LWLOCKS	(MAX_LOCK_PARTITIONS + 100)
 
 static int	num_held_lwlocks = 0;
 static LWLock *held_lwlocks[MAX_SIMUL_LWLOCKS];
@@ -234,20 +235,21 @@ NumLWLocks(void)
 	/* proc.c needs one for each backend or auxiliary process */
 	numLocks += MaxBackends + NUM_AUXILIARY_PROCS;
 
-	/* clog.c needs one per CLOG buffer */
-	numLocks += CLOGShmemBuffers();
+	/* clog.c needs one per CLOG buffer, plus one per bank */
+	numLocks += SimpleLruNumLWLocks(CLOGShmemBuffers(), true);
 
-	/* subtrans.c needs one per SubTrans buffer */
-	numLocks += NUM_SUBTRANS_BUFFERS;
+	/* subtrans.c needs one per SubTrans buffer, plus one per bank */
+	numLocks += SimpleLruNumLWLocks(SUBTRANSShmemBuffers(), true);
 
 	/* multixact.c needs two SLRU areas */
-	numLocks += NUM_MXACTOFFSET_BUFFERS + NUM_MXACTMEMBER_BUFFERS;
+	numLocks += SimpleLruNumLWLocks(multixact_offset_buffers, false) +
+		SimpleLruNumLWLocks(multixact_member_buffers, false);
 
 	/* async.c needs one per Async buffer */
-	numLocks += NUM_ASYNC_BUFFERS;
+	numLocks += SimpleLruNumLWLocks(NUM_ASYNC_BUFFERS, false);
 
 	/* predicate.c needs one per old serializable xid buffer */
-	numLocks += NUM_OLDSERXID_BUFFERS;
+	numLocks += SimpleLruNumLWLocks(NUM_OLDSERXID_BUFFERS, false);
 
 	/* slot.c needs one for each slot */
 	numLocks += max_replication_slots;
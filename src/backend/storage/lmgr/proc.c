@@ -89,6 +89,29 @@ static void ProcKill(int code, Datum arg);
 static void AuxiliaryProcKill(int code, Datum arg);
 
 
+/*
+ * Space needed for the lock manager arrays of one PGPROC, which are sized at
+ * startup: the myProcLocks lists and the fast-path lock slots.
+ */
+static Size
+PGProcLockDataSize(void)
+{
+	Size		size;
+
+	/* myProcLocks lists */
+	size = MAXALIGN(mul_size(NUM_LOCK_PARTITIONS, sizeof(SHM_QUEUE)));
+	/* fast-path lock bits, one uint64 per group */
+	size = add_size(size,
+					MAXALIGN(mul_size(FastPathLockGroupsPerBackend,
+									  sizeof(uint64))));
+	/* fast-path relation OIDs, one per slot */
+	size = add_size(size,
+					MAXALIGN(mul_size(FastPathLockSlotsPerBackend(),
+									  sizeof(Oid))));
+
+	return size;
+}
+
 /*
  * Report shared-memory space needed by InitProcGlobal.
  */
@@ -96,6 +119,8 @@ Size
 ProcGlobalShmemSize(void)
 {
 	Size		size = 0;
+	Size		TotalProcs = add_size(MaxBackends,
+								add_size(NUM_AUXILIARY_PROCS, max_prepared_xacts));
 
 	/* ProcGlobal */
 	size = add_size(size, sizeof(PROC_HDR));
@@ -112,6 +137,9 @@ ProcGlobalShmemSize(void)
 	size = add_size(size, mul_size(NUM_AUXILIARY_PROCS, sizeof(PGXACT)));
 	size = add_size(size, mul_size(max_prepared_xacts, sizeof(PGXACT)));
 
+	/* lock manager arrays of all the PGPROCs */
+	size = add_size(size, mul_size(TotalProcs, PGProcLockDataSize()));
+
 	return size;
 }
 
@@ -157,6 +185,8 @@ InitProcGlobal(void)
 {
 	PGPROC	   *procs;
 	PGXACT	   *pgxacts;
+	char	   *lockdata;
+	Size		lockdatasize = PGProcLockDataSize();
 	int			i,
 				j;
 	bool		found;
@@ -210,10 +240,33 @@ InitProcGlobal(void)
 	MemSet(pgxacts, 0, TotalProcs * sizeof(PGXACT));
 	ProcGlobal->allPgXact = pgxacts;
 
+	/*
+	 * Allocate the lock manager arrays of all PGPROCs in one chunk.  Their
+	 * sizes depend on lock_manager_partitions and max_locks_per_transaction,
+	 * so they can't be part of the PGPROC struct itself.
+	 */
+	lockdata = (char *) ShmemAlloc(mul_size(TotalProcs, lockdatasize));
+	if (!lockdata)
+		ereport(FATAL,
+				(errcode(ERRCODE_OUT_OF_MEMORY),
+				 errmsg("out of shared memory")));
+	MemSet(lockdata, 0, mul_size(TotalProcs, lockdatasize));
+
 	for (i = 0; i < TotalProcs; i++)
 	{
+		char	   *ptr = lockdata + i * lockdatasize;
+
 		/* Common initialization for all PGPROCs, regardless of type. */
 
+		/* Point to this PGPROC's lock manager arrays. */
+		procs[i].myProcLocks = (SHM_QUEUE *) ptr;
+		ptr += MAXALIGN(NUM_LOCK_PARTITIONS * sizeof(SHM_QUEUE));
+		procs[i].fpLockBits = (uint64 *) ptr;
+		ptr += MAXALIGN(FastPathLockGroupsPerBackend * sizeof(uint64));
+		procs[i].fpRelId = (Oid *) ptr;
+		ptr += MAXALIGN(FastPathLockSlotsPerBackend() * sizeof(Oid));
+		Assert(ptr == lockdata + (i + 1) * lockdatasize);
+
 		/*
 		 * Set up per-PGPROC semaphore, latch, and backendLock. Prepared xact
 		 * dummy PGPROCs don't need these though - they're never associated
@@ -3666,8 +3666,12 @@ PostgresMain(int argc, char *argv[],
 		 */
 		CreateDataDirLockFile(false);
 
-		/* Initialize MaxBackends (if under postmaster, was done already) */
+		/*
+		 * Initialize MaxBackends and fast-path lock sizing (if under
+		 * postmaster, was done already)
+		 */
 		InitializeMaxBackends();
+		InitializeFastPathLocks();
 	}
 
 	/* Early initialization */
@@ -30,6 +30,7 @@
 #include "catalog/pg_language.h"
 #include "catalog/pg_opclass.h"
 #include "catalog/pg_operator.h"
+#include "catalog/pg_partitioned_table.h"
 #include "catalog/pg_proc.h"
 #include "catalog/pg_trigger.h"
 #include "catalog/pg_type.h"
@@ -378,6 +379,7 @@ static void get_windowfunc_expr(WindowFunc *wfunc, deparse_context *context);
 static void get_coercion_expr(Node *arg, deparse_context *context,
 				  Oid resulttype, int32 resulttypmod,
 				  Node *parentNode);
+static void get_partition_bound_datum(Node *node, deparse_context *context);
 static void get_const_expr(Const *constval, deparse_context *context,
 			   int showtype);
 static void get_const_collation(Const *constval, deparse_context *context);
@@ -1246,6 +1248,64 @@ pg_get_indexdef_worker(Oid indexrelid, int colno,
 }
 
 
+/*
+ * pg_get_partkeydef
+ *
+ * Returns the partition key of a partitioned table, ie, everything that
+ * needs to appear after "PARTITION BY", or NULL if the table isn't
+ * partitioned.
+ */
+Datum
+pg_get_partkeydef(PG_FUNCTION_ARGS)
+{
+	Oid			relid = PG_GETARG_OID(0);
+	HeapTuple	tuple;
+	Form_pg_partitioned_table form;
+	Oid			keycoltype;
+	int32		keycoltypmod;
+	Oid			keycolcollation;
+	StringInfoData buf;
+
+	tuple = SearchSysCache1(PARTRELID, ObjectIdGetDatum(relid));
+	if (!HeapTupleIsValid(tuple))
+		PG_RETURN_NULL();
+	form = (Form_pg_partitioned_table) GETSTRUCT(tuple);
+
+	initStringInfo(&buf);
+
+	switch (form->partstrat)
+	{
+		case PARTITION_STRATEGY_RANGE:
+			appendStringInfoString(&buf, "RANGE");
+			break;
+		case PARTITION_STRATEGY_LIST:
+			appendStringInfoString(&buf, "LIST");
+			break;
+		default:
+			elog(ERROR, "unrecognized partitioning strategy: %d",
+				 (int) form->partstrat);
+	}
+
+	appendStringInfo(&buf, " (%s",
+					 quote_identifier(get_relid_attribute_name(relid,
+														form->partattnum)));
+	get_atttypetypmodcoll(relid, form->partattnum,
+						  &keycoltype, &keycoltypmod, &keycolcollation);
+
+	/* Add collation and operator class, if not default */
+	if (OidIsValid(form->partcollation) &&
+		form->partcollation != keycolcollation)
+		appendStringInfo(&buf, " COLLATE %s",
+						 generate_collation_name(form->partcollation));
+	get_opclass_name(form->partopclass, keycoltype, &buf);
+	appendStringInfoChar(&buf, ')');
+
+	ReleaseSysCache(tuple);
+
+	PG_RETURN_TEXT_P(string_to_text(buf.data));
+}
+
+
 /*
  * pg_get_constraintdef
  *
@@ -7371,6 +7431,35 @@ get_rule_expr(Node *node, deparse_context *context,
 			}
 			break;
 
+		case T_PartitionBoundSpec:
+			{
+				PartitionBoundSpec *spec = (PartitionBoundSpec *) node;
+				char	   *sep;
+				ListCell   *l;
+
+				if (spec->strategy == PARTITION_STRATEGY_LIST)
+				{
+					appendStringInfoString(buf, "FOR VALUES IN (");
+					sep = "";
+					foreach(l, spec->listdatums)
+					{
+						appendStringInfoString(buf, sep);
+						get_partition_bound_datum(lfirst(l), context);
+						sep = ", ";
+					}
+					appendStringInfoChar(buf, ')');
+				}
+				else
+				{
+					appendStringInfoString(buf, "FOR VALUES FROM (");
+					get_partition_bound_datum(spec->lowerdatum, context);
+					appendStringInfoString(buf, ") TO (");
+					get_partition_bound_datum(spec->upperdatum, context);
+					appendStringInfoChar(buf, ')');
+				}
+			}
+			break;
+
 		default:
 			elog(ERROR, "unrecognized node type: %d", (int) nodeTag(node));
 			break;
@@ -7378,6 +7467,56 @@ get_rule_expr(Node *node, deparse_context *context,
 }
 
 
+/*
+ * get_partition_bound_datum	- Parse back a value of a partition bound
+ *
+ * The grammar accepts only numeric and string literals here, so unlike
+ * get_const_expr we never add a cast or parenthesize a signed number.  A
+ * missing value is an unbounded end of a range.
+ */
+static void
+get_partition_bound_datum(Node *node, deparse_context *context)
+{
+	StringInfo	buf = context->buf;
+	Const	   *con;
+	Oid			typoutput;
+	bool		typIsVarlena;
+	char	   *extval;
+
+	if (node == NULL)
+	{
+		appendStringInfoString(buf, "UNBOUNDED");
+		return;
+	}
+
+	con = (Const *) node;
+	Assert(IsA(con, Const) && !con->constisnull);
+
+	getTypeOutputInfo(con->consttype, &typoutput, &typIsVarlena);
+	extval = OidOutputFunctionCall(typoutput, con->constvalue);
+
+	switch (con->consttype)
+	{
+		case INT2OID:
+		case INT4OID:
+		case INT8OID:
+		case FLOAT4OID:
+		case FLOAT8OID:
+		case NUMERICOID:
+			if (strspn(extval, "0123456789-eE.") == strlen(extval))
+			{
+				appendStringInfoString(buf, extval);
+				break;
+			}
+			/* FALL THRU */
+		default:
+			simple_quote_literal(buf, extval);
+			break;
+	}
+
+	pfree(extval);
+}
+
 /*
  * get_oper_expr			- Parse back an OpExpr node
  */
@@ -5959,7 +5959,9 @@ string_to_bytea_const(const char *str, size_t str_len)
  *
  * Callers should initialize all fields of GenericCosts to zero.  In addition,
  * they can set numIndexTuples to some positive value if they have a better
- * than default way of estimating the number of leaf index tuples visited.
+ * than default way of estimating the number of leaf index tuples visited,
+ * and num_sa_scans to a value greater than one if the scan will be repeated
+ * for some reason other than ScalarArrayOpExpr quals (such as a skip scan).
  */
 typedef struct
 {
@@ -6012,7 +6014,7 @@ genericcostestimate(PlannerInfo *root,
 	 * Check for ScalarArrayOpExpr index quals, and estimate the number of
 	 * index scans that will be performed.
 	 */
-	num_sa_scans = 1;
+	num_sa_scans = Max(costs->num_sa_scans, 1);
 	foreach(l, indexQuals)
 	{
 		RestrictInfo *rinfo = (RestrictInfo *) lfirst(l);
@@ -6245,9 +6247,95 @@ btcostestimate(PG_FUNCTION_ARGS)
 	bool		found_saop;
 	bool		found_is_null_op;
 	double		num_sa_scans;
+	double		num_skip_groups;
+	double		num_descents;
 	ListCell   *lcc,
 			   *lci;
 
+	/*
+	 * Fetch the statistics for the first index column, if any.  We need them
+	 * to estimate the number of groups a skip scan will visit, and for the
+	 * correlation estimate at the end.
+	 */
+	MemSet(&vardata, 0, sizeof(vardata));
+
+	if (index->indexkeys[0] != 0)
+	{
+		/* Simple variable --- look to stats for the underlying table */
+		RangeTblEntry *rte = planner_rt_fetch(index->rel->relid, root);
+
+		Assert(rte->rtekind == RTE_RELATION);
+		relid = rte->relid;
+		Assert(relid != InvalidOid);
+		colnum = index->indexkeys[0];
+
+		if (get_relation_stats_hook &&
+			(*get_relation_stats_hook) (root, rte, colnum, &vardata))
+		{
+			/*
+			 * The hook took control of acquiring a stats tuple.  If it did
+			 * supply a tuple, it'd better have supplied a freefunc.
+			 */
+			if (HeapTupleIsValid(vardata.statsTuple) &&
+				!vardata.freefunc)
+				elog(ERROR, "no function provided to release variable stats with");
+		}
+		else
+		{
+			vardata.statsTuple = SearchSysCache3(STATRELATTINH,
+												 ObjectIdGetDatum(relid),
+												 Int16GetDatum(colnum),
+												 BoolGetDatum(rte->inh));
+			vardata.freefunc = ReleaseSysCache;
+		}
+	}
+	else
+	{
+		/* Expression --- maybe there are stats for the index itself */
+		relid = index->indexoid;
+		colnum = 1;
+
+		if (get_index_stats_hook &&
+			(*get_index_stats_hook) (root, relid, colnum, &vardata))
+		{
+			/*
+			 * The hook took control of acquiring a stats tuple.  If it did
+			 * supply a tuple, it'd better have supplied a freefunc.
+			 */
+			if (HeapTupleIsValid(vardata.statsTuple) &&
+				!vardata.freefunc)
+				elog(ERROR, "no function provided to release variable stats with");
+		}
+		else
+		{
+			vardata.statsTuple = SearchSysCache3(STATRELATTINH,
+												 ObjectIdGetDatum(relid),
+												 Int16GetDatum(colnum),
+												 BoolGetDatum(false));
+			vardata.freefunc = ReleaseSysCache;
+		}
+	}
+
+	/*
+	 * A skip scan does a separate primitive index scan for each distinct
+	 * value of the first index column, plus one for NULLs.  If we have no
+	 * real estimate of the number of distinct values, assume the worst.
+	 */
+	num_skip_groups = 1;
+	if (path->indexskipscan)
+	{
+		bool		isdefault;
+
+		vardata.rel = index->rel;
+		vardata.vartype = index->opcintype[0];
+		num_skip_groups = get_variable_numdistinct(&vardata, &isdefault);
+		if (isdefault)
+			num_skip_groups = index->tuples;
+		else
+			num_skip_groups += 1;
+		num_skip_groups = clamp_row_est(Min(num_skip_groups, index->tuples));
+	}
+
 	/*
 	 * For a btree scan, only leading '=' quals plus inequality quals for the
 	 * immediately next attribute contribute to index selectivity (these are
@@ -6264,13 +6352,17 @@ btcostestimate(PG_FUNCTION_ARGS)
 	 * If there's a ScalarArrayOpExpr in the quals, we'll actually perform N
 	 * index scans not one, but the ScalarArrayOpExpr's operator can be
 	 * considered to act the same as it normally does.
+	 *
+	 * A skip scan acts as though there were an '=' qual on the first column,
+	 * with one index scan per group, so we start the search with the second
+	 * column in that case.
 	 */
 	indexBoundQuals = NIL;
-	indexcol = 0;
+	indexcol = path->indexskipscan ? 1 : 0;
 	eqQualHere = false;
 	found_saop = false;
 	found_is_null_op = false;
-	num_sa_scans = 1;
+	num_sa_scans = num_skip_groups;
 	forboth(lcc, path->indexquals, lci, path->indexqualcols)
 	{
 		RestrictInfo *rinfo = (RestrictInfo *) lfirst(lcc);
@@ -6418,9 +6510,18 @@ btcostestimate(PG_FUNCTION_ARGS)
 	 */
 	MemSet(&costs, 0, sizeof(costs));
 	costs.numIndexTuples = numIndexTuples;
+	costs.num_sa_scans = num_skip_groups;
 
 	genericcostestimate(root, path, loop_count, &costs);
 
+	/*
+	 * A skip scan needs an extra descent per group, to find the group's first
+	 * column value before scanning the group itself.
+	 */
+	num_descents = costs.num_sa_scans;
+	if (path->indexskipscan)
+		num_descents *= 2;
+
 	/*
 	 * Add a CPU-cost component to represent the costs of initial btree
 	 * descent.  We don't charge any I/O cost for touching upper btree levels,
@@ -6428,15 +6529,16 @@ btcostestimate(PG_FUNCTION_ARGS)
 	 * comparisons to descend a btree of N leaf tuples.  We charge one
 	 * cpu_operator_cost per comparison.
 	 *
-	 * If there are ScalarArrayOpExprs, charge this once per SA scan.  The
-	 * ones after the first one are not startup cost so far as the overall
-	 * plan is concerned, so add them only to "total" cost.
+	 * If there are ScalarArrayOpExprs, charge this once per SA scan, and
+	 * likewise for each descent of a skip scan.  The ones after the first one
+	 * are not startup cost so far as the overall plan is concerned, so add
+	 * them only to "total" cost.
 	 */
 	if (index->tuples > 1)		/* avoid computing log(0) */
 	{
 		descentCost = ceil(log(index->tuples) / log(2.0)) * cpu_operator_cost;
 		costs.indexStartupCost += descentCost;
-		costs.indexTotalCost += costs.num_sa_scans * descentCost;
+		costs.indexTotalCost += num_descents * descentCost;
 	}
 
 	/*
@@ -6447,11 +6549,11 @@ btcostestimate(PG_FUNCTION_ARGS)
 	 * in cases where only a single leaf page is expected to be visited.  This
 	 * cost is somewhat arbitrarily set at 50x cpu_operator_cost per page
 	 * touched.  The number of such pages is btree tree height plus one (ie,
-	 * we charge for the leaf page too).  As above, charge once per SA scan.
+	 * we charge for the leaf page too).  As above, charge once per descent.
 	 */
 	descentCost = (index->tree_height + 1) * 50.0 * cpu_operator_cost;
 	costs.indexStartupCost += descentCost;
-	costs.indexTotalCost += costs.num_sa_scans * descentCost;
+	costs.indexTotalCost += num_descents * descentCost;
 
 	/*
 	 * If we can get an estimate of the first column's ordering correlation C
@@ -6461,65 +6563,6 @@ btcostestimate(PG_FUNCTION_ARGS)
 	 * ordering, but don't negate it entirely.  Before 8.0 we divided the
 	 * correlation by the number of columns, but that seems too strong.)
 	 */
-	MemSet(&vardata, 0, sizeof(vardata));
-
-	if (index->indexkeys[0] != 0)
-	{
-		/* Simple variable --- look to stats for the underlying table */
-		RangeTblEntry *rte = planner_rt_fetch(index->rel->relid, root);
-
-		Assert(rte->rtekind == RTE_RELATION);
-		relid = rte->relid;
-		Assert(relid != InvalidOid);
-		colnum = index->indexkeys[0];
-
-		if (get_relation_stats_hook &&
-			(*get_relation_stats_hook) (root, rte, colnum, &vardata))
-		{
-			/*
-			 * The hook took control of acquiring a stats tuple.  If it did
-			 * supply a tuple, it'd better have supplied a freefunc.
-			 */
-			if (HeapTupleIsValid(vardata.statsTuple) &&
-				!vardata.freefunc)
-				elog(ERROR, "no function provided to release variable stats with");
-		}
-		else
-		{
-			vardata.statsTuple = SearchSysCache3(STATRELATTINH,
-												 ObjectIdGetDatum(relid),
-												 Int16GetDatum(colnum),
-												 BoolGetDatum(rte->inh));
-			vardata.freefunc = ReleaseSysCache;
-		}
-	}
-	else
-	{
-		/* Expression --- maybe there are stats for the index itself */
-		relid = index->indexoid;
-		colnum = 1;
-
-		if (get_index_stats_hook &&
-			(*get_index_stats_hook) (root, relid, colnum, &vardata))
-		{
-			/*
-			 * The hook took control of acquiring a stats tuple.  If it did
-			 * supply a tuple, it'd better have supplied a freefunc.
-			 */
-			if (HeapTupleIsValid(vardata.statsTuple) &&
-				!vardata.freefunc)
-				elog(ERROR, "no function provided to release variable stats with");
-		}
-		else
-		{
-			vardata.statsTuple = SearchSysCache3(STATRELATTINH,
-												 ObjectIdGetDatum(relid),
-												 Int16GetDatum(colnum),
-												 BoolGetDatum(false));
-			vardata.freefunc = ReleaseSysCache;
-		}
-	}
-
 	if (HeapTupleIsValid(vardata.statsTuple))
 	{
 		Oid			sortop;
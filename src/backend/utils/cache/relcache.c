@@ -1892,6 +1892,12 @@ RelationDestroyRelation(Relation relation)
 		MemoryContextDelete(relation->rd_indexcxt);
 	if (relation->rd_rulescxt)
 		MemoryContextDelete(relation->rd_rulescxt);
+	if (relation->rd_partkeycxt)
+		MemoryContextDelete(relation->rd_partkeycxt);
+	if (relation->rd_pdcxt)
+		MemoryContextDelete(relation->rd_pdcxt);
+	if (relation->rd_partcheckcxt)
+		MemoryContextDelete(relation->rd_partcheckcxt);
 	if (relation->rd_fdwroutine)
 		pfree(relation->rd_fdwroutine);
 	pfree(relation);
@@ -4560,6 +4566,13 @@ load_relcache_init_file(bool shared)
 		rel->rd_exclprocs = NULL;
 		rel->rd_exclstrats = NULL;
 		rel->rd_fdwroutine = NULL;
+		rel->rd_partkey = NULL;
+		rel->rd_partkeycxt = NULL;
+		rel->rd_partdesc = NULL;
+		rel->rd_pdcxt = NULL;
+		rel->rd_partcheck = NIL;
+		rel->rd_partcheckcxt = NULL;
+		rel->rd_partcheckvalid = false;
 
 		/*
 		 * Reset transient-state fields in the relcache entry
@@ -461,6 +461,31 @@ InitializeMaxBackends(void)
 		elog(ERROR, "too many backends configured");
 }
 
+/*
+ * Initialize the number of fast-path lock groups per backend.
+ *
+ * Backends that use many relations, like queries on tables with many
+ * partitions, need many fast-path slots, and max_locks_per_transaction is
+ * the best indication we have of how many locks a transaction will take.
+ * We allocate enough groups for that many locks, rounded up to a power of 2,
+ * but no more than FP_LOCK_GROUPS_PER_BACKEND_MAX.
+ *
+ * Like InitializeMaxBackends(), this must be called before shared memory size
+ * is determined, and in EXEC_BACKEND environment the value is passed down to
+ * subprocesses via BackendParameters.
+ */
+void
+InitializeFastPathLocks(void)
+{
+	Assert(FastPathLockGroupsPerBackend == 0);
+
+	FastPathLockGroupsPerBackend = 1;
+	while (FastPathLockGroupsPerBackend < FP_LOCK_GROUPS_PER_BACKEND_MAX &&
+		   FastPathLockGroupsPerBackend * FP_LOCK_SLOTS_PER_GROUP <
+		   max_locks_per_xact)
+		FastPathLockGroupsPerBackend *= 2;
+}
+
 /*
  * Early initialization of a backend (either standalone or under postmaster).
  * This happens even before InitPostgres.
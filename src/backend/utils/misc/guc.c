@@ -26,7 +26,11 @@
 #include <syslog.h>
 #endif
 
+#include "access/clog.h"
 #include "access/gin.h"
+#include "access/multixact.h"
+#include "access/slru.h"
+#include "access/subtrans.h"
 #include "access/transam.h"
 #include "access/twophase.h"
 #include "access/xact.h"
@@ -57,6 +61,7 @@
 #include "postmaster/postmaster.h"
 #include "postmaster/syslogger.h"
 #include "postmaster/walwriter.h"
+#include "replication/reorderbuffer.h"
 #include "replication/slot.h"
 #include "replication/syncrep.h"
 #include "replication/walreceiver.h"
@@ -173,6 +178,7 @@ static void assign_syslog_facility(int newval, void *extra);
 static void assign_syslog_ident(const char *newval, void *extra);
 static void assign_session_replication_role(int newval, void *extra);
 static bool check_temp_buffers(int *newval, void **extra, GucSource source);
+static bool check_slru_buffers(int *newval, void **extra, GucSource source);
 static bool check_phony_autocommit(bool *newval, void **extra, GucSource source);
 static bool check_debug_assertions(bool *newval, void **extra, GucSource source);
 static bool check_bonjour(bool *newval, void **extra, GucSource source);
@@ -194,6 +200,8 @@ static bool check_maxconnections(int *newval, void **extra, GucSource source);
 static bool check_max_worker_processes(int *newval, void **extra, GucSource source);
 static bool check_autovacuum_max_workers(int *newval, void **extra, GucSource source);
 static bool check_autovacuum_work_mem(int *newval, void **extra, GucSource source);
+static bool check_lock_manager_partitions(int *newval, void **extra, GucSource source);
+static void assign_lock_manager_partitions(int newval, void *extra);
 static bool check_effective_io_concurrency(int *newval, void **extra, GucSource source);
 static void assign_effective_io_concurrency(int newval, void *extra);
 static void assign_pgstat_temp_directory(const char *newval, void *extra);
@@ -718,6 +726,15 @@ static struct config_bool ConfigureNamesBool[] =
 		true,
 		NULL, NULL, NULL
 	},
+	{
+		{"enable_indexskipscan", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enables the planner's use of index skip scans."),
+			NULL
+		},
+		&enable_indexskipscan,
+		true,
+		NULL, NULL, NULL
+	},
 	{
 		{"enable_bitmapscan", PGC_USERSET, QUERY_TUNING_METHOD,
 			gettext_noop("Enables the planner's use of bitmap-scan plans."),
@@ -745,6 +762,15 @@ static struct config_bool ConfigureNamesBool[] =
 		true,
 		NULL, NULL, NULL
 	},
+	{
+		{"enable_incrementalsort", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enables the planner's use of incremental sort steps."),
+			NULL
+		},
+		&enable_incrementalsort,
+		true,
+		NULL, NULL, NULL
+	},
 	{
 		{"enable_hashagg", PGC_USERSET, QUERY_TUNING_METHOD,
 			gettext_noop("Enables the planner's use of hashed aggregation plans."),
@@ -790,6 +816,24 @@ static struct config_bool ConfigureNamesBool[] =
 		true,
 		NULL, NULL, NULL
 	},
+	{
+		{"enable_partitionwise_join", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enables the planner's use of partition-wise joins."),
+			NULL
+		},
+		&enable_partitionwise_join,
+		false,
+		NULL, NULL, NULL
+	},
+	{
+		{"enable_partitionwise_aggregate", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enables the planner's use of partition-wise aggregation."),
+			NULL
+		},
+		&enable_partitionwise_aggregate,
+		false,
+		NULL, NULL, NULL
+	},
 	{
 		{"geqo", PGC_USERSET, QUERY_TUNING_GEQO,
 			gettext_noop("Enables genetic query optimization."),
@@ -1722,6 +1766,50 @@ static struct config_int ConfigureNamesInt[] =
 		check_temp_buffers, NULL, NULL
 	},
 
+	{
+		{"transaction_buffers", PGC_POSTMASTER, RESOURCES_MEM,
+			gettext_noop("Sets the number of shared memory buffers used for the transaction status cache."),
+			gettext_noop("0 means to size it based on shared_buffers."),
+			GUC_UNIT_BLOCKS
+		},
+		&transaction_buffers,
+		0, 0, SLRU_MAX_BUFFERS,
+		check_slru_buffers, NULL, NULL
+	},
+
+	{
+		{"subtransaction_buffers", PGC_POSTMASTER, RESOURCES_MEM,
+			gettext_noop("Sets the number of shared memory buffers used for the subtransaction cache."),
+			gettext_noop("0 means to size it based on shared_buffers."),
+			GUC_UNIT_BLOCKS
+		},
+		&subtransaction_buffers,
+		0, 0, SLRU_MAX_BUFFERS,
+		check_slru_buffers, NULL, NULL
+	},
+
+	{
+		{"multixact_offset_buffers", PGC_POSTMASTER, RESOURCES_MEM,
+			gettext_noop("Sets the number of shared memory buffers used for the MultiXact offset cache."),
+			NULL,
+			GUC_UNIT_BLOCKS
+		},
+		&multixact_offset_buffers,
+		DEFAULT_MXACTOFFSET_BUFFERS, SLRU_MIN_BUFFERS, SLRU_MAX_BUFFERS,
+		check_slru_buffers, NULL, NULL
+	},
+
+	{
+		{"multixact_member_buffers", PGC_POSTMASTER, RESOURCES_MEM,
+			gettext_noop("Sets the number of shared memory buffers used for the MultiXact member cache."),
+			NULL,
+			GUC_UNIT_BLOCKS
+		},
+		&multixact_member_buffers,
+		DEFAULT_MXACTMEMBER_BUFFERS, SLRU_MIN_BUFFERS, SLRU_MAX_BUFFERS,
+		check_slru_buffers, NULL, NULL
+	},
+
 	{
 		{"port", PGC_POSTMASTER, CONN_AUTH_SETTINGS,
 			gettext_noop("Sets the TCP port the server listens on."),
@@ -2029,6 +2117,18 @@ static struct config_int ConfigureNamesInt[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"lock_manager_partitions", PGC_POSTMASTER, LOCK_MANAGEMENT,
+			gettext_noop("Sets the number of partitions of the shared lock table."),
+			gettext_noop("Each partition is protected by its own lock, so more "
+						 "partitions reduce contention between sessions "
+						 "taking many locks.  Must be a power of 2.")
+		},
+		&NumLockPartitions,
+		64, 16, MAX_LOCK_PARTITIONS,
+		check_lock_manager_partitions, assign_lock_manager_partitions, NULL
+	},
+
 	{
 		{"authentication_timeout", PGC_SIGHUP, CONN_AUTH_SECURITY,
 			gettext_noop("Sets the maximum allowed time to complete client authentication."),
@@ -2447,6 +2547,18 @@ static struct config_int ConfigureNamesInt[] =
 		check_autovacuum_work_mem, NULL, NULL
 	},
 
+	{
+		{"logical_decoding_work_mem", PGC_USERSET, RESOURCES_MEM,
+			gettext_noop("Sets the maximum memory to be used for logical decoding."),
+			gettext_noop("This much memory can be used by each decoding process before "
+						 "transactions are spilled to disk or streamed."),
+			GUC_UNIT_KB
+		},
+		&logical_decoding_work_mem,
+		65536, 64, MAX_KILOBYTES,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"tcp_keepalives_idle", PGC_USERSET, CLIENT_CONN_OTHER,
 			gettext_noop("Time between issuing TCP keepalives."),
@@ -9085,6 +9197,19 @@ check_temp_buffers(int *newval, void **extra, GucSource source)
 	return true;
 }
 
+static bool
+check_slru_buffers(int *newval, void **extra, GucSource source)
+{
+	/* zero, where allowed, selects the automatic setting */
+	if (*newval % SLRU_BANK_SIZE != 0)
+	{
+		GUC_check_errdetail("The number of SLRU buffers must be a multiple of %d.",
+							SLRU_BANK_SIZE);
+		return false;
+	}
+	return true;
+}
+
 static bool
 check_phony_autocommit(bool *newval, void **extra, GucSource source)
 {
@@ -9341,6 +9466,28 @@ check_autovacuum_work_mem(int *newval, void **extra, GucSource source)
 	return true;
 }
 
+static bool
+check_lock_manager_partitions(int *newval, void **extra, GucSource source)
+{
+	/* the partition number is taken from the low bits of the hash code */
+	if ((*newval & (*newval - 1)) != 0)
+	{
+		GUC_check_errdetail("The number of lock manager partitions must be a power of 2.");
+		return false;
+	}
+	return true;
+}
+
+static void
+assign_lock_manager_partitions(int newval, void *extra)
+{
+	int			log2 = 0;
+
+	while ((1 << log2) < newval)
+		log2++;
+	Log2NumLockPartitions = log2;
+}
+
 static bool
 check_max_worker_processes(int *newval, void **extra, GucSource source)
 {
@@ -0,0 +1,665 @@
+/*-------------------------------------------------------------------------
+ *
+ * generation.c
+ *	  Generational allocator definitions.
+ *
+ * Generation is a custom MemoryContext implementation designed for cases of
+ * chunks with similar lifespan.
+ *
+ *
+ * Portions Copyright (c) 1996-2014, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * IDENTIFICATION
+ *	  src/backend/utils/mmgr/generation.c
+ *
+ *
+ * NOTE:
+ *	This memory context is based on the assumption that the chunks are freed
+ *	roughly in the same order as they were allocated (FIFO), or in groups
+ *	with similar lifespan (generations - hence the name of the context).
+ *	This is typical for various queue-like use cases, i.e. when tuples are
+ *	constructed, processed and then thrown away.
+ *
+ *	The memory context uses a very simple approach to free space management.
+ *	Instead of a complex global freelist, each block tracks a number of
+ *	allocated and freed chunks.  Chunks are carved sequentially out of the
+ *	current block, rounded up only to MAXALIGN, and freed chunks are never
+ *	reused.  When all the chunks in a block are freed, the whole block is
+ *	returned to malloc().  The current block is never reused once a chunk
+ *	could not fit in it; a new block is allocated instead.
+ *
+ *	Requests larger than a fraction of the block size get a dedicated block
+ *	of their own, which is thus released as soon as the chunk is pfree'd.
+ *
+ *	Every chunk carries a pointer to its block, followed by the standard
+ *	chunk header that mcxt.c expects immediately before the chunk's data.
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "lib/ilist.h"
+#include "utils/memdebug.h"
+#include "utils/memutils.h"
+
+
+/* Chunks larger than this fraction of the block size get their own block */
+#define GENERATION_CHUNK_FRACTION	8
+
+typedef struct GenerationBlockData *GenerationBlock;
+
+/*
+ * GenerationContext is a simple memory context not reusing allocated chunks,
+ * and freeing blocks once all chunks are freed.
+ */
+typedef struct GenerationContext
+{
+	MemoryContextData header;	/* Standard memory-context fields */
+	/* Generational context parameters */
+	Size		blockSize;		/* standard block size */
+	GenerationBlock block;		/* current (most recently allocated) block */
+	dlist_head	blocks;			/* list of blocks */
+} GenerationContext;
+
+typedef GenerationContext *Generation;
+
+/*
+ * GenerationBlock
+ *		GenerationBlock is the unit of memory that is obtained by generation.c
+ *		from malloc().  It contains one or more chunks, which are the units
+ *		requested by palloc() and freed by pfree().  Chunks cannot be
+ *		returned to malloc() individually; instead pfree() updates the free
+ *		counter of the block, and when all chunks in a block are free the
+ *		whole block is returned to malloc().
+ *
+ *		GenerationBlockData is the header data for a block --- the usable
+ *		space within the block begins at the next alignment boundary.
+ */
+typedef struct GenerationBlockData
+{
+	dlist_node	node;			/* doubly-linked list of blocks */
+	int			nchunks;		/* number of chunks in the block */
+	int			nfree;			/* number of free chunks */
+	char	   *freeptr;		/* start of free space in this block */
+	char	   *endptr;			/* end of space in this block */
+} GenerationBlockData;
+
+/*
+ * A chunk is laid out as a pointer to its block, the StandardChunkHeader,
+ * and then the data.  mcxt.c finds the header at a fixed offset from the
+ * data pointer, so the block pointer must come before it.  The block
+ * pointer of a freed chunk is set to NULL.
+ */
+#define Generation_BLOCKHDRSZ	MAXALIGN(sizeof(GenerationBlockData))
+#define Generation_BLOCKPTRSZ	MAXALIGN(sizeof(GenerationBlock))
+#define Generation_CHUNKHDRSZ	(Generation_BLOCKPTRSZ + STANDARDCHUNKHEADERSIZE)
+
+#define GenerationPointerGetHeader(ptr) \
+	((StandardChunkHeader *) (((char *) (ptr)) - STANDARDCHUNKHEADERSIZE))
+#define GenerationPointerGetBlockPtr(ptr) \
+	((GenerationBlock *) (((char *) (ptr)) - Generation_CHUNKHDRSZ))
+
+/*
+ * These functions implement the MemoryContext API for Generation contexts.
+ */
+static void *GenerationAlloc(MemoryContext context, Size size);
+static void GenerationFree(MemoryContext context, void *pointer);
+static void *GenerationRealloc(MemoryContext context, void *pointer, Size size);
+static void GenerationInit(MemoryContext context);
+static void GenerationReset(MemoryContext context);
+static void GenerationDelete(MemoryContext context);
+static Size GenerationGetChunkSpace(MemoryContext context, void *pointer);
+static bool GenerationIsEmpty(MemoryContext context);
+static void GenerationStats(MemoryContext context, int level);
+
+#ifdef MEMORY_CONTEXT_CHECKING
+static void GenerationCheck(MemoryContext context);
+#endif
+
+/*
+ * This is the virtual function table for Generation contexts.
+ */
+static MemoryContextMethods GenerationMethods = {
+	GenerationAlloc,
+	GenerationFree,
+	GenerationRealloc,
+	GenerationInit,
+	GenerationReset,
+	GenerationDelete,
+	GenerationGetChunkSpace,
+	GenerationIsEmpty,
+	GenerationStats
+#ifdef MEMORY_CONTEXT_CHECKING
+	,GenerationCheck
+#endif
+};
+
+
+/*
+ * Public routines
+ */
+
+
+/*
+ * GenerationContextCreate
+ *		Create a new Generation context.
+ *
+ * parent: parent context, or NULL if top-level context
+ * name: name of context (for debugging --- string will be copied)
+ * blockSize: generation block size
+ */
+MemoryContext
+GenerationContextCreate(MemoryContext parent,
+						const char *name,
+						Size blockSize)
+{
+	Generation	set;
+
+	/*
+	 * First, validate allocation parameters.  (If we're going to throw an
+	 * error, we should do so before the context is created, not after.)  We
+	 * somewhat arbitrarily enforce a minimum 1K block size, mostly because
+	 * that's what AllocSet does.
+	 */
+	blockSize = MAXALIGN(blockSize);
+	if (blockSize < 1024 || !AllocHugeSizeIsValid(blockSize))
+		elog(ERROR, "invalid blockSize for memory context: %zu",
+			 blockSize);
+
+	/* Do the type-independent part of context creation */
+	set = (Generation) MemoryContextCreate(T_GenerationContext,
+										   sizeof(GenerationContext),
+										   &GenerationMethods,
+										   parent,
+										   name);
+
+	set->blockSize = blockSize;
+	set->block = NULL;
+	dlist_init(&set->blocks);
+
+	return (MemoryContext) set;
+}
+
+/*
+ * GenerationInit
+ *		Context-type-specific initialization routine.
+ */
+static void
+GenerationInit(MemoryContext context)
+{
+	/*
+	 * Since MemoryContextCreate already zeroed the context node, we don't
+	 * have to do anything here: GenerationContextCreate sets up the rest.
+	 */
+}
+
+/*
+ * GenerationReset
+ *		Frees all memory which is allocated in the given set.
+ *
+ * The code simply frees all the blocks in the context - we don't keep any
+ * keeper blocks or anything like that.
+ */
+static void
+GenerationReset(MemoryContext context)
+{
+	Generation	set = (Generation) context;
+	dlist_mutable_iter miter;
+
+	AssertArg(set != NULL);
+
+#ifdef MEMORY_CONTEXT_CHECKING
+	/* Check for corruption and leaks before freeing */
+	GenerationCheck(context);
+#endif
+
+	dlist_foreach_modify(miter, &set->blocks)
+	{
+		GenerationBlock block = dlist_container(GenerationBlockData, node, miter.cur);
+
+		dlist_delete(miter.cur);
+
+#ifdef CLOBBER_FREED_MEMORY
+		wipe_mem(block, block->freeptr - ((char *) block));
+#endif
+
+		free(block);
+	}
+
+	set->block = NULL;
+
+	Assert(dlist_is_empty(&set->blocks));
+}
+
+/*
+ * GenerationDelete
+ *		Frees all memory which is allocated in the given set, in preparation
+ *		for deletion of the set.  We simply call GenerationReset() which does
+ *		all the dirty work.
+ */
+static void
+GenerationDelete(MemoryContext context)
+{
+	GenerationReset(context);
+}
+
+/*
+ * GenerationAlloc
+ *		Returns pointer to allocated memory of given size or NULL if
+ *		request could not be completed; memory is added to the set.
+ *
+ * No request may exceed:
+ *		MAXALIGN_DOWN(SIZE_MAX) - Generation_BLOCKHDRSZ - Generation_CHUNKHDRSZ
+ * All callers use a much-lower limit.
+ */
+static void *
+GenerationAlloc(MemoryContext context, Size size)
+{
+	Generation	set = (Generation) context;
+	GenerationBlock block;
+	StandardChunkHeader *header;
+	char	   *chunk;
+	Size		chunk_size = MAXALIGN(size);
+
+	AssertArg(set != NULL);
+
+	/* is it an over-sized chunk? if yes, allocate special block */
+	if (chunk_size > set->blockSize / GENERATION_CHUNK_FRACTION)
+	{
+		Size		blksize = chunk_size + Generation_BLOCKHDRSZ + Generation_CHUNKHDRSZ;
+
+		block = (GenerationBlock) malloc(blksize);
+		if (block == NULL)
+		{
+			MemoryContextStats(TopMemoryContext);
+			ereport(ERROR,
+					(errcode(ERRCODE_OUT_OF_MEMORY),
+					 errmsg("out of memory"),
+					 errdetail("Failed on request of size %zu.", size)));
+		}
+
+		/* block with a single (used) chunk */
+		block->nchunks = 1;
+		block->nfree = 0;
+
+		/* the block is completely full */
+		block->freeptr = block->endptr = ((char *) block) + blksize;
+
+		/* add the block to the list of allocated blocks */
+		dlist_push_head(&set->blocks, &block->node);
+
+		chunk = ((char *) block) + Generation_BLOCKHDRSZ + Generation_CHUNKHDRSZ;
+	}
+	else
+	{
+		/*
+		 * Not an over-sized chunk.  Is there enough space in the current
+		 * block?  If not, allocate a new "regular" block.
+		 */
+		block = set->block;
+
+		if ((block == NULL) ||
+			(block->endptr - block->freeptr) < Generation_CHUNKHDRSZ + chunk_size)
+		{
+			Size		blksize = set->blockSize;
+
+			block = (GenerationBlock) malloc(blksize);
+			if (block == NULL)
+			{
+				MemoryContextStats(TopMemoryContext);
+				ereport(ERROR,
+						(errcode(ERRCODE_OUT_OF_MEMORY),
+						 errmsg("out of memory"),
+						 errdetail("Failed on request of size %zu.", size)));
+			}
+
+			block->nchunks = 0;
+			block->nfree = 0;
+
+			block->freeptr = ((char *) block) + Generation_BLOCKHDRSZ;
+			block->endptr = ((char *) block) + blksize;
+
+			/* Mark unallocated space NOACCESS. */
+			VALGRIND_MAKE_MEM_NOACCESS(block->freeptr,
+									   blksize - Generation_BLOCKHDRSZ);
+
+			/* add it to the doubly-linked list of blocks */
+			dlist_push_head(&set->blocks, &block->node);
+
+			/* and also use it as the current allocation block */
+			set->block = block;
+		}
+
+		/* we're supposed to have a block with enough free space now */
+		Assert(block != NULL);
+		Assert((block->endptr - block->freeptr) >= Generation_CHUNKHDRSZ + chunk_size);
+
+		chunk = block->freeptr + Generation_CHUNKHDRSZ;
+
+		block->nchunks += 1;
+		block->freeptr += (Generation_CHUNKHDRSZ + chunk_size);
+
+		Assert(block->freeptr <= block->endptr);
+	}
+
+	/* Fill in the chunk headers */
+	VALGRIND_MAKE_MEM_DEFINED(chunk - Generation_CHUNKHDRSZ, Generation_CHUNKHDRSZ);
+	*GenerationPointerGetBlockPtr(chunk) = block;
+	header = GenerationPointerGetHeader(chunk);
+	header->context = (MemoryContext) set;
+	header->size = chunk_size;
+
+#ifdef MEMORY_CONTEXT_CHECKING
+	header->requested_size = size;
+	/* set mark to catch clobber of "unused" space */
+	if (size < chunk_size)
+		set_sentinel(chunk, size);
+#endif
+#ifdef RANDOMIZE_ALLOCATED_MEMORY
+	/* fill the allocated space with junk */
+	randomize_mem(chunk, size);
+#endif
+
+	/* Ensure any padding bytes are marked NOACCESS. */
+	VALGRIND_MAKE_MEM_NOACCESS(chunk + size, chunk_size - size);
+
+	return chunk;
+}
+
+/*
+ * GenerationFree
+ *		Update number of chunks in the block, and if all chunks in the block
+ *		are now free then discard the block.
+ */
+static void
+GenerationFree(MemoryContext context, void *pointer)
+{
+	Generation	set = (Generation) context;
+	GenerationBlock *blockptr = GenerationPointerGetBlockPtr(pointer);
+	GenerationBlock block = *blockptr;
+
+	Assert(block != NULL);
+
+#ifdef MEMORY_CONTEXT_CHECKING
+	{
+		StandardChunkHeader *header = GenerationPointerGetHeader(pointer);
+
+		/* Test for someone scribbling on unused space in chunk */
+		if (header->requested_size < header->size)
+			if (!sentinel_ok(pointer, header->requested_size))
+				elog(WARNING, "detected write past chunk end in %s %p",
+					 set->header.name, pointer);
+		/* Reset requested_size to 0 in chunks that are on freelist */
+		header->requested_size = 0;
+	}
+#endif
+
+#ifdef CLOBBER_FREED_MEMORY
+	wipe_mem(pointer, GenerationPointerGetHeader(pointer)->size);
+#endif
+
+	/* Mark the chunk as free */
+	*blockptr = NULL;
+
+	block->nfree += 1;
+
+	Assert(block->nchunks > 0);
+	Assert(block->nfree <= block->nchunks);
+
+	/* If there are still allocated chunks in the block, we're done. */
+	if (block->nfree < block->nchunks)
+		return;
+
+	/*
+	 * The block is empty, so let's get rid of it.  First remove it from the
+	 * list of blocks, then return it to malloc().
+	 */
+	dlist_delete(&block->node);
+
+	/* Also make sure the block is not marked as the current block. */
+	if (set->block == block)
+		set->block = NULL;
+
+#ifdef CLOBBER_FREED_MEMORY
+	wipe_mem(block, block->freeptr - ((char *) block));
+#endif
+
+	free(block);
+}
+
+/*
+ * GenerationRealloc
+ *		When handling repalloc, we simply allocate a new chunk, copy the data
+ *		and discard the old one.  The only exception is when the new size fits
+ *		into the old chunk - in that case we just update chunk header.
+ */
+static void *
+GenerationRealloc(MemoryContext context, void *pointer, Size size)
+{
+	Generation	set = (Generation) context;
+	StandardChunkHeader *header = GenerationPointerGetHeader(pointer);
+	Size		oldsize = header->size;
+	void	   *newPointer;
+
+#ifdef MEMORY_CONTEXT_CHECKING
+	/* Test for someone scribbling on unused space in chunk */
+	if (header->requested_size < oldsize)
+		if (!sentinel_ok(pointer, header->requested_size))
+			elog(WARNING, "detected write past chunk end in %s %p",
+				 set->header.name, pointer);
+#endif
+
+	/*
+	 * Maybe the allocated area already is >= the new size.  (In particular,
+	 * we always fall out here if the requested size is a decrease.)  Chunks
+	 * are only MAXALIGN'd here, not rounded to a power of 2, so most
+	 * enlargements will end up in the palloc/memcpy/pfree branch.
+	 */
+	if (oldsize >= size)
+	{
+#ifdef MEMORY_CONTEXT_CHECKING
+		Size		oldrequest = header->requested_size;
+
+#ifdef RANDOMIZE_ALLOCATED_MEMORY
+		/* We can only fill the extra space if we know the prior request */
+		if (size > oldrequest)
+			randomize_mem((char *) pointer + oldrequest,
+						  size - oldrequest);
+#endif
+
+		header->requested_size = size;
+
+		/*
+		 * If this is an increase, mark any newly-available part UNDEFINED.
+		 * Otherwise, mark the obsolete part NOACCESS.
+		 */
+		if (size > oldrequest)
+			VALGRIND_MAKE_MEM_UNDEFINED((char *) pointer + oldrequest,
+										size - oldrequest);
+		else
+			VALGRIND_MAKE_MEM_NOACCESS((char *) pointer + size,
+									   oldsize - size);
+
+		/* set mark to catch clobber of "unused" space */
+		if (size < oldsize)
+			set_sentinel(pointer, size);
+#else							/* !MEMORY_CONTEXT_CHECKING */
+
+		/*
+		 * We don't have the information to determine whether we're growing
+		 * the old request or shrinking it, so we conservatively mark the
+		 * entire new allocation DEFINED.
+		 */
+		VALGRIND_MAKE_MEM_NOACCESS(pointer, oldsize);
+		VALGRIND_MAKE_MEM_DEFINED(pointer, size);
+#endif
+
+		return pointer;
+	}
+
+	/* allocate new chunk */
+	newPointer = GenerationAlloc((MemoryContext) set, size);
+
+	/* transfer existing data (certain to fit) */
+	memcpy(newPointer, pointer, oldsize);
+
+	/* free old chunk */
+	GenerationFree((MemoryContext) set, pointer);
+
+	return newPointer;
+}
+
+/*
+ * GenerationGetChunkSpace
+ *		Given a currently-allocated chunk, determine the total space
+ *		it occupies (including all memory-allocation overhead).
+ */
+static Size
+GenerationGetChunkSpace(MemoryContext context, void *pointer)
+{
+	return GenerationPointerGetHeader(pointer)->size + Generation_CHUNKHDRSZ;
+}
+
+/*
+ * GenerationIsEmpty
+ *		Is a Generation context empty of any allocated space?
+ */
+static bool
+GenerationIsEmpty(MemoryContext context)
+{
+	Generation	set = (Generation) context;
+
+	return dlist_is_empty(&set->blocks);
+}
+
+/*
+ * GenerationStats
+ *		Displays stats about memory consumption of a Generation context.
+ *
+ * XXX freespace only accounts for empty space at the end of the block, not
+ * space of freed chunks (which is unknown).
+ */
+static void
+GenerationStats(MemoryContext context, int level)
+{
+	Generation	set = (Generation) context;
+	Size		nblocks = 0;
+	Size		nchunks = 0;
+	Size		nfreechunks = 0;
+	Size		totalspace = 0;
+	Size		freespace = 0;
+	dlist_iter	iter;
+	int			i;
+
+	dlist_foreach(iter, &set->blocks)
+	{
+		GenerationBlock block = dlist_container(GenerationBlockData, node, iter.cur);
+
+		nblocks++;
+		nchunks += block->nchunks;
+		nfreechunks += block->nfree;
+		totalspace += block->endptr - ((char *) block);
+		freespace += (block->endptr - block->freeptr);
+	}
+
+	for (i = 0; i < level; i++)
+		fprintf(stderr, "  ");
+
+	fprintf(stderr,
+			"%s: %zu total in %zd blocks (%zd chunks); %zu free (%zd chunks); %zu used\n",
+			set->header.name, totalspace, nblocks, nchunks, freespace,
+			nfreechunks, totalspace - freespace);
+}
+
+
+#ifdef MEMORY_CONTEXT_CHECKING
+
+/*
+ * GenerationCheck
+ *		Walk through chunks and check consistency of memory.
+ *
+ * NOTE: report errors as WARNING, *not* ERROR or FATAL.  Otherwise you'll
+ * find yourself in an infinite loop when trouble occurs, because this
+ * routine will be entered again when elog cleanup tries to release memory!
+ */
+static void
+GenerationCheck(MemoryContext context)
+{
+	Generation	gen = (Generation) context;
+	char	   *name = gen->header.name;
+	dlist_iter	iter;
+
+	/* walk all blocks in this context */
+	dlist_foreach(iter, &gen->blocks)
+	{
+		GenerationBlock block = dlist_container(GenerationBlockData, node, iter.cur);
+		int			nfree,
+					nchunks;
+		char	   *ptr;
+
+		/*
+		 * nfree > nchunks is surely wrong, and we don't expect to see
+		 * equality either, because such a block should have gotten freed.
+		 */
+		if (block->nfree >= block->nchunks)
+			elog(WARNING, "problem in Generation %s: number of free chunks %d in block %p exceeds %d allocated",
+				 name, block->nfree, block, block->nchunks);
+
+		/* Now walk through the chunks and count them. */
+		nfree = 0;
+		nchunks = 0;
+		ptr = ((char *) block) + Generation_BLOCKHDRSZ;
+
+		while (ptr < block->freeptr)
+		{
+			char	   *chunk = ptr + Generation_CHUNKHDRSZ;
+			StandardChunkHeader *header = GenerationPointerGetHeader(chunk);
+			GenerationBlock chunkblock = *GenerationPointerGetBlockPtr(chunk);
+
+			/* move to the next chunk */
+			ptr += (header->size + Generation_CHUNKHDRSZ);
+
+			nchunks += 1;
+
+			/* chunks have both block and context pointers, so check both */
+			if (chunkblock == NULL)
+			{
+				nfree += 1;
+				continue;
+			}
+
+			if (chunkblock != block)
+				elog(WARNING, "problem in Generation %s: bogus block link in block %p, chunk %p",
+					 name, block, chunk);
+
+			if (header->context != (MemoryContext) gen)
+				elog(WARNING, "problem in Generation %s: bogus context link in block %p, chunk %p",
+					 name, block, chunk);
+
+			/* check sentinel */
+			if (header->requested_size > header->size)
+				elog(WARNING, "problem in Generation %s: req size > alloc size for chunk %p in block %p",
+					 name, chunk, block);
+			else if (header->requested_size < header->size &&
+					 !sentinel_ok(chunk, header->requested_size))
+				elog(WARNING, "problem in Generation %s: detected write past chunk end in block %p, chunk %p",
+					 name, block, chunk);
+		}
+
+		/*
+		 * Make sure we got the expected number of allocated and free chunks
+		 * (as tracked in the block header).
+		 */
+		if (nchunks != block->nchunks)
+			elog(WARNING, "problem in Generation %s: number of allocated chunks %d in block %p does not match header %d",
+				 name, nchunks, block, block->nchunks);
+
+		if (nfree != block->nfree)
+			elog(WARNING, "problem in Generation %s: number of free chunks %d in block %p does not match header %d",
+				 name, nfree, block, block->nfree);
+	}
+}
+
+#endif   /* MEMORY_CONTEXT_CHECKING */
@@ -0,0 +1,741 @@
+/*-------------------------------------------------------------------------
+ *
+ * slab.c
+ *	  Slab allocator definitions.
+ *
+ * Slab is a MemoryContext implementation designed for cases where large
+ * numbers of equally-sized objects are allocated (and freed).
+ *
+ *
+ * Portions Copyright (c) 1996-2014, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * IDENTIFICATION
+ *	  src/backend/utils/mmgr/slab.c
+ *
+ *
+ * NOTE:
+ *	The constant allocation size allows significant simplification and
+ *	various optimizations over more general purpose allocators.  The blocks
+ *	are carved into chunks of exactly the right size (plus alignment), not
+ *	wasting any memory on rounding up to powers of two as aset.c does.
+ *
+ *	The information about free chunks is maintained both at the block level
+ *	and global (context) level.  This is possible as the chunk size (and thus
+ *	also the number of chunks per block) is fixed.
+ *
+ *	On each block, free chunks are tracked in a simple linked list.  The
+ *	contents of a free chunk are replaced with the index of the next free
+ *	chunk, forming a very simple linked list.  Each block also contains a
+ *	counter of free chunks.  Combined with the block-level freelist, it makes
+ *	it trivial to eventually free the whole block.
+ *
+ *	At the context level, we use 'freelist' to track blocks ordered by number
+ *	of free chunks, starting with blocks having a single allocated chunk, and
+ *	with completely full blocks on the tail.
+ *
+ *	This also allows various optimizations - for example when searching for
+ *	a free chunk, the allocator reuses space from the fullest blocks first,
+ *	in the hope that some of the less full blocks will get completely empty
+ *	(and returned back to the OS).  As soon as a block gets completely empty,
+ *	it is returned to malloc().
+ *
+ *	For each block, we maintain a pointer to the first free chunk - this is
+ *	quite cheap and allows us to skip all the preceding used chunks,
+ *	eliminating a significant number of lookups in many common usage
+ *	patterns.  In the worst case this performs as if the pointer was not
+ *	maintained.
+ *
+ *	We cache the freelist index for the blocks with the fewest free chunks
+ *	(minFreeChunks), so that we don't have to search the freelist on every
+ *	SlabAlloc() call, which is quite expensive.
+ *
+ *	Every chunk carries a pointer to its block, followed by the standard
+ *	chunk header that mcxt.c expects immediately before the chunk's data.
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "lib/ilist.h"
+#include "utils/memdebug.h"
+#include "utils/memutils.h"
+
+
+/*
+ * SlabContext is a specialized implementation of MemoryContext.
+ */
+typedef struct SlabContext
+{
+	MemoryContextData header;	/* Standard memory-context fields */
+	/* Allocation parameters for this context: */
+	Size		chunkSize;		/* chunk size */
+	Size		fullChunkSize;	/* chunk size including header and alignment */
+	Size		blockSize;		/* block size */
+	int			chunksPerBlock; /* number of chunks per block */
+	int			minFreeChunks;	/* min number of free chunks in any block */
+	int			nblocks;		/* number of blocks allocated */
+	/* blocks with free space, grouped by number of free chunks: */
+	dlist_head	freelist[1];	/* VARIABLE LENGTH ARRAY */
+} SlabContext;
+
+typedef SlabContext *Slab;
+
+/*
+ * SlabBlock
+ *		Structure of a single block in SLAB allocator.
+ *
+ * node: doubly-linked list of blocks in global freelist
+ * nfree: number of free chunks in this block
+ * firstFreeChunk: index of the first free chunk
+ */
+typedef struct SlabBlockData
+{
+	dlist_node	node;			/* doubly-linked list */
+	int			nfree;			/* number of free chunks */
+	int			firstFreeChunk; /* index of the first free chunk in the block */
+} SlabBlockData;
+
+typedef SlabBlockData *SlabBlock;
+
+/*
+ * A chunk is laid out as a pointer to its block, the StandardChunkHeader,
+ * and then the data.  mcxt.c finds the header at a fixed offset from the
+ * data pointer, so the block pointer must come before it.
+ */
+#define SLAB_BLOCKHDRSZ		MAXALIGN(sizeof(SlabBlockData))
+#define SLAB_BLOCKPTRSZ		MAXALIGN(sizeof(SlabBlock))
+#define SLAB_CHUNKHDRSZ		(SLAB_BLOCKPTRSZ + STANDARDCHUNKHEADERSIZE)
+
+#define SlabPointerGetHeader(ptr) \
+	((StandardChunkHeader *) (((char *) (ptr)) - STANDARDCHUNKHEADERSIZE))
+#define SlabPointerGetBlock(ptr) \
+	(*(SlabBlock *) (((char *) (ptr)) - SLAB_CHUNKHDRSZ))
+#define SlabBlockGetChunk(slab, block, idx) \
+	((void *) ((char *) (block) + SLAB_BLOCKHDRSZ \
+			   + (idx) * (slab)->fullChunkSize + SLAB_CHUNKHDRSZ))
+#define SlabChunkIndex(slab, block, ptr) \
+	(((char *) (ptr) - SLAB_CHUNKHDRSZ - \
+	  ((char *) (block) + SLAB_BLOCKHDRSZ)) / (slab)->fullChunkSize)
+
+/*
+ * These functions implement the MemoryContext API for Slab contexts.
+ */
+static void *SlabAlloc(MemoryContext context, Size size);
+static void SlabFree(MemoryContext context, void *pointer);
+static void *SlabRealloc(MemoryContext context, void *pointer, Size size);
+static void SlabInit(MemoryContext context);
+static void SlabReset(MemoryContext context);
+static void SlabDelete(MemoryContext context);
+static Size SlabGetChunkSpace(MemoryContext context, void *pointer);
+static bool SlabIsEmpty(MemoryContext context);
+static void SlabStats(MemoryContext context, int level);
+
+#ifdef MEMORY_CONTEXT_CHECKING
+static void SlabCheck(MemoryContext context);
+#endif
+
+/*
+ * This is the virtual function table for Slab contexts.
+ */
+static MemoryContextMethods SlabMethods = {
+	SlabAlloc,
+	SlabFree,
+	SlabRealloc,
+	SlabInit,
+	SlabReset,
+	SlabDelete,
+	SlabGetChunkSpace,
+	SlabIsEmpty,
+	SlabStats
+#ifdef MEMORY_CONTEXT_CHECKING
+	,SlabCheck
+#endif
+};
+
+
+/*
+ * SlabContextCreate
+ *		Create a new Slab context.
+ *
+ * parent: parent context, or NULL if top-level context
+ * name: name of context (for debugging --- string will be copied)
+ * blockSize: allocation block size
+ * chunkSize: allocation chunk size
+ *
+ * The chunkSize may not exceed:
+ *		MAXALIGN_DOWN(SIZE_MAX) - MAXALIGN(sizeof(SlabBlockData)) - SLAB_CHUNKHDRSZ
+ */
+MemoryContext
+SlabContextCreate(MemoryContext parent,
+				  const char *name,
+				  Size blockSize,
+				  Size chunkSize)
+{
+	int			chunksPerBlock;
+	Size		fullChunkSize;
+	Size		freelistSize;
+	Slab		slab;
+	int			i;
+
+	/* Make sure the linked list node fits inside a freed chunk */
+	if (chunkSize < sizeof(int))
+		chunkSize = sizeof(int);
+
+	/* chunk, including SLAB header (both addresses nicely aligned) */
+	fullChunkSize = SLAB_CHUNKHDRSZ + MAXALIGN(chunkSize);
+
+	/* Make sure the block can store at least one chunk. */
+	if (blockSize < fullChunkSize + SLAB_BLOCKHDRSZ)
+		elog(ERROR, "block size %zu for slab is too small for %zu chunks",
+			 blockSize, chunkSize);
+
+	/* Compute maximum number of chunks per block */
+	chunksPerBlock = (blockSize - SLAB_BLOCKHDRSZ) / fullChunkSize;
+
+	/* The freelist starts with 0, ends with chunksPerBlock. */
+	freelistSize = sizeof(dlist_head) * (chunksPerBlock + 1);
+
+	/* Do the type-independent part of context creation */
+	slab = (Slab) MemoryContextCreate(T_SlabContext,
+									  offsetof(SlabContext, freelist) +
+									  freelistSize,
+									  &SlabMethods,
+									  parent,
+									  name);
+
+	slab->chunkSize = chunkSize;
+	slab->fullChunkSize = fullChunkSize;
+	slab->blockSize = blockSize;
+	slab->chunksPerBlock = chunksPerBlock;
+	slab->minFreeChunks = 0;
+	slab->nblocks = 0;
+
+	/* initialize the freelist slots */
+	for (i = 0; i < (slab->chunksPerBlock + 1); i++)
+		dlist_init(&slab->freelist[i]);
+
+	return (MemoryContext) slab;
+}
+
+/*
+ * SlabInit
+ *		Context-type-specific initialization routine.
+ */
+static void
+SlabInit(MemoryContext context)
+{
+	/*
+	 * Since MemoryContextCreate already zeroed the context node, we don't
+	 * have to do anything here: it's already OK.  The freelists are set up
+	 * by SlabContextCreate.
+	 */
+}
+
+/*
+ * SlabReset
+ *		Frees all memory which is allocated in the given set.
+ *
+ * The code simply frees all the blocks in the context - we don't keep any
+ * keeper blocks or anything like that.
+ */
+static void
+SlabReset(MemoryContext context)
+{
+	int			i;
+	Slab		slab = (Slab) context;
+
+	AssertArg(slab != NULL);
+
+#ifdef MEMORY_CONTEXT_CHECKING
+	/* Check for corruption and leaks before freeing */
+	SlabCheck(context);
+#endif
+
+	/* walk over freelists and free the blocks */
+	for (i = 0; i <= slab->chunksPerBlock; i++)
+	{
+		dlist_mutable_iter miter;
+
+		dlist_foreach_modify(miter, &slab->freelist[i])
+		{
+			SlabBlock	block = dlist_container(SlabBlockData, node, miter.cur);
+
+			dlist_delete(miter.cur);
+
+#ifdef CLOBBER_FREED_MEMORY
+			wipe_mem(block, slab->blockSize);
+#endif
+			free(block);
+			slab->nblocks--;
+		}
+	}
+
+	slab->minFreeChunks = 0;
+
+	Assert(slab->nblocks == 0);
+}
+
+/*
+ * SlabDelete
+ *		Frees all memory which is allocated in the given slab, in
+ *		preparation for deletion of the slab.  We simply call SlabReset().
+ */
+static void
+SlabDelete(MemoryContext context)
+{
+	SlabReset(context);
+}
+
+/*
+ * SlabAlloc
+ *		Returns pointer to allocated memory of given size or NULL if
+ *		request could not be completed; memory is added to the slab.
+ */
+static void *
+SlabAlloc(MemoryContext context, Size size)
+{
+	Slab		slab = (Slab) context;
+	SlabBlock	block;
+	StandardChunkHeader *header;
+	char	   *chunk;
+	int			idx;
+
+	AssertArg(slab != NULL);
+
+	Assert((slab->minFreeChunks >= 0) &&
+		   (slab->minFreeChunks < slab->chunksPerBlock));
+
+	/* make sure we only allow correct request size */
+	if (size != slab->chunkSize)
+		elog(ERROR, "unexpected alloc chunk size %zu (expected %zu)",
+			 size, slab->chunkSize);
+
+	/*
+	 * If there are no free chunks in any existing block, create a new block
+	 * and put it to the last freelist bucket.
+	 *
+	 * slab->minFreeChunks == 0 means there are no blocks with free chunks,
+	 * thanks to how minFreeChunks is updated at the end of SlabAlloc().
+	 */
+	if (slab->minFreeChunks == 0)
+	{
+		block = (SlabBlock) malloc(slab->blockSize);
+
+		if (block == NULL)
+		{
+			MemoryContextStats(TopMemoryContext);
+			ereport(ERROR,
+					(errcode(ERRCODE_OUT_OF_MEMORY),
+					 errmsg("out of memory"),
+					 errdetail("Failed on request of size %zu.", size)));
+		}
+
+		block->nfree = slab->chunksPerBlock;
+		block->firstFreeChunk = 0;
+
+		/*
+		 * Put all the chunks on a freelist. Walk the chunks and point each
+		 * one to the next one.
+		 */
+		for (idx = 0; idx < slab->chunksPerBlock; idx++)
+		{
+			chunk = SlabBlockGetChunk(slab, block, idx);
+			*(int *) chunk = (idx + 1);
+		}
+
+		/*
+		 * And add it to the last freelist with all chunks empty.
+		 *
+		 * We know there are no blocks in the freelist, otherwise we wouldn't
+		 * need a new block.
+		 */
+		Assert(dlist_is_empty(&slab->freelist[slab->chunksPerBlock]));
+
+		dlist_push_head(&slab->freelist[slab->chunksPerBlock], &block->node);
+
+		slab->minFreeChunks = slab->chunksPerBlock;
+		slab->nblocks += 1;
+	}
+
+	/* grab the block from the freelist (even the new block is there) */
+	block = dlist_head_element(SlabBlockData, node,
+							   &slab->freelist[slab->minFreeChunks]);
+
+	/* make sure we actually got a valid block, with matching nfree */
+	Assert(block != NULL);
+	Assert(slab->minFreeChunks == block->nfree);
+	Assert(block->nfree > 0);
+
+	/* we know index of the first free chunk in the block */
+	idx = block->firstFreeChunk;
+
+	/* make sure the chunk index is valid, and that it's marked as empty */
+	Assert((idx >= 0) && (idx < slab->chunksPerBlock));
+
+	/* compute the chunk location block start (after the block header) */
+	chunk = SlabBlockGetChunk(slab, block, idx);
+
+	/*
+	 * Update the block nfree count, and also the minFreeChunks as we've
+	 * decreased nfree for a block with the minimum number of free chunks
+	 * (because that's how we chose the block).
+	 */
+	block->nfree--;
+	slab->minFreeChunks = block->nfree;
+
+	/*
+	 * Remove the chunk from the freelist head. The index of the next free
+	 * chunk is stored in the chunk itself.
+	 */
+	block->firstFreeChunk = *(int *) chunk;
+
+	Assert(block->firstFreeChunk >= 0);
+	Assert(block->firstFreeChunk <= slab->chunksPerBlock);
+
+	Assert((block->nfree != 0 &&
+			block->firstFreeChunk < slab->chunksPerBlock) ||
+		   (block->nfree == 0 &&
+			block->firstFreeChunk == slab->chunksPerBlock));
+
+	/* move the whole block to the right place in the freelist */
+	dlist_delete(&block->node);
+	dlist_push_head(&slab->freelist[block->nfree], &block->node);
+
+	/*
+	 * And finally update minFreeChunks, i.e. the index to the block with the
+	 * lowest number of free chunks. We only need to do that when the block
+	 * got full (otherwise we know the current block is the right one). We'll
+	 * simply walk the freelist until we find a non-empty entry.
+	 */
+	if (slab->minFreeChunks == 0)
+	{
+		for (idx = 1; idx <= slab->chunksPerBlock; idx++)
+		{
+			if (dlist_is_empty(&slab->freelist[idx]))
+				continue;
+
+			/* found a non-empty freelist */
+			slab->minFreeChunks = idx;
+			break;
+		}
+	}
+
+	/* Prepare to initialize the chunk header. */
+	*(SlabBlock *) (chunk - SLAB_CHUNKHDRSZ) = block;
+	header = SlabPointerGetHeader(chunk);
+	header->context = (MemoryContext) slab;
+	header->size = MAXALIGN(size);
+
+#ifdef MEMORY_CONTEXT_CHECKING
+	header->requested_size = size;
+	/* slab mark to catch clobber of "unused" space */
+	if (slab->chunkSize < (slab->fullChunkSize - SLAB_CHUNKHDRSZ))
+		set_sentinel(chunk, size);
+#endif
+#ifdef RANDOMIZE_ALLOCATED_MEMORY
+	/* fill the allocated space with junk */
+	randomize_mem(chunk, size);
+#endif
+
+	return chunk;
+}
+
+/*
+ * SlabFree
+ *		Frees allocated memory; memory is removed from the slab.
+ */
+static void
+SlabFree(MemoryContext context, void *pointer)
+{
+	int			idx;
+	Slab		slab = (Slab) context;
+	SlabBlock	block = SlabPointerGetBlock(pointer);
+
+#ifdef MEMORY_CONTEXT_CHECKING
+	/* Test for someone scribbling on unused space in chunk */
+	if (slab->chunkSize < (slab->fullChunkSize - SLAB_CHUNKHDRSZ))
+		if (!sentinel_ok(pointer, slab->chunkSize))
+			elog(WARNING, "detected write past chunk end in %s %p",
+				 slab->header.name, pointer);
+	SlabPointerGetHeader(pointer)->requested_size = 0;
+#endif
+
+	/* compute index of the chunk with respect to block start */
+	idx = SlabChunkIndex(slab, block, pointer);
+
+	/* add chunk to freelist, and update block nfree count */
+	*(int *) pointer = block->firstFreeChunk;
+	block->firstFreeChunk = idx;
+	block->nfree++;
+
+	Assert(block->nfree > 0);
+	Assert(block->nfree <= slab->chunksPerBlock);
+
+#ifdef CLOBBER_FREED_MEMORY
+	/* XXX don't wipe the int32 index, used for block-level freelist */
+	wipe_mem((char *) pointer + sizeof(int),
+			 slab->chunkSize - sizeof(int));
+#endif
+
+	/* remove the block from a freelist */
+	dlist_delete(&block->node);
+
+	/*
+	 * See if we need to update the minFreeChunks field for the slab.
+	 *
+	 * If it is zero, no block had any free chunks, so the block we freed a
+	 * chunk in is now the one with the fewest - unless it has become entirely
+	 * free, in which case we free it below.
+	 *
+	 * Otherwise we only need to do something if the block had the minimum
+	 * number of free chunks before we freed one.  In that case, we check if
+	 * there still are blocks in the original freelist and we either keep the
+	 * current value (if there still are blocks) or increment it by one (the
+	 * block is still the one with minimum free chunks).  Again, if the block
+	 * got completely free we will free it, so we can't use it for
+	 * minFreeChunks; it however means there are no more blocks with free
+	 * chunks, as those would have had more free chunks than it had.
+	 */
+	if (slab->minFreeChunks == 0)
+	{
+		if (block->nfree < slab->chunksPerBlock)
+			slab->minFreeChunks = block->nfree;
+	}
+	else if (slab->minFreeChunks == (block->nfree - 1) &&
+			 dlist_is_empty(&slab->freelist[slab->minFreeChunks]))
+	{
+		if (block->nfree == slab->chunksPerBlock)
+			slab->minFreeChunks = 0;
+		else
+			slab->minFreeChunks++;
+	}
+
+	/* If the block is now completely empty, free it. */
+	if (block->nfree == slab->chunksPerBlock)
+	{
+#ifdef CLOBBER_FREED_MEMORY
+		wipe_mem(block, slab->blockSize);
+#endif
+		free(block);
+		slab->nblocks--;
+	}
+	else
+		dlist_push_head(&slab->freelist[block->nfree], &block->node);
+
+	Assert(slab->nblocks >= 0);
+}
+
+/*
+ * SlabRealloc
+ *		Change the allocated size of a chunk.
+ *
+ * As Slab is designed for allocating equally-sized chunks of memory, it can't
+ * do an actual chunk size change.  We try to be gentle and allow calls with
+ * exactly the same size, as in that case we can simply return the same
+ * chunk.  When the size differs, we throw an error.
+ *
+ * We could also allow requests with size < chunkSize.  That however seems
+ * rather pointless - Slab is meant for chunks of constant size, and moreover
+ * realloc is usually used to enlarge the chunk.
+ */
+static void *
+SlabRealloc(MemoryContext context, void *pointer, Size size)
+{
+	Slab		slab = (Slab) context;
+
+	Assert(slab);
+
+	/* can't do actual realloc with slab, but let's try to be gentle */
+	if (size == slab->chunkSize)
+		return pointer;
+
+	elog(ERROR, "slab allocator does not support realloc()");
+	return NULL;				/* keep compiler quiet */
+}
+
+/*
+ * SlabGetChunkSpace
+ *		Given a currently-allocated chunk, determine the total space
+ *		it occupies (including all memory-allocation overhead).
+ */
+static Size
+SlabGetChunkSpace(MemoryContext context, void *pointer)
+{
+	Slab		slab = (Slab) context;
+
+	Assert(slab);
+
+	return slab->fullChunkSize;
+}
+
+/*
+ * SlabIsEmpty
+ *		Is an Slab empty of any allocated space?
+ */
+static bool
+SlabIsEmpty(MemoryContext context)
+{
+	Slab		slab = (Slab) context;
+
+	Assert(slab);
+
+	return (slab->nblocks == 0);
+}
+
+/*
+ * SlabStats
+ *		Displays stats about memory consumption of a Slab.
+ */
+static void
+SlabStats(MemoryContext context, int level)
+{
+	Slab		slab = (Slab) context;
+	Size		nblocks = 0;
+	Size		freechunks = 0;
+	Size		totalspace = 0;
+	Size		freespace = 0;
+	int			i;
+
+	Assert(slab);
+
+	for (i = 0; i <= slab->chunksPerBlock; i++)
+	{
+		dlist_iter	iter;
+
+		dlist_foreach(iter, &slab->freelist[i])
+		{
+			SlabBlock	block = dlist_container(SlabBlockData, node, iter.cur);
+
+			nblocks++;
+			totalspace += slab->blockSize;
+			freespace += slab->fullChunkSize * block->nfree;
+			freechunks += block->nfree;
+		}
+	}
+
+	for (i = 0; i < level; i++)
+		fprintf(stderr, "  ");
+
+	fprintf(stderr,
+			"%s: %zu total in %zd blocks; %zu free (%zd chunks); %zu used\n",
+			slab->header.name, totalspace, nblocks, freespace, freechunks,
+			totalspace - freespace);
+}
+
+
+#ifdef MEMORY_CONTEXT_CHECKING
+
+/*
+ * SlabCheck
+ *		Walk through chunks and check consistency of memory.
+ *
+ * NOTE: report errors as WARNING, *not* ERROR or FATAL.  Otherwise you'll
+ * find yourself in an infinite loop when trouble occurs, because this
+ * routine will be entered again when elog cleanup tries to release memory!
+ */
+static void
+SlabCheck(MemoryContext context)
+{
+	int			i;
+	Slab		slab = (Slab) context;
+	char	   *name = slab->header.name;
+	bool	   *freechunks;
+
+	Assert(slab);
+	Assert(slab->chunksPerBlock > 0);
+
+	/*
+	 * Array to mark free chunks in a block.  We can't palloc it, as this is
+	 * called from within the memory context machinery.
+	 */
+	freechunks = (bool *) malloc(slab->chunksPerBlock * sizeof(bool));
+	if (freechunks == NULL)
+		return;
+
+	/* walk all the freelists */
+	for (i = 0; i <= slab->chunksPerBlock; i++)
+	{
+		int			j,
+					nfree;
+		dlist_iter	iter;
+
+		/* walk all blocks on this freelist */
+		dlist_foreach(iter, &slab->freelist[i])
+		{
+			int			idx;
+			SlabBlock	block = dlist_container(SlabBlockData, node, iter.cur);
+
+			/*
+			 * Make sure the number of free chunks (in the block header)
+			 * matches position in the freelist.
+			 */
+			if (block->nfree != i)
+				elog(WARNING, "problem in slab %s: number of free chunks %d in block %p does not match freelist %d",
+					 name, block->nfree, block, i);
+
+			/* reset the bitmap of free chunks for this block */
+			memset(freechunks, 0, (slab->chunksPerBlock * sizeof(bool)));
+			idx = block->firstFreeChunk;
+
+			/*
+			 * Now walk through the chunks, count the free ones and also
+			 * perform some additional checks for the used ones. As the chunk
+			 * freelist is stored within the chunks themselves, we have to
+			 * walk through the chunks and construct our own bitmap.
+			 */
+
+			nfree = 0;
+			while (idx < slab->chunksPerBlock)
+			{
+				char	   *chunk;
+
+				/* count the chunk as free, add it to the bitmap */
+				nfree++;
+				freechunks[idx] = true;
+
+				/* read index of the next free chunk */
+				chunk = SlabBlockGetChunk(slab, block, idx);
+				idx = *(int *) chunk;
+			}
+
+			for (j = 0; j < slab->chunksPerBlock; j++)
+			{
+				/* non-zero bit in the bitmap means chunk the chunk is used */
+				if (!freechunks[j])
+				{
+					char	   *chunk = SlabBlockGetChunk(slab, block, j);
+					StandardChunkHeader *header = SlabPointerGetHeader(chunk);
+
+					/* chunks have both block and slab pointers, so check both */
+					if (SlabPointerGetBlock(chunk) != block)
+						elog(WARNING, "problem in slab %s: bogus block link in block %p, chunk %p",
+							 name, block, chunk);
+
+					if (header->context != (MemoryContext) slab)
+						elog(WARNING, "problem in slab %s: bogus slab link in block %p, chunk %p",
+							 name, block, chunk);
+
+					/* there might be sentinel (thanks to alignment) */
+					if (slab->chunkSize < (slab->fullChunkSize - SLAB_CHUNKHDRSZ))
+						if (!sentinel_ok(chunk, slab->chunkSize))
+							elog(WARNING, "problem in slab %s: detected write past chunk end in block %p, chunk %p",
+								 name, block, chunk);
+				}
+			}
+
+			/*
+			 * Make sure we got the expected number of free chunks (as tracked
+			 * in the block header).
+			 */
+			if (nfree != block->nfree)
+				elog(WARNING, "problem in slab %s: number of free chunks %d in block %p does not match bitmap %d",
+					 name, block->nfree, block, nfree);
+		}
+	}
+
+	free(freechunks);
+}
+
+#endif   /* MEMORY_CONTEXT_CHECKING */
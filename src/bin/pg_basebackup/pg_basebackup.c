@@ -33,6 +33,7 @@
 #include "receivelog.h"
 #include "replication/basebackup.h"
 #include "streamutil.h"
+#include "utils/pg_crc.h"
 
 
 #define atooid(x)  ((Oid) strtoul((x), NULL, 10))
@@ -66,6 +67,12 @@ static bool	writerecoveryconf = false;
 static int	standby_message_timeout = 10 * 1000;		/* 10 sec = default */
 static pg_time_t last_progress_report = 0;
 static int32 maxrate = 0;		/* no limit by default */
+static char *incremental = NULL;	/* start location of prior backup */
+static int	server_compresslevel = 0;
+static bool	request_manifest = false;
+
+/* Files received in plain mode, in the same format as the manifest */
+static PQExpBuffer received_manifest = NULL;
 
 
 /* Progress counters */
@@ -101,6 +108,7 @@ static void progress_report(int tablespacenum, const char *filename, bool force)
 
 static void ReceiveTarFile(PGconn *conn, PGresult *res, int rownum);
 static void ReceiveAndUnpackTarFile(PGconn *conn, PGresult *res, int rownum);
+static void VerifyManifest(void);
 static void GenerateRecoveryConf(PGconn *conn);
 static void WriteRecoveryConf(void);
 static void BaseBackup(void);
@@ -237,8 +245,14 @@ usage(void)
 	printf(_("  -X, --xlog-method=fetch|stream\n"
 			 "                         include required WAL files with specified method\n"));
 	printf(_("      --xlogdir=XLOGDIR  location for the transaction log directory\n"));
+	printf(_("      --incremental=LSN  only send blocks changed since the prior backup\n"
+			 "                         that started at LSN\n"));
 	printf(_("  -z, --gzip             compress tar output\n"));
 	printf(_("  -Z, --compress=0-9     compress tar output with given compression level\n"));
+	printf(_("      --server-compress=1-9\n"
+			 "                         have the server compress tar output\n"));
+	printf(_("      --manifest         include a manifest of file sizes and checksums,\n"
+			 "                         and check plain output against it\n"));
 	printf(_("\nGeneral options:\n"));
 	printf(_("  -c, --checkpoint=fast|spread\n"
 			 "                         set fast or spread checkpointing\n"));
@@ -562,7 +576,22 @@ progress_report(int tablespacenum, const char *filename, bool force)
 	snprintf(totalsize_str, sizeof(totalsize_str), INT64_FORMAT, totalsize);
 
 #define VERBOSE_FILENAME_LENGTH 35
-	if (verbose)
+	if (server_compresslevel > 0)
+	{
+		/*
+		 * What we receive is compressed by the server, so all we can tell is
+		 * how much of it has arrived; it can't be compared with the
+		 * estimated total, which is of the uncompressed files.
+		 */
+		fprintf(stderr,
+				ngettext("%s kB received compressed, %d/%d tablespace",
+						 "%s kB received compressed, %d/%d tablespaces",
+						 tablespacecount),
+				totaldone_str, tablespacenum, tablespacecount);
+		if (verbose && !filename)
+			fprintf(stderr, "%*s", VERBOSE_FILENAME_LENGTH + 5, "");
+	}
+	else if (verbose)
 	{
 		if (!filename)
 
@@ -811,7 +840,8 @@ ReceiveTarFile(PGconn *conn, PGresult *res, int rownum)
 			else
 #endif
 			{
-				snprintf(filename, sizeof(filename), "%s/base.tar", basedir);
+				snprintf(filename, sizeof(filename), "%s/base.tar%s", basedir,
+						 server_compresslevel > 0 ? ".gz" : "");
 				tarfile = fopen(filename, "wb");
 			}
 		}
@@ -839,8 +869,9 @@ ReceiveTarFile(PGconn *conn, PGresult *res, int rownum)
 		else
 #endif
 		{
-			snprintf(filename, sizeof(filename), "%s/%s.tar", basedir,
-					 PQgetvalue(res, rownum, 0));
+			snprintf(filename, sizeof(filename), "%s/%s.tar%s", basedir,
+					 PQgetvalue(res, rownum, 0),
+					 server_compresslevel > 0 ? ".gz" : "");
 			tarfile = fopen(filename, "wb");
 		}
 	}
@@ -905,6 +936,26 @@ ReceiveTarFile(PGconn *conn, PGresult *res, int rownum)
 
 			MemSet(zerobuf, 0, sizeof(zerobuf));
 
+#ifdef HAVE_LIBZ
+
+			/*
+			 * If the server compressed the stream, what we have written so
+			 * far is a complete gzip file.  Write the rest as a second gzip
+			 * member after it, which gunzip treats as a continuation.
+			 */
+			if (server_compresslevel > 0)
+			{
+				if (fflush(tarfile) != 0 ||
+					(ztarfile = gzdopen(dup(fileno(tarfile)), "wb")) == NULL)
+				{
+					fprintf(stderr,
+							_("%s: could not create compressed file \"%s\": %s\n"),
+							progname, filename, strerror(errno));
+					disconnect_and_exit(1);
+				}
+			}
+#endif
+
 			if (basetablespace && writerecoveryconf)
 			{
 				char		header[512];
@@ -936,6 +987,16 @@ ReceiveTarFile(PGconn *conn, PGresult *res, int rownum)
 							progname, filename, get_gz_error(ztarfile));
 					disconnect_and_exit(1);
 				}
+				if (server_compresslevel > 0 && strcmp(basedir, "-") != 0)
+				{
+					if (fclose(tarfile) != 0)
+					{
+						fprintf(stderr,
+								_("%s: could not close file \"%s\": %s\n"),
+								progname, filename, strerror(errno));
+						disconnect_and_exit(1);
+					}
+				}
 			}
 			else
 #endif
@@ -961,12 +1022,14 @@ ReceiveTarFile(PGconn *conn, PGresult *res, int rownum)
 			disconnect_and_exit(1);
 		}
 
-		if (!writerecoveryconf || !basetablespace)
+		if (!writerecoveryconf || !basetablespace || server_compresslevel > 0)
 		{
 			/*
 			 * When not writing recovery.conf, or when not working on the base
 			 * tablespace, we never have to look for an existing recovery.conf
-			 * file in the stream.
+			 * file in the stream.  We can't look into a stream compressed by
+			 * the server; ours is appended after any recovery.conf in it, so
+			 * it's the one that ends up being extracted.
 			 */
 			WRITE_TAR_DATA(copybuf, r);
 		}
@@ -1132,6 +1195,90 @@ update_tablespace_symlink(Oid oid, const char *old_dir)
 }
 
 
+/*
+ * Compare the manifest sent by the server with the sizes and checksums of
+ * the files we actually unpacked.  Both list the files in the order they
+ * were sent, so a plain comparison of the lines is enough.
+ */
+static void
+VerifyManifest(void)
+{
+	char		filename[MAXPGPATH];
+	FILE	   *mf;
+	PQExpBuffer expected = createPQExpBuffer();
+	char		buf[1024];
+	char	   *e;
+	char	   *r;
+	int			lineno = 1;
+
+	snprintf(filename, sizeof(filename), "%s/%s", basedir,
+			 BACKUP_MANIFEST_FILE);
+	mf = fopen(filename, "r");
+	if (mf == NULL)
+	{
+		fprintf(stderr, _("%s: could not open file \"%s\": %s\n"),
+				progname, filename, strerror(errno));
+		exit(1);
+	}
+	while (fgets(buf, sizeof(buf), mf) != NULL)
+	{
+		/* skip the header comment */
+		if (buf[0] == '#')
+			continue;
+		appendPQExpBufferStr(expected, buf);
+	}
+	if (ferror(mf))
+	{
+		fprintf(stderr, _("%s: could not read file \"%s\": %s\n"),
+				progname, filename, strerror(errno));
+		exit(1);
+	}
+	fclose(mf);
+
+	/* Find the first line that differs, if any */
+	e = expected->data;
+	r = received_manifest->data;
+	while (*e != '\0' || *r != '\0')
+	{
+		char	   *eend = strchr(e, '\n');
+		char	   *rend = strchr(r, '\n');
+		size_t		elen = eend ? eend - e : strlen(e);
+		size_t		rlen = rend ? rend - r : strlen(r);
+
+		if (elen != rlen || strncmp(e, r, elen) != 0)
+		{
+			fprintf(stderr,
+					_("%s: backup does not match manifest at line %d\n"
+					  "%s: expected: %.*s\n"
+					  "%s: received: %.*s\n"),
+					progname, lineno,
+					progname, (int) elen, e,
+					progname, (int) rlen, r);
+			exit(1);
+		}
+		e += elen + (eend ? 1 : 0);
+		r += rlen + (rend ? 1 : 0);
+		lineno++;
+	}
+
+	destroyPQExpBuffer(expected);
+
+	if (verbose)
+		fprintf(stderr, _("%s: backup matches manifest (%d files)\n"),
+				progname, lineno - 1);
+}
+
+/*
+ * Finish the entry for the file just unpacked in received_manifest; its name
+ * was added when it was opened.  The manifest itself isn't listed.
+ */
+#define RECORD_RECEIVED_FILE() \
+	do { \
+		if (current_listed) \
+			appendPQExpBuffer(received_manifest, INT64_FORMAT "\t%08X\n", \
+							  (int64) current_size, current_crc); \
+	} while (0)
+
 /*
  * Receive a tar format stream from the connection to the server, and unpack
  * the contents of it into a directory. Only files, directories and
@@ -1146,17 +1293,28 @@ ReceiveAndUnpackTarFile(PGconn *conn, PGresult *res, int rownum)
 {
 	char		current_path[MAXPGPATH];
 	char		filename[MAXPGPATH];
-	int			current_len_left;
+	uint64		current_len_left;
 	int			current_padding = 0;
 	bool		basetablespace = PQgetisnull(res, rownum, 0);
 	char	   *copybuf = NULL;
 	FILE	   *file = NULL;
+	char		manifest_name[MAXPGPATH];
+	bool		current_listed = false;
+	uint64		current_size = 0;
+	pg_crc32	current_crc = 0;
 
 	if (basetablespace)
 		strlcpy(current_path, basedir, sizeof(current_path));
 	else
 		strlcpy(current_path, get_tablespace_mapping(PQgetvalue(res, rownum, 1)), sizeof(current_path));
 
+	/* Files in tablespaces are listed in the manifest via pg_tblspc */
+	if (basetablespace)
+		manifest_name[0] = '\0';
+	else
+		snprintf(manifest_name, sizeof(manifest_name), "pg_tblspc/%s/",
+				 PQgetvalue(res, rownum, 0));
+
 	/*
 	 * Get the COPY data
 	 */
@@ -1212,12 +1370,14 @@ ReceiveAndUnpackTarFile(PGconn *conn, PGresult *res, int rownum)
 			}
 			totaldone += 512;
 
-			if (sscanf(copybuf + 124, "%11o", &current_len_left) != 1)
+			/* the size may need more than 31 bits */
+			if (copybuf[124] < '0' || copybuf[124] > '7')
 			{
 				fprintf(stderr, _("%s: could not parse file size\n"),
 						progname);
 				disconnect_and_exit(1);
 			}
+			current_len_left = read_tar_number(&copybuf[124], 11);
 
 			/* Set permissions on the file */
 			if (sscanf(&copybuf[100], "%07o ", &filemode) != 1)
@@ -1302,6 +1462,15 @@ ReceiveAndUnpackTarFile(PGconn *conn, PGresult *res, int rownum)
 			/*
 			 * regular file
 			 */
+			current_listed = (received_manifest != NULL &&
+							  !(basetablespace &&
+								strcmp(copybuf, BACKUP_MANIFEST_FILE) == 0));
+			if (current_listed)
+				appendPQExpBuffer(received_manifest, "%s%s\t",
+								  manifest_name, copybuf);
+			current_size = current_len_left;
+			INIT_CRC32(current_crc);
+
 			file = fopen(filename, "wb");
 			if (!file)
 			{
@@ -1323,6 +1492,8 @@ ReceiveAndUnpackTarFile(PGconn *conn, PGresult *res, int rownum)
 				 */
 				fclose(file);
 				file = NULL;
+				FIN_CRC32(current_crc);
+				RECORD_RECEIVED_FILE();
 				continue;
 			}
 		}						/* new file */
@@ -1340,6 +1511,8 @@ ReceiveAndUnpackTarFile(PGconn *conn, PGresult *res, int rownum)
 				fclose(file);
 				file = NULL;
 				totaldone += r;
+				FIN_CRC32(current_crc);
+				RECORD_RECEIVED_FILE();
 				continue;
 			}
 
@@ -1349,6 +1522,8 @@ ReceiveAndUnpackTarFile(PGconn *conn, PGresult *res, int rownum)
 						progname, filename, strerror(errno));
 				disconnect_and_exit(1);
 			}
+			if (received_manifest != NULL)
+				COMP_CRC32(current_crc, copybuf, r);
 			totaldone += r;
 			progress_report(rownum, filename, false);
 
@@ -1362,6 +1537,8 @@ ReceiveAndUnpackTarFile(PGconn *conn, PGresult *res, int rownum)
 				 */
 				fclose(file);
 				file = NULL;
+				FIN_CRC32(current_crc);
+				RECORD_RECEIVED_FILE();
 				continue;
 			}
 		}						/* continuing data in existing file */
@@ -1582,6 +1759,8 @@ BaseBackup(void)
 	char	   *basebkp;
 	char		escaped_label[MAXPGPATH];
 	char	   *maxrate_clause = NULL;
+	char	   *incremental_clause = NULL;
+	char	   *compress_clause = NULL;
 	int			i;
 	char		xlogstart[64];
 	char		xlogend[64];
@@ -1658,14 +1837,23 @@ BaseBackup(void)
 	if (maxrate > 0)
 		maxrate_clause = psprintf("MAX_RATE %u", maxrate);
 
+	if (incremental)
+		incremental_clause = psprintf("INCREMENTAL %s", incremental);
+
+	if (server_compresslevel > 0)
+		compress_clause = psprintf("COMPRESS %d", server_compresslevel);
+
 	basebkp =
-		psprintf("BASE_BACKUP LABEL '%s' %s %s %s %s %s",
+		psprintf("BASE_BACKUP LABEL '%s' %s %s %s %s %s %s %s %s",
 				 escaped_label,
 				 showprogress ? "PROGRESS" : "",
 				 includewal && !streamwal ? "WAL" : "",
 				 fastcheckpoint ? "FAST" : "",
 				 includewal ? "NOWAIT" : "",
-				 maxrate_clause ? maxrate_clause : "");
+				 maxrate_clause ? maxrate_clause : "",
+				 incremental_clause ? incremental_clause : "",
+				 compress_clause ? compress_clause : "",
+				 request_manifest ? "MANIFEST" : "");
 
 	if (PQsendQuery(conn, basebkp) == 0)
 	{
@@ -1770,6 +1958,13 @@ BaseBackup(void)
 		StartLogStreamer(xlogstart, starttli, sysidentifier);
 	}
 
+	/*
+	 * In plain mode, remember what we unpack so it can be checked against
+	 * the manifest at the end.  Tar files are left for the user to verify.
+	 */
+	if (request_manifest && format == 'p')
+		received_manifest = createPQExpBuffer();
+
 	/*
 	 * Start receiving chunks
 	 */
@@ -1933,6 +2128,9 @@ BaseBackup(void)
 	PQclear(res);
 	PQfinish(conn);
 
+	if (received_manifest != NULL)
+		VerifyManifest();
+
 	if (verbose)
 		fprintf(stderr, "%s: base backup completed\n", progname);
 }
@@ -1965,6 +2163,9 @@ main(int argc, char **argv)
 		{"verbose", no_argument, NULL, 'v'},
 		{"progress", no_argument, NULL, 'P'},
 		{"xlogdir", required_argument, NULL, 1},
+		{"incremental", required_argument, NULL, 2},
+		{"server-compress", required_argument, NULL, 3},
+		{"manifest", no_argument, NULL, 4},
 		{NULL, 0, NULL, 0}
 	};
 	int			c;
@@ -2058,6 +2259,33 @@ main(int argc, char **argv)
 			case 1:
 				xlog_dir = pg_strdup(optarg);
 				break;
+			case 2:
+				{
+					uint32		hi,
+								lo;
+
+					if (sscanf(optarg, "%X/%X", &hi, &lo) != 2)
+					{
+						fprintf(stderr,
+								_("%s: invalid incremental backup location \"%s\"\n"),
+								progname, optarg);
+						exit(1);
+					}
+					incremental = psprintf("%X/%X", hi, lo);
+				}
+				break;
+			case 3:
+				server_compresslevel = atoi(optarg);
+				if (server_compresslevel <= 0 || server_compresslevel > 9)
+				{
+					fprintf(stderr, _("%s: invalid compression level \"%s\"\n"),
+							progname, optarg);
+					exit(1);
+				}
+				break;
+			case 4:
+				request_manifest = true;
+				break;
 			case 'l':
 				label = pg_strdup(optarg);
 				break;
@@ -2170,6 +2398,26 @@ main(int argc, char **argv)
 		exit(1);
 	}
 
+	if (format == 'p' && server_compresslevel != 0)
+	{
+		fprintf(stderr,
+				_("%s: only tar mode backups can be compressed\n"),
+				progname);
+		fprintf(stderr, _("Try \"%s --help\" for more information.\n"),
+				progname);
+		exit(1);
+	}
+
+	if (compresslevel != 0 && server_compresslevel != 0)
+	{
+		fprintf(stderr,
+				_("%s: cannot use both client and server compression\n"),
+				progname);
+		fprintf(stderr, _("Try \"%s --help\" for more information.\n"),
+				progname);
+		exit(1);
+	}
+
 	if (format != 'p' && streamwal)
 	{
 		fprintf(stderr,
@@ -2205,7 +2453,7 @@ main(int argc, char **argv)
 	}
 
 #ifndef HAVE_LIBZ
-	if (compresslevel != 0)
+	if (compresslevel != 0 || server_compresslevel != 0)
 	{
 		fprintf(stderr,
 				_("%s: this build does not support compression\n"),
@@ -0,0 +1,604 @@
+/*-------------------------------------------------------------------------
+ *
+ * pg_combinebackup.c - combine a base backup with an incremental backup
+ *						taken on top of it into a complete data directory.
+ *
+ * Portions Copyright (c) 1996-2014, PostgreSQL Global Development Group
+ *
+ * IDENTIFICATION
+ *		  src/bin/pg_basebackup/pg_combinebackup.c
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres_fe.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "getopt_long.h"
+#include "replication/basebackup.h"
+#include "storage/block.h"
+
+static const char *progname;
+static bool verbose = false;
+
+/* Directories of the prior backup, the incremental backup and the output */
+static char *prior_dir = NULL;
+static char *incr_dir = NULL;
+static char *output_dir = NULL;
+
+/* Start location of the prior backup, from its backup_label */
+static XLogRecPtr prior_start;
+
+static void usage(void);
+static XLogRecPtr read_backup_start(const char *dir);
+static void check_no_tablespaces(const char *dir);
+static void combine_dir(const char *relpath);
+static void copy_file(const char *src, const char *dst);
+static void reconstruct_file(const char *relpath);
+static void read_fully(int fd, char *buf, size_t len, const char *path);
+static void write_fully(int fd, const char *buf, size_t len, const char *path);
+
+
+static void
+usage(void)
+{
+	printf(_("%s reconstructs a data directory from a base backup and an incremental\n"
+			 "backup taken with pg_basebackup --incremental.\n\n"),
+		   progname);
+	printf(_("Usage:\n"));
+	printf(_("  %s [OPTION]... PRIORDIR INCREMENTALDIR\n"), progname);
+	printf(_("\nOptions:\n"));
+	printf(_("  -o, --output=DIRECTORY write the combined backup into directory\n"));
+	printf(_("  -v, --verbose          output verbose messages\n"));
+	printf(_("  -V, --version          output version information, then exit\n"));
+	printf(_("  -?, --help             show this help, then exit\n"));
+	printf(_("\nReport bugs to <pgsql-bugs@postgresql.org>.\n"));
+}
+
+/*
+ * Return the START WAL LOCATION recorded in the backup_label of a plain
+ * format base backup.
+ */
+static XLogRecPtr
+read_backup_start(const char *dir)
+{
+	char		path[MAXPGPATH];
+	char		line[MAXPGPATH];
+	FILE	   *fp;
+	uint32		hi,
+				lo;
+	bool		found = false;
+
+	snprintf(path, sizeof(path), "%s/backup_label", dir);
+	fp = fopen(path, "r");
+	if (fp == NULL)
+	{
+		fprintf(stderr, _("%s: could not open file \"%s\": %s\n"),
+				progname, path, strerror(errno));
+		exit(1);
+	}
+	while (fgets(line, sizeof(line), fp) != NULL)
+	{
+		if (sscanf(line, "START WAL LOCATION: %X/%X", &hi, &lo) == 2)
+		{
+			found = true;
+			break;
+		}
+	}
+	fclose(fp);
+
+	if (!found)
+	{
+		fprintf(stderr, _("%s: invalid data in file \"%s\"\n"),
+				progname, path);
+		exit(1);
+	}
+
+	return ((uint64) hi) << 32 | lo;
+}
+
+/*
+ * Tablespaces outside the data directory are restored by pg_basebackup to
+ * their own locations, which we have no way of pairing up; refuse them.
+ */
+static void
+check_no_tablespaces(const char *dir)
+{
+	char		path[MAXPGPATH];
+	DIR		   *d;
+	struct dirent *de;
+
+	snprintf(path, sizeof(path), "%s/pg_tblspc", dir);
+	d = opendir(path);
+	if (d == NULL)
+		return;
+	while ((de = readdir(d)) != NULL)
+	{
+		if (strcmp(de->d_name, ".") == 0 || strcmp(de->d_name, "..") == 0)
+			continue;
+		fprintf(stderr, _("%s: backup \"%s\" contains tablespaces, which are not supported\n"),
+				progname, dir);
+		exit(1);
+	}
+	closedir(d);
+}
+
+/*
+ * Recreate one directory of the incremental backup in the output.
+ *
+ * The incremental backup has an entry for every file that existed when it
+ * was taken, so its file list is the one to follow; files that exist only
+ * in the prior backup belonged to relations dropped in between.
+ */
+static void
+combine_dir(const char *relpath)
+{
+	char		incrpath[MAXPGPATH];
+	char		outpath[MAXPGPATH];
+	char		childrel[MAXPGPATH];
+	DIR		   *d;
+	struct dirent *de;
+	struct stat st;
+
+	snprintf(incrpath, sizeof(incrpath), "%s/%s", incr_dir, relpath);
+
+	d = opendir(incrpath);
+	if (d == NULL)
+	{
+		fprintf(stderr, _("%s: could not open directory \"%s\": %s\n"),
+				progname, incrpath, strerror(errno));
+		exit(1);
+	}
+
+	while ((de = readdir(d)) != NULL)
+	{
+		size_t		namelen = strlen(de->d_name);
+		size_t		suffixlen = strlen(INCREMENTAL_FILE_SUFFIX);
+
+		if (strcmp(de->d_name, ".") == 0 || strcmp(de->d_name, "..") == 0)
+			continue;
+
+		/* The manifest describes the incremental backup, not the result */
+		if (relpath[0] == '\0' && strcmp(de->d_name, BACKUP_MANIFEST_FILE) == 0)
+			continue;
+
+		if (relpath[0] == '\0')
+			strlcpy(childrel, de->d_name, sizeof(childrel));
+		else if (snprintf(childrel, sizeof(childrel), "%s/%s",
+						  relpath, de->d_name) >= (int) sizeof(childrel))
+		{
+			fprintf(stderr, _("%s: path too long: \"%s/%s\"\n"),
+					progname, relpath, de->d_name);
+			exit(1);
+		}
+		if (snprintf(incrpath, sizeof(incrpath), "%s/%s",
+					 incr_dir, childrel) >= (int) sizeof(incrpath) ||
+			snprintf(outpath, sizeof(outpath), "%s/%s",
+					 output_dir, childrel) >= (int) sizeof(outpath))
+		{
+			fprintf(stderr, _("%s: path too long: \"%s\"\n"),
+					progname, childrel);
+			exit(1);
+		}
+
+		if (lstat(incrpath, &st) != 0)
+		{
+			fprintf(stderr, _("%s: could not stat file \"%s\": %s\n"),
+					progname, incrpath, strerror(errno));
+			exit(1);
+		}
+
+		if (S_ISDIR(st.st_mode))
+		{
+			if (mkdir(outpath, S_IRWXU) != 0)
+			{
+				fprintf(stderr, _("%s: could not create directory \"%s\": %s\n"),
+						progname, outpath, strerror(errno));
+				exit(1);
+			}
+			combine_dir(childrel);
+		}
+#ifndef WIN32
+		else if (S_ISLNK(st.st_mode))
+		{
+			/* pg_xlog, if the backup was taken with --xlogdir */
+			char		target[MAXPGPATH];
+			int			rllen;
+
+			rllen = readlink(incrpath, target, sizeof(target));
+			if (rllen < 0 || rllen >= sizeof(target))
+			{
+				fprintf(stderr, _("%s: could not read symbolic link \"%s\"\n"),
+						progname, incrpath);
+				exit(1);
+			}
+			target[rllen] = '\0';
+			if (symlink(target, outpath) != 0)
+			{
+				fprintf(stderr, _("%s: could not create symbolic link \"%s\": %s\n"),
+						progname, outpath, strerror(errno));
+				exit(1);
+			}
+		}
+#endif
+		else if (namelen > suffixlen &&
+				 strcmp(de->d_name + namelen - suffixlen,
+						INCREMENTAL_FILE_SUFFIX) == 0)
+		{
+			childrel[strlen(childrel) - suffixlen] = '\0';
+			reconstruct_file(childrel);
+		}
+		else
+			copy_file(incrpath, outpath);
+	}
+
+	closedir(d);
+}
+
+/*
+ * Copy a file sent in full by the incremental backup.
+ */
+static void
+copy_file(const char *src, const char *dst)
+{
+	char		buf[65536];
+	int			srcfd;
+	int			dstfd;
+	int			rc;
+
+	srcfd = open(src, O_RDONLY | PG_BINARY, 0);
+	if (srcfd < 0)
+	{
+		fprintf(stderr, _("%s: could not open file \"%s\": %s\n"),
+				progname, src, strerror(errno));
+		exit(1);
+	}
+	dstfd = open(dst, O_WRONLY | O_CREAT | O_EXCL | PG_BINARY,
+				 S_IRUSR | S_IWUSR);
+	if (dstfd < 0)
+	{
+		fprintf(stderr, _("%s: could not create file \"%s\": %s\n"),
+				progname, dst, strerror(errno));
+		exit(1);
+	}
+
+	while ((rc = read(srcfd, buf, sizeof(buf))) > 0)
+		write_fully(dstfd, buf, rc, dst);
+	if (rc < 0)
+	{
+		fprintf(stderr, _("%s: could not read file \"%s\": %s\n"),
+				progname, src, strerror(errno));
+		exit(1);
+	}
+
+	close(srcfd);
+	if (close(dstfd) != 0)
+	{
+		fprintf(stderr, _("%s: could not close file \"%s\": %s\n"),
+				progname, dst, strerror(errno));
+		exit(1);
+	}
+}
+
+/*
+ * Rebuild a relation segment from its incremental file and the prior
+ * backup's copy of the segment.
+ */
+static void
+reconstruct_file(const char *relpath)
+{
+	char		incrpath[MAXPGPATH];
+	char		priorpath[MAXPGPATH];
+	char		outpath[MAXPGPATH];
+	char		page[BLCKSZ];
+	IncrementalFileHeader hdr;
+	BlockNumber *changed;
+	BlockNumber prior_nblocks = 0;
+	BlockNumber blkno;
+	XLogRecPtr	fromlsn;
+	uint32		i;
+	int			incrfd;
+	int			priorfd;
+	int			outfd;
+	struct stat st;
+
+	snprintf(incrpath, sizeof(incrpath), "%s/%s%s",
+			 incr_dir, relpath, INCREMENTAL_FILE_SUFFIX);
+	snprintf(priorpath, sizeof(priorpath), "%s/%s", prior_dir, relpath);
+	snprintf(outpath, sizeof(outpath), "%s/%s", output_dir, relpath);
+
+	incrfd = open(incrpath, O_RDONLY | PG_BINARY, 0);
+	if (incrfd < 0)
+	{
+		fprintf(stderr, _("%s: could not open file \"%s\": %s\n"),
+				progname, incrpath, strerror(errno));
+		exit(1);
+	}
+
+	read_fully(incrfd, (char *) &hdr, sizeof(hdr), incrpath);
+	if (hdr.magic != INCREMENTAL_MAGIC || hdr.nchanged > hdr.nblocks)
+	{
+		fprintf(stderr, _("%s: file \"%s\" is not a valid incremental file\n"),
+				progname, incrpath);
+		exit(1);
+	}
+
+	/*
+	 * Blocks changed after fromlsn were sent.  The prior backup must have
+	 * started no later than that, or the blocks changed in between would not
+	 * be correct in either backup.
+	 */
+	fromlsn = ((uint64) hdr.fromlsn_hi) << 32 | hdr.fromlsn_lo;
+	if (fromlsn > prior_start)
+	{
+		fprintf(stderr, _("%s: incremental backup is based on location %X/%X, but the prior backup started at %X/%X\n"),
+				progname, hdr.fromlsn_hi, hdr.fromlsn_lo,
+				(uint32) (prior_start >> 32), (uint32) prior_start);
+		exit(1);
+	}
+
+	changed = (BlockNumber *) pg_malloc(sizeof(BlockNumber) *
+										Max(hdr.nchanged, 1));
+	read_fully(incrfd, (char *) changed, sizeof(BlockNumber) * hdr.nchanged,
+			   incrpath);
+	for (i = 0; i < hdr.nchanged; i++)
+	{
+		if (changed[i] >= hdr.nblocks || (i > 0 && changed[i] <= changed[i - 1]))
+		{
+			fprintf(stderr, _("%s: file \"%s\" is not a valid incremental file\n"),
+					progname, incrpath);
+			exit(1);
+		}
+	}
+
+	priorfd = open(priorpath, O_RDONLY | PG_BINARY, 0);
+	if (priorfd >= 0)
+	{
+		if (fstat(priorfd, &st) != 0)
+		{
+			fprintf(stderr, _("%s: could not stat file \"%s\": %s\n"),
+					progname, priorpath, strerror(errno));
+			exit(1);
+		}
+		prior_nblocks = st.st_size / BLCKSZ;
+	}
+	else if (errno != ENOENT)
+	{
+		fprintf(stderr, _("%s: could not open file \"%s\": %s\n"),
+				progname, priorpath, strerror(errno));
+		exit(1);
+	}
+	else
+	{
+		/*
+		 * A segment created since the prior backup.  Make sure the prior
+		 * backup isn't an incremental one itself, though.
+		 */
+		snprintf(priorpath, sizeof(priorpath), "%s/%s%s",
+				 prior_dir, relpath, INCREMENTAL_FILE_SUFFIX);
+		if (stat(priorpath, &st) == 0)
+		{
+			fprintf(stderr, _("%s: prior backup \"%s\" is itself incremental; combine it first\n"),
+					progname, prior_dir);
+			exit(1);
+		}
+	}
+
+	outfd = open(outpath, O_WRONLY | O_CREAT | O_EXCL | PG_BINARY,
+				 S_IRUSR | S_IWUSR);
+	if (outfd < 0)
+	{
+		fprintf(stderr, _("%s: could not create file \"%s\": %s\n"),
+				progname, outpath, strerror(errno));
+		exit(1);
+	}
+
+	i = 0;
+	for (blkno = 0; blkno < hdr.nblocks; blkno++)
+	{
+		if (i < hdr.nchanged && changed[i] == blkno)
+		{
+			/* changed blocks are stored in order after the block numbers */
+			read_fully(incrfd, page, BLCKSZ, incrpath);
+			i++;
+		}
+		else if (blkno < prior_nblocks)
+		{
+			if (lseek(priorfd, (off_t) blkno * BLCKSZ, SEEK_SET) < 0)
+			{
+				fprintf(stderr, _("%s: could not seek in file \"%s\": %s\n"),
+						progname, priorpath, strerror(errno));
+				exit(1);
+			}
+			read_fully(priorfd, page, BLCKSZ, priorpath);
+		}
+		else
+		{
+			/*
+			 * The server only leaves out blocks the prior backup has a copy
+			 * of, so this isn't the backup the incremental one was based on,
+			 * or one of them is damaged.
+			 */
+			fprintf(stderr, _("%s: block %u of file \"%s\" is neither in the incremental nor in the prior backup\n"),
+					progname, blkno, relpath);
+			exit(1);
+		}
+
+		write_fully(outfd, page, BLCKSZ, outpath);
+	}
+
+	if (verbose)
+		fprintf(stderr, _("%s: reconstructed \"%s\" from %u of %u blocks\n"),
+				progname, relpath, hdr.nchanged, hdr.nblocks);
+
+	pg_free(changed);
+	close(incrfd);
+	if (priorfd >= 0)
+		close(priorfd);
+	if (close(outfd) != 0)
+	{
+		fprintf(stderr, _("%s: could not close file \"%s\": %s\n"),
+				progname, outpath, strerror(errno));
+		exit(1);
+	}
+}
+
+static void
+read_fully(int fd, char *buf, size_t len, const char *path)
+{
+	while (len > 0)
+	{
+		int			rc = read(fd, buf, len);
+
+		if (rc < 0)
+		{
+			fprintf(stderr, _("%s: could not read file \"%s\": %s\n"),
+					progname, path, strerror(errno));
+			exit(1);
+		}
+		if (rc == 0)
+		{
+			fprintf(stderr, _("%s: unexpected end of file \"%s\"\n"),
+					progname, path);
+			exit(1);
+		}
+		buf += rc;
+		len -= rc;
+	}
+}
+
+static void
+write_fully(int fd, const char *buf, size_t len, const char *path)
+{
+	while (len > 0)
+	{
+		int			rc = write(fd, buf, len);
+
+		if (rc < 0)
+		{
+			/* if write didn't set errno, assume problem is no disk space */
+			if (errno == 0)
+				errno = ENOSPC;
+			fprintf(stderr, _("%s: could not write file \"%s\": %s\n"),
+					progname, path, strerror(errno));
+			exit(1);
+		}
+		buf += rc;
+		len -= rc;
+	}
+}
+
+
+int
+main(int argc, char **argv)
+{
+	static struct option long_options[] = {
+		{"help", no_argument, NULL, '?'},
+		{"version", no_argument, NULL, 'V'},
+		{"output", required_argument, NULL, 'o'},
+		{"verbose", no_argument, NULL, 'v'},
+		{NULL, 0, NULL, 0}
+	};
+	int			c;
+	int			option_index;
+
+	progname = get_progname(argv[0]);
+	set_pglocale_pgservice(argv[0], PG_TEXTDOMAIN("pg_basebackup"));
+
+	if (argc > 1)
+	{
+		if (strcmp(argv[1], "--help") == 0 || strcmp(argv[1], "-?") == 0)
+		{
+			usage();
+			exit(0);
+		}
+		else if (strcmp(argv[1], "-V") == 0
+				 || strcmp(argv[1], "--version") == 0)
+		{
+			puts("pg_combinebackup (PostgreSQL) " PG_VERSION);
+			exit(0);
+		}
+	}
+
+	while ((c = getopt_long(argc, argv, "o:v",
+							long_options, &option_index)) != -1)
+	{
+		switch (c)
+		{
+			case 'o':
+				output_dir = pg_strdup(optarg);
+				break;
+			case 'v':
+				verbose = true;
+				break;
+			default:
+
+				/*
+				 * getopt_long already emitted a complaint
+				 */
+				fprintf(stderr, _("Try \"%s --help\" for more information.\n"),
+						progname);
+				exit(1);
+		}
+	}
+
+	if (argc - optind != 2)
+	{
+		fprintf(stderr,
+				_("%s: expected a prior and an incremental backup directory\n"),
+				progname);
+		fprintf(stderr, _("Try \"%s --help\" for more information.\n"),
+				progname);
+		exit(1);
+	}
+	prior_dir = argv[optind];
+	incr_dir = argv[optind + 1];
+
+	if (output_dir == NULL)
+	{
+		fprintf(stderr, _("%s: no output directory specified\n"), progname);
+		fprintf(stderr, _("Try \"%s --help\" for more information.\n"),
+				progname);
+		exit(1);
+	}
+
+	prior_start = read_backup_start(prior_dir);
+	/* just to check that it is a base backup */
+	(void) read_backup_start(incr_dir);
+
+	check_no_tablespaces(prior_dir);
+	check_no_tablespaces(incr_dir);
+
+	switch (pg_check_dir(output_dir))
+	{
+		case 0:
+			if (pg_mkdir_p(output_dir, S_IRWXU) == -1)
+			{
+				fprintf(stderr, _("%s: could not create directory \"%s\": %s\n"),
+						progname, output_dir, strerror(errno));
+				exit(1);
+			}
+			break;
+		case 1:
+			break;
+		case -1:
+			fprintf(stderr, _("%s: could not access directory \"%s\": %s\n"),
+					progname, output_dir, strerror(errno));
+			exit(1);
+		default:
+			fprintf(stderr, _("%s: directory \"%s\" exists but is not empty\n"),
+					progname, output_dir);
+			exit(1);
+	}
+
+	combine_dir("");
+
+	if (verbose)
+		fprintf(stderr, _("%s: combined backup written to \"%s\"\n"),
+				progname, output_dir);
+
+	return 0;
+}
@@ -0,0 +1,170 @@
+#!/bin/sh
+
+# src/bin/pg_basebackup/test.sh
+#
+# Test driver for incremental base backups.  Initializes a new database
+# cluster, takes a full base backup, makes changes including ones that copy
+# files with their old page LSNs, takes an incremental backup, combines the
+# two with pg_combinebackup, starts a server on the result and compares a
+# pg_dumpall of it with one of the original cluster.
+#
+# Portions Copyright (c) 1996-2014, PostgreSQL Global Development Group
+# Portions Copyright (c) 1994, Regents of the University of California
+
+set -e
+
+: ${MAKE=make}
+
+# Guard against parallel make issues (see comments in pg_regress.c)
+unset MAKEFLAGS
+unset MAKELEVEL
+
+# Set listen_addresses desirably
+testhost=`uname -s`
+
+case $testhost in
+	MINGW*)	LISTEN_ADDRESSES="localhost" ;;
+	*)		LISTEN_ADDRESSES="" ;;
+esac
+
+POSTMASTER_OPTS="-F -c listen_addresses=$LISTEN_ADDRESSES"
+
+temp_root=$PWD/tmp_check
+
+if [ "$1" = '--install' ]; then
+	temp_install=$temp_root/install
+	bindir=$temp_install/$bindir
+	libdir=$temp_install/$libdir
+
+	"$MAKE" -s -C ../../.. install DESTDIR="$temp_install"
+
+	# platform-specific magic to find the shared libraries; see pg_regress.c
+	LD_LIBRARY_PATH=$libdir:$LD_LIBRARY_PATH
+	export LD_LIBRARY_PATH
+	DYLD_LIBRARY_PATH=$libdir:$DYLD_LIBRARY_PATH
+	export DYLD_LIBRARY_PATH
+	LIBPATH=$libdir:$LIBPATH
+	export LIBPATH
+	PATH=$libdir:$PATH
+fi
+
+PATH=$bindir:$PATH
+export PATH
+
+PGDATA=$temp_root/data
+export PGDATA
+backup_full=$temp_root/backup_full
+backup_incr=$temp_root/backup_incr
+backup_combined=$temp_root/backup_combined
+rm -rf "$PGDATA" "$backup_full" "$backup_incr" "$backup_combined"
+
+logdir=$PWD/log
+rm -rf "$logdir"
+mkdir "$logdir"
+
+# Clear out any environment vars that might cause libpq to connect to
+# the wrong postmaster (cf pg_regress.c)
+#
+# Some shells, such as NetBSD's, return non-zero from unset if the variable
+# is already unset. Since we are operating under 'set -e', this causes the
+# script to fail. To guard against this, set them all to an empty string first.
+PGDATABASE="";        unset PGDATABASE
+PGUSER="";            unset PGUSER
+PGSERVICE="";         unset PGSERVICE
+PGSSLMODE="";         unset PGSSLMODE
+PGREQUIRESSL="";      unset PGREQUIRESSL
+PGCONNECT_TIMEOUT=""; unset PGCONNECT_TIMEOUT
+PGHOST="";            unset PGHOST
+PGHOSTADDR="";        unset PGHOSTADDR
+
+# Select a non-conflicting port number, similarly to pg_regress.c
+PG_VERSION_NUM=`grep '#define PG_VERSION_NUM' ../../../src/include/pg_config.h | awk '{print $3}'`
+PGPORT=`expr $PG_VERSION_NUM % 16384 + 49152`
+export PGPORT
+
+i=0
+while psql -X postgres </dev/null 2>/dev/null
+do
+	i=`expr $i + 1`
+	if [ $i -eq 16 ]
+	then
+		echo port $PGPORT apparently in use
+		exit 1
+	fi
+	PGPORT=`expr $PGPORT + 1`
+	export PGPORT
+done
+
+# enable echo so the user can see what is being executed
+set -x
+
+initdb -N
+cat >>"$PGDATA/postgresql.conf" <<EOF
+wal_level = archive
+max_wal_senders = 2
+wal_keep_segments = 32
+EOF
+echo "local replication all trust" >>"$PGDATA/pg_hba.conf"
+
+pg_ctl start -l "$logdir/postmaster1.log" -o "$POSTMASTER_OPTS" -w
+
+psql -X -q -v ON_ERROR_STOP=1 -d postgres <<EOF
+CREATE DATABASE src;
+\c src
+CREATE TABLE t (id int PRIMARY KEY, data text);
+INSERT INTO t SELECT g, 'row ' || g FROM generate_series(1, 10000) g;
+CREATE INDEX t_hash ON t USING hash (id);
+-- unlogged tables come back empty, so only check that restoring works
+CREATE UNLOGGED TABLE u (id int PRIMARY KEY);
+CHECKPOINT;
+EOF
+
+pg_basebackup -D "$backup_full" -X fetch
+
+prior_start=`sed -n 's/^START WAL LOCATION: \([0-9A-F]*\/[0-9A-F]*\).*/\1/p' "$backup_full/backup_label"`
+
+# Change some blocks, and copy whole databases, which keeps the page LSNs
+# of the originals
+psql -X -q -v ON_ERROR_STOP=1 -d src <<EOF
+UPDATE t SET data = 'updated ' || id WHERE id % 100 = 0;
+DELETE FROM t WHERE id > 9000;
+INSERT INTO t SELECT g, 'new ' || g FROM generate_series(20001, 21000) g;
+CREATE TABLE t2 AS SELECT * FROM t WHERE id < 500;
+EOF
+psql -X -q -v ON_ERROR_STOP=1 -d postgres <<EOF
+CREATE DATABASE copied TEMPLATE src;
+EOF
+
+pg_basebackup -D "$backup_incr" -X fetch --incremental="$prior_start"
+
+pg_combinebackup -o "$backup_combined" "$backup_full" "$backup_incr"
+
+pg_dumpall -f "$temp_root"/dump1.sql || pg_dumpall1_status=$?
+pg_ctl -m fast stop
+if [ -n "$pg_dumpall1_status" ]; then
+	echo "pg_dumpall of the original cluster failed"
+	exit 1
+fi
+
+PGDATA=$backup_combined
+chmod 700 "$PGDATA"
+pg_ctl start -l "$logdir/postmaster2.log" -o "$POSTMASTER_OPTS" -w
+pg_dumpall -f "$temp_root"/dump2.sql || pg_dumpall2_status=$?
+pg_ctl -m fast stop
+
+# no need to echo commands anymore
+set +x
+echo
+
+if [ -n "$pg_dumpall2_status" ]; then
+	echo "pg_dumpall of the combined backup failed"
+	exit 1
+fi
+
+if diff -q "$temp_root"/dump1.sql "$temp_root"/dump2.sql; then
+	echo PASSED
+	exit 0
+else
+	echo "dumps were not identical"
+	exit 1
+fi
@@ -816,7 +816,7 @@ lockTableNoWait(ArchiveHandle *AH, TocEntry *te)
 					  "       pg_class.relname "
 					  "  FROM pg_class "
 					"  JOIN pg_namespace on pg_namespace.oid = relnamespace "
-					  " WHERE pg_class.oid = %d", te->catalogId.oid);
+					  " WHERE pg_class.oid = %u", te->catalogId.oid);
 
 	res = PQexec(AH->connection, query->data);
 
@@ -825,6 +825,11 @@ lockTableNoWait(ArchiveHandle *AH, TocEntry *te)
 					  "could not get relation name for OID %u: %s\n",
 					  te->catalogId.oid, PQerrorMessage(AH->connection));
 
+	if (PQntuples(res) != 1)
+		exit_horribly(modulename,
+					  "could not find relation with OID %u to lock for TOC entry %d (%s %s)\n",
+					  te->catalogId.oid, te->dumpId, te->desc, te->tag);
+
 	resetPQExpBuffer(query);
 
 	qualId = fmtQualifiedId(AHX->remoteVersion,
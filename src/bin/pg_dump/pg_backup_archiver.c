@@ -1657,8 +1657,15 @@ buildTocEntryArrays(ArchiveHandle *AH)
 		/*
 		 * tableDataId provides the TABLE DATA item's dump ID for each TABLE
 		 * TOC entry that has a DATA item.	We compute this by reversing the
-		 * TABLE DATA item's dependency, knowing that a TABLE DATA item has
-		 * just one dependency and it is the TABLE item.
+		 * TABLE DATA item's dependency, knowing that a TABLE DATA item's
+		 * first dependency is the TABLE item.
+		 *
+		 * If pg_dump split the table's data into chunks, there are several
+		 * TABLE DATA items for the table.  The one we want is the item
+		 * without a data component, which depends on all the chunks; that
+		 * way post-data items wait for every chunk, and the chunks are never
+		 * candidates for truncation in restore_toc_entry, which would lose
+		 * the rows loaded by other chunks.
 		 */
 		if (strcmp(te->desc, "TABLE DATA") == 0 && te->nDeps > 0)
 		{
@@ -1672,7 +1679,8 @@ buildTocEntryArrays(ArchiveHandle *AH)
 			if (tableId <= 0 || tableId > maxDumpId)
 				exit_horribly(modulename, "bad table dumpId for TABLE DATA item\n");
 
-			AH->tableDataId[tableId] = te->dumpId;
+			if (AH->tableDataId[tableId] == 0 || !te->hadDumper)
+				AH->tableDataId[tableId] = te->dumpId;
 		}
 	}
 }
@@ -4218,6 +4226,17 @@ inhibit_data_for_failed_table(ArchiveHandle *AH, TocEntry *te)
 		TocEntry   *ted = AH->tocsByDumpId[AH->tableDataId[te->dumpId]];
 
 		ted->reqs = 0;
+
+		/* If the data was split into chunks, skip those too */
+		if (!ted->hadDumper)
+		{
+			for (ted = AH->toc->next; ted != AH->toc; ted = ted->next)
+			{
+				if (strcmp(ted->desc, "TABLE DATA") == 0 &&
+					ted->nDeps > 0 && ted->dependencies[0] == te->dumpId)
+					ted->reqs = 0;
+			}
+		}
 	}
 }
 
@@ -91,6 +91,7 @@ static bool	dataOnly;
 static int	dumpSections;		/* bitmask of chosen sections */
 static bool	aclsSkip;
 static const char *lockWaitTimeout;
+static int	splitTableSize;		/* split table data larger than this many MB */
 
 /* subquery used to convert user ID (eg, datdba) to user name */
 static const char *username_subquery;
@@ -151,6 +152,8 @@ static void expand_table_name_patterns(Archive *fout,
 						   SimpleOidList *oids);
 static NamespaceInfo *findNamespace(Archive *fout, Oid nsoid, Oid objoid);
 static void dumpTableData(Archive *fout, TableDataInfo *tdinfo);
+static bool dumpTableDataSplit(Archive *fout, TableDataInfo *tdinfo,
+				   const char *copyStmt, DataDumperPtr dumpFn);
 static void refreshMatViewData(Archive *fout, TableDataInfo *tdinfo);
 static void guessConstraintInheritance(TableInfo *tblinfo, int numTables);
 static void dumpComment(Archive *fout, const char *target,
@@ -354,6 +357,7 @@ main(int argc, char **argv)
 		{"role", required_argument, NULL, 3},
 		{"section", required_argument, NULL, 5},
 		{"serializable-deferrable", no_argument, &serializable_deferrable, 1},
+		{"split-table-size", required_argument, NULL, 6},
 		{"use-set-session-authorization", no_argument, &use_setsessauth, 1},
 		{"no-security-labels", no_argument, &no_security_labels, 1},
 		{"no-synchronized-snapshots", no_argument, &no_synchronized_snapshots, 1},
@@ -535,6 +539,15 @@ main(int argc, char **argv)
 				set_dump_section(optarg, &dumpSections);
 				break;
 
+			case 6:				/* split large tables' data */
+				splitTableSize = atoi(optarg);
+				if (splitTableSize <= 0)
+				{
+					write_msg(NULL, "invalid split table size \"%s\"\n", optarg);
+					exit_nicely(1);
+				}
+				break;
+
 			default:
 				fprintf(stderr, _("Try \"%s --help\" for more information.\n"), progname);
 				exit_nicely(1);
@@ -616,6 +629,10 @@ main(int argc, char **argv)
 	if (archiveFormat != archDirectory && numWorkers > 1)
 		exit_horribly(NULL, "parallel backup only supported by the directory format\n");
 
+	/* Split table data is only useful to pg_restore */
+	if (plainText && splitTableSize > 0)
+		exit_horribly(NULL, "option --split-table-size cannot be used with plain-text format\n");
+
 	/* Open the output file */
 	fout = CreateArchive(filename, archiveFormat, compressLevel, archiveMode,
 						 setupDumpWorker);
@@ -907,6 +924,7 @@ help(const char *progname)
 	printf(_("  --quote-all-identifiers      quote all identifiers, even if not key words\n"));
 	printf(_("  --section=SECTION            dump named section (pre-data, data, or post-data)\n"));
 	printf(_("  --serializable-deferrable    wait until the dump can run without anomalies\n"));
+	printf(_("  --split-table-size=MB        dump data of larger tables in key-range chunks\n"));
 	printf(_("  --use-set-session-authorization\n"
 			 "                               use SET SESSION AUTHORIZATION commands instead of\n"
 			 "                               ALTER OWNER commands to set ownership\n"));
@@ -1441,7 +1459,8 @@ dumpTableData_copy(Archive *fout, void *dcontext)
 		}
 		else
 			appendPQExpBufferStr(q, "* ");
-		appendPQExpBuffer(q, "FROM %s %s) TO stdout;",
+		/* ONLY, to match what a plain COPY of the table would return */
+		appendPQExpBuffer(q, "FROM ONLY %s %s) TO stdout;",
 						  fmtQualifiedId(fout->remoteVersion,
 										 tbinfo->dobj.namespace->dobj.name,
 										 classname),
@@ -1766,6 +1785,13 @@ dumpTableData(Archive *fout, TableDataInfo *tdinfo)
 		copyStmt = NULL;
 	}
 
+	if (dumpTableDataSplit(fout, tdinfo, copyStmt, dumpFn))
+	{
+		destroyPQExpBuffer(copyBuf);
+		destroyPQExpBuffer(clistBuf);
+		return;
+	}
+
 	/*
 	 * Note: although the TableDataInfo is a full DumpableObject, we treat its
 	 * dependency on its table as "special" and pass it to ArchiveEntry now.
@@ -1783,6 +1809,159 @@ dumpTableData(Archive *fout, TableDataInfo *tdinfo)
 	destroyPQExpBuffer(clistBuf);
 }
 
+/*
+ * dumpTableDataSplit -
+ *	  dump the contents of a large table as several key-range chunks
+ *
+ * If --split-table-size was given and the table is bigger than that, and it
+ * has a single-column integer primary key, we divide the key's range into
+ * equal-width intervals and make a separate TABLE DATA entry for each one.
+ * Each chunk can then be dumped by a different worker under the synchronized
+ * snapshot, stored as its own file by the directory format, and loaded
+ * concurrently by pg_restore --jobs.  Block ranges would avoid the need for
+ * a suitable key, but the server cannot fetch a range of blocks without
+ * scanning the whole table.
+ *
+ * The table's own TABLE DATA entry is still made, with no data, and depends
+ * on all the chunks; anything that waits for the table's data therefore
+ * waits for every chunk.  pg_restore relies on that entry having no data
+ * component to tell it apart from the chunks.
+ *
+ * Returns false if the table should be dumped as a single entry after all.
+ */
+static bool
+dumpTableDataSplit(Archive *fout, TableDataInfo *tdinfo,
+				   const char *copyStmt, DataDumperPtr dumpFn)
+{
+	TableInfo  *tbinfo = tdinfo->tdtable;
+	PQExpBuffer query;
+	PGresult   *res;
+	char	   *keycol;
+	DumpId	   *deps;
+	int			nchunks;
+	int			nbounds;
+	int			i;
+
+	if (splitTableSize <= 0 || fout->remoteVersion < 80200)
+		return false;
+
+	/* Existing row filters and OIDs go through the unsplit paths */
+	if (tdinfo->filtercond || (tdinfo->oids && tbinfo->hasoids))
+		return false;
+
+	nchunks = (int) (((double) tbinfo->relpages * BLCKSZ) /
+					 ((double) splitTableSize * 1024 * 1024));
+	if (nchunks < 2)
+		return false;
+
+	query = createPQExpBuffer();
+
+	/* Look for a primary key we can cheaply range-scan */
+	appendPQExpBuffer(query,
+					  "SELECT a.attname "
+					  "FROM pg_catalog.pg_index i "
+					  "JOIN pg_catalog.pg_attribute a "
+					  "ON a.attrelid = i.indrelid AND a.attnum = i.indkey[0] "
+					  "WHERE i.indrelid = '%u'::pg_catalog.oid "
+					  "AND i.indisprimary AND i.indnatts = 1 "
+					  "AND a.atttypid IN ('pg_catalog.int2'::pg_catalog.regtype, "
+					  "'pg_catalog.int4'::pg_catalog.regtype, "
+					  "'pg_catalog.int8'::pg_catalog.regtype)",
+					  tbinfo->dobj.catId.oid);
+	res = ExecuteSqlQuery(fout, query->data, PGRES_TUPLES_OK);
+	if (PQntuples(res) != 1)
+	{
+		PQclear(res);
+		destroyPQExpBuffer(query);
+		return false;
+	}
+	keycol = pg_strdup(fmtId(PQgetvalue(res, 0, 0)));
+	PQclear(res);
+
+	/*
+	 * Compute the interior chunk boundaries.  Do the arithmetic in numeric
+	 * so that extreme int8 keys can't overflow.  The first and last chunks
+	 * are left open-ended, so every row lands in exactly one chunk whatever
+	 * the boundaries turn out to be.
+	 */
+	resetPQExpBuffer(query);
+	appendPQExpBuffer(query,
+					  "SELECT DISTINCT pg_catalog.floor(lo + (hi - lo + 1) * g / %d)::pg_catalog.int8 "
+					  "FROM (SELECT pg_catalog.min(%s)::pg_catalog.numeric AS lo, "
+					  "pg_catalog.max(%s)::pg_catalog.numeric AS hi FROM %s) s, "
+					  "pg_catalog.generate_series(1, %d) g "
+					  "WHERE hi IS NOT NULL ORDER BY 1",
+					  nchunks, keycol, keycol,
+					  fmtQualifiedId(fout->remoteVersion,
+									 tbinfo->dobj.namespace->dobj.name,
+									 tbinfo->dobj.name),
+					  nchunks - 1);
+	res = ExecuteSqlQuery(fout, query->data, PGRES_TUPLES_OK);
+	nbounds = PQntuples(res);
+	if (nbounds == 0)
+	{
+		/* table is empty */
+		PQclear(res);
+		destroyPQExpBuffer(query);
+		free(keycol);
+		return false;
+	}
+
+	if (g_verbose)
+		write_msg(NULL, "splitting data of table %s into %d chunks\n",
+				  tbinfo->dobj.name, nbounds + 1);
+
+	deps = (DumpId *) pg_malloc((nbounds + 2) * sizeof(DumpId));
+	deps[0] = tbinfo->dobj.dumpId;
+
+	for (i = 0; i <= nbounds; i++)
+	{
+		TableDataInfo *chunk = (TableDataInfo *) pg_malloc(sizeof(TableDataInfo));
+
+		*chunk = *tdinfo;
+		resetPQExpBuffer(query);
+		if (i == 0)
+			appendPQExpBuffer(query, "WHERE %s < %s",
+							  keycol, PQgetvalue(res, i, 0));
+		else if (i == nbounds)
+			appendPQExpBuffer(query, "WHERE %s >= %s",
+							  keycol, PQgetvalue(res, i - 1, 0));
+		else
+			appendPQExpBuffer(query, "WHERE %s >= %s AND %s < %s",
+							  keycol, PQgetvalue(res, i - 1, 0),
+							  keycol, PQgetvalue(res, i, 0));
+		chunk->filtercond = pg_strdup(query->data);
+		chunk->dobj.dumpId = createDumpId();
+		deps[i + 1] = chunk->dobj.dumpId;
+
+		/*
+		 * The table's catalog ID lets parallel workers find the table to
+		 * lock, as for the TABLE DATA entry of an unsplit table.
+		 */
+		ArchiveEntry(fout, tdinfo->dobj.catId, chunk->dobj.dumpId,
+					 tbinfo->dobj.name, tbinfo->dobj.namespace->dobj.name,
+					 NULL, tbinfo->rolname,
+					 false, "TABLE DATA", SECTION_DATA,
+					 "", "", copyStmt,
+					 &(tbinfo->dobj.dumpId), 1,
+					 dumpFn, chunk);
+	}
+
+	ArchiveEntry(fout, tdinfo->dobj.catId, tdinfo->dobj.dumpId,
+				 tbinfo->dobj.name, tbinfo->dobj.namespace->dobj.name,
+				 NULL, tbinfo->rolname,
+				 false, "TABLE DATA", SECTION_DATA,
+				 "", "", NULL,
+				 deps, nbounds + 2,
+				 NULL, NULL);
+
+	PQclear(res);
+	destroyPQExpBuffer(query);
+	free(keycol);
+
+	return true;
+}
+
 /*
  * refreshMatViewData -
  *	  load or refresh the contents of a single materialized view
@@ -4267,6 +4446,8 @@ getTables(Archive *fout, int *numTables)
 	int			i_checkoption;
 	int			i_toastreloptions;
 	int			i_reloftype;
+	int			i_partkeydef;
+	int			i_partbound;
 	int			i_relpages;
 
 	/* Make sure we are in proper schema */
@@ -4309,6 +4490,8 @@ getTables(Archive *fout, int *numTables)
 						  "c.relpersistence, c.relispopulated, "
 						  "c.relreplident, c.relpages, "
 						  "CASE WHEN c.reloftype <> 0 THEN c.reloftype::pg_catalog.regtype ELSE NULL END AS reloftype, "
+						  "pg_catalog.pg_get_partkeydef(c.oid) AS partkeydef, "
+						  "(SELECT pg_catalog.pg_get_expr(i.inhbound, i.inhrelid) FROM pg_catalog.pg_inherits i WHERE i.inhrelid = c.oid AND i.inhbound IS NOT NULL) AS partbound, "
 						  "d.refobjid AS owning_tab, "
 						  "d.refobjsubid AS owning_col, "
 						  "(SELECT spcname FROM pg_tablespace t WHERE t.oid = c.reltablespace) AS reltablespace, "
@@ -4721,6 +4904,8 @@ getTables(Archive *fout, int *numTables)
 	i_checkoption = PQfnumber(res, "checkoption");
 	i_toastreloptions = PQfnumber(res, "toast_reloptions");
 	i_reloftype = PQfnumber(res, "reloftype");
+	i_partkeydef = PQfnumber(res, "partkeydef");
+	i_partbound = PQfnumber(res, "partbound");
 
 	if (lockWaitTimeout && fout->remoteVersion >= 70300)
 	{
@@ -4766,6 +4951,14 @@ getTables(Archive *fout, int *numTables)
 			tblinfo[i].reloftype = NULL;
 		else
 			tblinfo[i].reloftype = pg_strdup(PQgetvalue(res, i, i_reloftype));
+		if (i_partkeydef == -1 || PQgetisnull(res, i, i_partkeydef))
+			tblinfo[i].partkeydef = NULL;
+		else
+			tblinfo[i].partkeydef = pg_strdup(PQgetvalue(res, i, i_partkeydef));
+		if (i_partbound == -1 || PQgetisnull(res, i, i_partbound))
+			tblinfo[i].partbound = NULL;
+		else
+			tblinfo[i].partbound = pg_strdup(PQgetvalue(res, i, i_partbound));
 		tblinfo[i].ncheck = atoi(PQgetvalue(res, i, i_relchecks));
 		if (PQgetisnull(res, i, i_owning_tab))
 		{
@@ -13144,7 +13337,36 @@ dumpTableSchema(Archive *fout, TableInfo *tbinfo)
 		if (tbinfo->reloftype && !binary_upgrade)
 			appendPQExpBuffer(q, " OF %s", tbinfo->reloftype);
 
-		if (tbinfo->relkind != RELKIND_MATVIEW)
+		/*
+		 * A partition gets all its columns from its parent, so there's
+		 * nothing to say about them.  Its own CHECK constraints are added
+		 * afterwards.  We can't reproduce dropped columns this way, which
+		 * binary upgrade would need.
+		 */
+		if (tbinfo->partbound)
+		{
+			TableInfo  *parentRel = parents[0];
+
+			if (binary_upgrade)
+			{
+				for (j = 0; j < tbinfo->numatts; j++)
+				{
+					if (tbinfo->attisdropped[j])
+						exit_horribly(NULL,
+									  "cannot dump partition \"%s\" with dropped columns in binary upgrade mode\n",
+									  tbinfo->dobj.name);
+				}
+			}
+
+			Assert(numParents == 1);
+			appendPQExpBufferStr(q, " PARTITION OF ");
+			if (parentRel->dobj.namespace != tbinfo->dobj.namespace)
+				appendPQExpBuffer(q, "%s.",
+								  fmtId(parentRel->dobj.namespace->dobj.name));
+			appendPQExpBuffer(q, "%s\n%s", fmtId(parentRel->dobj.name),
+							  tbinfo->partbound);
+		}
+		else if (tbinfo->relkind != RELKIND_MATVIEW)
 		{
 			/* Dump the attributes */
 			actual_atts = 0;
@@ -13293,6 +13515,9 @@ dumpTableSchema(Archive *fout, TableInfo *tbinfo)
 				appendPQExpBufferChar(q, ')');
 			}
 
+			if (tbinfo->partkeydef)
+				appendPQExpBuffer(q, "\nPARTITION BY %s", tbinfo->partkeydef);
+
 			if (tbinfo->relkind == RELKIND_FOREIGN_TABLE)
 				appendPQExpBuffer(q, "\nSERVER %s", fmtId(srvname));
 		}
@@ -13336,6 +13561,22 @@ dumpTableSchema(Archive *fout, TableInfo *tbinfo)
 		else
 			appendPQExpBufferStr(q, ";\n");
 
+		if (tbinfo->partbound)
+		{
+			for (j = 0; j < tbinfo->ncheck; j++)
+			{
+				ConstraintInfo *constr = &(tbinfo->checkexprs[j]);
+
+				if (constr->separate || !constr->conislocal)
+					continue;
+
+				appendPQExpBuffer(q, "ALTER TABLE ONLY %s ",
+								  fmtId(tbinfo->dobj.name));
+				appendPQExpBuffer(q, "ADD CONSTRAINT %s %s;\n",
+								  fmtId(constr->dobj.name), constr->condef);
+			}
+		}
+
 		/*
 		 * To create binary-compatible heap files, we have to ensure the same
 		 * physical column order, including dropped columns, as in the
@@ -13352,7 +13593,7 @@ dumpTableSchema(Archive *fout, TableInfo *tbinfo)
 		if (binary_upgrade && (tbinfo->relkind == RELKIND_RELATION ||
 							   tbinfo->relkind == RELKIND_FOREIGN_TABLE) )
 		{
-			for (j = 0; j < tbinfo->numatts; j++)
+			for (j = 0; j < tbinfo->numatts && !tbinfo->partbound; j++)
 			{
 				if (tbinfo->attisdropped[j])
 				{
@@ -13396,7 +13637,7 @@ dumpTableSchema(Archive *fout, TableInfo *tbinfo)
 			{
 				ConstraintInfo *constr = &(tbinfo->checkexprs[k]);
 
-				if (constr->separate || constr->conislocal)
+				if (constr->separate || constr->conislocal || tbinfo->partbound)
 					continue;
 
 				appendPQExpBufferStr(q, "\n-- For binary upgrade, set up inherited constraint.\n");
@@ -13414,7 +13655,7 @@ dumpTableSchema(Archive *fout, TableInfo *tbinfo)
 				appendPQExpBufferStr(q, "::pg_catalog.regclass;\n");
 			}
 
-			if (numParents > 0)
+			if (numParents > 0 && !tbinfo->partbound)
 			{
 				appendPQExpBufferStr(q, "\n-- For binary upgrade, set up inheritance this way.\n");
 				for (k = 0; k < numParents; k++)
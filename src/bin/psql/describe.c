@@ -2265,8 +2265,27 @@ describeOneTableDetails(const char *schemaname,
 			PQclear(result);
 		}
 
+		/* print partition key */
+		if (pset.sversion >= 90400)
+		{
+			printfPQExpBuffer(&buf, "SELECT pg_catalog.pg_get_partkeydef('%s');", oid);
+			result = PSQLexec(buf.data, false);
+			if (!result)
+				goto error_return;
+			if (PQntuples(result) == 1 && !PQgetisnull(result, 0, 0))
+			{
+				printfPQExpBuffer(&buf, _("Partition key: %s"),
+								  PQgetvalue(result, 0, 0));
+				printTableAddFooter(&cont, buf.data);
+			}
+			PQclear(result);
+		}
+
 		/* print inherited tables */
-		printfPQExpBuffer(&buf, "SELECT c.oid::pg_catalog.regclass FROM pg_catalog.pg_class c, pg_catalog.pg_inherits i WHERE c.oid=i.inhparent AND i.inhrelid = '%s' ORDER BY inhseqno;", oid);
+		if (pset.sversion >= 90400)
+			printfPQExpBuffer(&buf, "SELECT c.oid::pg_catalog.regclass, pg_catalog.pg_get_expr(i.inhbound, i.inhrelid) FROM pg_catalog.pg_class c, pg_catalog.pg_inherits i WHERE c.oid=i.inhparent AND i.inhrelid = '%s' ORDER BY inhseqno;", oid);
+		else
+			printfPQExpBuffer(&buf, "SELECT c.oid::pg_catalog.regclass, NULL FROM pg_catalog.pg_class c, pg_catalog.pg_inherits i WHERE c.oid=i.inhparent AND i.inhrelid = '%s' ORDER BY inhseqno;", oid);
 
 		result = PSQLexec(buf.data, false);
 		if (!result)
@@ -2280,7 +2299,12 @@ describeOneTableDetails(const char *schemaname,
 
 			for (i = 0; i < tuples; i++)
 			{
-				if (i == 0)
+				/* a partition has just the one parent */
+				if (!PQgetisnull(result, i, 1))
+					printfPQExpBuffer(&buf, _("Partition of: %s %s"),
+									  PQgetvalue(result, i, 0),
+									  PQgetvalue(result, i, 1));
+				else if (i == 0)
 					printfPQExpBuffer(&buf, "%s: %s",
 									  s, PQgetvalue(result, i, 0));
 				else
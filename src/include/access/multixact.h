@@ -25,9 +25,12 @@
 
 #define MultiXactIdIsValid(multi) ((multi) != InvalidMultiXactId)
 
-/* Number of SLRU buffers to use for multixact */
-#define NUM_MXACTOFFSET_BUFFERS		8
-#define NUM_MXACTMEMBER_BUFFERS		16
+/* GUC parameters: number of SLRU buffers to use for multixact */
+#define DEFAULT_MXACTOFFSET_BUFFERS		16
+#define DEFAULT_MXACTMEMBER_BUFFERS		32
+
+extern int	multixact_offset_buffers;
+extern int	multixact_member_buffers;
 
 /*
  * Possible multixact lock modes ("status").  The first four modes are for
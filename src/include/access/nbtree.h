@@ -120,6 +120,15 @@ typedef struct BTMetaPageData
 				   MAXALIGN(SizeOfPageHeaderData + 3*sizeof(ItemIdData)) - \
 				   MAXALIGN(sizeof(BTPageOpaqueData))) / 3)
 
+/*
+ * Maximum number of heap TIDs that can be stored on a single leaf page.
+ * Posting list tuples let this exceed MaxIndexTuplesPerPage; it is a loose
+ * upper bound that simply assumes every byte of the page holds TIDs.
+ */
+#define MaxTIDsPerBTreePage \
+	((int) ((BLCKSZ - SizeOfPageHeaderData - sizeof(BTPageOpaqueData)) / \
+			sizeof(ItemPointerData)))
+
 /*
  * The leaf-page fillfactor defaults to 90% but is user-adjustable.
  * For pages above the leaf level, we use a fixed 70% fillfactor.
@@ -153,8 +162,112 @@ typedef struct BTMetaPageData
 	( (i1).ip_blkid.bi_hi == (i2).ip_blkid.bi_hi && \
 	  (i1).ip_blkid.bi_lo == (i2).ip_blkid.bi_lo && \
 	  (i1).ip_posid == (i2).ip_posid )
+
+/*
+ *	Downlinks are identified by the child block number alone, since the
+ *	offset part of a pivot tuple's t_tid may hold its number of attributes
+ *	(see below).
+ */
 #define BTEntrySame(i1, i2) \
-	BTTidSame((i1)->t_tid, (i2)->t_tid)
+	(BTreeInnerTupleGetDownLink(i1) == BTreeInnerTupleGetDownLink(i2))
+
+/*
+ *	Posting list tuples.
+ *
+ *	To save space, a non-unique index may merge a group of leaf tuples having
+ *	the same key into a single "posting list" tuple: the key, followed by a
+ *	sorted array of the heap TIDs of all the merged tuples.  Such a tuple is
+ *	flagged by setting INDEX_ALT_TID_MASK in t_info, which says that t_tid
+ *	does not point to a heap tuple.  Instead, its offset number holds the
+ *	number of TIDs in the list (together with the BT_IS_POSTING flag), and
+ *	its block number holds the offset of the TID array from the start of the
+ *	tuple.  The key part of the tuple, up to that offset, is laid out exactly
+ *	like an ordinary index tuple.  See nbtdedup.c and the README.
+ *
+ *	Posting list tuples only appear as data items on leaf pages.  High keys
+ *	and downlinks are always formed from a copy of the key part alone.
+ */
+#define INDEX_ALT_TID_MASK			INDEX_AM_RESERVED_BIT
+
+#define BT_OFFSET_MASK				0x0FFF
+#define BT_IS_POSTING				0x2000
+
+#define BTreeTupleIsPosting(itup) \
+	(((itup)->t_info & INDEX_ALT_TID_MASK) != 0 && \
+	 ((itup)->t_tid.ip_posid & BT_IS_POSTING) != 0)
+#define BTreeTupleGetNPosting(itup) \
+	( \
+		AssertMacro(BTreeTupleIsPosting(itup)), \
+		(int) ((itup)->t_tid.ip_posid & BT_OFFSET_MASK) \
+	)
+#define BTreeTupleGetPostingOffset(itup) \
+	( \
+		AssertMacro(BTreeTupleIsPosting(itup)), \
+		(Size) BlockIdGetBlockNumber(&(itup)->t_tid.ip_blkid) \
+	)
+#define BTreeTupleGetPosting(itup) \
+	((ItemPointer) ((char *) (itup) + BTreeTupleGetPostingOffset(itup)))
+#define BTreeTupleGetPostingN(itup, n) \
+	(BTreeTupleGetPosting(itup) + (n))
+#define BTreeTupleSetPosting(itup, nhtids, off) \
+	do { \
+		(itup)->t_info |= INDEX_ALT_TID_MASK; \
+		BlockIdSet(&(itup)->t_tid.ip_blkid, (off)); \
+		(itup)->t_tid.ip_posid = (OffsetNumber) ((nhtids) | BT_IS_POSTING); \
+	} while (0)
+
+/*
+ *	Pivot tuples.
+ *
+ *	High keys and the keys of downlinks only need to separate the key space
+ *	of the pages on either side of them, so when a leaf page is split we
+ *	truncate the new pivot tuple to the attributes needed to tell the last
+ *	item on the left from the first item on the right (see _bt_truncate).
+ *	The truncated attributes are treated as minus infinity.  A truncated
+ *	pivot tuple has INDEX_ALT_TID_MASK set, with its number of remaining
+ *	attributes in the offset part of t_tid; the block part is still free to
+ *	hold a downlink.  Tuples without INDEX_ALT_TID_MASK (and posting list
+ *	tuples) have all of the index's attributes.
+ */
+#define BTreeTupleGetNAtts(itup, rel) \
+	( \
+		(((itup)->t_info & INDEX_ALT_TID_MASK) != 0 && \
+		 ((itup)->t_tid.ip_posid & BT_IS_POSTING) == 0) ? \
+		(int) ((itup)->t_tid.ip_posid & BT_OFFSET_MASK) : \
+		RelationGetNumberOfAttributes(rel) \
+	)
+#define BTreeTupleSetNAtts(itup, natts) \
+	do { \
+		(itup)->t_info |= INDEX_ALT_TID_MASK; \
+		(itup)->t_tid.ip_posid = (OffsetNumber) ((natts) & BT_OFFSET_MASK); \
+	} while (0)
+
+/*
+ * Get or set the downlink of a pivot tuple on a non-leaf page, without
+ * disturbing any number of attributes stored alongside it.
+ */
+#define BTreeInnerTupleGetDownLink(itup) \
+	BlockIdGetBlockNumber(&((itup)->t_tid.ip_blkid))
+#define BTreeInnerTupleSetDownLink(itup, blkno) \
+	do { \
+		BlockIdSet(&((itup)->t_tid.ip_blkid), (blkno)); \
+		if (((itup)->t_info & INDEX_ALT_TID_MASK) == 0) \
+			(itup)->t_tid.ip_posid = P_HIKEY; \
+	} while (0)
+
+/*
+ * Size of the key part of a leaf tuple; this is the whole tuple unless it is
+ * a posting list tuple.
+ */
+#define BTreeTupleGetKeySize(itup) \
+	(BTreeTupleIsPosting(itup) ? BTreeTupleGetPostingOffset(itup) : \
+	 IndexTupleSize(itup))
+
+/*
+ * Number of heap TIDs represented by a leaf tuple.
+ */
+#define BTreeTupleGetNTIDs(itup) \
+	(BTreeTupleIsPosting(itup) ? BTreeTupleGetNPosting(itup) : 1)
 
 
 /*
@@ -293,9 +406,9 @@ typedef struct xl_btree_split
 	 * The new item, but not newitemoff, is suppressed if XLogInsert chooses
 	 * to store the left page's whole page image.
 	 *
-	 * If level > 0, an IndexTuple representing the HIKEY of the left page
-	 * follows.  We don't need this on leaf pages, because it's the same as
-	 * the leftmost key in the new right page.	Also, it's suppressed if
+	 * Next is an IndexTuple representing the HIKEY of the left page.  (On
+	 * leaf pages it's a truncated copy of the leftmost key in the new right
+	 * page, so it can't be reconstructed from that.)  It's suppressed if
 	 * XLogInsert chooses to store the left page's whole page image.
 	 *
 	 * If level > 0, BlockNumber of the page whose incomplete-split flag
@@ -355,6 +468,10 @@ typedef struct xl_btree_reuse_page
  * starting from the last block vacuumed through until this one. Individual
  * block numbers aren't given.
  *
+ * Posting list tuples from which only some of the heap TIDs were removed are
+ * replaced by smaller versions of themselves; the record carries the offsets
+ * and the new contents of those tuples.
+ *
  * Note that the *last* WAL record in any vacuum of an index is allowed to
  * have a zero length array of offsets. Earlier records must have at least one.
  */
@@ -363,11 +480,15 @@ typedef struct xl_btree_vacuum
 	RelFileNode node;
 	BlockNumber block;
 	BlockNumber lastBlockVacuumed;
+	uint16		ndeleted;
+	uint16		nupdated;
 
-	/* TARGET OFFSET NUMBERS FOLLOW */
+	/* DELETED TARGET OFFSET NUMBERS FOLLOW */
+	/* UPDATED TARGET OFFSET NUMBERS FOLLOW */
+	/* UPDATED TUPLES FOLLOW (each MAXALIGN'd) */
 } xl_btree_vacuum;
 
-#define SizeOfBtreeVacuum	(offsetof(xl_btree_vacuum, lastBlockVacuumed) + sizeof(BlockNumber))
+#define SizeOfBtreeVacuum	(offsetof(xl_btree_vacuum, nupdated) + sizeof(uint16))
 
 /*
  * This is what we need to know about marking an empty branch for deletion.
@@ -507,7 +628,9 @@ typedef BTStackData *BTStack;
  * If we are doing an index-only scan, we save the entire IndexTuple for each
  * matched item, otherwise only its heap TID and offset.  The IndexTuples go
  * into a separate workspace array; each BTScanPosItem stores its tuple's
- * offset within that array.
+ * offset within that array.  A posting list tuple produces one item per heap
+ * TID, all of which share the same indexOffset and (for an index-only scan)
+ * the same saved copy of the tuple's key part.
  */
 
 typedef struct BTScanPosItem	/* what we remember about each match */
@@ -549,7 +672,7 @@ typedef struct BTScanPosData
 	int			lastItem;		/* last valid index in items[] */
 	int			itemIndex;		/* current index in items[] */
 
-	BTScanPosItem items[MaxIndexTuplesPerPage]; /* MUST BE LAST */
+	BTScanPosItem items[MaxTIDsPerBTreePage];	/* MUST BE LAST */
 } BTScanPosData;
 
 typedef BTScanPosData *BTScanPos;
@@ -580,6 +703,18 @@ typedef struct BTScanOpaqueData
 	BTArrayKeyInfo *arrayKeys;	/* info about each equality-type array key */
 	MemoryContext arrayContext; /* scan-lifespan context for array data */
 
+	/* workspace for skip scans (see _bt_preprocess_skip_scan) */
+	bool		skipScan;		/* true if skipping over leading-column
+								 * groups */
+	ScanKey		skipKeyData;	/* input keys for the current skip step */
+	int			numSkipKeys;	/* number of keys in skipKeyData */
+	bool		skipIsNull;		/* is the current group the NULL group? */
+	Datum		skipValue;		/* else, its leading-column value */
+	bool		markSkipIsNull; /* same for the marked position */
+	Datum		markSkipValue;
+	FmgrInfo	skipProcs[BTMaxStrategyNumber]; /* leading-column <, =, > */
+	MemoryContext skipContext;	/* scan-lifespan context for skip data */
+
 	/* info about killed items if any (killedItems is NULL if never used) */
 	int		   *killedItems;	/* currPos.items indexes of killed items */
 	int			numKilled;		/* number of currently stored items */
@@ -637,6 +772,15 @@ extern Datum btvacuumcleanup(PG_FUNCTION_ARGS);
 extern Datum btcanreturn(PG_FUNCTION_ARGS);
 extern Datum btoptions(PG_FUNCTION_ARGS);
 
+/*
+ * prototypes for functions in nbtdedup.c
+ */
+extern bool _bt_dedup_one_page(Relation rel, Buffer buf);
+extern IndexTuple _bt_form_posting(IndexTuple base, ItemPointer htids,
+				 int nhtids);
+extern IndexTuple _bt_pivot_tuple(IndexTuple itup);
+extern bool _bt_posting_contains(IndexTuple posting, ItemPointer htid);
+
 /*
  * prototypes for functions in nbtinsert.c
  */
@@ -663,7 +807,8 @@ extern void _bt_delitems_delete(Relation rel, Buffer buf,
 					OffsetNumber *itemnos, int nitems, Relation heapRel);
 extern void _bt_delitems_vacuum(Relation rel, Buffer buf,
 					OffsetNumber *itemnos, int nitems,
-					BlockNumber lastBlockVacuumed);
+					OffsetNumber *updateitemnos, IndexTuple *updated,
+					int nupdated, BlockNumber lastBlockVacuumed);
 extern int	_bt_pagedel(Relation rel, Buffer buf);
 
 /*
@@ -681,6 +826,8 @@ extern int32 _bt_compare(Relation rel, int keysz, ScanKey scankey,
 			Page page, OffsetNumber offnum);
 extern bool _bt_first(IndexScanDesc scan, ScanDirection dir);
 extern bool _bt_next(IndexScanDesc scan, ScanDirection dir);
+extern void _bt_start_skip_scan(IndexScanDesc scan, ScanDirection dir);
+extern bool _bt_advance_skip_scan(IndexScanDesc scan, ScanDirection dir);
 extern Buffer _bt_get_endpoint(Relation rel, uint32 level, bool rightmost);
 
 /*
@@ -688,6 +835,8 @@ extern Buffer _bt_get_endpoint(Relation rel, uint32 level, bool rightmost);
  */
 extern ScanKey _bt_mkscankey(Relation rel, IndexTuple itup);
 extern ScanKey _bt_mkscankey_nodata(Relation rel);
+extern IndexTuple _bt_truncate(Relation rel, IndexTuple lastleft,
+			 IndexTuple firstright);
 extern void _bt_freeskey(ScanKey skey);
 extern void _bt_freestack(BTStack stack);
 extern void _bt_preprocess_array_keys(IndexScanDesc scan);
@@ -695,6 +844,14 @@ extern void _bt_start_array_keys(IndexScanDesc scan, ScanDirection dir);
 extern bool _bt_advance_array_keys(IndexScanDesc scan, ScanDirection dir);
 extern void _bt_mark_array_keys(IndexScanDesc scan);
 extern void _bt_restore_array_keys(IndexScanDesc scan);
+extern void _bt_preprocess_skip_scan(IndexScanDesc scan);
+extern void _bt_skip_set_group(IndexScanDesc scan, bool isnull, Datum value);
+extern void _bt_skip_group_keys(IndexScanDesc scan);
+extern void _bt_skip_probe_keys(IndexScanDesc scan, ScanDirection dir,
+					bool first);
+extern bool _bt_skip_nulls_first(IndexScanDesc scan, ScanDirection dir);
+extern void _bt_mark_skip_scan(IndexScanDesc scan);
+extern void _bt_restore_skip_scan(IndexScanDesc scan);
 extern void _bt_preprocess_keys(IndexScanDesc scan);
 extern IndexTuple _bt_checkkeys(IndexScanDesc scan,
 			  Page page, OffsetNumber offnum,
@@ -36,6 +36,20 @@
  */
 #define SLRU_PAGES_PER_SEGMENT	32
 
+/*
+ * The buffers of an SLRU are divided into banks of SLRU_BANK_SIZE buffers.
+ * A page can only be held by a buffer of the bank selected by its page
+ * number, so looking up a page or choosing a victim buffer only has to
+ * search that bank, and unless the SLRU uses a single control lock, each
+ * bank has its own lock.  An SLRU whose number of buffers is not a multiple
+ * of SLRU_BANK_SIZE has just one bank.
+ */
+#define SLRU_BANK_SIZE			16
+
+/* Limits for the number of buffers of an SLRU set by a GUC */
+#define SLRU_MIN_BUFFERS		SLRU_BANK_SIZE
+#define SLRU_MAX_BUFFERS		((1024 * 1024 * 1024) / BLCKSZ)
+
 /*
  * Page status codes.  Note that these do not include the "dirty" bit.
  * page_dirty can be TRUE only in the VALID or WRITE_IN_PROGRESS states;
@@ -55,11 +69,20 @@ typedef enum
  */
 typedef struct SlruSharedData
 {
-	LWLock     *ControlLock;
-
 	/* Number of buffers managed by this SLRU structure */
 	int			num_slots;
 
+	/*
+	 * The buffers are divided into num_banks banks of bank_size buffers.
+	 * bank_locks[] holds the lock protecting each bank's share of the
+	 * arrays below (all the same lock if the SLRU has a control lock), and
+	 * bank_cur_lru_count[] its LRU counter.
+	 */
+	int			num_banks;
+	int			bank_size;
+	LWLock	  **bank_locks;
+	int		   *bank_cur_lru_count;
+
 	/*
 	 * Arrays holding info for each buffer slot.  Page number is undefined
 	 * when status is EMPTY, as is page_lru_count.
@@ -82,23 +105,14 @@ typedef struct SlruSharedData
 	XLogRecPtr *group_lsn;
 	int			lsn_groups_per_page;
 
-	/*----------
-	 * We mark a page "most recently used" by setting
-	 *		page_lru_count[slotno] = ++cur_lru_count;
-	 * The oldest page is therefore the one with the highest value of
-	 *		cur_lru_count - page_lru_count[slotno]
-	 * The counts will eventually wrap around, but this calculation still
-	 * works as long as no page's age exceeds INT_MAX counts.
-	 *----------
-	 */
-	int			cur_lru_count;
-
 	/*
 	 * latest_page_number is the page number of the current end of the log;
 	 * this is not critical data, since we use it only to avoid swapping out
-	 * the latest page.
+	 * the latest page, and to sanity-check truncation.  It is set while
+	 * holding only the lock of the new page's bank, so it can change under
+	 * a process holding another bank's lock.
 	 */
-	int			latest_page_number;
+	volatile int latest_page_number;
 } SlruSharedData;
 
 typedef SlruSharedData *SlruShared;
@@ -133,8 +147,16 @@ typedef struct SlruCtlData
 
 typedef SlruCtlData *SlruCtl;
 
+/*
+ * Get the lock that must be held to access the given page.
+ */
+#define SimpleLruGetBankLock(ctl, pageno) \
+	((ctl)->shared->bank_locks[(pageno) % (ctl)->shared->num_banks])
+
 
 extern Size SimpleLruShmemSize(int nslots, int nlsns);
+extern int	SimpleLruNumLWLocks(int nslots, bool banklocks);
+extern int	SimpleLruAutotuneBuffers(int divisor, int max);
 extern void SimpleLruInit(SlruCtl ctl, const char *name, int nslots, int nlsns,
 			  LWLock *ctllock, const char *subdir);
 extern int	SimpleLruZeroPage(SlruCtl ctl, int pageno);
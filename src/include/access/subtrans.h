@@ -11,13 +11,14 @@
 #ifndef SUBTRANS_H
 #define SUBTRANS_H
 
-/* Number of SLRU buffers to use for subtrans */
-#define NUM_SUBTRANS_BUFFERS	32
+/* GUC parameter */
+extern int	subtransaction_buffers;
 
 extern void SubTransSetParent(TransactionId xid, TransactionId parent, bool overwriteOK);
 extern TransactionId SubTransGetParent(TransactionId xid);
 extern TransactionId SubTransGetTopmostTransaction(TransactionId xid);
 
+extern Size SUBTRANSShmemBuffers(void);
 extern Size SUBTRANSShmemSize(void);
 extern void SUBTRANSShmemInit(void);
 extern void BootStrapSUBTRANS(void);
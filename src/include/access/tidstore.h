@@ -0,0 +1,65 @@
+/*-------------------------------------------------------------------------
+ *
+ * tidstore.h
+ *	  compact storage for a set of TIDs, organized by block
+ *
+ *
+ * Portions Copyright (c) 1996-2014, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/include/access/tidstore.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef TIDSTORE_H
+#define TIDSTORE_H
+
+#include "storage/itemptr.h"
+
+/* Opaque backend-local handle for a TID store */
+typedef struct TidStore TidStore;
+
+/*
+ * State for iterating over a TID store in block order.  After each
+ * successful call to tidstore_iterate_next, blkno and the first num_offsets
+ * elements of offsets (in increasing order) describe one block.
+ */
+typedef struct TidStoreIter
+{
+	TidStore   *ts;
+	uint32		next_entry;
+	BlockNumber blkno;
+	int			num_offsets;
+	OffsetNumber offsets[MaxOffsetNumber];
+} TidStoreIter;
+
+/*
+ * Largest area a TID store can use; payload offsets are 32 bits wide.  It's
+ * kept MAXALIGN'd, as payloads are aligned relative to the end of the area.
+ */
+#define TIDSTORE_MAX_SIZE		MAXALIGN_DOWN((Size) 0xFFFFFFFF)
+
+extern Size tidstore_block_space(OffsetNumber max_offset);
+extern Size tidstore_space_for_blocks(BlockNumber nblocks,
+						  OffsetNumber max_offset);
+
+extern TidStore *tidstore_create(Size area_size, OffsetNumber max_offset);
+extern TidStore *tidstore_initialize(void *area, Size area_size,
+					OffsetNumber max_offset);
+extern TidStore *tidstore_attach(void *area);
+extern void tidstore_free(TidStore *ts);
+extern void tidstore_reset(TidStore *ts);
+
+extern bool tidstore_is_full(TidStore *ts);
+extern void tidstore_set_block_offsets(TidStore *ts, BlockNumber blkno,
+						   OffsetNumber *offsets, int num_offsets);
+extern bool tidstore_is_member(TidStore *ts, ItemPointer tid);
+
+extern int64 tidstore_num_tids(TidStore *ts);
+extern BlockNumber tidstore_num_blocks(TidStore *ts);
+extern Size tidstore_memory_usage(TidStore *ts);
+
+extern void tidstore_begin_iterate(TidStore *ts, TidStoreIter *iter);
+extern bool tidstore_iterate_next(TidStoreIter *iter);
+
+#endif   /* TIDSTORE_H */
@@ -29,13 +29,15 @@
  *		...
  *
  * where there can be zero to four backup blocks (as signaled by xl_info flag
- * bits).  XLogRecord structs always start on MAXALIGN boundaries in the WAL
+ * bits).  If XLR_HAS_TOPLEVEL_XID is set in xl_flags, the record ends with
+ * the TransactionId of xl_xid's toplevel transaction, after any backup
+ * blocks.  XLogRecord structs always start on MAXALIGN boundaries in the WAL
  * files, and we round up SizeOfXLogRecord so that the rmgr data is also
  * guaranteed to begin on a MAXALIGN boundary.	However, no padding is added
  * to align BkpBlock structs or backup block data.
  *
  * NOTE: xl_len counts only the rmgr data, not the XLogRecord header,
- * and also not any backup blocks.	xl_tot_len counts everything.  Neither
+ * and also not any backup blocks or toplevel xid.	xl_tot_len counts everything.  Neither
  * length field is rounded up to an alignment boundary.
  */
 typedef struct XLogRecord
@@ -45,7 +47,8 @@ typedef struct XLogRecord
 	uint32		xl_len;			/* total len of rmgr data */
 	uint8		xl_info;		/* flag bits, see below */
 	RmgrId		xl_rmid;		/* resource manager for this record */
-	/* 2 bytes of padding here, initialize to zero */
+	uint8		xl_flags;		/* flag bits, see below */
+	/* 1 byte of padding here, initialize to zero */
 	XLogRecPtr	xl_prev;		/* ptr to previous record in log */
 	pg_crc32	xl_crc;			/* CRC for this record */
 
@@ -73,6 +76,13 @@ typedef struct XLogRecord
 #define XLR_MAX_BKP_BLOCKS		4
 #define XLR_BKP_BLOCK(iblk)		(0x08 >> (iblk))		/* iblk in 0..3 */
 
+/*
+ * xl_flags bits.  XLR_HAS_TOPLEVEL_XID marks the first record written by a
+ * subtransaction when wal_level=logical, see
+ * IsSubTransactionAssignmentPending(); XLogRecGetTopXid() returns the xid.
+ */
+#define XLR_HAS_TOPLEVEL_XID	0x01
+
 /* Sync methods */
 #define SYNC_METHOD_FSYNC		0
 #define SYNC_METHOD_FDATASYNC	1
@@ -55,7 +55,7 @@ typedef struct BkpBlock
 /*
  * Each page of XLOG file has a header like this:
  */
-#define XLOG_PAGE_MAGIC 0xD07D	/* can be used as WAL version indicator */
+#define XLOG_PAGE_MAGIC 0xD081	/* can be used as WAL version indicator */
 
 typedef struct XLogPageHeaderData
 {
@@ -53,6 +53,6 @@
  */
 
 /*							yyyymmddN */
-#define CATALOG_VERSION_NO	201404031
+#define CATALOG_VERSION_NO	201404062
 
 #endif
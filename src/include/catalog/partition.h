@@ -0,0 +1,91 @@
+/*-------------------------------------------------------------------------
+ *
+ * partition.h
+ *	  Header file for structures and utility functions related to
+ *	  declarative partitioning
+ *
+ * Portions Copyright (c) 1996-2014, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/include/catalog/partition.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef PARTITION_H
+#define PARTITION_H
+
+#include "fmgr.h"
+#include "nodes/bitmapset.h"
+#include "nodes/parsenodes.h"
+#include "utils/relcache.h"
+
+/*
+ * Information about the partition key of a partitioned table, derived from
+ * its pg_partitioned_table row and the key column's pg_attribute row.
+ */
+typedef struct PartitionKeyData
+{
+	char		strategy;		/* PARTITION_STRATEGY_LIST or _RANGE */
+	AttrNumber	partattnum;		/* key column */
+	Oid			partopfamily;	/* btree opfamily of the key's opclass */
+	Oid			partopcintype;	/* input type of the key's opclass */
+	Oid			partcollation;	/* collation of the key, or InvalidOid */
+	Oid			parttypid;		/* type of the key column */
+	int32		parttypmod;		/* typmod of the key column */
+	int16		parttyplen;		/* typlen of the key column */
+	bool		parttypbyval;	/* typbyval of the key column */
+	FmgrInfo	partcmpfn;		/* btree comparison proc for partopcintype */
+} PartitionKeyData;
+
+typedef PartitionKeyData *PartitionKey;
+
+/*
+ * The partitions of a partitioned table, sorted by their bounds.
+ *
+ * For range partitioning, partition i accepts the key values in
+ * [lower[i], upper[i]).  Ranges don't overlap, so the upper bounds are
+ * sorted too; only the first partition can be unbounded below, and only the
+ * last one unbounded above.
+ *
+ * For list partitioning, values[] holds the values accepted by all the
+ * partitions, in sorted order, and valueparts[] the partition accepting
+ * each of them.  Partitions are numbered in order of their lowest value.
+ *
+ * No partition accepts a NULL key.
+ */
+typedef struct PartitionDescData
+{
+	int			nparts;			/* number of partitions */
+	Oid		   *oids;			/* OIDs of the partitions, in bound order */
+
+	/* range partitioning */
+	Datum	   *lower;
+	bool	   *lower_unbounded;
+	Datum	   *upper;
+	bool	   *upper_unbounded;
+
+	/* list partitioning */
+	int			nvalues;
+	Datum	   *values;
+	int		   *valueparts;
+} PartitionDescData;
+
+typedef PartitionDescData *PartitionDesc;
+
+extern PartitionKey RelationGetPartitionKey(Relation rel);
+extern PartitionDesc RelationGetPartitionDesc(Relation rel);
+extern List *RelationGetPartitionQual(Relation rel);
+extern bool relation_is_partitioned(Oid relid);
+extern Oid	get_partition_parent(Oid relid);
+
+extern void check_new_partition_bound(const char *relname, Relation parent,
+						  PartitionBoundSpec *spec);
+extern int get_partition_for_value(PartitionKey key, PartitionDesc pdesc,
+						Datum value, bool isnull);
+extern Bitmapset *get_matching_partitions(PartitionKey key,
+						PartitionDesc pdesc, Index varno,
+						List *clauses, List **paramclauses);
+extern bool partition_bounds_equal(PartitionKey key1, PartitionDesc pdesc1,
+					   PartitionKey key2, PartitionDesc pdesc2);
+
+#endif   /* PARTITION_H */
@@ -0,0 +1,69 @@
+/*-------------------------------------------------------------------------
+ *
+ * pg_partitioned_table.h
+ *	  definition of the system "partitioned table" relation
+ *	  along with the relation's initial contents.
+ *
+ *
+ * Portions Copyright (c) 1996-2014, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/include/catalog/pg_partitioned_table.h
+ *
+ * NOTES
+ *	  the genbki.pl script reads this file and generates .bki
+ *	  information from the DATA() statements.
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef PG_PARTITIONED_TABLE_H
+#define PG_PARTITIONED_TABLE_H
+
+#include "catalog/genbki.h"
+
+/* ----------------
+ *		pg_partitioned_table definition.  cpp turns this into
+ *		typedef struct FormData_pg_partitioned_table
+ * ----------------
+ */
+#define PartitionedRelationId 3350
+
+CATALOG(pg_partitioned_table,3350) BKI_WITHOUT_OIDS
+{
+	Oid			partrelid;		/* OID of the partitioned table */
+	char		partstrat;		/* partitioning strategy, see below */
+	int16		partattnum;		/* attribute number of the key column */
+	Oid			partopclass;	/* btree opclass of the key */
+	Oid			partcollation;	/* collation of the key, or 0 */
+} FormData_pg_partitioned_table;
+
+/* ----------------
+ *		Form_pg_partitioned_table corresponds to a pointer to a tuple with
+ *		the format of pg_partitioned_table relation.
+ * ----------------
+ */
+typedef FormData_pg_partitioned_table *Form_pg_partitioned_table;
+
+/* ----------------
+ *		compiler constants for pg_partitioned_table
+ * ----------------
+ */
+#define Natts_pg_partitioned_table				5
+#define Anum_pg_partitioned_table_partrelid		1
+#define Anum_pg_partitioned_table_partstrat		2
+#define Anum_pg_partitioned_table_partattnum	3
+#define Anum_pg_partitioned_table_partopclass	4
+#define Anum_pg_partitioned_table_partcollation 5
+
+/* ----------------
+ *		pg_partitioned_table has no initial contents
+ * ----------------
+ */
+
+/*
+ * Symbolic values for partstrat column
+ */
+#define PARTITION_STRATEGY_RANGE	'r'
+#define PARTITION_STRATEGY_LIST		'l'
+
+#endif   /* PG_PARTITIONED_TABLE_H */
@@ -36,4 +36,6 @@ extern void CopyFromErrorCallback(void *arg);
 
 extern DestReceiver *CreateCopyDestReceiver(void);
 
+extern void ParallelCopyWorkerMain(Datum main_arg);
+
 #endif   /* COPY_H */
@@ -0,0 +1,47 @@
+/*-------------------------------------------------------------------------
+ *
+ * execPartition.h
+ *	  Routing of inserted rows to the partitions of a partitioned table.
+ *
+ * Portions Copyright (c) 1996-2014, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/include/executor/execPartition.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef EXECPARTITION_H
+#define EXECPARTITION_H
+
+#include "access/tupconvert.h"
+#include "nodes/execnodes.h"
+
+/*
+ * State for routing rows inserted into a partitioned table.  The per
+ * partition arrays are indexed like the parent's PartitionDesc, and filled
+ * in only when a row is first routed to the partition.
+ */
+typedef struct PartitionTupleRouting
+{
+	ResultRelInfo *rootinfo;	/* the partitioned table */
+	int			nparts;			/* number of partitions */
+	ResultRelInfo **partinfos;	/* partitions opened so far, or NULL */
+	TupleConversionMap **tomaps;	/* parent to partition row type, or NULL */
+	TupleConversionMap **frommaps;	/* partition to parent row type */
+	TupleTableSlot **partslots; /* slots for converted rows */
+	TupleTableSlot *rootslot;	/* slot for rows converted back */
+} PartitionTupleRouting;
+
+extern PartitionTupleRouting *ExecSetupPartitionTupleRouting(ResultRelInfo *rootinfo,
+							   EState *estate);
+extern int ExecFindPartition(PartitionTupleRouting *proute,
+				  TupleTableSlot *slot, EState *estate);
+extern ResultRelInfo *ExecGetPartitionInfo(PartitionTupleRouting *proute,
+					 int partidx, EState *estate);
+extern TupleTableSlot *ExecConvertToPartition(PartitionTupleRouting *proute,
+					   int partidx, TupleTableSlot *slot);
+extern TupleTableSlot *ExecConvertToRoot(PartitionTupleRouting *proute,
+				  int partidx, TupleTableSlot *slot);
+extern void ExecCleanupPartitionTupleRouting(PartitionTupleRouting *proute);
+
+#endif   /* EXECPARTITION_H */
@@ -308,6 +308,8 @@ typedef struct JunkFilter
  *		ConstraintExprs			array of constraint-checking expr states
  *		junkFilter				for removing junk attributes from tuples
  *		projectReturning		for computing a RETURNING list
+ *		PartitionCheck			partition constraint, if a partition
+ *		PartitionCheckExpr		partition constraint expr state
  * ----------------
  */
 typedef struct ResultRelInfo
@@ -329,6 +331,8 @@ typedef struct ResultRelInfo
 	List	  **ri_ConstraintExprs;
 	JunkFilter *ri_junkFilter;
 	ProjectionInfo *ri_projectReturning;
+	List	   *ri_PartitionCheck;
+	List	   *ri_PartitionCheckExpr;
 } ResultRelInfo;
 
 /* ----------------
@@ -1088,6 +1092,8 @@ typedef struct ModifyTableState
 	List	  **mt_arowmarks;	/* per-subplan ExecAuxRowMark lists */
 	EPQState	mt_epqstate;	/* for evaluating EvalPlanQual rechecks */
 	bool		fireBSTriggers; /* do we need to fire stmt triggers? */
+	struct PartitionTupleRouting *mt_partition_routing;	/* for INSERT into
+														 * a partitioned table */
 } ModifyTableState;
 
 /* ----------------
@@ -1095,6 +1101,7 @@ typedef struct ModifyTableState
  *
  *		nplans			how many plans are in the array
  *		whichplan		which plan is being executed (0 .. n-1)
+ *		nremoved		how many subplans were pruned at startup
  * ----------------
  */
 typedef struct AppendState
@@ -1103,6 +1110,7 @@ typedef struct AppendState
 	PlanState **appendplans;	/* array of PlanStates for my inputs */
 	int			as_nplans;
 	int			as_whichplan;
+	int			as_nremoved;
 } AppendState;
 
 /* ----------------
@@ -1672,6 +1680,33 @@ typedef struct SortState
 	void	   *tuplesortstate; /* private state of tuplesort.c */
 } SortState;
 
+/* ----------------
+ *	 IncrementalSortState information
+ *
+ *	 The input is read in batches made of whole groups of tuples sharing the
+ *	 presorted columns; each batch is sorted by its own tuplesort.  A batch
+ *	 holds at least INCSORT_MIN_BATCH tuples (unless the input or the bound
+ *	 runs out first), so that tiny groups don't each pay for a tuplesort.
+ *	 group_pivot holds the first tuple of the group being read, or, when
+ *	 pivot_pending is set, the first tuple of the next batch.
+ * ----------------
+ */
+typedef struct IncrementalSortState
+{
+	ScanState	ss;				/* its first field is NodeTag */
+	bool		bounded;		/* is the result set bounded? */
+	int64		bound;			/* if bounded, how many tuples are needed */
+	bool		batch_Done;		/* current batch sorted, being returned? */
+	bool		outer_Done;		/* outer plan exhausted? */
+	bool		pivot_pending;	/* group_pivot not yet fed to a batch? */
+	int64		tuples_returned;	/* tuples returned so far */
+	long		nbatches;		/* number of batches sorted so far */
+	FmgrInfo   *eqfunctions;	/* equality fns for the presorted columns */
+	MemoryContext tempContext;	/* short-term context for comparisons */
+	TupleTableSlot *group_pivot;	/* see above */
+	void	   *tuplesortstate; /* private state of tuplesort.c */
+} IncrementalSortState;
+
 /* ---------------------
  *	GroupState information
  * -------------------------
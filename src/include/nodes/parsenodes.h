@@ -547,6 +547,40 @@ typedef enum TableLikeOption
 	CREATE_TABLE_LIKE_ALL = 0x7FFFFFFF
 } TableLikeOption;
 
+/*
+ * PartitionSpec - PARTITION BY clause of CREATE TABLE
+ *
+ * Only a single key column is supported.
+ */
+typedef struct PartitionSpec
+{
+	NodeTag		type;
+	char	   *strategy;		/* "range" or "list" */
+	char	   *colname;		/* name of the key column */
+	List	   *collation;		/* name of collation; NIL = default */
+	List	   *opclass;		/* name of desired opclass; NIL = default */
+	int			location;		/* token location, or -1 if unknown */
+} PartitionSpec;
+
+/*
+ * PartitionBoundSpec - FOR VALUES clause of CREATE TABLE ... PARTITION OF
+ *
+ * In a raw parse tree the datums are A_Const nodes, with NULL standing for
+ * UNBOUNDED.  After parse analysis they are Consts of the key column's type;
+ * that form is what gets stored in pg_inherits.inhbound.
+ */
+typedef struct PartitionBoundSpec
+{
+	NodeTag		type;
+	char		strategy;		/* PARTITION_STRATEGY_LIST or _RANGE */
+	List	   *listdatums;		/* accepted values of a list partition */
+	Node	   *lowerdatum;		/* inclusive lower bound of a range
+								 * partition, or NULL if unbounded */
+	Node	   *upperdatum;		/* exclusive upper bound of a range
+								 * partition, or NULL if unbounded */
+	int			location;		/* token location, or -1 if unknown */
+} PartitionBoundSpec;
+
 /*
  * IndexElem - index parameters (used in CREATE INDEX)
  *
@@ -1552,6 +1586,8 @@ typedef struct CreateStmt
 	OnCommitAction oncommit;	/* what do we do at COMMIT? */
 	char	   *tablespacename; /* table space to use, or NULL */
 	bool		if_not_exists;	/* just do nothing if it already exists? */
+	PartitionSpec *partspec;	/* PARTITION BY clause, or NULL */
+	PartitionBoundSpec *partbound;	/* FOR VALUES clause of PARTITION OF */
 } CreateStmt;
 
 /* ----------
@@ -2538,6 +2574,8 @@ typedef struct VacuumStmt
 												 * or -1 to use default */
 	int			multixact_freeze_table_age;		/* multixact age at which to
 												 * scan whole table */
+	int			parallel_workers;		/* # of workers for index vacuuming,
+										 * or 0 to do it all in this backend */
 	RangeVar   *relation;		/* single table to process, or NULL */
 	List	   *va_cols;		/* list of column names, or NIL for all */
 } VacuumStmt;
@@ -188,6 +188,16 @@ typedef struct Append
 {
 	Plan		plan;
 	List	   *appendplans;
+
+	/*
+	 * If the Append scans the partitions of a partitioned table, and some
+	 * restrictions compare the partition key with external Params, the
+	 * partitions that can't match are pruned at executor startup.
+	 */
+	Oid			partrelid;		/* partitioned table, or InvalidOid */
+	Index		partrti;		/* its range table index */
+	List	   *partpruneclauses;	/* clauses to prune with */
+	List	   *partoids;		/* OID of each subplan's partition */
 } Append;
 
 /* ----------------
@@ -302,6 +312,9 @@ typedef Scan SeqScan;
  *
  * indexorderdir specifies the scan ordering, for indexscans on amcanorder
  * indexes (for other indexes it should be "don't care").
+ *
+ * indexskipscan asks the index AM to skip over distinct values of the first
+ * index column, which indexqual doesn't constrain (see amcanskip).
  * ----------------
  */
 typedef struct IndexScan
@@ -313,6 +326,7 @@ typedef struct IndexScan
 	List	   *indexorderby;	/* list of index ORDER BY exprs */
 	List	   *indexorderbyorig;		/* the same in original form */
 	ScanDirection indexorderdir;	/* forward or backward or don't care */
+	bool		indexskipscan;	/* skip over leading-column values? */
 } IndexScan;
 
 /* ----------------
@@ -340,6 +354,7 @@ typedef struct IndexOnlyScan
 	List	   *indexorderby;	/* list of index ORDER BY exprs */
 	List	   *indextlist;		/* TargetEntry list describing index's cols */
 	ScanDirection indexorderdir;	/* forward or backward or don't care */
+	bool		indexskipscan;	/* skip over leading-column values? */
 } IndexOnlyScan;
 
 /* ----------------
@@ -365,6 +380,7 @@ typedef struct BitmapIndexScan
 	Oid			indexid;		/* OID of index to scan */
 	List	   *indexqual;		/* list of index quals (OpExprs) */
 	List	   *indexqualorig;	/* the same in original form */
+	bool		indexskipscan;	/* skip over leading-column values? */
 } BitmapIndexScan;
 
 /* ----------------
@@ -588,6 +604,19 @@ typedef struct Sort
 	bool	   *nullsFirst;		/* NULLS FIRST/LAST directions */
 } Sort;
 
+/* ----------------
+ *		incremental sort node
+ *
+ * The input is already sorted by the first presortedCols sort columns, so
+ * only the runs of tuples sharing those columns need to be sorted.
+ * ----------------
+ */
+typedef struct IncrementalSort
+{
+	Sort		sort;
+	int			presortedCols;	/* number of presorted columns */
+} IncrementalSort;
+
 /* ---------------
  *	 group node -
  *		Used for queries with GROUP BY (but no aggregates) specified.
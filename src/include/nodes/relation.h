@@ -529,6 +529,7 @@ typedef struct IndexOptInfo
 	bool		canreturn;		/* can index return IndexTuples? */
 	bool		amcanorderbyop; /* does AM support order by operator result? */
 	bool		amoptionalkey;	/* can query omit key for the first column? */
+	bool		amcanskip;		/* can AM skip over leading-column values? */
 	bool		amsearcharray;	/* can AM handle ScalarArrayOpExpr quals? */
 	bool		amsearchnulls;	/* can AM search for NULL/NOT NULL entries? */
 	bool		amhasgettuple;	/* does AM have amgettuple interface? */
@@ -780,6 +781,10 @@ typedef struct Path
  * NoMovementScanDirection for an indexscan, but the planner wants to
  * distinguish ordered from unordered indexes for building pathkeys.)
  *
+ * 'indexskipscan' is true if the index AM should skip over distinct values
+ * of the first index column, which the indexquals don't constrain.  This
+ * doesn't change the ordering of the scan output.
+ *
  * 'indextotalcost' and 'indexselectivity' are saved in the IndexPath so that
  * we need not recompute them when considering using the same index in a
  * bitmap index/heap scan (see BitmapHeapPath).  The costs of the IndexPath
@@ -796,6 +801,7 @@ typedef struct IndexPath
 	List	   *indexorderbys;
 	List	   *indexorderbycols;
 	ScanDirection indexscandir;
+	bool		indexskipscan;
 	Cost		indextotalcost;
 	Selectivity indexselectivity;
 } IndexPath;
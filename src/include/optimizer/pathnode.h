@@ -40,6 +40,7 @@ extern IndexPath *create_index_path(PlannerInfo *root,
 				  List *indexorderbycols,
 				  List *pathkeys,
 				  ScanDirection indexscandir,
+				  bool indexskipscan,
 				  bool indexonly,
 				  Relids required_outer,
 				  double loop_count);
@@ -142,6 +143,13 @@ extern RelOptInfo *build_join_rel(PlannerInfo *root,
 			   RelOptInfo *inner_rel,
 			   SpecialJoinInfo *sjinfo,
 			   List **restrictlist_ptr);
+extern RelOptInfo *build_child_join_rel(PlannerInfo *root,
+					 RelOptInfo *parent_joinrel,
+					 RelOptInfo *outer_rel,
+					 RelOptInfo *inner_rel,
+					 SpecialJoinInfo *sjinfo,
+					 List *restrictlist,
+					 List **restrictlist_ptr);
 extern RelOptInfo *build_empty_join_rel(PlannerInfo *root);
 extern AppendRelInfo *find_childrel_appendrelinfo(PlannerInfo *root,
 							RelOptInfo *rel);
@@ -15,6 +15,7 @@
 #define PARSE_UTILCMD_H
 
 #include "parser/parse_node.h"
+#include "utils/relcache.h"
 
 
 extern List *transformCreateStmt(CreateStmt *stmt, const char *queryString);
@@ -25,5 +26,7 @@ extern IndexStmt *transformIndexStmt(Oid relid, IndexStmt *stmt,
 extern void transformRuleStmt(RuleStmt *stmt, const char *queryString,
 				  List **actions, Node **whereClause);
 extern List *transformCreateSchemaStmt(CreateSchemaStmt *stmt);
+extern PartitionBoundSpec *transformPartitionBound(ParseState *pstate,
+						Relation parent, PartitionBoundSpec *spec);
 
 #endif   /* PARSE_UTILCMD_H */
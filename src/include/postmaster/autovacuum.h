@@ -14,6 +14,7 @@
 #ifndef AUTOVACUUM_H
 #define AUTOVACUUM_H
 
+#include "fmgr.h"
 
 /* GUC variables */
 extern bool autovacuum_start_daemon;
@@ -64,4 +65,6 @@ extern void AutovacuumLauncherIAm(void);
 extern Size AutoVacuumShmemSize(void);
 extern void AutoVacuumShmemInit(void);
 
+extern Datum pg_stat_get_autovacuum_queue(PG_FUNCTION_ARGS);
+
 #endif   /* AUTOVACUUM_H */
@@ -20,6 +20,33 @@
 #define MAX_RATE_LOWER  32
 #define MAX_RATE_UPPER  1048576
 
+/*
+ * File listing all files in the backup with their sizes and CRCs, sent at
+ * the end of the main tar stream with the MANIFEST option.
+ */
+#define BACKUP_MANIFEST_FILE	"backup_manifest"
+
+/*
+ * In an incremental backup (BASE_BACKUP INCREMENTAL), a segment of a
+ * relation's main fork in which only some blocks have changed is sent as
+ * "<segment>.incr" instead.  It holds this header, then the numbers of the
+ * blocks included (nchanged BlockNumbers, ascending), then those blocks.
+ * nblocks is the length of the segment in blocks; every block not included
+ * must be present in the prior backup.  All fields are in the server's byte
+ * order, like the relation files themselves.
+ */
+#define INCREMENTAL_FILE_SUFFIX ".incr"
+#define INCREMENTAL_MAGIC		0xd3ae1f0d
+
+typedef struct IncrementalFileHeader
+{
+	uint32		magic;			/* INCREMENTAL_MAGIC */
+	uint32		nblocks;		/* length of the segment, in blocks */
+	uint32		nchanged;		/* number of blocks included */
+	uint32		fromlsn_hi;		/* blocks with a newer page LSN were */
+	uint32		fromlsn_lo;		/* included: high and low halves */
+} IncrementalFileHeader;
+
 
 extern void SendBaseBackup(BaseBackupCmd *cmd);
 
@@ -45,6 +45,13 @@ typedef struct LogicalDecodingContext
 	 */
 	List	   *output_plugin_options;
 
+	/*
+	 * Send large transactions to the output plugin's stream callbacks while
+	 * they are still in progress?  Set if the plugin provides them; its
+	 * startup callback may turn it off again.
+	 */
+	bool		streaming;
+
 	/*
 	 * User-Provided callback for writing/streaming out data.
 	 */
@@ -97,4 +104,6 @@ extern void LogicalIncreaseRestartDecodingForSlot(XLogRecPtr current_lsn,
 												   XLogRecPtr restart_lsn);
 extern void LogicalConfirmReceivedLocation(XLogRecPtr lsn);
 
+extern void UpdateDecodingStats(LogicalDecodingContext *ctx);
+
 #endif
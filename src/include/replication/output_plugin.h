@@ -73,6 +73,50 @@ typedef void (*LogicalDecodeCommitCB) (
 												   ReorderBufferTXN *txn,
 												   XLogRecPtr commit_lsn);
 
+/*
+ * Called when starting to send a block of changes of a transaction that is
+ * still in progress.  A transaction may be streamed in several blocks.
+ */
+typedef void (*LogicalDecodeStreamStartCB) (
+											 struct LogicalDecodingContext *,
+													   ReorderBufferTXN *txn);
+
+/*
+ * Called after the last change of a streamed block has been sent.
+ */
+typedef void (*LogicalDecodeStreamStopCB) (
+											 struct LogicalDecodingContext *,
+													   ReorderBufferTXN *txn);
+
+/*
+ * Callback for every individual change of a streamed block.  txn is the
+ * toplevel transaction; change->txn is the (sub)transaction that made it.
+ */
+typedef void (*LogicalDecodeStreamChangeCB) (
+											 struct LogicalDecodingContext *,
+														 ReorderBufferTXN *txn,
+														 Relation relation,
+												 ReorderBufferChange *change
+);
+
+/*
+ * Called when a streamed transaction, or a subtransaction of it, has been
+ * rolled back.  Changes of txn already streamed have to be discarded.
+ */
+typedef void (*LogicalDecodeStreamAbortCB) (
+											 struct LogicalDecodingContext *,
+														ReorderBufferTXN *txn,
+													  XLogRecPtr abort_lsn);
+
+/*
+ * Called when a streamed transaction has committed, after all of its
+ * remaining changes have been streamed.
+ */
+typedef void (*LogicalDecodeStreamCommitCB) (
+											 struct LogicalDecodingContext *,
+														 ReorderBufferTXN *txn,
+													 XLogRecPtr commit_lsn);
+
 /*
  * Called to shutdown an output plugin.
  */
@@ -90,6 +134,12 @@ typedef struct OutputPluginCallbacks
 	LogicalDecodeChangeCB change_cb;
 	LogicalDecodeCommitCB commit_cb;
 	LogicalDecodeShutdownCB shutdown_cb;
+	/* streaming of in-progress transactions, optional */
+	LogicalDecodeStreamStartCB stream_start_cb;
+	LogicalDecodeStreamStopCB stream_stop_cb;
+	LogicalDecodeStreamChangeCB stream_change_cb;
+	LogicalDecodeStreamAbortCB stream_abort_cb;
+	LogicalDecodeStreamCommitCB stream_commit_cb;
 } OutputPluginCallbacks;
 
 void OutputPluginPrepareWrite(struct LogicalDecodingContext *ctx, bool last_write);
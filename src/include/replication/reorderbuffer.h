@@ -23,15 +23,17 @@
 /* an individual tuple, stored in one chunk of memory */
 typedef struct ReorderBufferTupleBuf
 {
-	/* position in preallocated list */
-	slist_node	node;
-
-	/* tuple, stored sequentially */
+	/* tuple header, the interesting bit for users of logical decoding */
 	HeapTupleData tuple;
-	HeapTupleHeaderData header;
-	char		data[MaxHeapTupleSize];
+	/* space allocated for the tuple data following this struct */
+	Size		alloc_tuple_size;
+	/* actual tuple data follows */
 } ReorderBufferTupleBuf;
 
+/* pointer to the data stored in a TupleBuf */
+#define ReorderBufferTupleBufData(p) \
+	((HeapTupleHeader) MAXALIGN(((char *) p) + sizeof(ReorderBufferTupleBuf)))
+
 /*
  * Types of the change passed to a 'change' callback.
  *
@@ -64,6 +66,9 @@ typedef struct ReorderBufferChange
 	/* The type of change. */
 	enum ReorderBufferChangeType action;
 
+	/* Transaction this change belongs to. */
+	struct ReorderBufferTXN *txn;
+
 	/*
 	 * Context data for the change, which part of the union is valid depends
 	 * on action/action_internal.
@@ -122,9 +127,20 @@ typedef struct ReorderBufferTXN
 	bool		has_catalog_changes;
 
 	/*
-	 * Do we know this is a subxact?
+	 * Do we know this is a subxact?  If so, toptxn is the toplevel
+	 * transaction it belongs to.
 	 */
 	bool		is_known_as_subxact;
+	struct ReorderBufferTXN *toptxn;
+
+	/*
+	 * Have (some of) this transaction's changes been sent to the output
+	 * plugin's stream callbacks before it finished?
+	 */
+	bool		streamed;
+
+	/* have changes of this transaction been spilled to disk? */
+	bool		serialized;
 
 	/*
 	 * LSN of the first data carrying, WAL record with knowledge about this
@@ -169,6 +185,13 @@ typedef struct ReorderBufferTXN
 	Snapshot	base_snapshot;
 	XLogRecPtr	base_snapshot_lsn;
 
+	/*
+	 * Snapshot and CommandId the last streamed block of changes ended with,
+	 * to continue decoding from there.  Only used in toplevel transactions.
+	 */
+	Snapshot	snapshot_now;
+	CommandId	command_id;
+
 	/*
 	 * How many ReorderBufferChange's do we have in this txn.
 	 *
@@ -182,6 +205,12 @@ typedef struct ReorderBufferTXN
 	 */
 	uint64		nentries_mem;
 
+	/*
+	 * Memory used by the in-memory changes of this (sub)transaction, in
+	 * bytes. Changes of subtransactions are accounted in the subtransaction.
+	 */
+	Size		size;
+
 	/*
 	 * List of ReorderBufferChange structs, including new Snapshots and new
 	 * CommandIds
@@ -253,6 +282,30 @@ typedef void (*ReorderBufferCommitCB) (
 												   ReorderBufferTXN *txn,
 												   XLogRecPtr commit_lsn);
 
+/* start streaming a block of changes, signature */
+typedef void (*ReorderBufferStreamStartCB) (
+														ReorderBuffer *rb,
+														ReorderBufferTXN *txn,
+													  XLogRecPtr first_lsn);
+
+/* stop streaming a block of changes, signature */
+typedef void (*ReorderBufferStreamStopCB) (
+													   ReorderBuffer *rb,
+													   ReorderBufferTXN *txn,
+													   XLogRecPtr last_lsn);
+
+/* abort of a streamed (sub)transaction, signature */
+typedef void (*ReorderBufferStreamAbortCB) (
+														ReorderBuffer *rb,
+														ReorderBufferTXN *txn,
+													  XLogRecPtr abort_lsn);
+
+/* commit of a streamed transaction, signature */
+typedef void (*ReorderBufferStreamCommitCB) (
+														 ReorderBuffer *rb,
+													   ReorderBufferTXN *txn,
+													 XLogRecPtr commit_lsn);
+
 struct ReorderBuffer
 {
 	/*
@@ -280,6 +333,15 @@ struct ReorderBuffer
 	ReorderBufferApplyChangeCB apply_change;
 	ReorderBufferCommitCB commit;
 
+	/*
+	 * Callbacks to be called for transactions streamed while in progress.
+	 */
+	ReorderBufferStreamStartCB stream_start;
+	ReorderBufferStreamStopCB stream_stop;
+	ReorderBufferApplyChangeCB stream_change;
+	ReorderBufferStreamAbortCB stream_abort;
+	ReorderBufferStreamCommitCB stream_commit;
+
 	/*
 	 * Pointer that will be passed untouched to the callbacks.
 	 */
@@ -291,39 +353,43 @@ struct ReorderBuffer
 	MemoryContext context;
 
 	/*
-	 * Data structure slab cache.
-	 *
-	 * We allocate/deallocate some structures very frequently, to avoid bigger
-	 * overhead we cache some unused ones here.
-	 *
-	 * The maximum number of cached entries is controlled by const variables
-	 * ontop of reorderbuffer.c
+	 * Memory contexts for specific types of objects, children of context.
+	 * Changes and transactions live in slab contexts, tuples in a generation
+	 * context.
 	 */
-
-	/* cached ReorderBufferTXNs */
-	dlist_head	cached_transactions;
-	Size		nr_cached_transactions;
-
-	/* cached ReorderBufferChanges */
-	dlist_head	cached_changes;
-	Size		nr_cached_changes;
-
-	/* cached ReorderBufferTupleBufs */
-	slist_head	cached_tuplebufs;
-	Size		nr_cached_tuplebufs;
+	MemoryContext change_context;
+	MemoryContext txn_context;
+	MemoryContext tup_context;
 
 	XLogRecPtr	current_restart_decoding_lsn;
 
 	/* buffer for disk<->memory conversions */
 	char	   *outbuf;
 	Size		outbufsize;
+
+	/* memory used by in-memory changes of all transactions, in bytes */
+	Size		size;
+
+	/*
+	 * Statistics about transactions spilled to disk or streamed since they
+	 * were last reported to the replication slot.
+	 */
+	int64		spill_txns;		/* transactions spilled at least once */
+	int64		spill_count;	/* times transactions were spilled */
+	int64		spill_bytes;	/* amount of decoded data spilled */
+	int64		stream_txns;	/* transactions streamed at least once */
+	int64		stream_count;	/* times transactions were streamed */
+	int64		stream_bytes;	/* amount of decoded data streamed */
 };
 
+/* GUC: memory limit for decoded changes kept in memory, in kB */
+extern PGDLLIMPORT int logical_decoding_work_mem;
+
 
 ReorderBuffer *ReorderBufferAllocate(void);
 void		ReorderBufferFree(ReorderBuffer *);
 
-ReorderBufferTupleBuf *ReorderBufferGetTupleBuf(ReorderBuffer *);
+ReorderBufferTupleBuf *ReorderBufferGetTupleBuf(ReorderBuffer *, Size tuple_len);
 void		ReorderBufferReturnTupleBuf(ReorderBuffer *, ReorderBufferTupleBuf *tuple);
 ReorderBufferChange *ReorderBufferGetChange(ReorderBuffer *);
 void		ReorderBufferReturnChange(ReorderBuffer *, ReorderBufferChange *);
@@ -336,7 +402,7 @@ void		ReorderBufferAssignChild(ReorderBuffer *, TransactionId, TransactionId, XL
 void		ReorderBufferCommitChild(ReorderBuffer *, TransactionId, TransactionId,
 									 XLogRecPtr commit_lsn, XLogRecPtr end_lsn);
 void		ReorderBufferAbort(ReorderBuffer *, TransactionId, XLogRecPtr lsn);
-void		ReorderBufferAbortOld(ReorderBuffer *, TransactionId xid);
+void		ReorderBufferAbortOld(ReorderBuffer *, TransactionId xid, XLogRecPtr lsn);
 void		ReorderBufferForget(ReorderBuffer *, TransactionId, XLogRecPtr lsn);
 
 void		ReorderBufferSetBaseSnapshot(ReorderBuffer *, TransactionId, XLogRecPtr lsn, struct SnapshotData *snap);
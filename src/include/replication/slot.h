@@ -123,6 +123,18 @@ typedef struct ReplicationSlot
 	XLogRecPtr	candidate_xmin_lsn;
 	XLogRecPtr	candidate_restart_valid;
 	XLogRecPtr	candidate_restart_lsn;
+
+	/*
+	 * Statistics about transactions decoded via this slot that had to be
+	 * spilled to disk or were streamed, protected by mutex. Not persistent;
+	 * they start at zero when the slot is created or loaded at startup.
+	 */
+	int64		spill_txns;
+	int64		spill_count;
+	int64		spill_bytes;
+	int64		stream_txns;
+	int64		stream_count;
+	int64		stream_bytes;
 } ReplicationSlot;
 
 /*
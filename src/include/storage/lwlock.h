@@ -100,8 +100,7 @@ extern PGDLLIMPORT LWLockPadded *MainLWLockArray;
 #define WALWriteLock				(&MainLWLockArray[8].lock)
 #define ControlFileLock				(&MainLWLockArray[9].lock)
 #define CheckpointLock				(&MainLWLockArray[10].lock)
-#define CLogControlLock				(&MainLWLockArray[11].lock)
-#define SubtransControlLock			(&MainLWLockArray[12].lock)
+/* 11 and 12 were the CLOG and SUBTRANS control locks; see slru.c */
 #define MultiXactGenLock			(&MainLWLockArray[13].lock)
 #define MultiXactOffsetControlLock	(&MainLWLockArray[14].lock)
 #define MultiXactMemberControlLock	(&MainLWLockArray[15].lock)
@@ -138,22 +137,33 @@ extern PGDLLIMPORT LWLockPadded *MainLWLockArray;
 /* Number of partitions of the shared buffer mapping hashtable */
 #define NUM_BUFFER_PARTITIONS  16
 
-/* Number of partitions the shared lock tables are divided into */
-#define LOG2_NUM_LOCK_PARTITIONS  4
-#define NUM_LOCK_PARTITIONS  (1 << LOG2_NUM_LOCK_PARTITIONS)
+/*
+ * Number of partitions the shared lock tables are divided into.  This is set
+ * by the lock_manager_partitions GUC, and must be a power of 2 no greater
+ * than MAX_LOCK_PARTITIONS.
+ */
+extern PGDLLIMPORT int NumLockPartitions;
+extern PGDLLIMPORT int Log2NumLockPartitions;
+
+#define LOG2_NUM_LOCK_PARTITIONS  Log2NumLockPartitions
+#define NUM_LOCK_PARTITIONS  NumLockPartitions
+#define MAX_LOCK_PARTITIONS  256
 
 /* Number of partitions the shared predicate lock tables are divided into */
 #define LOG2_NUM_PREDICATELOCK_PARTITIONS  4
 #define NUM_PREDICATELOCK_PARTITIONS  (1 << LOG2_NUM_PREDICATELOCK_PARTITIONS)
 
-/* Offsets for various chunks of preallocated lwlocks. */
+/*
+ * Offsets for various chunks of preallocated lwlocks.  The lock manager's
+ * come last, since their number is only known at runtime.
+ */
 #define BUFFER_MAPPING_LWLOCK_OFFSET	NUM_INDIVIDUAL_LWLOCKS
-#define LOCK_MANAGER_LWLOCK_OFFSET		\
-	(BUFFER_MAPPING_LWLOCK_OFFSET + NUM_BUFFER_PARTITIONS)
 #define PREDICATELOCK_MANAGER_LWLOCK_OFFSET	\
-	(NUM_INDIVIDUAL_LWLOCKS + NUM_LOCK_PARTITIONS)
-#define NUM_FIXED_LWLOCKS \
+	(BUFFER_MAPPING_LWLOCK_OFFSET + NUM_BUFFER_PARTITIONS)
+#define LOCK_MANAGER_LWLOCK_OFFSET		\
 	(PREDICATELOCK_MANAGER_LWLOCK_OFFSET + NUM_PREDICATELOCK_PARTITIONS)
+#define NUM_FIXED_LWLOCKS \
+	(LOCK_MANAGER_LWLOCK_OFFSET + NUM_LOCK_PARTITIONS)
 
 typedef enum LWLockMode
 {
@@ -49,12 +49,19 @@ struct XidCache
 	(PROC_IN_VACUUM | PROC_IN_ANALYZE | PROC_VACUUM_FOR_WRAPAROUND)
 
 /*
- * We allow a small number of "weak" relation locks (AccesShareLock,
- * RowShareLock, RowExclusiveLock) to be recorded in the PGPROC structure
- * rather than the main lock table.  This eases contention on the lock
- * manager LWLocks.  See storage/lmgr/README for additional details.
+ * We allow a number of "weak" relation locks (AccesShareLock, RowShareLock,
+ * RowExclusiveLock) to be recorded in the PGPROC structure rather than the
+ * main lock table.  This eases contention on the lock manager LWLocks.  The
+ * slots are divided into groups of FP_LOCK_SLOTS_PER_GROUP, and the number of
+ * groups is derived from max_locks_per_transaction at startup.  See
+ * storage/lmgr/README for additional details.
  */
-#define		FP_LOCK_SLOTS_PER_BACKEND 16
+extern PGDLLIMPORT int FastPathLockGroupsPerBackend;
+
+#define		FP_LOCK_GROUPS_PER_BACKEND_MAX	1024
+#define		FP_LOCK_SLOTS_PER_GROUP		16	/* don't change */
+#define		FastPathLockSlotsPerBackend() \
+	(FP_LOCK_SLOTS_PER_GROUP * FastPathLockGroupsPerBackend)
 
 /*
  * Each backend has a PGPROC struct in shared memory.  There is also a list of
@@ -128,7 +135,7 @@ struct PGPROC
 	 * linked into one of these lists, according to the partition number of
 	 * their lock.
 	 */
-	SHM_QUEUE	myProcLocks[NUM_LOCK_PARTITIONS];
+	SHM_QUEUE  *myProcLocks;	/* NUM_LOCK_PARTITIONS entries */
 
 	struct XidCache subxids;	/* cache for subtransaction XIDs */
 
@@ -136,8 +143,9 @@ struct PGPROC
 	LWLock	   *backendLock;	/* protects the fields below */
 
 	/* Lock manager data, recording fast-path locks taken by this backend. */
-	uint64		fpLockBits;		/* lock modes held for each fast-path slot */
-	Oid			fpRelId[FP_LOCK_SLOTS_PER_BACKEND];		/* slots for rel oids */
+	uint64	   *fpLockBits;		/* lock modes held for each fast-path slot,
+								 * one uint64 per group */
+	Oid		   *fpRelId;		/* slots for rel oids */
 	bool		fpVXIDLock;		/* are we holding a fast-path VXID lock? */
 	LocalTransactionId fpLocalTransactionId;	/* lxid for fast-path VXID
 												 * lock */
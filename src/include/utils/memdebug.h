@@ -3,8 +3,10 @@
  * memdebug.h
  *	  Memory debugging support.
  *
- * Currently, this file either wraps <valgrind/memcheck.h> or substitutes
- * empty definitions for Valgrind client request macros we use.
+ * This file either wraps <valgrind/memcheck.h> or substitutes empty
+ * definitions for Valgrind client request macros we use.  It also declares
+ * the debugging helpers in memdebug.c that memory context implementations
+ * share.
  *
  *
  * Portions Copyright (c) 1996-2014, PostgreSQL Global Development Group
@@ -31,4 +33,17 @@
 #define VALGRIND_MEMPOOL_CHANGE(context, optr, nptr, size)	do {} while (0)
 #endif
 
+#ifdef CLOBBER_FREED_MEMORY
+extern void wipe_mem(void *ptr, size_t size);
+#endif
+
+#ifdef MEMORY_CONTEXT_CHECKING
+extern void set_sentinel(void *base, Size offset);
+extern bool sentinel_ok(const void *base, Size offset);
+#endif
+
+#ifdef RANDOMIZE_ALLOCATED_MEMORY
+extern void randomize_mem(char *ptr, size_t size);
+#endif
+
 #endif   /* MEMDEBUG_H */
@@ -172,6 +172,23 @@ typedef struct RelationData
 	/* use "struct" here to avoid needing to include fdwapi.h: */
 	struct FdwRoutine *rd_fdwroutine;	/* cached function pointers, or NULL */
 
+	/*
+	 * partitioning support, see catalog/partition.c
+	 *
+	 * These are built on first use, each in its own memory context, and are
+	 * simply thrown away by a relcache reset.  rd_partkey and rd_partdesc are
+	 * NULL for a table that isn't partitioned; rd_partcheck is NIL for one
+	 * that isn't a partition.
+	 */
+	/* use "struct" here to avoid needing to include partition.h: */
+	struct PartitionKeyData *rd_partkey;	/* partition key, or NULL */
+	MemoryContext rd_partkeycxt;	/* private memory cxt for rd_partkey */
+	struct PartitionDescData *rd_partdesc;	/* partitions, or NULL */
+	MemoryContext rd_pdcxt;		/* private memory cxt for rd_partdesc */
+	List	   *rd_partcheck;	/* partition constraint, as implicit-AND */
+	MemoryContext rd_partcheckcxt;	/* private memory cxt for rd_partcheck */
+	bool		rd_partcheckvalid;	/* is rd_partcheck valid? */
+
 	/*
 	 * Hack for CLUSTER, rewriting ALTER TABLE, etc: when writing a new
 	 * version of a table, we need to make any toast pointers inserted into it
@@ -2894,6 +2894,8 @@ closePGconn(PGconn *conn)
 										 * absent */
 	conn->asyncStatus = PGASYNC_IDLE;
 	pqClearAsyncResult(conn);	/* deallocate result */
+	pqCommandQueueClear(conn);	/* forget about any pipelined commands */
+	conn->pipelineStatus = PQ_PIPELINE_OFF;
 	pg_freeaddrinfo_all(conn->addrlist_family, conn->addrlist);
 	conn->addrlist = NULL;
 	conn->addr_cur = NULL;
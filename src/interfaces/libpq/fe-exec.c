@@ -39,9 +39,18 @@ char	   *const pgresStatus[] = {
 	"PGRES_NONFATAL_ERROR",
 	"PGRES_FATAL_ERROR",
 	"PGRES_COPY_BOTH",
-	"PGRES_SINGLE_TUPLE"
+	"PGRES_SINGLE_TUPLE",
+	"PGRES_PIPELINE_SYNC",
+	"PGRES_PIPELINE_ABORTED"
 };
 
+/*
+ * In pipeline mode, we don't push each command to the server as soon as it's
+ * queued, but wait until this much data has accumulated in the output buffer
+ * (or the application asks for a sync or flush).
+ */
+#define OUTBUFFER_THRESHOLD		65536
+
 /*
  * static state needed by PQescapeString and PQescapeBytea; initialize to
  * values that result in backward-compatible behavior
@@ -68,6 +77,13 @@ static bool PQexecStart(PGconn *conn);
 static PGresult *PQexecFinish(PGconn *conn);
 static int PQsendDescribe(PGconn *conn, char desc_type,
 			   const char *desc_target);
+static PGcmdQueueEntry *pqAllocCmdQueueEntry(PGconn *conn);
+static void pqFreeCmdQueueEntry(PGcmdQueueEntry *entry);
+static bool pqFinishSend(PGconn *conn, PGcmdQueueEntry *entry,
+			 PGQueryClass queryclass, const char *query);
+static void pqAppendCmdQueueEntry(PGconn *conn, PGcmdQueueEntry *entry);
+static void pqCommandQueueAdvance(PGconn *conn);
+static void pqPipelineProcessQueue(PGconn *conn);
 static int	check_field_number(const PGresult *res, int field_num);
 
 
@@ -1122,6 +1138,21 @@ PQsendQuery(PGconn *conn, const char *query)
 		return 0;
 	}
 
+	/*
+	 * In pipeline mode, use the extended query protocol instead, since the
+	 * server ends a pipeline segment after each simple Query message.
+	 */
+	if (conn->pipelineStatus != PQ_PIPELINE_OFF)
+		return PQsendQueryGuts(conn,
+							   query,
+							   "",	/* use unnamed statement */
+							   0,
+							   NULL,
+							   NULL,
+							   NULL,
+							   NULL,
+							   0);
+
 	/* construct the outgoing Query message */
 	if (pqPutMsgStart('Q', false, conn) < 0 ||
 		pqPuts(query, conn) < 0 ||
@@ -1209,6 +1240,8 @@ PQsendPrepare(PGconn *conn,
 			  const char *stmtName, const char *query,
 			  int nParams, const Oid *paramTypes)
 {
+	PGcmdQueueEntry *entry = NULL;
+
 	if (!PQsendQueryStart(conn))
 		return 0;
 
@@ -1240,6 +1273,14 @@ PQsendPrepare(PGconn *conn,
 		return 0;
 	}
 
+	/* In pipeline mode, allocate the queue entry before sending anything */
+	if (conn->pipelineStatus != PQ_PIPELINE_OFF)
+	{
+		entry = pqAllocCmdQueueEntry(conn);
+		if (entry == NULL)
+			return 0;
+	}
+
 	/* construct the Parse message */
 	if (pqPutMsgStart('P', false, conn) < 0 ||
 		pqPuts(stmtName, conn) < 0 ||
@@ -1266,32 +1307,21 @@ PQsendPrepare(PGconn *conn,
 	if (pqPutMsgEnd(conn) < 0)
 		goto sendFailed;
 
-	/* construct the Sync message */
-	if (pqPutMsgStart('S', false, conn) < 0 ||
-		pqPutMsgEnd(conn) < 0)
-		goto sendFailed;
-
-	/* remember we are doing just a Parse */
-	conn->queryclass = PGQUERY_PREPARE;
-
-	/* and remember the query text too, if possible */
-	/* if insufficient memory, last_query just winds up NULL */
-	if (conn->last_query)
-		free(conn->last_query);
-	conn->last_query = strdup(query);
+	/* construct the Sync message, unless the application will do that */
+	if (conn->pipelineStatus == PQ_PIPELINE_OFF)
+	{
+		if (pqPutMsgStart('S', false, conn) < 0 ||
+			pqPutMsgEnd(conn) < 0)
+			goto sendFailed;
+	}
 
-	/*
-	 * Give the data a push.  In nonblock mode, don't complain if we're unable
-	 * to send it all; PQgetResult() will do any additional flushing needed.
-	 */
-	if (pqFlush(conn) < 0)
+	/* remember we are doing just a Parse, and send it off */
+	if (!pqFinishSend(conn, entry, PGQUERY_PREPARE, query))
 		goto sendFailed;
-
-	/* OK, it's launched! */
-	conn->asyncStatus = PGASYNC_BUSY;
 	return 1;
 
 sendFailed:
+	pqFreeCmdQueueEntry(entry);
 	pqHandleSendFailure(conn);
 	return 0;
 }
@@ -1357,6 +1387,25 @@ PQsendQueryStart(PGconn *conn)
 						  libpq_gettext("no connection to the server\n"));
 		return false;
 	}
+
+	if (conn->pipelineStatus != PQ_PIPELINE_OFF)
+	{
+		/*
+		 * In pipeline mode, the command is queued behind those already sent,
+		 * and the connection state is left alone until we get to processing
+		 * its results.  We can queue behind anything but a COPY, though.
+		 */
+		if (conn->asyncStatus == PGASYNC_COPY_IN ||
+			conn->asyncStatus == PGASYNC_COPY_OUT ||
+			conn->asyncStatus == PGASYNC_COPY_BOTH)
+		{
+			printfPQExpBuffer(&conn->errorMessage,
+					   libpq_gettext("cannot queue commands during COPY\n"));
+			return false;
+		}
+		return true;
+	}
+
 	/* Can't send while already busy, either. */
 	if (conn->asyncStatus != PGASYNC_IDLE)
 	{
@@ -1394,6 +1443,7 @@ PQsendQueryGuts(PGconn *conn,
 				const int *paramFormats,
 				int resultFormat)
 {
+	PGcmdQueueEntry *entry = NULL;
 	int			i;
 
 	/* This isn't gonna work on a 2.0 server */
@@ -1404,9 +1454,18 @@ PQsendQueryGuts(PGconn *conn,
 		return 0;
 	}
 
+	/* In pipeline mode, allocate the queue entry before sending anything */
+	if (conn->pipelineStatus != PQ_PIPELINE_OFF)
+	{
+		entry = pqAllocCmdQueueEntry(conn);
+		if (entry == NULL)
+			return 0;
+	}
+
 	/*
 	 * We will send Parse (if needed), Bind, Describe Portal, Execute, Sync,
-	 * using specified statement name and the unnamed portal.
+	 * using specified statement name and the unnamed portal.  In pipeline
+	 * mode, the Sync is left to PQpipelineSync.
 	 */
 
 	if (command)
@@ -1516,39 +1575,260 @@ PQsendQueryGuts(PGconn *conn,
 		pqPutMsgEnd(conn) < 0)
 		goto sendFailed;
 
-	/* construct the Sync message */
-	if (pqPutMsgStart('S', false, conn) < 0 ||
-		pqPutMsgEnd(conn) < 0)
-		goto sendFailed;
-
-	/* remember we are using extended query protocol */
-	conn->queryclass = PGQUERY_EXTENDED;
-
-	/* and remember the query text too, if possible */
-	/* if insufficient memory, last_query just winds up NULL */
-	if (conn->last_query)
-		free(conn->last_query);
-	if (command)
-		conn->last_query = strdup(command);
-	else
-		conn->last_query = NULL;
+	/* construct the Sync message, unless the application will do that */
+	if (conn->pipelineStatus == PQ_PIPELINE_OFF)
+	{
+		if (pqPutMsgStart('S', false, conn) < 0 ||
+			pqPutMsgEnd(conn) < 0)
+			goto sendFailed;
+	}
 
-	/*
-	 * Give the data a push.  In nonblock mode, don't complain if we're unable
-	 * to send it all; PQgetResult() will do any additional flushing needed.
-	 */
-	if (pqFlush(conn) < 0)
+	/* remember we are using extended query protocol, and send it off */
+	if (!pqFinishSend(conn, entry, PGQUERY_EXTENDED, command))
 		goto sendFailed;
-
-	/* OK, it's launched! */
-	conn->asyncStatus = PGASYNC_BUSY;
 	return 1;
 
 sendFailed:
+	pqFreeCmdQueueEntry(entry);
 	pqHandleSendFailure(conn);
 	return 0;
 }
 
+/*
+ * pqAllocCmdQueueEntry
+ *		Allocate an entry for the pipeline-mode command queue
+ *
+ * Returns NULL if out of memory, with conn->errorMessage set.
+ */
+static PGcmdQueueEntry *
+pqAllocCmdQueueEntry(PGconn *conn)
+{
+	PGcmdQueueEntry *entry;
+
+	entry = (PGcmdQueueEntry *) malloc(sizeof(PGcmdQueueEntry));
+	if (entry == NULL)
+	{
+		printfPQExpBuffer(&conn->errorMessage,
+						  libpq_gettext("out of memory\n"));
+		return NULL;
+	}
+	entry->queryclass = PGQUERY_SIMPLE;
+	entry->query = NULL;
+	entry->next = NULL;
+
+	return entry;
+}
+
+/*
+ * pqFreeCmdQueueEntry
+ *		Release a command queue entry; NULL is allowed
+ */
+static void
+pqFreeCmdQueueEntry(PGcmdQueueEntry *entry)
+{
+	if (entry == NULL)
+		return;
+	if (entry->query)
+		free(entry->query);
+	free(entry);
+}
+
+/*
+ * pqFinishSend
+ *		Common code to finish sending a command
+ *
+ * We remember the command's class and text, which we need to interpret its
+ * results, and give the data a push.  Outside pipeline mode entry is NULL,
+ * and the command becomes the current one right away; in pipeline mode it's
+ * queued behind the commands whose results are still to be read.
+ *
+ * Returns false if sending failed; the caller still owns entry then.
+ */
+static bool
+pqFinishSend(PGconn *conn, PGcmdQueueEntry *entry,
+			 PGQueryClass queryclass, const char *query)
+{
+	if (entry == NULL)
+	{
+		conn->queryclass = queryclass;
+
+		/* and remember the query text too, if possible */
+		/* if insufficient memory, last_query just winds up NULL */
+		if (conn->last_query)
+			free(conn->last_query);
+		conn->last_query = query ? strdup(query) : NULL;
+
+		/*
+		 * Give the data a push.  In nonblock mode, don't complain if we're
+		 * unable to send it all; PQgetResult() will do any additional
+		 * flushing needed.
+		 */
+		if (pqFlush(conn) < 0)
+			return false;
+
+		/* OK, it's launched! */
+		conn->asyncStatus = PGASYNC_BUSY;
+	}
+	else
+	{
+		entry->queryclass = queryclass;
+		entry->query = query ? strdup(query) : NULL;
+
+		/* Push the data only once there's a fair amount of it */
+		if (conn->outCount >= OUTBUFFER_THRESHOLD && pqFlush(conn) < 0)
+			return false;
+
+		pqAppendCmdQueueEntry(conn, entry);
+	}
+
+	return true;
+}
+
+/*
+ * pqAppendCmdQueueEntry
+ *		Add a command that has been sent in pipeline mode to the queue
+ */
+static void
+pqAppendCmdQueueEntry(PGconn *conn, PGcmdQueueEntry *entry)
+{
+	entry->next = NULL;
+	if (conn->cmd_queue_tail != NULL)
+		conn->cmd_queue_tail->next = entry;
+	else
+	{
+		/* The queue was empty, so the new command is now the current one */
+		conn->cmd_queue_head = entry;
+		conn->queryclass = entry->queryclass;
+		if (conn->last_query)
+			free(conn->last_query);
+		conn->last_query = entry->query;
+		entry->query = NULL;
+	}
+	conn->cmd_queue_tail = entry;
+
+	if (conn->pipelineStatus == PQ_PIPELINE_ABORTED)
+	{
+		/*
+		 * The server won't send anything for this command, except for a
+		 * Sync.  If we were idle, let the queue processing generate its
+		 * result.
+		 */
+		if (conn->asyncStatus == PGASYNC_IDLE)
+			pqPipelineProcessQueue(conn);
+	}
+	else
+	{
+		/*
+		 * If we were idle, we now expect something to arrive from the
+		 * server.  In any other state, the new command's results will be
+		 * processed when we get to it.
+		 */
+		if (conn->asyncStatus == PGASYNC_IDLE)
+			conn->asyncStatus = PGASYNC_BUSY;
+	}
+}
+
+/*
+ * pqCommandQueueAdvance
+ *		Remove the current command from the queue, once all its results
+ *		have been received, and make the next one current
+ */
+static void
+pqCommandQueueAdvance(PGconn *conn)
+{
+	PGcmdQueueEntry *prev = conn->cmd_queue_head;
+
+	if (prev == NULL)
+		return;
+
+	conn->cmd_queue_head = prev->next;
+	if (conn->cmd_queue_head == NULL)
+		conn->cmd_queue_tail = NULL;
+	else
+	{
+		conn->queryclass = conn->cmd_queue_head->queryclass;
+		if (conn->last_query)
+			free(conn->last_query);
+		conn->last_query = conn->cmd_queue_head->query;
+		conn->cmd_queue_head->query = NULL;
+	}
+
+	pqFreeCmdQueueEntry(prev);
+}
+
+/*
+ * pqCommandQueueClear
+ *		Forget about all commands in the pipeline-mode queue
+ */
+void
+pqCommandQueueClear(PGconn *conn)
+{
+	while (conn->cmd_queue_head != NULL)
+	{
+		PGcmdQueueEntry *entry = conn->cmd_queue_head;
+
+		conn->cmd_queue_head = entry->next;
+		pqFreeCmdQueueEntry(entry);
+	}
+	conn->cmd_queue_tail = NULL;
+}
+
+/*
+ * pqPipelineProcessQueue
+ *		In pipeline mode, start processing the results of the next command
+ *		in the queue, if we're done with the current one
+ */
+static void
+pqPipelineProcessQueue(PGconn *conn)
+{
+	switch (conn->asyncStatus)
+	{
+		case PGASYNC_IDLE:
+		case PGASYNC_PIPELINE_IDLE:
+			/* next command, please */
+			break;
+		default:
+			/* the application still has to collect the current results */
+			return;
+	}
+
+	if (conn->pipelineStatus == PQ_PIPELINE_OFF ||
+		conn->cmd_queue_head == NULL)
+	{
+		/* Nothing more to do until another command is queued */
+		conn->asyncStatus = PGASYNC_IDLE;
+		return;
+	}
+
+	/* Initialize async result-accumulation state */
+	pqClearAsyncResult(conn);
+
+	/* Reset single-row processing mode */
+	conn->singleRowMode = false;
+
+	if (conn->pipelineStatus == PQ_PIPELINE_ABORTED &&
+		conn->cmd_queue_head->queryclass != PGQUERY_SYNC)
+	{
+		/*
+		 * After an error, the server skips everything up to the next Sync
+		 * without sending any response, so there's nothing to wait for.
+		 * Just report that the command was not executed.
+		 */
+		conn->result = PQmakeEmptyPGresult(conn, PGRES_PIPELINE_ABORTED);
+		if (!conn->result)
+		{
+			printfPQExpBuffer(&conn->errorMessage,
+							  libpq_gettext("out of memory\n"));
+			pqSaveErrorResult(conn);
+		}
+		conn->asyncStatus = PGASYNC_READY;
+		return;
+	}
+
+	/* allow parsing to continue */
+	conn->asyncStatus = PGASYNC_BUSY;
+}
+
 /*
  * pqHandleSendFailure: try to clean up after failure to send command.
  *
@@ -1668,6 +1948,220 @@ PQisBusy(PGconn *conn)
 	return conn->asyncStatus == PGASYNC_BUSY;
 }
 
+/*
+ * PQpipelineStatus
+ *	 Return the current pipeline mode status of the connection.
+ */
+PGpipelineStatus
+PQpipelineStatus(const PGconn *conn)
+{
+	if (!conn)
+		return PQ_PIPELINE_OFF;
+
+	return conn->pipelineStatus;
+}
+
+/*
+ * PQenterPipelineMode
+ *	 Put the connection in pipeline mode.
+ *
+ * In pipeline mode, commands can be sent without waiting for the results of
+ * the previous ones.  The server processes them in order, and a Sync is
+ * only sent when the application calls PQpipelineSync.  If a command fails,
+ * the server skips the remaining commands up to the next Sync; we report
+ * PGRES_PIPELINE_ABORTED for those.
+ *
+ * Returns 1 on success, 0 on failure (conn->errorMessage is set).
+ */
+int
+PQenterPipelineMode(PGconn *conn)
+{
+	if (!conn)
+		return 0;
+
+	/* succeed with no action if already in pipeline mode */
+	if (conn->pipelineStatus != PQ_PIPELINE_OFF)
+		return 1;
+
+	if (conn->asyncStatus != PGASYNC_IDLE)
+	{
+		printfPQExpBuffer(&conn->errorMessage,
+						  libpq_gettext("cannot enter pipeline mode, connection not idle\n"));
+		return 0;
+	}
+
+	if (PG_PROTOCOL_MAJOR(conn->pversion) < 3)
+	{
+		printfPQExpBuffer(&conn->errorMessage,
+		 libpq_gettext("function requires at least protocol version 3.0\n"));
+		return 0;
+	}
+
+	conn->pipelineStatus = PQ_PIPELINE_ON;
+
+	return 1;
+}
+
+/*
+ * PQexitPipelineMode
+ *	 End pipeline mode and return to normal command mode.
+ *
+ * This is only possible once all results of the commands sent in pipeline
+ * mode, up to and including the last sync, have been collected.
+ *
+ * Returns 1 on success, 0 on failure (conn->errorMessage is set).
+ */
+int
+PQexitPipelineMode(PGconn *conn)
+{
+	if (!conn)
+		return 0;
+
+	/* succeed with no action if not in pipeline mode */
+	if (conn->pipelineStatus == PQ_PIPELINE_OFF)
+		return 1;
+
+	switch (conn->asyncStatus)
+	{
+		case PGASYNC_IDLE:
+		case PGASYNC_PIPELINE_IDLE:
+			break;
+		case PGASYNC_READY:
+			printfPQExpBuffer(&conn->errorMessage,
+							  libpq_gettext("cannot exit pipeline mode with uncollected results\n"));
+			return 0;
+		case PGASYNC_BUSY:
+			printfPQExpBuffer(&conn->errorMessage,
+							  libpq_gettext("cannot exit pipeline mode while busy\n"));
+			return 0;
+		default:
+			printfPQExpBuffer(&conn->errorMessage,
+							  libpq_gettext("cannot exit pipeline mode while in COPY\n"));
+			return 0;
+	}
+
+	/* still commands whose results we haven't collected? */
+	if (conn->cmd_queue_head != NULL)
+	{
+		printfPQExpBuffer(&conn->errorMessage,
+						  libpq_gettext("cannot exit pipeline mode with uncollected results\n"));
+		return 0;
+	}
+
+	conn->pipelineStatus = PQ_PIPELINE_OFF;
+	conn->asyncStatus = PGASYNC_IDLE;
+
+	/* Flush any data left in the output buffer */
+	if (pqFlush(conn) < 0)
+		return 0;
+
+	return 1;
+}
+
+/*
+ * PQpipelineSync
+ *	 Send a Sync message, marking the end of a pipeline segment.
+ *
+ * The server commits an implicit transaction, if any, at a Sync, and it
+ * resumes processing commands there after an error.  We return a result
+ * with status PGRES_PIPELINE_SYNC once we get the server's response.  The
+ * output buffer is flushed, so that the server gets to see the commands.
+ *
+ * Returns 1 on success, 0 on failure (conn->errorMessage is set).
+ */
+int
+PQpipelineSync(PGconn *conn)
+{
+	PGcmdQueueEntry *entry;
+
+	if (!conn)
+		return 0;
+
+	if (conn->pipelineStatus == PQ_PIPELINE_OFF)
+	{
+		printfPQExpBuffer(&conn->errorMessage,
+						  libpq_gettext("cannot send pipeline sync when not in pipeline mode\n"));
+		return 0;
+	}
+
+	if (conn->asyncStatus == PGASYNC_COPY_IN ||
+		conn->asyncStatus == PGASYNC_COPY_OUT ||
+		conn->asyncStatus == PGASYNC_COPY_BOTH)
+	{
+		printfPQExpBuffer(&conn->errorMessage,
+						  libpq_gettext("cannot send pipeline sync while in COPY\n"));
+		return 0;
+	}
+
+	entry = pqAllocCmdQueueEntry(conn);
+	if (entry == NULL)
+		return 0;
+	entry->queryclass = PGQUERY_SYNC;
+
+	/* construct the Sync message */
+	if (pqPutMsgStart('S', false, conn) < 0 ||
+		pqPutMsgEnd(conn) < 0)
+		goto sendFailed;
+
+	/*
+	 * Give the data a push.  In nonblock mode, don't complain if we're unable
+	 * to send it all; PQgetResult() will do any additional flushing needed.
+	 */
+	if (pqFlush(conn) < 0)
+		goto sendFailed;
+
+	pqAppendCmdQueueEntry(conn, entry);
+
+	return 1;
+
+sendFailed:
+	pqFreeCmdQueueEntry(entry);
+	pqHandleSendFailure(conn);
+	return 0;
+}
+
+/*
+ * PQsendFlushRequest
+ *	 Ask the server to send the results it has produced so far.
+ *
+ * Without a sync, the server may otherwise hold on to the results of
+ * pipelined commands until its output buffer fills up.  This also flushes
+ * our own output buffer.
+ *
+ * Returns 1 on success, 0 on failure (conn->errorMessage is set).
+ */
+int
+PQsendFlushRequest(PGconn *conn)
+{
+	if (!conn)
+		return 0;
+
+	/* Don't try to send if we know there's no live connection. */
+	if (conn->status != CONNECTION_OK)
+	{
+		printfPQExpBuffer(&conn->errorMessage,
+						  libpq_gettext("no connection to the server\n"));
+		return 0;
+	}
+
+	/* This isn't gonna work on a 2.0 server */
+	if (PG_PROTOCOL_MAJOR(conn->pversion) < 3)
+	{
+		printfPQExpBuffer(&conn->errorMessage,
+		 libpq_gettext("function requires at least protocol version 3.0\n"));
+		return 0;
+	}
+
+	if (pqPutMsgStart('H', false, conn) < 0 ||
+		pqPutMsgEnd(conn) < 0)
+		return 0;
+
+	if (pqFlush(conn) < 0)
+		return 0;
+
+	return 1;
+}
+
 
 /*
  * PQgetResult
@@ -1729,10 +2223,45 @@ PQgetResult(PGconn *conn)
 		case PGASYNC_IDLE:
 			res = NULL;			/* query is complete */
 			break;
+		case PGASYNC_PIPELINE_IDLE:
+
+			/*
+			 * We've returned all results of the current command, so return
+			 * the NULL that ends them, and get ready to return the results
+			 * of the next command in the queue, if any.
+			 */
+			res = NULL;
+			pqPipelineProcessQueue(conn);
+			break;
 		case PGASYNC_READY:
 			res = pqPrepareAsyncResult(conn);
-			/* Set the state back to BUSY, allowing parsing to proceed. */
-			conn->asyncStatus = PGASYNC_BUSY;
+			if (conn->pipelineStatus != PQ_PIPELINE_OFF &&
+				(res == NULL || res->resultStatus != PGRES_SINGLE_TUPLE))
+			{
+				/*
+				 * In pipeline mode, each command yields one result (apart
+				 * from single-row mode), so this is the current command's
+				 * last one.  Move on to the next command, but don't let
+				 * parsing proceed until we've returned a NULL.  The one
+				 * exception is a sync result, which isn't followed by a
+				 * NULL.  (A failure while we're waiting for the sync isn't
+				 * the sync's result, so don't advance past it then.)
+				 */
+				bool		gotSync = (res != NULL &&
+							   res->resultStatus == PGRES_PIPELINE_SYNC);
+
+				if (gotSync || conn->cmd_queue_head == NULL ||
+					conn->cmd_queue_head->queryclass != PGQUERY_SYNC)
+					pqCommandQueueAdvance(conn);
+				conn->asyncStatus = PGASYNC_PIPELINE_IDLE;
+				if (gotSync)
+					pqPipelineProcessQueue(conn);
+			}
+			else
+			{
+				/* Set the state back to BUSY, allowing parsing to proceed. */
+				conn->asyncStatus = PGASYNC_BUSY;
+			}
 			break;
 		case PGASYNC_COPY_IN:
 			res = getCopyResult(conn, PGRES_COPY_IN);
@@ -1910,6 +2439,13 @@ PQexecStart(PGconn *conn)
 	if (!conn)
 		return false;
 
+	if (conn->pipelineStatus != PQ_PIPELINE_OFF)
+	{
+		printfPQExpBuffer(&conn->errorMessage,
+						  libpq_gettext("synchronous command execution functions are not allowed in pipeline mode\n"));
+		return false;
+	}
+
 	/*
 	 * Silently discard any prior query result that application didn't eat.
 	 * This is probably poor design, but it's here for backward compatibility.
@@ -2104,6 +2640,8 @@ PQsendDescribePortal(PGconn *conn, const char *portal)
 static int
 PQsendDescribe(PGconn *conn, char desc_type, const char *desc_target)
 {
+	PGcmdQueueEntry *entry = NULL;
+
 	/* Treat null desc_target as empty string */
 	if (!desc_target)
 		desc_target = "";
@@ -2119,6 +2657,14 @@ PQsendDescribe(PGconn *conn, char desc_type, const char *desc_target)
 		return 0;
 	}
 
+	/* In pipeline mode, allocate the queue entry before sending anything */
+	if (conn->pipelineStatus != PQ_PIPELINE_OFF)
+	{
+		entry = pqAllocCmdQueueEntry(conn);
+		if (entry == NULL)
+			return 0;
+	}
+
 	/* construct the Describe message */
 	if (pqPutMsgStart('D', false, conn) < 0 ||
 		pqPutc(desc_type, conn) < 0 ||
@@ -2126,33 +2672,21 @@ PQsendDescribe(PGconn *conn, char desc_type, const char *desc_target)
 		pqPutMsgEnd(conn) < 0)
 		goto sendFailed;
 
-	/* construct the Sync message */
-	if (pqPutMsgStart('S', false, conn) < 0 ||
-		pqPutMsgEnd(conn) < 0)
-		goto sendFailed;
-
-	/* remember we are doing a Describe */
-	conn->queryclass = PGQUERY_DESCRIBE;
-
-	/* reset last-query string (not relevant now) */
-	if (conn->last_query)
+	/* construct the Sync message, unless the application will do that */
+	if (conn->pipelineStatus == PQ_PIPELINE_OFF)
 	{
-		free(conn->last_query);
-		conn->last_query = NULL;
+		if (pqPutMsgStart('S', false, conn) < 0 ||
+			pqPutMsgEnd(conn) < 0)
+			goto sendFailed;
 	}
 
-	/*
-	 * Give the data a push.  In nonblock mode, don't complain if we're unable
-	 * to send it all; PQgetResult() will do any additional flushing needed.
-	 */
-	if (pqFlush(conn) < 0)
+	/* remember we are doing a Describe (last-query string not relevant) */
+	if (!pqFinishSend(conn, entry, PGQUERY_DESCRIBE, NULL))
 		goto sendFailed;
-
-	/* OK, it's launched! */
-	conn->asyncStatus = PGASYNC_BUSY;
 	return 1;
 
 sendFailed:
+	pqFreeCmdQueueEntry(entry);
 	pqHandleSendFailure(conn);
 	return 0;
 }
@@ -2549,6 +3083,13 @@ PQfn(PGconn *conn,
 	/* clear the error string */
 	resetPQExpBuffer(&conn->errorMessage);
 
+	if (conn->pipelineStatus != PQ_PIPELINE_OFF)
+	{
+		printfPQExpBuffer(&conn->errorMessage,
+						  libpq_gettext("PQfn not allowed in pipeline mode\n"));
+		return NULL;
+	}
+
 	if (conn->sock < 0 || conn->asyncStatus != PGASYNC_IDLE ||
 		conn->result != NULL)
 	{
@@ -213,12 +213,29 @@ pqParseInput3(PGconn *conn)
 				case 'E':		/* error return */
 					if (pqGetErrorNotice3(conn, true))
 						return;
+					/* the server now skips everything up to the next Sync */
+					if (conn->pipelineStatus != PQ_PIPELINE_OFF)
+						conn->pipelineStatus = PQ_PIPELINE_ABORTED;
 					conn->asyncStatus = PGASYNC_READY;
 					break;
 				case 'Z':		/* backend is ready for new query */
 					if (getReadyForQuery(conn))
 						return;
-					conn->asyncStatus = PGASYNC_IDLE;
+					if (conn->pipelineStatus != PQ_PIPELINE_OFF)
+					{
+						/*
+						 * In pipeline mode, this is the response to a Sync;
+						 * report it to the application, and end any abort.
+						 */
+						conn->result = PQmakeEmptyPGresult(conn,
+													   PGRES_PIPELINE_SYNC);
+						if (!conn->result)
+							return;
+						conn->pipelineStatus = PQ_PIPELINE_ON;
+						conn->asyncStatus = PGASYNC_READY;
+					}
+					else
+						conn->asyncStatus = PGASYNC_IDLE;
 					break;
 				case 'I':		/* empty query */
 					if (conn->result == NULL)
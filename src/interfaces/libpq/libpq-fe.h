@@ -91,7 +91,10 @@ typedef enum
 	PGRES_NONFATAL_ERROR,		/* notice or warning message */
 	PGRES_FATAL_ERROR,			/* query failed */
 	PGRES_COPY_BOTH,			/* Copy In/Out data transfer in progress */
-	PGRES_SINGLE_TUPLE			/* single tuple from larger resultset */
+	PGRES_SINGLE_TUPLE,			/* single tuple from larger resultset */
+	PGRES_PIPELINE_SYNC,		/* pipeline synchronization point */
+	PGRES_PIPELINE_ABORTED		/* command didn't run because of an abort
+								 * earlier in a pipeline */
 } ExecStatusType;
 
 typedef enum
@@ -103,6 +106,15 @@ typedef enum
 	PQTRANS_UNKNOWN				/* cannot determine status */
 } PGTransactionStatusType;
 
+/* PGpipelineStatus - current status of pipeline mode */
+typedef enum
+{
+	PQ_PIPELINE_OFF,			/* not in pipeline mode */
+	PQ_PIPELINE_ON,				/* in pipeline mode */
+	PQ_PIPELINE_ABORTED			/* in pipeline mode, but an error occurred
+								 * since the last sync point */
+} PGpipelineStatus;
+
 typedef enum
 {
 	PQERRORS_TERSE,				/* single-line error messages */
@@ -403,6 +415,13 @@ extern PGresult *PQgetResult(PGconn *conn);
 
 /* Routines for managing an asynchronous query */
 extern int	PQisBusy(PGconn *conn);
+
+/* Routines for pipeline mode management */
+extern PGpipelineStatus PQpipelineStatus(const PGconn *conn);
+extern int	PQenterPipelineMode(PGconn *conn);
+extern int	PQexitPipelineMode(PGconn *conn);
+extern int	PQpipelineSync(PGconn *conn);
+extern int	PQsendFlushRequest(PGconn *conn);
 extern int	PQconsumeInput(PGconn *conn);
 
 /* LISTEN/NOTIFY support */
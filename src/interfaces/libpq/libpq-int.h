@@ -219,7 +219,10 @@ typedef enum
 	PGASYNC_READY,				/* result ready for PQgetResult */
 	PGASYNC_COPY_IN,			/* Copy In data transfer in progress */
 	PGASYNC_COPY_OUT,			/* Copy Out data transfer in progress */
-	PGASYNC_COPY_BOTH			/* Copy In/Out data transfer in progress */
+	PGASYNC_COPY_BOTH,			/* Copy In/Out data transfer in progress */
+	PGASYNC_PIPELINE_IDLE		/* pipeline mode: the current command's
+								 * results are all returned, but the NULL
+								 * that ends them hasn't been */
 } PGAsyncStatusType;
 
 /* PGQueryClass tracks which query protocol we are now executing */
@@ -228,9 +231,23 @@ typedef enum
 	PGQUERY_SIMPLE,				/* simple Query protocol (PQexec) */
 	PGQUERY_EXTENDED,			/* full Extended protocol (PQexecParams) */
 	PGQUERY_PREPARE,			/* Parse only (PQprepare) */
-	PGQUERY_DESCRIBE			/* Describe Statement or Portal */
+	PGQUERY_DESCRIBE,			/* Describe Statement or Portal */
+	PGQUERY_SYNC				/* Sync (at end of a pipeline segment) */
 } PGQueryClass;
 
+/*
+ * An entry in the queue of commands sent in pipeline mode whose results
+ * haven't been completely consumed yet.  The head of the queue is the
+ * command whose results are being processed; its queryclass and query are
+ * mirrored in the PGconn's queryclass and last_query fields.
+ */
+typedef struct PGcmdQueueEntry
+{
+	PGQueryClass queryclass;	/* query type */
+	char	   *query;			/* SQL command, or NULL if none or unknown */
+	struct PGcmdQueueEntry *next;	/* list link */
+} PGcmdQueueEntry;
+
 /* PGSetenvStatusType defines the state of the PQSetenv state machine */
 /* (this is used only for 2.0-protocol connections) */
 typedef enum
@@ -357,6 +374,9 @@ struct pg_conn
 	bool		nonblocking;	/* whether this connection is using nonblock
 								 * sending semantics */
 	bool		singleRowMode;	/* return current query result row-by-row? */
+	PGpipelineStatus pipelineStatus;	/* status of pipeline mode */
+	PGcmdQueueEntry *cmd_queue_head;	/* commands awaiting results, in */
+	PGcmdQueueEntry *cmd_queue_tail;	/* pipeline mode only */
 	char		copy_is_binary; /* 1 = copy binary, 0 = copy text */
 	int			copy_already_done;		/* # bytes already returned in COPY
 										 * OUT */
@@ -532,6 +552,7 @@ extern void pqSaveParameterStatus(PGconn *conn, const char *name,
 					  const char *value);
 extern int	pqRowProcessor(PGconn *conn, const char **errmsgp);
 extern void pqHandleSendFailure(PGconn *conn);
+extern void pqCommandQueueClear(PGconn *conn);
 
 /* === in fe-protocol2.c === */
 
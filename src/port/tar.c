@@ -21,6 +21,22 @@ print_val(char *s, uint64 val, unsigned int base, size_t len)
 }
 
 
+/*
+ * Read a number written by print_val in base 8, such as a file size, which
+ * may be wider than 32 bits.  Reading stops at the first non-digit.
+ */
+uint64
+read_tar_number(const char *s, int len)
+{
+	uint64		result = 0;
+
+	while (len-- > 0 && *s >= '0' && *s <= '7')
+		result = (result << 3) + (*s++ - '0');
+
+	return result;
+}
+
+
 /*
  * Calculate the tar checksum for a header. The header is assumed to always
  * be 512 bytes, per the tar standard.
@@ -0,0 +1,267 @@
+/*
+ * src/test/examples/testlibpq5.c
+ *
+ *
+ * testlibpq5.c
+ *		Test pipeline mode.
+ *
+ * Sends two pipeline segments without waiting for any results.  In the
+ * first, all commands succeed; in the second, the middle command fails, so
+ * the server skips the rest of the segment.  A third segment checks that
+ * the connection works normally again after the failed one was synced.
+ * Results are checked to arrive in order, each command's followed by a
+ * NULL, and each segment's ended by a PGRES_PIPELINE_SYNC result.
+ *
+ * The expected output is:
+ *
+ * segment 1: result 1
+ * segment 1: result 2
+ * segment 1: result 3
+ * segment 1: sync
+ * segment 2: result 1
+ * segment 2: error: division by zero
+ * segment 2: aborted
+ * segment 2: aborted
+ * segment 2: sync
+ * segment 3: result 42
+ * segment 3: sync
+ * done
+ */
+
+#ifdef WIN32
+#include <windows.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "libpq-fe.h"
+
+
+static void
+exit_nicely(PGconn *conn)
+{
+	PQfinish(conn);
+	exit(1);
+}
+
+/*
+ * Queue "SELECT $1::int4" with the given value, or, if fail is true,
+ * "SELECT 1 / $1::int4" with a zero, which fails at execution.
+ */
+static void
+send_query(PGconn *conn, int value, int fail)
+{
+	char		buf[16];
+	const char *paramValues[1];
+
+	snprintf(buf, sizeof(buf), "%d", fail ? 0 : value);
+	paramValues[0] = buf;
+
+	if (!PQsendQueryParams(conn,
+						   fail ? "SELECT 1 / $1::int4" : "SELECT $1::int4",
+						   1, NULL, paramValues, NULL, NULL, 0))
+	{
+		fprintf(stderr, "PQsendQueryParams failed: %s",
+				PQerrorMessage(conn));
+		exit_nicely(conn);
+	}
+}
+
+static void
+send_sync(PGconn *conn)
+{
+	if (!PQpipelineSync(conn))
+	{
+		fprintf(stderr, "PQpipelineSync failed: %s", PQerrorMessage(conn));
+		exit_nicely(conn);
+	}
+}
+
+/*
+ * Collect the results of one command, which must have the given status,
+ * and the NULL that ends them.
+ */
+static void
+get_command_result(PGconn *conn, int segment, ExecStatusType expected)
+{
+	PGresult   *res;
+
+	res = PQgetResult(conn);
+	if (res == NULL)
+	{
+		fprintf(stderr, "segment %d: unexpected NULL result: %s",
+				segment, PQerrorMessage(conn));
+		exit_nicely(conn);
+	}
+	if (PQresultStatus(res) != expected)
+	{
+		fprintf(stderr, "segment %d: expected %s, got %s: %s",
+				segment, PQresStatus(expected),
+				PQresStatus(PQresultStatus(res)),
+				PQresultErrorMessage(res));
+		PQclear(res);
+		exit_nicely(conn);
+	}
+
+	switch (expected)
+	{
+		case PGRES_TUPLES_OK:
+			printf("segment %d: result %s\n", segment,
+				   PQgetvalue(res, 0, 0));
+			break;
+		case PGRES_FATAL_ERROR:
+			printf("segment %d: error: %s\n", segment,
+				   PQresultErrorField(res, PG_DIAG_MESSAGE_PRIMARY));
+			/* the rest of the segment is now being skipped */
+			if (PQpipelineStatus(conn) != PQ_PIPELINE_ABORTED)
+			{
+				fprintf(stderr, "segment %d: pipeline not aborted\n",
+						segment);
+				exit_nicely(conn);
+			}
+			break;
+		case PGRES_PIPELINE_ABORTED:
+			printf("segment %d: aborted\n", segment);
+			break;
+		default:
+			break;
+	}
+	PQclear(res);
+
+	res = PQgetResult(conn);
+	if (res != NULL)
+	{
+		fprintf(stderr, "segment %d: expected NULL, got %s\n",
+				segment, PQresStatus(PQresultStatus(res)));
+		PQclear(res);
+		exit_nicely(conn);
+	}
+}
+
+/*
+ * Collect the result of a sync, which isn't followed by a NULL, and check
+ * that any abort has ended.
+ */
+static void
+get_sync_result(PGconn *conn, int segment)
+{
+	PGresult   *res;
+
+	res = PQgetResult(conn);
+	if (res == NULL || PQresultStatus(res) != PGRES_PIPELINE_SYNC)
+	{
+		fprintf(stderr, "segment %d: expected PGRES_PIPELINE_SYNC, got %s: %s",
+				segment,
+				res ? PQresStatus(PQresultStatus(res)) : "NULL",
+				PQerrorMessage(conn));
+		PQclear(res);
+		exit_nicely(conn);
+	}
+	PQclear(res);
+
+	if (PQpipelineStatus(conn) != PQ_PIPELINE_ON)
+	{
+		fprintf(stderr, "segment %d: pipeline still aborted after sync\n",
+				segment);
+		exit_nicely(conn);
+	}
+	printf("segment %d: sync\n", segment);
+}
+
+int
+main(int argc, char **argv)
+{
+	const char *conninfo;
+	PGconn	   *conn;
+	PGresult   *res;
+
+	/*
+	 * If the user supplies a parameter on the command line, use it as the
+	 * conninfo string; otherwise default to setting dbname=postgres and using
+	 * environment variables or defaults for all other connection parameters.
+	 */
+	if (argc > 1)
+		conninfo = argv[1];
+	else
+		conninfo = "dbname = postgres";
+
+	/* Make a connection to the database */
+	conn = PQconnectdb(conninfo);
+
+	/* Check to see that the backend connection was successfully made */
+	if (PQstatus(conn) != CONNECTION_OK)
+	{
+		fprintf(stderr, "Connection to database failed: %s",
+				PQerrorMessage(conn));
+		exit_nicely(conn);
+	}
+
+	if (!PQenterPipelineMode(conn))
+	{
+		fprintf(stderr, "PQenterPipelineMode failed: %s",
+				PQerrorMessage(conn));
+		exit_nicely(conn);
+	}
+
+	/* Send both segments before reading anything */
+	send_query(conn, 1, 0);
+	send_query(conn, 2, 0);
+	send_query(conn, 3, 0);
+	send_sync(conn);
+
+	send_query(conn, 1, 0);
+	send_query(conn, 0, 1);
+	send_query(conn, 3, 0);
+	send_query(conn, 4, 0);
+	send_sync(conn);
+
+	/* Pipeline mode can't be left while results are pending */
+	if (PQexitPipelineMode(conn))
+	{
+		fprintf(stderr, "PQexitPipelineMode succeeded with pending results\n");
+		exit_nicely(conn);
+	}
+
+	get_command_result(conn, 1, PGRES_TUPLES_OK);
+	get_command_result(conn, 1, PGRES_TUPLES_OK);
+	get_command_result(conn, 1, PGRES_TUPLES_OK);
+	get_sync_result(conn, 1);
+
+	get_command_result(conn, 2, PGRES_TUPLES_OK);
+	get_command_result(conn, 2, PGRES_FATAL_ERROR);
+	get_command_result(conn, 2, PGRES_PIPELINE_ABORTED);
+	get_command_result(conn, 2, PGRES_PIPELINE_ABORTED);
+	get_sync_result(conn, 2);
+
+	/* Commands sent after the failed segment's sync run normally */
+	send_query(conn, 42, 0);
+	send_sync(conn);
+	get_command_result(conn, 3, PGRES_TUPLES_OK);
+	get_sync_result(conn, 3);
+
+	if (!PQexitPipelineMode(conn))
+	{
+		fprintf(stderr, "PQexitPipelineMode failed: %s",
+				PQerrorMessage(conn));
+		exit_nicely(conn);
+	}
+
+	/* Synchronous commands work again outside pipeline mode */
+	res = PQexec(conn, "SELECT 1");
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+	{
+		fprintf(stderr, "SELECT failed after pipeline mode: %s",
+				PQerrorMessage(conn));
+		PQclear(res);
+		exit_nicely(conn);
+	}
+	PQclear(res);
+
+	printf("done\n");
+
+	/* close the connection to the database and cleanup */
+	PQfinish(conn);
+
+	return 0;
+}
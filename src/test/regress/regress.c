@@ -10,6 +10,7 @@
 #include "access/htup_details.h"
 #include "access/transam.h"
 #include "access/tuptoaster.h"
+#include "access/visibilitymap.h"
 #include "access/xact.h"
 #include "catalog/pg_type.h"
 #include "commands/sequence.h"
@@ -40,6 +41,7 @@ extern int	oldstyle_length(int n, text *t);
 extern Datum int44in(PG_FUNCTION_ARGS);
 extern Datum int44out(PG_FUNCTION_ARGS);
 extern Datum make_tuple_indirect(PG_FUNCTION_ARGS);
+extern Datum vm_page_count(PG_FUNCTION_ARGS);
 
 #ifdef PG_MODULE_MAGIC
 PG_MODULE_MAGIC;
@@ -825,3 +827,24 @@ make_tuple_indirect(PG_FUNCTION_ARGS)
 
 	PG_RETURN_HEAPTUPLEHEADER(newtup->t_data);
 }
+
+/*
+ * Count the pages of a relation that its visibility map marks all-visible,
+ * or all-frozen if the second argument is true.
+ */
+PG_FUNCTION_INFO_V1(vm_page_count);
+Datum
+vm_page_count(PG_FUNCTION_ARGS)
+{
+	Oid			relid = PG_GETARG_OID(0);
+	bool		frozen = PG_GETARG_BOOL(1);
+	Relation	rel;
+	BlockNumber all_visible;
+	BlockNumber all_frozen;
+
+	rel = relation_open(relid, AccessShareLock);
+	visibilitymap_count(rel, &all_visible, &all_frozen);
+	relation_close(rel, AccessShareLock);
+
+	PG_RETURN_INT32(frozen ? all_frozen : all_visible);
+}
@@ -309,6 +309,51 @@ COPY forcetest (d, e) FROM STDIN WITH (FORMAT csv, FORCE_NULL(b));
 ROLLBACK;
 \pset null ''
 DROP TABLE forcetest;
+-- Test PARALLEL option; the results mustn't depend on whether any workers
+-- could be started
+CREATE TEMP TABLE partest (a int, b text, c numeric DEFAULT 0);
+COPY partest (a, b) FROM STDIN WITH (FORMAT csv, PARALLEL 2);
+1,one
+2,"two, quoted"
+3,
+\.
+COPY partest (a, b, c) FROM STDIN WITH (PARALLEL 2);
+4	four	4.5
+\.
+-- errors should be reported just as without workers
+COPY partest (a, b) FROM STDIN WITH (FORMAT csv, PARALLEL 2);
+5,five
+x,bad
+\.
+-- line numbers count the newlines within quoted fields
+COPY partest (a, b) FROM STDIN WITH (FORMAT csv, PARALLEL 2);
+6,"six
+lines"
+y,bad
+\.
+SELECT * FROM partest ORDER BY a;
+-- reg* input must see the leader's catalog state, such as temp tables
+CREATE TEMP TABLE parreg (r regclass, rs regclass[]);
+COPY parreg FROM STDIN WITH (PARALLEL 2);
+partest	{partest,parreg}
+\.
+SELECT * FROM parreg;
+DROP TABLE parreg;
+-- should fail
+COPY partest TO STDOUT WITH (PARALLEL 2);
+COPY partest FROM STDIN WITH (FORMAT binary, PARALLEL 2);
+COPY partest FROM STDIN WITH (PARALLEL -1);
+DROP TABLE partest;
+-- Test COPY TO's output fast paths for integers and text; they mustn't skip
+-- any quoting or escaping the format requires
+CREATE TEMP TABLE outtest (a int2, b int4, c int8, d text, e varchar, f char(3));
+INSERT INTO outtest VALUES (-1, 0, -9223372036854775808, E'a\\b\tc', 'x,"y"', 'xyz');
+COPY outtest TO STDOUT;
+COPY outtest TO STDOUT WITH (DELIMITER '-');
+COPY outtest TO STDOUT WITH (FORMAT csv, NULL '0');
+COPY outtest TO STDOUT WITH (FORMAT csv, QUOTE '1', FORCE_QUOTE (a));
+COPY (SELECT 10::int4 AS x, 'a1'::text AS y) TO STDOUT WITH (FORMAT csv, QUOTE '1');
+DROP TABLE outtest;
 DROP TABLE vistest;
 DROP FUNCTION truncate_in_subxact();
 DROP TABLE x, y;
@@ -917,3 +917,94 @@ ORDER BY thousand;
 SELECT thousand, tenthous FROM tenk1
 WHERE thousand < 2 AND tenthous IN (1001,3000)
 ORDER BY thousand;
+
+--
+-- Check skip scans over a leading column with few distinct values
+--
+
+CREATE TABLE skip_scan_tbl AS
+  SELECT i % 4 AS a, i AS b, i::text AS c FROM generate_series(1, 10000) i;
+INSERT INTO skip_scan_tbl VALUES (NULL, 5, '5'), (NULL, 10001, '10001');
+CREATE INDEX skip_scan_tbl_a_b ON skip_scan_tbl (a, b);
+ANALYZE skip_scan_tbl;
+
+SET enable_bitmapscan = OFF;
+
+explain (costs off)
+SELECT a, b, c FROM skip_scan_tbl WHERE b = 5 ORDER BY a;
+
+SELECT a, b, c FROM skip_scan_tbl WHERE b = 5 ORDER BY a;
+
+explain (costs off)
+SELECT a, b, c FROM skip_scan_tbl WHERE b > 9998 ORDER BY a DESC, b DESC;
+
+SELECT a, b, c FROM skip_scan_tbl WHERE b > 9998 ORDER BY a DESC, b DESC;
+
+-- DISTINCT and GROUP BY on the leading column don't use a skip scan
+explain (costs off)
+SELECT DISTINCT a FROM skip_scan_tbl;
+
+explain (costs off)
+SELECT a FROM skip_scan_tbl GROUP BY a;
+
+RESET enable_bitmapscan;
+
+DROP TABLE skip_scan_tbl;
+
+--
+-- Check that duplicates merged into posting lists are still found
+--
+
+CREATE TABLE dedup_tbl (a int, b int);
+CREATE INDEX dedup_tbl_a ON dedup_tbl (a);
+INSERT INTO dedup_tbl SELECT i % 3, i FROM generate_series(1, 30000) i;
+
+SET enable_seqscan = OFF;
+SET enable_bitmapscan = OFF;
+
+SELECT count(*), min(b), max(b) FROM dedup_tbl WHERE a = 1;
+
+DELETE FROM dedup_tbl WHERE b % 2 = 0;
+VACUUM dedup_tbl;
+
+SELECT a, count(*), min(b), max(b) FROM dedup_tbl WHERE a < 3
+GROUP BY a ORDER BY a;
+
+INSERT INTO dedup_tbl SELECT 1, i FROM generate_series(1, 1000) i;
+
+SELECT count(*) FROM dedup_tbl WHERE a = 1;
+
+RESET enable_seqscan;
+RESET enable_bitmapscan;
+
+DROP TABLE dedup_tbl;
+
+--
+-- Check searches through truncated pivot tuples, both in an index built
+-- by insertions and in one built by CREATE INDEX
+--
+
+CREATE TABLE trunc_tbl (a int, b text, c int);
+CREATE INDEX trunc_tbl_a_b_c ON trunc_tbl (a, b, c);
+INSERT INTO trunc_tbl
+  SELECT i / 100, repeat('x', 200) || (i % 100), i
+  FROM generate_series(1, 10000) i;
+
+SET enable_seqscan = OFF;
+SET enable_bitmapscan = OFF;
+
+SELECT count(*) FROM trunc_tbl WHERE a = 42;
+SELECT c FROM trunc_tbl WHERE a = 42 AND b = repeat('x', 200) || '7';
+SELECT count(*) FROM trunc_tbl WHERE a >= 99;
+
+DROP INDEX trunc_tbl_a_b_c;
+CREATE INDEX trunc_tbl_a_b_c ON trunc_tbl (a, b, c);
+
+SELECT count(*) FROM trunc_tbl WHERE a = 42;
+SELECT c FROM trunc_tbl WHERE a = 42 AND b = repeat('x', 200) || '7';
+SELECT count(*) FROM trunc_tbl WHERE a >= 99;
+
+RESET enable_seqscan;
+RESET enable_bitmapscan;
+
+DROP TABLE trunc_tbl;
@@ -55,6 +55,49 @@ LOCK TABLE ONLY lock_tbl1;
 ROLLBACK;
 RESET ROLE;
 
+-- The number of lock manager partitions is set at server start, and must
+-- be a power of 2.
+SHOW lock_manager_partitions;
+SET lock_manager_partitions = 32;
+ALTER SYSTEM SET lock_manager_partitions = 8;
+ALTER SYSTEM SET lock_manager_partitions = 48;
+
+-- Take more fast-path-eligible locks than one fast-path group has slots.
+-- Relations are spread over several groups, and the locks that don't fit
+-- go to the shared lock table.
+DO $$
+BEGIN
+  FOR i IN 1..100 LOOP
+    EXECUTE format('CREATE TABLE lock_fp_tbl%s (a int)', i);
+  END LOOP;
+END
+$$;
+BEGIN;
+DO $$
+BEGIN
+  FOR i IN 1..100 LOOP
+    EXECUTE format('LOCK TABLE lock_fp_tbl%s IN ACCESS SHARE MODE', i);
+  END LOOP;
+END
+$$;
+SELECT count(*) AS locks,
+       count(*) FILTER (WHERE fastpath) > 16 AS several_groups,
+       count(*) FILTER (WHERE NOT fastpath) > 0 AS overflowed
+  FROM pg_locks
+  WHERE pid = pg_backend_pid() AND locktype = 'relation' AND
+    mode = 'AccessShareLock' AND relation::regclass::text LIKE 'lock_fp_tbl%';
+COMMIT;
+SELECT count(*) FROM pg_locks
+  WHERE pid = pg_backend_pid() AND locktype = 'relation' AND
+    relation::regclass::text LIKE 'lock_fp_tbl%';
+DO $$
+BEGIN
+  FOR i IN 1..100 LOOP
+    EXECUTE format('DROP TABLE lock_fp_tbl%s', i);
+  END LOOP;
+END
+$$;
+
 --
 -- Clean up
 --
@@ -0,0 +1,111 @@
+--
+-- Declarative partitioning
+--
+
+CREATE TABLE parted (a int, b text) PARTITION BY range (a);
+CREATE TABLE parted_1 PARTITION OF parted FOR VALUES FROM (UNBOUNDED) TO (10);
+CREATE TABLE parted_2 PARTITION OF parted FOR VALUES FROM (10) TO (20);
+CREATE TABLE parted_3 PARTITION OF parted FOR VALUES FROM (20) TO (30);
+
+\d parted
+\d parted_2
+
+-- bad partition bounds
+CREATE TABLE parted_bad PARTITION OF parted FOR VALUES FROM (25) TO (35);
+CREATE TABLE parted_bad PARTITION OF parted FOR VALUES FROM (40) TO (40);
+CREATE TABLE parted_bad PARTITION OF parted FOR VALUES IN (40);
+
+-- partitioned tables and partitions don't mix with plain inheritance
+CREATE TABLE not_parted (a int);
+CREATE TABLE fail PARTITION OF not_parted FOR VALUES IN (1);
+CREATE TABLE fail () INHERITS (parted);
+CREATE TABLE fail () INHERITS (parted_1);
+DROP TABLE not_parted;
+
+CREATE TABLE fail (a int) PARTITION BY hash (a);
+CREATE TABLE fail (a int) PARTITION BY list (z);
+ALTER TABLE parted DROP COLUMN a;
+ALTER TABLE parted_1 ADD COLUMN c int;
+
+-- rows are routed to the partition accepting them
+INSERT INTO parted VALUES (1, 'one'), (15, 'fifteen'), (25, 'twenty-five'), (-5, 'neg');
+INSERT INTO parted VALUES (30, 'thirty');
+INSERT INTO parted VALUES (NULL, 'null');
+INSERT INTO parted VALUES (7, 'seven') RETURNING tableoid::regclass, *;
+COPY parted FROM stdin;
+3	three
+22	twenty-two
+\.
+SELECT tableoid::regclass, * FROM parted ORDER BY a;
+
+-- but rows put into a partition directly are checked against its bound
+INSERT INTO parted_1 VALUES (15, 'wrong');
+UPDATE parted SET a = 12 WHERE a = 15;
+UPDATE parted SET a = 5 WHERE a = 12;
+
+-- only the partitions that can hold matching rows are scanned
+EXPLAIN (COSTS OFF) SELECT * FROM parted WHERE a = 15;
+EXPLAIN (COSTS OFF) SELECT * FROM parted WHERE a >= 5 AND a < 12;
+EXPLAIN (COSTS OFF) SELECT * FROM parted WHERE a < 0;
+EXPLAIN (COSTS OFF) SELECT * FROM parted WHERE a IN (1, 25);
+EXPLAIN (COSTS OFF) SELECT * FROM parted WHERE a = 1 OR a = 25;
+EXPLAIN (COSTS OFF) SELECT * FROM parted WHERE a = 100;
+
+-- with a parameter, partitions are pruned at executor startup
+CREATE FUNCTION parted_count(int) RETURNS bigint AS
+  'SELECT count(*) FROM parted WHERE a = $1' LANGUAGE sql;
+SELECT parted_count(1), parted_count(12), parted_count(100);
+DROP FUNCTION parted_count(int);
+
+-- list partitioning, with partitions whose rowtype differs from the parent's
+CREATE TABLE lparted (x int, a text, b int) PARTITION BY list (a);
+ALTER TABLE lparted DROP COLUMN x;
+CREATE TABLE lparted_ab PARTITION OF lparted FOR VALUES IN ('a', 'b');
+CREATE TABLE lparted_c PARTITION OF lparted FOR VALUES IN ('c');
+CREATE TABLE lparted_bad PARTITION OF lparted FOR VALUES IN ('d', 'c');
+CREATE TABLE lparted_bad PARTITION OF lparted FOR VALUES FROM ('d') TO ('e');
+\d lparted_ab
+
+INSERT INTO lparted VALUES ('a', 1), ('c', 2), ('b', 3) RETURNING *;
+INSERT INTO lparted_c VALUES ('a', 5);
+SELECT tableoid::regclass, * FROM lparted ORDER BY b;
+EXPLAIN (COSTS OFF) SELECT * FROM lparted WHERE a = 'c';
+
+-- dropping a partition removes its rows and bound
+DROP TABLE parted_3;
+INSERT INTO parted VALUES (25, 'twenty-five');
+SELECT count(*) FROM parted;
+
+DROP TABLE parted;
+DROP TABLE lparted;
+
+-- partition-wise join and aggregation
+CREATE TABLE pwj1 (a int, b text) PARTITION BY RANGE (a);
+CREATE TABLE pwj1_1 PARTITION OF pwj1 FOR VALUES FROM (0) TO (100);
+CREATE TABLE pwj1_2 PARTITION OF pwj1 FOR VALUES FROM (100) TO (200);
+CREATE TABLE pwj2 (a int, c text) PARTITION BY RANGE (a);
+CREATE TABLE pwj2_1 PARTITION OF pwj2 FOR VALUES FROM (0) TO (100);
+CREATE TABLE pwj2_2 PARTITION OF pwj2 FOR VALUES FROM (100) TO (200);
+INSERT INTO pwj1 SELECT i, 'b' || i FROM generate_series(0, 199) i;
+INSERT INTO pwj2 SELECT i, 'c' || i FROM generate_series(0, 199, 20) i;
+ANALYZE pwj1_1;
+ANALYZE pwj1_2;
+ANALYZE pwj2_1;
+ANALYZE pwj2_2;
+SET enable_partitionwise_join = on;
+SET enable_hashjoin = off;
+SET enable_mergejoin = off;
+EXPLAIN (COSTS OFF)
+SELECT pwj1.a, b, c FROM pwj1 JOIN pwj2 ON pwj1.a = pwj2.a;
+SELECT pwj1.a, b, c FROM pwj1 JOIN pwj2 ON pwj1.a = pwj2.a ORDER BY pwj1.a;
+RESET enable_partitionwise_join;
+RESET enable_hashjoin;
+RESET enable_mergejoin;
+SET enable_partitionwise_aggregate = on;
+SET enable_sort = off;
+EXPLAIN (COSTS OFF) SELECT a, count(*) FROM pwj2 GROUP BY a;
+SELECT a, count(*), max(c) FROM pwj2 GROUP BY a HAVING count(*) > 0 ORDER BY a;
+RESET enable_partitionwise_aggregate;
+RESET enable_sort;
+DROP TABLE pwj1;
+DROP TABLE pwj2;
@@ -207,3 +207,12 @@ drop function sillysrf(int);
 -- (see bug #5084)
 select * from (values (2),(null),(1)) v(k) where k = k order by k;
 select * from (values (2),(null),(1)) v(k) where k = k;
+
+--
+-- Incremental sort of input already sorted by a prefix of the ORDER BY keys
+--
+explain (costs off)
+select hundred, unique1 from tenk1 order by hundred, unique1 limit 5;
+select hundred, unique1 from tenk1 order by hundred, unique1 limit 5;
+select hundred, unique1 from tenk1 where hundred < 2
+  order by hundred, unique1 desc limit 3 offset 98;
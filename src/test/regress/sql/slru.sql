@@ -0,0 +1,38 @@
+--
+-- SLRU buffer pools
+--
+
+-- the number of buffers of each pool is set at server start
+SELECT name, setting FROM pg_settings
+  WHERE name IN ('transaction_buffers', 'subtransaction_buffers',
+                 'multixact_offset_buffers', 'multixact_member_buffers')
+  ORDER BY name;
+
+-- must be a multiple of the bank size
+ALTER SYSTEM SET multixact_offset_buffers = 20;
+ALTER SYSTEM SET transaction_buffers = 8;
+
+-- give each row its own subtransaction, enough to span several pages
+CREATE TABLE slru_tab (id int PRIMARY KEY, val int);
+DO $$
+BEGIN
+  FOR i IN 1..5000 LOOP
+    BEGIN
+      INSERT INTO slru_tab VALUES (i, 0);
+    EXCEPTION WHEN unique_violation THEN
+      NULL;
+    END;
+  END LOOP;
+END
+$$;
+SELECT count(*), count(DISTINCT xmin::text) FROM slru_tab;
+
+-- updating a row locked by the parent transaction creates a multixact
+BEGIN;
+SELECT id FROM slru_tab WHERE id = 1 FOR SHARE;
+SAVEPOINT s1;
+UPDATE slru_tab SET val = 1 WHERE id = 1;
+COMMIT;
+SELECT id, val FROM slru_tab WHERE id <= 2 ORDER BY id;
+
+DROP TABLE slru_tab;
@@ -231,6 +231,19 @@ reset enable_indexscan;
 reset enable_bitmapscan;
 reset enable_indexonlyscan;
 
+--
+-- Test that ORDER BY and LIMIT are applied to each branch of a UNION ALL
+-- that can't be flattened into an appendrel
+--
+
+CREATE TEMP TABLE ulim AS SELECT g::int8 AS x FROM generate_series(1,1000) g;
+ANALYZE ulim;
+
+explain (costs off)
+  SELECT x FROM ulim UNION ALL SELECT 0 ORDER BY 1 LIMIT 3;
+
+  SELECT x FROM ulim UNION ALL SELECT 0 ORDER BY 1 LIMIT 3;
+
 -- Test constraint exclusion of UNION ALL subqueries
 explain (costs off)
  SELECT * FROM
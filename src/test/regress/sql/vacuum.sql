@@ -55,3 +55,50 @@ VACUUM FULL vactst;
 
 DROP TABLE vaccluster;
 DROP TABLE vactst;
+
+-- parallel index vacuuming
+CREATE TABLE vacparallel (a int, b int, c text);
+CREATE INDEX vacparallel_a ON vacparallel (a);
+CREATE INDEX vacparallel_b ON vacparallel (b);
+CREATE INDEX vacparallel_c ON vacparallel (c);
+INSERT INTO vacparallel SELECT i, i % 10, i::text FROM generate_series(1, 1000) i;
+DELETE FROM vacparallel WHERE a % 3 = 0;
+VACUUM (PARALLEL 2) vacparallel;
+VACUUM (PARALLEL 2, ANALYZE) vacparallel;
+SELECT count(*) FROM vacparallel WHERE b = 1;
+VACUUM (PARALLEL 2, FULL) vacparallel;
+DROP TABLE vacparallel;
+
+-- an update that has to toast the new tuple, or move it to another page,
+-- marks the old tuple and unlocks its page first, which clears the
+-- all-frozen bit of a frozen page
+CREATE TABLE vacfrozen (id int, data text);
+ALTER TABLE vacfrozen ALTER data SET STORAGE EXTERNAL;
+INSERT INTO vacfrozen SELECT i, 'short' FROM generate_series(1, 100) i;
+VACUUM FREEZE vacfrozen;
+UPDATE vacfrozen SET data = repeat('x', 10000) WHERE id = 1;
+BEGIN;
+UPDATE vacfrozen SET data = repeat('y', 10000) WHERE id = 2;
+ROLLBACK;
+VACUUM FREEZE vacfrozen;
+SELECT id, length(data) FROM vacfrozen WHERE id <= 3 ORDER BY id;
+DROP TABLE vacfrozen;
+
+-- dead tuple lookups during index vacuuming, and the heap pass over them;
+-- line pointers are reused afterwards, so any index entry VACUUM missed
+-- would show up as a wrong count or sum below
+CREATE TABLE vactid (id int, pad text) WITH (autovacuum_enabled = off);
+INSERT INTO vactid SELECT i, repeat('x', 20) FROM generate_series(1, 20000) i;
+CREATE INDEX vactid_id ON vactid (id);
+-- many dead tuples on some pages, only a few on others
+DELETE FROM vactid WHERE id <= 10000 AND id % 3 <> 0;
+DELETE FROM vactid WHERE id > 10000 AND id % 97 = 0;
+VACUUM vactid;
+INSERT INTO vactid SELECT -i, 'y' FROM generate_series(1, 7000) i;
+SET enable_seqscan = off;
+SET enable_bitmapscan = off;
+SELECT count(*), sum(id) FROM vactid WHERE id BETWEEN 1 AND 20000;
+RESET enable_seqscan;
+RESET enable_bitmapscan;
+SELECT count(*), sum(id) FROM vactid WHERE id > 0;
+DROP TABLE vactid;
@@ -0,0 +1,41 @@
+--
+-- Visibility map bits set by VACUUM, and cleared by changes to the table
+--
+-- VACUUM can only mark a page all-visible once no other session could see
+-- its tuples differently, so this test must not run in parallel with others.
+--
+
+-- 88 rows of a single name column fit on a page, so this fills 40 pages
+CREATE TABLE vacvm (n name) WITH (autovacuum_enabled = off);
+INSERT INTO vacvm SELECT 'row ' || i FROM generate_series(1, 3520) i;
+
+CREATE VIEW vacvm_status AS
+  SELECT (pg_relation_size('vacvm') / current_setting('block_size')::int)::int AS pages,
+         vm_page_count('vacvm', false) AS all_visible,
+         vm_page_count('vacvm', true) AS all_frozen;
+
+-- VACUUM FREEZE marks every page all-visible and all-frozen
+VACUUM FREEZE vacvm;
+SELECT * FROM vacvm_status;
+
+-- locking a row leaves its page all-visible, but not all-frozen
+SELECT n FROM vacvm WHERE n = 'row 1' FOR UPDATE;
+SELECT * FROM vacvm_status;
+
+-- an aggressive vacuum reads only the page that isn't all-frozen, and still
+-- advances relfrozenxid
+SELECT relfrozenxid AS frozenxid FROM pg_class WHERE relname = 'vacvm' \gset
+\set VERBOSITY terse
+VACUUM (FREEZE, VERBOSE) vacvm;
+\set VERBOSITY default
+SELECT age(relfrozenxid) < age(:'frozenxid'::xid) AS advanced
+  FROM pg_class WHERE relname = 'vacvm';
+SELECT * FROM vacvm_status;
+
+-- an update clears both bits of the old tuple's page; the new tuple goes on
+-- a new page
+UPDATE vacvm SET n = 'updated' WHERE n = 'row 100';
+SELECT * FROM vacvm_status;
+
+DROP VIEW vacvm_status;
+DROP TABLE vacvm;
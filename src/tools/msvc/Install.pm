@@ -25,7 +25,7 @@ my @client_program_files = (
 	'libecpg',       'libecpg_compat', 'libpgtypes', 'libpq',
 	'pg_basebackup', 'pg_config',      'pg_dump',    'pg_dumpall',
 	'pg_isready',    'pg_receivexlog', 'pg_restore', 'psql',
-	'reindexdb',     'vacuumdb',       @client_contribs);
+	'reindexdb',     'vacuumdb',       'pg_combinebackup', @client_contribs);
 
 sub lcopy
 {
@@ -375,6 +375,11 @@ sub mkvcbuild
 	$pgreceivexlog->AddFile('src\bin\pg_basebackup\pg_receivexlog.c');
 	$pgreceivexlog->AddLibrary('ws2_32.lib');
 
+	my $pgcombinebackup = AddSimpleFrontend('pg_basebackup', 1);
+	$pgcombinebackup->{name} = 'pg_combinebackup';
+	$pgcombinebackup->AddFile('src\bin\pg_basebackup\pg_combinebackup.c');
+	$pgcombinebackup->AddLibrary('ws2_32.lib');
+
 	my $pgconfig = AddSimpleFrontend('pg_config');
 
 	my $pgcontrol = AddSimpleFrontend('pg_controldata');